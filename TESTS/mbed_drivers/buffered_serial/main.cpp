@@ -0,0 +1,188 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "mbed.h"
+#include "greentea-client/test_env.h"
+#include "unity.h"
+#include "utest.h"
+#include "drivers/BufferedSerial.h"
+#include <errno.h>
+
+#if !DEVICE_SERIAL
+  #error [NOT_SUPPORTED] Serial not supported
+#endif
+
+using namespace utest::v1;
+
+// The test shares the greentea UART, so only whole lines that the host
+// ignores are written through the buffered port
+static const char line[] = "buffered serial test line, ignore\r\n";
+
+#define BAUD            MBED_CONF_PLATFORM_STDIO_BAUD_RATE
+#define LINE_TIME_US    ((sizeof(line) - 1) * 10 * 1000000ULL / BAUD)
+
+void test_write_returns_before_transmission() {
+    BufferedSerial serial(USBTX, USBRX, BAUD);
+    Timer timer;
+
+    timer.start();
+    ssize_t written = serial.write(line, sizeof(line) - 1);
+    int write_us = timer.read_us();
+    TEST_ASSERT_EQUAL(sizeof(line) - 1, written);
+
+    serial.fsync();
+    int fsync_us = timer.read_us();
+
+    printf("write %d us, drained after %d us, line time %d us\r\n",
+           write_us, fsync_us, (int)LINE_TIME_US);
+
+    // The caller only pays for the copy, not for the line time
+    TEST_ASSERT(write_us < LINE_TIME_US / 2);
+}
+
+void test_non_blocking_write() {
+    BufferedSerial serial(USBTX, USBRX, BAUD);
+    uint32_t total = 0;
+
+    serial.set_blocking(false);
+    TEST_ASSERT_FALSE(serial.is_blocking());
+    TEST_ASSERT_EQUAL(POLLOUT, serial.poll(POLLOUT));
+
+    // Fill the TX buffer faster than the UART can drain it
+    while (true) {
+        ssize_t written = serial.write(line, sizeof(line) - 1);
+        if (written == -EAGAIN) {
+            break;
+        }
+        TEST_ASSERT(written > 0);
+        total += written;
+        TEST_ASSERT(total < 4 * MBED_CONF_DRIVERS_BUFFERED_SERIAL_TXBUF_SIZE);
+    }
+    TEST_ASSERT(total >= MBED_CONF_DRIVERS_BUFFERED_SERIAL_TXBUF_SIZE);
+    TEST_ASSERT_EQUAL(0, serial.poll(POLLOUT));
+
+    // Finish the partial line so the host sees whole lines only
+    serial.set_blocking(true);
+    uint32_t partial = total % (sizeof(line) - 1);
+    if (partial) {
+        serial.write(line + partial, sizeof(line) - 1 - partial);
+    }
+    TEST_ASSERT_EQUAL(0, serial.fsync());
+    TEST_ASSERT_EQUAL(POLLOUT, serial.poll(POLLOUT));
+}
+
+void test_non_blocking_read() {
+    BufferedSerial serial(USBTX, USBRX, BAUD);
+    char c;
+
+    serial.set_blocking(false);
+    TEST_ASSERT_EQUAL(0, serial.poll(POLLIN));
+    TEST_ASSERT_EQUAL(-EAGAIN, serial.read(&c, 1));
+    TEST_ASSERT_EQUAL(0, serial.read(&c, 0));
+}
+
+static volatile int sigio_count;
+
+static void sigio_handler() {
+    sigio_count++;
+}
+
+void test_sigio_on_space() {
+    BufferedSerial serial(USBTX, USBRX, BAUD);
+
+    sigio_count = 0;
+    serial.sigio(sigio_handler);
+    serial.set_blocking(false);
+    while (serial.write(line, sizeof(line) - 1) != -EAGAIN);
+
+    serial.set_blocking(true);
+    serial.write("\r\n", 2);
+    serial.fsync();
+    TEST_ASSERT(sigio_count > 0);
+    serial.sigio(Callback<void()>());
+}
+
+void test_write_in_critical_section() {
+    BufferedSerial serial(USBTX, USBRX, BAUD);
+
+    // More than the buffer holds, with nothing but the caller to drain it
+    core_util_critical_section_enter();
+    uint32_t total = 0;
+    while (total < 2 * MBED_CONF_DRIVERS_BUFFERED_SERIAL_TXBUF_SIZE) {
+        TEST_ASSERT_EQUAL(sizeof(line) - 1, serial.write(line, sizeof(line) - 1));
+        total += sizeof(line) - 1;
+    }
+    TEST_ASSERT_EQUAL(0, serial.fsync());
+    TEST_ASSERT_EQUAL(POLLOUT, serial.poll(POLLOUT));
+    core_util_critical_section_exit();
+}
+
+static BufferedSerial *isr_serial;
+static volatile uint32_t isr_written;
+
+static void isr_write() {
+    isr_written += isr_serial->write(line, sizeof(line) - 1);
+}
+
+void test_write_from_isr_and_thread() {
+    BufferedSerial serial(USBTX, USBRX, BAUD);
+    Ticker ticker;
+    uint32_t total = 0;
+
+    isr_serial = &serial;
+    isr_written = 0;
+
+    // The ticker interrupts the thread in the middle of its pushes, so both
+    // sides produce into the TX buffer at once
+    ticker.attach_us(isr_write, 2 * LINE_TIME_US);
+    while (total < 4 * MBED_CONF_DRIVERS_BUFFERED_SERIAL_TXBUF_SIZE) {
+        TEST_ASSERT_EQUAL(sizeof(line) - 1, serial.write(line, sizeof(line) - 1));
+        total += sizeof(line) - 1;
+    }
+    ticker.detach();
+
+    TEST_ASSERT_EQUAL(0, serial.fsync());
+    TEST_ASSERT_EQUAL(POLLOUT, serial.poll(POLLOUT));
+    TEST_ASSERT(isr_written > 0);
+}
+
+void test_file_handle() {
+    BufferedSerial serial(USBTX, USBRX, BAUD);
+
+    TEST_ASSERT_EQUAL(1, serial.isatty());
+    TEST_ASSERT_EQUAL(-1, serial.lseek(0, SEEK_SET));
+    TEST_ASSERT_EQUAL(0, serial.close());
+}
+
+Case cases[] = {
+    Case("Write returns before transmission", test_write_returns_before_transmission),
+    Case("Non-blocking write and POLLOUT", test_non_blocking_write),
+    Case("Non-blocking read and POLLIN", test_non_blocking_read),
+    Case("sigio when TX space frees up", test_sigio_on_space),
+    Case("Write with interrupts disabled", test_write_in_critical_section),
+    Case("Write from an interrupt while a thread writes", test_write_from_isr_and_thread),
+    Case("FileHandle interface", test_file_handle),
+};
+
+utest::v1::status_t greentea_test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(30, "default_auto");
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+Specification specification(greentea_test_setup, cases, greentea_test_teardown_handler);
+
+int main() {
+    Harness::run(specification);
+}
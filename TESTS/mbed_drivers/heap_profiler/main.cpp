@@ -0,0 +1,187 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "mbed.h"
+#include "greentea-client/test_env.h"
+#include "unity.h"
+#include "utest.h"
+#include "rtos.h"
+#include "mbed_stats.h"
+#include "mbed_heap_profiler.h"
+#include <stdlib.h>
+
+#if defined(MBED_RTOS_SINGLE_THREAD)
+  #error [NOT_SUPPORTED] test not supported
+#endif
+
+#if !defined(MBED_HEAP_PROFILER_ENABLED) || defined(__ICCARM__)
+  #error [NOT_SUPPORTED] test not supported
+#endif
+
+#if defined(TARGET_MCU_NRF51822) || defined(TARGET_MCU_NRF52832)
+    #define STACK_SIZE 512
+#elif defined(TARGET_STM32F070RB) || defined(TARGET_STM32F072RB) || defined(TARGET_STM32F103RB) || defined(TARGET_STM32F091RC)
+    #define STACK_SIZE 512
+#else
+    #define STACK_SIZE DEFAULT_STACK_SIZE
+#endif
+
+using namespace utest::v1;
+
+#define SMALL_SIZE          24
+#define LARGE_SIZE          200
+#define SMALL_COUNT         (MBED_HEAP_PROFILER_SAMPLE * 8)
+#define LARGE_COUNT         (MBED_HEAP_PROFILER_SAMPLE * 2)
+#define THREADS             3
+#define THREAD_ALLOCS       500
+
+static mbed_heap_profile_t before[MBED_HEAP_PROFILER_SIZE + 1];
+static mbed_heap_profile_t after[MBED_HEAP_PROFILER_SIZE + 1];
+
+/* Each in its own function, so they are two call sites */
+static __attribute__((noinline)) void *alloc_small() {
+    return malloc(SMALL_SIZE);
+}
+
+static __attribute__((noinline)) void *alloc_large() {
+    return malloc(LARGE_SIZE);
+}
+
+/* Allocations counted for a caller since the before snapshot */
+static mbed_heap_profile_t growth(void *caller, size_t before_count, size_t after_count) {
+    mbed_heap_profile_t diff = {caller, 0, 0, 0, 0};
+    for (size_t i = 0; i < after_count; i++) {
+        if (after[i].caller == caller) {
+            diff = after[i];
+        }
+    }
+    for (size_t i = 0; i < before_count; i++) {
+        if (before[i].caller == caller) {
+            diff.alloc_cnt -= before[i].alloc_cnt;
+            diff.alloc_size -= before[i].alloc_size;
+            diff.live_cnt -= before[i].live_cnt;
+            diff.live_size -= before[i].live_size;
+        }
+    }
+    return diff;
+}
+
+void test_call_sites() {
+    void *small[SMALL_COUNT];
+    void *large[LARGE_COUNT];
+
+    printf("Initial print to setup stdio buffers\r\n");
+    size_t before_count = mbed_heap_profiler_get(before, MBED_HEAP_PROFILER_SIZE + 1);
+    for (int i = 0; i < SMALL_COUNT; i++) {
+        small[i] = alloc_small();
+    }
+    for (int i = 0; i < LARGE_COUNT; i++) {
+        large[i] = alloc_large();
+    }
+    size_t after_count = mbed_heap_profiler_get(after, MBED_HEAP_PROFILER_SIZE + 1);
+
+    // The sites are the ones whose bytes grew by a multiple of each size
+    void *small_site = NULL;
+    void *large_site = NULL;
+    for (size_t i = 0; i < after_count; i++) {
+        mbed_heap_profile_t diff = growth(after[i].caller, before_count, after_count);
+        if (after[i].caller == NULL || diff.alloc_cnt == 0) {
+            continue;
+        }
+        if (diff.alloc_size == diff.alloc_cnt * SMALL_SIZE) {
+            small_site = after[i].caller;
+        } else if (diff.alloc_size == diff.alloc_cnt * LARGE_SIZE) {
+            large_site = after[i].caller;
+        }
+    }
+    TEST_ASSERT_NOT_NULL(small_site);
+    TEST_ASSERT_NOT_NULL(large_site);
+    TEST_ASSERT_NOT_EQUAL(small_site, large_site);
+
+    mbed_heap_profile_t small_diff = growth(small_site, before_count, after_count);
+    mbed_heap_profile_t large_diff = growth(large_site, before_count, after_count);
+    TEST_ASSERT_EQUAL_UINT32(SMALL_COUNT / MBED_HEAP_PROFILER_SAMPLE, small_diff.alloc_cnt);
+    TEST_ASSERT_EQUAL_UINT32(SMALL_COUNT / MBED_HEAP_PROFILER_SAMPLE, small_diff.live_cnt);
+    TEST_ASSERT_EQUAL_UINT32(LARGE_COUNT / MBED_HEAP_PROFILER_SAMPLE, large_diff.alloc_cnt);
+
+    // Freeing brings the live counts back, the totals stay
+    for (int i = 0; i < SMALL_COUNT; i++) {
+        free(small[i]);
+    }
+    for (int i = 0; i < LARGE_COUNT; i++) {
+        free(large[i]);
+    }
+    after_count = mbed_heap_profiler_get(after, MBED_HEAP_PROFILER_SIZE + 1);
+    small_diff = growth(small_site, before_count, after_count);
+    large_diff = growth(large_site, before_count, after_count);
+    TEST_ASSERT_EQUAL_UINT32(0, small_diff.live_cnt);
+    TEST_ASSERT_EQUAL_UINT32(0, small_diff.live_size);
+    TEST_ASSERT_EQUAL_UINT32(0, large_diff.live_cnt);
+    TEST_ASSERT_EQUAL_UINT32(LARGE_COUNT / MBED_HEAP_PROFILER_SAMPLE, large_diff.alloc_cnt);
+
+    // For tools/heap_profile.py
+    mbed_heap_profiler_dump();
+}
+
+/* Threads allocating at once leave the counts balanced */
+static void churn() {
+    for (int i = 0; i < THREAD_ALLOCS; i++) {
+        void *ptr = alloc_small();
+        ptr = realloc(ptr, LARGE_SIZE);
+        free(ptr);
+        Thread::yield();
+    }
+}
+
+void test_concurrent() {
+    Thread *threads[THREADS];
+
+    size_t before_count = mbed_heap_profiler_get(before, MBED_HEAP_PROFILER_SIZE + 1);
+    for (int i = 0; i < THREADS; i++) {
+        threads[i] = new Thread(osPriorityNormal, STACK_SIZE);
+        threads[i]->start(churn);
+    }
+    for (int i = 0; i < THREADS; i++) {
+        threads[i]->join();
+        delete threads[i];
+    }
+    size_t after_count = mbed_heap_profiler_get(after, MBED_HEAP_PROFILER_SIZE + 1);
+
+    // Everything allocated meanwhile, the threads included, was freed
+    uint32_t counted = 0;
+    for (size_t i = 0; i < after_count; i++) {
+        mbed_heap_profile_t diff = growth(after[i].caller, before_count, after_count);
+        TEST_ASSERT_EQUAL_UINT32(0, diff.live_cnt);
+        TEST_ASSERT_EQUAL_UINT32(0, diff.live_size);
+        counted += diff.alloc_cnt;
+    }
+    TEST_ASSERT_TRUE(counted >= THREADS * THREAD_ALLOCS * 2 / MBED_HEAP_PROFILER_SAMPLE);
+}
+
+Case cases[] = {
+    Case("Allocations counted per call site", test_call_sites),
+    Case("Allocations from several threads", test_concurrent),
+};
+
+utest::v1::status_t greentea_test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(30, "default_auto");
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+Specification specification(greentea_test_setup, cases, greentea_test_teardown_handler);
+
+int main() {
+    Harness::run(specification);
+}
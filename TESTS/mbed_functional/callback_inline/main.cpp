@@ -0,0 +1,221 @@
+#include "mbed.h"
+#include "greentea-client/test_env.h"
+#include "unity.h"
+#include "utest.h"
+
+using namespace utest::v1;
+
+#define BENCHMARK_CALLS     100000
+
+// Function objects larger than the default storage
+struct Sum {
+    uint32_t values[8];
+
+    uint32_t operator()(uint32_t a0) const {
+        uint32_t sum = a0;
+        for (int i = 0; i < 8; i++) {
+            sum += values[i];
+        }
+        return sum;
+    }
+};
+
+struct Counted {
+    static int live;
+    static int copies;
+    uint32_t values[8];
+
+    Counted() { memset(values, 0, sizeof(values)); live++; }
+    Counted(const Counted &other) { memcpy(values, other.values, sizeof(values)); live++; copies++; }
+    ~Counted() { live--; }
+
+    uint32_t operator()(uint32_t a0) const {
+        return values[0] + a0;
+    }
+};
+
+int Counted::live;
+int Counted::copies;
+
+struct Thing {
+    uint32_t t;
+    Thing() : t(0x80) {}
+
+    uint32_t member_func(uint32_t a0) { return t | a0; }
+};
+
+static uint32_t static_func(uint32_t a0) { return 0x40 | a0; }
+
+static Sum make_sum() {
+    Sum sum;
+    for (int i = 0; i < 8; i++) {
+        sum.values[i] = i + 1;
+    }
+    return sum;
+}
+
+
+void test_default_size() {
+    // Events are sized for the default Callback, so it must not grow
+    TEST_ASSERT_EQUAL(sizeof(void (Thing::*)()) + 2*sizeof(void*), sizeof(Callback<void()>));
+    TEST_ASSERT_TRUE(sizeof(Callback<uint32_t(uint32_t), sizeof(Sum)>) >= sizeof(Sum) + sizeof(void*));
+
+    // Smaller sizes keep room for a member function
+    Thing thing;
+    Callback<uint32_t(uint32_t), 1> cb(&thing, &Thing::member_func);
+    TEST_ASSERT_EQUAL(0x81, cb(1));
+    cb = static_func;
+    TEST_ASSERT_EQUAL(0x41, cb(1));
+}
+
+void test_large_function_object() {
+    Sum sum = make_sum();
+    Callback<uint32_t(uint32_t), sizeof(Sum)> cb(sum);
+    TEST_ASSERT_EQUAL(37, cb(1));
+
+    // Copies of a trivial object are plain copies of the storage
+    Callback<uint32_t(uint32_t), sizeof(Sum)> copy(cb);
+    TEST_ASSERT_TRUE(copy == cb);
+    TEST_ASSERT_EQUAL(37, copy(1));
+    sum.values[0] = 0;
+    copy = sum;
+    TEST_ASSERT_TRUE(copy != cb);
+    TEST_ASSERT_EQUAL(36, copy(1));
+
+    // The same type still takes functions and member functions
+    Thing thing;
+    copy.attach(&thing, &Thing::member_func);
+    TEST_ASSERT_EQUAL(0x81, copy(1));
+    copy = callback(static_func);
+    TEST_ASSERT_EQUAL(0x41, copy(1));
+}
+
+void test_non_trivial_function_object() {
+    Counted::live = 0;
+    {
+        Counted counted;
+        counted.values[0] = 10;
+        Callback<uint32_t(uint32_t), sizeof(Counted)> cb(counted);
+        TEST_ASSERT_EQUAL(11, cb(1));
+
+        Callback<uint32_t(uint32_t), sizeof(Counted)> copy(cb);
+        TEST_ASSERT_EQUAL(11, copy(1));
+        TEST_ASSERT_EQUAL(3, Counted::live);
+
+        copy = static_func;
+        TEST_ASSERT_EQUAL(2, Counted::live);
+        copy = cb;
+        TEST_ASSERT_EQUAL(3, Counted::live);
+    }
+    TEST_ASSERT_EQUAL(0, Counted::live);
+}
+
+void test_larger_storage() {
+    // A smaller Callback is a function object that fits in a larger one
+    Callback<uint32_t(uint32_t)> small(static_func);
+    Callback<uint32_t(uint32_t), 2*sizeof(Callback<uint32_t(uint32_t)>)> large(small);
+    TEST_ASSERT_EQUAL(0x41, large(1));
+}
+
+#if MBED_CONF_EVENTS_PRESENT
+static uint32_t posted;
+
+struct Post {
+    uint32_t values[6];
+
+    void operator()() const {
+        for (int i = 0; i < 6; i++) {
+            posted += values[i];
+        }
+    }
+};
+
+void test_event_queue() {
+    EventQueue queue(4*(EVENTS_EVENT_SIZE + sizeof(Post)));
+    Post post = {{1, 2, 3, 4, 5, 6}};
+    Callback<void(), sizeof(Post)> cb(post);
+
+    posted = 0;
+    TEST_ASSERT_NOT_EQUAL(0, queue.call(cb));
+    TEST_ASSERT_NOT_EQUAL(0, queue.call(cb));
+    queue.dispatch(0);
+    TEST_ASSERT_EQUAL(42, posted);
+}
+#endif
+
+/* Cost of calls and copies, so growing the storage can be weighed against
+ * the overhead of each call */
+template <typename F>
+static uint32_t time_calls(F &f) {
+    Timer timer;
+    volatile uint32_t result = 0;
+
+    timer.start();
+    for (uint32_t i = 0; i < BENCHMARK_CALLS; i++) {
+        result = result + f(i);
+    }
+    return timer.read_us();
+}
+
+template <typename F>
+static uint32_t time_copies(const F &f) {
+    Timer timer;
+
+    timer.start();
+    for (uint32_t i = 0; i < BENCHMARK_CALLS; i++) {
+        F copy(f);
+        volatile uint32_t result = copy(i);
+        (void)result;
+    }
+    return timer.read_us();
+}
+
+void test_benchmark() {
+    Sum sum = make_sum();
+    Counted counted;
+    Thing thing;
+    uint32_t (*func)(uint32_t) = static_func;
+    Callback<uint32_t(uint32_t)> static_cb(static_func);
+    Callback<uint32_t(uint32_t)> member_cb(&thing, &Thing::member_func);
+    Callback<uint32_t(uint32_t), sizeof(Sum)> sum_cb(sum);
+    Callback<uint32_t(uint32_t), sizeof(Counted)> counted_cb(counted);
+
+    printf("%d calls:\r\n", BENCHMARK_CALLS);
+    printf("  function pointer     %lu us\r\n", (unsigned long)time_calls(func));
+    printf("  Callback, function   %lu us\r\n", (unsigned long)time_calls(static_cb));
+    printf("  Callback, member     %lu us\r\n", (unsigned long)time_calls(member_cb));
+    printf("  function object      %lu us\r\n", (unsigned long)time_calls(sum));
+    printf("  Callback, object     %lu us\r\n", (unsigned long)time_calls(sum_cb));
+    printf("%d copies and calls:\r\n", BENCHMARK_CALLS);
+    printf("  Callback, function   %lu us\r\n", (unsigned long)time_copies(static_cb));
+    printf("  Callback, trivial    %lu us\r\n", (unsigned long)time_copies(sum_cb));
+    printf("  Callback, copy ctor  %lu us\r\n", (unsigned long)time_copies(counted_cb));
+
+    Counted::copies = 0;
+    Callback<uint32_t(uint32_t), sizeof(Counted)> copy(counted_cb);
+    TEST_ASSERT_EQUAL(1, Counted::copies);
+}
+
+
+// Test setup
+utest::v1::status_t test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(20, "default_auto");
+    return verbose_test_setup_handler(number_of_cases);
+}
+
+Case cases[] = {
+    Case("Testing the default storage size", test_default_size),
+    Case("Testing large function objects", test_large_function_object),
+    Case("Testing non-trivial function objects", test_non_trivial_function_object),
+    Case("Testing callbacks in larger callbacks", test_larger_storage),
+#if MBED_CONF_EVENTS_PRESENT
+    Case("Testing large callbacks on an event queue", test_event_queue),
+#endif
+    Case("Benchmarking calls and copies", test_benchmark),
+};
+
+Specification specification(test_setup, cases);
+
+int main() {
+    return !Harness::run(specification);
+}
@@ -0,0 +1,358 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utest/utest.h"
+#include "unity/unity.h"
+#include "greentea-client/test_env.h"
+
+#include "mbed.h"
+#include "ticker_api.h"
+
+using namespace utest::v1;
+
+#define EVENT_COUNT     64
+#define RANDOM_STEPS    5000
+
+/* A simulated ticker: time only moves when the test advances it, and the
+ * interrupt is run by the test once time reaches it */
+static timestamp_t sim_time;
+static bool sim_irq_enabled;
+static timestamp_t sim_irq_time;
+static uint32_t sim_set_count;
+
+static void sim_init(void) {}
+static uint32_t sim_read(void) { return sim_time; }
+static void sim_disable_interrupt(void) { sim_irq_enabled = false; }
+static void sim_clear_interrupt(void) {}
+
+static void sim_set_interrupt(timestamp_t timestamp) {
+    sim_irq_enabled = true;
+    sim_irq_time = timestamp;
+    sim_set_count++;
+}
+
+static const ticker_interface_t sim_interface = {
+    sim_init,
+    sim_read,
+    sim_disable_interrupt,
+    sim_clear_interrupt,
+    sim_set_interrupt,
+};
+
+static ticker_event_queue_t sim_queue;
+static const ticker_data_t sim_data = {&sim_interface, &sim_queue};
+
+typedef struct {
+    ticker_event_t event;
+    timestamp_t period;
+    uint32_t runs;
+    bool pending;
+} test_event_t;
+
+static test_event_t events[EVENT_COUNT];
+static uint32_t run_log[4 * EVENT_COUNT];
+static uint32_t run_count;
+static uint32_t seed;
+
+static uint32_t next_random(uint32_t range) {
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 8) % range;
+}
+
+static void event_handler(uint32_t id) {
+    test_event_t *e = &events[id];
+    // Only events in the past run
+    TEST_ASSERT_TRUE((int)(sim_time - e->event.timestamp) >= 0);
+    if (run_count < sizeof(run_log) / sizeof(run_log[0])) {
+        run_log[run_count] = id;
+    }
+    run_count++;
+    e->runs++;
+    e->pending = false;
+    if (e->period != 0) {
+        ticker_rearm_event(&sim_data, &e->event, e->period);
+        e->pending = true;
+    }
+}
+
+static void sim_reset(timestamp_t time) {
+    memset(&sim_queue, 0, sizeof(sim_queue));
+    memset(events, 0, sizeof(events));
+    sim_time = time;
+    sim_irq_enabled = false;
+    sim_set_count = 0;
+    run_count = 0;
+    seed = 12345;
+    ticker_set_handler(&sim_data, event_handler);
+}
+
+// Move time forward, running the interrupt each time it is reached
+static void sim_advance(timestamp_t ticks) {
+    timestamp_t end = sim_time + ticks;
+    while (sim_irq_enabled && (int)(end - sim_irq_time) >= 0) {
+        if ((int)(sim_irq_time - sim_time) > 0) {
+            sim_time = sim_irq_time;
+        }
+        ticker_irq_handler(&sim_data);
+    }
+    sim_time = end;
+}
+
+static void insert_event(uint32_t id, timestamp_t timestamp) {
+    ticker_insert_event(&sim_data, &events[id].event, timestamp, id);
+    events[id].pending = true;
+}
+
+static void remove_event(uint32_t id) {
+    ticker_remove_event(&sim_data, &events[id].event);
+    events[id].pending = false;
+}
+
+// The queue and the interrupt agree with the pending events
+static void check_next() {
+    bool pending = false;
+    timestamp_t first = 0;
+    for (int i = 0; i < EVENT_COUNT; i++) {
+        if (events[i].pending && (!pending || (int)(events[i].event.timestamp - first) < 0)) {
+            first = events[i].event.timestamp;
+            pending = true;
+        }
+    }
+
+    timestamp_t next;
+    TEST_ASSERT_EQUAL(pending, ticker_get_next_timestamp(&sim_data, &next));
+    TEST_ASSERT_EQUAL(pending, sim_irq_enabled);
+    if (pending) {
+        TEST_ASSERT_EQUAL_UINT32(first, next);
+        TEST_ASSERT_EQUAL_UINT32(first, sim_irq_time);
+    }
+}
+
+void test_order() {
+    // Across the wrap of the timestamps
+    sim_reset(0xFFFFF000);
+    for (int i = 0; i < EVENT_COUNT; i++) {
+        insert_event(i, sim_time + 1 + next_random(0x2000));
+        check_next();
+    }
+
+    sim_advance(0x2000);
+    TEST_ASSERT_EQUAL(EVENT_COUNT, run_count);
+    TEST_ASSERT_FALSE(sim_irq_enabled);
+    for (int i = 1; i < EVENT_COUNT; i++) {
+        timestamp_t previous = events[run_log[i - 1]].event.timestamp - 0xFFFFF000;
+        TEST_ASSERT_TRUE(events[run_log[i]].event.timestamp - 0xFFFFF000 >= previous);
+    }
+    for (int i = 0; i < EVENT_COUNT; i++) {
+        TEST_ASSERT_EQUAL(1, events[i].runs);
+    }
+}
+
+// Events with the same timestamp run in the order they were inserted
+void test_same_timestamp() {
+    const uint32_t half = EVENT_COUNT / 2;
+
+    sim_reset(0);
+    // Among earlier and later events, so the heap gets merged in between
+    for (int i = half - 1; i >= 0; i--) {
+        insert_event(i, 500);
+        insert_event(half + i, 100 + next_random(800));
+    }
+    // Moving an event puts it last
+    insert_event(half - 1, 500);
+
+    sim_advance(1000);
+    TEST_ASSERT_EQUAL(EVENT_COUNT, run_count);
+    uint32_t order = 0;
+    for (uint32_t i = 0; i < run_count; i++) {
+        if (run_log[i] < half) {
+            TEST_ASSERT_EQUAL(order < half - 1 ? half - 2 - order : half - 1, run_log[i]);
+            order++;
+        }
+    }
+    TEST_ASSERT_EQUAL(half, order);
+}
+
+void test_remove() {
+    sim_reset(0);
+    for (int i = 0; i < EVENT_COUNT; i++) {
+        insert_event(i, 100 + next_random(1000));
+    }
+    // The first, the last and everything between
+    for (int i = 0; i < EVENT_COUNT; i += 3) {
+        remove_event(i);
+        check_next();
+    }
+    // Removing again, or events never inserted, does nothing
+    remove_event(0);
+    ticker_event_t unused = {0};
+    ticker_remove_event(&sim_data, &unused);
+    check_next();
+    // Inserting a pending event moves it
+    insert_event(1, 50);
+    check_next();
+    insert_event(1, 2000);
+    check_next();
+
+    sim_advance(1999);
+    TEST_ASSERT_EQUAL(EVENT_COUNT - (EVENT_COUNT + 2) / 3 - 1, run_count);
+    sim_advance(1);
+    TEST_ASSERT_EQUAL(1, events[1].runs);
+    for (int i = 0; i < EVENT_COUNT; i += 3) {
+        TEST_ASSERT_EQUAL(0, events[i].runs);
+    }
+    check_next();
+}
+
+// Random inserts, moves, removes and time steps against the events' state
+void test_random() {
+    uint32_t expected = 0;
+
+    sim_reset(0x7FFFF000);
+    for (int step = 0; step < RANDOM_STEPS; step++) {
+        uint32_t id = next_random(EVENT_COUNT);
+        switch (next_random(4)) {
+            case 0:
+            case 1:
+                insert_event(id, sim_time + next_random(3000));
+                break;
+            case 2:
+                remove_event(id);
+                break;
+            case 3: {
+                timestamp_t ticks = next_random(500);
+                for (int i = 0; i < EVENT_COUNT; i++) {
+                    if (events[i].pending && (int)(sim_time + ticks - events[i].event.timestamp) >= 0) {
+                        expected++;
+                    }
+                }
+                sim_advance(ticks);
+                TEST_ASSERT_EQUAL(expected, run_count);
+                break;
+            }
+        }
+        check_next();
+    }
+}
+
+void test_rearm() {
+    ticker_stats_t stats;
+
+    sim_reset(0);
+    // Periodic events rearmed together set the interrupt once
+    for (int i = 0; i < 16; i++) {
+        events[i].period = 100;
+        insert_event(i, 100);
+    }
+    for (int i = 16; i < 32; i++) {
+        events[i].period = 100 + i;
+        insert_event(i, 100 + i);
+    }
+    sim_set_count = 0;
+    sim_advance(100);
+    TEST_ASSERT_EQUAL(16, run_count);
+    TEST_ASSERT_EQUAL(1, sim_set_count);
+    TEST_ASSERT_EQUAL_UINT32(116, sim_irq_time);
+    check_next();
+
+    // Each one keeps its period
+    sim_advance(10000 - 100);
+    for (int i = 0; i < 32; i++) {
+        TEST_ASSERT_EQUAL(10000 / events[i].period, events[i].runs);
+        TEST_ASSERT_EQUAL_UINT32(events[i].period * (events[i].runs + 1), events[i].event.timestamp);
+    }
+    ticker_get_stats(&sim_data, &stats);
+    TEST_ASSERT_EQUAL(run_count, stats.dispatched);
+    TEST_ASSERT_EQUAL(0, stats.late_max);
+    TEST_ASSERT_EQUAL(0, stats.catch_up);
+}
+
+void test_catch_up() {
+    ticker_stats_t stats;
+
+    sim_reset(0);
+    events[0].period = 10;
+    insert_event(0, 10);
+    insert_event(1, 100);
+
+    // An interrupt 25 ticks late runs the event for each period missed
+    sim_time = 35;
+    ticker_irq_handler(&sim_data);
+    TEST_ASSERT_EQUAL(3, events[0].runs);
+    TEST_ASSERT_EQUAL_UINT32(40, events[0].event.timestamp);
+    TEST_ASSERT_EQUAL_UINT32(40, sim_irq_time);
+    ticker_get_stats(&sim_data, &stats);
+    TEST_ASSERT_EQUAL(3, stats.dispatched);
+    TEST_ASSERT_EQUAL(25, stats.late_max);
+    TEST_ASSERT_EQUAL(2, stats.catch_up);
+
+    ticker_reset_stats(&sim_data);
+    sim_advance(100 - 35);
+    ticker_get_stats(&sim_data, &stats);
+    TEST_ASSERT_EQUAL(8, stats.dispatched);
+    TEST_ASSERT_EQUAL(0, stats.late_max);
+    TEST_ASSERT_EQUAL(0, stats.catch_up);
+    TEST_ASSERT_EQUAL(1, events[1].runs);
+}
+
+/* Time to insert and remove an event with more and more events pending */
+void test_benchmark() {
+    Timer timer;
+
+    for (int count = 4; count <= EVENT_COUNT; count *= 4) {
+        sim_reset(0);
+        for (int i = 0; i < count; i++) {
+            insert_event(i, 1000 + next_random(100000));
+        }
+        timer.reset();
+        timer.start();
+        for (int i = 0; i < 1000; i++) {
+            uint32_t id = next_random(count);
+            insert_event(id, 1000 + next_random(100000));
+        }
+        timer.stop();
+        int move_us = timer.read_us();
+
+        timer.reset();
+        timer.start();
+        sim_advance(200000);
+        timer.stop();
+        printf("%2d events: 1000 moves %4d us, %4lu events run %4d us\r\n",
+               count, move_us, (unsigned long)run_count, timer.read_us());
+        TEST_ASSERT_EQUAL(count, run_count);
+    }
+}
+
+utest::v1::status_t greentea_test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(20, "default_auto");
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+Case cases[] = {
+    Case("Events run in order", test_order),
+    Case("Events with the same timestamp", test_same_timestamp),
+    Case("Removing and moving events", test_remove),
+    Case("Random operations", test_random),
+    Case("Rearming periodic events", test_rearm),
+    Case("Catching up late periodic events", test_catch_up),
+    Case("Benchmark", test_benchmark),
+};
+
+Specification specification(greentea_test_setup, cases, greentea_test_teardown_handler);
+
+int main() {
+    Harness::run(specification);
+}
@@ -0,0 +1,222 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "mbed.h"
+#include "mbed_events.h"
+#include "greentea-client/test_env.h"
+#include "unity.h"
+#include "utest.h"
+#include "platform/AsyncConsole.h"
+#include <string.h>
+
+using namespace utest::v1;
+
+#define RING_SIZE       256
+// Roughly a 115200 baud UART
+#define US_PER_BYTE     87
+
+/* Output device that costs as much time per byte as a UART, and records
+ * what it was given */
+class SlowOutput : public FileHandle {
+public:
+    SlowOutput() : length(0) {
+    }
+
+    virtual ssize_t write(const void *buffer, size_t size) {
+        for (size_t i = 0; i < size; i++) {
+            wait_us(US_PER_BYTE);
+            if (length < sizeof(data)) {
+                data[length++] = ((const char *)buffer)[i];
+            }
+        }
+        return size;
+    }
+    virtual ssize_t read(void *buffer, size_t size) { return -1; }
+    virtual int close() { return 0; }
+    virtual int isatty() { return 1; }
+    virtual off_t lseek(off_t offset, int whence) { return -1; }
+
+    bool contains(const char *str) const {
+        size_t len = strlen(str);
+        for (size_t i = 0; i + len <= length; i++) {
+            if (memcmp(&data[i], str, len) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    char data[4 * RING_SIZE];
+    size_t length;
+};
+
+static void noop() {
+}
+
+static char line[RING_SIZE / 4];
+
+static void fill_line(size_t size) {
+    memset(line, 'x', size - 1);
+    line[size - 1] = '\n';
+}
+
+void test_latency_against_line_length() {
+    static const size_t sizes[] = {8, 16, 32, 64};
+
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        SlowOutput direct;
+        SlowOutput queued;
+        AsyncConsole console(&queued, RING_SIZE);
+        Timer timer;
+
+        // Nobody drains while measuring
+        console.attach(noop);
+        fill_line(sizes[i]);
+
+        timer.start();
+        direct.write(line, sizes[i]);
+        int direct_us = timer.read_us();
+
+        timer.reset();
+        console.write(line, sizes[i]);
+        int queued_us = timer.read_us();
+
+        printf("line %u bytes: direct %d us, async %d us\r\n",
+               (unsigned)sizes[i], direct_us, queued_us);
+
+        // The async write only pays for the copy
+        TEST_ASSERT(queued_us < direct_us / 4);
+
+        TEST_ASSERT_EQUAL(sizes[i], console.drain());
+        TEST_ASSERT_EQUAL(sizes[i], queued.length);
+        TEST_ASSERT_EQUAL(0, memcmp(queued.data, line, sizes[i]));
+    }
+}
+
+void test_overflow_drop() {
+    SlowOutput output;
+    AsyncConsole console(&output, RING_SIZE, AsyncConsole::OverflowDrop);
+    AsyncConsole::Stats stats;
+
+    console.attach(noop);
+    fill_line(sizeof(line));
+    for (int i = 0; i < 8; i++) {
+        TEST_ASSERT_EQUAL(sizeof(line), console.write(line, sizeof(line)));
+    }
+    TEST_ASSERT_EQUAL(0, console.poll(POLLOUT));
+
+    console.get_stats(&stats);
+    TEST_ASSERT_EQUAL(RING_SIZE, stats.bytes_written);
+    TEST_ASSERT_EQUAL(4 * sizeof(line), stats.bytes_dropped);
+    TEST_ASSERT_EQUAL(RING_SIZE, stats.max_used);
+
+    TEST_ASSERT_EQUAL(RING_SIZE, console.drain());
+    TEST_ASSERT_EQUAL(RING_SIZE, output.length);
+    TEST_ASSERT_EQUAL(POLLOUT, console.poll(POLLOUT));
+}
+
+void test_overflow_report() {
+    SlowOutput output;
+    AsyncConsole console(&output, RING_SIZE, AsyncConsole::OverflowReport);
+
+    console.attach(noop);
+    fill_line(sizeof(line));
+    for (int i = 0; i < 5; i++) {
+        console.write(line, sizeof(line));
+    }
+    console.drain();
+
+    TEST_ASSERT(output.length > RING_SIZE);
+    TEST_ASSERT(output.contains("[console: 64 bytes dropped]"));
+}
+
+void test_overflow_block() {
+    SlowOutput output;
+    AsyncConsole console(&output, RING_SIZE, AsyncConsole::OverflowBlock);
+    AsyncConsole::Stats stats;
+    char big[2 * RING_SIZE];
+
+    // Without a drain thread or callback the writer drains itself
+    memset(big, 'b', sizeof(big));
+    TEST_ASSERT_EQUAL(sizeof(big), console.write(big, sizeof(big)));
+
+    console.get_stats(&stats);
+    TEST_ASSERT_EQUAL(0, stats.bytes_dropped);
+    TEST_ASSERT_EQUAL(sizeof(big), stats.bytes_drained);
+    TEST_ASSERT_EQUAL(sizeof(big), output.length);
+}
+
+void test_drain_from_event_queue() {
+    SlowOutput output;
+    AsyncConsole console(&output, RING_SIZE);
+    EventQueue queue;
+    Timer timer;
+
+    Event<void()> drain_event = queue.event(&console, &AsyncConsole::drain);
+    console.attach(callback(&drain_event, &Event<void()>::call));
+    fill_line(sizeof(line));
+
+    timer.start();
+    console.write(line, sizeof(line));
+    console.write(line, sizeof(line));
+    int write_us = timer.read_us();
+    TEST_ASSERT_EQUAL(0, output.length);
+
+    queue.dispatch(0);
+    int drain_us = timer.read_us();
+
+    printf("two lines queued in %d us, drained after %d us\r\n", write_us, drain_us);
+    TEST_ASSERT_EQUAL(2 * sizeof(line), output.length);
+}
+
+#ifdef MBED_CONF_RTOS_PRESENT
+void test_drain_thread_and_fsync() {
+    SlowOutput output;
+    AsyncConsole console(&output, RING_SIZE);
+
+    TEST_ASSERT_EQUAL(osOK, console.start(osPriorityLow));
+    fill_line(sizeof(line));
+    for (int i = 0; i < 16; i++) {
+        console.write(line, sizeof(line));
+        // Let the drain thread keep up
+        Thread::wait(5);
+    }
+
+    TEST_ASSERT_EQUAL(0, console.fsync());
+    TEST_ASSERT_EQUAL(16 * sizeof(line), output.length);
+}
+#endif
+
+Case cases[] = {
+    Case("Write latency against line length", test_latency_against_line_length),
+    Case("Overflow policy drop", test_overflow_drop),
+    Case("Overflow policy report", test_overflow_report),
+    Case("Overflow policy block", test_overflow_block),
+    Case("Drain from an EventQueue", test_drain_from_event_queue),
+#ifdef MBED_CONF_RTOS_PRESENT
+    Case("Drain thread and fsync", test_drain_thread_and_fsync),
+#endif
+};
+
+utest::v1::status_t greentea_test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(30, "default_auto");
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+Specification specification(greentea_test_setup, cases, greentea_test_teardown_handler);
+
+int main() {
+    Harness::run(specification);
+}
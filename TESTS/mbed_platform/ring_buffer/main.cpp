@@ -0,0 +1,192 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "mbed.h"
+#include "greentea-client/test_env.h"
+#include "unity.h"
+#include "utest.h"
+#include "platform/RingBuffer.h"
+#include "platform/CircularBuffer.h"
+
+using namespace utest::v1;
+
+#define BUFFER_SIZE     64
+#define BENCH_BYTES     (16 * 1024)
+#define BENCH_CHUNK     32
+#define ISR_BYTES       4096
+
+void test_single_element() {
+    RingBuffer<int, 4> buf;
+    int data;
+
+    TEST_ASSERT_TRUE(buf.empty());
+    TEST_ASSERT_FALSE(buf.pop(data));
+
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_TRUE(buf.push(i));
+    }
+    TEST_ASSERT_TRUE(buf.full());
+    // Full buffers reject rather than overwrite
+    TEST_ASSERT_FALSE(buf.push(4));
+
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_TRUE(buf.pop(data));
+        TEST_ASSERT_EQUAL(i, data);
+    }
+    TEST_ASSERT_TRUE(buf.empty());
+}
+
+void test_bulk_wrap() {
+    RingBuffer<uint8_t, 8> buf;
+    uint8_t in[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    uint8_t out[10];
+
+    TEST_ASSERT_EQUAL(8, buf.push(in, 10));
+    TEST_ASSERT_EQUAL(5, buf.pop(out, 5));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(in, out, 5);
+
+    // Wraps around the end of the storage
+    TEST_ASSERT_EQUAL(5, buf.push(in, 10));
+    TEST_ASSERT_EQUAL(8, buf.size());
+    TEST_ASSERT_EQUAL(8, buf.pop(out, 10));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(in + 5, out, 3);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(in, out + 3, 5);
+    TEST_ASSERT_TRUE(buf.empty());
+}
+
+void test_spans() {
+    RingBuffer<uint8_t, 8, RingBufferSPSC> buf;
+    uint8_t in[6] = {1, 2, 3, 4, 5, 6};
+    uint32_t size;
+
+    uint8_t *wr = buf.write_span(size);
+    TEST_ASSERT_EQUAL(8, size);
+    memcpy(wr, in, 6);
+    buf.commit_write(6);
+
+    const uint8_t *rd = buf.read_span(size);
+    TEST_ASSERT_EQUAL(6, size);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(in, rd, 6);
+    buf.commit_read(6);
+
+    // Only the two elements up to the end of storage are contiguous
+    wr = buf.write_span(size);
+    TEST_ASSERT_EQUAL(2, size);
+    buf.commit_write(2);
+    wr = buf.write_span(size);
+    TEST_ASSERT_EQUAL(6, size);
+
+    TEST_ASSERT_EQUAL(2, buf.size());
+    buf.reset();
+    TEST_ASSERT_TRUE(buf.empty());
+}
+
+static RingBuffer<uint8_t, BUFFER_SIZE, RingBufferSPSC> isr_buf;
+static volatile uint32_t isr_produced;
+
+static void isr_producer() {
+    uint8_t chunk[7];
+    uint32_t count = 0;
+    while (count < sizeof(chunk) && isr_produced + count < ISR_BYTES) {
+        chunk[count] = (uint8_t)(isr_produced + count);
+        count++;
+    }
+    isr_produced += isr_buf.push(chunk, count);
+}
+
+void test_spsc_interrupt_producer() {
+    Ticker ticker;
+    uint8_t out[13];
+    uint32_t consumed = 0;
+
+    isr_produced = 0;
+    ticker.attach_us(isr_producer, 100);
+
+    Timer timer;
+    timer.start();
+    while (consumed < ISR_BYTES && timer.read_ms() < 10000) {
+        uint32_t count = isr_buf.pop(out, sizeof(out));
+        for (uint32_t i = 0; i < count; i++) {
+            TEST_ASSERT_EQUAL_UINT8((uint8_t)consumed, out[i]);
+            consumed++;
+        }
+    }
+    ticker.detach();
+
+    TEST_ASSERT_EQUAL(ISR_BYTES, consumed);
+    TEST_ASSERT_TRUE(isr_buf.empty());
+}
+
+template <typename Buffer>
+static int bench_bulk(Buffer &buf) {
+    uint8_t chunk[BENCH_CHUNK] = {0};
+    Timer timer;
+    timer.start();
+    for (uint32_t i = 0; i < BENCH_BYTES; i += BENCH_CHUNK) {
+        buf.push(chunk, BENCH_CHUNK);
+        buf.pop(chunk, BENCH_CHUNK);
+    }
+    return timer.read_us();
+}
+
+void test_benchmark() {
+    static CircularBuffer<uint8_t, BUFFER_SIZE> circular;
+    static RingBuffer<uint8_t, BUFFER_SIZE> locked;
+    static RingBuffer<uint8_t, BUFFER_SIZE, RingBufferSPSC> spsc;
+    uint8_t data = 0;
+
+    Timer timer;
+    timer.start();
+    for (uint32_t i = 0; i < BENCH_BYTES; i++) {
+        circular.push(data);
+        circular.pop(data);
+    }
+    int circular_us = timer.read_us();
+
+    timer.reset();
+    for (uint32_t i = 0; i < BENCH_BYTES; i++) {
+        locked.push(data);
+        locked.pop(data);
+    }
+    int single_us = timer.read_us();
+
+    int locked_us = bench_bulk(locked);
+    int spsc_us = bench_bulk(spsc);
+
+    printf("%d bytes through %d byte buffers:\r\n", BENCH_BYTES, BUFFER_SIZE);
+    printf("  CircularBuffer per byte:    %d us\r\n", circular_us);
+    printf("  RingBuffer per byte:        %d us\r\n", single_us);
+    printf("  RingBuffer %d byte bulk:    %d us\r\n", BENCH_CHUNK, locked_us);
+    printf("  RingBuffer SPSC %d byte:    %d us\r\n", BENCH_CHUNK, spsc_us);
+}
+
+Case cases[] = {
+    Case("Single element push/pop", test_single_element),
+    Case("Bulk push/pop with wrap", test_bulk_wrap),
+    Case("Zero-copy spans", test_spans),
+    Case("SPSC with interrupt producer", test_spsc_interrupt_producer),
+    Case("Benchmark against CircularBuffer", test_benchmark),
+};
+
+utest::v1::status_t greentea_test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(30, "default_auto");
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+Specification specification(greentea_test_setup, cases, greentea_test_teardown_handler);
+
+int main() {
+    Harness::run(specification);
+}
@@ -0,0 +1,295 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "mbed.h"
+#include "greentea-client/test_env.h"
+#include "unity.h"
+#include "utest.h"
+#include "mbed_tlsf.h"
+#include "us_ticker_api.h"
+#include <stdlib.h>
+
+using namespace utest::v1;
+
+#define POOL_SIZE           8192
+#define REGION_SIZE         1024
+#define TRACE_SLOTS         48
+#define TRACE_OPS           4000
+
+static MBED_ALIGN(8) uint8_t pool[POOL_SIZE];
+static MBED_ALIGN(8) uint8_t region[REGION_SIZE];
+static mbed_tlsf_t tlsf;
+
+static bool filled(const void *data, uint8_t value, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        if (((const uint8_t *)data)[i] != value) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void test_malloc_free() {
+    mbed_tlsf_info_t info;
+    void *blocks[8];
+
+    mbed_tlsf_init(&tlsf);
+    TEST_ASSERT_NULL(mbed_tlsf_malloc(&tlsf, 1));
+    TEST_ASSERT_TRUE(mbed_tlsf_add_region(&tlsf, pool, POOL_SIZE));
+    mbed_tlsf_get_info(&tlsf, &info);
+    size_t free_size = info.free_size;
+    TEST_ASSERT_EQUAL(1, info.free_blocks);
+    TEST_ASSERT_TRUE(free_size >= POOL_SIZE - 32);
+
+    for (int i = 0; i < 8; i++) {
+        blocks[i] = mbed_tlsf_malloc(&tlsf, 1 << (i + 2));
+        TEST_ASSERT_NOT_NULL(blocks[i]);
+        TEST_ASSERT_EQUAL(0, (uintptr_t)blocks[i] & 7);
+        TEST_ASSERT_TRUE(mbed_tlsf_block_size(blocks[i]) >= (size_t)(1 << (i + 2)));
+        memset(blocks[i], i, 1 << (i + 2));
+    }
+    TEST_ASSERT_NULL(mbed_tlsf_malloc(&tlsf, POOL_SIZE));
+
+    // Every other block, then the rest: all merged back in one block
+    for (int i = 0; i < 8; i += 2) {
+        mbed_tlsf_free(&tlsf, blocks[i]);
+    }
+    mbed_tlsf_get_info(&tlsf, &info);
+    TEST_ASSERT_TRUE(info.free_blocks > 1);
+    for (int i = 1; i < 8; i += 2) {
+        TEST_ASSERT_TRUE(filled(blocks[i], i, 1 << (i + 2)));
+        mbed_tlsf_free(&tlsf, blocks[i]);
+    }
+    mbed_tlsf_get_info(&tlsf, &info);
+    TEST_ASSERT_EQUAL(1, info.free_blocks);
+    TEST_ASSERT_EQUAL(free_size, info.free_size);
+}
+
+void test_realloc() {
+    mbed_tlsf_info_t info;
+
+    uint8_t *data = (uint8_t *)mbed_tlsf_realloc(&tlsf, NULL, 100);
+    TEST_ASSERT_NOT_NULL(data);
+    memset(data, 0xA5, 100);
+    // The memory after the block is free, so it grows in place
+    TEST_ASSERT_EQUAL_PTR(data, mbed_tlsf_realloc(&tlsf, data, 1000));
+    TEST_ASSERT_TRUE(filled(data, 0xA5, 100));
+
+    // Blocked by a neighbour, so it moves
+    uint8_t *next = (uint8_t *)mbed_tlsf_malloc(&tlsf, 16);
+    uint8_t *moved = (uint8_t *)mbed_tlsf_realloc(&tlsf, data, 2000);
+    TEST_ASSERT_NOT_NULL(moved);
+    TEST_ASSERT_TRUE(moved != data);
+    TEST_ASSERT_TRUE(filled(moved, 0xA5, 100));
+
+    // Too large leaves the block alone
+    TEST_ASSERT_NULL(mbed_tlsf_realloc(&tlsf, moved, POOL_SIZE));
+    TEST_ASSERT_TRUE(filled(moved, 0xA5, 100));
+
+    TEST_ASSERT_NULL(mbed_tlsf_realloc(&tlsf, moved, 0));
+    mbed_tlsf_free(&tlsf, next);
+    mbed_tlsf_get_info(&tlsf, &info);
+    TEST_ASSERT_EQUAL(1, info.free_blocks);
+}
+
+void test_regions() {
+    mbed_tlsf_info_t info;
+
+    TEST_ASSERT_FALSE(mbed_tlsf_add_region(&tlsf, region, 8));
+    // Unaligned start and end are trimmed
+    TEST_ASSERT_TRUE(mbed_tlsf_add_region(&tlsf, region + 1, REGION_SIZE - 2));
+    mbed_tlsf_get_info(&tlsf, &info);
+    TEST_ASSERT_EQUAL(2, info.free_blocks);
+
+    // Filling one region spills over to the other
+    void *large = mbed_tlsf_malloc(&tlsf, POOL_SIZE - REGION_SIZE / 2);
+    TEST_ASSERT_NOT_NULL(large);
+    void *small = mbed_tlsf_malloc(&tlsf, REGION_SIZE / 2);
+    TEST_ASSERT_NOT_NULL(small);
+    TEST_ASSERT_TRUE((uint8_t *)small > region && (uint8_t *)small < region + REGION_SIZE);
+    mbed_tlsf_free(&tlsf, large);
+    mbed_tlsf_free(&tlsf, small);
+}
+
+/* The same pseudo-random allocation trace replayed on a heap: short-lived
+ * small blocks mixed with buffers that live longer, as a network stack
+ * would make */
+typedef struct {
+    const char *name;
+    void *(*alloc)(size_t size);
+    void (*release)(void *ptr);
+    uint32_t failed;
+    uint32_t malloc_max_us;
+    uint32_t free_max_us;
+    uint32_t total_us;
+} heap_ops_t;
+
+static void *tlsf_malloc(size_t size) {
+    return mbed_tlsf_malloc(&tlsf, size);
+}
+
+static void tlsf_free(void *ptr) {
+    mbed_tlsf_free(&tlsf, ptr);
+}
+
+static void replay(heap_ops_t *heap) {
+    void *slots[TRACE_SLOTS] = {0};
+    uint32_t seed = 12345;
+
+    heap->failed = 0;
+    heap->malloc_max_us = 0;
+    heap->free_max_us = 0;
+    heap->total_us = 0;
+    for (int i = 0; i < TRACE_OPS; i++) {
+        seed = seed * 1103515245 + 12345;
+        uint32_t random = seed >> 8;
+        uint32_t slot = random % TRACE_SLOTS;
+        // A quarter of the slots hold buffers, freed less often
+        bool buffer = slot < TRACE_SLOTS / 4;
+        uint32_t start;
+
+        if (slots[slot] != NULL) {
+            if (buffer && (random & 0x700)) {
+                continue;
+            }
+            start = us_ticker_read();
+            heap->release(slots[slot]);
+            uint32_t time = us_ticker_read() - start;
+            heap->free_max_us = time > heap->free_max_us ? time : heap->free_max_us;
+            heap->total_us += time;
+            slots[slot] = NULL;
+        } else {
+            size_t size = buffer ? 64 + (random >> 12) % 256 : 8 + (random >> 12) % 56;
+            start = us_ticker_read();
+            slots[slot] = heap->alloc(size);
+            uint32_t time = us_ticker_read() - start;
+            heap->malloc_max_us = time > heap->malloc_max_us ? time : heap->malloc_max_us;
+            heap->total_us += time;
+            if (slots[slot] == NULL) {
+                heap->failed++;
+            } else {
+                memset(slots[slot], slot, size);
+            }
+        }
+    }
+    for (int i = 0; i < TRACE_SLOTS; i++) {
+        heap->release(slots[i]);
+    }
+}
+
+void test_benchmark() {
+    heap_ops_t heaps[] = {
+        {"C library", malloc, free},
+        {"TLSF", tlsf_malloc, tlsf_free},
+    };
+    mbed_tlsf_info_t before, after;
+
+    mbed_tlsf_init(&tlsf);
+    TEST_ASSERT_TRUE(mbed_tlsf_add_region(&tlsf, pool, POOL_SIZE));
+    mbed_tlsf_get_info(&tlsf, &before);
+
+    printf("%d operations on %d slots:\r\n", TRACE_OPS, TRACE_SLOTS);
+    for (size_t i = 0; i < sizeof(heaps) / sizeof(heaps[0]); i++) {
+        replay(&heaps[i]);
+        printf("  %-10s worst malloc %lu us, worst free %lu us, total %lu us, %lu failed\r\n", heaps[i].name,
+               (unsigned long)heaps[i].malloc_max_us, (unsigned long)heaps[i].free_max_us,
+               (unsigned long)heaps[i].total_us, (unsigned long)heaps[i].failed);
+    }
+
+    // Everything merged back once the trace is done
+    mbed_tlsf_get_info(&tlsf, &after);
+    TEST_ASSERT_EQUAL(1, after.free_blocks);
+    TEST_ASSERT_EQUAL(before.free_size, after.free_size);
+    TEST_ASSERT_EQUAL(0, heaps[1].failed);
+}
+
+/* Fragmentation after the long-lived buffers of the trace are left in place */
+void test_fragmentation() {
+    void *slots[TRACE_SLOTS] = {0};
+    mbed_tlsf_info_t info;
+    uint32_t seed = 54321;
+
+    for (int i = 0; i < TRACE_OPS; i++) {
+        seed = seed * 1103515245 + 12345;
+        uint32_t random = seed >> 8;
+        uint32_t slot = random % TRACE_SLOTS;
+        mbed_tlsf_free(&tlsf, slots[slot]);
+        slots[slot] = mbed_tlsf_malloc(&tlsf, 8 + (random >> 12) % 120);
+    }
+    // Free every other slot, the worst case for merging
+    for (int i = 0; i < TRACE_SLOTS; i += 2) {
+        mbed_tlsf_free(&tlsf, slots[i]);
+        slots[i] = NULL;
+    }
+    mbed_tlsf_get_info(&tlsf, &info);
+    printf("Free %lu bytes in %lu blocks, largest %lu (%lu%% fragmented)\r\n",
+           (unsigned long)info.free_size, (unsigned long)info.free_blocks, (unsigned long)info.largest_free,
+           (unsigned long)(100 - info.largest_free * 100 / info.free_size));
+    TEST_ASSERT_TRUE(info.largest_free < info.free_size);
+
+    for (int i = 0; i < TRACE_SLOTS; i++) {
+        mbed_tlsf_free(&tlsf, slots[i]);
+    }
+    mbed_tlsf_get_info(&tlsf, &info);
+    TEST_ASSERT_EQUAL(1, info.free_blocks);
+}
+
+#if MBED_CONF_PLATFORM_HEAP_TLSF
+void test_platform_heap() {
+    mbed_tlsf_info_t before, after;
+
+    mbed_tlsf_heap_get_info(&before);
+    TEST_ASSERT_TRUE(before.free_size > 0);
+    void *data = malloc(100);
+    TEST_ASSERT_NOT_NULL(data);
+    mbed_tlsf_heap_get_info(&after);
+    TEST_ASSERT_TRUE(after.free_size < before.free_size);
+    free(data);
+
+    data = calloc(10, 10);
+    TEST_ASSERT_NOT_NULL(data);
+    TEST_ASSERT_TRUE(filled(data, 0, 100));
+    free(data);
+    // A count and size whose product wraps around to a small size
+    volatile size_t count = (size_t)-1 / 16 + 2;
+    TEST_ASSERT_NULL(calloc(count, 16));
+
+    TEST_ASSERT_TRUE(mbed_tlsf_heap_add_region(region, REGION_SIZE));
+    mbed_tlsf_heap_get_info(&after);
+    TEST_ASSERT_TRUE(after.free_size > before.free_size);
+}
+#endif
+
+Case cases[] = {
+    Case("Allocate and free", test_malloc_free),
+    Case("Reallocate", test_realloc),
+    Case("Several regions", test_regions),
+    Case("Benchmark against the C library", test_benchmark),
+    Case("Fragmentation", test_fragmentation),
+#if MBED_CONF_PLATFORM_HEAP_TLSF
+    Case("Platform heap", test_platform_heap),
+#endif
+};
+
+utest::v1::status_t greentea_test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(30, "default_auto");
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+Specification specification(greentea_test_setup, cases, greentea_test_teardown_handler);
+
+int main() {
+    Harness::run(specification);
+}
@@ -0,0 +1,234 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "mbed.h"
+#include "greentea-client/test_env.h"
+#include "unity.h"
+#include "utest.h"
+#include "rtos.h"
+
+#if defined(MBED_RTOS_SINGLE_THREAD)
+  #error [NOT_SUPPORTED] test not supported
+#endif
+
+#if defined(TARGET_MCU_NRF51822) || defined(TARGET_MCU_NRF52832)
+    #define STACK_SIZE 512
+#elif defined(TARGET_STM32F070RB) || defined(TARGET_STM32F072RB) || defined(TARGET_STM32F103RB) || defined(TARGET_STM32F091RC)
+    #define STACK_SIZE 512
+#else
+    #define STACK_SIZE DEFAULT_STACK_SIZE
+#endif
+
+using namespace utest::v1;
+
+#define CHANNEL_SIZE        16
+#define CONSUMERS           3
+#define ISR_SAMPLES         4000
+#define BENCH_SAMPLES       4096
+#define BENCH_BATCH         16
+
+typedef struct {
+    uint16_t channel;
+    int16_t value;
+    uint32_t sequence;
+} sample_t;
+
+void test_put_get() {
+    Channel<sample_t, 4> channel;
+    sample_t sample = {1, -2, 0};
+
+    TEST_ASSERT_TRUE(channel.empty());
+    TEST_ASSERT_EQUAL(osErrorResource, channel.get(sample, 0));
+    for (uint32_t i = 0; i < 4; i++) {
+        sample.sequence = i;
+        TEST_ASSERT_EQUAL(osOK, channel.put(sample));
+    }
+    TEST_ASSERT_TRUE(channel.full());
+    TEST_ASSERT_EQUAL(osErrorResource, channel.put(sample));
+
+    for (uint32_t i = 0; i < 4; i++) {
+        TEST_ASSERT_EQUAL(osOK, channel.get(sample));
+        TEST_ASSERT_EQUAL(i, sample.sequence);
+        TEST_ASSERT_EQUAL(-2, sample.value);
+    }
+}
+
+void test_batches() {
+    Channel<int, 8> channel;
+    int in[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    int out[10];
+
+    TEST_ASSERT_EQUAL(8, channel.put_n(in, 10));
+    TEST_ASSERT_EQUAL(5, channel.get_n(out, 5));
+    TEST_ASSERT_EQUAL_INT_ARRAY(in, out, 5);
+    // Wraps around the end of the ring
+    TEST_ASSERT_EQUAL(2, channel.put_n(in + 8, 2));
+    TEST_ASSERT_EQUAL(5, channel.get_n(out, 10));
+    TEST_ASSERT_EQUAL_INT_ARRAY(in + 5, out, 5);
+    TEST_ASSERT_TRUE(channel.empty());
+}
+
+void test_timeouts() {
+    Channel<int, 2> channel;
+    int data[3] = {1, 2, 3};
+    Timer timer;
+
+    timer.start();
+    TEST_ASSERT_EQUAL(0, channel.get_n(data, 3, 20));
+    TEST_ASSERT_INT_WITHIN(5000, 20000, timer.read_us());
+    TEST_ASSERT_EQUAL(osEventTimeout, channel.get(data[0], 10));
+
+    timer.reset();
+    TEST_ASSERT_EQUAL(2, channel.put_n(data, 3, 20));
+    TEST_ASSERT_INT_WITHIN(5000, 20000, timer.read_us());
+    TEST_ASSERT_EQUAL(osErrorTimeoutResource, channel.put(data[2], 10));
+}
+
+/* Samples put from a ticker interrupt in batches, got by a thread */
+static Channel<sample_t, CHANNEL_SIZE> isr_channel;
+static uint32_t isr_sequence;
+static uint32_t isr_dropped;
+
+static void isr_producer() {
+    sample_t samples[3];
+    uint32_t count = 0;
+    while (count < 3 && isr_sequence + count < ISR_SAMPLES) {
+        samples[count].channel = count;
+        samples[count].value = (int16_t)(isr_sequence + count);
+        samples[count].sequence = isr_sequence + count;
+        count++;
+    }
+    uint32_t sent = isr_channel.put_n(samples, count);
+    isr_dropped += count - sent;
+    isr_sequence += sent;
+}
+
+void test_interrupt_producer() {
+    Ticker ticker;
+    sample_t samples[CHANNEL_SIZE];
+    uint32_t received = 0;
+
+    isr_sequence = 0;
+    isr_dropped = 0;
+    ticker.attach_us(isr_producer, 200);
+    while (received < ISR_SAMPLES) {
+        uint32_t count = isr_channel.get_n(samples, CHANNEL_SIZE, 1000);
+        TEST_ASSERT_NOT_EQUAL(0, count);
+        for (uint32_t i = 0; i < count; i++) {
+            TEST_ASSERT_EQUAL(received, samples[i].sequence);
+            received++;
+        }
+    }
+    ticker.detach();
+
+    TEST_ASSERT_EQUAL(0, isr_dropped);
+    TEST_ASSERT_TRUE(isr_channel.empty());
+}
+
+/* Every waiting consumer is woken when enough elements arrive */
+static Channel<int, CHANNEL_SIZE> shared_channel;
+static Semaphore consumed(0);
+static uint32_t consumed_sum;
+
+static void consumer() {
+    int data;
+    if (shared_channel.get(data, 2000) == osOK) {
+        core_util_atomic_incr_u32(&consumed_sum, data);
+    }
+    consumed.release();
+}
+
+void test_multiple_consumers() {
+    Thread *threads[CONSUMERS];
+
+    consumed_sum = 0;
+    for (int i = 0; i < CONSUMERS; i++) {
+        threads[i] = new Thread(osPriorityNormal, STACK_SIZE);
+        threads[i]->start(consumer);
+    }
+    // Let them all block
+    Thread::wait(10);
+
+    int data[CONSUMERS];
+    for (int i = 0; i < CONSUMERS; i++) {
+        data[i] = 1 << i;
+    }
+    TEST_ASSERT_EQUAL(CONSUMERS, shared_channel.put_n(data, CONSUMERS));
+    for (int i = 0; i < CONSUMERS; i++) {
+        TEST_ASSERT_TRUE(consumed.wait(100) > 0);
+    }
+    for (int i = 0; i < CONSUMERS; i++) {
+        threads[i]->join();
+        delete threads[i];
+    }
+    TEST_ASSERT_EQUAL((1 << CONSUMERS) - 1, consumed_sum);
+}
+
+void test_benchmark() {
+    static Mail<sample_t, CHANNEL_SIZE> mail;
+    static Channel<sample_t, CHANNEL_SIZE> channel;
+    sample_t samples[BENCH_BATCH] = {0};
+    Timer timer;
+
+    timer.start();
+    for (uint32_t i = 0; i < BENCH_SAMPLES; i++) {
+        sample_t *sample = mail.alloc();
+        *sample = samples[0];
+        mail.put(sample);
+        osEvent event = mail.get();
+        samples[0] = *(sample_t *)event.value.p;
+        mail.free((sample_t *)event.value.p);
+    }
+    int mail_us = timer.read_us();
+
+    timer.reset();
+    for (uint32_t i = 0; i < BENCH_SAMPLES; i++) {
+        channel.put(samples[0]);
+        channel.get(samples[0]);
+    }
+    int single_us = timer.read_us();
+
+    timer.reset();
+    for (uint32_t i = 0; i < BENCH_SAMPLES; i += BENCH_BATCH) {
+        channel.put_n(samples, BENCH_BATCH);
+        channel.get_n(samples, BENCH_BATCH);
+    }
+    int batch_us = timer.read_us();
+
+    printf("%d samples of %d bytes through a queue of %d:\r\n", BENCH_SAMPLES, (int)sizeof(sample_t), CHANNEL_SIZE);
+    printf("  Mail:                       %d us\r\n", mail_us);
+    printf("  Channel put/get:            %d us\r\n", single_us);
+    printf("  Channel %d sample batches:  %d us\r\n", BENCH_BATCH, batch_us);
+}
+
+Case cases[] = {
+    Case("Put and get single elements", test_put_get),
+    Case("Batches with wrap", test_batches),
+    Case("Time-outs", test_timeouts),
+    Case("Interrupt producer", test_interrupt_producer),
+    Case("Multiple waiting consumers", test_multiple_consumers),
+    Case("Benchmark against Mail", test_benchmark),
+};
+
+utest::v1::status_t greentea_test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(30, "default_auto");
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+Specification specification(greentea_test_setup, cases, greentea_test_teardown_handler);
+
+int main() {
+    Harness::run(specification);
+}
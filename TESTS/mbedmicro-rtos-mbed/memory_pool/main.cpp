@@ -0,0 +1,308 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "mbed.h"
+#include "greentea-client/test_env.h"
+#include "unity.h"
+#include "utest.h"
+#include "rtos.h"
+
+#if defined(MBED_RTOS_SINGLE_THREAD)
+  #error [NOT_SUPPORTED] test not supported
+#endif
+
+#if defined(TARGET_MCU_NRF51822) || defined(TARGET_MCU_NRF52832)
+    #define STACK_SIZE 512
+#elif defined(TARGET_STM32F070RB) || defined(TARGET_STM32F072RB) || defined(TARGET_STM32F103RB) || defined(TARGET_STM32F091RC)
+    #define STACK_SIZE 512
+#else
+    #define STACK_SIZE DEFAULT_STACK_SIZE
+#endif
+
+using namespace utest::v1;
+
+#define POOL_SIZE           16
+#define STRESS_THREADS      3
+#define STRESS_ROUNDS       2000
+#define STRESS_HOLD         3
+#define BENCH_ROUNDS        10000
+
+typedef struct {
+    uint32_t owner;
+    uint32_t sequence;
+    uint8_t payload[13];
+} block_t;
+
+static bool all_blocks_free(MemoryPool<block_t, POOL_SIZE> &pool) {
+    block_t *blocks[POOL_SIZE];
+    bool ok = true;
+
+    for (int i = 0; i < POOL_SIZE; i++) {
+        blocks[i] = pool.alloc();
+        ok = ok && blocks[i] != NULL;
+        for (int j = 0; j < i && ok; j++) {
+            ok = blocks[i] != blocks[j];
+        }
+    }
+    ok = ok && pool.alloc() == NULL;
+    for (int i = 0; i < POOL_SIZE; i++) {
+        pool.free(blocks[i]);
+    }
+    return ok;
+}
+
+void test_alloc_all() {
+    static MemoryPool<block_t, POOL_SIZE> pool;
+    block_t *blocks[POOL_SIZE];
+
+    for (int i = 0; i < POOL_SIZE; i++) {
+        blocks[i] = pool.alloc();
+        TEST_ASSERT_NOT_NULL(blocks[i]);
+        TEST_ASSERT_EQUAL(0, (uintptr_t)blocks[i] % 4);
+        memset(blocks[i], i, sizeof(block_t));
+    }
+    TEST_ASSERT_NULL(pool.alloc());
+
+    for (int i = 0; i < POOL_SIZE; i++) {
+        for (uint32_t j = 0; j < sizeof(block_t); j++) {
+            TEST_ASSERT_EQUAL_UINT8(i, ((uint8_t *)blocks[i])[j]);
+        }
+        TEST_ASSERT_EQUAL(osOK, pool.free(blocks[i]));
+    }
+    TEST_ASSERT_TRUE(all_blocks_free(pool));
+}
+
+void test_calloc_and_bad_free() {
+    static MemoryPool<block_t, POOL_SIZE> pool;
+    block_t outside;
+
+    block_t *block = pool.alloc();
+    memset(block, 0xA5, sizeof(block_t));
+    pool.free(block);
+    block = pool.calloc();
+    for (uint32_t i = 0; i < sizeof(block_t); i++) {
+        TEST_ASSERT_EQUAL_UINT8(0, ((uint8_t *)block)[i]);
+    }
+
+    TEST_ASSERT_EQUAL(osErrorValue, pool.free(&outside));
+    TEST_ASSERT_EQUAL(osErrorValue, pool.free(NULL));
+    TEST_ASSERT_EQUAL(osErrorValue, pool.free((block_t *)((uint8_t *)block + 4)));
+    TEST_ASSERT_EQUAL(osOK, pool.free(block));
+}
+
+void test_section_pool() {
+    // Any storage will do, targets would place it with MBED_SECTION
+    static SectionMemoryPool<block_t, 4>::storage_t storage;
+    static SectionMemoryPool<block_t, 4> pool(storage);
+    block_t *blocks[4];
+
+    for (int i = 0; i < 4; i++) {
+        blocks[i] = pool.alloc();
+        TEST_ASSERT_TRUE((uint8_t *)blocks[i] >= (uint8_t *)storage);
+        TEST_ASSERT_TRUE((uint8_t *)(blocks[i] + 1) <= (uint8_t *)storage + sizeof(storage));
+    }
+    TEST_ASSERT_NULL(pool.alloc());
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_EQUAL(osOK, pool.free(blocks[i]));
+    }
+}
+
+/* Threads and an interrupt allocate, fill, check and free blocks of one pool */
+static MemoryPool<block_t, POOL_SIZE> shared_pool;
+static volatile bool corrupted;
+static volatile uint32_t isr_rounds;
+
+static bool use_blocks(uint32_t owner, uint32_t sequence, int count) {
+    block_t *held[STRESS_HOLD];
+    int taken = 0;
+
+    for (int i = 0; i < count; i++) {
+        held[taken] = shared_pool.alloc();
+        if (held[taken] != NULL) {
+            held[taken]->owner = owner;
+            held[taken]->sequence = sequence + taken;
+            taken++;
+        }
+    }
+    bool ok = true;
+    for (int i = 0; i < taken; i++) {
+        ok = ok && held[i]->owner == owner && held[i]->sequence == sequence + i;
+        shared_pool.free(held[i]);
+    }
+    return ok;
+}
+
+static void isr_user() {
+    if (!use_blocks(0xFFFF, isr_rounds, 1)) {
+        corrupted = true;
+    }
+    isr_rounds++;
+}
+
+static void stress_thread(uint32_t *owner) {
+    for (uint32_t round = 0; round < STRESS_ROUNDS; round++) {
+        if (!use_blocks(*owner, round, STRESS_HOLD)) {
+            corrupted = true;
+        }
+    }
+}
+
+void test_multi_producer_stress() {
+    Thread *threads[STRESS_THREADS];
+    uint32_t owners[STRESS_THREADS];
+    Ticker ticker;
+
+    corrupted = false;
+    isr_rounds = 0;
+    ticker.attach_us(isr_user, 50);
+    for (int i = 0; i < STRESS_THREADS; i++) {
+        owners[i] = i;
+        threads[i] = new Thread(osPriorityNormal, STACK_SIZE);
+        threads[i]->start(callback(stress_thread, &owners[i]));
+    }
+    for (int i = 0; i < STRESS_THREADS; i++) {
+        threads[i]->join();
+        delete threads[i];
+    }
+    ticker.detach();
+
+    TEST_ASSERT_FALSE(corrupted);
+    TEST_ASSERT_TRUE(isr_rounds > 0);
+    TEST_ASSERT_TRUE(all_blocks_free(shared_pool));
+}
+
+/* Threads and an interrupt hammer a bare LockFreePool, marking each block
+ * they hold so that a block handed out twice is caught */
+static MBED_ALIGN(4) uint32_t raw_storage[LockFreePoolStorage<block_t, POOL_SIZE>::words];
+static LockFreePool raw_pool(raw_storage, sizeof(block_t), POOL_SIZE);
+static uint8_t raw_in_use[POOL_SIZE];
+static volatile bool duplicated;
+static volatile bool raw_rounds_done;
+
+static uint32_t raw_index(void *block) {
+    return ((uint32_t *)block - raw_storage) / (raw_pool.block_size() / 4);
+}
+
+static void raw_use_blocks(int count) {
+    void *held[STRESS_HOLD];
+    int taken = 0;
+
+    for (int i = 0; i < count; i++) {
+        held[taken] = raw_pool.alloc();
+        if (held[taken] != NULL) {
+            if (core_util_atomic_incr_u8(&raw_in_use[raw_index(held[taken])], 1) != 1) {
+                duplicated = true;
+            }
+            taken++;
+        }
+    }
+    for (int i = 0; i < taken; i++) {
+        core_util_atomic_decr_u8(&raw_in_use[raw_index(held[i])], 1);
+        if (!raw_pool.free(held[i])) {
+            duplicated = true;
+        }
+    }
+}
+
+static void raw_isr_user() {
+    raw_use_blocks(1);
+    raw_rounds_done = true;
+}
+
+static void raw_stress_thread() {
+    for (uint32_t round = 0; round < STRESS_ROUNDS; round++) {
+        raw_use_blocks(STRESS_HOLD);
+    }
+}
+
+void test_lock_free_pool_stress() {
+    Thread *threads[STRESS_THREADS];
+    Ticker ticker;
+
+    duplicated = false;
+    raw_rounds_done = false;
+    ticker.attach_us(raw_isr_user, 50);
+    for (int i = 0; i < STRESS_THREADS; i++) {
+        threads[i] = new Thread(osPriorityNormal, STACK_SIZE);
+        threads[i]->start(raw_stress_thread);
+    }
+    for (int i = 0; i < STRESS_THREADS; i++) {
+        threads[i]->join();
+        delete threads[i];
+    }
+    ticker.detach();
+
+    TEST_ASSERT_FALSE(duplicated);
+    TEST_ASSERT_TRUE(raw_rounds_done);
+
+    // Every block is free again, and each one is handed out exactly once
+    void *blocks[POOL_SIZE];
+    for (int i = 0; i < POOL_SIZE; i++) {
+        blocks[i] = raw_pool.alloc();
+        TEST_ASSERT_NOT_NULL(blocks[i]);
+        TEST_ASSERT_EQUAL_UINT8(0, raw_in_use[raw_index(blocks[i])]);
+        raw_in_use[raw_index(blocks[i])] = 1;
+    }
+    TEST_ASSERT_NULL(raw_pool.alloc());
+    for (int i = 0; i < POOL_SIZE; i++) {
+        raw_in_use[raw_index(blocks[i])] = 0;
+        TEST_ASSERT_TRUE(raw_pool.free(blocks[i]));
+    }
+}
+
+osPoolDef(kernel_pool, POOL_SIZE, block_t);
+
+void test_cycles() {
+    static MemoryPool<block_t, POOL_SIZE> pool;
+    osPoolId kernel_pool_id = osPoolCreate(osPool(kernel_pool));
+    Timer timer;
+
+    timer.start();
+    for (int i = 0; i < BENCH_ROUNDS; i++) {
+        osPoolFree(kernel_pool_id, osPoolAlloc(kernel_pool_id));
+    }
+    int kernel_us = timer.read_us();
+
+    timer.reset();
+    for (int i = 0; i < BENCH_ROUNDS; i++) {
+        pool.free(pool.alloc());
+    }
+    int lock_free_us = timer.read_us();
+
+    uint32_t cycles_per_us = SystemCoreClock / 1000000;
+    printf("Cycles per alloc and free:\r\n");
+    printf("  osPoolAlloc/osPoolFree:     %d\r\n", (int)(kernel_us * cycles_per_us / BENCH_ROUNDS));
+    printf("  MemoryPool:                 %d\r\n", (int)(lock_free_us * cycles_per_us / BENCH_ROUNDS));
+}
+
+Case cases[] = {
+    Case("Allocate every block", test_alloc_all),
+    Case("calloc and freeing foreign blocks", test_calloc_and_bad_free),
+    Case("Pool in separately defined storage", test_section_pool),
+    Case("Threads and interrupt sharing a pool", test_multi_producer_stress),
+    Case("Threads and interrupt sharing a LockFreePool", test_lock_free_pool_stress),
+    Case("Cycles against the kernel pool", test_cycles),
+};
+
+utest::v1::status_t greentea_test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(30, "default_auto");
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+Specification specification(greentea_test_setup, cases, greentea_test_teardown_handler);
+
+int main() {
+    Harness::run(specification);
+}
@@ -0,0 +1,216 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "mbed.h"
+#include "greentea-client/test_env.h"
+#include "unity.h"
+#include "utest.h"
+#include "rtos.h"
+#include "mbed_stats.h"
+
+#if defined(MBED_RTOS_SINGLE_THREAD)
+  #error [NOT_SUPPORTED] test not supported
+#endif
+
+#if !defined(MBED_THREAD_STATS_ENABLED) || !MBED_THREAD_STATS_ENABLED
+  #error [NOT_SUPPORTED] test not supported
+#endif
+
+#if defined(TARGET_MCU_NRF51822) || defined(TARGET_MCU_NRF52832)
+    #define STACK_SIZE 512
+#elif defined(TARGET_STM32F070RB) || defined(TARGET_STM32F072RB) || defined(TARGET_STM32F103RB) || defined(TARGET_STM32F091RC)
+    #define STACK_SIZE 512
+#else
+    #define STACK_SIZE DEFAULT_STACK_SIZE
+#endif
+
+using namespace utest::v1;
+
+#define BUSY_MS             100
+#define PING_PONGS          10
+#define MAX_THREADS         16
+
+/* Threads report being done, then stay alive for their stats to be read */
+static Semaphore done_sem(0);
+static Semaphore finish_sem(0);
+
+static void busy() {
+    Timer timer;
+    timer.start();
+    while (timer.read_ms() < BUSY_MS);
+}
+
+static void busy_worker() {
+    busy();
+    done_sem.release();
+    finish_sem.wait();
+}
+
+static void sleepy_worker() {
+    Thread::wait(BUSY_MS);
+    done_sem.release();
+    finish_sem.wait();
+}
+
+void test_run_time() {
+    Thread busy_thread(osPriorityNormal, STACK_SIZE);
+    Thread sleepy_thread(osPriorityNormal, STACK_SIZE);
+
+    busy_thread.start(busy_worker);
+    sleepy_thread.start(sleepy_worker);
+    done_sem.wait();
+    done_sem.wait();
+    mbed_stats_thread_t busy_stats = busy_thread.get_stats();
+    mbed_stats_thread_t sleepy_stats = sleepy_thread.get_stats();
+    finish_sem.release();
+    finish_sem.release();
+    busy_thread.join();
+    sleepy_thread.join();
+
+    uint64_t busy_ticks = osKernelSysTickMicroSec(BUSY_MS * 1000);
+
+    TEST_ASSERT_TRUE(busy_stats.run_time >= busy_ticks);
+    TEST_ASSERT_TRUE(busy_stats.run_time < busy_ticks + busy_ticks / 10);
+    TEST_ASSERT_TRUE(busy_stats.switches >= 1);
+    TEST_ASSERT_TRUE(sleepy_stats.run_time < busy_ticks / 10);
+    TEST_ASSERT_TRUE(sleepy_stats.switches >= 2);
+    TEST_ASSERT_NOT_EQUAL(busy_stats.task_id, sleepy_stats.task_id);
+}
+
+/* A high priority thread woken from an interrupt is switched in at once */
+static Semaphore isr_sem(0);
+static volatile bool isr_done;
+
+static void isr_waiter() {
+    while (!isr_done) {
+        isr_sem.wait();
+    }
+}
+
+static void isr_release() {
+    isr_sem.release();
+}
+
+void test_preemption() {
+    Thread waiter(osPriorityRealtime, STACK_SIZE);
+    Ticker ticker;
+
+    isr_done = false;
+    waiter.start(isr_waiter);
+    ticker.attach_us(isr_release, 1000);
+    busy();
+    ticker.detach();
+    mbed_stats_thread_t stats = waiter.get_stats();
+    isr_done = true;
+    isr_sem.release();
+    waiter.join();
+
+    TEST_ASSERT_TRUE(stats.switches > BUSY_MS / 2);
+    TEST_ASSERT_TRUE(stats.ready_time_max < osKernelSysTickMicroSec(500));
+}
+
+void test_all_threads() {
+    mbed_stats_thread_t before[MAX_THREADS];
+    mbed_stats_thread_t after[MAX_THREADS];
+    Timer timer;
+
+    timer.start();
+    size_t count = mbed_stats_thread_get_each(before, MAX_THREADS);
+    Thread::wait(BUSY_MS);
+    TEST_ASSERT_EQUAL(count, mbed_stats_thread_get_each(after, MAX_THREADS));
+    int elapsed_us = timer.read_us();
+
+    // The idle thread comes last and is the one running while main waits
+    uint64_t total = 0;
+    for (size_t i = 0; i < count; i++) {
+        TEST_ASSERT_EQUAL(before[i].id, after[i].id);
+        total += after[i].run_time - before[i].run_time;
+    }
+    uint64_t idle = after[count - 1].run_time - before[count - 1].run_time;
+    uint64_t elapsed = osKernelSysTickMicroSec(elapsed_us);
+
+    printf("%d threads, idle for %d%% of %d us\r\n", (int)count, (int)(idle * 100 / total), elapsed_us);
+    TEST_ASSERT_TRUE(total <= elapsed);
+    TEST_ASSERT_TRUE(total > elapsed - elapsed / 10);
+    TEST_ASSERT_TRUE(idle > total / 2);
+}
+
+#if defined(MBED_THREAD_TRACE_SIZE)
+/* Two threads taking turns show up in the trace in turn */
+static Semaphore ping_sem(0);
+static Semaphore pong_sem(0);
+
+static void ponger() {
+    for (int i = 0; i < PING_PONGS; i++) {
+        ping_sem.wait();
+        pong_sem.release();
+    }
+    finish_sem.wait();
+}
+
+void test_trace() {
+    mbed_stats_thread_switch_t records[MBED_THREAD_TRACE_SIZE];
+    Thread pong_thread(osPriorityNormal, STACK_SIZE);
+    uint32_t lost;
+
+    pong_thread.start(ponger);
+    Thread::wait(10);
+    mbed_stats_thread_trace_read(records, MBED_THREAD_TRACE_SIZE, &lost);
+    for (int i = 0; i < PING_PONGS; i++) {
+        ping_sem.release();
+        pong_sem.wait();
+    }
+    size_t count = mbed_stats_thread_trace_read(records, MBED_THREAD_TRACE_SIZE, &lost);
+    uint8_t pong_id = pong_thread.get_stats().task_id;
+    finish_sem.release();
+    pong_thread.join();
+
+    int turns = 0;
+    for (size_t i = 0; i < count; i++) {
+        // Dump for offline viewing: time, from, to, preempted, priority
+        printf("%08lx %02x %02x %d %d\r\n", (unsigned long)records[i].time, records[i].from,
+               records[i].to, records[i].preempted, records[i].prio);
+        if (i > 0) {
+            TEST_ASSERT_TRUE((int32_t)(records[i].time - records[i - 1].time) >= 0);
+            TEST_ASSERT_EQUAL(records[i - 1].to, records[i].from);
+        }
+        if (records[i].from == pong_id && records[i].to != pong_id) {
+            turns++;
+        }
+    }
+    TEST_ASSERT_EQUAL(0, lost);
+    TEST_ASSERT_TRUE(turns >= PING_PONGS);
+}
+#endif
+
+Case cases[] = {
+    Case("Run time of busy and waiting threads", test_run_time),
+    Case("Preemption from an interrupt", test_preemption),
+    Case("Snapshot of all threads", test_all_threads),
+#if defined(MBED_THREAD_TRACE_SIZE)
+    Case("Context switch trace", test_trace),
+#endif
+};
+
+utest::v1::status_t greentea_test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(30, "default_auto");
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+Specification specification(greentea_test_setup, cases, greentea_test_teardown_handler);
+
+int main() {
+    Harness::run(specification);
+}
@@ -0,0 +1,192 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2016 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mbed.h"
+#include "mbed_events.h"
+#include "greentea-client/test_env.h"
+#include "unity.h"
+#include "utest.h"
+#include "rtos.h"
+
+#include "mbed_accel.h"
+
+#if !defined(MBEDTLS_SHA256_C)
+#error [NOT_SUPPORTED] SHA256 not enabled
+#endif
+
+#include "mbedtls/sha256.h"
+
+#include <string.h>
+
+using namespace utest::v1;
+
+#define MOCK_LATENCY_MS 20
+
+static const unsigned char sha256_abc[32] = {
+    0xBA, 0x78, 0x16, 0xBF, 0x8F, 0x01, 0xCF, 0xEA,
+    0x41, 0x41, 0x40, 0xDE, 0x5D, 0xAE, 0x22, 0x23,
+    0xB0, 0x03, 0x61, 0xA3, 0x96, 0x17, 0x7A, 0x9C,
+    0xB4, 0x10, 0xFF, 0x61, 0xF2, 0x00, 0x15, 0xAD
+};
+
+// Mock accelerator: completes requests in software on its own thread
+// after a fixed latency, like a DMA engine raising a completion interrupt
+static EventQueue mock_queue(8 * EVENTS_EVENT_SIZE);
+static Thread mock_thread;
+
+static void mock_run(mbedtls_accel_request_t *req) {
+    mbedtls_accel_complete(req, mbedtls_accel_run_software(req));
+}
+
+static int mock_submit(mbedtls_accel_driver_t *drv, mbedtls_accel_request_t *req) {
+    return mock_queue.call_in(MOCK_LATENCY_MS, mock_run, req) ? 0 : MBEDTLS_ERR_ACCEL_BUSY;
+}
+
+static mbedtls_accel_driver_t mock_driver = {
+    "mock",
+    MBEDTLS_ACCEL_OP_MASK(MBEDTLS_ACCEL_OP_SHA256),
+    1,
+    mock_submit,
+    NULL
+};
+
+static Semaphore done_sem(0);
+static volatile int done_status;
+
+static void done_cb(mbedtls_accel_request_t *req, int status) {
+    done_status = status;
+    done_sem.release();
+}
+
+static void init_sha_request(mbedtls_accel_request_t *req, unsigned char *out) {
+    static const unsigned char abc[3] = { 'a', 'b', 'c' };
+    memset(req, 0, sizeof(*req));
+    req->op = MBEDTLS_ACCEL_OP_SHA256;
+    req->u.sha256.input = abc;
+    req->u.sha256.ilen = sizeof(abc);
+    req->u.sha256.output = out;
+    req->u.sha256.is224 = 0;
+    req->callback = done_cb;
+}
+
+void test_software_fallback() {
+    mbedtls_accel_request_t req;
+    unsigned char out[32];
+    mbedtls_accel_stats_t stats;
+
+    mbedtls_accel_reset_stats();
+    init_sha_request(&req, out);
+
+    TEST_ASSERT_EQUAL(0, mbedtls_accel_submit(&req));
+    // Without a driver the callback runs before submit returns
+    TEST_ASSERT_EQUAL(1, done_sem.wait(0));
+    TEST_ASSERT_EQUAL(0, done_status);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(sha256_abc, out, sizeof(out));
+
+    mbedtls_accel_get_stats(MBEDTLS_ACCEL_OP_SHA256, &stats);
+    TEST_ASSERT_EQUAL(1, stats.submitted);
+    TEST_ASSERT_EQUAL(1, stats.fallback);
+    TEST_ASSERT_EQUAL(0, stats.accelerated);
+}
+
+void test_async_completion() {
+    mbedtls_accel_request_t req;
+    unsigned char out[32];
+    mbedtls_accel_stats_t stats;
+
+    TEST_ASSERT_EQUAL(0, mbedtls_accel_register(&mock_driver));
+    mbedtls_accel_reset_stats();
+    init_sha_request(&req, out);
+
+    Timer timer;
+    timer.start();
+    TEST_ASSERT_EQUAL(0, mbedtls_accel_submit(&req));
+    int submit_us = timer.read_us();
+
+    mbedtls_accel_get_stats(MBEDTLS_ACCEL_OP_SHA256, &stats);
+    TEST_ASSERT_EQUAL(1, stats.depth);
+
+    TEST_ASSERT_EQUAL(1, done_sem.wait(10 * MOCK_LATENCY_MS));
+    int complete_us = timer.read_us();
+
+    TEST_ASSERT_EQUAL(0, done_status);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(sha256_abc, out, sizeof(out));
+    // Submission must not have waited for the engine
+    TEST_ASSERT(submit_us < MOCK_LATENCY_MS * 1000);
+    TEST_ASSERT(complete_us >= MOCK_LATENCY_MS * 1000);
+
+    mbedtls_accel_get_stats(MBEDTLS_ACCEL_OP_SHA256, &stats);
+    TEST_ASSERT_EQUAL(1, stats.accelerated);
+    TEST_ASSERT_EQUAL(0, stats.fallback);
+    TEST_ASSERT_EQUAL(0, stats.depth);
+    TEST_ASSERT_EQUAL(1, stats.max_depth);
+}
+
+void test_busy_fallback() {
+    mbedtls_accel_request_t req1, req2;
+    unsigned char out1[32], out2[32];
+    mbedtls_accel_stats_t stats;
+
+    mbedtls_accel_reset_stats();
+    init_sha_request(&req1, out1);
+    init_sha_request(&req2, out2);
+
+    // The mock queue holds one request, so the second runs in software
+    TEST_ASSERT_EQUAL(0, mbedtls_accel_submit(&req1));
+    TEST_ASSERT_EQUAL(0, mbedtls_accel_submit(&req2));
+    TEST_ASSERT_EQUAL(1, done_sem.wait(0));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(sha256_abc, out2, sizeof(out2));
+
+    TEST_ASSERT_EQUAL(1, done_sem.wait(10 * MOCK_LATENCY_MS));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(sha256_abc, out1, sizeof(out1));
+
+    mbedtls_accel_get_stats(MBEDTLS_ACCEL_OP_SHA256, &stats);
+    TEST_ASSERT_EQUAL(2, stats.submitted);
+    TEST_ASSERT_EQUAL(1, stats.accelerated);
+    TEST_ASSERT_EQUAL(1, stats.fallback);
+    TEST_ASSERT_EQUAL(1, stats.busy);
+
+    TEST_ASSERT_EQUAL(0, mbedtls_accel_unregister(&mock_driver));
+}
+
+void test_unsupported_op() {
+    mbedtls_accel_request_t req;
+
+    memset(&req, 0, sizeof(req));
+    req.op = MBEDTLS_ACCEL_OP_COUNT;
+    req.callback = done_cb;
+    TEST_ASSERT_EQUAL(MBEDTLS_ERR_ACCEL_BAD_INPUT, mbedtls_accel_submit(&req));
+    TEST_ASSERT_EQUAL(MBEDTLS_ERR_ACCEL_BAD_INPUT, mbedtls_accel_unregister(&mock_driver));
+}
+
+Case cases[] = {
+    Case("Software fallback without accelerator", test_software_fallback),
+    Case("Asynchronous completion with latency", test_async_completion),
+    Case("Fallback when accelerator is busy", test_busy_fallback),
+    Case("Bad input", test_unsupported_op),
+};
+
+utest::v1::status_t test_setup(const size_t num_cases) {
+    GREENTEA_SETUP(20, "default_auto");
+    mock_thread.start(callback(&mock_queue, &EventQueue::dispatch_forever));
+    return verbose_test_setup_handler(num_cases);
+}
+
+Specification specification(test_setup, cases);
+
+int main() {
+    return !Harness::run(specification);
+}
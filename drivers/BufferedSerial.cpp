@@ -0,0 +1,309 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "drivers/BufferedSerial.h"
+#include "platform/wait_api.h"
+#include "platform/critical.h"
+#include <errno.h>
+
+#if DEVICE_SERIAL
+
+namespace mbed {
+
+BufferedSerial::BufferedSerial(PinName tx, PinName rx, int baud) :
+        SerialBase(tx, rx, baud),
+#if DEVICE_SERIAL_ASYNCH && MBED_CONF_DRIVERS_BUFFERED_SERIAL_TX_DMA
+        _tx_dma_active(false), _tx_dma_size(0),
+#endif
+        _blocking(true), _tx_irq_enabled(false), _rx_overflows(0) {
+    // No lock needed in the constructor
+
+    // The TX interrupt is only enabled while there is data to send
+    _irq[TxIrq].attach(callback(this, &BufferedSerial::tx_irq));
+    _irq[RxIrq].attach(callback(this, &BufferedSerial::rx_irq));
+    if (rx != NC) {
+        serial_irq_set(&_serial, (SerialIrq)RxIrq, 1);
+    }
+}
+
+BufferedSerial::~BufferedSerial() {
+    // No lock can be used in destructor
+    core_util_critical_section_enter();
+    serial_irq_set(&_serial, (SerialIrq)RxIrq, 0);
+    serial_irq_set(&_serial, (SerialIrq)TxIrq, 0);
+#if DEVICE_SERIAL_ASYNCH && MBED_CONF_DRIVERS_BUFFERED_SERIAL_TX_DMA
+    if (_tx_dma_active) {
+        abort_write();
+    }
+#endif
+    core_util_critical_section_exit();
+}
+
+ssize_t BufferedSerial::write(const void *buffer, size_t length) {
+    const char *ptr = (const char *)buffer;
+    size_t written = 0;
+
+    if (in_critical()) {
+        // The mutex can't be taken and nothing will drain the buffer for
+        // us, e.g. printf from a fault handler: push it out by hand. Keep
+        // the TX interrupt out while we take its place.
+        core_util_critical_section_enter();
+        while (written < length) {
+            written += _txbuf.push(ptr + written, length - written);
+            flush_blocking();
+        }
+        core_util_critical_section_exit();
+        return written;
+    }
+
+    lock();
+    while (written < length) {
+        uint32_t count = _txbuf.push(ptr + written, length - written);
+        if (count > 0) {
+            written += count;
+            tx_start();
+            continue;
+        }
+
+        if (_blocking) {
+            wait_for_event();
+        } else {
+            break;
+        }
+    }
+    unlock();
+
+    if (written == 0 && length > 0) {
+        return -EAGAIN;
+    }
+    return written;
+}
+
+ssize_t BufferedSerial::read(void *buffer, size_t length) {
+    if (length == 0) {
+        return 0;
+    }
+
+    lock();
+    while (_rxbuf.empty()) {
+        if (!_blocking) {
+            unlock();
+            return -EAGAIN;
+        }
+        wait_for_event();
+    }
+
+    uint32_t count = _rxbuf.pop((char *)buffer, length);
+    unlock();
+
+    return count;
+}
+
+int BufferedSerial::close() {
+    return 0;
+}
+
+int BufferedSerial::isatty() {
+    return 1;
+}
+
+off_t BufferedSerial::lseek(off_t offset, int whence) {
+    return -1;
+}
+
+int BufferedSerial::fsync() {
+    if (in_critical()) {
+        core_util_critical_section_enter();
+        flush_blocking();
+        core_util_critical_section_exit();
+        return 0;
+    }
+
+    lock();
+    while (!_txbuf.empty()) {
+        wait_for_event();
+    }
+    unlock();
+    return 0;
+}
+
+short BufferedSerial::poll(short events) const {
+    short revents = 0;
+    if (!_rxbuf.empty()) {
+        revents |= POLLIN;
+    }
+    if (!_txbuf.full()) {
+        revents |= POLLOUT;
+    }
+    return revents & events;
+}
+
+void BufferedSerial::set_blocking(bool blocking) {
+    _blocking = blocking;
+}
+
+bool BufferedSerial::is_blocking() const {
+    return _blocking;
+}
+
+void BufferedSerial::sigio(Callback<void()> func) {
+    core_util_critical_section_enter();
+    _sigio_cb = func;
+    core_util_critical_section_exit();
+}
+
+uint32_t BufferedSerial::rx_overflows() const {
+    return _rx_overflows;
+}
+
+void BufferedSerial::lock() {
+    _mutex.lock();
+}
+
+void BufferedSerial::unlock() {
+    _mutex.unlock();
+}
+
+void BufferedSerial::rx_irq() {
+    bool was_empty = _rxbuf.empty();
+
+    // Always drain the UART, even when the buffer is full, so that the
+    // interrupt is acknowledged
+    while (serial_readable(&_serial)) {
+        char c = serial_getc(&_serial);
+        if (!_rxbuf.push(c)) {
+            _rx_overflows++;
+        }
+    }
+
+    if (was_empty && !_rxbuf.empty()) {
+        wake();
+    }
+}
+
+void BufferedSerial::tx_irq() {
+    bool was_full = _txbuf.full();
+    char c;
+
+    while (serial_writable(&_serial) && _txbuf.pop(c)) {
+        serial_putc(&_serial, c);
+    }
+
+    if (_txbuf.empty()) {
+        serial_irq_set(&_serial, (SerialIrq)TxIrq, 0);
+        _tx_irq_enabled = false;
+#ifdef MBED_CONF_RTOS_PRESENT
+        // fsync() waits for the buffer to empty
+        _event_sem.release();
+#endif
+    }
+
+    if (was_full && !_txbuf.full()) {
+        wake();
+    }
+}
+
+void BufferedSerial::tx_start() {
+    // The interrupt handler may be about to turn itself off, so decide
+    // whether it needs restarting with interrupts disabled
+    core_util_critical_section_enter();
+#if DEVICE_SERIAL_ASYNCH && MBED_CONF_DRIVERS_BUFFERED_SERIAL_TX_DMA
+    if (!_tx_dma_active) {
+        uint32_t size;
+        const char *span = _txbuf.read_span(size);
+        if (size > 0) {
+            _tx_dma_active = true;
+            _tx_dma_size = size;
+            start_write(span, size, 8, callback(this, &BufferedSerial::tx_dma_done), SERIAL_EVENT_TX_COMPLETE);
+        }
+    }
+#else
+    if (!_tx_irq_enabled) {
+        // Fill the UART FIFO straight away rather than waiting for the
+        // first interrupt
+        tx_irq();
+        if (!_txbuf.empty()) {
+            _tx_irq_enabled = true;
+            serial_irq_set(&_serial, (SerialIrq)TxIrq, 1);
+        }
+    }
+#endif
+    core_util_critical_section_exit();
+}
+
+#if DEVICE_SERIAL_ASYNCH && MBED_CONF_DRIVERS_BUFFERED_SERIAL_TX_DMA
+void BufferedSerial::tx_dma_done(int event) {
+    bool was_full = _txbuf.full();
+
+    _txbuf.commit_read(_tx_dma_size);
+    _tx_dma_active = false;
+    tx_start();
+
+#ifdef MBED_CONF_RTOS_PRESENT
+    if (_txbuf.empty()) {
+        _event_sem.release();
+    }
+#endif
+    if (was_full) {
+        wake();
+    }
+}
+#endif
+
+void BufferedSerial::flush_blocking() {
+    // Called with interrupts disabled, e.g. while reporting a fatal error
+#if DEVICE_SERIAL_ASYNCH && MBED_CONF_DRIVERS_BUFFERED_SERIAL_TX_DMA
+    if (_tx_dma_active) {
+        // The completion interrupt cannot run, so restart the transfer by
+        // hand. Bytes already sent by the DMA may be repeated.
+        abort_write();
+        _tx_dma_active = false;
+    }
+#endif
+    char c;
+    while (_txbuf.pop(c)) {
+        serial_putc(&_serial, c);
+    }
+}
+
+void BufferedSerial::wake() {
+#ifdef MBED_CONF_RTOS_PRESENT
+    _event_sem.release();
+#endif
+    if (_sigio_cb) {
+        _sigio_cb.call();
+    }
+}
+
+void BufferedSerial::wait_for_event() {
+    unlock();
+#ifdef MBED_CONF_RTOS_PRESENT
+    // A release between the caller's check and here leaves a token, so no
+    // wake up is lost. Callers check their condition again either way.
+    _event_sem.wait();
+#else
+    // No other threads to run, let the interrupt handlers make progress
+    wait_ms(1);
+#endif
+    lock();
+}
+
+bool BufferedSerial::in_critical() const {
+    return core_util_is_isr_active() || !core_util_are_interrupts_enabled();
+}
+
+} // namespace mbed
+
+#endif
@@ -0,0 +1,236 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef MBED_BUFFEREDSERIAL_H
+#define MBED_BUFFEREDSERIAL_H
+
+#include "platform/platform.h"
+
+#if DEVICE_SERIAL
+
+#include "FileHandle.h"
+#include "SerialBase.h"
+#include "PlatformMutex.h"
+#include "serial_api.h"
+#include "platform/RingBuffer.h"
+#include "platform/Callback.h"
+#ifdef MBED_CONF_RTOS_PRESENT
+#include "rtos/Semaphore.h"
+#endif
+
+#ifndef MBED_CONF_DRIVERS_BUFFERED_SERIAL_TXBUF_SIZE
+#define MBED_CONF_DRIVERS_BUFFERED_SERIAL_TXBUF_SIZE 256
+#endif
+
+#ifndef MBED_CONF_DRIVERS_BUFFERED_SERIAL_RXBUF_SIZE
+#define MBED_CONF_DRIVERS_BUFFERED_SERIAL_RXBUF_SIZE 256
+#endif
+
+namespace mbed {
+/** \addtogroup drivers */
+/** @{*/
+
+/** An interrupt driven serial port (UART) with transmit and receive buffers
+ *
+ * Writes copy into the TX buffer and return as soon as the data fits, the
+ * UART interrupt (or, with drivers.buffered-serial-tx-dma, the asynchronous
+ * serial API) drains it in the background. Received bytes are collected
+ * into the RX buffer from the UART interrupt. Reads and writes move whole
+ * buffers at a time instead of one character per call.
+ *
+ * @Note Synchronization level: Thread safe
+ *
+ * Example:
+ * @code
+ * #include "mbed.h"
+ * #include "BufferedSerial.h"
+ *
+ * BufferedSerial pc(USBTX, USBRX, 115200);
+ *
+ * int main() {
+ *     char buf[32];
+ *     while (true) {
+ *         ssize_t n = pc.read(buf, sizeof(buf));
+ *         pc.write(buf, n);
+ *     }
+ * }
+ * @endcode
+ */
+class BufferedSerial : private SerialBase, public FileHandle {
+
+public:
+    /** Create a buffered serial port, connected to the specified transmit and receive pins
+     *
+     *  @param tx Transmit pin
+     *  @param rx Receive pin
+     *  @param baud The baud rate of the serial port (optional, defaults to MBED_CONF_PLATFORM_DEFAULT_SERIAL_BAUD_RATE)
+     *
+     *  @note
+     *    Either tx or rx may be specified as NC if unused
+     */
+    BufferedSerial(PinName tx, PinName rx, int baud = MBED_CONF_PLATFORM_DEFAULT_SERIAL_BAUD_RATE);
+
+    virtual ~BufferedSerial();
+
+    using SerialBase::baud;
+    using SerialBase::format;
+    using SerialBase::send_break;
+#if DEVICE_SERIAL_FC
+    using SerialBase::set_flow_control;
+#endif
+
+    /** Write the contents of a buffer to the serial port
+     *
+     *  In blocking mode, waits for space in the TX buffer until all the data
+     *  has been queued. In non-blocking mode, queues as much as fits.
+     *
+     *  @param buffer the buffer to write from
+     *  @param length the number of bytes to write
+     *
+     *  @returns
+     *    The number of bytes queued for transmission, or
+     *    -EAGAIN in non-blocking mode if the TX buffer is full
+     */
+    virtual ssize_t write(const void *buffer, size_t length);
+
+    /** Read received data into a buffer
+     *
+     *  In blocking mode, waits until at least one byte has been received.
+     *  Returns whatever is buffered, up to length bytes.
+     *
+     *  @param buffer the buffer to read in to
+     *  @param length the maximum number of bytes to read
+     *
+     *  @returns
+     *    The number of bytes read, or
+     *    -EAGAIN in non-blocking mode if no data is available
+     */
+    virtual ssize_t read(void *buffer, size_t length);
+
+    /** Close the serial port
+     *
+     *  @returns 0
+     */
+    virtual int close();
+
+    /** Check if the handle is for an interactive terminal device
+     *
+     *  @returns 1
+     */
+    virtual int isatty();
+
+    /** Seeking is not supported on a serial port
+     *
+     *  @returns -1
+     */
+    virtual off_t lseek(off_t offset, int whence);
+
+    /** Wait until all queued data has been handed to the UART
+     *
+     *  @returns 0
+     */
+    virtual int fsync();
+
+    /** Check for readiness without blocking
+     *
+     *  @param events Bitmask of POLLIN and POLLOUT to check for
+     *
+     *  @returns
+     *    POLLIN if received data is buffered, POLLOUT if there is space in
+     *    the TX buffer, masked by events
+     */
+    virtual short poll(short events) const;
+
+    /** Set blocking or non-blocking mode
+     *
+     *  @param blocking true for blocking (default), false for non-blocking
+     */
+    void set_blocking(bool blocking);
+
+    /** Check if the port is in blocking mode
+     *
+     *  @returns true if blocking
+     */
+    bool is_blocking() const;
+
+    /** Register a callback for readiness changes
+     *
+     *  Called from interrupt context whenever data is received or space is
+     *  freed in a previously full TX buffer, so that poll() would return a
+     *  different result.
+     *
+     *  @param func Function to call, or NULL to remove the callback
+     */
+    void sigio(Callback<void()> func);
+
+    /** Get the number of received bytes dropped because the RX buffer was full
+     *
+     *  @returns the overflow count since construction
+     */
+    uint32_t rx_overflows() const;
+
+    /** Transmit everything in the TX buffer by polling the UART
+     *
+     *  Takes no lock and does not rely on interrupts, for fatal error
+     *  handlers that run with interrupts disabled.
+     */
+    void flush_blocking();
+
+protected:
+    virtual void lock();
+    virtual void unlock();
+
+private:
+    void rx_irq();
+    void tx_irq();
+    void tx_start();
+    void wake();
+    void wait_for_event();
+    bool in_critical() const;
+
+#if DEVICE_SERIAL_ASYNCH && MBED_CONF_DRIVERS_BUFFERED_SERIAL_TX_DMA
+    void tx_dma_done(int event);
+
+    volatile bool _tx_dma_active;
+    uint32_t _tx_dma_size;
+#endif
+
+    // Threads push under the mutex but interrupt handlers and critical
+    // sections push without it, so the TX side has more than one producer
+    RingBuffer<char, MBED_CONF_DRIVERS_BUFFERED_SERIAL_TXBUF_SIZE, RingBufferInterruptSafe> _txbuf;
+    RingBuffer<char, MBED_CONF_DRIVERS_BUFFERED_SERIAL_RXBUF_SIZE, RingBufferSPSC> _rxbuf;
+
+    PlatformMutex _mutex;
+#ifdef MBED_CONF_RTOS_PRESENT
+    // Released by the interrupt handlers whenever a blocked call may proceed
+    rtos::Semaphore _event_sem;
+#endif
+    Callback<void()> _sigio_cb;
+    bool _blocking;
+    volatile bool _tx_irq_enabled;
+    volatile uint32_t _rx_overflows;
+
+    /* disallow copy constructor and assignment operators */
+    BufferedSerial(const BufferedSerial&);
+    BufferedSerial & operator = (const BufferedSerial&);
+};
+
+} // namespace mbed
+
+#endif
+
+#endif
+
+/** @}*/
@@ -19,6 +19,7 @@
 typedef int FILEHANDLE;
 
 #include <stdio.h>
+#include "platform/mbed_poll.h"
 
 #if defined(__ARMCC_VERSION) || defined(__ICCARM__)
 typedef int ssize_t;
@@ -120,6 +121,21 @@ public:
         return res;
     }
 
+    /** Check for readiness events without blocking
+     *
+     *  Handles that never block, such as regular files, report that they
+     *  are always readable and writable.
+     *
+     *  @param events Bitmask of POLLIN and POLLOUT to check for
+     *
+     *  @returns
+     *    bitmask of the requested events that are ready, plus POLLERR or
+     *    POLLHUP if applicable
+     */
+    virtual short poll(short events) const {
+        return events & (POLLIN | POLLOUT);
+    }
+
     virtual ~FileHandle();
 
 protected:
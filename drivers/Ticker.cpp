@@ -38,7 +38,7 @@ void Ticker::setup(timestamp_t t) {
 }
 
 void Ticker::handler() {
-    insert(event.timestamp + _delay);
+    ticker_rearm_event(_ticker_data, &event, _delay);
     _function.call();
 }
 
@@ -289,6 +289,57 @@ void mbed_vtracef(uint8_t dlevel, const char* grp, const char *fmt, va_list ap)
 void mbed_vtracef(uint8_t dlevel, const char* grp, const char *fmt, va_list ap);
 #endif
 
+/**
+ * Enable or disable binary trace mode
+ * In binary mode a trace call does not format the line. The group and format
+ * string pointers are stored into a ring buffer together with the raw
+ * arguments, and the line is formatted later by mbed_trace_binary_flush(),
+ * for example from a low priority task, or off-device by a host tool that
+ * reads the records from mbed_trace_binary_read() and resolves the pointers
+ * from the ELF file (tools/trace_decode.py).
+ * Group names and format strings must therefore stay valid, e.g. string
+ * literals. %s arguments are copied into the record, truncated to fit.
+ * TRACE_LEVEL_CMD traces are always printed straight away.
+ * When the ring is full new traces are dropped and counted.
+ * Stored traces can only be read once no trace call is storing a record, so a
+ * trace call preempted half way holds back the output until it completes.
+ *
+ * @param buffer_size   ring buffer size in bytes, rounded down to a power of two.
+ *                      0 to return to the text mode
+ * @return 0 when all success, -1 if memory allocation failed
+ */
+int mbed_trace_binary_mode_set(int buffer_size);
+/**
+ * Format and print the traces stored in binary mode
+ * Uses the print function and the prefix / suffix functions as configured.
+ * Must not be called from more than one thread at a time; does not take
+ * the trace mutex, so new traces are not blocked by a slow print function.
+ * @return number of traces printed
+ */
+int mbed_trace_binary_flush(void);
+/**
+ * Move raw binary trace records out of the ring buffer
+ * Copies whole records only; the same rules as for mbed_trace_binary_flush()
+ * apply.
+ * @param buf  destination buffer
+ * @param len  destination buffer length in bytes
+ * @return number of bytes copied
+ */
+int mbed_trace_binary_read(uint8_t *buf, int len);
+/**
+ * Get the number of traces dropped because the binary ring buffer was full
+ */
+uint32_t mbed_trace_binary_dropped(void);
+/**
+ * Set function which is called when a trace is stored in binary mode
+ * and no flush is pending, e.g. to schedule mbed_trace_binary_flush()
+ * on an event queue.
+ */
+void mbed_trace_binary_notify_function_set(void (*notify_f)(void));
+/**
+ * Set function which returns a timestamp stored with each binary trace
+ */
+void mbed_trace_binary_timestamp_function_set(uint32_t (*timestamp_f)(void));
 
 /**
  *  Get last trace from buffer
@@ -367,6 +418,12 @@ char* mbed_trace_array(const uint8_t* buf, uint16_t len);
 #undef mbed_tracef
 #undef mbed_vtracef
 #undef mbed_trace_last
+#undef mbed_trace_binary_mode_set
+#undef mbed_trace_binary_flush
+#undef mbed_trace_binary_read
+#undef mbed_trace_binary_dropped
+#undef mbed_trace_binary_notify_function_set
+#undef mbed_trace_binary_timestamp_function_set
 #undef mbed_trace_ipv6
 #undef mbed_trace_ipv6_prefix
 #undef mbed_trace_array
@@ -392,6 +449,12 @@ char* mbed_trace_array(const uint8_t* buf, uint16_t len);
 #define mbed_trace_last(...)                        ((const char *) 0)
 #define mbed_tracef(...)                            ((void) 0)
 #define mbed_vtracef(...)                           ((void) 0)
+#define mbed_trace_binary_mode_set(...)             ((int) 0)
+#define mbed_trace_binary_flush(...)                ((int) 0)
+#define mbed_trace_binary_read(...)                 ((int) 0)
+#define mbed_trace_binary_dropped(...)              ((uint32_t) 0)
+#define mbed_trace_binary_notify_function_set(...)  ((void) 0)
+#define mbed_trace_binary_timestamp_function_set(...) ((void) 0)
 /**
  * These helper functions accumulate strings in a buffer that is only flushed by actual trace calls. Using these
  * functions outside trace calls could cause the buffer to overflow.
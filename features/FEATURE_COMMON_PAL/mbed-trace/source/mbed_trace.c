@@ -69,11 +69,41 @@
 #endif
 /** default max filters (include/exclude) length in bytes */
 #define DEFAULT_TRACE_FILTER_LENGTH       24
+/** max size of one binary trace record in bytes, incl. copied %s arguments */
+#ifdef YOTTA_CFG_MBED_TRACE_BINARY_RECORD_SIZE
+#define DEFAULT_TRACE_BINARY_RECORD_SIZE  YOTTA_CFG_MBED_TRACE_BINARY_RECORD_SIZE
+#else
+#define DEFAULT_TRACE_BINARY_RECORD_SIZE  192
+#endif
+#if DEFAULT_TRACE_BINARY_RECORD_SIZE > 1020
+#error Binary trace record size must not exceed 1020 bytes
+#endif
+
+/* Binary trace writers reserve ring space with compare-and-swap where the
+ * core has it. Elsewhere (e.g. Cortex-M0) writers rely on the trace mutex. */
+#if (defined(__GNUC__) || defined(__CC_ARM)) && !defined(__ARM_ARCH_6M__) && !defined(__TARGET_ARCH_6S_M)
+#define MBED_TRACE_CAS(ptr, oldval, newval) __sync_bool_compare_and_swap(ptr, oldval, newval)
+#define MBED_TRACE_ADD(ptr, val)            __sync_fetch_and_add(ptr, val)
+#define MBED_TRACE_BARRIER()                __sync_synchronize()
+#else
+static bool mbed_trace_cas(volatile uint32_t *ptr, uint32_t oldval, uint32_t newval)
+{
+    if (*ptr != oldval) {
+        return false;
+    }
+    *ptr = newval;
+    return true;
+}
+#define MBED_TRACE_CAS(ptr, oldval, newval) mbed_trace_cas(ptr, oldval, newval)
+#define MBED_TRACE_ADD(ptr, val)            (*(ptr) += (val))
+#define MBED_TRACE_BARRIER()
+#endif
 
 /** default print function, just redirect str to printf */
 static void mbed_trace_realloc( char **buffer, int *length_ptr, int new_length);
 static void mbed_trace_default_print(const char *str);
 static void mbed_trace_reset_tmp(void);
+static void mbed_trace_binary_store(uint8_t dlevel, const char *grp, const char *fmt, va_list ap);
 
 typedef struct trace_s {
     /** trace configuration bits */
@@ -111,6 +141,33 @@ typedef struct trace_s {
     int mutex_lock_count;
 } trace_t;
 
+typedef struct trace_binary_s {
+    /** ring buffer of binary trace records, NULL in text mode */
+    uint32_t *ring;
+    /** ring size in words - 1 */
+    uint32_t mask;
+    /** words reserved, committed and read, free running */
+    volatile uint32_t reserve;
+    volatile uint32_t commit;
+    volatile uint32_t tail;
+    /** number of dropped traces */
+    volatile uint32_t dropped;
+    /** set when notify function has been called and no flush has run since */
+    volatile uint8_t notified;
+    /** formatted trace text, used by mbed_trace_binary_flush */
+    char *text;
+    /** trace line, used by mbed_trace_binary_flush */
+    char *line;
+    /** length of text and line */
+    int line_length;
+    /** called when there is something to flush */
+    void (*notify_f)(void);
+    /** timestamp function */
+    uint32_t (*timestamp_f)(void);
+} trace_binary_t;
+
+static trace_binary_t m_trace_binary;
+
 static trace_t m_trace = {
     .filters_exclude = 0,
     .filters_include = 0,
@@ -167,6 +224,7 @@ int mbed_trace_init(void)
 }
 void mbed_trace_free(void)
 {
+    mbed_trace_binary_mode_set(0);
     MBED_TRACE_MEM_FREE(m_trace.line);
     m_trace.line_length = 0;
     m_trace.line = 0;
@@ -288,92 +346,29 @@ void mbed_tracef(uint8_t dlevel, const char *grp, const char *fmt, ...)
     mbed_vtracef(dlevel, grp, fmt, ap);
     va_end(ap);
 }
-void mbed_vtracef(uint8_t dlevel, const char* grp, const char *fmt, va_list ap)
+/** format one trace line into given buffer and print it out */
+static void mbed_trace_vline(char *line, int line_length, uint8_t dlevel, const char *grp, const char *fmt, va_list ap)
 {
-    if ( m_trace.mutex_wait_f ) {
-        m_trace.mutex_wait_f();
-        m_trace.mutex_lock_count++;
-    }
-
-    if (NULL == m_trace.line) {
-        goto end;
-    }
+    bool color = (m_trace.trace_config & TRACE_MODE_COLOR) != 0;
+    bool plain = (m_trace.trace_config & TRACE_MODE_PLAIN) != 0;
+    bool cr    = (m_trace.trace_config & TRACE_CARRIAGE_RETURN) != 0;
 
-    m_trace.line[0] = 0; //by default trace is empty
-
-    if (mbed_trace_skip(dlevel, grp) || fmt == 0 || grp == 0 || !m_trace.printf) {
-        //return tmp data pointer back to the beginning
-        mbed_trace_reset_tmp();
-        goto end;
-    }
-    if ((m_trace.trace_config & TRACE_MASK_LEVEL) &  dlevel) {
-        bool color = (m_trace.trace_config & TRACE_MODE_COLOR) != 0;
-        bool plain = (m_trace.trace_config & TRACE_MODE_PLAIN) != 0;
-        bool cr    = (m_trace.trace_config & TRACE_CARRIAGE_RETURN) != 0;
-
-        int retval = 0, bLeft = m_trace.line_length;
-        char *ptr = m_trace.line;
-        if (plain == true || dlevel == TRACE_LEVEL_CMD) {
-            //add trace data
-            retval = vsnprintf(ptr, bLeft, fmt, ap);
-            if (dlevel == TRACE_LEVEL_CMD && m_trace.cmd_printf) {
-                m_trace.cmd_printf(m_trace.line);
-                m_trace.cmd_printf("\n");
-            } else {
-                //print out whole data
-                m_trace.printf(m_trace.line);
-            }
+    int retval = 0, bLeft = line_length;
+    char *ptr = line;
+    if (plain == true || dlevel == TRACE_LEVEL_CMD) {
+        //add trace data
+        retval = vsnprintf(ptr, bLeft, fmt, ap);
+        if (dlevel == TRACE_LEVEL_CMD && m_trace.cmd_printf) {
+            m_trace.cmd_printf(line);
+            m_trace.cmd_printf("\n");
         } else {
-            if (color) {
-                if (cr) {
-                    retval = snprintf(ptr, bLeft, "\r\x1b[2K");
-                    if (retval >= bLeft) {
-                        retval = 0;
-                    }
-                    if (retval > 0) {
-                        ptr += retval;
-                        bLeft -= retval;
-                    }
-                }
-                if (bLeft > 0) {
-                    //include color in ANSI/VT100 escape code
-                    switch (dlevel) {
-                        case (TRACE_LEVEL_ERROR):
-                            retval = snprintf(ptr, bLeft, "%s", VT100_COLOR_ERROR);
-                            break;
-                        case (TRACE_LEVEL_WARN):
-                            retval = snprintf(ptr, bLeft, "%s", VT100_COLOR_WARN);
-                            break;
-                        case (TRACE_LEVEL_INFO):
-                            retval = snprintf(ptr, bLeft, "%s", VT100_COLOR_INFO);
-                            break;
-                        case (TRACE_LEVEL_DEBUG):
-                            retval = snprintf(ptr, bLeft, "%s", VT100_COLOR_DEBUG);
-                            break;
-                        default:
-                            color = 0; //avoid unneeded color-terminate code
-                            retval = 0;
-                            break;
-                    }
-                    if (retval >= bLeft) {
-                        retval = 0;
-                    }
-                    if (retval > 0 && color) {
-                        ptr += retval;
-                        bLeft -= retval;
-                    }
-                }
-
-            }
-            if (bLeft > 0 && m_trace.prefix_f) {
-                //find out length of body
-                size_t sz = 0;
-                va_list ap2;
-                va_copy(ap2, ap);
-                sz = vsnprintf(NULL, 0, fmt, ap2) + retval + (retval ? 4 : 0);
-                va_end(ap2);
-                //add prefix string
-                retval = snprintf(ptr, bLeft, "%s", m_trace.prefix_f(sz));
+            //print out whole data
+            m_trace.printf(line);
+        }
+    } else {
+        if (color) {
+            if (cr) {
+                retval = snprintf(ptr, bLeft, "\r\x1b[2K");
                 if (retval >= bLeft) {
                     retval = 0;
                 }
@@ -383,70 +378,150 @@ void mbed_vtracef(uint8_t dlevel, const char* grp, const char *fmt, va_list ap)
                 }
             }
             if (bLeft > 0) {
-                //add group tag
+                //include color in ANSI/VT100 escape code
                 switch (dlevel) {
                     case (TRACE_LEVEL_ERROR):
-                        retval = snprintf(ptr, bLeft, "[ERR ][%-4s]: ", grp);
+                        retval = snprintf(ptr, bLeft, "%s", VT100_COLOR_ERROR);
                         break;
                     case (TRACE_LEVEL_WARN):
-                        retval = snprintf(ptr, bLeft, "[WARN][%-4s]: ", grp);
+                        retval = snprintf(ptr, bLeft, "%s", VT100_COLOR_WARN);
                         break;
                     case (TRACE_LEVEL_INFO):
-                        retval = snprintf(ptr, bLeft, "[INFO][%-4s]: ", grp);
+                        retval = snprintf(ptr, bLeft, "%s", VT100_COLOR_INFO);
                         break;
                     case (TRACE_LEVEL_DEBUG):
-                        retval = snprintf(ptr, bLeft, "[DBG ][%-4s]: ", grp);
+                        retval = snprintf(ptr, bLeft, "%s", VT100_COLOR_DEBUG);
                         break;
                     default:
-                        retval = snprintf(ptr, bLeft, "              ");
+                        color = 0; //avoid unneeded color-terminate code
+                        retval = 0;
                         break;
                 }
                 if (retval >= bLeft) {
                     retval = 0;
                 }
-                if (retval > 0) {
+                if (retval > 0 && color) {
                     ptr += retval;
                     bLeft -= retval;
                 }
             }
-            if (retval > 0 && bLeft > 0) {
-                //add trace text
-                retval = vsnprintf(ptr, bLeft, fmt, ap);
-                if (retval >= bLeft) {
-                    retval = 0;
-                }
-                if (retval > 0) {
-                    ptr += retval;
-                    bLeft -= retval;
-                }
+
+        }
+        if (bLeft > 0 && m_trace.prefix_f) {
+            //find out length of body
+            size_t sz = 0;
+            va_list ap2;
+            va_copy(ap2, ap);
+            sz = vsnprintf(NULL, 0, fmt, ap2) + retval + (retval ? 4 : 0);
+            va_end(ap2);
+            //add prefix string
+            retval = snprintf(ptr, bLeft, "%s", m_trace.prefix_f(sz));
+            if (retval >= bLeft) {
+                retval = 0;
+            }
+            if (retval > 0) {
+                ptr += retval;
+                bLeft -= retval;
+            }
+        }
+        if (bLeft > 0) {
+            //add group tag
+            switch (dlevel) {
+                case (TRACE_LEVEL_ERROR):
+                    retval = snprintf(ptr, bLeft, "[ERR ][%-4s]: ", grp);
+                    break;
+                case (TRACE_LEVEL_WARN):
+                    retval = snprintf(ptr, bLeft, "[WARN][%-4s]: ", grp);
+                    break;
+                case (TRACE_LEVEL_INFO):
+                    retval = snprintf(ptr, bLeft, "[INFO][%-4s]: ", grp);
+                    break;
+                case (TRACE_LEVEL_DEBUG):
+                    retval = snprintf(ptr, bLeft, "[DBG ][%-4s]: ", grp);
+                    break;
+                default:
+                    retval = snprintf(ptr, bLeft, "              ");
+                    break;
             }
+            if (retval >= bLeft) {
+                retval = 0;
+            }
+            if (retval > 0) {
+                ptr += retval;
+                bLeft -= retval;
+            }
+        }
+        if (retval > 0 && bLeft > 0) {
+            //add trace text
+            retval = vsnprintf(ptr, bLeft, fmt, ap);
+            if (retval >= bLeft) {
+                retval = 0;
+            }
+            if (retval > 0) {
+                ptr += retval;
+                bLeft -= retval;
+            }
+        }
 
-            if (retval > 0 && bLeft > 0  && m_trace.suffix_f) {
-                //add suffix string
-                retval = snprintf(ptr, bLeft, "%s", m_trace.suffix_f());
-                if (retval >= bLeft) {
-                    retval = 0;
-                }
-                if (retval > 0) {
-                    ptr += retval;
-                    bLeft -= retval;
-                }
+        if (retval > 0 && bLeft > 0  && m_trace.suffix_f) {
+            //add suffix string
+            retval = snprintf(ptr, bLeft, "%s", m_trace.suffix_f());
+            if (retval >= bLeft) {
+                retval = 0;
+            }
+            if (retval > 0) {
+                ptr += retval;
+                bLeft -= retval;
             }
+        }
 
-            if (retval > 0 && bLeft > 0  && color) {
-                //add zero color VT100 when color mode
-                retval = snprintf(ptr, bLeft, "\x1b[0m");
-                if (retval >= bLeft) {
-                    retval = 0;
-                }
-                if (retval > 0) {
-                    // not used anymore
-                    //ptr += retval;
-                    //bLeft -= retval;
-                }
+        if (retval > 0 && bLeft > 0  && color) {
+            //add zero color VT100 when color mode
+            retval = snprintf(ptr, bLeft, "\x1b[0m");
+            if (retval >= bLeft) {
+                retval = 0;
             }
-            //print out whole data
-            m_trace.printf(m_trace.line);
+            if (retval > 0) {
+                // not used anymore
+                //ptr += retval;
+                //bLeft -= retval;
+            }
+        }
+        //print out whole data
+        m_trace.printf(line);
+    }
+}
+static void mbed_trace_line(char *line, int line_length, uint8_t dlevel, const char *grp, const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    mbed_trace_vline(line, line_length, dlevel, grp, fmt, ap);
+    va_end(ap);
+}
+void mbed_vtracef(uint8_t dlevel, const char* grp, const char *fmt, va_list ap)
+{
+    if ( m_trace.mutex_wait_f ) {
+        m_trace.mutex_wait_f();
+        m_trace.mutex_lock_count++;
+    }
+
+    if (NULL == m_trace.line) {
+        goto end;
+    }
+
+    m_trace.line[0] = 0; //by default trace is empty
+
+    if (mbed_trace_skip(dlevel, grp) || fmt == 0 || grp == 0 || !m_trace.printf) {
+        //return tmp data pointer back to the beginning
+        mbed_trace_reset_tmp();
+        goto end;
+    }
+    if ((m_trace.trace_config & TRACE_MASK_LEVEL) &  dlevel) {
+        if (m_trace_binary.ring && dlevel != TRACE_LEVEL_CMD) {
+            //store for later formatting, helper function results are copied
+            mbed_trace_binary_store(dlevel, grp, fmt, ap);
+        } else {
+            mbed_trace_vline(m_trace.line, m_trace.line_length, dlevel, grp, fmt, ap);
         }
         //return tmp data pointer back to the beginning
         mbed_trace_reset_tmp();
@@ -570,3 +645,480 @@ char *mbed_trace_array(const uint8_t *buf, uint16_t len)
     m_trace.tmp_data_ptr = wptr;
     return str;
 }
+
+/* Binary trace mode
+ *
+ * Record layout, in native words:
+ *   word 0:  bits 0-7 record size in words, bits 8-15 trace level,
+ *            bits 16-23 flags, bits 24-31 TRACE_BINARY_MAGIC
+ *   word 1:  timestamp
+ *   group pointer, format string pointer
+ *   arguments in format string order: int, long, long long, size_t,
+ *   double and pointer values in their native size rounded up to words,
+ *   strings as a length word followed by the NUL terminated characters.
+ */
+#define TRACE_BINARY_MAGIC          0xB5
+#define TRACE_BINARY_FLAG_TRUNCATED 0x01
+#define TRACE_BINARY_HEADER_WORDS   2
+#define TRACE_BINARY_RECORD_WORDS   (DEFAULT_TRACE_BINARY_RECORD_SIZE / 4)
+#define TRACE_BINARY_WORDS(type)    ((sizeof(type) + 3) / 4)
+
+typedef enum {
+    TRACE_ARG_NONE,
+    TRACE_ARG_INT,
+    TRACE_ARG_LONG,
+    TRACE_ARG_LLONG,
+    TRACE_ARG_SIZE,
+    TRACE_ARG_DOUBLE,
+    TRACE_ARG_PTR,
+    TRACE_ARG_STR,
+    TRACE_ARG_INVALID
+} trace_arg_t;
+
+/** parse one conversion specification, fmt points after the '%' */
+static const char *mbed_trace_binary_spec(const char *fmt, trace_arg_t *type, int *stars)
+{
+    char length = 0;
+    *stars = 0;
+    while (*fmt && strchr("-+ #0", *fmt)) {
+        fmt++;
+    }
+    if (*fmt == '*') {
+        (*stars)++;
+        fmt++;
+    }
+    while (*fmt >= '0' && *fmt <= '9') {
+        fmt++;
+    }
+    if (*fmt == '.') {
+        fmt++;
+        if (*fmt == '*') {
+            (*stars)++;
+            fmt++;
+        }
+        while (*fmt >= '0' && *fmt <= '9') {
+            fmt++;
+        }
+    }
+    while (*fmt && strchr("hlLqjzt", *fmt)) {
+        length = (length == 'l' && *fmt == 'l') ? 'q' : *fmt;
+        fmt++;
+    }
+    switch (*fmt) {
+        case 'd': case 'i': case 'u': case 'o': case 'x': case 'X': case 'c':
+            if (length == 'l') {
+                *type = TRACE_ARG_LONG;
+            } else if (length == 'q' || length == 'j') {
+                *type = TRACE_ARG_LLONG;
+            } else if (length == 'z' || length == 't') {
+                *type = TRACE_ARG_SIZE;
+            } else {
+                *type = TRACE_ARG_INT;
+            }
+            break;
+        case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+            *type = TRACE_ARG_DOUBLE;
+            break;
+        case 's':
+            *type = TRACE_ARG_STR;
+            break;
+        case 'p': case 'n':
+            *type = TRACE_ARG_PTR;
+            break;
+        case '%':
+            *type = TRACE_ARG_NONE;
+            break;
+        default:
+            *type = TRACE_ARG_INVALID;
+            return fmt;
+    }
+    return fmt + 1;
+}
+static int mbed_trace_binary_encode(uint32_t *rec, uint8_t dlevel, const char *grp, const char *fmt, va_list ap)
+{
+    int pos = TRACE_BINARY_HEADER_WORDS;
+    uint8_t flags = 0;
+    const char *ptr = fmt;
+
+    rec[1] = m_trace_binary.timestamp_f ? m_trace_binary.timestamp_f() : 0;
+    memcpy(&rec[pos], &grp, sizeof(grp));
+    pos += TRACE_BINARY_WORDS(grp);
+    memcpy(&rec[pos], &fmt, sizeof(fmt));
+    pos += TRACE_BINARY_WORDS(fmt);
+
+    while ((ptr = strchr(ptr, '%')) != NULL) {
+        trace_arg_t type;
+        int stars, left;
+        ptr = mbed_trace_binary_spec(ptr + 1, &type, &stars);
+        if (type == TRACE_ARG_INVALID) {
+            break;
+        }
+        for (; stars > 0; stars--) {
+            int value = va_arg(ap, int);
+            if (pos + 1 > TRACE_BINARY_RECORD_WORDS) {
+                flags |= TRACE_BINARY_FLAG_TRUNCATED;
+                goto done;
+            }
+            memcpy(&rec[pos++], &value, sizeof(value));
+        }
+        left = TRACE_BINARY_RECORD_WORDS - pos;
+        switch (type) {
+            case TRACE_ARG_INT: {
+                int value = va_arg(ap, int);
+                if (left < (int)TRACE_BINARY_WORDS(value)) {
+                    flags |= TRACE_BINARY_FLAG_TRUNCATED;
+                    goto done;
+                }
+                memcpy(&rec[pos], &value, sizeof(value));
+                pos += TRACE_BINARY_WORDS(value);
+                break;
+            }
+            case TRACE_ARG_LONG: {
+                long value = va_arg(ap, long);
+                if (left < (int)TRACE_BINARY_WORDS(value)) {
+                    flags |= TRACE_BINARY_FLAG_TRUNCATED;
+                    goto done;
+                }
+                memcpy(&rec[pos], &value, sizeof(value));
+                pos += TRACE_BINARY_WORDS(value);
+                break;
+            }
+            case TRACE_ARG_LLONG: {
+                long long value = va_arg(ap, long long);
+                if (left < (int)TRACE_BINARY_WORDS(value)) {
+                    flags |= TRACE_BINARY_FLAG_TRUNCATED;
+                    goto done;
+                }
+                memcpy(&rec[pos], &value, sizeof(value));
+                pos += TRACE_BINARY_WORDS(value);
+                break;
+            }
+            case TRACE_ARG_SIZE: {
+                size_t value = va_arg(ap, size_t);
+                if (left < (int)TRACE_BINARY_WORDS(value)) {
+                    flags |= TRACE_BINARY_FLAG_TRUNCATED;
+                    goto done;
+                }
+                memcpy(&rec[pos], &value, sizeof(value));
+                pos += TRACE_BINARY_WORDS(value);
+                break;
+            }
+            case TRACE_ARG_DOUBLE: {
+                // long double is stored as double
+                double value = (ptr[-2] == 'L') ? (double)va_arg(ap, long double) : va_arg(ap, double);
+                if (left < (int)TRACE_BINARY_WORDS(value)) {
+                    flags |= TRACE_BINARY_FLAG_TRUNCATED;
+                    goto done;
+                }
+                memcpy(&rec[pos], &value, sizeof(value));
+                pos += TRACE_BINARY_WORDS(value);
+                break;
+            }
+            case TRACE_ARG_PTR: {
+                void *value = va_arg(ap, void *);
+                if (left < (int)TRACE_BINARY_WORDS(value)) {
+                    flags |= TRACE_BINARY_FLAG_TRUNCATED;
+                    goto done;
+                }
+                memcpy(&rec[pos], &value, sizeof(value));
+                pos += TRACE_BINARY_WORDS(value);
+                break;
+            }
+            case TRACE_ARG_STR: {
+                const char *value = va_arg(ap, const char *);
+                uint32_t len;
+                if (value == NULL) {
+                    value = "(null)";
+                }
+                if (left < 2) {
+                    flags |= TRACE_BINARY_FLAG_TRUNCATED;
+                    goto done;
+                }
+                // copy as much as fits, always leaving room for the NUL
+                len = strlen(value);
+                if (len > (uint32_t)(left - 1) * 4 - 1) {
+                    len = (left - 1) * 4 - 1;
+                    flags |= TRACE_BINARY_FLAG_TRUNCATED;
+                }
+                rec[pos++] = len;
+                rec[pos + len / 4] = 0;
+                memcpy(&rec[pos], value, len);
+                ((char *)&rec[pos])[len] = 0;
+                pos += (len + 1 + 3) / 4;
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+done:
+    rec[0] = pos | (dlevel << 8) | ((uint32_t)flags << 16) | ((uint32_t)TRACE_BINARY_MAGIC << 24);
+    return pos;
+}
+static void mbed_trace_binary_store(uint8_t dlevel, const char *grp, const char *fmt, va_list ap)
+{
+    uint32_t rec[TRACE_BINARY_RECORD_WORDS];
+    uint32_t size = mbed_trace_binary_encode(rec, dlevel, grp, fmt, ap);
+    uint32_t reserve, i;
+
+    do {
+        reserve = m_trace_binary.reserve;
+        if (reserve + size - m_trace_binary.tail > m_trace_binary.mask + 1) {
+            MBED_TRACE_ADD(&m_trace_binary.dropped, 1);
+            return;
+        }
+    } while (!MBED_TRACE_CAS(&m_trace_binary.reserve, reserve, reserve + size));
+
+    for (i = 0; i < size; i++) {
+        m_trace_binary.ring[(reserve + i) & m_trace_binary.mask] = rec[i];
+    }
+    MBED_TRACE_BARRIER();
+    MBED_TRACE_ADD(&m_trace_binary.commit, size);
+
+    if (!m_trace_binary.notified && m_trace_binary.notify_f) {
+        m_trace_binary.notified = 1;
+        m_trace_binary.notify_f();
+    }
+}
+/** take next complete record out of the ring, returns its size in words or 0 */
+static uint32_t mbed_trace_binary_next(uint32_t *rec, uint32_t max_words)
+{
+    uint32_t commit, tail, size, i;
+
+    commit = m_trace_binary.commit;
+    MBED_TRACE_BARRIER();
+    if (commit != m_trace_binary.reserve) {
+        return 0;
+    }
+    tail = m_trace_binary.tail;
+    if (tail == commit) {
+        return 0;
+    }
+    size = m_trace_binary.ring[tail & m_trace_binary.mask] & 0xFF;
+    if (size > max_words) {
+        return 0;
+    }
+    for (i = 0; i < size; i++) {
+        rec[i] = m_trace_binary.ring[(tail + i) & m_trace_binary.mask];
+    }
+    MBED_TRACE_BARRIER();
+    m_trace_binary.tail = tail + size;
+    return size;
+}
+/** format the trace text of one record, returns number of characters written */
+static int mbed_trace_binary_format(char *out, int len, const uint32_t *rec, uint32_t size)
+{
+    const char *fmt, *ptr;
+    char spec[32];
+    int pos = TRACE_BINARY_HEADER_WORDS + TRACE_BINARY_WORDS(char *) * 2;
+    int used = 0;
+
+    memcpy(&fmt, &rec[TRACE_BINARY_HEADER_WORDS + TRACE_BINARY_WORDS(char *)], sizeof(fmt));
+    ptr = fmt;
+    out[0] = 0;
+
+    while (*ptr && used < len - 1) {
+        const char *end;
+        trace_arg_t type;
+        int stars, retval, spec_len = 0;
+
+        if (*ptr != '%') {
+            out[used++] = *ptr++;
+            out[used] = 0;
+            continue;
+        }
+        end = mbed_trace_binary_spec(ptr + 1, &type, &stars);
+        if (type == TRACE_ARG_INVALID || end - ptr >= (int)sizeof(spec) - 20) {
+            break;
+        }
+        // copy the specification, replacing '*' with the stored values
+        for (; ptr < end; ptr++) {
+            if (*ptr == '*') {
+                int value;
+                if (pos + 1 > (int)size) {
+                    return used;
+                }
+                memcpy(&value, &rec[pos++], sizeof(value));
+                spec_len += snprintf(&spec[spec_len], sizeof(spec) - spec_len, "%d", value);
+            } else {
+                spec[spec_len++] = *ptr;
+            }
+        }
+        spec[spec_len] = 0;
+
+        retval = 0;
+        switch (type) {
+            case TRACE_ARG_NONE:
+                retval = snprintf(&out[used], len - used, "%%");
+                break;
+#define TRACE_BINARY_FORMAT_ARG(argtype) { \
+                argtype value; \
+                if (pos + (int)TRACE_BINARY_WORDS(value) > (int)size) { \
+                    return used; \
+                } \
+                memcpy(&value, &rec[pos], sizeof(value)); \
+                pos += TRACE_BINARY_WORDS(value); \
+                retval = snprintf(&out[used], len - used, spec, value); \
+                break; \
+            }
+            case TRACE_ARG_INT:
+                TRACE_BINARY_FORMAT_ARG(int)
+            case TRACE_ARG_LONG:
+                TRACE_BINARY_FORMAT_ARG(long)
+            case TRACE_ARG_LLONG:
+                TRACE_BINARY_FORMAT_ARG(long long)
+            case TRACE_ARG_SIZE:
+                TRACE_BINARY_FORMAT_ARG(size_t)
+            case TRACE_ARG_PTR:
+                if (end[-1] == 'n') {
+                    // nothing to write back to
+                    pos += TRACE_BINARY_WORDS(void *);
+                    break;
+                }
+                TRACE_BINARY_FORMAT_ARG(void *)
+#undef TRACE_BINARY_FORMAT_ARG
+            case TRACE_ARG_DOUBLE: {
+                double value;
+                if (pos + (int)TRACE_BINARY_WORDS(value) > (int)size) {
+                    return used;
+                }
+                memcpy(&value, &rec[pos], sizeof(value));
+                pos += TRACE_BINARY_WORDS(value);
+                if (end[-2] == 'L') {
+                    retval = snprintf(&out[used], len - used, spec, (long double)value);
+                } else {
+                    retval = snprintf(&out[used], len - used, spec, value);
+                }
+                break;
+            }
+            case TRACE_ARG_STR: {
+                uint32_t slen;
+                if (pos + 1 > (int)size) {
+                    return used;
+                }
+                slen = rec[pos++];
+                if (pos + (int)((slen + 1 + 3) / 4) > (int)size) {
+                    return used;
+                }
+                retval = snprintf(&out[used], len - used, spec, (const char *)&rec[pos]);
+                pos += (slen + 1 + 3) / 4;
+                break;
+            }
+            default:
+                break;
+        }
+        if (retval < 0) {
+            break;
+        }
+        used += retval;
+        if (used >= len) {
+            used = len - 1;
+        }
+    }
+    return used;
+}
+int mbed_trace_binary_mode_set(int buffer_size)
+{
+    uint32_t words = 1;
+
+    MBED_TRACE_MEM_FREE(m_trace_binary.ring);
+    MBED_TRACE_MEM_FREE(m_trace_binary.text);
+    MBED_TRACE_MEM_FREE(m_trace_binary.line);
+    m_trace_binary.ring = 0;
+    m_trace_binary.text = 0;
+    m_trace_binary.line = 0;
+    m_trace_binary.mask = 0;
+    m_trace_binary.reserve = 0;
+    m_trace_binary.commit = 0;
+    m_trace_binary.tail = 0;
+    m_trace_binary.dropped = 0;
+    m_trace_binary.notified = 0;
+
+    if (buffer_size <= 0) {
+        return 0;
+    }
+
+    // round down to a power of two, at least one full size record
+    while (words * 2 <= (uint32_t)buffer_size / 4) {
+        words *= 2;
+    }
+    if (words < TRACE_BINARY_RECORD_WORDS) {
+        return -1;
+    }
+
+    m_trace_binary.line_length = m_trace.line_length ? m_trace.line_length : DEFAULT_TRACE_LINE_LENGTH;
+    m_trace_binary.text = MBED_TRACE_MEM_ALLOC(m_trace_binary.line_length);
+    m_trace_binary.line = MBED_TRACE_MEM_ALLOC(m_trace_binary.line_length);
+    m_trace_binary.mask = words - 1;
+    m_trace_binary.ring = MBED_TRACE_MEM_ALLOC(words * 4);
+    if (m_trace_binary.ring == NULL ||
+            m_trace_binary.text == NULL ||
+            m_trace_binary.line == NULL) {
+        //memory allocation fail
+        mbed_trace_binary_mode_set(0);
+        return -1;
+    }
+    return 0;
+}
+int mbed_trace_binary_flush(void)
+{
+    uint32_t rec[TRACE_BINARY_RECORD_WORDS];
+    uint32_t size;
+    int count = 0;
+
+    if (NULL == m_trace_binary.ring || !m_trace.printf) {
+        return 0;
+    }
+
+    // traces stored from now on must notify again
+    m_trace_binary.notified = 0;
+
+    while ((size = mbed_trace_binary_next(rec, TRACE_BINARY_RECORD_WORDS)) != 0) {
+        const char *grp;
+        uint8_t dlevel = (rec[0] >> 8) & 0xFF;
+        memcpy(&grp, &rec[TRACE_BINARY_HEADER_WORDS], sizeof(grp));
+        mbed_trace_binary_format(m_trace_binary.text, m_trace_binary.line_length, rec, size);
+        mbed_trace_line(m_trace_binary.line, m_trace_binary.line_length, dlevel, grp, "%s", m_trace_binary.text);
+        count++;
+    }
+    return count;
+}
+int mbed_trace_binary_read(uint8_t *buf, int len)
+{
+    uint32_t rec[TRACE_BINARY_RECORD_WORDS];
+    uint32_t size;
+    int used = 0;
+
+    if (NULL == m_trace_binary.ring) {
+        return 0;
+    }
+
+    m_trace_binary.notified = 0;
+
+    while (len - used >= 4) {
+        uint32_t max_words = (len - used) / 4;
+        if (max_words > TRACE_BINARY_RECORD_WORDS) {
+            max_words = TRACE_BINARY_RECORD_WORDS;
+        }
+        size = mbed_trace_binary_next(rec, max_words);
+        if (size == 0) {
+            break;
+        }
+        memcpy(&buf[used], rec, size * 4);
+        used += size * 4;
+    }
+    return used;
+}
+uint32_t mbed_trace_binary_dropped(void)
+{
+    return m_trace_binary.dropped;
+}
+void mbed_trace_binary_notify_function_set(void (*notify_f)(void))
+{
+    m_trace_binary.notify_f = notify_f;
+}
+void mbed_trace_binary_timestamp_function_set(uint32_t (*timestamp_f)(void))
+{
+    m_trace_binary.timestamp_f = timestamp_f;
+}
@@ -9,6 +9,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <time.h>
 
 #include "mbed-cpputest/CppUTest/TestHarness.h"
 #include "mbed-cpputest/CppUTest/SimpleString.h"
@@ -429,3 +430,182 @@ TEST(trace, uninitialized)
     STRCMP_EQUAL("hello", buf);
 }
 
+static int notify_count = 0;
+void my_notify()
+{
+  notify_count++;
+}
+TEST(trace, binary_deferred)
+{
+    CHECK(mbed_trace_binary_mode_set(1024) == 0);
+    strcpy(buf, "nothing yet");
+
+    mbed_tracef(TRACE_LEVEL_DEBUG, "mygr", "hello %d %s %.1f %lld %c %04x %%", -12, "world", 5.5, 1LL << 40, 'z', 0xab);
+    STRCMP_EQUAL("nothing yet", buf);
+
+    check_mutex_lock_status = false;
+    CHECK(mbed_trace_binary_flush() == 1);
+    STRCMP_EQUAL("hello -12 world 5.5 1099511627776 z 00ab %", buf);
+    CHECK(mbed_trace_binary_flush() == 0);
+    check_mutex_lock_status = true;
+}
+TEST(trace, binary_headers)
+{
+    mbed_trace_config_set(TRACE_ACTIVE_LEVEL_ALL|TRACE_MODE_COLOR);
+    mbed_trace_binary_mode_set(1024);
+
+    mbed_tracef(TRACE_LEVEL_ERROR, "mygr", "%*d|%-5s|%.*f", 4, 7, "ab", 2, 3.14159);
+    mbed_tracef(TRACE_LEVEL_INFO, "grp2", "second");
+
+    check_mutex_lock_status = false;
+    CHECK(mbed_trace_binary_flush() == 2);
+    STRCMP_EQUAL("\x1b[39m[INFO][grp2]: second\x1b[0m", buf);
+    check_mutex_lock_status = true;
+    mbed_trace_binary_mode_set(0);
+
+    // same line in text mode
+    mbed_tracef(TRACE_LEVEL_ERROR, "mygr", "%*d|%-5s|%.*f", 4, 7, "ab", 2, 3.14159);
+    STRCMP_EQUAL("\x1b[31m[ERR ][mygr]:    7|ab   |3.14\x1b[0m", buf);
+}
+TEST(trace, binary_helpers_copied)
+{
+    uint8_t arr[3] = {1, 2, 3};
+    mbed_trace_binary_mode_set(1024);
+
+    mbed_tracef(TRACE_LEVEL_DEBUG, "mygr", "arr: %s", mbed_trace_array(arr, 3));
+    // overwrite the temporary buffer the helper returned
+    mbed_tracef(TRACE_LEVEL_DEBUG, "mygr", "arr: %s", mbed_trace_array(arr, 1));
+
+    check_mutex_lock_status = false;
+    CHECK(mbed_trace_binary_flush() == 2);
+    STRCMP_EQUAL("arr: 01", buf);
+    check_mutex_lock_status = true;
+}
+TEST(trace, binary_long_string)
+{
+    char longStr[1000];
+    memset(longStr, 0x36, sizeof(longStr));
+    longStr[999] = 0;
+    mbed_trace_binary_mode_set(1024);
+
+    mbed_tracef(TRACE_LEVEL_DEBUG, "mygr", "%s", longStr);
+
+    check_mutex_lock_status = false;
+    CHECK(mbed_trace_binary_flush() == 1);
+    check_mutex_lock_status = true;
+    // truncated to fit the record
+    CHECK(strlen(buf) > 100 && strlen(buf) < 200);
+    CHECK(strspn(buf, "6") == strlen(buf));
+}
+TEST(trace, binary_cmdline_not_deferred)
+{
+    mbed_trace_binary_mode_set(1024);
+    mbed_tracef(TRACE_LEVEL_CMD, "mygr", "cmd %d", 1);
+    STRCMP_EQUAL("cmd 1", buf);
+    CHECK(mbed_trace_binary_flush() == 0);
+}
+TEST(trace, binary_overflow)
+{
+    int i, printed;
+    mbed_trace_binary_mode_set(256);
+
+    for (i = 0; i < 50; i++) {
+        mbed_tracef(TRACE_LEVEL_DEBUG, "mygr", "trace %d", i);
+    }
+    CHECK(mbed_trace_binary_dropped() > 0);
+
+    check_mutex_lock_status = false;
+    printed = mbed_trace_binary_flush();
+    check_mutex_lock_status = true;
+    CHECK(printed > 0);
+    CHECK(printed + (int)mbed_trace_binary_dropped() == 50);
+
+    // room again after flush
+    mbed_tracef(TRACE_LEVEL_DEBUG, "mygr", "trace %d", 50);
+    check_mutex_lock_status = false;
+    CHECK(mbed_trace_binary_flush() == 1);
+    check_mutex_lock_status = true;
+    STRCMP_EQUAL("trace 50", buf);
+}
+TEST(trace, binary_notify)
+{
+    notify_count = 0;
+    mbed_trace_binary_mode_set(1024);
+    mbed_trace_binary_notify_function_set(my_notify);
+
+    mbed_tracef(TRACE_LEVEL_DEBUG, "mygr", "one");
+    mbed_tracef(TRACE_LEVEL_DEBUG, "mygr", "two");
+    CHECK(notify_count == 1);
+
+    check_mutex_lock_status = false;
+    mbed_trace_binary_flush();
+    check_mutex_lock_status = true;
+    mbed_tracef(TRACE_LEVEL_DEBUG, "mygr", "three");
+    CHECK(notify_count == 2);
+    mbed_trace_binary_notify_function_set(0);
+}
+TEST(trace, binary_read_records)
+{
+    static const char fmt[] = "value %d";
+    uint32_t records[64];
+    const char *ptr;
+    int len;
+
+    mbed_trace_binary_mode_set(1024);
+    mbed_tracef(TRACE_LEVEL_WARN, "mygr", fmt, 42);
+    mbed_tracef(TRACE_LEVEL_WARN, "mygr", fmt, 43);
+
+    len = mbed_trace_binary_read((uint8_t *)records, sizeof(records));
+    int words = records[0] & 0xff;
+    CHECK(len == words * 8);
+    CHECK((records[0] >> 24) == 0xB5);
+    CHECK(((records[0] >> 8) & 0xff) == TRACE_LEVEL_WARN);
+    memcpy(&ptr, &records[2 + sizeof(ptr) / 4], sizeof(ptr));
+    POINTERS_EQUAL(fmt, ptr);
+    CHECK((int)records[words - 1] == 42);
+    CHECK((int)records[2 * words - 1] == 43);
+    CHECK(mbed_trace_binary_read((uint8_t *)records, sizeof(records)) == 0);
+}
+static void null_print(const char *str)
+{
+  (void)str;
+}
+static double elapsed_ns(const struct timespec *start)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (now.tv_sec - start->tv_sec) * 1e9 + (now.tv_nsec - start->tv_nsec);
+}
+TEST(trace, binary_call_time)
+{
+    #define BENCH_TRACES 20000
+    struct timespec start;
+    double text_ns, binary_ns, flush_ns;
+    int i;
+
+    mbed_trace_config_set(TRACE_ACTIVE_LEVEL_ALL|TRACE_MODE_COLOR);
+    mbed_trace_print_function_set(null_print);
+    mbed_trace_mutex_wait_function_set(0);
+    mbed_trace_mutex_release_function_set(0);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < BENCH_TRACES; i++) {
+        mbed_tracef(TRACE_LEVEL_INFO, "mygr", "rx frame %d len %u rssi %d from %s", i, 127u, -70, "fe80::1");
+    }
+    text_ns = elapsed_ns(&start) / BENCH_TRACES;
+
+    mbed_trace_binary_mode_set(BENCH_TRACES * 64);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < BENCH_TRACES; i++) {
+        mbed_tracef(TRACE_LEVEL_INFO, "mygr", "rx frame %d len %u rssi %d from %s", i, 127u, -70, "fe80::1");
+    }
+    binary_ns = elapsed_ns(&start) / BENCH_TRACES;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    CHECK(mbed_trace_binary_flush() == BENCH_TRACES);
+    flush_ns = elapsed_ns(&start) / BENCH_TRACES;
+
+    printf("trace call: text %.0f ns, binary %.0f ns (+%.0f ns deferred formatting)\n",
+           text_ns, binary_ns, flush_ns);
+    CHECK(mbed_trace_binary_dropped() == 0);
+}
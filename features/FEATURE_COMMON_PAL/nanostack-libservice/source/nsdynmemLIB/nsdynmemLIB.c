@@ -40,7 +40,16 @@ typedef struct {
     ns_list_link_t link;
 } hole_t;
 
-static NS_LIST_DEFINE(holes_list, hole_t, link);
+typedef NS_LIST_HEAD(hole_t, link) hole_list_t;
+
+// Free blocks big enough to hold a hole_t are kept in segregated size bins.
+// Each power of two of the data size (in words) is split into two bins, so
+// 32 bins cover any 16-bit heap. Each bin is sorted by address, and
+// hole_bin_map has a bit set for every bin that isn't empty.
+#define HOLE_BIN_COUNT 32
+
+static hole_list_t hole_bins[HOLE_BIN_COUNT];
+static uint32_t hole_bin_map;
 
 // size of a hole_t in our word units
 #define HOLE_T_SIZE ((sizeof(hole_t) + sizeof(int) - 1) / sizeof(int))
@@ -63,6 +72,117 @@ static void heap_failure(heap_fail_t reason)
     }
 }
 
+// Index of the highest set bit, value must not be 0
+static NS_INLINE uint_fast8_t highest_bit(uint32_t value)
+{
+#ifdef  __CC_ARM
+    return 31 - __clz(value);
+#elif defined __GNUC__
+    return 31 - __builtin_clz(value);
+#else
+    uint_fast8_t bit = 0;
+    if (value & 0xFFFF0000) {
+        value >>= 16;
+        bit += 16;
+    }
+    if (value & 0xFF00) {
+        value >>= 8;
+        bit += 8;
+    }
+    if (value & 0xF0) {
+        value >>= 4;
+        bit += 4;
+    }
+    if (value & 0xC) {
+        value >>= 2;
+        bit += 2;
+    }
+    if (value & 0x2) {
+        bit += 1;
+    }
+    return bit;
+#endif
+}
+
+// Bin holding holes of data size "size" words: sizes 2^n to 2^n + 2^(n-1) - 1
+// go to bin 2n - 1, and the upper half of the range to bin 2n
+static uint_fast8_t hole_bin(int size)
+{
+    uint_fast8_t log2 = highest_bit(size);
+    if (log2 == 0) {
+        return 0;
+    }
+    return 2 * log2 - 1 + ((size >> (log2 - 1)) & 1);
+}
+
+static void hole_insert(hole_t *hole, int size)
+{
+    uint_fast8_t bin = hole_bin(size);
+    hole_list_t *list = &hole_bins[bin];
+
+    // Temporary allocations are made from the bottom of the heap and long
+    // period ones from the top, so walk from the end of the heap nearer to
+    // the hole to find its place.
+    if ((int *)hole - heap_main < heap_main_end - (int *)hole) {
+        hole_t *before = NULL;
+        ns_list_foreach(hole_t, ptr, list) {
+            if (ptr > hole) {
+                before = ptr;
+                break;
+            }
+        }
+        if (before) {
+            ns_list_add_before(list, before, hole);
+        } else {
+            ns_list_add_to_end(list, hole);
+        }
+    } else {
+        hole_t *after = NULL;
+        ns_list_foreach_reverse(hole_t, ptr, list) {
+            if (ptr < hole) {
+                after = ptr;
+                break;
+            }
+        }
+        if (after) {
+            ns_list_add_after(list, after, hole);
+        } else {
+            ns_list_add_to_start(list, hole);
+        }
+    }
+    hole_bin_map |= (uint32_t)1 << bin;
+}
+
+static void hole_remove(hole_t *hole, int size)
+{
+    uint_fast8_t bin = hole_bin(size);
+    ns_list_remove(&hole_bins[bin], hole);
+    if (ns_list_is_empty(&hole_bins[bin])) {
+        hole_bin_map &= ~((uint32_t)1 << bin);
+    }
+}
+
+// Replace the descriptor of a hole that is shrinking or growing. No other
+// hole lies between the old and new position, so if the size stays in the
+// same bin the new descriptor simply takes the old one's place in the list.
+// The descriptors may overlap, so the old one is removed first.
+static void hole_move(hole_t *from, int from_size, hole_t *to, int to_size)
+{
+    uint_fast8_t bin = hole_bin(from_size);
+    if (bin == hole_bin(to_size)) {
+        hole_t *next = ns_list_get_next(&hole_bins[bin], from);
+        ns_list_remove(&hole_bins[bin], from);
+        if (next) {
+            ns_list_add_before(&hole_bins[bin], next, to);
+        } else {
+            ns_list_add_to_end(&hole_bins[bin], to);
+        }
+    } else {
+        hole_remove(from, from_size);
+        hole_insert(to, to_size);
+    }
+}
+
 #endif
 
 void ns_dyn_mem_init(uint8_t *heap, uint16_t h_size, void (*passed_fptr)(heap_fail_t), mem_stat_t *info_ptr)
@@ -92,8 +212,11 @@ void ns_dyn_mem_init(uint8_t *heap, uint16_t h_size, void (*passed_fptr)(heap_fa
     *ptr = -(temp_int);
     heap_main_end = ptr;
 
-    ns_list_init(&holes_list);
-    ns_list_add_to_start(&holes_list, hole_from_block_start(heap_main));
+    for (int i = 0; i < HOLE_BIN_COUNT; i++) {
+        ns_list_init(&hole_bins[i]);
+    }
+    hole_bin_map = 0;
+    hole_insert(hole_from_block_start(heap_main), temp_int);
 
     //RESET Memory by Hea Len
     if (info_ptr) {
@@ -180,51 +303,67 @@ static void *ns_dyn_mem_internal_alloc(const int16_t alloc_size, int direction)
         goto done;
     }
 
-    // ns_list_foreach, either forwards or backwards, result to ptr
-    for (hole_t *cur_hole = direction > 0 ? ns_list_get_first(&holes_list)
-                                          : ns_list_get_last(&holes_list);
-         cur_hole;
-         cur_hole = direction > 0 ? ns_list_get_next(&holes_list, cur_hole)
-                                  : ns_list_get_previous(&holes_list, cur_hole)
+    // First fit from the bottom of the heap for temporary data and from the
+    // top otherwise. Every hole in a bigger bin fits and the bins are sorted
+    // by address, so the first fit is the first hole of one of those bins
+    // unless a hole of the requested size's own bin comes before it.
+    uint_fast8_t bin = hole_bin(data_size);
+    hole_t *found = NULL;
+    uint32_t bigger = hole_bin_map & ~(((uint32_t)2 << bin) - 1);
+    while (bigger) {
+        uint_fast8_t cur_bin = highest_bit(bigger & -bigger);
+        hole_t *cur_hole = direction > 0 ? ns_list_get_first(&hole_bins[cur_bin])
+                                         : ns_list_get_last(&hole_bins[cur_bin]);
+        if (!found || (direction > 0 ? cur_hole < found : cur_hole > found)) {
+            found = cur_hole;
+        }
+        bigger &= bigger - 1;
+    }
+
+    for (hole_t *cur_hole = direction > 0 ? ns_list_get_first(&hole_bins[bin])
+                                          : ns_list_get_last(&hole_bins[bin]);
+         cur_hole && (!found || (direction > 0 ? cur_hole < found : cur_hole > found));
+         cur_hole = direction > 0 ? ns_list_get_next(&hole_bins[bin], cur_hole)
+                                  : ns_list_get_previous(&hole_bins[bin], cur_hole)
         ) {
         int *p = block_start_from_hole(cur_hole);
         if (ns_block_validate(p, direction) != 0 || *p >= 0) {
             //Validation failed, or this supposed hole has positive (allocated) size
             heap_failure(NS_DYN_MEM_HEAP_SECTOR_CORRUPTED);
-            break;
+            goto done;
         }
         if (-*p >= data_size) {
             // Found a big enough block
-            block_ptr = p;
+            found = cur_hole;
             break;
         }
     }
 
-    if (!block_ptr) {
+    if (!found) {
         goto done;
     }
 
+    if (ns_block_validate(block_start_from_hole(found), direction) != 0 || *block_start_from_hole(found) >= 0) {
+        heap_failure(NS_DYN_MEM_HEAP_SECTOR_CORRUPTED);
+        goto done;
+    }
+    block_ptr = block_start_from_hole(found);
+
     int block_data_size = -*block_ptr;
     if (block_data_size >= (data_size + 2 + HOLE_T_SIZE)) {
         int hole_size = block_data_size - data_size - 2;
         int *hole_ptr;
         //There is enough room for a new hole so create it first
         if ( direction > 0 ) {
-            hole_ptr = block_ptr + 1 + data_size + 1;
             // Hole will be left at end of area.
-            // Would like to just replace this block_ptr with new descriptor, but
-            // they could overlap, so ns_list_replace might fail
-            //ns_list_replace(&holes_list, block_ptr, hole_from_block_start(hole_ptr));
-            hole_t *before = ns_list_get_previous(&holes_list, hole_from_block_start(block_ptr));
-            ns_list_remove(&holes_list, hole_from_block_start(block_ptr));
-            if (before) {
-                ns_list_add_after(&holes_list, before, hole_from_block_start(hole_ptr));
-            } else {
-                ns_list_add_to_start(&holes_list, hole_from_block_start(hole_ptr));
-            }
+            hole_ptr = block_ptr + 1 + data_size + 1;
         } else {
-            hole_ptr = block_ptr;
             // Hole remains at start of area - keep existing descriptor in place.
+            hole_ptr = block_ptr;
+        }
+        hole_move(hole_from_block_start(block_ptr), block_data_size,
+                  hole_from_block_start(hole_ptr), hole_size);
+        if (direction < 0) {
             block_ptr += 1 + hole_size + 1;
         }
 
@@ -233,7 +372,7 @@ static void *ns_dyn_mem_internal_alloc(const int16_t alloc_size, int direction)
     } else {
         // Not enough room for a left-over hole, so use the whole block
         data_size = block_data_size;
-        ns_list_remove(&holes_list, hole_from_block_start(block_ptr));
+        hole_remove(hole_from_block_start(block_ptr), block_data_size);
     }
     block_ptr[0] = data_size;
     block_ptr[1 + data_size] = data_size;
@@ -283,6 +422,8 @@ static void ns_free_and_merge_with_adjacent_blocks(int *cur_block, int data_size
 
     hole_t *existing_start = NULL;
     hole_t *existing_end = NULL;
+    int existing_start_size = 0;
+    int existing_end_size = 0;
     int *start = cur_block;
     int *end = cur_block + data_size + 1;
     //invalidate current block
@@ -297,6 +438,7 @@ static void ns_free_and_merge_with_adjacent_blocks(int *cur_block, int data_size
             start -= (2 - *cur_block);
             if (-*start >= HOLE_T_SIZE) {
                 existing_start = hole_from_block_start(start);
+                existing_start_size = -*start;
             }
         }
         cur_block++;
@@ -308,6 +450,7 @@ static void ns_free_and_merge_with_adjacent_blocks(int *cur_block, int data_size
             merged_data_size += (2 - *end);
             if (-*end >= HOLE_T_SIZE) {
                 existing_end = hole_from_block_start(end);
+                existing_end_size = -*end;
             }
             end += (1 - *end);
         }else{
@@ -315,41 +458,19 @@ static void ns_free_and_merge_with_adjacent_blocks(int *cur_block, int data_size
         }
     }
 
+    // The merged hole is described by a descriptor at its bottom. Adjacent
+    // holes change size, so their descriptors move to the bin of the merged
+    // size; small blocks without descriptors are simply absorbed.
     hole_t *to_add = hole_from_block_start(start);
-    hole_t *before = NULL;
-    if (existing_end) {
-        // Extending hole described by "existing_end" downwards.
-        // Will replace with descriptor at bottom of merged block.
-        // (Can't use ns_list_replace, because of danger of overlap)
-        // Optimisation - note our position for insertion below.
-        before = ns_list_get_next(&holes_list, existing_end);
-        ns_list_remove(&holes_list, existing_end);
-    }
     if (existing_start) {
-        // Extending hole described by "existing_start" upwards.
-        // No need to modify that descriptor - it remains at the bottom
-        // of the merged block to describe it.
-    } else {
-        // Didn't find adjacent descriptors, but may still
-        // be merging with small blocks without descriptors.
-        if ( merged_data_size >= HOLE_T_SIZE ) {
-            // Locate hole position in list, if we don't already know
-            // from merging with the block above.
-            if (!existing_end) {
-                ns_list_foreach(hole_t, ptr, &holes_list) {
-                    if (ptr > to_add) {
-                        before = ptr;
-                        break;
-                    }
-                }
-            }
-            if (before) {
-                ns_list_add_before(&holes_list, before, to_add);
-            } else {
-                ns_list_add_to_end(&holes_list, to_add);
-            }
-
+        if (existing_end) {
+            hole_remove(existing_end, existing_end_size);
         }
+        hole_move(existing_start, existing_start_size, to_add, merged_data_size);
+    } else if (existing_end) {
+        hole_move(existing_end, existing_end_size, to_add, merged_data_size);
+    } else if (merged_data_size >= HOLE_T_SIZE) {
+        hole_insert(to_add, merged_data_size);
     }
     *start = -merged_data_size;
     *end = -merged_data_size;
@@ -189,6 +189,45 @@ TEST(dynmem, test_temp_alloc_with_skipping_hole) {
     free(heap);
 }
 
+TEST(dynmem, alloc_directions_with_many_holes)
+{
+    uint16_t size = 4000;
+    mem_stat_t info;
+    void *p[40];
+    uint8_t *heap = (uint8_t*)malloc(size);
+    CHECK(NULL != heap);
+    reset_heap_error();
+    ns_dyn_mem_init(heap, size, &heap_fail_callback, &info);
+    CHECK(!heap_have_failed());
+
+    // Leave holes of different sizes at both ends of the heap
+    for (int i = 0; i < 20; i++) {
+        p[i] = ns_dyn_mem_temporary_alloc(8 + 4 * i);
+        p[20 + i] = ns_dyn_mem_alloc(8 + 4 * i);
+        CHECK(p[i] && p[20 + i]);
+    }
+    for (int i = 0; i < 40; i += 2) {
+        ns_dyn_mem_free(p[i]);
+    }
+
+    // Small temporary data goes to the lowest hole that fits and long period
+    // data to the highest one
+    void *temp = ns_dyn_mem_temporary_alloc(40);
+    void *keep = ns_dyn_mem_alloc(40);
+    CHECK(temp == p[8]);
+    CHECK(keep == p[28]);
+    ns_dyn_mem_free(temp);
+    ns_dyn_mem_free(keep);
+
+    for (int i = 1; i < 40; i += 2) {
+        ns_dyn_mem_free(p[i]);
+    }
+    CHECK(!heap_have_failed());
+    CHECK(info.heap_sector_alloc_cnt == 0);
+    CHECK(ns_dyn_mem_temporary_alloc(size - 16));
+    free(heap);
+}
+
 TEST(dynmem, zero_allocate)
 {
     uint16_t size = 1000;
@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "CppUTest/TestHarness.h"
+#include "nsdynmemLIB.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "error_callback.h"
+
+/*
+ * Replays an allocation trace against the heap and reports the time taken
+ * per operation. The trace is read from the file named by the NSDYNMEM_TRACE
+ * environment variable, one operation per line:
+ *
+ *     a <slot> <size>    ns_dyn_mem_alloc()
+ *     t <slot> <size>    ns_dyn_mem_temporary_alloc()
+ *     f <slot>           ns_dyn_mem_free()
+ *
+ * Without it a trace resembling a busy border router is generated: long
+ * period routing and neighbour entries that come and go slowly, and packet
+ * buffers that are freed soon after being allocated.
+ */
+
+#define TRACE_HEAP_SIZE     65000
+#define TRACE_SLOTS         640
+#define TRACE_LONG_SLOTS    512
+#define TRACE_OPERATIONS    200000
+
+typedef struct {
+    char op;
+    uint16_t slot;
+    int16_t size;
+} trace_op_t;
+
+static trace_op_t *trace;
+static int trace_length;
+
+static void trace_add(char op, int slot, int size)
+{
+    trace[trace_length].op = op;
+    trace[trace_length].slot = slot;
+    trace[trace_length].size = size;
+    trace_length++;
+}
+
+static bool trace_load(const char *file)
+{
+    FILE *f = fopen(file, "r");
+    char op;
+    int slot;
+    int size;
+
+    if (!f) {
+        return false;
+    }
+    while (trace_length < TRACE_OPERATIONS && fscanf(f, " %c %d", &op, &slot) == 2) {
+        size = 0;
+        if (op != 'f' && fscanf(f, "%d", &size) != 1) {
+            break;
+        }
+        if (slot >= 0 && slot < TRACE_SLOTS) {
+            trace_add(op, slot, size);
+        }
+    }
+    fclose(f);
+    return trace_length > 0;
+}
+
+static void trace_generate(void)
+{
+    bool live[TRACE_SLOTS];
+    memset(live, 0, sizeof(live));
+    srand(1);
+
+    while (trace_length < TRACE_OPERATIONS) {
+        int slot;
+        if (rand() % 16 == 0) {
+            // Routing and neighbour entries, CoAP resources
+            slot = rand() % TRACE_LONG_SLOTS;
+            if (live[slot]) {
+                trace_add('f', slot, 0);
+            } else {
+                trace_add('a', slot, 16 + rand() % 112);
+            }
+        } else {
+            // Packet buffers, from 6LoWPAN frames up to IPv6 MTU
+            slot = TRACE_LONG_SLOTS + rand() % (TRACE_SLOTS - TRACE_LONG_SLOTS);
+            if (live[slot]) {
+                trace_add('f', slot, 0);
+            } else {
+                trace_add('t', slot, rand() % 4 ? 40 + rand() % 100 : 200 + rand() % 1080);
+            }
+        }
+        live[slot] = !live[slot];
+    }
+}
+
+static uint32_t elapsed_ns(const struct timespec *start, const struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) * 1000000000UL + end->tv_nsec - start->tv_nsec;
+}
+
+static int compare_ns(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+TEST_GROUP(dynmem_trace)
+{
+    void setup() {
+        reset_heap_error();
+        trace = (trace_op_t *)malloc(TRACE_OPERATIONS * sizeof(trace_op_t));
+        trace_length = 0;
+    }
+
+    void teardown() {
+        free(trace);
+    }
+};
+
+TEST(dynmem_trace, replay)
+{
+    mem_stat_t info;
+    uint8_t *heap = (uint8_t*)malloc(TRACE_HEAP_SIZE);
+    void *p[TRACE_SLOTS];
+    int16_t size[TRACE_SLOTS];
+    CHECK(NULL != heap);
+    memset(p, 0, sizeof(p));
+
+    const char *file = getenv("NSDYNMEM_TRACE");
+    if (!file || !trace_load(file)) {
+        trace_generate();
+    }
+
+    ns_dyn_mem_init(heap, TRACE_HEAP_SIZE, &heap_fail_callback, &info);
+    CHECK(!heap_have_failed());
+
+    uint32_t *op_ns = (uint32_t *)malloc(trace_length * sizeof(uint32_t));
+    uint64_t total_ns = 0;
+    int ops = 0;
+    for (int i = 0; i < trace_length; i++) {
+        trace_op_t *op = &trace[i];
+        struct timespec start, end;
+        if (op->op == 'f') {
+            if (!p[op->slot]) {
+                continue;
+            }
+            for (int j = 0; j < size[op->slot]; j++) {
+                CHECK(((uint8_t *)p[op->slot])[j] == (uint8_t)op->slot);
+            }
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            ns_dyn_mem_free(p[op->slot]);
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            p[op->slot] = NULL;
+        } else {
+            if (p[op->slot]) {
+                ns_dyn_mem_free(p[op->slot]);
+            }
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            if (op->op == 't') {
+                p[op->slot] = ns_dyn_mem_temporary_alloc(op->size);
+            } else {
+                p[op->slot] = ns_dyn_mem_alloc(op->size);
+            }
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            if (p[op->slot]) {
+                size[op->slot] = op->size;
+                memset(p[op->slot], op->slot, op->size);
+            }
+        }
+        op_ns[ops] = elapsed_ns(&start, &end);
+        total_ns += op_ns[ops++];
+    }
+    CHECK(!heap_have_failed());
+
+    // Timer overhead is included, and the slowest few are mostly preemption
+    qsort(op_ns, ops, sizeof(uint32_t), compare_ns);
+    printf("\nreplayed %d operations: %lu ns average, %lu ns 99%%, %lu ns 99.9%%, %lu allocations failed\n",
+           ops, (unsigned long)(total_ns / ops), (unsigned long)op_ns[ops * 99 / 100],
+           (unsigned long)op_ns[ops * 999 / 1000], (unsigned long)info.heap_alloc_fail_cnt);
+    free(op_ns);
+
+    // Everything merges back into a single hole, which takes two blocks of
+    // almost half the heap
+    for (int i = 0; i < TRACE_SLOTS; i++) {
+        ns_dyn_mem_free(p[i]);
+    }
+    CHECK(!heap_have_failed());
+    CHECK(info.heap_sector_alloc_cnt == 0);
+    void *low = ns_dyn_mem_temporary_alloc(TRACE_HEAP_SIZE / 2 - 64);
+    void *high = ns_dyn_mem_alloc(TRACE_HEAP_SIZE / 2 - 64);
+    CHECK(low != NULL && high != NULL && low < high);
+    ns_dyn_mem_free(low);
+    ns_dyn_mem_free(high);
+    free(heap);
+}
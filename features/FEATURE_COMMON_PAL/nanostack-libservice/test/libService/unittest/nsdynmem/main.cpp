@@ -24,3 +24,4 @@ int main(int ac, char **av)
 }
 
 IMPORT_TEST_GROUP(dynmem);
+IMPORT_TEST_GROUP(dynmem_trace);
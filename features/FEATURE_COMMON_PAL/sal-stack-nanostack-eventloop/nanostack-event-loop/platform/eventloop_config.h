@@ -21,6 +21,7 @@
  */
 #undef NS_EVENTLOOP_USE_TICK_TIMER
 #undef NS_EXCLUDE_HIGHRES_TIMER
+#undef NS_EVENTLOOP_TICKLESS
 
 /*
  * mbedOS 5 specific configuration flag mapping to internal flags
@@ -33,6 +34,10 @@
 #define NS_EXCLUDE_HIGHRES_TIMER        1
 #endif
 
+#ifdef MBED_CONF_NANOSTACK_EVENTLOOP_TICKLESS
+#define NS_EVENTLOOP_TICKLESS           1
+#endif
+
 /*
  * For mbedOS 3 and minar use platform tick timer by default, highres timers should come from eventloop adaptor
  */
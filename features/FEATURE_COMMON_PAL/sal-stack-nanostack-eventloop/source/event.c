@@ -36,8 +36,15 @@ typedef struct arm_core_event_s {
     ns_list_link_t link;
 } arm_core_event_s;
 
+typedef NS_LIST_HEAD(arm_core_event_s, link) event_queue_t;
+
+/* One FIFO per priority level; bit n of event_queue_map is set when
+ * event_queue_active[n] is not empty */
+#define EVENT_PRIORITY_COUNT (ARM_LIB_LOW_PRIORITY_EVENT + 1)
+
 static NS_LIST_DEFINE(arm_core_tasklet_list, arm_core_tasklet_list_s, link);
-static NS_LIST_DEFINE(event_queue_active, arm_core_event_s, link);
+static event_queue_t event_queue_active[EVENT_PRIORITY_COUNT];
+static uint8_t event_queue_map;
 static NS_LIST_DEFINE(free_event_entry, arm_core_event_s, link);
 
 /** Curr_tasklet tell to core and platform which task_let is active, Core Update this automatic when switch Tasklet. */
@@ -153,14 +160,15 @@ arm_core_event_s *event_core_get(void)
     event = ns_list_get_first(&free_event_entry);
     if (event) {
         ns_list_remove(&free_event_entry, event);
-    } else {
+    }
+    platform_exit_critical();
+    if (!event) {
         event = event_dynamically_allocate();
     }
     if (event) {
         event->data.data_ptr = NULL;
         event->data.priority = ARM_LIB_LOW_PRIORITY_EVENT;
     }
-    platform_exit_critical();
     return event;
 }
 
@@ -174,11 +182,19 @@ static void event_core_free_push(arm_core_event_s *free)
 
 static arm_core_event_s *event_core_read(void)
 {
-    arm_core_event_s *event;
+    arm_core_event_s *event = NULL;
     platform_enter_critical();
-    event = ns_list_get_first(&event_queue_active);
-    if (event) {
-        ns_list_remove(&event_queue_active, event);
+    if (event_queue_map) {
+        // Lowest set bit is the highest priority waiting
+        uint_fast8_t priority = 0;
+        while (!(event_queue_map & (1 << priority))) {
+            priority++;
+        }
+        event = ns_list_get_first(&event_queue_active[priority]);
+        ns_list_remove(&event_queue_active[priority], event);
+        if (ns_list_is_empty(&event_queue_active[priority])) {
+            event_queue_map &= ~(1 << priority);
+        }
     }
     platform_exit_critical();
     return event;
@@ -186,20 +202,16 @@ static arm_core_event_s *event_core_read(void)
 
 void event_core_write(arm_core_event_s *event)
 {
-    platform_enter_critical();
-    bool added = false;
-    ns_list_foreach(arm_core_event_s, event_tmp, &event_queue_active) {
-        // note enum ordering means we're checking if event_tmp is LOWER priority than event
-        if (event_tmp->data.priority > event->data.priority) {
-            ns_list_add_before(&event_queue_active, event_tmp, event);
-            added = true;
-            break;
-        }
-    }
-    if (!added) {
-        ns_list_add_to_end(&event_queue_active, event);
+    // Unknown priorities are queued as low priority
+    uint_fast8_t priority = event->data.priority;
+    if (priority >= EVENT_PRIORITY_COUNT) {
+        priority = EVENT_PRIORITY_COUNT - 1;
     }
 
+    platform_enter_critical();
+    ns_list_add_to_end(&event_queue_active[priority], event);
+    event_queue_map |= 1 << priority;
+
     /* Wake From Idle */
     platform_exit_critical();
     eventOS_scheduler_signal();
@@ -216,7 +228,10 @@ void eventOS_scheduler_init(void)
 {
     /* Reset Event List variables */
     ns_list_init(&free_event_entry);
-    ns_list_init(&event_queue_active);
+    for (uint8_t i = 0; i < EVENT_PRIORITY_COUNT; i++) {
+        ns_list_init(&event_queue_active[i]);
+    }
+    event_queue_map = 0;
     ns_list_init(&arm_core_tasklet_list);
 
     //Allocate 10 entry
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <string.h>
 #include "ns_types.h"
 #include "ns_list.h"
 #include "ns_timer.h"
@@ -24,8 +25,7 @@
 
 #ifndef NS_EXCLUDE_HIGHRES_TIMER
 typedef enum ns_timer_state_e {
-    NS_TIMER_ACTIVE = 0,        // Will run on the next HAL interrupt
-    NS_TIMER_HOLD,              // Will run on a later HAL interrupt
+    NS_TIMER_ACTIVE = 0,        // Waiting for its deadline in the timer heap
     NS_TIMER_RUN_INTERRUPT,     // Running on the interrupt we're currently handling
     NS_TIMER_STOP               // Timer not scheduled ("start" not called since last callback)
 } ns_timer_state_e;
@@ -33,28 +33,44 @@ typedef enum ns_timer_state_e {
 typedef struct ns_timer_struct {
     int8_t ns_timer_id;
     ns_timer_state_e timer_state;
+    uint8_t heap_index;
     uint16_t slots;
-    uint16_t remaining_slots;
+    uint32_t deadline;
     void (*interrupt_handler)(int8_t, uint16_t);
+    struct ns_timer_struct *next_run;
     ns_list_link_t link;
 } ns_timer_struct;
 
 static NS_LIST_DEFINE(ns_timer_list, ns_timer_struct, link);
 
+/* Active timers are kept in a binary min-heap ordered by deadline, and the
+ * HAL timer runs to the deadline of the first one. Deadlines are absolute
+ * slot times, so nothing needs updating as time passes. The heap grows as
+ * timers are registered, it has room for all of them. */
+#define NS_TIMER_HEAP_STEP  4
+static ns_timer_struct **ns_timer_heap = NULL;
+static uint8_t ns_timer_heap_size = 0;
+static uint8_t ns_timer_heap_count = 0;
+static uint8_t ns_timer_count = 0;
+
+/* Timers taken off the heap by the interrupt we're currently handling */
+static ns_timer_struct *ns_timer_run_list = NULL;
+
+/* Slot time at which the HAL timer expires, or stopped if it isn't running */
+static uint32_t ns_timer_pl_time = 0;
 
 #define NS_TIMER_RUNNING    1
 static uint8_t ns_timer_state = 0;
 
 #ifdef ATMEGA256RFR2
 #define COMPENSATION 3
-#define COMPENSATION_TUNE 1
 #else
 #define COMPENSATION 0
-#define COMPENSATION_TUNE 0
 #endif
 
 static void ns_timer_interrupt_handler(void);
 static ns_timer_struct *ns_timer_get_pointer_to_timer_struct(int8_t timer_id);
+static void ns_timer_cancel(ns_timer_struct *timer);
 static bool ns_timer_initialized = 0;
 
 int8_t eventOS_callback_timer_register(void (*timer_interrupt_handler)(int8_t, uint16_t))
@@ -80,6 +96,23 @@ int8_t eventOS_callback_timer_register(void (*timer_interrupt_handler)(int8_t, u
         return -1;
     }
 
+    /*Make room for the new timer in the heap*/
+    if (ns_timer_count == ns_timer_heap_size) {
+        ns_timer_struct **new_heap = ns_dyn_mem_alloc((ns_timer_heap_size + NS_TIMER_HEAP_STEP) * sizeof(ns_timer_struct *));
+        if (!new_heap) {
+            return -1;
+        }
+        platform_enter_critical();
+        ns_timer_struct **old_heap = ns_timer_heap;
+        if (ns_timer_heap_count) {
+            memcpy(new_heap, ns_timer_heap, ns_timer_heap_count * sizeof(ns_timer_struct *));
+        }
+        ns_timer_heap = new_heap;
+        ns_timer_heap_size += NS_TIMER_HEAP_STEP;
+        platform_exit_critical();
+        ns_dyn_mem_free(old_heap);
+    }
+
     ns_timer_struct *new_timer = ns_dyn_mem_alloc(sizeof(ns_timer_struct));
     if (!new_timer) {
         return -1;
@@ -88,13 +121,15 @@ int8_t eventOS_callback_timer_register(void (*timer_interrupt_handler)(int8_t, u
     /*Initialise new timer*/
     new_timer->ns_timer_id = retval;
     new_timer->timer_state = NS_TIMER_STOP;
-    new_timer->remaining_slots = 0;
+    new_timer->slots = 0;
+    new_timer->deadline = 0;
     new_timer->interrupt_handler = timer_interrupt_handler;
 
     // Critical section sufficient as long as list can't be reordered from
     // interrupt, otherwise will need to cover whole routine
     platform_enter_critical();
     ns_list_add_to_end(&ns_timer_list, new_timer);
+    ns_timer_count++;
     platform_exit_critical();
 
     /*Return timer ID*/
@@ -113,93 +148,137 @@ int8_t eventOS_callback_timer_unregister(int8_t ns_timer_id)
     // Critical section sufficient as long as list can't be reordered from
     // interrupt, otherwise will need to cover whole routine
     platform_enter_critical();
+    /*Unregistered by the callback of another timer that expired with it, maybe
+     *after stopping or restarting it, so it can be on the run list in any state*/
+    for (ns_timer_struct **prev = &ns_timer_run_list; *prev; prev = &(*prev)->next_run) {
+        if (*prev == current_timer) {
+            *prev = current_timer->next_run;
+            break;
+        }
+    }
+    ns_timer_cancel(current_timer);
     ns_list_remove(&ns_timer_list, current_timer);
+    ns_timer_count--;
     platform_exit_critical();
 
     ns_dyn_mem_free(current_timer);
     return 0;
 }
 
+/* Earlier deadline first, and timers expiring together in ID order */
+static bool ns_timer_before(const ns_timer_struct *a, const ns_timer_struct *b)
+{
+    int32_t diff = (int32_t)(a->deadline - b->deadline);
+    return diff < 0 || (diff == 0 && a->ns_timer_id < b->ns_timer_id);
+}
 
-static int8_t ns_timer_start_pl_timer(uint16_t pl_timer_start_slots)
+static void ns_timer_heap_set(uint8_t index, ns_timer_struct *timer)
 {
-    /*Don't start timer with 0 slots*/
-    if (!pl_timer_start_slots) {
-        pl_timer_start_slots = 1;
-    }
+    ns_timer_heap[index] = timer;
+    timer->heap_index = index;
+}
 
-    /*Start HAL timer*/
-    platform_timer_start(pl_timer_start_slots);
-    /*Set HAL timer state to running*/
-    ns_timer_state |= NS_TIMER_RUNNING;
-    return 0;
+static void ns_timer_heap_up(uint8_t index, ns_timer_struct *timer)
+{
+    while (index > 0) {
+        uint8_t parent = (index - 1) / 2;
+        if (!ns_timer_before(timer, ns_timer_heap[parent])) {
+            break;
+        }
+        ns_timer_heap_set(index, ns_timer_heap[parent]);
+        index = parent;
+    }
+    ns_timer_heap_set(index, timer);
 }
 
-int8_t ns_timer_sleep(void)
+static void ns_timer_heap_down(uint8_t index, ns_timer_struct *timer)
 {
-    int8_t ret_val = -1;
-    if (ns_timer_state & NS_TIMER_RUNNING) {
-        /*Start HAL timer*/
-        platform_timer_disable();
-        /*Set HAL timer state to running*/
-        ns_timer_state &= ~NS_TIMER_RUNNING;
-        ret_val = 0;
+    for (;;) {
+        uint16_t child = 2 * index + 1;
+        if (child >= ns_timer_heap_count) {
+            break;
+        }
+        if (child + 1 < ns_timer_heap_count && ns_timer_before(ns_timer_heap[child + 1], ns_timer_heap[child])) {
+            child++;
+        }
+        if (!ns_timer_before(ns_timer_heap[child], timer)) {
+            break;
+        }
+        ns_timer_heap_set(index, ns_timer_heap[child]);
+        index = child;
     }
-    return ret_val;
+    ns_timer_heap_set(index, timer);
 }
 
-static int8_t ns_timer_get_next_running_to(void)
+static void ns_timer_heap_insert(ns_timer_struct *timer)
 {
-    uint8_t hold_count = 0;
-    ns_timer_struct *first_timer = NULL;
+    ns_timer_heap_up(ns_timer_heap_count++, timer);
+}
 
-    /*Find hold-labelled timer with the least remaining slots*/
-    ns_list_foreach(ns_timer_struct, current_timer, &ns_timer_list) {
-        if (current_timer->timer_state == NS_TIMER_HOLD) {
-            if (!first_timer || current_timer->remaining_slots < first_timer->remaining_slots) {
-                first_timer = current_timer;
-            }
-            /*For optimisation, count the found timers*/
-            hold_count++;
-        }
+static void ns_timer_heap_remove(ns_timer_struct *timer)
+{
+    uint8_t index = timer->heap_index;
+    ns_timer_struct *last = ns_timer_heap[--ns_timer_heap_count];
+
+    if (last == timer) {
+        return;
+    }
+    /*Fill the hole with the last timer, moving it whichever way it belongs*/
+    if (index > 0 && ns_timer_before(last, ns_timer_heap[(index - 1) / 2])) {
+        ns_timer_heap_up(index, last);
+    } else {
+        ns_timer_heap_down(index, last);
     }
+}
 
-    if (!first_timer) {
-        return 0;
+static uint32_t ns_timer_now(void)
+{
+    if (ns_timer_state & NS_TIMER_RUNNING) {
+        return ns_timer_pl_time - platform_timer_get_remaining_slots();
     }
+    return ns_timer_pl_time;
+}
 
-    /*If hold-labelled timer found, set it active and start the HAL driver*/
-    hold_count--;
-    first_timer->timer_state = NS_TIMER_ACTIVE;
-    /*Compensate time spent in timer function*/
-    if (first_timer->remaining_slots > COMPENSATION) {
-        first_timer->remaining_slots -= COMPENSATION;
+static void ns_timer_start_pl_timer(uint32_t now, uint16_t compensation)
+{
+    /*Deadlines are at most a 16-bit slot count away*/
+    uint16_t pl_timer_start_slots = ns_timer_heap[0]->deadline - now;
+
+    /*Don't start timer with 0 slots*/
+    if (!pl_timer_start_slots) {
+        pl_timer_start_slots = 1;
     }
-    /*Start HAL timer*/
-    ns_timer_start_pl_timer(first_timer->remaining_slots);
+    ns_timer_pl_time = now + pl_timer_start_slots;
 
-    /*Update other hold-labelled timers*/
-    ns_list_foreach(ns_timer_struct, current_timer, &ns_timer_list) {
-        if (hold_count == 0) { // early termination optimisation
-            break;
-        }
-        if (current_timer->timer_state == NS_TIMER_HOLD) {
-            if (current_timer->remaining_slots == first_timer->remaining_slots) {
-                current_timer->timer_state = NS_TIMER_ACTIVE;
-            } else {
-                current_timer->remaining_slots -= first_timer->remaining_slots;
-                /*Compensate time spent in timer function*/
-                if (current_timer->remaining_slots > COMPENSATION) {
-                    current_timer->remaining_slots -= COMPENSATION;
-                }
-            }
-            hold_count--;
-        }
+    /*Compensate time spent in timer function*/
+    if (pl_timer_start_slots > compensation) {
+        pl_timer_start_slots -= compensation;
     }
+    /*Start HAL timer*/
+    platform_timer_start(pl_timer_start_slots);
+    /*Set HAL timer state to running*/
+    ns_timer_state |= NS_TIMER_RUNNING;
+}
 
-    return 0;
+static void ns_timer_stop_pl_timer(void)
+{
+    /*Time stands still until the HAL timer is started again*/
+    ns_timer_pl_time = ns_timer_now();
+    platform_timer_disable();
+    ns_timer_state &= ~NS_TIMER_RUNNING;
 }
 
+int8_t ns_timer_sleep(void)
+{
+    int8_t ret_val = -1;
+    platform_enter_critical();
+    if (ns_timer_state & NS_TIMER_RUNNING) {
+        ns_timer_stop_pl_timer();
+        ret_val = 0;
+    }
+    platform_exit_critical();
+    return ret_val;
+}
 
 static ns_timer_struct *ns_timer_get_pointer_to_timer_struct(int8_t timer_id)
 {
@@ -212,10 +291,25 @@ static ns_timer_struct *ns_timer_get_pointer_to_timer_struct(int8_t timer_id)
     return NULL;
 }
 
+uint16_t ns_timer_remaining_slots(int8_t ns_timer_id)
+{
+    uint16_t slots = 0;
+    ns_timer_struct *timer;
+    platform_enter_critical();
+
+    timer = ns_timer_get_pointer_to_timer_struct(ns_timer_id);
+    if (timer && timer->timer_state == NS_TIMER_ACTIVE) {
+        slots = timer->deadline - ns_timer_now();
+    }
+
+    platform_exit_critical();
+    return slots;
+}
+
 int8_t eventOS_callback_timer_start(int8_t ns_timer_id, uint16_t slots)
 {
     int8_t ret_val = 0;
-    uint16_t pl_timer_remaining_slots;
+    uint32_t now;
     ns_timer_struct *timer;
     platform_enter_critical();
 
@@ -226,61 +320,21 @@ int8_t eventOS_callback_timer_start(int8_t ns_timer_id, uint16_t slots)
         goto exit;
     }
 
-    // XXX this assumes the timer currently isn't running?
-    // Is event.c relying on this restarting HAL timer after ns_timer_sleep()?
+    /*Starting a running timer replaces its timeout*/
+    if (timer->timer_state == NS_TIMER_ACTIVE) {
+        ns_timer_heap_remove(timer);
+    }
 
-    /*If any timers are active*/
-    if (ns_timer_state & NS_TIMER_RUNNING) {
-        /*Get remaining slots of the currently activated timeout*/
-        pl_timer_remaining_slots = platform_timer_get_remaining_slots();
-
-        /*New timeout is shorter than currently enabled timeout*/
-        if (pl_timer_remaining_slots > slots) {
-            /*Start HAL timer*/
-            ns_timer_start_pl_timer(slots - 0);
-
-            ns_list_foreach(ns_timer_struct, current_timer, &ns_timer_list) {
-                /*Switch active timers to hold*/
-                if (current_timer->timer_state == NS_TIMER_ACTIVE) {
-                    current_timer->timer_state = NS_TIMER_HOLD;
-                    current_timer->remaining_slots = 0;
-                }
-                /*Update hold-labelled timers*/
-                if (current_timer->timer_state == NS_TIMER_HOLD) {
-                    current_timer->remaining_slots += (pl_timer_remaining_slots - slots);
-                    /*Compensate time spent in timer function*/
-                    if (current_timer->remaining_slots > (COMPENSATION - COMPENSATION_TUNE)) {
-                        current_timer->remaining_slots -= (COMPENSATION - COMPENSATION_TUNE);
-                    }
-                }
-            }
-            /*Mark active and start the timer*/
-            timer->timer_state = NS_TIMER_ACTIVE;
-            timer->slots = slots;
-            timer->remaining_slots = slots;
-        }
+    now = ns_timer_now();
+    timer->timer_state = NS_TIMER_ACTIVE;
+    timer->slots = slots;
+    timer->deadline = now + slots;
+    ns_timer_heap_insert(timer);
 
-        /*New timeout is longer than currently enabled timeout*/
-        else if (pl_timer_remaining_slots < slots) {
-            /*Mark hold and update remaining slots*/
-            timer->timer_state = NS_TIMER_HOLD;
-            timer->slots = slots;
-            timer->remaining_slots = (slots - pl_timer_remaining_slots);
-        }
-        /*New timeout is equal to currently enabled timeout*/
-        else {
-            /*Mark it active and it will be handled in next interrupt*/
-            timer->timer_state = NS_TIMER_ACTIVE;
-            timer->slots = slots;
-            timer->remaining_slots = slots;
-        }
-    } else {
-        /*No timers running*/
-        timer->timer_state = NS_TIMER_HOLD;
-        timer->slots = slots;
-        timer->remaining_slots = slots;
-        /*Start next timeout*/
-        ns_timer_get_next_running_to();
+    /*Run the HAL timer to the new timeout if it comes first, or after
+     *ns_timer_sleep() to the first one*/
+    if (!(ns_timer_state & NS_TIMER_RUNNING) || (int32_t)(timer->deadline - ns_timer_pl_time) < 0) {
+        ns_timer_start_pl_timer(now, 0);
     }
 exit:
     platform_exit_critical();
@@ -289,44 +343,63 @@ exit:
 
 static void ns_timer_interrupt_handler(void)
 {
-    uint8_t i = 0;
+    ns_timer_struct **run_tail = &ns_timer_run_list;
+    uint32_t now;
 
     platform_enter_critical();
     /*Clear timer running state*/
     ns_timer_state &= ~NS_TIMER_RUNNING;
-    /*Mark active timers as NS_TIMER_RUN_INTERRUPT, interrupt functions are called at the end of this function*/
-    ns_list_foreach(ns_timer_struct, current_timer, &ns_timer_list) {
-        if (current_timer->timer_state == NS_TIMER_ACTIVE) {
-            current_timer->timer_state = NS_TIMER_RUN_INTERRUPT;
-            /*For optimisation, count the found timers*/
-            i++;
-        }
+    now = ns_timer_pl_time;
+
+    /*Take the expired timers off the heap, interrupt functions are called at the end of this function*/
+    while (ns_timer_heap_count && (int32_t)(ns_timer_heap[0]->deadline - now) <= 0) {
+        ns_timer_struct *timer = ns_timer_heap[0];
+        ns_timer_heap_remove(timer);
+        timer->timer_state = NS_TIMER_RUN_INTERRUPT;
+        timer->next_run = NULL;
+        *run_tail = timer;
+        run_tail = &timer->next_run;
     }
 
     /*Start next timeout*/
-    ns_timer_get_next_running_to();
+    if (ns_timer_heap_count) {
+        ns_timer_start_pl_timer(now, COMPENSATION);
+    }
 
     /*Call interrupt functions*/
-    ns_list_foreach(ns_timer_struct, current_timer, &ns_timer_list) {
-        if (i == 0) {
-            break;
-        }
-        if (current_timer->timer_state == NS_TIMER_RUN_INTERRUPT) {
-            current_timer->timer_state = NS_TIMER_STOP;
-            current_timer->interrupt_handler(current_timer->ns_timer_id, current_timer->slots);
-            i--;
+    while (ns_timer_run_list) {
+        ns_timer_struct *timer = ns_timer_run_list;
+        ns_timer_run_list = timer->next_run;
+        /*Unless stopped or started again by an earlier one*/
+        if (timer->timer_state == NS_TIMER_RUN_INTERRUPT) {
+            timer->timer_state = NS_TIMER_STOP;
+            timer->interrupt_handler(timer->ns_timer_id, timer->slots);
         }
     }
 
     platform_exit_critical();
 }
 
+static void ns_timer_cancel(ns_timer_struct *timer)
+{
+    if (timer->timer_state == NS_TIMER_ACTIVE) {
+        bool first = timer->heap_index == 0;
+        ns_timer_heap_remove(timer);
+        /*HAL timer was running to this one, run it to the next or stop it*/
+        if (first && (ns_timer_state & NS_TIMER_RUNNING)) {
+            if (ns_timer_heap_count) {
+                ns_timer_start_pl_timer(ns_timer_now(), 0);
+            } else {
+                ns_timer_stop_pl_timer();
+            }
+        }
+    }
+    timer->timer_state = NS_TIMER_STOP;
+}
+
 int8_t eventOS_callback_timer_stop(int8_t ns_timer_id)
 {
-    uint16_t pl_timer_remaining_slots;
-    bool active_timer_found = false;
     ns_timer_struct *current_timer;
-    ns_timer_struct *first_timer = NULL;
     int8_t retval = -1;
 
     platform_enter_critical();
@@ -337,52 +410,7 @@ int8_t eventOS_callback_timer_stop(int8_t ns_timer_id)
     }
 
     retval = 0;
-
-    /*Check if already stopped*/
-    if (current_timer->timer_state == NS_TIMER_STOP) {
-        goto exit;
-    }
-
-    current_timer->timer_state = NS_TIMER_STOP;
-    current_timer->remaining_slots = 0;
-
-    /*Check if some timer is already active*/
-    ns_list_foreach(ns_timer_struct, current_timer, &ns_timer_list) {
-        if (current_timer->timer_state == NS_TIMER_ACTIVE) {
-            active_timer_found = true;
-            break;
-        }
-    }
-    /*If no active timers found, start one*/
-    if (!active_timer_found) {
-        pl_timer_remaining_slots = platform_timer_get_remaining_slots();
-        /*Find hold-labelled timer with the least remaining slots*/
-        ns_list_foreach(ns_timer_struct, current_timer, &ns_timer_list) {
-            if (current_timer->timer_state == NS_TIMER_HOLD) {
-                current_timer->remaining_slots += pl_timer_remaining_slots;
-
-                if (!first_timer || current_timer->remaining_slots < first_timer->remaining_slots) {
-                    first_timer = current_timer;
-                }
-            }
-        }
-        /*If hold-labelled timer found, set it active and start the HAL driver*/
-        if (first_timer) {
-            first_timer->timer_state = NS_TIMER_ACTIVE;
-            /*Start HAL timer*/
-            ns_timer_start_pl_timer(first_timer->remaining_slots);
-            /*If some of the other hold-labelled timers have the same remaining slots as the timer_tmp, mark them active*/
-            ns_list_foreach(ns_timer_struct, current_timer, &ns_timer_list) {
-                if (current_timer->timer_state == NS_TIMER_HOLD) {
-                    if (current_timer->remaining_slots == first_timer->remaining_slots) {
-                        current_timer->timer_state = NS_TIMER_ACTIVE;
-                    } else {
-                        current_timer->remaining_slots -= first_timer->remaining_slots;
-                    }
-                }
-            }
-        }
-    }
+    ns_timer_cancel(current_timer);
 
 exit:
     platform_exit_critical();
@@ -22,6 +22,13 @@ extern "C" {
 
 extern int8_t ns_timer_sleep(void);
 
+/**
+ * Slots left until the given eventOS callback timer expires
+ *
+ * \return remaining 50us slots, 0 if the timer is not running
+ */
+extern uint16_t ns_timer_remaining_slots(int8_t ns_timer_id);
+
 #ifdef __cplusplus
 }
 #endif
@@ -28,7 +28,7 @@
 #endif
 
 typedef struct sys_timer_struct_s {
-    uint32_t timer_sys_launch_time;
+    uint32_t timer_sys_launch_time;     // absolute deadline in ticks of run_time_tick_ticks
     int8_t timer_sys_launch_receiver;
     uint8_t timer_sys_launch_message;
     uint8_t timer_event_type;
@@ -41,13 +41,86 @@ typedef struct sys_timer_struct_s {
 
 static uint32_t run_time_tick_ticks = 0;
 static NS_LIST_DEFINE(system_timer_free, sys_timer_struct_s, link);
+/* Active timers sorted by deadline, so a tick only looks at the timers that
+ * expire and the next deadline is always at the head. */
 static NS_LIST_DEFINE(system_timer_list, sys_timer_struct_s, link);
 
 
 static sys_timer_struct_s *sys_timer_dynamically_allocate(void);
+#ifndef NS_EVENTLOOP_TICKLESS
 static void timer_sys_interrupt(void);
+#endif
+static void timer_sys_advance(uint32_t ticks);
+
+/* Deadlines are compared by difference so that the tick counter may wrap */
+#define TIMER_SYS_DUE(deadline) ((int32_t)((deadline) - run_time_tick_ticks) <= 0)
+
+#ifdef NS_EVENTLOOP_TICKLESS
+#if defined NS_EVENTLOOP_USE_TICK_TIMER || defined NS_EXCLUDE_HIGHRES_TIMER
+#error "Tickless system timer requires the eventOS callback timer"
+#endif
+/*
+ * Tickless system timer: the eventOS timer is started for the next deadline
+ * only, and stopped when no timers are active. Time that has passed is read
+ * back from the running timer whenever the timer list changes, so ticks are
+ * counted exactly as with a periodic tick.
+ */
+#define TIMER_SYS_TICK_SLOTS        (TIMER_SLOTS_PER_MS * TIMER_SYS_TICK_PERIOD)
+#define TIMER_SYS_MAX_TICKS         (UINT16_MAX / TIMER_SYS_TICK_SLOTS)
 
-#ifndef NS_EVENTLOOP_USE_TICK_TIMER
+static int8_t tick_timer_id = -1;
+static uint16_t tick_timer_slots;       // remaining slots when last read, 0 when stopped
+static uint16_t tick_slot_count;        // slots passed since the last whole tick
+
+// Count the time passed since the timer was started or last read
+static void timer_sys_catch_up(void)
+{
+    if (tick_timer_slots) {
+        uint16_t remaining = ns_timer_remaining_slots(tick_timer_id);
+        if (remaining > tick_timer_slots) {
+            remaining = tick_timer_slots;
+        }
+        tick_slot_count += tick_timer_slots - remaining;
+        tick_timer_slots = remaining;
+        if (tick_slot_count >= TIMER_SYS_TICK_SLOTS) {
+            uint32_t ticks = tick_slot_count / TIMER_SYS_TICK_SLOTS;
+            tick_slot_count %= TIMER_SYS_TICK_SLOTS;
+            timer_sys_advance(ticks);
+        }
+    }
+}
+
+// Start the timer for the next deadline, or stop it if there is none
+static void timer_sys_schedule(void)
+{
+    timer_sys_catch_up();
+    if (tick_timer_slots) {
+        eventOS_callback_timer_stop(tick_timer_id);
+        tick_timer_slots = 0;
+    }
+    sys_timer_struct_s *next = ns_list_get_first(&system_timer_list);
+    if (!next) {
+        tick_slot_count = 0;
+        return;
+    }
+    uint32_t ticks = next->timer_sys_launch_time - run_time_tick_ticks;
+    if (ticks > TIMER_SYS_MAX_TICKS) {
+        ticks = TIMER_SYS_MAX_TICKS;
+    }
+    tick_timer_slots = ticks * TIMER_SYS_TICK_SLOTS - tick_slot_count;
+    eventOS_callback_timer_start(tick_timer_id, tick_timer_slots);
+}
+
+static void tick_timer_eventOS_callback(int8_t timer_id, uint16_t slots)
+{
+    (void)slots;
+    if (timer_id == tick_timer_id) {
+        platform_enter_critical();
+        timer_sys_schedule();
+        platform_exit_critical();
+    }
+}
+#elif !defined NS_EVENTLOOP_USE_TICK_TIMER
 static int8_t platform_tick_timer_start(uint32_t period_ms);
 /* Implement platform tick timer using eventOS timer */
 // platform tick timer callback function
@@ -82,7 +155,7 @@ static int8_t platform_tick_timer_stop(void)
 {
     return eventOS_callback_timer_stop(tick_timer_id);
 }
-#endif // !NS_EVENTLOOP_USE_TICK_TIMER
+#endif // NS_EVENTLOOP_TICKLESS / !NS_EVENTLOOP_USE_TICK_TIMER
 
 /*
  * Initializes timers and starts system timer
@@ -109,8 +182,18 @@ void timer_sys_init(void)
         }
     }
 
+#ifdef NS_EVENTLOOP_TICKLESS
+    if (tick_timer_id < 0) {
+        tick_timer_id = eventOS_callback_timer_register(tick_timer_eventOS_callback);
+    } else {
+        eventOS_callback_timer_stop(tick_timer_id);
+    }
+    tick_timer_slots = 0;
+    tick_slot_count = 0;
+#else
     platform_tick_timer_register(timer_sys_interrupt);
     platform_tick_timer_start(TIMER_SYS_TICK_PERIOD);
+#endif
 }
 
 
@@ -118,22 +201,42 @@ void timer_sys_init(void)
 /*-------------------SYSTEM TIMER FUNCTIONS--------------------------*/
 void timer_sys_disable(void)
 {
+#ifdef NS_EVENTLOOP_TICKLESS
+    platform_enter_critical();
+    timer_sys_catch_up();
+    if (tick_timer_slots) {
+        eventOS_callback_timer_stop(tick_timer_id);
+        tick_timer_slots = 0;
+    }
+    platform_exit_critical();
+#else
     platform_tick_timer_stop();
+#endif
 }
 
 /*
- * Starts ticking system timer interrupts every 10ms
+ * Starts ticking system timer interrupts every 10ms, or in tickless mode
+ * starts the timer for the next deadline
  */
 int8_t timer_sys_wakeup(void)
 {
+#ifdef NS_EVENTLOOP_TICKLESS
+    platform_enter_critical();
+    timer_sys_schedule();
+    platform_exit_critical();
+    return 0;
+#else
     return platform_tick_timer_start(TIMER_SYS_TICK_PERIOD);
+#endif
 }
 
 
+#ifndef NS_EVENTLOOP_TICKLESS
 static void timer_sys_interrupt(void)
 {
     system_timer_tick_update(1);
 }
+#endif
 
 
 
@@ -162,6 +265,9 @@ uint32_t timer_get_runtime_ticks(void)  // only used in dev_stats_internal.c
 {
     uint32_t ret_val;
     platform_enter_critical();
+#ifdef NS_EVENTLOOP_TICKLESS
+    timer_sys_catch_up();
+#endif
     ret_val = run_time_tick_ticks;
     platform_exit_critical();
     return ret_val;
@@ -186,11 +292,31 @@ int8_t eventOS_event_timer_request(uint8_t snmessage, uint8_t event_type, int8_t
     }
     timer = timer_struct_get();
     if (timer) {
+#ifdef NS_EVENTLOOP_TICKLESS
+        timer_sys_catch_up();
+#endif
         timer->timer_sys_launch_message = snmessage;
         timer->timer_sys_launch_receiver = tasklet_id;
         timer->timer_event_type = event_type;
-        timer->timer_sys_launch_time = time;
-        ns_list_add_to_start(&system_timer_list, timer);
+        timer->timer_sys_launch_time = run_time_tick_ticks + time;
+
+        // New timers tend to be the longest, so search from the end. Timers
+        // with the same deadline expire in the order requested.
+        sys_timer_struct_s *before = NULL;
+        ns_list_foreach_reverse(sys_timer_struct_s, cur, &system_timer_list) {
+            if ((int32_t)(cur->timer_sys_launch_time - timer->timer_sys_launch_time) <= 0) {
+                before = cur;
+                break;
+            }
+        }
+        if (before) {
+            ns_list_add_after(&system_timer_list, before, timer);
+        } else {
+            ns_list_add_to_start(&system_timer_list, timer);
+#ifdef NS_EVENTLOOP_TICKLESS
+            timer_sys_schedule();
+#endif
+        }
         res = 0;
     }
     platform_exit_critical();
@@ -209,6 +335,13 @@ int8_t eventOS_event_timer_cancel(uint8_t snmessage, int8_t tasklet_id)
             break;
         }
     }
+#ifdef NS_EVENTLOOP_TICKLESS
+    // An early wakeup for a cancelled timer is harmless, but don't keep
+    // the timer running for nothing
+    if (res == 0 && ns_list_is_empty(&system_timer_list)) {
+        timer_sys_schedule();
+    }
+#endif
 
     platform_exit_critical();
     return res;
@@ -220,9 +353,15 @@ uint32_t eventOS_event_timer_shortest_active_timer(void)
     uint32_t ret_val = 0;
 
     platform_enter_critical();
-    ns_list_foreach(sys_timer_struct_s, cur, &system_timer_list) {
-        if (ret_val == 0 || cur->timer_sys_launch_time < ret_val) {
-            ret_val = cur->timer_sys_launch_time;
+#ifdef NS_EVENTLOOP_TICKLESS
+    timer_sys_catch_up();
+#endif
+    sys_timer_struct_s *first = ns_list_get_first(&system_timer_list);
+    if (first) {
+        ret_val = first->timer_sys_launch_time - run_time_tick_ticks;
+        // An expired timer waits for the next tick
+        if ((int32_t)ret_val <= 0) {
+            ret_val = 1;
         }
     }
 
@@ -232,30 +371,33 @@ uint32_t eventOS_event_timer_shortest_active_timer(void)
     return ret_val;
 }
 
-void system_timer_tick_update(uint32_t ticks)
+static void timer_sys_advance(uint32_t ticks)
 {
-    platform_enter_critical();
     //Keep runtime time
     run_time_tick_ticks += ticks;
-    ns_list_foreach_safe(sys_timer_struct_s, cur, &system_timer_list) {
-        if (cur->timer_sys_launch_time <= ticks) {
-            arm_event_s event = {
-                .receiver = cur->timer_sys_launch_receiver,
-                .sender = 0, /**< Event sender Tasklet ID */
-                .data_ptr = NULL,
-                .event_type = cur->timer_event_type,
-                .event_id = cur->timer_sys_launch_message,
-                .event_data = 0,
-                .priority = ARM_LIB_MED_PRIORITY_EVENT,
-            };
-            eventOS_event_send(&event);
-            ns_list_remove(&system_timer_list, cur);
-            ns_list_add_to_start(&system_timer_free, cur);
-        } else {
-            cur->timer_sys_launch_time -= ticks;
-        }
+    sys_timer_struct_s *cur;
+    while ((cur = ns_list_get_first(&system_timer_list)) != NULL && TIMER_SYS_DUE(cur->timer_sys_launch_time)) {
+        arm_event_s event = {
+            .receiver = cur->timer_sys_launch_receiver,
+            .sender = 0, /**< Event sender Tasklet ID */
+            .data_ptr = NULL,
+            .event_type = cur->timer_event_type,
+            .event_id = cur->timer_sys_launch_message,
+            .event_data = 0,
+            .priority = ARM_LIB_MED_PRIORITY_EVENT,
+        };
+        eventOS_event_send(&event);
+        ns_list_remove(&system_timer_list, cur);
+        ns_list_add_to_start(&system_timer_free, cur);
     }
+}
 
+void system_timer_tick_update(uint32_t ticks)
+{
+    platform_enter_critical();
+#ifdef NS_EVENTLOOP_TICKLESS
+    timer_sys_catch_up();
+#endif
+    timer_sys_advance(ticks);
     platform_exit_critical();
 }
-
@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ */
+#include "CppUTest/TestHarness.h"
+#include "eventOS_event.h"
+#include "eventOS_scheduler.h"
+#include "platform_posix.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define INIT_EVENT          0
+#define TEST_EVENT          1
+
+#define POSTER_THREADS      4
+#define POSTS_PER_THREAD    20000
+#define BACKLOG_EVENTS      10000
+#define TIMED_EVENTS        1000
+
+static int received;
+static arm_event_s events[64];
+static int8_t tasklet_id;
+
+static void record_handler(arm_event_s *event)
+{
+    if (event->event_type == TEST_EVENT && received < 64) {
+        events[received] = *event;
+    }
+    received++;
+}
+
+static void post(arm_library_event_priority_e priority, uint32_t data)
+{
+    arm_event_s event;
+    memset(&event, 0, sizeof(event));
+    event.receiver = tasklet_id;
+    event.event_type = TEST_EVENT;
+    event.priority = priority;
+    event.event_data = data;
+    CHECK(eventOS_event_send(&event) == 0);
+}
+
+static uint32_t elapsed_ns(const struct timespec *start, const struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) * 1000000000UL + end->tv_nsec - start->tv_nsec;
+}
+
+TEST_GROUP(event)
+{
+    void setup() {
+        platform_posix_init();
+        eventOS_scheduler_init();
+        received = 0;
+        tasklet_id = eventOS_event_handler_create(&record_handler, INIT_EVENT);
+        CHECK(tasklet_id >= 0);
+        eventOS_scheduler_run_until_idle();
+        received = 0;
+    }
+
+    void teardown() {
+    }
+};
+
+TEST(event, priority_order)
+{
+    post(ARM_LIB_LOW_PRIORITY_EVENT, 1);
+    post(ARM_LIB_MED_PRIORITY_EVENT, 2);
+    post(ARM_LIB_HIGH_PRIORITY_EVENT, 3);
+    post(ARM_LIB_LOW_PRIORITY_EVENT, 4);
+    post(ARM_LIB_HIGH_PRIORITY_EVENT, 5);
+    post(ARM_LIB_MED_PRIORITY_EVENT, 6);
+
+    eventOS_scheduler_run_until_idle();
+
+    // Higher priorities first, and in the order posted within a priority
+    const uint32_t expected[] = { 3, 5, 2, 6, 1, 4 };
+    CHECK(received == 6);
+    for (int i = 0; i < 6; i++) {
+        CHECK(events[i].event_data == expected[i]);
+    }
+    CHECK(!eventOS_scheduler_dispatch_event());
+}
+
+TEST(event, unknown_priority_is_low)
+{
+    post((arm_library_event_priority_e)7, 1);
+    post(ARM_LIB_LOW_PRIORITY_EVENT, 2);
+    post(ARM_LIB_HIGH_PRIORITY_EVENT, 3);
+
+    eventOS_scheduler_run_until_idle();
+
+    CHECK(received == 3);
+    CHECK(events[0].event_data == 3);
+    CHECK(events[1].event_data == 1);
+    CHECK(events[2].event_data == 2);
+    CHECK(events[1].priority == 7);
+}
+
+static void *poster_thread(void *arg)
+{
+    intptr_t id = (intptr_t)arg;
+    for (uint32_t i = 0; i < POSTS_PER_THREAD; i++) {
+        arm_event_s event;
+        memset(&event, 0, sizeof(event));
+        event.receiver = tasklet_id;
+        event.sender = id;
+        event.event_type = TEST_EVENT;
+        event.priority = (arm_library_event_priority_e)(i % 3);
+        event.event_data = i;
+        while (eventOS_event_send(&event) != 0) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static uint32_t next_data[POSTER_THREADS][3];
+static bool order_ok;
+
+static void order_handler(arm_event_s *event)
+{
+    if (event->event_type != TEST_EVENT) {
+        return;
+    }
+    uint32_t *next = &next_data[event->sender][event->priority];
+    if (event->event_data != *next) {
+        order_ok = false;
+    }
+    *next = event->event_data + 3;
+    received++;
+}
+
+TEST(event, posts_from_other_threads)
+{
+    pthread_t threads[POSTER_THREADS];
+
+    eventOS_scheduler_init();
+    tasklet_id = eventOS_event_handler_create(&order_handler, INIT_EVENT);
+    CHECK(tasklet_id >= 0);
+    for (int i = 0; i < POSTER_THREADS; i++) {
+        for (int p = 0; p < 3; p++) {
+            next_data[i][p] = p;
+        }
+    }
+    order_ok = true;
+    received = 0;
+
+    eventOS_scheduler_mutex_wait();
+    for (intptr_t i = 0; i < POSTER_THREADS; i++) {
+        pthread_create(&threads[i], NULL, poster_thread, (void *)i);
+    }
+    // Every sender's events of one priority arrive in the order posted
+    while (received < POSTER_THREADS * POSTS_PER_THREAD) {
+        if (!eventOS_scheduler_dispatch_event()) {
+            eventOS_scheduler_idle();
+        }
+    }
+    eventOS_scheduler_mutex_release();
+    for (int i = 0; i < POSTER_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    CHECK(order_ok);
+    CHECK(!eventOS_scheduler_dispatch_event());
+}
+
+TEST(event, post_behind_backlog)
+{
+    struct timespec start, end;
+
+    // A flood of low priority events is waiting when urgent ones are posted
+    for (uint32_t i = 0; i < BACKLOG_EVENTS; i++) {
+        post(ARM_LIB_LOW_PRIORITY_EVENT, i);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t i = 0; i < TIMED_EVENTS; i++) {
+        post(ARM_LIB_HIGH_PRIORITY_EVENT, i);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    uint32_t post_ns = elapsed_ns(&start, &end);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t i = 0; i < TIMED_EVENTS; i++) {
+        eventOS_scheduler_dispatch_event();
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    uint32_t dispatch_ns = elapsed_ns(&start, &end);
+
+    printf("\nbehind %d queued events: %lu ns per post, %lu ns per dispatch\n", BACKLOG_EVENTS,
+           (unsigned long)(post_ns / TIMED_EVENTS), (unsigned long)(dispatch_ns / TIMED_EVENTS));
+
+    CHECK(events[0].priority == ARM_LIB_HIGH_PRIORITY_EVENT);
+    eventOS_scheduler_run_until_idle();
+    CHECK(received == BACKLOG_EVENTS + TIMED_EVENTS);
+}
@@ -0,0 +1,292 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ */
+#include "CppUTest/TestHarness.h"
+#include "eventOS_callback_timer.h"
+#include "ns_timer.h"
+#include "arm_hal_timer_stub.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* eventOS callback timers on a virtual HAL timer. Every timer fires exactly
+ * when started plus its slots, timers expiring together in the order they
+ * were registered. */
+
+#define MAX_TIMERS      64
+#define MAX_FIRED       64
+
+typedef struct {
+    int8_t id;
+    uint16_t slots;
+    uint32_t time;
+} fired_t;
+
+static int8_t timer_ids[MAX_TIMERS];
+static int timer_count;
+static fired_t fired[MAX_FIRED];
+static int fired_count;
+
+static void record_handler(int8_t id, uint16_t slots)
+{
+    if (fired_count < MAX_FIRED) {
+        fired[fired_count].id = id;
+        fired[fired_count].slots = slots;
+        fired[fired_count].time = arm_hal_timer_stub.now;
+    }
+    fired_count++;
+}
+
+static void register_timers(int count, void (*handler)(int8_t, uint16_t))
+{
+    for (int i = 0; i < count; i++) {
+        timer_ids[i] = eventOS_callback_timer_register(handler);
+        CHECK(timer_ids[i] == i);
+    }
+    timer_count = count;
+}
+
+static uint32_t elapsed_ns(const struct timespec *start, const struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) * 1000000000UL + end->tv_nsec - start->tv_nsec;
+}
+
+TEST_GROUP(ns_timer)
+{
+    void setup() {
+        memset(&arm_hal_timer_stub, 0, sizeof(arm_hal_timer_stub));
+        fired_count = 0;
+        timer_count = 0;
+    }
+
+    void teardown() {
+        for (int i = 0; i < timer_count; i++) {
+            eventOS_callback_timer_unregister(timer_ids[i]);
+        }
+        // Let a HAL timer left running expire
+        arm_hal_timer_stub_advance(UINT16_MAX + 1);
+    }
+};
+
+TEST(ns_timer, expire_in_deadline_order)
+{
+    register_timers(4, record_handler);
+    CHECK(eventOS_callback_timer_start(3, 500) == 0);
+    CHECK(eventOS_callback_timer_start(0, 100) == 0);
+    CHECK(eventOS_callback_timer_start(2, 300) == 0);
+    CHECK(eventOS_callback_timer_start(1, 100) == 0);
+
+    arm_hal_timer_stub_advance(1000);
+
+    CHECK(fired_count == 4);
+    CHECK(fired[0].id == 0 && fired[0].time == 100 && fired[0].slots == 100);
+    CHECK(fired[1].id == 1 && fired[1].time == 100);
+    CHECK(fired[2].id == 2 && fired[2].time == 300 && fired[2].slots == 300);
+    CHECK(fired[3].id == 3 && fired[3].time == 500);
+    CHECK(arm_hal_timer_stub.interrupts == 3);
+}
+
+TEST(ns_timer, shorter_timeout_while_running)
+{
+    register_timers(2, record_handler);
+    CHECK(eventOS_callback_timer_start(0, 1000) == 0);
+    arm_hal_timer_stub_advance(200);
+    CHECK(eventOS_callback_timer_start(1, 300) == 0);
+    CHECK(ns_timer_remaining_slots(0) == 800);
+    CHECK(ns_timer_remaining_slots(1) == 300);
+
+    arm_hal_timer_stub_advance(2000);
+
+    CHECK(fired_count == 2);
+    CHECK(fired[0].id == 1 && fired[0].time == 500);
+    CHECK(fired[1].id == 0 && fired[1].time == 1000);
+    CHECK(ns_timer_remaining_slots(0) == 0);
+}
+
+TEST(ns_timer, restart_and_stop)
+{
+    register_timers(3, record_handler);
+    CHECK(eventOS_callback_timer_start(0, 100) == 0);
+    CHECK(eventOS_callback_timer_start(1, 200) == 0);
+    CHECK(eventOS_callback_timer_start(2, 400) == 0);
+    arm_hal_timer_stub_advance(50);
+
+    CHECK(eventOS_callback_timer_stop(0) == 0);
+    CHECK(eventOS_callback_timer_stop(0) == 0);
+    CHECK(eventOS_callback_timer_start(1, 500) == 0);
+    CHECK(eventOS_callback_timer_stop(5) == -1);
+    CHECK(eventOS_callback_timer_start(5, 10) == -1);
+    CHECK(ns_timer_remaining_slots(2) == 350);
+
+    arm_hal_timer_stub_advance(1000);
+
+    CHECK(fired_count == 2);
+    CHECK(fired[0].id == 2 && fired[0].time == 400);
+    CHECK(fired[1].id == 1 && fired[1].time == 550 && fired[1].slots == 500);
+}
+
+static void periodic_handler(int8_t id, uint16_t slots)
+{
+    record_handler(id, slots);
+    if (id == 0) {
+        eventOS_callback_timer_start(id, slots);
+    }
+}
+
+TEST(ns_timer, restart_from_callback)
+{
+    register_timers(2, periodic_handler);
+    CHECK(eventOS_callback_timer_start(0, 70) == 0);
+    CHECK(eventOS_callback_timer_start(1, 333) == 0);
+
+    arm_hal_timer_stub_advance(700);
+
+    CHECK(fired_count == 11);
+    for (int i = 0, t = 70; i < fired_count; i++) {
+        if (fired[i].id == 1) {
+            CHECK(fired[i].time == 333);
+        } else {
+            CHECK(fired[i].time == (uint32_t)t);
+            t += 70;
+        }
+    }
+    CHECK(eventOS_callback_timer_stop(0) == 0);
+}
+
+/* Timer 0 unregisters timers expiring with it: 1 after stopping it, 2 after
+ * starting it again */
+static void unregister_handler(int8_t id, uint16_t slots)
+{
+    record_handler(id, slots);
+    if (id == 0) {
+        CHECK(eventOS_callback_timer_stop(1) == 0);
+        CHECK(eventOS_callback_timer_unregister(1) == 0);
+        CHECK(eventOS_callback_timer_start(2, 50) == 0);
+        CHECK(eventOS_callback_timer_unregister(2) == 0);
+    }
+}
+
+TEST(ns_timer, unregister_from_callback)
+{
+    register_timers(4, unregister_handler);
+    for (int i = 0; i < 4; i++) {
+        CHECK(eventOS_callback_timer_start(i, 100) == 0);
+    }
+
+    arm_hal_timer_stub_advance(1000);
+
+    CHECK(fired_count == 2);
+    CHECK(fired[0].id == 0 && fired[0].time == 100);
+    CHECK(fired[1].id == 3 && fired[1].time == 100);
+    CHECK(eventOS_callback_timer_register(record_handler) == 1);
+    CHECK(eventOS_callback_timer_register(record_handler) == 2);
+}
+
+/* Random starts and stops, also from callbacks, against the expected deadlines */
+#define MODEL_TIMERS    16
+#define MODEL_STEPS     20000
+
+static bool model_active[MODEL_TIMERS];
+static uint32_t model_deadline[MODEL_TIMERS];
+static uint32_t model_last_time;
+static int8_t model_last_id;
+static bool model_ok;
+
+static uint16_t model_slots(void)
+{
+    return rand() % 8 ? 1 + rand() % 2000 : 1 + rand() % UINT16_MAX;
+}
+
+static void model_start(int8_t id, uint16_t slots)
+{
+    CHECK(eventOS_callback_timer_start(id, slots) == 0);
+    model_active[id] = true;
+    model_deadline[id] = arm_hal_timer_stub.now + slots;
+}
+
+static void model_handler(int8_t id, uint16_t slots)
+{
+    uint32_t now = arm_hal_timer_stub.now;
+    if (!model_active[id] || model_deadline[id] != now) {
+        model_ok = false;
+    }
+    if (now == model_last_time && id <= model_last_id) {
+        model_ok = false;
+    }
+    model_last_time = now;
+    model_last_id = id;
+    model_active[id] = false;
+    fired_count++;
+
+    if (rand() % 4 == 0) {
+        model_start(id, model_slots());
+    }
+    if (rand() % 8 == 0) {
+        int8_t other = rand() % MODEL_TIMERS;
+        CHECK(eventOS_callback_timer_stop(other) == 0);
+        model_active[other] = false;
+    }
+}
+
+TEST(ns_timer, matches_reference_model)
+{
+    srand(1);
+    memset(model_active, 0, sizeof(model_active));
+    model_last_time = UINT32_MAX;
+    model_ok = true;
+    register_timers(MODEL_TIMERS, model_handler);
+
+    for (int step = 0; step < MODEL_STEPS; step++) {
+        int8_t id = rand() % MODEL_TIMERS;
+        if (rand() % 4) {
+            model_start(id, model_slots());
+        } else {
+            CHECK(eventOS_callback_timer_stop(id) == 0);
+            model_active[id] = false;
+        }
+        arm_hal_timer_stub_advance(rand() % 1000);
+
+        // Nothing was missed
+        for (int i = 0; i < MODEL_TIMERS; i++) {
+            if (model_active[i]) {
+                CHECK((int32_t)(model_deadline[i] - arm_hal_timer_stub.now) > 0);
+                CHECK(ns_timer_remaining_slots(i) == model_deadline[i] - arm_hal_timer_stub.now);
+            }
+        }
+    }
+    CHECK(model_ok);
+    CHECK(fired_count > MODEL_STEPS / 4);
+}
+
+/* MAC and PHY timers of several interfaces, each restarted as it expires */
+#define BUSY_TIMERS     32
+#define BUSY_EXPIRIES   100000
+
+static void busy_handler(int8_t id, uint16_t slots)
+{
+    fired_count++;
+    eventOS_callback_timer_start(id, slots);
+}
+
+TEST(ns_timer, many_timers)
+{
+    struct timespec start, end;
+
+    register_timers(BUSY_TIMERS, busy_handler);
+    for (int i = 0; i < BUSY_TIMERS; i++) {
+        CHECK(eventOS_callback_timer_start(i, 20 + i * 13) == 0);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (fired_count < BUSY_EXPIRIES) {
+        arm_hal_timer_stub_advance(100);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    printf("\n%d running timers: %lu ns per expiry\n", BUSY_TIMERS,
+           (unsigned long)(elapsed_ns(&start, &end) / fired_count));
+    for (int i = 0; i < BUSY_TIMERS; i++) {
+        CHECK(eventOS_callback_timer_stop(i) == 0);
+    }
+}
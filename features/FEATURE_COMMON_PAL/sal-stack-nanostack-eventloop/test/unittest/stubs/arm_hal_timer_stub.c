@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ */
+#include "ns_types.h"
+#include "platform/arm_hal_timer.h"
+#include "arm_hal_timer_stub.h"
+
+arm_hal_timer_stub_def arm_hal_timer_stub;
+
+static platform_timer_cb timer_cb;
+static bool running;
+static uint32_t due;
+
+void arm_hal_timer_stub_advance(uint32_t slots)
+{
+    uint32_t target = arm_hal_timer_stub.now + slots;
+    while (running && (int32_t)(due - target) <= 0) {
+        arm_hal_timer_stub.now = due;
+        running = false;
+        arm_hal_timer_stub.interrupts++;
+        timer_cb();
+    }
+    arm_hal_timer_stub.now = target;
+}
+
+void platform_timer_enable(void)
+{
+}
+
+void platform_timer_set_cb(platform_timer_cb new_fp)
+{
+    timer_cb = new_fp;
+}
+
+void platform_timer_start(uint16_t slots)
+{
+    due = arm_hal_timer_stub.now + slots;
+    running = true;
+    arm_hal_timer_stub.starts++;
+}
+
+void platform_timer_disable(void)
+{
+    running = false;
+}
+
+uint16_t platform_timer_get_remaining_slots(void)
+{
+    return running ? due - arm_hal_timer_stub.now : 0;
+}
@@ -0,0 +1,29 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ */
+#ifndef ARM_HAL_TIMER_STUB_H_
+#define ARM_HAL_TIMER_STUB_H_
+
+#include "ns_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* HAL timer running on a virtual clock of 50us slots */
+typedef struct {
+    uint32_t now;           /**< Virtual time in slots */
+    uint32_t interrupts;    /**< Number of timer interrupts */
+    uint32_t starts;        /**< Number of times the timer was started */
+} arm_hal_timer_stub_def;
+
+extern arm_hal_timer_stub_def arm_hal_timer_stub;
+
+/** Advance the virtual clock, calling the interrupt handler when the timer expires */
+void arm_hal_timer_stub_advance(uint32_t slots);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ARM_HAL_TIMER_STUB_H_ */
@@ -0,0 +1,18 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ */
+#include "eventOS_event.h"
+#include "event_stub.h"
+#include "ns_timer_stub.h"
+
+event_stub_def event_stub;
+
+int8_t eventOS_event_send(arm_event_s *event)
+{
+    if (event_stub.count < EVENT_STUB_MAX_EVENTS) {
+        event_stub.events[event_stub.count] = *event;
+        event_stub.time[event_stub.count] = ns_timer_stub.now;
+    }
+    event_stub.count++;
+    return 0;
+}
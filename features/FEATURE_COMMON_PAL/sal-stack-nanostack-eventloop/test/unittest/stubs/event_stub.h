@@ -0,0 +1,28 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ */
+#ifndef EVENT_STUB_H_
+#define EVENT_STUB_H_
+
+#include "eventOS_event.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EVENT_STUB_MAX_EVENTS 512
+
+/* Records the events sent instead of queueing them */
+typedef struct {
+    arm_event_s events[EVENT_STUB_MAX_EVENTS];
+    uint32_t time[EVENT_STUB_MAX_EVENTS];   /**< ns_timer_stub.now when sent */
+    int count;
+} event_stub_def;
+
+extern event_stub_def event_stub;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EVENT_STUB_H_ */
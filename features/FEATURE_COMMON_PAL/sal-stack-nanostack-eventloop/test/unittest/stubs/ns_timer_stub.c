@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ */
+#include "ns_types.h"
+#include "ns_timer.h"
+#include "eventOS_callback_timer.h"
+#include "ns_timer_stub.h"
+
+ns_timer_stub_def ns_timer_stub;
+
+static void (*timer_callback)(int8_t, uint16_t);
+static bool running;
+static uint32_t due;
+static uint16_t started_slots;
+
+void ns_timer_stub_reset(void)
+{
+    ns_timer_stub.now = 0;
+    ns_timer_stub.wakeups = 0;
+    ns_timer_stub.starts = 0;
+    running = false;
+}
+
+void ns_timer_stub_advance(uint32_t slots)
+{
+    uint32_t target = ns_timer_stub.now + slots;
+    while (running && (int32_t)(due - target) <= 0) {
+        ns_timer_stub.now = due;
+        running = false;
+        ns_timer_stub.wakeups++;
+        timer_callback(0, started_slots);
+    }
+    ns_timer_stub.now = target;
+}
+
+int8_t eventOS_callback_timer_register(void (*timer_interrupt_handler)(int8_t, uint16_t))
+{
+    timer_callback = timer_interrupt_handler;
+    return 0;
+}
+
+int8_t eventOS_callback_timer_unregister(int8_t ns_timer_id)
+{
+    timer_callback = NULL;
+    return 0;
+}
+
+int8_t eventOS_callback_timer_start(int8_t ns_timer_id, uint16_t slots)
+{
+    due = ns_timer_stub.now + slots;
+    started_slots = slots;
+    running = true;
+    ns_timer_stub.starts++;
+    return 0;
+}
+
+int8_t eventOS_callback_timer_stop(int8_t ns_timer_id)
+{
+    running = false;
+    return 0;
+}
+
+uint16_t ns_timer_remaining_slots(int8_t ns_timer_id)
+{
+    return running ? due - ns_timer_stub.now : 0;
+}
+
+int8_t ns_timer_sleep(void)
+{
+    return 0;
+}
@@ -0,0 +1,32 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ */
+#ifndef NS_TIMER_STUB_H_
+#define NS_TIMER_STUB_H_
+
+#include "ns_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* eventOS callback timer running on a virtual clock of 50us slots. A single
+ * timer is supported, which is all the system timer uses. */
+typedef struct {
+    uint32_t now;           /**< Virtual time in slots */
+    uint32_t wakeups;       /**< Number of timer callbacks made */
+    uint32_t starts;        /**< Number of times the timer was started */
+} ns_timer_stub_def;
+
+extern ns_timer_stub_def ns_timer_stub;
+
+void ns_timer_stub_reset(void);
+
+/** Advance the virtual clock, calling the timer callback when it is due */
+void ns_timer_stub_advance(uint32_t slots);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NS_TIMER_STUB_H_ */
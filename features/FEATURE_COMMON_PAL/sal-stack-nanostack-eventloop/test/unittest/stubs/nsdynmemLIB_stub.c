@@ -0,0 +1,20 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ */
+#include "nsdynmemLIB.h"
+#include <stdlib.h>
+
+void *ns_dyn_mem_alloc(int16_t alloc_size)
+{
+    return malloc(alloc_size);
+}
+
+void *ns_dyn_mem_temporary_alloc(int16_t alloc_size)
+{
+    return malloc(alloc_size);
+}
+
+void ns_dyn_mem_free(void *block)
+{
+    free(block);
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ */
+
+/* The platform hooks of the event loop on POSIX threads, so that events can
+ * be posted from other threads while one thread runs the scheduler. The
+ * critical section is a recursive mutex standing in for masked interrupts. */
+
+#include <pthread.h>
+#include "ns_types.h"
+#include "eventOS_scheduler.h"
+#include "platform/arm_hal_interrupt.h"
+#include "platform_posix.h"
+
+static pthread_mutex_t critical_mutex;
+static pthread_mutex_t event_mutex;
+static pthread_mutex_t signal_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t signal_cond = PTHREAD_COND_INITIALIZER;
+static bool signalled;
+static pthread_once_t init_once = PTHREAD_ONCE_INIT;
+
+static void platform_posix_init_once(void)
+{
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&critical_mutex, &attr);
+    pthread_mutex_init(&event_mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+void platform_posix_init(void)
+{
+    pthread_once(&init_once, platform_posix_init_once);
+    signalled = false;
+}
+
+void platform_enter_critical(void)
+{
+    pthread_once(&init_once, platform_posix_init_once);
+    pthread_mutex_lock(&critical_mutex);
+}
+
+void platform_exit_critical(void)
+{
+    pthread_mutex_unlock(&critical_mutex);
+}
+
+void eventOS_scheduler_mutex_wait(void)
+{
+    pthread_mutex_lock(&event_mutex);
+}
+
+void eventOS_scheduler_mutex_release(void)
+{
+    pthread_mutex_unlock(&event_mutex);
+}
+
+void eventOS_scheduler_signal(void)
+{
+    pthread_mutex_lock(&signal_mutex);
+    signalled = true;
+    pthread_cond_signal(&signal_cond);
+    pthread_mutex_unlock(&signal_mutex);
+}
+
+void eventOS_scheduler_idle(void)
+{
+    eventOS_scheduler_mutex_release();
+    pthread_mutex_lock(&signal_mutex);
+    while (!signalled) {
+        pthread_cond_wait(&signal_cond, &signal_mutex);
+    }
+    signalled = false;
+    pthread_mutex_unlock(&signal_mutex);
+    eventOS_scheduler_mutex_wait();
+}
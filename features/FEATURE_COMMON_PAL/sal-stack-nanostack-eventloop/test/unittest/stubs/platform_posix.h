@@ -0,0 +1,18 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ */
+#ifndef PLATFORM_POSIX_H_
+#define PLATFORM_POSIX_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Reset the scheduler signal, call before eventOS_scheduler_init() */
+void platform_posix_init(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PLATFORM_POSIX_H_ */
@@ -0,0 +1,28 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ */
+#include "ns_types.h"
+#include "timer_sys.h"
+#include "ns_timer.h"
+
+void timer_sys_init(void)
+{
+}
+
+int8_t timer_sys_wakeup(void)
+{
+    return 0;
+}
+
+void timer_sys_disable(void)
+{
+}
+
+void system_timer_tick_update(uint32_t ticks)
+{
+}
+
+int8_t ns_timer_sleep(void)
+{
+    return 0;
+}
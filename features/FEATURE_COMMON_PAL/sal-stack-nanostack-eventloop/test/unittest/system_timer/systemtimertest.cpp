@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ */
+#include "CppUTest/TestHarness.h"
+#include "eventOS_event_timer.h"
+#include "eventloop_config.h"
+#include "timer_sys.h"
+#include "event_stub.h"
+#include "ns_timer_stub.h"
+#include <stdio.h>
+#include <string.h>
+
+/* The system timer on a virtual clock. Timers expire at the same times with
+ * the periodic tick and in tickless mode (NS_EVENTLOOP_TICKLESS), which only
+ * wakes up for deadlines. */
+
+#define SLOTS_PER_MS    20
+#define TASKLET         1
+
+static void advance_ms(uint32_t ms)
+{
+    // A millisecond at a time, so that events record when they were sent
+    for (uint32_t i = 0; i < ms; i++) {
+        ns_timer_stub_advance(SLOTS_PER_MS);
+    }
+}
+
+static uint32_t sent_ms(int event)
+{
+    return event_stub.time[event] / SLOTS_PER_MS;
+}
+
+TEST_GROUP(system_timer)
+{
+    void setup() {
+        ns_timer_stub_reset();
+        memset(&event_stub, 0, sizeof(event_stub));
+        timer_sys_init();
+    }
+
+    void teardown() {
+    }
+};
+
+TEST(system_timer, expire_in_deadline_order)
+{
+    CHECK(eventOS_event_timer_request(1, 0, TASKLET, 500) == 0);
+    CHECK(eventOS_event_timer_request(2, 0, TASKLET, 100) == 0);
+    CHECK(eventOS_event_timer_request(3, 0, TASKLET, 300) == 0);
+    CHECK(eventOS_event_timer_request(4, 0, TASKLET, 100) == 0);
+
+    advance_ms(600);
+
+    // Requests are rounded up to the next 10 ms tick, plus one
+    CHECK(event_stub.count == 4);
+    CHECK(event_stub.events[0].event_id == 2 && sent_ms(0) == 110);
+    CHECK(event_stub.events[1].event_id == 4 && sent_ms(1) == 110);
+    CHECK(event_stub.events[2].event_id == 3 && sent_ms(2) == 310);
+    CHECK(event_stub.events[3].event_id == 1 && sent_ms(3) == 510);
+    CHECK(event_stub.events[0].receiver == TASKLET);
+    CHECK(event_stub.events[0].priority == ARM_LIB_MED_PRIORITY_EVENT);
+    CHECK(eventOS_event_timer_shortest_active_timer() == 0);
+}
+
+TEST(system_timer, earlier_request_while_waiting)
+{
+    CHECK(eventOS_event_timer_request(1, 0, TASKLET, 5000) == 0);
+    advance_ms(1234);
+    CHECK(eventOS_event_timer_shortest_active_timer() == 5010 - 1230);
+
+    CHECK(eventOS_event_timer_request(2, 0, TASKLET, 100) == 0);
+    advance_ms(5000);
+
+    CHECK(event_stub.count == 2);
+    CHECK(event_stub.events[0].event_id == 2 && sent_ms(0) == 1340);
+    CHECK(event_stub.events[1].event_id == 1 && sent_ms(1) == 5010);
+}
+
+TEST(system_timer, cancel)
+{
+    CHECK(eventOS_event_timer_request(1, 0, TASKLET, 100) == 0);
+    CHECK(eventOS_event_timer_request(2, 0, TASKLET, 200) == 0);
+    advance_ms(50);
+    CHECK(eventOS_event_timer_cancel(1, TASKLET) == 0);
+    CHECK(eventOS_event_timer_cancel(1, TASKLET) == -1);
+    CHECK(eventOS_event_timer_shortest_active_timer() == 160);
+    CHECK(eventOS_event_timer_cancel(2, TASKLET) == 0);
+    advance_ms(500);
+    CHECK(event_stub.count == 0);
+}
+
+TEST(system_timer, sleep)
+{
+    CHECK(eventOS_event_timer_request(1, 0, TASKLET, 1000) == 0);
+    advance_ms(305);
+
+    // As eventOS_scheduler_timer_stop() and _synch_after_sleep()
+    timer_sys_disable();
+    ns_timer_stub_advance(500 * SLOTS_PER_MS);
+    system_timer_tick_update(500 / 10 + 1);
+    timer_sys_wakeup();
+    CHECK(event_stub.count == 0);
+
+    advance_ms(1000);
+    CHECK(event_stub.count == 1);
+    CHECK(sent_ms(0) >= 1000 && sent_ms(0) <= 1010);
+}
+
+TEST(system_timer, many_timers)
+{
+    // Neighbour and route lifetimes of a large node
+    for (int i = 0; i < 300; i++) {
+        CHECK(eventOS_event_timer_request(i, 0, TASKLET, 1000 * (1 + (i * 7) % 60)) == 0);
+    }
+    uint32_t wakeups = ns_timer_stub.wakeups;
+    advance_ms(61000);
+    wakeups = ns_timer_stub.wakeups - wakeups;
+
+    CHECK(event_stub.count == 300);
+    for (int i = 1; i < 300; i++) {
+        CHECK(event_stub.time[i - 1] <= event_stub.time[i]);
+    }
+    printf("\n300 timers over 61 s: %lu wakeups\n", (unsigned long)wakeups);
+#ifdef NS_EVENTLOOP_TICKLESS
+    // One per distinct deadline
+    CHECK(wakeups == 60);
+#else
+    CHECK(wakeups == 6100);
+#endif
+}
@@ -0,0 +1,7 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ */
+
+/* The system timer built in tickless mode, in place of ../../../source/system_timer.c */
+#define MBED_CONF_NANOSTACK_EVENTLOOP_TICKLESS 1
+#include "../../../source/system_timer.c"
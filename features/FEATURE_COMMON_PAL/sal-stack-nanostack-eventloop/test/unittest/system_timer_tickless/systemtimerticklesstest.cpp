@@ -0,0 +1,7 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ */
+
+/* The system_timer tests, against system_timer_tickless.c */
+#define MBED_CONF_NANOSTACK_EVENTLOOP_TICKLESS 1
+#include "../system_timer/systemtimertest.cpp"
@@ -0,0 +1,263 @@
+/**
+ * \file mbed_accel.h
+ *
+ * \brief Runtime registry for asynchronous crypto accelerators
+ *
+ *  Copyright (C) 2006-2016, ARM Limited, All Rights Reserved
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *  not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  This file is part of mbed TLS (https://tls.mbed.org)
+ */
+#ifndef MBEDTLS_ACCEL_H
+#define MBEDTLS_ACCEL_H
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(MBEDTLS_ECP_C)
+#include "mbedtls/ecp.h"
+#endif
+
+/*
+ * Low-level error codes, taken from the unassigned 0x0070-0x0076 range.
+ */
+#define MBEDTLS_ERR_ACCEL_BUSY                  -0x0070  /**< Accelerator queue is full. */
+#define MBEDTLS_ERR_ACCEL_BAD_INPUT             -0x0072  /**< Bad input parameters to function. */
+#define MBEDTLS_ERR_ACCEL_FEATURE_UNAVAILABLE   -0x0074  /**< No accelerator and no software implementation for the operation. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief          Operations an accelerator can register for
+ */
+typedef enum {
+    MBEDTLS_ACCEL_OP_AES_ECB = 0,   /**< AES-ECB over a whole number of blocks */
+    MBEDTLS_ACCEL_OP_GCM,           /**< AES-GCM encrypt-and-tag / decrypt-and-verify */
+    MBEDTLS_ACCEL_OP_SHA256,        /**< SHA-224/SHA-256 over a single buffer */
+    MBEDTLS_ACCEL_OP_ECP_MUL,       /**< Elliptic curve scalar multiplication */
+    MBEDTLS_ACCEL_OP_COUNT
+} mbedtls_accel_op_t;
+
+#define MBEDTLS_ACCEL_OP_MASK(op)   (1u << (op))
+
+typedef struct mbedtls_accel_request mbedtls_accel_request_t;
+typedef struct mbedtls_accel_driver mbedtls_accel_driver_t;
+
+/**
+ * \brief          Completion callback
+ *
+ * \param req      The request that completed
+ * \param status   0 on success, or an MBEDTLS_ERR_XXX code
+ *
+ * \note           Called from the accelerator's completion context (which
+ *                 may be an interrupt) or, for software fallback, from
+ *                 the context that called mbedtls_accel_submit().
+ */
+typedef void (*mbedtls_accel_callback_t)( mbedtls_accel_request_t *req, int status );
+
+/**
+ * \brief          Operation request
+ *
+ *                 Filled in by the caller and owned by the caller until
+ *                 the completion callback fires. All buffers referenced
+ *                 by the request must stay valid for that long.
+ */
+struct mbedtls_accel_request
+{
+    mbedtls_accel_op_t op;              /*!< operation to perform        */
+
+    union
+    {
+        struct
+        {
+            const unsigned char *key;   /*!< AES key                     */
+            unsigned int keybits;       /*!< 128, 192 or 256             */
+            int mode;                   /*!< MBEDTLS_AES_ENCRYPT/DECRYPT */
+            size_t length;              /*!< multiple of 16 bytes        */
+            const unsigned char *input;
+            unsigned char *output;
+        } aes;
+
+        struct
+        {
+            const unsigned char *key;   /*!< AES key                     */
+            unsigned int keybits;       /*!< 128, 192 or 256             */
+            int mode;                   /*!< MBEDTLS_GCM_ENCRYPT/DECRYPT */
+            size_t length;
+            const unsigned char *iv;
+            size_t iv_len;
+            const unsigned char *add;
+            size_t add_len;
+            const unsigned char *input;
+            unsigned char *output;
+            size_t tag_len;
+            unsigned char *tag;         /*!< written on encrypt, checked on decrypt */
+        } gcm;
+
+        struct
+        {
+            const unsigned char *input;
+            size_t ilen;
+            unsigned char *output;      /*!< 32 bytes                    */
+            int is224;
+        } sha256;
+
+#if defined(MBEDTLS_ECP_C)
+        struct
+        {
+            mbedtls_ecp_group *grp;
+            mbedtls_ecp_point *R;
+            const mbedtls_mpi *m;
+            const mbedtls_ecp_point *P;
+            int (*f_rng)(void *, unsigned char *, size_t);
+            void *p_rng;
+        } ecp;
+#endif
+    } u;
+
+    mbedtls_accel_callback_t callback;  /*!< completion callback         */
+    void *context;                      /*!< opaque user data            */
+
+    /* Private, managed by the registry */
+    mbedtls_accel_driver_t *driver;     /*!< driver running the request  */
+};
+
+/**
+ * \brief          Accelerator driver
+ *
+ *                 Statically allocated by the driver and handed to
+ *                 mbedtls_accel_register(). The registry keeps a pointer
+ *                 to it until mbedtls_accel_unregister() is called.
+ */
+struct mbedtls_accel_driver
+{
+    const char *name;                   /*!< for diagnostics             */
+    uint32_t ops;                       /*!< MBEDTLS_ACCEL_OP_MASK() set */
+    uint32_t max_depth;                 /*!< requests in flight, 0 = unlimited */
+
+    /**
+     * Start a request. Return 0 if the request was accepted, in which case
+     * the driver must call mbedtls_accel_complete() exactly once later on,
+     * or MBEDTLS_ERR_ACCEL_BUSY to let the registry try the next driver
+     * or fall back to software. Must not block.
+     */
+    int (*submit)( mbedtls_accel_driver_t *drv, mbedtls_accel_request_t *req );
+
+    void *context;                      /*!< driver private data         */
+
+    /* Private, managed by the registry */
+    uint32_t depth;                     /*!< requests currently in flight */
+    mbedtls_accel_driver_t *next;
+};
+
+/**
+ * \brief          Per-operation statistics
+ */
+typedef struct
+{
+    uint32_t submitted;         /*!< requests passed to mbedtls_accel_submit() */
+    uint32_t accelerated;       /*!< requests completed by a driver            */
+    uint32_t fallback;          /*!< requests run in software                  */
+    uint32_t busy;              /*!< driver rejections due to a full queue     */
+    uint32_t errors;            /*!< requests completed with non-zero status   */
+    uint32_t depth;             /*!< requests currently queued on drivers      */
+    uint32_t max_depth;         /*!< high-water mark of depth                  */
+} mbedtls_accel_stats_t;
+
+/**
+ * \brief          Register an accelerator
+ *
+ *                 Drivers registered later take precedence over earlier
+ *                 ones for the operations they both support.
+ *
+ * \param drv      driver to register
+ *
+ * \return         0 if successful, or MBEDTLS_ERR_ACCEL_BAD_INPUT
+ */
+int mbedtls_accel_register( mbedtls_accel_driver_t *drv );
+
+/**
+ * \brief          Unregister an accelerator
+ *
+ * \param drv      driver to unregister, must have no requests in flight
+ *
+ * \return         0 if successful, MBEDTLS_ERR_ACCEL_BUSY if requests are
+ *                 still in flight, or MBEDTLS_ERR_ACCEL_BAD_INPUT if the
+ *                 driver was not registered
+ */
+int mbedtls_accel_unregister( mbedtls_accel_driver_t *drv );
+
+/**
+ * \brief          Submit an operation
+ *
+ *                 The request is offered to each registered driver that
+ *                 supports the operation and has room in its queue. If none
+ *                 accepts it, the operation runs synchronously in software
+ *                 and the callback fires before this function returns.
+ *
+ * \param req      request to run, with op, parameters and callback set
+ *
+ * \return         0 if the request was accepted (the final status is
+ *                 passed to the callback), or MBEDTLS_ERR_ACCEL_BAD_INPUT
+ */
+int mbedtls_accel_submit( mbedtls_accel_request_t *req );
+
+/**
+ * \brief          Complete a request (for use by drivers)
+ *
+ *                 Safe to call from interrupt context.
+ *
+ * \param req      request previously accepted by the driver's submit()
+ * \param status   0 on success, or an MBEDTLS_ERR_XXX code
+ */
+void mbedtls_accel_complete( mbedtls_accel_request_t *req, int status );
+
+/**
+ * \brief          Run an operation in software, synchronously
+ *
+ * \param req      request to run; its callback is not invoked
+ *
+ * \return         0 if successful, or an MBEDTLS_ERR_XXX code
+ */
+int mbedtls_accel_run_software( const mbedtls_accel_request_t *req );
+
+/**
+ * \brief          Read the statistics for an operation
+ *
+ * \param op       operation
+ * \param stats    filled with a snapshot of the counters
+ */
+void mbedtls_accel_get_stats( mbedtls_accel_op_t op, mbedtls_accel_stats_t *stats );
+
+/**
+ * \brief          Reset the counters for all operations
+ *
+ *                 The depth counters are left untouched.
+ */
+void mbedtls_accel_reset_stats( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MBEDTLS_ACCEL_H */
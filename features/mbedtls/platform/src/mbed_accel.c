@@ -0,0 +1,292 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2016 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mbed_accel.h"
+#include "platform/critical.h"
+
+#include <string.h>
+
+#if defined(MBEDTLS_AES_C)
+#include "mbedtls/aes.h"
+#endif
+#if defined(MBEDTLS_GCM_C)
+#include "mbedtls/gcm.h"
+#endif
+#if defined(MBEDTLS_SHA256_C)
+#include "mbedtls/sha256.h"
+#endif
+
+/* Registered drivers, most recently registered first */
+static mbedtls_accel_driver_t *accel_drivers = NULL;
+
+static mbedtls_accel_stats_t accel_stats[MBEDTLS_ACCEL_OP_COUNT];
+
+int mbedtls_accel_register( mbedtls_accel_driver_t *drv )
+{
+    if( drv == NULL || drv->submit == NULL || drv->ops == 0 )
+        return( MBEDTLS_ERR_ACCEL_BAD_INPUT );
+
+    drv->depth = 0;
+
+    core_util_critical_section_enter();
+    drv->next = accel_drivers;
+    accel_drivers = drv;
+    core_util_critical_section_exit();
+
+    return( 0 );
+}
+
+int mbedtls_accel_unregister( mbedtls_accel_driver_t *drv )
+{
+    mbedtls_accel_driver_t **p;
+    int ret = MBEDTLS_ERR_ACCEL_BAD_INPUT;
+
+    core_util_critical_section_enter();
+    for( p = &accel_drivers; *p != NULL; p = &(*p)->next )
+    {
+        if( *p != drv )
+            continue;
+
+        if( drv->depth != 0 )
+        {
+            ret = MBEDTLS_ERR_ACCEL_BUSY;
+        }
+        else
+        {
+            *p = drv->next;
+            drv->next = NULL;
+            ret = 0;
+        }
+        break;
+    }
+    core_util_critical_section_exit();
+
+    return( ret );
+}
+
+/*
+ * Reserve a queue slot on the next driver, after 'prev', that supports
+ * the operation and is not full. Returns NULL if there is none.
+ */
+static mbedtls_accel_driver_t *accel_reserve( mbedtls_accel_driver_t *prev,
+                                              mbedtls_accel_op_t op )
+{
+    mbedtls_accel_driver_t *drv;
+    mbedtls_accel_stats_t *stats = &accel_stats[op];
+
+    core_util_critical_section_enter();
+    for( drv = prev ? prev->next : accel_drivers; drv != NULL; drv = drv->next )
+    {
+        if( !( drv->ops & MBEDTLS_ACCEL_OP_MASK( op ) ) )
+            continue;
+
+        if( drv->max_depth != 0 && drv->depth >= drv->max_depth )
+        {
+            stats->busy++;
+            continue;
+        }
+
+        drv->depth++;
+        stats->depth++;
+        if( stats->depth > stats->max_depth )
+            stats->max_depth = stats->depth;
+        break;
+    }
+    core_util_critical_section_exit();
+
+    return( drv );
+}
+
+static void accel_release( mbedtls_accel_driver_t *drv, mbedtls_accel_op_t op )
+{
+    core_util_critical_section_enter();
+    drv->depth--;
+    accel_stats[op].depth--;
+    core_util_critical_section_exit();
+}
+
+int mbedtls_accel_submit( mbedtls_accel_request_t *req )
+{
+    mbedtls_accel_driver_t *drv = NULL;
+    int ret;
+
+    if( req == NULL || req->op >= MBEDTLS_ACCEL_OP_COUNT || req->callback == NULL )
+        return( MBEDTLS_ERR_ACCEL_BAD_INPUT );
+
+    core_util_atomic_incr_u32( &accel_stats[req->op].submitted, 1 );
+
+    while( ( drv = accel_reserve( drv, req->op ) ) != NULL )
+    {
+        req->driver = drv;
+        ret = drv->submit( drv, req );
+        if( ret == 0 )
+            return( 0 );
+
+        /* The slot was never used, give it back before trying the next one */
+        req->driver = NULL;
+        accel_release( drv, req->op );
+        core_util_atomic_incr_u32( &accel_stats[req->op].busy, 1 );
+    }
+
+    core_util_atomic_incr_u32( &accel_stats[req->op].fallback, 1 );
+    ret = mbedtls_accel_run_software( req );
+    if( ret != 0 )
+        core_util_atomic_incr_u32( &accel_stats[req->op].errors, 1 );
+
+    req->callback( req, ret );
+
+    return( 0 );
+}
+
+void mbedtls_accel_complete( mbedtls_accel_request_t *req, int status )
+{
+    mbedtls_accel_driver_t *drv = req->driver;
+
+    req->driver = NULL;
+    accel_release( drv, req->op );
+
+    core_util_atomic_incr_u32( &accel_stats[req->op].accelerated, 1 );
+    if( status != 0 )
+        core_util_atomic_incr_u32( &accel_stats[req->op].errors, 1 );
+
+    req->callback( req, status );
+}
+
+#if defined(MBEDTLS_AES_C)
+static int accel_sw_aes_ecb( const mbedtls_accel_request_t *req )
+{
+    mbedtls_aes_context ctx;
+    size_t offset;
+    int ret;
+
+    if( req->u.aes.length % 16 != 0 )
+        return( MBEDTLS_ERR_AES_INVALID_INPUT_LENGTH );
+
+    mbedtls_aes_init( &ctx );
+
+    if( req->u.aes.mode == MBEDTLS_AES_ENCRYPT )
+        ret = mbedtls_aes_setkey_enc( &ctx, req->u.aes.key, req->u.aes.keybits );
+    else
+        ret = mbedtls_aes_setkey_dec( &ctx, req->u.aes.key, req->u.aes.keybits );
+
+    for( offset = 0; ret == 0 && offset < req->u.aes.length; offset += 16 )
+    {
+        ret = mbedtls_aes_crypt_ecb( &ctx, req->u.aes.mode,
+                                     req->u.aes.input + offset,
+                                     req->u.aes.output + offset );
+    }
+
+    mbedtls_aes_free( &ctx );
+
+    return( ret );
+}
+#endif /* MBEDTLS_AES_C */
+
+#if defined(MBEDTLS_GCM_C)
+static int accel_sw_gcm( const mbedtls_accel_request_t *req )
+{
+    mbedtls_gcm_context ctx;
+    int ret;
+
+    mbedtls_gcm_init( &ctx );
+
+    ret = mbedtls_gcm_setkey( &ctx, MBEDTLS_CIPHER_ID_AES,
+                              req->u.gcm.key, req->u.gcm.keybits );
+    if( ret != 0 )
+        goto exit;
+
+    if( req->u.gcm.mode == MBEDTLS_GCM_ENCRYPT )
+    {
+        ret = mbedtls_gcm_crypt_and_tag( &ctx, MBEDTLS_GCM_ENCRYPT,
+                                         req->u.gcm.length,
+                                         req->u.gcm.iv, req->u.gcm.iv_len,
+                                         req->u.gcm.add, req->u.gcm.add_len,
+                                         req->u.gcm.input, req->u.gcm.output,
+                                         req->u.gcm.tag_len, req->u.gcm.tag );
+    }
+    else
+    {
+        ret = mbedtls_gcm_auth_decrypt( &ctx, req->u.gcm.length,
+                                        req->u.gcm.iv, req->u.gcm.iv_len,
+                                        req->u.gcm.add, req->u.gcm.add_len,
+                                        req->u.gcm.tag, req->u.gcm.tag_len,
+                                        req->u.gcm.input, req->u.gcm.output );
+    }
+
+exit:
+    mbedtls_gcm_free( &ctx );
+
+    return( ret );
+}
+#endif /* MBEDTLS_GCM_C */
+
+int mbedtls_accel_run_software( const mbedtls_accel_request_t *req )
+{
+    switch( req->op )
+    {
+#if defined(MBEDTLS_AES_C)
+        case MBEDTLS_ACCEL_OP_AES_ECB:
+            return( accel_sw_aes_ecb( req ) );
+#endif
+
+#if defined(MBEDTLS_GCM_C)
+        case MBEDTLS_ACCEL_OP_GCM:
+            return( accel_sw_gcm( req ) );
+#endif
+
+#if defined(MBEDTLS_SHA256_C)
+        case MBEDTLS_ACCEL_OP_SHA256:
+            mbedtls_sha256( req->u.sha256.input, req->u.sha256.ilen,
+                            req->u.sha256.output, req->u.sha256.is224 );
+            return( 0 );
+#endif
+
+#if defined(MBEDTLS_ECP_C)
+        case MBEDTLS_ACCEL_OP_ECP_MUL:
+            return( mbedtls_ecp_mul( req->u.ecp.grp, req->u.ecp.R,
+                                     req->u.ecp.m, req->u.ecp.P,
+                                     req->u.ecp.f_rng, req->u.ecp.p_rng ) );
+#endif
+
+        default:
+            return( MBEDTLS_ERR_ACCEL_FEATURE_UNAVAILABLE );
+    }
+}
+
+void mbedtls_accel_get_stats( mbedtls_accel_op_t op, mbedtls_accel_stats_t *stats )
+{
+    if( op >= MBEDTLS_ACCEL_OP_COUNT || stats == NULL )
+        return;
+
+    core_util_critical_section_enter();
+    memcpy( stats, &accel_stats[op], sizeof( *stats ) );
+    core_util_critical_section_exit();
+}
+
+void mbedtls_accel_reset_stats( void )
+{
+    int op;
+
+    core_util_critical_section_enter();
+    for( op = 0; op < MBEDTLS_ACCEL_OP_COUNT; op++ )
+    {
+        uint32_t depth = accel_stats[op].depth;
+        memset( &accel_stats[op], 0, sizeof( accel_stats[op] ) );
+        accel_stats[op].depth = depth;
+        accel_stats[op].max_depth = depth;
+    }
+    core_util_critical_section_exit();
+}
@@ -0,0 +1,298 @@
+/*
+ * mbed Microcontroller Library
+ * Copyright (c) 2006-2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/** @file batch.cpp Test cases for drv->BeginBatch() and drv->EndBatch().
+ *
+ * Please consult the documentation under the test-case functions for
+ * a description of the individual test case.
+ */
+
+#include "mbed.h"
+#include "cfstore_config.h"
+#include "cfstore_test.h"
+#include "cfstore_debug.h"
+#include "Driver_Common.h"
+#include "configuration_store.h"
+#include "utest/utest.h"
+#include "unity/unity.h"
+#include "greentea-client/test_env.h"
+#include "cfstore_utest.h"
+#ifdef YOTTA_CFG_CFSTORE_UVISOR
+#include "uvisor-lib/uvisor-lib.h"
+#endif /* YOTTA_CFG_CFSTORE_UVISOR */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+using namespace utest::v1;
+
+static char cfstore_batch_utest_msg_g[CFSTORE_UTEST_MSG_BUF_SIZE];
+
+/* Configure secure box. */
+#ifdef YOTTA_CFG_CFSTORE_UVISOR
+UVISOR_BOX_NAMESPACE("com.arm.mbed.cfstore.test.batch.box1");
+UVISOR_BOX_CONFIG(cfstore_batch_box1, UVISOR_BOX_STACK_SIZE);
+#endif /* YOTTA_CFG_CFSTORE_UVISOR */
+
+/// @cond CFSTORE_DOXYGEN_DISABLE
+#ifdef CFSTORE_DEBUG
+#define CFSTORE_BATCH_GREENTEA_TIMEOUT_S     360
+#else
+#define CFSTORE_BATCH_GREENTEA_TIMEOUT_S     60
+#endif
+#define CFSTORE_BATCH_TEST_02_KEY_PREFIX     "b.k."
+#define CFSTORE_BATCH_TEST_02_KEY_COUNT      1000
+
+static cfstore_kv_data_t cfstore_batch_test_01_data[] = {
+        { "com.arm.mbed.batch.a.1", "1"},
+        { "com.arm.mbed.batch.b.1", "22"},
+        { "com.arm.mbed.batch.a.2", "333"},
+        { "com.arm.mbed.batch.b.2", "4444"},
+        { "com.arm.mbed.batch.a.3", "55555"},
+        { "com.arm.mbed.batch.b.3", "666666"},
+        { "com.arm.mbed.batch.a.4", "7777777"},
+        { NULL, NULL},
+};
+
+static ARM_CFSTORE_KEYDESC cfstore_batch_kdesc_g;
+/// @endcond
+
+
+/* report whether built/configured for flash sync or async mode */
+static control_t cfstore_batch_test_00(const size_t call_count)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+
+    (void) call_count;
+    ret = cfstore_test_startup();
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_batch_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to perform test startup (ret=%d).\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_batch_utest_msg_g);
+    return CaseNext;
+}
+
+
+/* @brief   check the KVs of the table named "*.b.*" are absent and the
+ *          others hold their values */
+static void cfstore_batch_test_01_check(const char* func)
+{
+    char value[CFSTORE_KEY_NAME_MAX_LENGTH+1];
+    int32_t ret = ARM_DRIVER_ERROR;
+    ARM_CFSTORE_SIZE len = 0;
+    cfstore_kv_data_t* node = cfstore_batch_test_01_data;
+    bool bfound = false;
+
+    while(node->key_name != NULL)
+    {
+        ret = cfstore_test_kv_is_found(node->key_name, &bfound);
+        CFSTORE_TEST_UTEST_MESSAGE(cfstore_batch_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: unexpected Find() result for %s (ret=%d).\n", func, node->key_name, (int) ret);
+        TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK || ret == ARM_CFSTORE_DRIVER_ERROR_KEY_NOT_FOUND, cfstore_batch_utest_msg_g);
+        TEST_ASSERT_MESSAGE(bfound == (strstr(node->key_name, ".b.") == NULL), cfstore_batch_utest_msg_g);
+        if(bfound){
+            len = sizeof(value);
+            ret = cfstore_test_read(node->key_name, value, &len);
+            TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_batch_utest_msg_g);
+            TEST_ASSERT_MESSAGE(len == strlen(node->value) && strncmp(value, node->value, len) == 0, cfstore_batch_utest_msg_g);
+        }
+        node++;
+    }
+}
+
+
+/** @brief  test KVs deleted inside a batch are no longer found, while the
+ *          KVs following them in the area keep their values and open
+ *          handles remain usable after EndBatch() has compacted the area.
+ *
+ * @return on success returns CaseNext to continue to next test case, otherwise will assert on errors.
+ */
+control_t cfstore_batch_test_01_end(const size_t call_count)
+{
+    char value[CFSTORE_KEY_NAME_MAX_LENGTH+1];
+    int32_t ret = ARM_DRIVER_ERROR;
+    ARM_CFSTORE_SIZE len = 0;
+    ARM_CFSTORE_DRIVER* drv = &cfstore_driver;
+    ARM_CFSTORE_HANDLE_INIT(hkey);
+    ARM_CFSTORE_FMODE flags;
+
+    (void) call_count;
+    memset(&flags, 0, sizeof(flags));
+    ret = cfstore_test_create_table(cfstore_batch_test_01_data);
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_batch_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to create KVs (ret=%d).\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_batch_utest_msg_g);
+
+    /* EndBatch() without BeginBatch() is an error */
+    ret = drv->EndBatch();
+    TEST_ASSERT_MESSAGE(ret < ARM_DRIVER_OK, "EndBatch() without BeginBatch() should fail");
+
+    ret = drv->BeginBatch(0);
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_batch_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: BeginBatch() failed (ret=%d).\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_batch_utest_msg_g);
+    /* nested batch */
+    ret = drv->BeginBatch(0);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_batch_utest_msg_g);
+
+    /* hold a handle on a KV following the KVs to be deleted */
+    ret = drv->Open("com.arm.mbed.batch.a.4", flags, hkey);
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_batch_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to open KV (ret=%d).\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_batch_utest_msg_g);
+
+    ret = cfstore_test_delete("com.arm.mbed.batch.b.1");
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_batch_utest_msg_g);
+    ret = cfstore_test_delete("com.arm.mbed.batch.b.2");
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_batch_utest_msg_g);
+    ret = cfstore_test_delete("com.arm.mbed.batch.b.3");
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_batch_utest_msg_g);
+    cfstore_batch_test_01_check(__func__);
+
+    /* a KV deleted in the batch can be created again */
+    len = 1;
+    ret = cfstore_test_create("com.arm.mbed.batch.c.1", "x", &len, &cfstore_batch_kdesc_g);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_batch_utest_msg_g);
+
+    /* the inner EndBatch() leaves the batch open, the outer one compacts the area */
+    ret = drv->EndBatch();
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_batch_utest_msg_g);
+    cfstore_batch_test_01_check(__func__);
+    ret = drv->EndBatch();
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_batch_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: EndBatch() failed (ret=%d).\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_batch_utest_msg_g);
+    cfstore_batch_test_01_check(__func__);
+
+    /* the handle opened before the compaction refers to the moved KV */
+    len = sizeof(value);
+    ret = drv->Read(hkey, value, &len);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_batch_utest_msg_g);
+    TEST_ASSERT_MESSAGE(len == 7 && strncmp(value, "7777777", len) == 0, cfstore_batch_utest_msg_g);
+    drv->Close(hkey);
+
+    len = sizeof(value);
+    ret = cfstore_test_read("com.arm.mbed.batch.c.1", value, &len);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK && len == 1 && value[0] == 'x', cfstore_batch_utest_msg_g);
+
+    ret = cfstore_test_delete_all();
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_batch_utest_msg_g);
+    ret = drv->Uninitialize();
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_batch_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: Uninitialize() call failed.\n", __func__);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_batch_utest_msg_g);
+    return CaseNext;
+}
+
+
+/* @brief   create and then delete CFSTORE_BATCH_TEST_02_KEY_COUNT KVs,
+ *          optionally inside a batch, reporting the time taken */
+static void cfstore_batch_test_02_provision(bool batch)
+{
+    char key_name[CFSTORE_KEY_NAME_MAX_LENGTH+1];
+    int32_t ret = ARM_DRIVER_ERROR;
+    uint32_t i = 0;
+    uint32_t create_us = 0;
+    uint32_t delete_us = 0;
+    ARM_CFSTORE_SIZE len = 0;
+    ARM_CFSTORE_DRIVER* drv = &cfstore_driver;
+    Timer timer;
+
+    timer.start();
+    if(batch){
+        ret = drv->BeginBatch(CFSTORE_BATCH_TEST_02_KEY_COUNT * (sizeof(CFSTORE_BATCH_TEST_02_KEY_PREFIX) + 4));
+        TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_batch_utest_msg_g);
+    }
+    for(i = 0; i < CFSTORE_BATCH_TEST_02_KEY_COUNT; i++){
+        snprintf(key_name, sizeof(key_name), CFSTORE_BATCH_TEST_02_KEY_PREFIX "%04d", (int) i);
+        len = 1;
+        ret = cfstore_test_create(key_name, "v", &len, &cfstore_batch_kdesc_g);
+        CFSTORE_TEST_UTEST_MESSAGE(cfstore_batch_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to create KV %s (ret=%d).\n", __func__, key_name, (int) ret);
+        TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_batch_utest_msg_g);
+    }
+    if(batch){
+        ret = drv->EndBatch();
+        TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_batch_utest_msg_g);
+    }
+    timer.stop();
+    create_us = timer.read_us();
+
+    timer.reset();
+    timer.start();
+    if(batch){
+        ret = drv->BeginBatch(0);
+        TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_batch_utest_msg_g);
+    }
+    /* delete from the start of the area so every delete moves the following KVs unless batched */
+    for(i = 0; i < CFSTORE_BATCH_TEST_02_KEY_COUNT; i++){
+        snprintf(key_name, sizeof(key_name), CFSTORE_BATCH_TEST_02_KEY_PREFIX "%04d", (int) i);
+        ret = cfstore_test_delete(key_name);
+        CFSTORE_TEST_UTEST_MESSAGE(cfstore_batch_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to delete KV %s (ret=%d).\n", __func__, key_name, (int) ret);
+        TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_batch_utest_msg_g);
+    }
+    if(batch){
+        ret = drv->EndBatch();
+        TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_batch_utest_msg_g);
+    }
+    timer.stop();
+    delete_us = timer.read_us();
+    printf("%s: %s, %d, %d\n", __func__, batch ? "batch" : "no batch", (int) create_us, (int) delete_us);
+}
+
+
+/** @brief  benchmark provisioning CFSTORE_BATCH_TEST_02_KEY_COUNT KVs with
+ *          and without a batch.
+ *
+ * @return on success returns CaseNext to continue to next test case, otherwise will assert on errors.
+ */
+control_t cfstore_batch_test_02_end(const size_t call_count)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+    ARM_CFSTORE_DRIVER* drv = &cfstore_driver;
+
+    (void) call_count;
+    printf("%s: mode, create %d keys (us), delete %d keys (us)\n", __func__, CFSTORE_BATCH_TEST_02_KEY_COUNT, CFSTORE_BATCH_TEST_02_KEY_COUNT);
+    cfstore_batch_test_02_provision(false);
+    cfstore_batch_test_02_provision(true);
+
+    ret = drv->Uninitialize();
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_batch_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: Uninitialize() call failed.\n", __func__);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_batch_utest_msg_g);
+    return CaseNext;
+}
+
+
+/// @cond CFSTORE_DOXYGEN_DISABLE
+Case cases[] = {
+        Case("BATCH_test_00", cfstore_batch_test_00),
+        Case("BATCH_test_01_start", cfstore_utest_default_start),
+        Case("BATCH_test_01_end", cfstore_batch_test_01_end),
+        Case("BATCH_test_02_start", cfstore_utest_default_start),
+        Case("BATCH_test_02_end", cfstore_batch_test_02_end),
+};
+
+
+utest::v1::status_t greentea_setup(const size_t number_of_cases)
+{
+    GREENTEA_SETUP(CFSTORE_BATCH_GREENTEA_TIMEOUT_S, "default_auto");
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+/* Declare your test specification with a custom setup handler */
+Specification specification(greentea_setup, cases);
+
+
+int main()
+{
+    return !Harness::run(specification);
+}
+/// @endcond
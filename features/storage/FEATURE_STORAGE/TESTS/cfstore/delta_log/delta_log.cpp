@@ -0,0 +1,431 @@
+/*
+ * mbed Microcontroller Library
+ * Copyright (c) 2006-2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @file delta_log.cpp Test cases for the cfstore delta log.
+ *
+ * The delta log is exercised on a RAM backed storage volume which behaves like
+ * NOR flash (program only clears bits, erase sets whole sectors) and counts the
+ * bytes programmed and the sectors erased, so that the flash wear of a flush
+ * persisted as a delta can be compared with a full snapshot rewrite.
+ */
+
+#include "cfstore_delta.h"
+#include "Driver_Common.h"
+#include "utest/utest.h"
+#include "unity/unity.h"
+#include "greentea-client/test_env.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+using namespace utest::v1;
+
+/// @cond CFSTORE_DOXYGEN_DISABLE
+#define CFSTORE_DELTA_TEST_STORAGE_SIZE     (16 * 1024)
+#define CFSTORE_DELTA_TEST_SECTOR_SIZE      4096
+#define CFSTORE_DELTA_TEST_PROGRAM_UNIT     8
+#define CFSTORE_DELTA_TEST_NUM_KVS          32
+#define CFSTORE_DELTA_TEST_KV_SIZE          48
+#define CFSTORE_DELTA_TEST_MAX_RECORDS      16
+/// @endcond
+
+/*
+ * RAM backed storage volume
+ */
+static uint8_t cfstore_delta_test_storage_g[CFSTORE_DELTA_TEST_STORAGE_SIZE];
+static uint32_t cfstore_delta_test_programmed_g = 0;
+static uint32_t cfstore_delta_test_erased_g = 0;
+
+static ARM_DRIVER_VERSION cfstore_delta_test_get_version(void)
+{
+    ARM_DRIVER_VERSION version = { ARM_STORAGE_API_VERSION, ARM_DRIVER_VERSION_MAJOR_MINOR(1, 0) };
+    return version;
+}
+
+static ARM_STORAGE_CAPABILITIES cfstore_delta_test_get_capabilities(void)
+{
+    ARM_STORAGE_CAPABILITIES caps;
+
+    memset(&caps, 0, sizeof(caps));
+    return caps;
+}
+
+static int32_t cfstore_delta_test_initialize(ARM_Storage_Callback_t callback)
+{
+    (void) callback;
+    return 1;
+}
+
+static int32_t cfstore_delta_test_uninitialize(void) { return 1; }
+static int32_t cfstore_delta_test_power_control(ARM_POWER_STATE state) { (void) state; return 1; }
+
+static int32_t cfstore_delta_test_read_data(uint64_t addr, void *data, uint32_t size)
+{
+    if (addr + size > CFSTORE_DELTA_TEST_STORAGE_SIZE) {
+        return ARM_DRIVER_ERROR_PARAMETER;
+    }
+    memcpy(data, &cfstore_delta_test_storage_g[addr], size);
+    return size;
+}
+
+static int32_t cfstore_delta_test_program_data(uint64_t addr, const void *data, uint32_t size)
+{
+    const uint8_t *ptr = (const uint8_t *) data;
+
+    if (addr + size > CFSTORE_DELTA_TEST_STORAGE_SIZE || addr % CFSTORE_DELTA_TEST_PROGRAM_UNIT || size % CFSTORE_DELTA_TEST_PROGRAM_UNIT) {
+        return ARM_DRIVER_ERROR_PARAMETER;
+    }
+    for (uint32_t i = 0; i < size; i++) {
+        cfstore_delta_test_storage_g[addr + i] &= ptr[i];
+    }
+    cfstore_delta_test_programmed_g += size;
+    return size;
+}
+
+static int32_t cfstore_delta_test_erase(uint64_t addr, uint32_t size)
+{
+    if (addr + size > CFSTORE_DELTA_TEST_STORAGE_SIZE || addr % CFSTORE_DELTA_TEST_SECTOR_SIZE || size % CFSTORE_DELTA_TEST_SECTOR_SIZE) {
+        return ARM_DRIVER_ERROR_PARAMETER;
+    }
+    memset(&cfstore_delta_test_storage_g[addr], 0xff, size);
+    cfstore_delta_test_erased_g += size / CFSTORE_DELTA_TEST_SECTOR_SIZE;
+    return size;
+}
+
+static int32_t cfstore_delta_test_erase_all(void)
+{
+    return cfstore_delta_test_erase(0, CFSTORE_DELTA_TEST_STORAGE_SIZE);
+}
+
+static ARM_STORAGE_STATUS cfstore_delta_test_get_status(void)
+{
+    ARM_STORAGE_STATUS status;
+
+    memset(&status, 0, sizeof(status));
+    return status;
+}
+
+static int32_t cfstore_delta_test_get_info(ARM_STORAGE_INFO *info)
+{
+    memset(info, 0, sizeof(*info));
+    info->total_storage = CFSTORE_DELTA_TEST_STORAGE_SIZE;
+    info->program_unit = CFSTORE_DELTA_TEST_PROGRAM_UNIT;
+    info->optimal_program_unit = CFSTORE_DELTA_TEST_PROGRAM_UNIT;
+    info->program_cycles = ARM_STORAGE_PROGRAM_CYCLES_INFINITE;
+    info->erased_value = 1;
+    return ARM_DRIVER_OK;
+}
+
+static uint32_t cfstore_delta_test_resolve_address(uint64_t addr)
+{
+    return (uint32_t) addr;
+}
+
+static int32_t cfstore_delta_test_get_next_block(const ARM_STORAGE_BLOCK* prev_block, ARM_STORAGE_BLOCK *next_block)
+{
+    if (prev_block != NULL) {
+        next_block->addr = ARM_STORAGE_INVALID_OFFSET;
+        next_block->size = 0;
+        return ARM_DRIVER_ERROR;
+    }
+    memset(next_block, 0, sizeof(*next_block));
+    next_block->addr = 0;
+    next_block->size = CFSTORE_DELTA_TEST_STORAGE_SIZE;
+    next_block->attributes.erasable = 1;
+    next_block->attributes.programmable = 1;
+    next_block->attributes.erase_unit = CFSTORE_DELTA_TEST_SECTOR_SIZE;
+    next_block->attributes.protection_unit = CFSTORE_DELTA_TEST_SECTOR_SIZE;
+    return ARM_DRIVER_OK;
+}
+
+static int32_t cfstore_delta_test_get_block(uint64_t addr, ARM_STORAGE_BLOCK *block)
+{
+    if (addr >= CFSTORE_DELTA_TEST_STORAGE_SIZE) {
+        return ARM_DRIVER_ERROR;
+    }
+    return cfstore_delta_test_get_next_block(NULL, block);
+}
+
+static ARM_DRIVER_STORAGE cfstore_delta_test_mtd_g = {
+    cfstore_delta_test_get_version,
+    cfstore_delta_test_get_capabilities,
+    cfstore_delta_test_initialize,
+    cfstore_delta_test_uninitialize,
+    cfstore_delta_test_power_control,
+    cfstore_delta_test_read_data,
+    cfstore_delta_test_program_data,
+    cfstore_delta_test_erase,
+    cfstore_delta_test_erase_all,
+    cfstore_delta_test_get_status,
+    cfstore_delta_test_get_info,
+    cfstore_delta_test_resolve_address,
+    cfstore_delta_test_get_next_block,
+    cfstore_delta_test_get_block
+};
+
+
+/*
+ * replayed records
+ */
+typedef struct cfstore_delta_test_record_t
+{
+    uint8_t type;
+    uint32_t length;
+    uint8_t data[CFSTORE_DELTA_TEST_KV_SIZE];
+} cfstore_delta_test_record_t;
+
+static cfstore_delta_test_record_t cfstore_delta_test_records_g[CFSTORE_DELTA_TEST_MAX_RECORDS];
+static uint32_t cfstore_delta_test_num_records_g = 0;
+
+static int32_t cfstore_delta_test_apply(cfstore_delta_log_t *log, uint8_t type, uint32_t offset, uint32_t length, void *context)
+{
+    cfstore_delta_test_record_t *rec = &cfstore_delta_test_records_g[cfstore_delta_test_num_records_g];
+
+    (void) context;
+    TEST_ASSERT(cfstore_delta_test_num_records_g < CFSTORE_DELTA_TEST_MAX_RECORDS);
+    TEST_ASSERT(length <= sizeof(rec->data));
+    rec->type = type;
+    rec->length = length;
+    cfstore_delta_test_num_records_g++;
+    return cfstore_delta_read(log, offset, rec->data, length);
+}
+
+/* @brief   mount the log as done at cfstore initialisation, replaying it on the snapshot base_crc */
+static void cfstore_delta_test_mount(cfstore_delta_log_t *log, uint32_t base_crc)
+{
+    cfstore_delta_test_num_records_g = 0;
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, cfstore_delta_init(log, &cfstore_delta_test_mtd_g));
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, cfstore_delta_replay(log, base_crc, cfstore_delta_test_apply, NULL));
+}
+
+static void cfstore_delta_test_kv(uint8_t *kv, uint8_t id, uint8_t value)
+{
+    memset(kv, value, CFSTORE_DELTA_TEST_KV_SIZE);
+    kv[0] = id;
+}
+
+static void cfstore_delta_test_format(cfstore_delta_log_t *log, uint32_t base_crc)
+{
+    memset(cfstore_delta_test_storage_g, 0xff, sizeof(cfstore_delta_test_storage_g));
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, cfstore_delta_init(log, &cfstore_delta_test_mtd_g));
+    TEST_ASSERT_FALSE(log->formatted);
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, cfstore_delta_reset(log, base_crc));
+}
+
+
+/** @brief  A flush changing one KV programs a small record rather than
+ *          rewriting the whole store, and never erases.
+ */
+static control_t cfstore_delta_test_01(const size_t call_count)
+{
+    cfstore_delta_log_t log;
+    uint8_t kv[CFSTORE_DELTA_TEST_KV_SIZE];
+    uint32_t snapshot_size = CFSTORE_DELTA_TEST_NUM_KVS * CFSTORE_DELTA_TEST_KV_SIZE;
+    uint32_t erased = 0;
+
+    (void) call_count;
+    cfstore_delta_test_format(&log, 0);
+
+    for (uint8_t i = 0; i < 10; i++) {
+        cfstore_delta_test_programmed_g = 0;
+        erased = cfstore_delta_test_erased_g;
+        cfstore_delta_test_kv(kv, 1, i);
+        TEST_ASSERT_EQUAL(ARM_DRIVER_OK, cfstore_delta_append(&log, CFSTORE_DELTA_RECORD_PUT, kv, 4, kv + 4, sizeof(kv) - 4));
+        TEST_ASSERT_EQUAL(ARM_DRIVER_OK, cfstore_delta_append(&log, CFSTORE_DELTA_RECORD_END, NULL, 0, NULL, 0));
+        TEST_ASSERT_EQUAL(erased, cfstore_delta_test_erased_g);
+        TEST_ASSERT(cfstore_delta_test_programmed_g * 8 < snapshot_size);
+    }
+    printf("one KV changed: delta flush programs %u bytes, full snapshot %u bytes\r\n",
+           (unsigned) cfstore_delta_test_programmed_g, (unsigned) snapshot_size);
+
+    cfstore_delta_test_mount(&log, 0);
+    TEST_ASSERT_EQUAL(10, cfstore_delta_test_num_records_g);
+    TEST_ASSERT_EQUAL(CFSTORE_DELTA_RECORD_PUT, cfstore_delta_test_records_g[9].type);
+    TEST_ASSERT_EQUAL(sizeof(kv), cfstore_delta_test_records_g[9].length);
+    TEST_ASSERT_EQUAL(0, memcmp(cfstore_delta_test_records_g[9].data, kv, sizeof(kv)));
+    TEST_ASSERT_FALSE(log.needs_compaction);
+    return CaseNext;
+}
+
+
+/** @brief  Records are replayed in order, and the log can be appended to after mounting. */
+static control_t cfstore_delta_test_02(const size_t call_count)
+{
+    cfstore_delta_log_t log;
+    uint8_t kv[CFSTORE_DELTA_TEST_KV_SIZE];
+    const char *name = "com.arm.mbed.test";
+
+    (void) call_count;
+    cfstore_delta_test_format(&log, 0x1234);
+    cfstore_delta_test_kv(kv, 1, 0xa5);
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, cfstore_delta_append(&log, CFSTORE_DELTA_RECORD_PUT, kv, sizeof(kv), NULL, 0));
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, cfstore_delta_append(&log, CFSTORE_DELTA_RECORD_END, NULL, 0, NULL, 0));
+
+    cfstore_delta_test_mount(&log, 0x1234);
+    TEST_ASSERT_EQUAL(1, cfstore_delta_test_num_records_g);
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, cfstore_delta_append(&log, CFSTORE_DELTA_RECORD_DELETE, name, strlen(name), NULL, 0));
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, cfstore_delta_append(&log, CFSTORE_DELTA_RECORD_END, NULL, 0, NULL, 0));
+
+    cfstore_delta_test_mount(&log, 0x1234);
+    TEST_ASSERT_EQUAL(2, cfstore_delta_test_num_records_g);
+    TEST_ASSERT_EQUAL(CFSTORE_DELTA_RECORD_PUT, cfstore_delta_test_records_g[0].type);
+    TEST_ASSERT_EQUAL(CFSTORE_DELTA_RECORD_DELETE, cfstore_delta_test_records_g[1].type);
+    TEST_ASSERT_EQUAL(strlen(name), cfstore_delta_test_records_g[1].length);
+    TEST_ASSERT_EQUAL(0, memcmp(cfstore_delta_test_records_g[1].data, name, strlen(name)));
+
+    /* a log written on top of another snapshot is dropped */
+    cfstore_delta_test_mount(&log, 0x5678);
+    TEST_ASSERT_EQUAL(0, cfstore_delta_test_num_records_g);
+    cfstore_delta_test_mount(&log, 0x5678);
+    TEST_ASSERT_EQUAL(0, cfstore_delta_test_num_records_g);
+    TEST_ASSERT_TRUE(log.formatted);
+    return CaseNext;
+}
+
+
+/** @brief  The records of a flush interrupted before its END record are not
+ *          replayed, nor are records following a torn record.
+ */
+static control_t cfstore_delta_test_03(const size_t call_count)
+{
+    cfstore_delta_log_t log;
+    uint8_t kv[CFSTORE_DELTA_TEST_KV_SIZE];
+    uint32_t offset = 0;
+
+    (void) call_count;
+    cfstore_delta_test_format(&log, 0);
+    cfstore_delta_test_kv(kv, 1, 1);
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, cfstore_delta_append(&log, CFSTORE_DELTA_RECORD_PUT, kv, sizeof(kv), NULL, 0));
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, cfstore_delta_append(&log, CFSTORE_DELTA_RECORD_END, NULL, 0, NULL, 0));
+    cfstore_delta_test_kv(kv, 2, 2);
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, cfstore_delta_append(&log, CFSTORE_DELTA_RECORD_PUT, kv, sizeof(kv), NULL, 0));
+
+    /* power failure before END */
+    cfstore_delta_test_mount(&log, 0);
+    TEST_ASSERT_EQUAL(1, cfstore_delta_test_num_records_g);
+    TEST_ASSERT_EQUAL(1, cfstore_delta_test_records_g[0].data[0]);
+    TEST_ASSERT_TRUE(log.needs_compaction);
+    TEST_ASSERT_EQUAL(ARM_DRIVER_ERROR_PARAMETER, cfstore_delta_append(&log, CFSTORE_DELTA_RECORD_END, NULL, 0, NULL, 0));
+
+    /* power failure while programming the payload of the second flush */
+    cfstore_delta_test_format(&log, 0);
+    cfstore_delta_test_kv(kv, 1, 1);
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, cfstore_delta_append(&log, CFSTORE_DELTA_RECORD_PUT, kv, sizeof(kv), NULL, 0));
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, cfstore_delta_append(&log, CFSTORE_DELTA_RECORD_END, NULL, 0, NULL, 0));
+    offset = log.offset;
+    cfstore_delta_test_kv(kv, 2, 2);
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, cfstore_delta_append(&log, CFSTORE_DELTA_RECORD_PUT, kv, sizeof(kv), NULL, 0));
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, cfstore_delta_append(&log, CFSTORE_DELTA_RECORD_END, NULL, 0, NULL, 0));
+    memset(&cfstore_delta_test_storage_g[offset + sizeof(cfstore_delta_record_t) + 8], 0xff, 16);
+
+    cfstore_delta_test_mount(&log, 0);
+    TEST_ASSERT_EQUAL(1, cfstore_delta_test_num_records_g);
+    TEST_ASSERT_TRUE(log.needs_compaction);
+    return CaseNext;
+}
+
+
+/** @brief  A compaction which committed its snapshot but was interrupted
+ *          before resetting the log does not replay the log again, whereas
+ *          one which did not commit leaves the log in use.
+ */
+static control_t cfstore_delta_test_04(const size_t call_count)
+{
+    cfstore_delta_log_t log;
+    uint8_t kv[CFSTORE_DELTA_TEST_KV_SIZE];
+    uint32_t old_crc = 0x1111;
+    uint32_t new_crc = 0x2222;
+
+    (void) call_count;
+    cfstore_delta_test_format(&log, old_crc);
+    cfstore_delta_test_kv(kv, 1, 1);
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, cfstore_delta_append(&log, CFSTORE_DELTA_RECORD_PUT, kv, sizeof(kv), NULL, 0));
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, cfstore_delta_append(&log, CFSTORE_DELTA_RECORD_END, NULL, 0, NULL, 0));
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, cfstore_delta_compact_begin(&log, new_crc));
+    TEST_ASSERT_TRUE(log.needs_compaction);
+
+    /* the journal commit did not complete: the old snapshot is read */
+    cfstore_delta_test_mount(&log, old_crc);
+    TEST_ASSERT_EQUAL(1, cfstore_delta_test_num_records_g);
+    TEST_ASSERT_TRUE(log.needs_compaction);
+
+    /* the journal commit completed: the new snapshot holds the records */
+    cfstore_delta_test_mount(&log, new_crc);
+    TEST_ASSERT_EQUAL(0, cfstore_delta_test_num_records_g);
+    TEST_ASSERT_FALSE(log.needs_compaction);
+    TEST_ASSERT_EQUAL(new_crc, log.base_crc);
+
+    /* compactions which fail to commit use up the slots */
+    for (uint32_t i = 0; i < CFSTORE_DELTA_COMPACT_SLOTS; i++) {
+        TEST_ASSERT_EQUAL(ARM_DRIVER_OK, cfstore_delta_compact_begin(&log, new_crc + 1 + i));
+    }
+    TEST_ASSERT_EQUAL(ARM_DRIVER_ERROR, cfstore_delta_compact_begin(&log, new_crc + 10));
+    return CaseNext;
+}
+
+
+/** @brief  Appending fails when the log is full, which the caller takes as
+ *          the cue to compact.
+ */
+static control_t cfstore_delta_test_05(const size_t call_count)
+{
+    cfstore_delta_log_t log;
+    uint8_t kv[CFSTORE_DELTA_TEST_KV_SIZE];
+    uint32_t size = 0;
+    uint32_t count = 0;
+
+    (void) call_count;
+    cfstore_delta_test_format(&log, 0);
+    cfstore_delta_test_kv(kv, 1, 1);
+    size = cfstore_delta_record_size(&log, sizeof(kv));
+    while (cfstore_delta_space(&log) >= size) {
+        TEST_ASSERT_EQUAL(ARM_DRIVER_OK, cfstore_delta_append(&log, CFSTORE_DELTA_RECORD_PUT, kv, sizeof(kv), NULL, 0));
+        count++;
+    }
+    TEST_ASSERT(count > CFSTORE_DELTA_TEST_STORAGE_SIZE / size - 4);
+    TEST_ASSERT_EQUAL(ARM_DRIVER_ERROR_PARAMETER, cfstore_delta_append(&log, CFSTORE_DELTA_RECORD_PUT, kv, sizeof(kv), NULL, 0));
+    TEST_ASSERT_FALSE(log.needs_compaction);
+    return CaseNext;
+}
+
+
+/// @cond CFSTORE_DOXYGEN_DISABLE
+Case cases[] = {
+        Case("DELTA_LOG_test_01", cfstore_delta_test_01),
+        Case("DELTA_LOG_test_02", cfstore_delta_test_02),
+        Case("DELTA_LOG_test_03", cfstore_delta_test_03),
+        Case("DELTA_LOG_test_04", cfstore_delta_test_04),
+        Case("DELTA_LOG_test_05", cfstore_delta_test_05),
+};
+
+
+utest::v1::status_t greentea_setup(const size_t number_of_cases)
+{
+    GREENTEA_SETUP(100, "default_auto");
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+/* Declare your test specification with a custom setup handler */
+Specification specification(greentea_setup, cases);
+
+
+int main()
+{
+    return !Harness::run(specification);
+}
+/// @endcond
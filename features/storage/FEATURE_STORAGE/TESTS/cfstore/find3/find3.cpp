@@ -0,0 +1,293 @@
+/*
+ * mbed Microcontroller Library
+ * Copyright (c) 2006-2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/** @file find3.cpp Test cases for the key name index used by drv->Find() and drv->Open().
+ *
+ * Please consult the documentation under the test-case functions for
+ * a description of the individual test case.
+ */
+
+#include "mbed.h"
+#include "cfstore_config.h"
+#include "cfstore_test.h"
+#include "cfstore_debug.h"
+#include "Driver_Common.h"
+#include "configuration_store.h"
+#include "utest/utest.h"
+#include "unity/unity.h"
+#include "greentea-client/test_env.h"
+#include "cfstore_utest.h"
+#ifdef YOTTA_CFG_CFSTORE_UVISOR
+#include "uvisor-lib/uvisor-lib.h"
+#endif /* YOTTA_CFG_CFSTORE_UVISOR */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+using namespace utest::v1;
+
+static char cfstore_find3_utest_msg_g[CFSTORE_UTEST_MSG_BUF_SIZE];
+
+/* Configure secure box. */
+#ifdef YOTTA_CFG_CFSTORE_UVISOR
+UVISOR_BOX_NAMESPACE("com.arm.mbed.cfstore.test.find3.box1");
+UVISOR_BOX_CONFIG(cfstore_find3_box1, UVISOR_BOX_STACK_SIZE);
+#endif /* YOTTA_CFG_CFSTORE_UVISOR */
+
+/// @cond CFSTORE_DOXYGEN_DISABLE
+#ifdef CFSTORE_DEBUG
+#define CFSTORE_FIND3_GREENTEA_TIMEOUT_S     360
+#else
+#define CFSTORE_FIND3_GREENTEA_TIMEOUT_S     60
+#endif
+#define CFSTORE_FIND3_TEST_KEY_PREFIX        "com.arm.mbed.find3.key."
+#define CFSTORE_FIND3_TEST_02_KEY_COUNT_MAX  128
+
+static cfstore_kv_data_t cfstore_find3_test_01_data[] = {
+        { "com.arm.mbed.find3.a.1", "1"},
+        { "com.arm.mbed.find3.b.1", "22"},
+        { "com.arm.mbed.find3.a.2", "333"},
+        { "com.arm.mbed.find3.b.2", "4444"},
+        { "com.arm.mbed.find3.a.3", "55555"},
+        { "com.arm.mbed.find3.b.3", "666666"},
+        { "com.arm.mbed.find3.a.4", "7777777"},
+        { NULL, NULL},
+};
+
+static ARM_CFSTORE_KEYDESC cfstore_find3_kdesc_g;
+/// @endcond
+
+
+/* report whether built/configured for flash sync or async mode */
+static control_t cfstore_find3_test_00(const size_t call_count)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+
+    (void) call_count;
+    ret = cfstore_test_startup();
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_find3_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to perform test startup (ret=%d).\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_find3_utest_msg_g);
+    return CaseNext;
+}
+
+
+/* @brief   count the KVs found by query, checking they are returned in area order */
+static int32_t cfstore_find3_count(const char* key_name_query)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+    int32_t count = 0;
+    ARM_CFSTORE_DRIVER* drv = &cfstore_driver;
+    ARM_CFSTORE_HANDLE_INIT(next);
+    ARM_CFSTORE_HANDLE_INIT(prev);
+
+    while((ret = drv->Find(key_name_query, prev, next)) == ARM_DRIVER_OK)
+    {
+        count++;
+        CFSTORE_HANDLE_SWAP(prev, next);
+    }
+    if(ret != ARM_CFSTORE_DRIVER_ERROR_KEY_NOT_FOUND){
+        return ret;
+    }
+    return count;
+}
+
+
+/** @brief  test Find() and Open() return the expected KVs as the store is
+ *          modified by Create(), Delete() and resizing a KV, which move the
+ *          KVs within the area.
+ *
+ * @return on success returns CaseNext to continue to next test case, otherwise will assert on errors.
+ */
+control_t cfstore_find3_test_01_end(const size_t call_count)
+{
+    char value[CFSTORE_KEY_NAME_MAX_LENGTH+1];
+    int32_t ret = ARM_DRIVER_ERROR;
+    ARM_CFSTORE_SIZE len = 0;
+    ARM_CFSTORE_DRIVER* drv = &cfstore_driver;
+    ARM_CFSTORE_HANDLE_INIT(hkey);
+    cfstore_kv_data_t* node = NULL;
+    bool bfound = false;
+
+    (void) call_count;
+    ret = cfstore_test_create_table(cfstore_find3_test_01_data);
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_find3_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to create KVs (ret=%d).\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_find3_utest_msg_g);
+
+    /* exact, literal prefix and leading wildcard queries */
+    TEST_ASSERT_EQUAL(4, cfstore_find3_count("com.arm.mbed.find3.a.*"));
+    TEST_ASSERT_EQUAL(3, cfstore_find3_count("com.arm.mbed.find3.b*"));
+    TEST_ASSERT_EQUAL(7, cfstore_find3_count("com.arm.mbed.find3.*"));
+    TEST_ASSERT_EQUAL(4, cfstore_find3_count("*.a.*"));
+    TEST_ASSERT_EQUAL(1, cfstore_find3_count("com.arm.mbed.find3.b.2"));
+    TEST_ASSERT_EQUAL(0, cfstore_find3_count("com.arm.mbed.find3.b.20"));
+    TEST_ASSERT_EQUAL(0, cfstore_find3_count("com.arm.mbed.find3.c*"));
+
+    /* delete a KV from the middle of the area, moving the KVs following it */
+    ret = cfstore_test_delete("com.arm.mbed.find3.b.1");
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_find3_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to delete KV (ret=%d).\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_find3_utest_msg_g);
+    TEST_ASSERT_EQUAL(2, cfstore_find3_count("com.arm.mbed.find3.b*"));
+    TEST_ASSERT_EQUAL(0, cfstore_find3_count("com.arm.mbed.find3.b.1"));
+
+    /* grow a KV, moving the KVs following it */
+    ret = drv->Create("com.arm.mbed.find3.a.2", 64, NULL, hkey);
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_find3_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to grow KV (ret=%d).\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_find3_utest_msg_g);
+    drv->Close(hkey);
+
+    /* the values of all the remaining KVs are still found under their names */
+    node = cfstore_find3_test_01_data;
+    while(node->key_name != NULL)
+    {
+        ret = cfstore_test_kv_is_found(node->key_name, &bfound);
+        CFSTORE_TEST_UTEST_MESSAGE(cfstore_find3_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: unexpected Find() result for %s (ret=%d).\n", __func__, node->key_name, (int) ret);
+        TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK || ret == ARM_CFSTORE_DRIVER_ERROR_KEY_NOT_FOUND, cfstore_find3_utest_msg_g);
+        TEST_ASSERT_MESSAGE(bfound == (strcmp(node->key_name, "com.arm.mbed.find3.b.1") != 0), cfstore_find3_utest_msg_g);
+        if(bfound && strcmp(node->key_name, "com.arm.mbed.find3.a.2") != 0){
+            len = sizeof(value);
+            ret = cfstore_test_read(node->key_name, value, &len);
+            TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_find3_utest_msg_g);
+            TEST_ASSERT_MESSAGE(len == strlen(node->value) && strncmp(value, node->value, len) == 0, cfstore_find3_utest_msg_g);
+        }
+        node++;
+    }
+    TEST_ASSERT_EQUAL(4, cfstore_find3_count("com.arm.mbed.find3.a.*"));
+
+    /* a KV created after the deletes is found at the end of the area */
+    len = 1;
+    ret = cfstore_test_create("com.arm.mbed.find3.b.1", "x", &len, &cfstore_find3_kdesc_g);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_find3_utest_msg_g);
+    TEST_ASSERT_EQUAL(3, cfstore_find3_count("com.arm.mbed.find3.b*"));
+
+    ret = cfstore_test_delete_all();
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_find3_utest_msg_g);
+    TEST_ASSERT_EQUAL(0, cfstore_find3_count("com.arm.mbed.find3.*"));
+
+    ret = drv->Uninitialize();
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_find3_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: Uninitialize() call failed.\n", __func__);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_find3_utest_msg_g);
+    return CaseNext;
+}
+
+
+/** @brief  benchmark the time to find a KV by name as the number of KVs in
+ *          the store grows. Lookups by exact name use the index and should
+ *          take roughly constant time, while queries starting with a
+ *          wildcard walk the area and grow linearly.
+ *
+ * @return on success returns CaseNext to continue to next test case, otherwise will assert on errors.
+ */
+control_t cfstore_find3_test_02_end(const size_t call_count)
+{
+    char key_name[CFSTORE_KEY_NAME_MAX_LENGTH+1];
+    char query[CFSTORE_KEY_NAME_MAX_LENGTH+1];
+    int32_t ret = ARM_DRIVER_ERROR;
+    uint32_t i = 0;
+    uint32_t count = 0;
+    uint32_t created = 0;
+    uint32_t exact_us = 0;
+    uint32_t prefix_us = 0;
+    uint32_t walk_us = 0;
+    ARM_CFSTORE_SIZE len = 0;
+    ARM_CFSTORE_DRIVER* drv = &cfstore_driver;
+    ARM_CFSTORE_HANDLE_INIT(next);
+    Timer timer;
+
+    (void) call_count;
+    printf("%s: keys, exact find (us), prefix find (us), wildcard find (us)\n", __func__);
+    for(count = 16; count <= CFSTORE_FIND3_TEST_02_KEY_COUNT_MAX; count *= 2)
+    {
+        for( ; created < count; created++){
+            snprintf(key_name, sizeof(key_name), CFSTORE_FIND3_TEST_KEY_PREFIX "%03d", (int) created);
+            len = 1;
+            ret = cfstore_test_create(key_name, "v", &len, &cfstore_find3_kdesc_g);
+            CFSTORE_TEST_UTEST_MESSAGE(cfstore_find3_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to create KV %s (ret=%d).\n", __func__, key_name, (int) ret);
+            TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_find3_utest_msg_g);
+        }
+
+        timer.reset();
+        timer.start();
+        for(i = 0; i < count; i++){
+            snprintf(key_name, sizeof(key_name), CFSTORE_FIND3_TEST_KEY_PREFIX "%03d", (int) i);
+            ret = drv->Find(key_name, NULL, next);
+            TEST_ASSERT_EQUAL(ARM_DRIVER_OK, ret);
+            drv->Close(next);
+        }
+        timer.stop();
+        exact_us = timer.read_us() / count;
+
+        timer.reset();
+        timer.start();
+        for(i = 0; i < count; i++){
+            snprintf(query, sizeof(query), CFSTORE_FIND3_TEST_KEY_PREFIX "%02d*", (int) i / 10);
+            ret = drv->Find(query, NULL, next);
+            TEST_ASSERT_EQUAL(ARM_DRIVER_OK, ret);
+            drv->Close(next);
+        }
+        timer.stop();
+        prefix_us = timer.read_us() / count;
+
+        timer.reset();
+        timer.start();
+        for(i = 0; i < count; i++){
+            snprintf(query, sizeof(query), "*.key.%03d", (int) i);
+            ret = drv->Find(query, NULL, next);
+            TEST_ASSERT_EQUAL(ARM_DRIVER_OK, ret);
+            drv->Close(next);
+        }
+        timer.stop();
+        walk_us = timer.read_us() / count;
+        printf("%s: %d, %d, %d, %d\n", __func__, (int) count, (int) exact_us, (int) prefix_us, (int) walk_us);
+    }
+
+    ret = cfstore_test_delete_all();
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_find3_utest_msg_g);
+    ret = drv->Uninitialize();
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_find3_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: Uninitialize() call failed.\n", __func__);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_find3_utest_msg_g);
+    return CaseNext;
+}
+
+
+/// @cond CFSTORE_DOXYGEN_DISABLE
+Case cases[] = {
+        Case("FIND3_test_00", cfstore_find3_test_00),
+        Case("FIND3_test_01_start", cfstore_utest_default_start),
+        Case("FIND3_test_01_end", cfstore_find3_test_01_end),
+        Case("FIND3_test_02_start", cfstore_utest_default_start),
+        Case("FIND3_test_02_end", cfstore_find3_test_02_end),
+};
+
+
+utest::v1::status_t greentea_setup(const size_t number_of_cases)
+{
+    GREENTEA_SETUP(CFSTORE_FIND3_GREENTEA_TIMEOUT_S, "default_auto");
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+/* Declare your test specification with a custom setup handler */
+Specification specification(greentea_setup, cases);
+
+
+int main()
+{
+    return !Harness::run(specification);
+}
+/// @endcond
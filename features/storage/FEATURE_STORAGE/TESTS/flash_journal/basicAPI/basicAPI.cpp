@@ -29,7 +29,13 @@
 #include "flash-journal-strategy-sequential/flash_journal_strategy_sequential.h"
 #include "flash-journal-strategy-sequential/flash_journal_private.h"
 #include <string.h>
+#include <stdlib.h>
 #include <inttypes.h>
+#ifdef TARGET_LIKE_POSIX
+#include <time.h>
+#else
+#include "us_ticker_api.h"
+#endif
 
 using namespace utest::v1;
 
@@ -1051,6 +1057,108 @@ void test_crc32()
             flashJournalCrcReset(); TEST_ASSERT_EQUAL(flashJournalCrcCummulative(dummyMsg, msgLen), crc);
         }
     }
+
+    /* the stateless update is expected to match the cummulative CRC */
+    TEST_ASSERT_EQUAL(0xcbf43926, flashJournalCrcUpdate(0, (const unsigned char *)"123456789", 9));
+    for (unsigned msgLen = 1; msgLen <= strlen((const char *)dummyMsg); msgLen++) {
+        flashJournalCrcReset(); TEST_ASSERT_EQUAL(flashJournalCrcCummulative(dummyMsg, msgLen), flashJournalCrcUpdate(0, dummyMsg, msgLen));
+    }
+
+    /* check for composability of the stateless update over buffers long enough
+     * to be processed a word at a time, starting at every alignment */
+    static const size_t SIZEOF_LONG_MSG = 64;
+    for (size_t i = 0; i < SIZEOF_LONG_MSG + 8; i++) {
+        buffer[i] = (uint8_t)(i * 7 + 3);
+    }
+    for (unsigned offset = 0; offset < 8; offset++) {
+        flashJournalCrcReset();
+        uint32_t expected = flashJournalCrcCummulative(buffer + offset, SIZEOF_LONG_MSG);
+        for (unsigned partitionIndex = 0; partitionIndex <= SIZEOF_LONG_MSG; partitionIndex += 3) {
+            crc = flashJournalCrcUpdate(0, buffer + offset, partitionIndex);
+            crc = flashJournalCrcUpdate(crc, buffer + offset + partitionIndex, SIZEOF_LONG_MSG - partitionIndex);
+            TEST_ASSERT_EQUAL(expected, crc);
+        }
+    }
+}
+
+static uint32_t benchmarkTimestampInMicroseconds(void)
+{
+#ifdef TARGET_LIKE_POSIX
+    return (uint32_t)(((uint64_t)clock() * 1000000) / CLOCKS_PER_SEC);
+#else
+    return us_ticker_read();
+#endif
+}
+
+/* Log and commit a blob of SIZEOF_BENCHMARK_BLOB, then report the time taken
+ * by initialize(), which verifies the CRC of every slot, and by a read() of the
+ * whole blob, which verifies the blob as it is read. Only synchronous storage
+ * is timed. */
+void test_benchmarkInitializeAndReadLargeBlob()
+{
+    static const size_t SIZEOF_BENCHMARK_BLOB = 64 * 1024;
+
+    int32_t rc;
+    FlashJournal_Info_t info;
+
+    if (drv->GetCapabilities().asynchronous_ops) {
+        printf("test_benchmarkInitializeAndReadLargeBlob: skipped for asynchronous storage\n");
+        return;
+    }
+
+    rc = FlashJournal_getInfo(&journal, &info);
+    TEST_ASSERT_EQUAL(JOURNAL_STATUS_OK, rc);
+    if (info.capacity < SIZEOF_BENCHMARK_BLOB) {
+        printf("test_benchmarkInitializeAndReadLargeBlob: skipped for capacity %" PRIu32 "\n", (uint32_t)info.capacity);
+        return;
+    }
+
+    uint8_t *blob = (uint8_t *)malloc(SIZEOF_BENCHMARK_BLOB);
+    if (blob == NULL) {
+        printf("test_benchmarkInitializeAndReadLargeBlob: skipped; unable to allocate %" PRIu32 " bytes\n", (uint32_t)SIZEOF_BENCHMARK_BLOB);
+        return;
+    }
+
+    rc = FlashJournal_reset(&journal);
+    TEST_ASSERT_EQUAL(1, rc);
+
+    size_t sizeofLoggedData = 0;
+    while (sizeofLoggedData < SIZEOF_BENCHMARK_BLOB) {
+        size_t sizeofChunk = SIZEOF_BENCHMARK_BLOB - sizeofLoggedData;
+        if (sizeofChunk > BUFFER_SIZE) {
+            sizeofChunk = BUFFER_SIZE;
+        }
+        for (size_t i = 0; i < sizeofChunk; i++) {
+            buffer[i] = (uint8_t)((sizeofLoggedData + i) * 13);
+        }
+
+        rc = FlashJournal_log(&journal, buffer, sizeofChunk);
+        TEST_ASSERT(rc > JOURNAL_STATUS_OK);
+        sizeofLoggedData += rc;
+    }
+    rc = FlashJournal_commit(&journal);
+    TEST_ASSERT_EQUAL(1, rc);
+
+    uint32_t start = benchmarkTimestampInMicroseconds();
+    rc = FlashJournal_initialize(&journal, drv, &FLASH_JOURNAL_STRATEGY_SEQUENTIAL, callbackHandler);
+    uint32_t initializeTime = benchmarkTimestampInMicroseconds() - start;
+    TEST_ASSERT_EQUAL(1, rc);
+
+    rc = FlashJournal_getInfo(&journal, &info);
+    TEST_ASSERT_EQUAL(JOURNAL_STATUS_OK, rc);
+    TEST_ASSERT_EQUAL(SIZEOF_BENCHMARK_BLOB, info.sizeofJournaledBlob);
+
+    start = benchmarkTimestampInMicroseconds();
+    rc = FlashJournal_read(&journal, blob, SIZEOF_BENCHMARK_BLOB);
+    uint32_t readTime = benchmarkTimestampInMicroseconds() - start;
+    TEST_ASSERT_EQUAL(SIZEOF_BENCHMARK_BLOB, rc);
+    for (size_t i = 0; i < SIZEOF_BENCHMARK_BLOB; i++) {
+        TEST_ASSERT_EQUAL((uint8_t)(i * 13), blob[i]);
+    }
+
+    printf("test_benchmarkInitializeAndReadLargeBlob: %" PRIu32 " byte blob: initialize %" PRIu32 " us, read %" PRIu32 " us\n",
+           (uint32_t)SIZEOF_BENCHMARK_BLOB, initializeTime, readTime);
+    free(blob);
 }
 
 #ifndef AVOID_GREENTEA
@@ -1145,6 +1253,7 @@ Case cases[] = {
 
     Case("reset and initialize6",                       test_resetAndInitialize),
     Case("crc32",                                       test_crc32),
+    Case("benchmark initialize and read of large blob", test_benchmarkInitializeAndReadLargeBlob),
     // Case("uninitialize", test_uninitialize),
 };
 
@@ -0,0 +1,672 @@
+/*
+ * Copyright (c) 2006-2016, ARM Limited, All Rights Reserved
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Test cases for the log-structured flash-journal strategy.
+ *
+ * The journal is exercised on a RAM backed storage driver which behaves like
+ * NOR flash (program only clears bits, erase sets whole erase units) with small
+ * erase units, so that the log wraps around the ring many times. The driver
+ * counts the erases of every erase unit, and can be switched to complete
+ * program and erase operations asynchronously; these are then completed by
+ * pumpPendingOperations().
+ */
+
+#ifdef TARGET_LIKE_POSIX
+#define AVOID_GREENTEA
+#endif
+
+#ifndef AVOID_GREENTEA
+#include "greentea-client/test_env.h"
+#endif
+#include "utest/utest.h"
+#include "unity/unity.h"
+
+#include "flash-journal-strategy-log/flash_journal_strategy_log.h"
+#include "flash-journal-strategy-log/flash_journal_log_private.h"
+#include <string.h>
+#include <inttypes.h>
+
+using namespace utest::v1;
+
+static const uint32_t SIM_ERASE_UNIT   = 512;
+static const uint32_t SIM_NUM_UNITS    = 18;    /* one for the journal header, the rest for the ring */
+static const uint32_t SIM_STORAGE_SIZE = SIM_ERASE_UNIT * SIM_NUM_UNITS;
+static const uint32_t SIM_PROGRAM_UNIT = 8;
+static const uint32_t NUM_SECTORS      = SIM_NUM_UNITS - 1;
+
+/*
+ * RAM backed storage driver
+ */
+static uint8_t                simStorage[SIM_STORAGE_SIZE];
+static uint32_t               simEraseCounts[SIM_NUM_UNITS];
+static bool                   simAsynchronous;
+static ARM_Storage_Callback_t simCallback;
+
+static struct {
+    ARM_STORAGE_OPERATION  operation;
+    uint64_t               addr;
+    const void            *data;
+    uint32_t               size;
+    bool                   pending;
+} simPendingOp;
+
+static ARM_DRIVER_VERSION simGetVersion(void)
+{
+    ARM_DRIVER_VERSION version = { ARM_STORAGE_API_VERSION, ARM_DRIVER_VERSION_MAJOR_MINOR(1, 0) };
+    return version;
+}
+
+static ARM_STORAGE_CAPABILITIES simGetCapabilities(void)
+{
+    ARM_STORAGE_CAPABILITIES caps;
+
+    memset(&caps, 0, sizeof(caps));
+    caps.asynchronous_ops = simAsynchronous ? 1 : 0;
+    return caps;
+}
+
+static int32_t simInitialize(ARM_Storage_Callback_t callback)
+{
+    simCallback = callback;
+    return 1;
+}
+
+static int32_t simUninitialize(void) { return 1; }
+static int32_t simPowerControl(ARM_POWER_STATE state) { (void) state; return 1; }
+
+static int32_t simReadData(uint64_t addr, void *data, uint32_t size)
+{
+    if (addr + size > SIM_STORAGE_SIZE) {
+        return ARM_DRIVER_ERROR_PARAMETER;
+    }
+    memcpy(data, &simStorage[addr], size);
+    return size;
+}
+
+static int32_t simDoProgramData(uint64_t addr, const void *data, uint32_t size)
+{
+    const uint8_t *ptr = (const uint8_t *) data;
+    for (uint32_t i = 0; i < size; i++) {
+        simStorage[addr + i] &= ptr[i];
+    }
+    return size;
+}
+
+static int32_t simDoErase(uint64_t addr, uint32_t size)
+{
+    memset(&simStorage[addr], 0xFF, size);
+    for (uint32_t unit = addr / SIM_ERASE_UNIT; unit < (addr + size) / SIM_ERASE_UNIT; unit++) {
+        simEraseCounts[unit]++;
+    }
+    return size;
+}
+
+static int32_t simDefer(ARM_STORAGE_OPERATION operation, uint64_t addr, const void *data, uint32_t size)
+{
+    TEST_ASSERT_FALSE(simPendingOp.pending); /* the journal is expected to issue one operation at a time */
+    simPendingOp.operation = operation;
+    simPendingOp.addr      = addr;
+    simPendingOp.data      = data;
+    simPendingOp.size      = size;
+    simPendingOp.pending   = true;
+    return ARM_DRIVER_OK;
+}
+
+static int32_t simProgramData(uint64_t addr, const void *data, uint32_t size)
+{
+    if ((addr + size > SIM_STORAGE_SIZE) || (addr % SIM_PROGRAM_UNIT) || (size % SIM_PROGRAM_UNIT) || (size == 0)) {
+        return ARM_DRIVER_ERROR_PARAMETER;
+    }
+    if (simAsynchronous) {
+        return simDefer(ARM_STORAGE_OPERATION_PROGRAM_DATA, addr, data, size);
+    }
+    return simDoProgramData(addr, data, size);
+}
+
+static int32_t simErase(uint64_t addr, uint32_t size)
+{
+    if ((addr + size > SIM_STORAGE_SIZE) || (addr % SIM_ERASE_UNIT) || (size % SIM_ERASE_UNIT) || (size == 0)) {
+        return ARM_DRIVER_ERROR_PARAMETER;
+    }
+    if (simAsynchronous) {
+        return simDefer(ARM_STORAGE_OPERATION_ERASE, addr, NULL, size);
+    }
+    return simDoErase(addr, size);
+}
+
+static int32_t simEraseAll(void)
+{
+    return simErase(0, SIM_STORAGE_SIZE);
+}
+
+static ARM_STORAGE_STATUS simGetStatus(void)
+{
+    ARM_STORAGE_STATUS status;
+
+    memset(&status, 0, sizeof(status));
+    status.busy = simPendingOp.pending ? 1 : 0;
+    return status;
+}
+
+static int32_t simGetInfo(ARM_STORAGE_INFO *info)
+{
+    memset(info, 0, sizeof(*info));
+    info->total_storage        = SIM_STORAGE_SIZE;
+    info->program_unit         = SIM_PROGRAM_UNIT;
+    info->optimal_program_unit = SIM_PROGRAM_UNIT;
+    info->program_cycles       = ARM_STORAGE_PROGRAM_CYCLES_INFINITE;
+    info->erased_value         = 1;
+    return ARM_DRIVER_OK;
+}
+
+static uint32_t simResolveAddress(uint64_t addr)
+{
+    return (uint32_t) addr;
+}
+
+static int32_t simGetNextBlock(const ARM_STORAGE_BLOCK* prev_block, ARM_STORAGE_BLOCK *next_block)
+{
+    if (prev_block != NULL) {
+        next_block->addr = ARM_STORAGE_INVALID_OFFSET;
+        next_block->size = 0;
+        return ARM_DRIVER_ERROR;
+    }
+    memset(next_block, 0, sizeof(*next_block));
+    next_block->addr                       = 0;
+    next_block->size                       = SIM_STORAGE_SIZE;
+    next_block->attributes.erasable        = 1;
+    next_block->attributes.programmable    = 1;
+    next_block->attributes.erase_unit      = SIM_ERASE_UNIT;
+    next_block->attributes.protection_unit = SIM_ERASE_UNIT;
+    return ARM_DRIVER_OK;
+}
+
+static int32_t simGetBlock(uint64_t addr, ARM_STORAGE_BLOCK *block)
+{
+    if (addr >= SIM_STORAGE_SIZE) {
+        return ARM_DRIVER_ERROR;
+    }
+    return simGetNextBlock(NULL, block);
+}
+
+static ARM_DRIVER_STORAGE simDriver = {
+    simGetVersion,
+    simGetCapabilities,
+    simInitialize,
+    simUninitialize,
+    simPowerControl,
+    simReadData,
+    simProgramData,
+    simErase,
+    simEraseAll,
+    simGetStatus,
+    simGetInfo,
+    simResolveAddress,
+    simGetNextBlock,
+    simGetBlock
+};
+
+/**
+ * Complete the pending asynchronous operation, and invoke the callback.
+ */
+static void completePendingOperation(void)
+{
+    TEST_ASSERT_TRUE(simPendingOp.pending);
+    simPendingOp.pending = false;
+
+    int32_t status;
+    if (simPendingOp.operation == ARM_STORAGE_OPERATION_ERASE) {
+        status = simDoErase(simPendingOp.addr, simPendingOp.size);
+    } else {
+        status = simDoProgramData(simPendingOp.addr, simPendingOp.data, simPendingOp.size);
+    }
+    simCallback(status, simPendingOp.operation);
+}
+
+/**
+ * Complete the pending asynchronous operations, including the ones issued from
+ * the completion callbacks.
+ * @return the number of operations completed.
+ */
+static uint32_t pumpPendingOperations(void)
+{
+    uint32_t count = 0;
+    while (simPendingOp.pending) {
+        completePendingOperation();
+        count++;
+    }
+
+    return count;
+}
+
+static uint32_t simTotalErases(void)
+{
+    uint32_t total = 0;
+    for (uint32_t unit = 0; unit < SIM_NUM_UNITS; unit++) {
+        total += simEraseCounts[unit];
+    }
+    return total;
+}
+
+
+FlashJournal_t journal;
+
+static const size_t BUFFER_SIZE = 4096;
+static uint8_t      buffer[BUFFER_SIZE];
+static uint8_t      readBuffer[BUFFER_SIZE];
+
+static int32_t callbackStatus;
+static int32_t callbackCount;
+static FlashJournal_OpCode_t callbackOpCode;
+
+void callbackHandler(int32_t status, FlashJournal_OpCode_t cmd_code)
+{
+    callbackStatus = status;
+    callbackOpCode = cmd_code;
+    callbackCount++;
+}
+
+/**
+ * Wait for an operation to complete; the return value from an API is passed
+ * through unless it signals pending asynchronous activity, in which case the
+ * status passed to the callback is returned.
+ */
+static int32_t waitForCompletion(int32_t rc, FlashJournal_OpCode_t cmd_code)
+{
+    if (rc != JOURNAL_STATUS_OK) {
+        return rc;
+    }
+
+    TEST_ASSERT_TRUE(simAsynchronous);
+    callbackCount = 0;
+    pumpPendingOperations();
+    TEST_ASSERT_EQUAL(1, callbackCount);
+    TEST_ASSERT_EQUAL(cmd_code, callbackOpCode);
+    return callbackStatus;
+}
+
+static void fillPattern(uint8_t *data, size_t size, uint32_t seed)
+{
+    for (size_t i = 0; i < size; i++) {
+        data[i] = (uint8_t)((i * 7) + (seed * 13) + 1);
+    }
+}
+
+static void logAndCommit(const void *data, size_t size)
+{
+    if (size > 0) {
+        TEST_ASSERT_EQUAL((int32_t)size, waitForCompletion(FlashJournal_log(&journal, data, size), FLASH_JOURNAL_OPCODE_LOG_BLOB));
+    }
+    TEST_ASSERT_EQUAL(1, waitForCompletion(FlashJournal_commit(&journal), FLASH_JOURNAL_OPCODE_COMMIT));
+}
+
+static void verifyBlob(const uint8_t *expected, size_t size)
+{
+    FlashJournal_Info_t info;
+    TEST_ASSERT_EQUAL(JOURNAL_STATUS_OK, FlashJournal_getInfo(&journal, &info));
+    TEST_ASSERT_EQUAL(size, info.sizeofJournaledBlob);
+
+    memset(readBuffer, 0, size);
+    TEST_ASSERT_EQUAL((int32_t)size, waitForCompletion(FlashJournal_read(&journal, readBuffer, BUFFER_SIZE), FLASH_JOURNAL_OPCODE_READ_BLOB));
+    TEST_ASSERT_EQUAL(0, memcmp(expected, readBuffer, size));
+}
+
+void test_format()
+{
+    memset(simStorage, 0x5A, sizeof(simStorage)); /* start from garbage */
+    memset(simEraseCounts, 0, sizeof(simEraseCounts));
+    simAsynchronous = false;
+
+    TEST_ASSERT_EQUAL(JOURNAL_STATUS_NOT_FORMATTED, FlashJournal_initialize(&journal, &simDriver, &FLASH_JOURNAL_STRATEGY_LOG, callbackHandler));
+    TEST_ASSERT_EQUAL(1, flashJournalStrategyLog_format(&simDriver, callbackHandler));
+
+    /* format erases the header and every sector of the ring once */
+    for (uint32_t unit = 0; unit < SIM_NUM_UNITS; unit++) {
+        TEST_ASSERT_EQUAL(1, simEraseCounts[unit]);
+    }
+}
+
+void test_initialize()
+{
+    TEST_ASSERT_EQUAL(1, FlashJournal_initialize(&journal, &simDriver, &FLASH_JOURNAL_STRATEGY_LOG, callbackHandler));
+
+    FlashJournal_Info_t info;
+    TEST_ASSERT_EQUAL(JOURNAL_STATUS_OK, FlashJournal_getInfo(&journal, &info));
+    TEST_ASSERT_EQUAL(SIM_PROGRAM_UNIT, info.program_unit);
+    TEST_ASSERT_EQUAL(((NUM_SECTORS - 1) / 2) * (SIM_ERASE_UNIT - 32) - 16, info.capacity);
+}
+
+void test_readEmpty()
+{
+    TEST_ASSERT_EQUAL(JOURNAL_STATUS_EMPTY, FlashJournal_read(&journal, readBuffer, BUFFER_SIZE));
+}
+
+/* Frequent small updates are appended to the ring; sectors only get erased as the log wraps around. */
+void test_frequentSmallCommits()
+{
+    const uint32_t NUM_COMMITS   = 200;
+    const size_t   SIZEOF_UPDATE = 40;
+    uint32_t       erasesBefore  = simTotalErases();
+
+    for (uint32_t i = 0; i < NUM_COMMITS; i++) {
+        fillPattern(buffer, SIZEOF_UPDATE, i);
+        logAndCommit(buffer, SIZEOF_UPDATE);
+        verifyBlob(buffer, SIZEOF_UPDATE);
+    }
+
+    /* Every update takes up 64 bytes of a sector with 480 bytes of data. The
+     * log has wrapped around the ring, but only one erase is needed for every
+     * 7 updates. */
+    uint32_t erases = simTotalErases() - erasesBefore;
+    TEST_ASSERT(erases > 0);
+    TEST_ASSERT((erases * 7) <= NUM_COMMITS);
+}
+
+void test_initializeFindsLatestBlob()
+{
+    TEST_ASSERT_EQUAL(1, FlashJournal_initialize(&journal, &simDriver, &FLASH_JOURNAL_STRATEGY_LOG, callbackHandler));
+
+    fillPattern(buffer, 40, 199);
+    verifyBlob(buffer, 40);
+
+    /* the log continues from where it left off */
+    fillPattern(buffer, 24, 1000);
+    logAndCommit(buffer, 24);
+    TEST_ASSERT_EQUAL(1, FlashJournal_initialize(&journal, &simDriver, &FLASH_JOURNAL_STRATEGY_LOG, callbackHandler));
+    verifyBlob(buffer, 24);
+}
+
+void test_emptyCommit()
+{
+    logAndCommit(NULL, 0);
+
+    FlashJournal_Info_t info;
+    TEST_ASSERT_EQUAL(JOURNAL_STATUS_OK, FlashJournal_getInfo(&journal, &info));
+    TEST_ASSERT_EQUAL(0, info.sizeofJournaledBlob);
+    TEST_ASSERT_EQUAL(JOURNAL_STATUS_EMPTY, FlashJournal_read(&journal, readBuffer, BUFFER_SIZE));
+
+    TEST_ASSERT_EQUAL(1, FlashJournal_initialize(&journal, &simDriver, &FLASH_JOURNAL_STRATEGY_LOG, callbackHandler));
+    TEST_ASSERT_EQUAL(JOURNAL_STATUS_EMPTY, FlashJournal_read(&journal, readBuffer, BUFFER_SIZE));
+}
+
+/* A blob as large as the capacity spans several sectors; log it in odd-sized chunks and read it back piecemeal. */
+void test_largeBlobSpanningSectors()
+{
+    FlashJournal_Info_t info;
+    TEST_ASSERT_EQUAL(JOURNAL_STATUS_OK, FlashJournal_getInfo(&journal, &info));
+    size_t capacity = (size_t)info.capacity;
+    TEST_ASSERT(capacity <= BUFFER_SIZE);
+
+    for (unsigned iteration = 0; iteration < 3; iteration++) {
+        fillPattern(buffer, capacity, 77 + iteration);
+
+        /* log() takes up whole program units; the remainder is passed in again with the next chunk */
+        size_t logged = 0;
+        while ((capacity - logged) >= SIM_PROGRAM_UNIT) {
+            size_t chunk = ((capacity - logged) < 1001) ? (capacity - logged) : 1001;
+            int32_t rc = waitForCompletion(FlashJournal_log(&journal, buffer + logged, chunk), FLASH_JOURNAL_OPCODE_LOG_BLOB);
+            TEST_ASSERT(rc > 0);
+            TEST_ASSERT_EQUAL(chunk - (chunk % SIM_PROGRAM_UNIT), (size_t)rc);
+            logged += rc;
+        }
+        TEST_ASSERT_EQUAL(capacity - (capacity % SIM_PROGRAM_UNIT), logged);
+        TEST_ASSERT_EQUAL(JOURNAL_STATUS_BOUNDED_CAPACITY, FlashJournal_log(&journal, buffer, capacity));
+        TEST_ASSERT_EQUAL(1, waitForCompletion(FlashJournal_commit(&journal), FLASH_JOURNAL_OPCODE_COMMIT));
+
+        /* sequential reads in chunks which don't line up with sectors */
+        size_t amountRead = 0;
+        memset(readBuffer, 0, logged);
+        while (amountRead < logged) {
+            int32_t rc = waitForCompletion(FlashJournal_read(&journal, readBuffer + amountRead, 333), FLASH_JOURNAL_OPCODE_READ_BLOB);
+            TEST_ASSERT(rc > 0);
+            amountRead += rc;
+        }
+        TEST_ASSERT_EQUAL(logged, amountRead);
+        TEST_ASSERT_EQUAL(0, memcmp(buffer, readBuffer, logged));
+        TEST_ASSERT_EQUAL(JOURNAL_STATUS_EMPTY, FlashJournal_read(&journal, readBuffer, 333));
+        verifyBlob(buffer, logged);
+
+        /* random access */
+        for (size_t offset = 0; offset < logged; offset += 479) {
+            uint8_t scratch[100];
+            size_t expected = ((logged - offset) < sizeof(scratch)) ? (logged - offset) : sizeof(scratch);
+            TEST_ASSERT_EQUAL((int32_t)expected, waitForCompletion(FlashJournal_readFrom(&journal, offset, scratch, sizeof(scratch)), FLASH_JOURNAL_OPCODE_READ_BLOB));
+            TEST_ASSERT_EQUAL(0, memcmp(buffer + offset, scratch, expected));
+        }
+
+        TEST_ASSERT_EQUAL(1, FlashJournal_initialize(&journal, &simDriver, &FLASH_JOURNAL_STRATEGY_LOG, callbackHandler));
+        verifyBlob(buffer, logged);
+    }
+}
+
+/* A blob which hasn't been committed is not visible, neither before nor after initialize(). */
+void test_uncommittedBlobIsDiscarded()
+{
+    fillPattern(buffer, 96, 5);
+    logAndCommit(buffer, 96);
+
+    uint8_t uncommitted[600];
+    fillPattern(uncommitted, sizeof(uncommitted), 6);
+    TEST_ASSERT_EQUAL((int32_t)sizeof(uncommitted), waitForCompletion(FlashJournal_log(&journal, uncommitted, sizeof(uncommitted)), FLASH_JOURNAL_OPCODE_LOG_BLOB));
+    TEST_ASSERT_EQUAL(JOURNAL_STATUS_ERROR, FlashJournal_read(&journal, readBuffer, BUFFER_SIZE)); /* logging is in progress */
+
+    /* power failure */
+    TEST_ASSERT_EQUAL(1, FlashJournal_initialize(&journal, &simDriver, &FLASH_JOURNAL_STRATEGY_LOG, callbackHandler));
+    verifyBlob(buffer, 96);
+
+    /* the log carries on past the partially logged blob */
+    for (uint32_t i = 0; i < 3; i++) {
+        fillPattern(buffer, 200, 7 + i);
+        logAndCommit(buffer, 200);
+        TEST_ASSERT_EQUAL(1, FlashJournal_initialize(&journal, &simDriver, &FLASH_JOURNAL_STRATEGY_LOG, callbackHandler));
+        verifyBlob(buffer, 200);
+    }
+}
+
+/* A corrupted blob is skipped in favour of the one committed before it. */
+void test_corruptedBlobFallsBack()
+{
+    uint8_t previous[64];
+    fillPattern(previous, sizeof(previous), 11);
+    logAndCommit(previous, sizeof(previous));
+
+    fillPattern(buffer, 64, 12);
+    logAndCommit(buffer, 64);
+
+    /* clear a bit in the payload of the latest blob */
+    LogFlashJournal_t *logJournal = (LogFlashJournal_t *)&journal;
+    uint64_t addr = logPhysicalAddress(logJournal, logAdvance(logJournal, logJournal->currentBlobOffset, LOG_FLASH_JOURNAL_SIZEOF_METADATA));
+    simStorage[addr] ^= 0x01;
+    TEST_ASSERT_EQUAL(JOURNAL_STATUS_STORAGE_IO_ERROR, FlashJournal_read(&journal, readBuffer, BUFFER_SIZE));
+
+    TEST_ASSERT_EQUAL(1, FlashJournal_initialize(&journal, &simDriver, &FLASH_JOURNAL_STRATEGY_LOG, callbackHandler));
+    verifyBlob(previous, sizeof(previous));
+
+    fillPattern(buffer, 64, 13);
+    logAndCommit(buffer, 64);
+    TEST_ASSERT_EQUAL(1, FlashJournal_initialize(&journal, &simDriver, &FLASH_JOURNAL_STRATEGY_LOG, callbackHandler));
+    verifyBlob(buffer, 64);
+}
+
+/* Erase counts are kept for every sector, and sectors wear evenly. */
+void test_eraseCounts()
+{
+    uint32_t eraseCounts[NUM_SECTORS + 1];
+    TEST_ASSERT_EQUAL((int32_t)NUM_SECTORS, flashJournalStrategyLog_getEraseCounts(&journal, eraseCounts, NUM_SECTORS + 1));
+
+    uint32_t minCount = UINT32_MAX;
+    uint32_t maxCount = 0;
+    for (uint32_t sector = 0; sector < NUM_SECTORS; sector++) {
+        /* the count in the sector head doesn't include the erase done by format */
+        TEST_ASSERT_EQUAL(simEraseCounts[sector + 1] - 1, eraseCounts[sector]);
+        minCount = (eraseCounts[sector] < minCount) ? eraseCounts[sector] : minCount;
+        maxCount = (eraseCounts[sector] > maxCount) ? eraseCounts[sector] : maxCount;
+    }
+    TEST_ASSERT(maxCount > 0);
+    TEST_ASSERT((maxCount - minCount) <= 1);
+
+    /* the journal header is never erased again */
+    TEST_ASSERT_EQUAL(1, simEraseCounts[0]);
+}
+
+void test_reset()
+{
+    fillPattern(buffer, 296, 21);
+    logAndCommit(buffer, 296);
+
+    TEST_ASSERT_EQUAL(1, waitForCompletion(FlashJournal_reset(&journal), FLASH_JOURNAL_OPCODE_RESET));
+    TEST_ASSERT_EQUAL(JOURNAL_STATUS_EMPTY, FlashJournal_read(&journal, readBuffer, BUFFER_SIZE));
+    TEST_ASSERT_EQUAL(1, FlashJournal_initialize(&journal, &simDriver, &FLASH_JOURNAL_STRATEGY_LOG, callbackHandler));
+    TEST_ASSERT_EQUAL(JOURNAL_STATUS_EMPTY, FlashJournal_read(&journal, readBuffer, BUFFER_SIZE));
+
+    /* a reset of a reset journal erases nothing */
+    uint32_t erasesBefore = simTotalErases();
+    TEST_ASSERT_EQUAL(1, waitForCompletion(FlashJournal_reset(&journal), FLASH_JOURNAL_OPCODE_RESET));
+    TEST_ASSERT_EQUAL(erasesBefore, simTotalErases());
+
+    fillPattern(buffer, 296, 22);
+    logAndCommit(buffer, 296);
+    TEST_ASSERT_EQUAL(1, FlashJournal_initialize(&journal, &simDriver, &FLASH_JOURNAL_STRATEGY_LOG, callbackHandler));
+    verifyBlob(buffer, 296);
+}
+
+void test_asynchronousFormat()
+{
+    simAsynchronous = true;
+    memset(simEraseCounts, 0, sizeof(simEraseCounts));
+
+    TEST_ASSERT_EQUAL(JOURNAL_STATUS_OK, flashJournalStrategyLog_format(&simDriver, callbackHandler));
+    TEST_ASSERT_EQUAL(1, waitForCompletion(JOURNAL_STATUS_OK, FLASH_JOURNAL_OPCODE_FORMAT));
+    TEST_ASSERT_EQUAL(1, FlashJournal_initialize(&journal, &simDriver, &FLASH_JOURNAL_STRATEGY_LOG, callbackHandler));
+    TEST_ASSERT_EQUAL(JOURNAL_STATUS_EMPTY, FlashJournal_read(&journal, readBuffer, BUFFER_SIZE));
+}
+
+/* With an asynchronous MTD, the sector ahead of the log is erased in the background following a commit. */
+void test_asynchronousBackgroundErase()
+{
+    LogFlashJournal_t *logJournal = (LogFlashJournal_t *)&journal;
+    uint32_t backgroundErases = 0;
+
+    for (uint32_t i = 0; i < 60; i++) {
+        fillPattern(buffer, 200, 30 + i);
+
+        int32_t rc = FlashJournal_log(&journal, buffer, 200);
+        TEST_ASSERT_EQUAL(JOURNAL_STATUS_OK, rc);
+        TEST_ASSERT_EQUAL(200, waitForCompletion(rc, FLASH_JOURNAL_OPCODE_LOG_BLOB));
+
+        rc = FlashJournal_commit(&journal);
+        TEST_ASSERT_EQUAL(JOURNAL_STATUS_OK, rc);
+
+        /* complete the program of the blob head, leaving a background erase pending */
+        callbackCount = 0;
+        while (simPendingOp.pending && (callbackCount == 0)) {
+            completePendingOperation();
+        }
+        TEST_ASSERT_EQUAL(1, callbackCount);
+        TEST_ASSERT_EQUAL(1, callbackStatus);
+
+        if (logJournal->backgroundErase) {
+            backgroundErases++;
+            TEST_ASSERT_TRUE(simPendingOp.pending);
+            TEST_ASSERT_EQUAL(JOURNAL_STATUS_BUSY, flashJournalStrategyLog_getEraseCounts(&journal, NULL, 0));
+
+            /* a read requested during the background erase is carried out once the erase finishes */
+            rc = FlashJournal_read(&journal, readBuffer, BUFFER_SIZE);
+            TEST_ASSERT_EQUAL(JOURNAL_STATUS_OK, rc);
+            TEST_ASSERT_EQUAL(200, waitForCompletion(rc, FLASH_JOURNAL_OPCODE_READ_BLOB));
+            TEST_ASSERT_EQUAL(0, memcmp(buffer, readBuffer, 200));
+            TEST_ASSERT_FALSE(logJournal->backgroundErase);
+            TEST_ASSERT(logJournal->numErasedSectors >= 1);
+        } else {
+            verifyBlob(buffer, 200);
+        }
+    }
+    TEST_ASSERT(backgroundErases > 0);
+
+    /* the log never had to stop for an erase, yet every sector has been reused */
+    TEST_ASSERT_EQUAL(1, FlashJournal_initialize(&journal, &simDriver, &FLASH_JOURNAL_STRATEGY_LOG, callbackHandler));
+    verifyBlob(buffer, 200);
+    uint32_t eraseCounts[NUM_SECTORS];
+    TEST_ASSERT_EQUAL((int32_t)NUM_SECTORS, flashJournalStrategyLog_getEraseCounts(&journal, eraseCounts, NUM_SECTORS));
+    for (uint32_t sector = 0; sector < NUM_SECTORS; sector++) {
+        TEST_ASSERT(eraseCounts[sector] >= 1);
+    }
+}
+
+void test_asynchronousResetAndLargeBlob()
+{
+    TEST_ASSERT_EQUAL(1, waitForCompletion(FlashJournal_reset(&journal), FLASH_JOURNAL_OPCODE_RESET));
+
+    FlashJournal_Info_t info;
+    TEST_ASSERT_EQUAL(JOURNAL_STATUS_OK, FlashJournal_getInfo(&journal, &info));
+    size_t size = (size_t)info.capacity - (info.capacity % SIM_PROGRAM_UNIT);
+    fillPattern(buffer, size, 99);
+    logAndCommit(buffer, size);
+    pumpPendingOperations(); /* background erase */
+    verifyBlob(buffer, size);
+
+    TEST_ASSERT_EQUAL(1, FlashJournal_initialize(&journal, &simDriver, &FLASH_JOURNAL_STRATEGY_LOG, callbackHandler));
+    verifyBlob(buffer, size);
+    simAsynchronous = false;
+}
+
+#ifndef AVOID_GREENTEA
+// Custom setup handler required for proper Greentea support
+status_t greentea_setup(const size_t number_of_cases)
+{
+    GREENTEA_SETUP(60, "default_auto");
+    // Call the default reporting function
+    return greentea_test_setup_handler(number_of_cases);
+}
+#else
+status_t default_setup(const size_t)
+{
+    return STATUS_CONTINUE;
+}
+#endif
+
+// Specify all your test cases here
+Case cases[] = {
+    Case("format",                                  test_format),
+    Case("initialize",                              test_initialize),
+    Case("read empty journal",                      test_readEmpty),
+    Case("frequent small commits",                  test_frequentSmallCommits),
+    Case("initialize finds latest blob",            test_initializeFindsLatestBlob),
+    Case("empty commit",                            test_emptyCommit),
+    Case("large blob spanning sectors",             test_largeBlobSpanningSectors),
+    Case("uncommitted blob is discarded",           test_uncommittedBlobIsDiscarded),
+    Case("corrupted blob falls back",               test_corruptedBlobFallsBack),
+    Case("erase counts",                            test_eraseCounts),
+    Case("reset",                                   test_reset),
+    Case("asynchronous format",                     test_asynchronousFormat),
+    Case("asynchronous background erase",           test_asynchronousBackgroundErase),
+    Case("asynchronous reset and large blob",       test_asynchronousResetAndLargeBlob),
+};
+
+// Declare your test specification with a custom setup handler
+#ifndef AVOID_GREENTEA
+Specification specification(greentea_setup, cases);
+#else
+Specification specification(default_setup, cases);
+#endif
+
+int main(int argc, char** argv)
+{
+    // Run the test specification
+    Harness::run(specification);
+}
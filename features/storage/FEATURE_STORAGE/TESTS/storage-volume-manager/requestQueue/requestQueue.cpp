@@ -0,0 +1,738 @@
+/*
+ * Copyright (c) 2006-2016, ARM Limited, All Rights Reserved
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Test cases for the request queue of the storage volume manager.
+ *
+ * The volumes are carved out of a RAM backed storage driver which simulates the
+ * latency of every operation against a virtual clock. The clock only moves
+ * when the test advances it, at which point the operation in progress is
+ * completed and the callback is invoked. The driver logs every operation it is
+ * asked to perform, so that the tests can check the order in which the volume
+ * manager issues requests.
+ */
+
+#ifdef TARGET_LIKE_POSIX
+#define AVOID_GREENTEA
+#endif
+
+#ifndef AVOID_GREENTEA
+#include "greentea-client/test_env.h"
+#endif
+#include "utest/utest.h"
+#include "unity/unity.h"
+
+#include "storage-volume-manager/storage_volume_manager.h"
+#include <string.h>
+#include <inttypes.h>
+
+using namespace utest::v1;
+
+static const uint32_t SIM_ERASE_UNIT   = 1024;
+static const uint32_t SIM_STORAGE_SIZE = 8 * SIM_ERASE_UNIT;
+static const uint32_t SIM_PROGRAM_UNIT = 8;
+
+/* simulated latencies, in ticks of the virtual clock */
+static const uint32_t SIM_SETUP_LATENCY          = 20;
+static const uint32_t SIM_BYTES_PER_READ_TICK    = 16;
+static const uint32_t SIM_BYTES_PER_PROGRAM_TICK = 2;
+static const uint32_t SIM_ERASE_UNIT_LATENCY     = 1000;
+
+/* The volumes under test: the first two are adjacent. */
+static const uint64_t VOLUME0_OFFSET = 0;
+static const uint64_t VOLUME0_SIZE   = 2 * SIM_ERASE_UNIT;
+static const uint64_t VOLUME1_OFFSET = VOLUME0_OFFSET + VOLUME0_SIZE;
+static const uint64_t VOLUME1_SIZE   = 2 * SIM_ERASE_UNIT;
+static const uint64_t VOLUME2_OFFSET = VOLUME1_OFFSET + VOLUME1_SIZE;
+static const uint64_t VOLUME2_SIZE   = 4 * SIM_ERASE_UNIT;
+static const unsigned NUM_VOLUMES    = 3;
+
+/*
+ * RAM backed storage driver with simulated latency
+ */
+static uint8_t                simStorage[SIM_STORAGE_SIZE];
+static bool                   simAsynchronous;
+static bool                   simSynchronousReads; /* complete reads synchronously even when asynchronous */
+static ARM_Storage_Callback_t simCallback;
+static uint32_t               simTime;
+static void                 (*simDuringOperation)(void); /* runs inside the driver call, as an interrupt could */
+
+static struct {
+    ARM_STORAGE_OPERATION  operation;
+    uint64_t               addr;
+    void                  *data;
+    uint32_t               size;
+    uint32_t               completionTime;
+    bool                   pending;
+} simPendingOp;
+
+static const unsigned SIM_OP_LOG_SIZE = 64;
+static struct {
+    ARM_STORAGE_OPERATION  operation;
+    uint64_t               addr;
+    uint32_t               size;
+} simOpLog[SIM_OP_LOG_SIZE];
+static unsigned simOpCount;
+
+static ARM_DRIVER_VERSION simGetVersion(void)
+{
+    ARM_DRIVER_VERSION version = { ARM_STORAGE_API_VERSION, ARM_DRIVER_VERSION_MAJOR_MINOR(1, 0) };
+    return version;
+}
+
+static ARM_STORAGE_CAPABILITIES simGetCapabilities(void)
+{
+    ARM_STORAGE_CAPABILITIES caps;
+
+    memset(&caps, 0, sizeof(caps));
+    caps.asynchronous_ops = simAsynchronous ? 1 : 0;
+    return caps;
+}
+
+static int32_t simInitialize(ARM_Storage_Callback_t callback)
+{
+    simCallback = callback;
+    return 1;
+}
+
+static int32_t simUninitialize(void) { return 1; }
+static int32_t simPowerControl(ARM_POWER_STATE state) { (void) state; return 1; }
+
+static uint32_t simLatency(ARM_STORAGE_OPERATION operation, uint32_t size)
+{
+    switch (operation) {
+        case ARM_STORAGE_OPERATION_READ_DATA:
+            return SIM_SETUP_LATENCY + (size / SIM_BYTES_PER_READ_TICK);
+        case ARM_STORAGE_OPERATION_PROGRAM_DATA:
+            return SIM_SETUP_LATENCY + (size / SIM_BYTES_PER_PROGRAM_TICK);
+        default:
+            return SIM_SETUP_LATENCY + ((size / SIM_ERASE_UNIT) * SIM_ERASE_UNIT_LATENCY);
+    }
+}
+
+static int32_t simDoOperation(ARM_STORAGE_OPERATION operation, uint64_t addr, void *data, uint32_t size)
+{
+    switch (operation) {
+        case ARM_STORAGE_OPERATION_READ_DATA:
+            memcpy(data, &simStorage[addr], size);
+            break;
+        case ARM_STORAGE_OPERATION_PROGRAM_DATA:
+            for (uint32_t i = 0; i < size; i++) {
+                simStorage[addr + i] &= ((const uint8_t *)data)[i];
+            }
+            break;
+        default:
+            memset(&simStorage[addr], 0xFF, size);
+            break;
+    }
+    return size;
+}
+
+static int32_t simSubmit(ARM_STORAGE_OPERATION operation, uint64_t addr, void *data, uint32_t size)
+{
+    /* the volume manager must never have more than one operation outstanding */
+    TEST_ASSERT_FALSE(simPendingOp.pending);
+
+    TEST_ASSERT(simOpCount < SIM_OP_LOG_SIZE);
+    simOpLog[simOpCount].operation = operation;
+    simOpLog[simOpCount].addr      = addr;
+    simOpLog[simOpCount].size      = size;
+    simOpCount++;
+
+    if (simDuringOperation != NULL) {
+        void (*duringOperation)(void) = simDuringOperation;
+        simDuringOperation = NULL;
+        duringOperation();
+    }
+
+    if (!simAsynchronous || (simSynchronousReads && (operation == ARM_STORAGE_OPERATION_READ_DATA))) {
+        return simDoOperation(operation, addr, data, size);
+    }
+
+    simPendingOp.operation      = operation;
+    simPendingOp.addr           = addr;
+    simPendingOp.data           = data;
+    simPendingOp.size           = size;
+    simPendingOp.completionTime = simTime + simLatency(operation, size);
+    simPendingOp.pending        = true;
+    return ARM_DRIVER_OK;
+}
+
+static int32_t simReadData(uint64_t addr, void *data, uint32_t size)
+{
+    if (addr + size > SIM_STORAGE_SIZE) {
+        return ARM_DRIVER_ERROR_PARAMETER;
+    }
+    return simSubmit(ARM_STORAGE_OPERATION_READ_DATA, addr, data, size);
+}
+
+static int32_t simProgramData(uint64_t addr, const void *data, uint32_t size)
+{
+    if ((addr + size > SIM_STORAGE_SIZE) || (addr % SIM_PROGRAM_UNIT) || (size % SIM_PROGRAM_UNIT) || (size == 0)) {
+        return ARM_DRIVER_ERROR_PARAMETER;
+    }
+    return simSubmit(ARM_STORAGE_OPERATION_PROGRAM_DATA, addr, const_cast<void *>(data), size);
+}
+
+static int32_t simErase(uint64_t addr, uint32_t size)
+{
+    if ((addr + size > SIM_STORAGE_SIZE) || (addr % SIM_ERASE_UNIT) || (size % SIM_ERASE_UNIT) || (size == 0)) {
+        return ARM_DRIVER_ERROR_PARAMETER;
+    }
+    return simSubmit(ARM_STORAGE_OPERATION_ERASE, addr, NULL, size);
+}
+
+static int32_t simEraseAll(void)
+{
+    return simErase(0, SIM_STORAGE_SIZE);
+}
+
+static ARM_STORAGE_STATUS simGetStatus(void)
+{
+    ARM_STORAGE_STATUS status;
+
+    memset(&status, 0, sizeof(status));
+    status.busy = simPendingOp.pending ? 1 : 0;
+    return status;
+}
+
+static int32_t simGetInfo(ARM_STORAGE_INFO *info)
+{
+    memset(info, 0, sizeof(*info));
+    info->total_storage        = SIM_STORAGE_SIZE;
+    info->program_unit         = SIM_PROGRAM_UNIT;
+    info->optimal_program_unit = SIM_PROGRAM_UNIT;
+    info->program_cycles       = ARM_STORAGE_PROGRAM_CYCLES_INFINITE;
+    info->erased_value         = 1;
+    return ARM_DRIVER_OK;
+}
+
+static uint32_t simResolveAddress(uint64_t addr)
+{
+    return (uint32_t) addr;
+}
+
+static int32_t simGetNextBlock(const ARM_STORAGE_BLOCK* prev_block, ARM_STORAGE_BLOCK *next_block)
+{
+    if (prev_block != NULL) {
+        next_block->addr = ARM_STORAGE_INVALID_OFFSET;
+        next_block->size = 0;
+        return ARM_DRIVER_ERROR;
+    }
+    memset(next_block, 0, sizeof(*next_block));
+    next_block->addr                       = 0;
+    next_block->size                       = SIM_STORAGE_SIZE;
+    next_block->attributes.erasable        = 1;
+    next_block->attributes.programmable    = 1;
+    next_block->attributes.erase_unit      = SIM_ERASE_UNIT;
+    next_block->attributes.protection_unit = SIM_ERASE_UNIT;
+    return ARM_DRIVER_OK;
+}
+
+static int32_t simGetBlock(uint64_t addr, ARM_STORAGE_BLOCK *block)
+{
+    if (addr >= SIM_STORAGE_SIZE) {
+        return ARM_DRIVER_ERROR;
+    }
+    return simGetNextBlock(NULL, block);
+}
+
+static ARM_DRIVER_STORAGE simDriver = {
+    simGetVersion,
+    simGetCapabilities,
+    simInitialize,
+    simUninitialize,
+    simPowerControl,
+    simReadData,
+    simProgramData,
+    simErase,
+    simEraseAll,
+    simGetStatus,
+    simGetInfo,
+    simResolveAddress,
+    simGetNextBlock,
+    simGetBlock
+};
+
+static uint32_t simClock(void)
+{
+    return simTime;
+}
+
+/**
+ * Advance the virtual clock until the pending operation completes, and invoke
+ * the callback.
+ */
+static void completePendingOperation(void)
+{
+    TEST_ASSERT_TRUE(simPendingOp.pending);
+    simPendingOp.pending = false;
+    simTime              = simPendingOp.completionTime;
+
+    int32_t status = simDoOperation(simPendingOp.operation, simPendingOp.addr, simPendingOp.data, simPendingOp.size);
+    simCallback(status, simPendingOp.operation);
+}
+
+/**
+ * Complete the pending operations, including the ones issued from the
+ * completion callbacks.
+ * @return the number of operations completed.
+ */
+static uint32_t pumpPendingOperations(void)
+{
+    uint32_t count = 0;
+    while (simPendingOp.pending) {
+        completePendingOperation();
+        count++;
+    }
+
+    return count;
+}
+
+
+static StorageVolumeManager volumeManager;
+static StorageVolume       *volumes[NUM_VOLUMES];
+
+static const unsigned COMPLETION_LOG_SIZE = 64;
+static struct {
+    unsigned               volume;
+    int32_t                status;
+    ARM_STORAGE_OPERATION  operation;
+} completionLog[COMPLETION_LOG_SIZE];
+static unsigned completionCount;
+
+/* Reads to be re-issued by the completion callback of a volume; see test_readsDoNotStarveOtherVolumes(). */
+static unsigned rereadsRemaining[NUM_VOLUMES];
+
+static uint8_t buffer[NUM_VOLUMES][1024];
+static uint8_t readBuffer[NUM_VOLUMES][1024];
+
+static void recordCompletion(unsigned volume, int32_t status, ARM_STORAGE_OPERATION operation)
+{
+    TEST_ASSERT(completionCount < COMPLETION_LOG_SIZE);
+    completionLog[completionCount].volume    = volume;
+    completionLog[completionCount].status    = status;
+    completionLog[completionCount].operation = operation;
+    completionCount++;
+
+    if (rereadsRemaining[volume] > 0) {
+        rereadsRemaining[volume]--;
+        TEST_ASSERT_EQUAL(ARM_DRIVER_OK, volumes[volume]->ReadData(0, readBuffer[volume], 64));
+    }
+}
+
+void volume0CallbackHandler(int32_t status, ARM_STORAGE_OPERATION operation)
+{
+    recordCompletion(0, status, operation);
+}
+
+void volume1CallbackHandler(int32_t status, ARM_STORAGE_OPERATION operation)
+{
+    recordCompletion(1, status, operation);
+}
+
+void volume2CallbackHandler(int32_t status, ARM_STORAGE_OPERATION operation)
+{
+    recordCompletion(2, status, operation);
+}
+
+static const ARM_Storage_Callback_t volumeCallbacks[NUM_VOLUMES] = {
+    volume0CallbackHandler,
+    volume1CallbackHandler,
+    volume2CallbackHandler,
+};
+
+/**
+ * Initialize the volume manager over the simulated driver, and set up the
+ * volumes under test.
+ */
+static void setupVolumes(bool asynchronous)
+{
+    const uint64_t offsets[NUM_VOLUMES] = {VOLUME0_OFFSET, VOLUME1_OFFSET, VOLUME2_OFFSET};
+    const uint64_t sizes[NUM_VOLUMES]   = {VOLUME0_SIZE,   VOLUME1_SIZE,   VOLUME2_SIZE};
+
+    memset(simStorage, 0xFF, sizeof(simStorage));
+    memset(&simPendingOp, 0, sizeof(simPendingOp));
+    memset(rereadsRemaining, 0, sizeof(rereadsRemaining));
+    simAsynchronous     = asynchronous;
+    simSynchronousReads = false;
+    simDuringOperation  = NULL;
+    simOpCount          = 0;
+    completionCount     = 0;
+
+    TEST_ASSERT_EQUAL(1, volumeManager.initialize(&simDriver, NULL));
+    volumeManager.setClock(simClock);
+    for (unsigned index = 0; index < NUM_VOLUMES; index++) {
+        TEST_ASSERT_EQUAL(ARM_DRIVER_OK, volumeManager.addVolume(offsets[index], sizes[index], &volumes[index]));
+        TEST_ASSERT_EQUAL(1, volumes[index]->Initialize(volumeCallbacks[index]));
+    }
+}
+
+static void fillPattern(uint8_t *data, size_t size, uint32_t seed)
+{
+    for (size_t i = 0; i < size; i++) {
+        data[i] = (uint8_t)((i * 7) + (seed * 13) + 1);
+    }
+}
+
+/* With a synchronous driver, there is never anything to queue. */
+void test_synchronousDriver()
+{
+    setupVolumes(false /* asynchronous */);
+
+    for (unsigned index = 0; index < NUM_VOLUMES; index++) {
+        fillPattern(buffer[index], 256, index);
+        TEST_ASSERT_EQUAL((int32_t)SIM_ERASE_UNIT, volumes[index]->Erase(0, SIM_ERASE_UNIT));
+        TEST_ASSERT_EQUAL(256, volumes[index]->ProgramData(64, buffer[index], 256));
+        TEST_ASSERT_EQUAL(0, volumes[index]->GetStatus().busy);
+    }
+    for (unsigned index = 0; index < NUM_VOLUMES; index++) {
+        TEST_ASSERT_EQUAL(256, volumes[index]->ReadData(64, readBuffer[index], 256));
+        TEST_ASSERT_EQUAL(0, memcmp(buffer[index], readBuffer[index], 256));
+
+        const StorageVolumeStats_t &stats = volumes[index]->getStats();
+        TEST_ASSERT_EQUAL(1, stats.eraseOps);
+        TEST_ASSERT_EQUAL(1, stats.programOps);
+        TEST_ASSERT_EQUAL(1, stats.readOps);
+        TEST_ASSERT_EQUAL(SIM_ERASE_UNIT, stats.bytesErased);
+        TEST_ASSERT_EQUAL(256, stats.bytesProgrammed);
+        TEST_ASSERT_EQUAL(256, stats.bytesRead);
+        TEST_ASSERT_EQUAL(0, stats.queuedOps);
+        TEST_ASSERT_EQUAL(0, stats.mergedOps);
+    }
+    TEST_ASSERT_EQUAL(0, completionCount);
+}
+
+/* Requests from different volumes are queued rather than rejected; a volume may still only have one request outstanding. */
+void test_serializesAcrossVolumes()
+{
+    setupVolumes(true /* asynchronous */);
+
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, volumes[0]->Erase(0, SIM_ERASE_UNIT));
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, volumes[1]->Erase(SIM_ERASE_UNIT, SIM_ERASE_UNIT));
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, volumes[2]->Erase(0, 2 * SIM_ERASE_UNIT));
+    TEST_ASSERT_EQUAL(1, simOpCount);
+
+    for (unsigned index = 0; index < NUM_VOLUMES; index++) {
+        TEST_ASSERT_EQUAL(1, volumes[index]->GetStatus().busy);
+        TEST_ASSERT_EQUAL(ARM_DRIVER_ERROR_BUSY, volumes[index]->ReadData(0, readBuffer[index], 64));
+        TEST_ASSERT_EQUAL(ARM_DRIVER_ERROR_BUSY, volumes[index]->ProgramData(0, buffer[index], 64));
+        TEST_ASSERT_EQUAL(ARM_DRIVER_ERROR_BUSY, volumes[index]->Erase(0, SIM_ERASE_UNIT));
+    }
+
+    TEST_ASSERT_EQUAL(3, pumpPendingOperations());
+    TEST_ASSERT_EQUAL(3, completionCount);
+    TEST_ASSERT_EQUAL(3, simOpCount);
+
+    /* erases are issued in the order of submission */
+    const uint64_t expectedAddr[NUM_VOLUMES] = {VOLUME0_OFFSET, VOLUME1_OFFSET + SIM_ERASE_UNIT, VOLUME2_OFFSET};
+    const uint32_t expectedSize[NUM_VOLUMES] = {SIM_ERASE_UNIT, SIM_ERASE_UNIT, 2 * SIM_ERASE_UNIT};
+    for (unsigned index = 0; index < NUM_VOLUMES; index++) {
+        TEST_ASSERT_EQUAL(ARM_STORAGE_OPERATION_ERASE, simOpLog[index].operation);
+        TEST_ASSERT_EQUAL(expectedAddr[index], simOpLog[index].addr);
+        TEST_ASSERT_EQUAL(expectedSize[index], simOpLog[index].size);
+
+        TEST_ASSERT_EQUAL(index, completionLog[index].volume);
+        TEST_ASSERT_EQUAL(ARM_STORAGE_OPERATION_ERASE, completionLog[index].operation);
+        TEST_ASSERT_EQUAL((int32_t)expectedSize[index], completionLog[index].status);
+        TEST_ASSERT_EQUAL(0, volumes[index]->GetStatus().busy);
+    }
+    TEST_ASSERT_EQUAL(0, volumes[0]->getStats().queuedOps);
+    TEST_ASSERT_EQUAL(1, volumes[1]->getStats().queuedOps);
+    TEST_ASSERT_EQUAL(1, volumes[2]->getStats().queuedOps);
+}
+
+/* A queued request which the MTD completes synchronously is reported through the callback. */
+void test_queuedSynchronousCompletion()
+{
+    setupVolumes(true /* asynchronous */);
+    simSynchronousReads = true;
+
+    fillPattern(buffer[0], 128, 3);
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, volumes[0]->ProgramData(0, buffer[0], 128));
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, volumes[1]->ReadData(0, readBuffer[1], 128));
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, volumes[2]->Erase(0, SIM_ERASE_UNIT));
+
+    /* completing the program issues the read, which completes synchronously, and then the erase */
+    completePendingOperation();
+    TEST_ASSERT_EQUAL(2, completionCount);
+    TEST_ASSERT_EQUAL(0, completionLog[0].volume);
+    TEST_ASSERT_EQUAL(128, completionLog[0].status);
+    TEST_ASSERT_EQUAL(1, completionLog[1].volume);
+    TEST_ASSERT_EQUAL(128, completionLog[1].status);
+    TEST_ASSERT_EQUAL(ARM_STORAGE_OPERATION_READ_DATA, completionLog[1].operation);
+    TEST_ASSERT_TRUE(simPendingOp.pending);
+    TEST_ASSERT_EQUAL(ARM_STORAGE_OPERATION_ERASE, simPendingOp.operation);
+
+    TEST_ASSERT_EQUAL(1, pumpPendingOperations());
+    TEST_ASSERT_EQUAL(3, completionCount);
+    TEST_ASSERT_EQUAL(2, completionLog[2].volume);
+
+    /* with the MTD idle, a read completes synchronously and returns directly */
+    TEST_ASSERT_EQUAL(128, volumes[1]->ReadData(0, readBuffer[1], 128));
+    TEST_ASSERT_EQUAL(3, completionCount);
+}
+
+static void submitReadFromVolume1(void)
+{
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, volumes[1]->ReadData(0, readBuffer[1], 64));
+}
+
+/* A request submitted while another volume's synchronous operation is in the MTD is queued, and issued once it returns. */
+void test_submitDuringSynchronousOperation()
+{
+    setupVolumes(true /* asynchronous */);
+    simSynchronousReads = true;
+    simDuringOperation  = submitReadFromVolume1;
+
+    TEST_ASSERT_EQUAL(64, volumes[0]->ReadData(0, readBuffer[0], 64));
+    TEST_ASSERT_EQUAL(2, simOpCount);
+    TEST_ASSERT_EQUAL(VOLUME0_OFFSET, simOpLog[0].addr);
+    TEST_ASSERT_EQUAL(VOLUME1_OFFSET, simOpLog[1].addr);
+    TEST_ASSERT_FALSE(simPendingOp.pending);
+
+    /* only the queued read is reported through the callback */
+    TEST_ASSERT_EQUAL(1, completionCount);
+    TEST_ASSERT_EQUAL(1, completionLog[0].volume);
+    TEST_ASSERT_EQUAL(64, completionLog[0].status);
+    TEST_ASSERT_EQUAL(1, volumes[1]->getStats().queuedOps);
+}
+
+/* Queued reads are issued ahead of older programs and erases. */
+void test_readsAheadOfOlderRequests()
+{
+    setupVolumes(true /* asynchronous */);
+
+    fillPattern(buffer[0], 256, 0);
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, volumes[2]->Erase(0, SIM_ERASE_UNIT));
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, volumes[0]->ProgramData(0, buffer[0], 256));
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, volumes[1]->ReadData(0, readBuffer[1], 256));
+
+    TEST_ASSERT_EQUAL(3, pumpPendingOperations());
+    TEST_ASSERT_EQUAL(ARM_STORAGE_OPERATION_ERASE,        simOpLog[0].operation);
+    TEST_ASSERT_EQUAL(ARM_STORAGE_OPERATION_READ_DATA,    simOpLog[1].operation);
+    TEST_ASSERT_EQUAL(VOLUME1_OFFSET,                     simOpLog[1].addr);
+    TEST_ASSERT_EQUAL(ARM_STORAGE_OPERATION_PROGRAM_DATA, simOpLog[2].operation);
+    TEST_ASSERT_EQUAL(VOLUME0_OFFSET,                     simOpLog[2].addr);
+
+    TEST_ASSERT_EQUAL(3, completionCount);
+    TEST_ASSERT_EQUAL(2, completionLog[0].volume);
+    TEST_ASSERT_EQUAL(1, completionLog[1].volume);
+    TEST_ASSERT_EQUAL(0, completionLog[2].volume);
+    TEST_ASSERT_EQUAL(256, completionLog[2].status);
+}
+
+/* A stream of reads from two volumes delays an older program only for a bounded number of reads. */
+void test_readsDoNotStarveOtherVolumes()
+{
+    setupVolumes(true /* asynchronous */);
+
+    const unsigned NUM_REREADS = 10;
+    fillPattern(buffer[0], 64, 0);
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, volumes[2]->Erase(SIM_ERASE_UNIT, SIM_ERASE_UNIT));
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, volumes[0]->ProgramData(0, buffer[0], 64));
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, volumes[1]->ReadData(0, readBuffer[1], 64));
+    rereadsRemaining[1] = NUM_REREADS;
+    rereadsRemaining[2] = NUM_REREADS; /* volume 2 joins in with reads once its erase completes */
+
+    pumpPendingOperations();
+    TEST_ASSERT_EQUAL(1 + 1 + (1 + NUM_REREADS) + NUM_REREADS, simOpCount);
+
+    unsigned programIndex;
+    for (programIndex = 0; programIndex < simOpCount; programIndex++) {
+        if (simOpLog[programIndex].operation == ARM_STORAGE_OPERATION_PROGRAM_DATA) {
+            break;
+        }
+    }
+    TEST_ASSERT_EQUAL(1 + STORAGE_VOLUME_MANAGER_MAX_READ_BYPASS, programIndex);
+    for (unsigned index = 1; index < programIndex; index++) {
+        TEST_ASSERT_EQUAL(ARM_STORAGE_OPERATION_READ_DATA, simOpLog[index].operation);
+    }
+}
+
+/* A completion callback which launches another request joins the back of the queue. */
+void test_callbackRequestJoinsBackOfQueue()
+{
+    setupVolumes(true /* asynchronous */);
+
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, volumes[0]->ReadData(0, readBuffer[0], 64));
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, volumes[1]->ReadData(0, readBuffer[1], 64));
+    rereadsRemaining[0] = 1;
+
+    TEST_ASSERT_EQUAL(3, pumpPendingOperations());
+    TEST_ASSERT_EQUAL(VOLUME0_OFFSET, simOpLog[0].addr);
+    TEST_ASSERT_EQUAL(VOLUME1_OFFSET, simOpLog[1].addr);
+    TEST_ASSERT_EQUAL(VOLUME0_OFFSET, simOpLog[2].addr);
+}
+
+/* Programs queued against adjacent ranges of neighbouring volumes are merged into a single program. */
+void test_mergesAdjacentPrograms()
+{
+    if (STORAGE_VOLUME_MANAGER_MERGE_BUFFER_SIZE == 0) {
+        return; /* merging is disabled */
+    }
+
+    setupVolumes(true /* asynchronous */);
+
+    const uint32_t SIZEOF_PROGRAM = 128;
+    fillPattern(buffer[0], SIZEOF_PROGRAM, 10);
+    fillPattern(buffer[1], SIZEOF_PROGRAM, 11);
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, volumes[2]->Erase(0, SIM_ERASE_UNIT));
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, volumes[1]->ProgramData(0, buffer[1], SIZEOF_PROGRAM));
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, volumes[0]->ProgramData(VOLUME0_SIZE - SIZEOF_PROGRAM, buffer[0], SIZEOF_PROGRAM));
+
+    TEST_ASSERT_EQUAL(2, pumpPendingOperations());
+    TEST_ASSERT_EQUAL(2, simOpCount);
+    TEST_ASSERT_EQUAL(ARM_STORAGE_OPERATION_PROGRAM_DATA, simOpLog[1].operation);
+    TEST_ASSERT_EQUAL(VOLUME1_OFFSET - SIZEOF_PROGRAM,    simOpLog[1].addr);
+    TEST_ASSERT_EQUAL(2 * SIZEOF_PROGRAM,                 simOpLog[1].size);
+
+    /* each volume receives a callback with the size of its own program */
+    TEST_ASSERT_EQUAL(3, completionCount);
+    for (unsigned index = 1; index < 3; index++) {
+        TEST_ASSERT_EQUAL(ARM_STORAGE_OPERATION_PROGRAM_DATA, completionLog[index].operation);
+        TEST_ASSERT_EQUAL((int32_t)SIZEOF_PROGRAM, completionLog[index].status);
+    }
+    TEST_ASSERT_EQUAL(0, memcmp(&simStorage[VOLUME1_OFFSET - SIZEOF_PROGRAM], buffer[0], SIZEOF_PROGRAM));
+    TEST_ASSERT_EQUAL(0, memcmp(&simStorage[VOLUME1_OFFSET], buffer[1], SIZEOF_PROGRAM));
+
+    for (unsigned index = 0; index < 2; index++) {
+        const StorageVolumeStats_t &stats = volumes[index]->getStats();
+        TEST_ASSERT_EQUAL(1, stats.mergedOps);
+        TEST_ASSERT_EQUAL(1, stats.programOps);
+        TEST_ASSERT_EQUAL(SIZEOF_PROGRAM, stats.bytesProgrammed);
+    }
+
+    /* the programmed data reads back through the volumes */
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, volumes[0]->ReadData(VOLUME0_SIZE - SIZEOF_PROGRAM, readBuffer[0], SIZEOF_PROGRAM));
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, volumes[1]->ReadData(0, readBuffer[1], SIZEOF_PROGRAM));
+    TEST_ASSERT_EQUAL(2, pumpPendingOperations());
+    TEST_ASSERT_EQUAL(0, memcmp(buffer[0], readBuffer[0], SIZEOF_PROGRAM));
+    TEST_ASSERT_EQUAL(0, memcmp(buffer[1], readBuffer[1], SIZEOF_PROGRAM));
+}
+
+/* Programs aren't merged unless they are adjacent and fit within the merge buffer. */
+void test_doesNotMergeUnsuitablePrograms()
+{
+    if (STORAGE_VOLUME_MANAGER_MERGE_BUFFER_SIZE == 0) {
+        return; /* merging is disabled */
+    }
+
+    setupVolumes(true /* asynchronous */);
+
+    /* a gap of one program unit */
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, volumes[2]->Erase(0, SIM_ERASE_UNIT));
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, volumes[0]->ProgramData(VOLUME0_SIZE - 64, buffer[0], 64));
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, volumes[1]->ProgramData(SIM_PROGRAM_UNIT, buffer[1], 64));
+    TEST_ASSERT_EQUAL(3, pumpPendingOperations());
+    TEST_ASSERT_EQUAL(3, simOpCount);
+
+    /* adjacent, but too large to be merged */
+    const uint32_t SIZEOF_LARGE_PROGRAM = STORAGE_VOLUME_MANAGER_MERGE_BUFFER_SIZE;
+    TEST_ASSERT(SIZEOF_LARGE_PROGRAM <= sizeof(buffer[0]));
+    simOpCount = 0;
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, volumes[2]->Erase(0, SIM_ERASE_UNIT));
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, volumes[0]->ProgramData(VOLUME0_SIZE - SIZEOF_LARGE_PROGRAM, buffer[0], SIZEOF_LARGE_PROGRAM));
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, volumes[1]->ProgramData(0, buffer[1], 64));
+    TEST_ASSERT_EQUAL(3, pumpPendingOperations());
+    TEST_ASSERT_EQUAL(3, simOpCount);
+
+    for (unsigned index = 0; index < 2; index++) {
+        TEST_ASSERT_EQUAL(0, volumes[index]->getStats().mergedOps);
+        TEST_ASSERT_EQUAL(2, volumes[index]->getStats().programOps);
+    }
+}
+
+/* Statistics are timed against the clock installed with setClock(). */
+void test_statistics()
+{
+    setupVolumes(true /* asynchronous */);
+    const uint32_t startTime = simTime;
+
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, volumes[0]->Erase(0, SIM_ERASE_UNIT));
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, volumes[1]->ReadData(0, readBuffer[1], 512));
+    TEST_ASSERT_EQUAL(2, pumpPendingOperations());
+
+    const uint32_t eraseLatency = simLatency(ARM_STORAGE_OPERATION_ERASE, SIM_ERASE_UNIT);
+    const uint32_t readLatency  = simLatency(ARM_STORAGE_OPERATION_READ_DATA, 512);
+    TEST_ASSERT_EQUAL(startTime + eraseLatency + readLatency, simTime);
+
+    const StorageVolumeStats_t &stats0 = volumes[0]->getStats();
+    TEST_ASSERT_EQUAL(1, stats0.eraseOps);
+    TEST_ASSERT_EQUAL(SIM_ERASE_UNIT, stats0.bytesErased);
+    TEST_ASSERT_EQUAL(0, stats0.queuedOps);
+    TEST_ASSERT_EQUAL(0, stats0.queueTime);
+    TEST_ASSERT_EQUAL(eraseLatency, stats0.serviceTime);
+
+    const StorageVolumeStats_t &stats1 = volumes[1]->getStats();
+    TEST_ASSERT_EQUAL(1, stats1.readOps);
+    TEST_ASSERT_EQUAL(512, stats1.bytesRead);
+    TEST_ASSERT_EQUAL(1, stats1.queuedOps);
+    TEST_ASSERT_EQUAL(eraseLatency, stats1.queueTime);
+    TEST_ASSERT_EQUAL(readLatency, stats1.serviceTime);
+
+    /* failed requests aren't counted */
+    TEST_ASSERT_EQUAL(ARM_DRIVER_ERROR_PARAMETER, volumes[0]->ProgramData(1, buffer[0], 64));
+    TEST_ASSERT_EQUAL(0, stats0.programOps);
+
+    volumes[1]->resetStats();
+    TEST_ASSERT_EQUAL(0, stats1.readOps);
+    TEST_ASSERT_EQUAL(0, stats1.bytesRead);
+    TEST_ASSERT_EQUAL(0, stats1.serviceTime);
+}
+
+#ifndef AVOID_GREENTEA
+// Custom setup handler required for proper Greentea support
+status_t greentea_setup(const size_t number_of_cases)
+{
+    GREENTEA_SETUP(30, "default_auto");
+    // Call the default reporting function
+    return greentea_test_setup_handler(number_of_cases);
+}
+#else
+status_t default_setup(const size_t)
+{
+    return STATUS_CONTINUE;
+}
+#endif
+
+// Specify all your test cases here
+Case cases[] = {
+    Case("synchronous driver",                      test_synchronousDriver),
+    Case("serializes requests across volumes",      test_serializesAcrossVolumes),
+    Case("queued synchronous completion",           test_queuedSynchronousCompletion),
+    Case("submit during synchronous operation",     test_submitDuringSynchronousOperation),
+    Case("reads ahead of older requests",           test_readsAheadOfOlderRequests),
+    Case("reads do not starve other volumes",       test_readsDoNotStarveOtherVolumes),
+    Case("callback request joins back of queue",    test_callbackRequestJoinsBackOfQueue),
+    Case("merges adjacent programs",                test_mergesAdjacentPrograms),
+    Case("does not merge unsuitable programs",      test_doesNotMergeUnsuitablePrograms),
+    Case("statistics",                              test_statistics),
+};
+
+// Declare your test specification with a custom setup handler
+#ifndef AVOID_GREENTEA
+Specification specification(greentea_setup, cases);
+#else
+Specification specification(default_setup, cases);
+#endif
+
+int main(int argc, char** argv)
+{
+    // Run the test specification
+    Harness::run(specification);
+}
@@ -869,6 +869,41 @@ typedef struct _ARM_DRIVER_CFSTORE
      */
     int32_t (*Write)(ARM_CFSTORE_HANDLE hkey, const char* data, ARM_CFSTORE_SIZE* len);
 
+    /** @brief  Start a batch of Create() and Delete() operations.
+     *
+     * Inside a batch, Delete() only marks the KV as deleted. The space of the
+     * deleted KVs is reclaimed in a single pass by EndBatch() (or Flush()),
+     * rather than moving the rest of the area on each Delete(). The size_hint
+     * is used to reserve space for the KVs to be created so that the area is
+     * not grown for each Create().
+     *
+     * @note    Batches are not atomic: operations completed before an error
+     *          are not rolled back. Batches may be nested, only the outermost
+     *          EndBatch() reclaims the space.
+     *
+     * @param   size_hint
+     *          IN: expected total size of the key names and values to be
+     *          created in the batch. 0 if unknown.
+     *
+     * @return
+     *          This function completes synchronously and there is no
+     *          completion notification.
+     *          return_value == ARM_DRIVER_OK (==0) => success.
+     *          return_value < 0, error condition.
+     */
+    int32_t (*BeginBatch)(ARM_CFSTORE_SIZE size_hint);
+
+    /** @brief  End a batch started with BeginBatch().
+     *
+     * @return
+     *          This function completes synchronously and there is no
+     *          completion notification.
+     *          return_value == ARM_DRIVER_OK (==0) => success.
+     *          return_value < 0, error condition, e.g. ARM_DRIVER_ERROR
+     *          if no batch has been started.
+     */
+    int32_t (*EndBatch)(void);
+
 } const ARM_CFSTORE_DRIVER;
 
 
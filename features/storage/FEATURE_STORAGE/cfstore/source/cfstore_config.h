@@ -60,5 +60,14 @@
 #define CFSTORE_STORAGE_DRIVER_CONFIG_HARDWARE_MTD_ASYNC_OPS STORAGE_CONFIG_HARDWARE_MTD_K64F_ASYNC_OPS
 #endif
 
+/* CFSTORE_DELTA_LOG_SIZE
+ *   size of the storage volume at the end of the cfstore region used for the
+ *   delta log, so a flush appends the changed KVs rather than rewriting them
+ *   all to the journal. 0 disables the delta log.
+ */
+#ifndef CFSTORE_DELTA_LOG_SIZE
+#define CFSTORE_DELTA_LOG_SIZE 0
+#endif
+
 
 #endif /*__CFSTORE_CONFIG_H*/
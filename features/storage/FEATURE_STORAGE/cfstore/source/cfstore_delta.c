@@ -0,0 +1,492 @@
+/*
+ * mbed Microcontroller Library
+ * Copyright (c) 2006-2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/** @file  cfstore_delta.c
+ *
+ * Append-only delta log for configuration store. See cfstore_delta.h for the
+ * format. The log is written with synchronous storage operations only, as it
+ * is appended to from within the flush fsm handlers.
+ */
+
+#include "cfstore_config.h"
+#include "cfstore_debug.h"
+#include "cfstore_delta.h"
+#include "flash_journal_crc.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define CFSTORE_DELTA_LOG_MAGIC             0xCFDE17A0UL
+#define CFSTORE_DELTA_LOG_VERSION           1
+#define CFSTORE_DELTA_RECORD_MAGIC          0xCFDE17A1UL
+
+/* @brief   header at the start of the delta log volume */
+typedef struct cfstore_delta_log_header_t
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t base_crc;
+    uint32_t crc32;
+} cfstore_delta_log_header_t;
+
+/* @brief   gather list entry for the data being programmed */
+typedef struct cfstore_delta_seg_t
+{
+    const uint8_t *data;
+    uint32_t len;
+} cfstore_delta_seg_t;
+
+
+static inline uint32_t cfstore_delta_round_up(uint32_t n, uint32_t unit)
+{
+    return ((n + unit - 1) / unit) * unit;
+}
+
+uint32_t cfstore_delta_record_size(cfstore_delta_log_t *log, uint32_t length)
+{
+    return cfstore_delta_round_up(sizeof(cfstore_delta_record_t) + length, log->program_unit);
+}
+
+static inline uint32_t cfstore_delta_first_slot(cfstore_delta_log_t *log)
+{
+    return cfstore_delta_round_up(sizeof(cfstore_delta_log_header_t), log->program_unit);
+}
+
+static inline uint32_t cfstore_delta_first_record(cfstore_delta_log_t *log)
+{
+    return cfstore_delta_first_slot(log) + CFSTORE_DELTA_COMPACT_SLOTS * cfstore_delta_record_size(log, sizeof(uint32_t));
+}
+
+uint32_t cfstore_delta_crc(const void *data, uint32_t size)
+{
+    flashJournalCrcReset();
+    return flashJournalCrcCummulative((const unsigned char *) data, (int) size);
+}
+
+/* @brief   number of bytes that can still be appended */
+uint32_t cfstore_delta_space(cfstore_delta_log_t *log)
+{
+    uint32_t offset = log->formatted ? log->offset : cfstore_delta_first_record(log);
+
+    return offset < log->size ? log->size - offset : 0;
+}
+
+int32_t cfstore_delta_read(cfstore_delta_log_t *log, uint32_t offset, void *data, uint32_t size)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+    uint8_t *ptr = (uint8_t *) data;
+
+    while(size > 0){
+        ret = log->mtd->ReadData(log->addr + offset, ptr, size);
+        if(ret <= ARM_DRIVER_OK){
+            CFSTORE_ERRLOG("%s:Error: ReadData() failed (ret=%d)\n", __func__, (int) ret);
+            return ret < ARM_DRIVER_OK ? ret : ARM_DRIVER_ERROR;
+        }
+        offset += ret;
+        ptr += ret;
+        size -= ret;
+    }
+    return ARM_DRIVER_OK;
+}
+
+static int32_t cfstore_delta_program(cfstore_delta_log_t *log, uint32_t offset, const uint8_t *data, uint32_t size)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+
+    while(size > 0){
+        ret = log->mtd->ProgramData(log->addr + offset, data, size);
+        if(ret <= ARM_DRIVER_OK){
+            CFSTORE_ERRLOG("%s:Error: ProgramData() failed (ret=%d)\n", __func__, (int) ret);
+            return ret < ARM_DRIVER_OK ? ret : ARM_DRIVER_ERROR;
+        }
+        offset += ret;
+        data += ret;
+        size -= ret;
+    }
+    return ARM_DRIVER_OK;
+}
+
+/* @brief   program the concatenation of the segments at offset, padded to the program unit */
+static int32_t cfstore_delta_program_segs(cfstore_delta_log_t *log, uint32_t offset, const cfstore_delta_seg_t *seg, uint32_t nsegs)
+{
+    int32_t ret = ARM_DRIVER_OK;
+    uint8_t stage[CFSTORE_DELTA_STAGE_SIZE];
+    uint32_t used = 0;
+    uint32_t pos = 0;
+    uint32_t len = 0;
+
+    for(; nsegs > 0; seg++, nsegs--){
+        for(pos = 0; pos < seg->len; pos += len){
+            len = seg->len - pos;
+            if(len > CFSTORE_DELTA_STAGE_SIZE - used){
+                len = CFSTORE_DELTA_STAGE_SIZE - used;
+            }
+            memcpy(&stage[used], seg->data + pos, len);
+            used += len;
+            if(used == CFSTORE_DELTA_STAGE_SIZE){
+                ret = cfstore_delta_program(log, offset, stage, used);
+                if(ret < ARM_DRIVER_OK){
+                    return ret;
+                }
+                offset += used;
+                used = 0;
+            }
+        }
+    }
+    if(used > 0){
+        len = cfstore_delta_round_up(used, log->program_unit);
+        memset(&stage[used], 0, len - used);
+        ret = cfstore_delta_program(log, offset, stage, len);
+    }
+    return ret;
+}
+
+/* @brief   check the record at offset
+ *
+ * @return  1 if the record is valid, 0 if not, < 0 on storage error
+ */
+static int32_t cfstore_delta_check_record(cfstore_delta_log_t *log, uint32_t offset, cfstore_delta_record_t *rec)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+    uint8_t buf[CFSTORE_DELTA_STAGE_SIZE];
+    uint32_t crc = 0;
+    uint32_t pos = 0;
+    uint32_t len = 0;
+    cfstore_delta_record_t hdr;
+
+    ret = cfstore_delta_read(log, offset, rec, sizeof(*rec));
+    if(ret < ARM_DRIVER_OK){
+        return ret;
+    }
+    if(rec->magic != CFSTORE_DELTA_RECORD_MAGIC || rec->type < CFSTORE_DELTA_RECORD_PUT || rec->type > CFSTORE_DELTA_RECORD_COMPACT){
+        return 0;
+    }
+    if(rec->length > log->size - offset - sizeof(*rec)){
+        return 0;
+    }
+    memcpy(&hdr, rec, sizeof(hdr));
+    hdr.crc32 = 0;
+    flashJournalCrcReset();
+    crc = flashJournalCrcCummulative((const unsigned char *) &hdr, sizeof(hdr));
+    for(pos = 0; pos < rec->length; pos += len){
+        len = rec->length - pos < sizeof(buf) ? rec->length - pos : sizeof(buf);
+        ret = cfstore_delta_read(log, offset + sizeof(*rec) + pos, buf, len);
+        if(ret < ARM_DRIVER_OK){
+            return ret;
+        }
+        crc = flashJournalCrcCummulative(buf, (int) len);
+    }
+    return crc == rec->crc32 ? 1 : 0;
+}
+
+/* @brief   check whether the bytes at offset are still erased */
+static bool cfstore_delta_is_erased(cfstore_delta_log_t *log, uint32_t offset)
+{
+    uint8_t buf[sizeof(cfstore_delta_record_t)];
+    uint8_t erased = log->erased_value ? 0xff : 0x00;
+    uint32_t i = 0;
+
+    if(offset + sizeof(buf) > log->size){
+        return true;
+    }
+    if(cfstore_delta_read(log, offset, buf, sizeof(buf)) < ARM_DRIVER_OK){
+        return false;
+    }
+    for(i = 0; i < sizeof(buf); i++){
+        if(buf[i] != erased){
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/* @brief   initialise the delta log on the storage volume mtd
+ *
+ * @param   mtd
+ *          storage volume for the log, or NULL if the delta log is not in use.
+ *
+ * @return  ARM_DRIVER_OK on success. On failure the log is left disabled, so
+ *          that every flush writes a full snapshot.
+ */
+int32_t cfstore_delta_init(cfstore_delta_log_t *log, ARM_DRIVER_STORAGE *mtd)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+    ARM_STORAGE_INFO info;
+    ARM_STORAGE_BLOCK block;
+    ARM_STORAGE_CAPABILITIES caps;
+    cfstore_delta_log_header_t hdr;
+
+    CFSTORE_FENTRYLOG("%s:entered\n", __func__);
+    memset(log, 0, sizeof(*log));
+    if(mtd == NULL){
+        return ARM_DRIVER_OK;
+    }
+    caps = mtd->GetCapabilities();
+    if(caps.asynchronous_ops){
+        CFSTORE_DBGLOG("%s:delta log requires synchronous storage operations\n", __func__);
+        return ARM_DRIVER_ERROR_UNSUPPORTED;
+    }
+    ret = mtd->GetInfo(&info);
+    if(ret < ARM_DRIVER_OK){
+        CFSTORE_ERRLOG("%s:Error: GetInfo() failed (ret=%d)\n", __func__, (int) ret);
+        return ret;
+    }
+    ret = mtd->GetNextBlock(NULL, &block);
+    if(ret < ARM_DRIVER_OK || !ARM_STORAGE_VALID_BLOCK(&block)){
+        CFSTORE_ERRLOG("%s:Error: GetNextBlock() failed (ret=%d)\n", __func__, (int) ret);
+        return ARM_DRIVER_ERROR;
+    }
+    log->program_unit = info.program_unit > 0 ? info.program_unit : 1;
+    if(CFSTORE_DELTA_STAGE_SIZE % log->program_unit != 0 || info.total_storage > UINT32_MAX || info.total_storage <= cfstore_delta_first_record(log)){
+        CFSTORE_DBGLOG("%s:delta log not supported on this volume (program_unit=%d)\n", __func__, (int) log->program_unit);
+        return ARM_DRIVER_ERROR_UNSUPPORTED;
+    }
+    log->addr = block.addr;
+    log->size = (uint32_t) info.total_storage;
+    log->erased_value = info.erased_value;
+    log->offset = cfstore_delta_first_record(log);
+    log->mtd = mtd;
+
+    ret = cfstore_delta_read(log, 0, &hdr, sizeof(hdr));
+    if(ret < ARM_DRIVER_OK){
+        log->mtd = NULL;
+        return ret;
+    }
+    if(hdr.magic == CFSTORE_DELTA_LOG_MAGIC && hdr.version == CFSTORE_DELTA_LOG_VERSION && hdr.crc32 == cfstore_delta_crc(&hdr, sizeof(hdr) - sizeof(hdr.crc32))){
+        log->formatted = true;
+        log->base_crc = hdr.base_crc;
+    }
+    CFSTORE_TP(CFSTORE_TP_INIT, "%s:delta log size=%d, formatted=%d\n", __func__, (int) log->size, (int) log->formatted);
+    return ARM_DRIVER_OK;
+}
+
+
+/* @brief   erase the log and write a new region header
+ *
+ * @param   base_crc
+ *          CRC of the base snapshot in the journal the log is to be replayed on
+ */
+int32_t cfstore_delta_reset(cfstore_delta_log_t *log, uint32_t base_crc)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+    uint32_t erased = 0;
+    cfstore_delta_log_header_t hdr;
+    cfstore_delta_seg_t seg;
+
+    CFSTORE_FENTRYLOG("%s:entered\n", __func__);
+    log->formatted = false;
+    while(erased < log->size){
+        ret = log->mtd->Erase(log->addr + erased, log->size - erased);
+        if(ret <= ARM_DRIVER_OK){
+            CFSTORE_ERRLOG("%s:Error: Erase() failed (ret=%d)\n", __func__, (int) ret);
+            return ret < ARM_DRIVER_OK ? ret : ARM_DRIVER_ERROR;
+        }
+        erased += ret;
+    }
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic = CFSTORE_DELTA_LOG_MAGIC;
+    hdr.version = CFSTORE_DELTA_LOG_VERSION;
+    hdr.base_crc = base_crc;
+    hdr.crc32 = cfstore_delta_crc(&hdr, sizeof(hdr) - sizeof(hdr.crc32));
+    seg.data = (const uint8_t *) &hdr;
+    seg.len = sizeof(hdr);
+    ret = cfstore_delta_program_segs(log, 0, &seg, 1);
+    if(ret < ARM_DRIVER_OK){
+        return ret;
+    }
+    log->offset = cfstore_delta_first_record(log);
+    log->base_crc = base_crc;
+    log->formatted = true;
+    log->needs_compaction = false;
+    return ARM_DRIVER_OK;
+}
+
+
+/* @brief   program a record whose payload is the concatenation of head and data */
+static int32_t cfstore_delta_write_record(cfstore_delta_log_t *log, uint32_t offset, uint8_t type, const void *head, uint32_t head_len, const void *data, uint32_t data_len)
+{
+    cfstore_delta_record_t rec;
+    cfstore_delta_seg_t seg[3];
+
+    memset(&rec, 0, sizeof(rec));
+    rec.magic = CFSTORE_DELTA_RECORD_MAGIC;
+    rec.type = type;
+    rec.length = head_len + data_len;
+    flashJournalCrcReset();
+    flashJournalCrcCummulative((const unsigned char *) &rec, sizeof(rec));
+    flashJournalCrcCummulative((const unsigned char *) head, (int) head_len);
+    rec.crc32 = flashJournalCrcCummulative((const unsigned char *) data, (int) data_len);
+
+    seg[0].data = (const uint8_t *) &rec;
+    seg[0].len = sizeof(rec);
+    seg[1].data = (const uint8_t *) head;
+    seg[1].len = head_len;
+    seg[2].data = (const uint8_t *) data;
+    seg[2].len = data_len;
+    return cfstore_delta_program_segs(log, offset, seg, 3);
+}
+
+
+/* @brief   append a record whose payload is the concatenation of head and data
+ *
+ * @note    the caller checks there is space with cfstore_delta_space()
+ */
+int32_t cfstore_delta_append(cfstore_delta_log_t *log, uint8_t type, const void *head, uint32_t head_len, const void *data, uint32_t data_len)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+    uint32_t size = 0;
+
+    CFSTORE_FENTRYLOG("%s:entered: type=%d, length=%d\n", __func__, (int) type, (int) (head_len + data_len));
+    size = cfstore_delta_record_size(log, head_len + data_len);
+    if(!log->formatted || log->needs_compaction || size > cfstore_delta_space(log)){
+        CFSTORE_ERRLOG("%s:Error: cannot append record (size=%d)\n", __func__, (int) size);
+        return ARM_DRIVER_ERROR_PARAMETER;
+    }
+    ret = cfstore_delta_write_record(log, log->offset, type, head, head_len, data, data_len);
+    if(ret < ARM_DRIVER_OK){
+        /* the record may be partially programmed */
+        log->needs_compaction = true;
+        return ret;
+    }
+    log->offset += size;
+    return ARM_DRIVER_OK;
+}
+
+
+/* @brief   record in a free compaction slot that the snapshot with CRC base_crc
+ *          is about to be committed to the journal. The log is closed for appends
+ *          until it is reset.
+ *
+ * @return  ARM_DRIVER_OK on success, ARM_DRIVER_ERROR if every slot has been
+ *          used by compactions which failed to commit.
+ */
+int32_t cfstore_delta_compact_begin(cfstore_delta_log_t *log, uint32_t base_crc)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+    uint32_t slot = 0;
+    uint32_t offset = 0;
+
+    CFSTORE_FENTRYLOG("%s:entered\n", __func__);
+    if(!log->formatted){
+        /* no records to be superseded */
+        return ARM_DRIVER_OK;
+    }
+    log->needs_compaction = true;
+    for(slot = 0; slot < CFSTORE_DELTA_COMPACT_SLOTS; slot++){
+        offset = cfstore_delta_first_slot(log) + slot * cfstore_delta_record_size(log, sizeof(base_crc));
+        if(cfstore_delta_is_erased(log, offset)){
+            ret = cfstore_delta_write_record(log, offset, CFSTORE_DELTA_RECORD_COMPACT, &base_crc, sizeof(base_crc), NULL, 0);
+            CFSTORE_TP(CFSTORE_TP_FLUSH, "%s:compaction slot %d (ret=%d)\n", __func__, (int) slot, (int) ret);
+            return ret;
+        }
+    }
+    CFSTORE_ERRLOG("%s:Error: no free compaction slot\n", __func__);
+    return ARM_DRIVER_ERROR;
+}
+
+
+/* @brief   replay the records of completed flushes on top of the base snapshot
+ *
+ * @param   base_crc
+ *          CRC of the base snapshot read from the journal. The records are
+ *          dropped and the log is reset if they were not appended on top of
+ *          this snapshot, or if a compaction slot shows the snapshot already
+ *          contains them.
+ */
+int32_t cfstore_delta_replay(cfstore_delta_log_t *log, uint32_t base_crc, cfstore_delta_apply_t apply, void *context)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+    uint32_t slot = 0;
+    uint32_t offset = 0;
+    uint32_t last_end = 0;
+    uint32_t crc = 0;
+    bool stale = false;
+    cfstore_delta_record_t rec;
+
+    CFSTORE_FENTRYLOG("%s:entered\n", __func__);
+    if(!log->formatted){
+        log->base_crc = base_crc;
+        return ARM_DRIVER_OK;
+    }
+    stale = log->base_crc != base_crc;
+    for(slot = 0; slot < CFSTORE_DELTA_COMPACT_SLOTS && !stale; slot++){
+        offset = cfstore_delta_first_slot(log) + slot * cfstore_delta_record_size(log, sizeof(crc));
+        ret = cfstore_delta_check_record(log, offset, &rec);
+        if(ret < ARM_DRIVER_OK){
+            return ret;
+        } else if(ret == 0){
+            if(!cfstore_delta_is_erased(log, offset)){
+                /* torn slot: a compaction was started */
+                log->needs_compaction = true;
+            }
+            continue;
+        }
+        if(rec.type == CFSTORE_DELTA_RECORD_COMPACT && rec.length == sizeof(crc)){
+            ret = cfstore_delta_read(log, offset + sizeof(rec), &crc, sizeof(crc));
+            if(ret < ARM_DRIVER_OK){
+                return ret;
+            }
+            stale = crc == base_crc;
+        }
+        /* a compaction was started but did not commit, so the records still apply */
+        log->needs_compaction = true;
+    }
+    if(stale){
+        /* a compaction committed the snapshot but did not get as far as resetting the log */
+        CFSTORE_TP(CFSTORE_TP_INIT, "%s:delta log already folded into snapshot\n", __func__);
+        return cfstore_delta_reset(log, base_crc);
+    }
+
+    /* find the end of the last completed flush */
+    offset = last_end = cfstore_delta_first_record(log);
+    while(offset + sizeof(rec) <= log->size){
+        ret = cfstore_delta_check_record(log, offset, &rec);
+        if(ret < ARM_DRIVER_OK){
+            return ret;
+        } else if(ret == 0 || rec.type == CFSTORE_DELTA_RECORD_COMPACT){
+            break;
+        }
+        offset += cfstore_delta_record_size(log, rec.length);
+        if(rec.type == CFSTORE_DELTA_RECORD_END){
+            last_end = offset;
+        }
+    }
+    log->offset = offset;
+    if(offset != last_end || !cfstore_delta_is_erased(log, offset)){
+        /* records of an interrupted flush or a torn record: appending after them would
+         * make them part of the next flush */
+        CFSTORE_TP(CFSTORE_TP_INIT, "%s:incomplete records at offset=%d\n", __func__, (int) last_end);
+        log->needs_compaction = true;
+    }
+
+    for(offset = cfstore_delta_first_record(log); offset < last_end; offset += cfstore_delta_record_size(log, rec.length)){
+        ret = cfstore_delta_read(log, offset, &rec, sizeof(rec));
+        if(ret < ARM_DRIVER_OK){
+            return ret;
+        }
+        if(rec.type == CFSTORE_DELTA_RECORD_PUT || rec.type == CFSTORE_DELTA_RECORD_DELETE){
+            ret = apply(log, rec.type, offset + sizeof(rec), rec.length, context);
+            if(ret < ARM_DRIVER_OK){
+                CFSTORE_ERRLOG("%s:Error: failed to apply record (ret=%d)\n", __func__, (int) ret);
+                return ret;
+            }
+        }
+    }
+    return ARM_DRIVER_OK;
+}
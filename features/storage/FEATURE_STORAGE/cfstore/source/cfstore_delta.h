@@ -0,0 +1,141 @@
+/*
+ * mbed Microcontroller Library
+ * Copyright (c) 2006-2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/** @file  cfstore_delta.h
+ *
+ * Append-only delta log used by configuration store to persist the KVs
+ * changed since the base snapshot held in the flash journal.
+ *
+ * The log occupies a storage volume of its own. It starts with a region
+ * header holding the CRC of the base snapshot the log applies to, followed by
+ * CFSTORE_DELTA_COMPACT_SLOTS compaction slots and then the records. Each
+ * record is a cfstore_delta_record_t and a payload padded to the program unit:
+ * - CFSTORE_DELTA_RECORD_PUT       payload is a KV as stored in area_0 (header, key name, value)
+ * - CFSTORE_DELTA_RECORD_DELETE    payload is the key name of a deleted KV
+ * - CFSTORE_DELTA_RECORD_END       marks the end of the records appended by one Flush()
+ * - CFSTORE_DELTA_RECORD_COMPACT   only found in a compaction slot. The payload is the CRC
+ *                                  of the snapshot a compaction is committing to the journal
+ *
+ * Records are only replayed up to the last END record, so a Flush() interrupted
+ * by a power failure leaves the previous state. A compaction slot matching the
+ * base snapshot means the snapshot already holds every record in the log.
+ */
+
+#ifndef __CFSTORE_DELTA_H_
+#define __CFSTORE_DELTA_H_
+
+#include <Driver_Storage.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CFSTORE_DELTA_RECORD_PUT            1
+#define CFSTORE_DELTA_RECORD_DELETE         2
+#define CFSTORE_DELTA_RECORD_END            3
+#define CFSTORE_DELTA_RECORD_COMPACT        4
+
+/* size of the buffer used to stage data for ProgramData(). The program unit
+ * of the volume must divide it for the delta log to be used */
+#define CFSTORE_DELTA_STAGE_SIZE            64
+
+/* number of compactions which may fail to commit before the log is reset */
+#define CFSTORE_DELTA_COMPACT_SLOTS         4
+
+/* @brief   record header, followed by the payload padded to the program unit
+ *
+ * @param   magic
+ *          CFSTORE_DELTA_RECORD_MAGIC. Erased storage ends the log.
+ * @param   type
+ *          CFSTORE_DELTA_RECORD_xxx
+ * @param   length
+ *          payload length excluding the padding
+ * @param   crc32
+ *          CRC of the record header (with crc32 = 0) and the payload. It is
+ *          last so that a partially programmed header is never valid.
+ */
+typedef struct cfstore_delta_record_t
+{
+    uint32_t magic;
+    uint8_t type;
+    uint8_t reserved[3];
+    uint32_t length;
+    uint32_t crc32;
+} cfstore_delta_record_t;
+
+/* @brief   delta log state
+ *
+ * @param   mtd
+ *          storage volume holding the log, NULL when the log is not in use
+ * @param   addr
+ *          address of the start of the volume
+ * @param   size
+ *          size of the volume in bytes
+ * @param   offset
+ *          offset of the next record to be appended
+ * @param   base_crc
+ *          CRC of the base snapshot the records apply to
+ * @param   formatted
+ *          the region header is valid, so records can be appended
+ * @param   needs_compaction
+ *          the log must not be appended to, e.g. it ends with a torn
+ *          record or records of an interrupted Flush(), or a compaction
+ *          has been started
+ * @param   erased_value
+ *          ARM_STORAGE_INFO::erased_value of the volume
+ */
+typedef struct cfstore_delta_log_t
+{
+    ARM_DRIVER_STORAGE *mtd;
+    uint64_t addr;
+    uint32_t size;
+    uint32_t program_unit;
+    uint32_t offset;
+    uint32_t base_crc;
+    uint32_t formatted : 1;
+    uint32_t needs_compaction : 1;
+    uint32_t erased_value : 1;
+    uint32_t reserved : 29;
+} cfstore_delta_log_t;
+
+/* @brief   replay callback, invoked for each PUT and DELETE record of a completed Flush().
+ *          The payload is read with cfstore_delta_read().
+ */
+typedef int32_t (*cfstore_delta_apply_t)(cfstore_delta_log_t *log, uint8_t type, uint32_t offset, uint32_t length, void *context);
+
+int32_t cfstore_delta_init(cfstore_delta_log_t *log, ARM_DRIVER_STORAGE *mtd);
+int32_t cfstore_delta_reset(cfstore_delta_log_t *log, uint32_t base_crc);
+int32_t cfstore_delta_append(cfstore_delta_log_t *log, uint8_t type, const void *head, uint32_t head_len, const void *data, uint32_t data_len);
+int32_t cfstore_delta_compact_begin(cfstore_delta_log_t *log, uint32_t base_crc);
+int32_t cfstore_delta_read(cfstore_delta_log_t *log, uint32_t offset, void *data, uint32_t size);
+int32_t cfstore_delta_replay(cfstore_delta_log_t *log, uint32_t base_crc, cfstore_delta_apply_t apply, void *context);
+uint32_t cfstore_delta_record_size(cfstore_delta_log_t *log, uint32_t length);
+uint32_t cfstore_delta_space(cfstore_delta_log_t *log);
+uint32_t cfstore_delta_crc(const void *data, uint32_t size);
+
+static inline bool cfstore_delta_is_enabled(cfstore_delta_log_t *log)
+{
+    return log->mtd != NULL;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*__CFSTORE_DELTA_H_ */
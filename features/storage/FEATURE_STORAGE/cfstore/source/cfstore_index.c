@@ -0,0 +1,478 @@
+/*
+ * mbed Microcontroller Library
+ * Copyright (c) 2006-2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/** @file  cfstore_index.c
+ *
+ * Index of the KVs in the configuration store area. See cfstore_index.h.
+ *
+ * The index only ever narrows the set of KVs a query has to examine: callers
+ * still apply the delete flag, access control and cfstore_fnmatch() checks to
+ * each candidate. If memory for the index cannot be allocated the index is
+ * marked invalid and callers walk the area instead.
+ */
+
+#include "cfstore_config.h"
+#include "cfstore_debug.h"
+#include "cfstore_index.h"
+#include "configuration_store.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef CFSTORE_YOTTA_CFG_CFSTORE_SRAM_ADDR
+#define CFSTORE_INDEX_REALLOC(ptr, size)    realloc((ptr), (size))
+#define CFSTORE_INDEX_FREE(ptr)             free((ptr))
+#else
+/* KVs are stored in a client provided memory slab so there is no heap for
+ * the index, which then remains invalid */
+#define CFSTORE_INDEX_REALLOC(ptr, size)    NULL
+#define CFSTORE_INDEX_FREE(ptr)             do { } while(0)
+#endif
+
+#define CFSTORE_INDEX_HASH_SIZE_MIN         16
+#define CFSTORE_INDEX_HASH_EMPTY            0
+
+
+/* FNV-1a hash of a key name */
+static uint32_t cfstore_index_hash(const char *key, uint8_t len)
+{
+    uint32_t hash = 2166136261UL;
+
+    while(len--){
+        hash ^= (uint8_t) *key++;
+        hash *= 16777619UL;
+    }
+    return hash;
+}
+
+/* compare key names as strcmp() would if they were NUL terminated */
+static int32_t cfstore_index_key_cmp(const char *key1, uint8_t len1, const char *key2, uint8_t len2)
+{
+    int32_t ret = memcmp(key1, key2, len1 < len2 ? len1 : len2);
+
+    if(ret == 0){
+        ret = (int32_t) len1 - (int32_t) len2;
+    }
+    return ret;
+}
+
+/* order KVs by key name, then by offset as a KV being deleted may share its
+ * name with a newly created KV */
+static int32_t cfstore_index_cmp(cfstore_index_t *index, uint32_t offset1, uint32_t offset2)
+{
+    uint8_t len1 = 0;
+    uint8_t len2 = 0;
+    const char *key1 = index->key(offset1, &len1);
+    const char *key2 = index->key(offset2, &len2);
+    int32_t ret = cfstore_index_key_cmp(key1, len1, key2, len2);
+
+    if(ret == 0){
+        ret = offset1 < offset2 ? -1 : (offset1 > offset2 ? 1 : 0);
+    }
+    return ret;
+}
+
+/* @brief   index of the first entry in sorted not ordered before offset */
+static uint32_t cfstore_index_sorted_lower_bound(cfstore_index_t *index, uint32_t offset)
+{
+    uint32_t lo = 0;
+    uint32_t hi = index->count;
+    uint32_t mid;
+
+    while(lo < hi){
+        mid = lo + (hi - lo) / 2;
+        if(cfstore_index_cmp(index, index->sorted[mid], offset) < 0){
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/* @brief   index of the first entry in sorted with a key name not ordered before prefix */
+static uint32_t cfstore_index_sorted_lower_bound_key(cfstore_index_t *index, const char *prefix, uint8_t prefix_len)
+{
+    uint32_t lo = 0;
+    uint32_t hi = index->count;
+    uint32_t mid;
+    uint8_t len = 0;
+    const char *key;
+
+    while(lo < hi){
+        mid = lo + (hi - lo) / 2;
+        key = index->key(index->sorted[mid], &len);
+        if(cfstore_index_key_cmp(key, len, prefix, prefix_len) < 0){
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static void cfstore_index_hash_add(cfstore_index_t *index, uint32_t offset)
+{
+    uint8_t len = 0;
+    const char *key = index->key(offset, &len);
+    uint32_t mask = index->hash_size - 1;
+    uint32_t pos = cfstore_index_hash(key, len) & mask;
+
+    while(index->hash[pos] != CFSTORE_INDEX_HASH_EMPTY){
+        pos = (pos + 1) & mask;
+    }
+    index->hash[pos] = offset + 1;
+}
+
+/* @brief   (re)build the hash table with hash_size slots from the sorted entries */
+static int32_t cfstore_index_hash_resize(cfstore_index_t *index, uint32_t hash_size)
+{
+    uint32_t i;
+    uint32_t *hash = NULL;
+
+    hash = (uint32_t*) CFSTORE_INDEX_REALLOC(index->hash, hash_size * sizeof(uint32_t));
+    if(hash == NULL){
+        CFSTORE_ERRLOG("%s:Error: failed to allocate index hash table (hash_size=%d).\n", __func__, (int) hash_size);
+        return ARM_CFSTORE_DRIVER_ERROR_OUT_OF_MEMORY;
+    }
+    index->hash = hash;
+    index->hash_size = hash_size;
+    memset(index->hash, 0, hash_size * sizeof(uint32_t));
+    for(i = 0; i < index->count; i++){
+        cfstore_index_hash_add(index, index->sorted[i]);
+    }
+    return ARM_DRIVER_OK;
+}
+
+static void cfstore_index_free(cfstore_index_t *index)
+{
+    if(index->sorted){
+        CFSTORE_INDEX_FREE(index->sorted);
+    }
+    if(index->hash){
+        CFSTORE_INDEX_FREE(index->hash);
+    }
+    index->sorted = NULL;
+    index->hash = NULL;
+    index->count = 0;
+    index->sorted_size = 0;
+    index->hash_size = 0;
+}
+
+/* @brief   make space for another entry in sorted, invalidating the index on failure */
+static int32_t cfstore_index_grow(cfstore_index_t *index)
+{
+    uint32_t size;
+    uint32_t *sorted = NULL;
+
+    if(index->count < index->sorted_size){
+        return ARM_DRIVER_OK;
+    }
+    size = index->sorted_size ? index->sorted_size * 2 : CFSTORE_INDEX_HASH_SIZE_MIN / 2;
+    sorted = (uint32_t*) CFSTORE_INDEX_REALLOC(index->sorted, size * sizeof(uint32_t));
+    if(sorted == NULL){
+        CFSTORE_ERRLOG("%s:Error: failed to allocate index (size=%d).\n", __func__, (int) size);
+        /* callers fall back to walking the area */
+        cfstore_index_free(index);
+        index->valid = false;
+        return ARM_CFSTORE_DRIVER_ERROR_OUT_OF_MEMORY;
+    }
+    index->sorted = sorted;
+    index->sorted_size = size;
+    return ARM_DRIVER_OK;
+}
+
+/* @brief   initialise an empty (and therefore valid) index
+ *
+ * @param   key
+ *          callback returning the key name of the KV at a given offset
+ */
+void cfstore_index_init(cfstore_index_t *index, cfstore_index_key_t key)
+{
+    memset(index, 0, sizeof(cfstore_index_t));
+    index->key = key;
+    index->valid = true;
+}
+
+void cfstore_index_deinit(cfstore_index_t *index)
+{
+    cfstore_index_free(index);
+    index->valid = false;
+}
+
+/* @brief   empty the index and mark it valid, e.g. before the KVs
+ *          read from storage are inserted */
+void cfstore_index_clear(cfstore_index_t *index)
+{
+    index->count = 0;
+    if(index->hash){
+        memset(index->hash, 0, index->hash_size * sizeof(uint32_t));
+    }
+    index->valid = true;
+}
+
+/* @brief   add the KV at offset to the index. The KV header and key name must
+ *          already be present in the area.
+ *
+ * @return  ARM_DRIVER_OK, or ARM_CFSTORE_DRIVER_ERROR_OUT_OF_MEMORY in which case
+ *          the index has been invalidated.
+ */
+int32_t cfstore_index_insert(cfstore_index_t *index, uint32_t offset)
+{
+    int32_t ret = ARM_DRIVER_OK;
+    uint32_t pos;
+    uint32_t size;
+
+    if(!index->valid){
+        return ARM_DRIVER_OK;
+    }
+    ret = cfstore_index_grow(index);
+    if(ret < ARM_DRIVER_OK){
+        return ret;
+    }
+    pos = cfstore_index_sorted_lower_bound(index, offset);
+    memmove(&index->sorted[pos+1], &index->sorted[pos], (index->count - pos) * sizeof(uint32_t));
+    index->sorted[pos] = offset;
+    index->count++;
+
+    /* keep the hash table at most half full so probe sequences stay short */
+    if(index->count * 2 > index->hash_size){
+        size = index->hash_size ? index->hash_size * 2 : CFSTORE_INDEX_HASH_SIZE_MIN;
+        ret = cfstore_index_hash_resize(index, size);
+        if(ret < ARM_DRIVER_OK){
+            /* callers fall back to walking the area */
+            cfstore_index_free(index);
+            index->valid = false;
+            return ret;
+        }
+    } else {
+        cfstore_index_hash_add(index, offset);
+    }
+    return ARM_DRIVER_OK;
+}
+
+/* @brief   add the KV at offset to the end of the sorted entries without
+ *          ordering it, when building the index for many KVs at once.
+ *          cfstore_index_sort() must be called once all the KVs have been
+ *          appended.
+ *
+ * @return  ARM_DRIVER_OK, or ARM_CFSTORE_DRIVER_ERROR_OUT_OF_MEMORY in which case
+ *          the index has been invalidated.
+ */
+int32_t cfstore_index_append(cfstore_index_t *index, uint32_t offset)
+{
+    int32_t ret = ARM_DRIVER_OK;
+
+    if(!index->valid){
+        return ARM_DRIVER_OK;
+    }
+    ret = cfstore_index_grow(index);
+    if(ret < ARM_DRIVER_OK){
+        return ret;
+    }
+    index->sorted[index->count++] = offset;
+    return ARM_DRIVER_OK;
+}
+
+/* @brief   restore the heap property of sorted[root..count) */
+static void cfstore_index_sift_down(cfstore_index_t *index, uint32_t root, uint32_t count)
+{
+    uint32_t child;
+    uint32_t tmp;
+
+    while((child = 2 * root + 1) < count){
+        if(child + 1 < count && cfstore_index_cmp(index, index->sorted[child], index->sorted[child+1]) < 0){
+            child++;
+        }
+        if(cfstore_index_cmp(index, index->sorted[root], index->sorted[child]) >= 0){
+            return;
+        }
+        tmp = index->sorted[root];
+        index->sorted[root] = index->sorted[child];
+        index->sorted[child] = tmp;
+        root = child;
+    }
+}
+
+/* @brief   order the entries added with cfstore_index_append() and build
+ *          the hash table. Heapsort is used as it needs no extra memory.
+ *
+ * @return  ARM_DRIVER_OK, or ARM_CFSTORE_DRIVER_ERROR_OUT_OF_MEMORY in which case
+ *          the index has been invalidated.
+ */
+int32_t cfstore_index_sort(cfstore_index_t *index)
+{
+    int32_t ret = ARM_DRIVER_OK;
+    uint32_t i;
+    uint32_t tmp;
+    uint32_t hash_size = CFSTORE_INDEX_HASH_SIZE_MIN;
+
+    if(!index->valid){
+        return ARM_DRIVER_OK;
+    }
+    for(i = index->count / 2; i > 0; i--){
+        cfstore_index_sift_down(index, i - 1, index->count);
+    }
+    for(i = index->count; i > 1; i--){
+        tmp = index->sorted[0];
+        index->sorted[0] = index->sorted[i-1];
+        index->sorted[i-1] = tmp;
+        cfstore_index_sift_down(index, 0, i - 1);
+    }
+    while(index->count * 2 > hash_size){
+        hash_size *= 2;
+    }
+    ret = cfstore_index_hash_resize(index, hash_size);
+    if(ret < ARM_DRIVER_OK){
+        cfstore_index_free(index);
+        index->valid = false;
+    }
+    return ret;
+}
+
+/* @brief   remove the KV at offset from the index. The KV must still be present in the area. */
+void cfstore_index_remove(cfstore_index_t *index, uint32_t offset)
+{
+    uint8_t len = 0;
+    const char *key = NULL;
+    uint32_t pos;
+    uint32_t next;
+    uint32_t home;
+    uint32_t mask;
+
+    if(!index->valid || index->count == 0){
+        return;
+    }
+    pos = cfstore_index_sorted_lower_bound(index, offset);
+    if(pos >= index->count || index->sorted[pos] != offset){
+        CFSTORE_ERRLOG("%s:Error: KV not found in index (offset=%d).\n", __func__, (int) offset);
+        return;
+    }
+    memmove(&index->sorted[pos], &index->sorted[pos+1], (index->count - pos - 1) * sizeof(uint32_t));
+    index->count--;
+
+    mask = index->hash_size - 1;
+    key = index->key(offset, &len);
+    pos = cfstore_index_hash(key, len) & mask;
+    while(index->hash[pos] != offset + 1){
+        if(index->hash[pos] == CFSTORE_INDEX_HASH_EMPTY){
+            return;
+        }
+        pos = (pos + 1) & mask;
+    }
+    /* backward shift deletion: move up entries of the probe sequence which
+     * would otherwise no longer be reachable from their home slot */
+    next = (pos + 1) & mask;
+    while(index->hash[next] != CFSTORE_INDEX_HASH_EMPTY){
+        key = index->key(index->hash[next] - 1, &len);
+        home = cfstore_index_hash(key, len) & mask;
+        if(((next - home) & mask) >= ((next - pos) & mask)){
+            index->hash[pos] = index->hash[next];
+            pos = next;
+        }
+        next = (next + 1) & mask;
+    }
+    index->hash[pos] = CFSTORE_INDEX_HASH_EMPTY;
+}
+
+/* @brief   update the offsets of the KVs following offset after size_diff bytes
+ *          have been inserted (size_diff > 0) or removed (size_diff < 0) from the
+ *          area at offset. The order of the entries is unchanged.
+ */
+void cfstore_index_shift(cfstore_index_t *index, uint32_t offset, int32_t size_diff)
+{
+    uint32_t i;
+
+    if(!index->valid){
+        return;
+    }
+    for(i = 0; i < index->count; i++){
+        if(index->sorted[i] > offset){
+            index->sorted[i] += size_diff;
+        }
+    }
+    for(i = 0; i < index->hash_size; i++){
+        if(index->hash[i] > offset + 1){
+            index->hash[i] += size_diff;
+        }
+    }
+}
+
+/* @brief   start iterating over the KVs which may match query
+ *
+ * @return  false if the index cannot narrow down the query, e.g. it starts
+ *          with a wildcard, in which case the whole area must be walked.
+ */
+bool cfstore_index_iter_init(cfstore_index_t *index, cfstore_index_iter_t *iter, const char *query)
+{
+    size_t len;
+
+    if(!index->valid){
+        return false;
+    }
+    len = strcspn(query, "*?[\\");
+    if(len == 0 || len > UINT8_MAX){
+        return false;
+    }
+    iter->query = query;
+    iter->len = (uint8_t) len;
+    iter->exact = query[len] == '\0';
+    if(iter->exact){
+        iter->pos = index->hash_size ? cfstore_index_hash(query, iter->len) & (index->hash_size - 1) : 0;
+    } else {
+        iter->pos = cfstore_index_sorted_lower_bound_key(index, query, iter->len);
+    }
+    return true;
+}
+
+/* @brief   get the offset of the next KV which may match the query
+ *
+ * @return  false when there are no more candidates
+ */
+bool cfstore_index_iter_next(cfstore_index_t *index, cfstore_index_iter_t *iter, uint32_t *offset)
+{
+    uint8_t len = 0;
+    const char *key = NULL;
+
+    if(iter->exact){
+        if(index->hash_size == 0){
+            return false;
+        }
+        while(index->hash[iter->pos] != CFSTORE_INDEX_HASH_EMPTY){
+            *offset = index->hash[iter->pos] - 1;
+            iter->pos = (iter->pos + 1) & (index->hash_size - 1);
+            key = index->key(*offset, &len);
+            if(cfstore_index_key_cmp(key, len, iter->query, iter->len) == 0){
+                return true;
+            }
+        }
+        return false;
+    }
+    /* entries sharing the literal prefix of the query are contiguous in sorted */
+    if(iter->pos >= index->count){
+        return false;
+    }
+    *offset = index->sorted[iter->pos];
+    key = index->key(*offset, &len);
+    if(len < iter->len || memcmp(key, iter->query, iter->len) != 0){
+        iter->pos = index->count;
+        return false;
+    }
+    iter->pos++;
+    return true;
+}
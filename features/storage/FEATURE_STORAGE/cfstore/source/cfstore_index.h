@@ -0,0 +1,101 @@
+/*
+ * mbed Microcontroller Library
+ * Copyright (c) 2006-2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/** @file  cfstore_index.h
+ *
+ * Index of the KVs in the configuration store area, used to find KVs without
+ * walking the whole area.
+ *
+ * KVs are identified by their offset from the start of the area, so the index
+ * is unaffected by realloc() moving the area. It holds:
+ * - a hash table of the key names, used for queries without wildcards.
+ * - the KVs sorted by key name, used for queries starting with a literal
+ *   prefix (e.g. "com.arm.mbed.*"), which only need to examine the KVs
+ *   sharing the prefix.
+ */
+
+#ifndef __CFSTORE_INDEX_H_
+#define __CFSTORE_INDEX_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* @brief   callback returning the key name (not NUL terminated) and its length of the KV at offset */
+typedef const char* (*cfstore_index_key_t)(uint32_t offset, uint8_t *len);
+
+/* @brief   KV index
+ *
+ * @param   sorted
+ *          offsets of the KVs sorted by key name
+ * @param   hash
+ *          open addressing hash table of KV offsets + 1, 0 indicating an empty slot
+ * @param   count
+ *          number of KVs in the index
+ * @param   sorted_size
+ *          number of entries allocated for sorted
+ * @param   hash_size
+ *          number of slots in hash, a power of 2
+ * @param   valid
+ *          the index reflects the area. If not, queries fall back to walking the area.
+ */
+typedef struct cfstore_index_t
+{
+    uint32_t *sorted;
+    uint32_t *hash;
+    uint32_t count;
+    uint32_t sorted_size;
+    uint32_t hash_size;
+    cfstore_index_key_t key;
+    bool valid;
+} cfstore_index_t;
+
+/* @brief   cursor over the KVs which may match a query
+ *
+ * @param   exact
+ *          the query has no wildcards so only KVs with the same name are returned
+ * @param   pos
+ *          next hash slot or sorted index to examine
+ */
+typedef struct cfstore_index_iter_t
+{
+    const char *query;
+    uint8_t len;
+    bool exact;
+    uint32_t pos;
+} cfstore_index_iter_t;
+
+void cfstore_index_init(cfstore_index_t *index, cfstore_index_key_t key);
+void cfstore_index_deinit(cfstore_index_t *index);
+void cfstore_index_clear(cfstore_index_t *index);
+int32_t cfstore_index_insert(cfstore_index_t *index, uint32_t offset);
+int32_t cfstore_index_append(cfstore_index_t *index, uint32_t offset);
+int32_t cfstore_index_sort(cfstore_index_t *index);
+void cfstore_index_remove(cfstore_index_t *index, uint32_t offset);
+void cfstore_index_shift(cfstore_index_t *index, uint32_t offset, int32_t size_diff);
+bool cfstore_index_iter_init(cfstore_index_t *index, cfstore_index_iter_t *iter, const char *query);
+bool cfstore_index_iter_next(cfstore_index_t *index, cfstore_index_iter_t *iter, uint32_t *offset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*__CFSTORE_INDEX_H_ */
@@ -29,8 +29,11 @@
  * so it can be called by the C-HAL implementation configuration_store.c
  */
 
+/* the delta log volume, if any, is carved from the end of the cfstore region */
 #define CFSTORE_SVM_VOL_01_START_OFFSET       0x80000UL
-#define CFSTORE_SVM_VOL_01_SIZE               0x80000UL
+#define CFSTORE_SVM_VOL_01_SIZE               (0x80000UL - CFSTORE_DELTA_LOG_SIZE)
+#define CFSTORE_SVM_VOL_02_START_OFFSET       (CFSTORE_SVM_VOL_01_START_OFFSET + CFSTORE_SVM_VOL_01_SIZE)
+#define CFSTORE_SVM_VOL_02_SIZE               CFSTORE_DELTA_LOG_SIZE
 
 #ifdef CFSTORE_CONFIG_BACKEND_FLASH_ENABLED
 extern ARM_DRIVER_STORAGE ARM_Driver_Storage_MTD_K64F;
@@ -52,7 +55,7 @@ static void cfstore_svm_journal_mtc_callback(int32_t status, ARM_STORAGE_OPERATI
     CFSTORE_FENTRYLOG("%s: operation %d with status %d" , __func__, (int) operation, (int) status);
 }
 
-int32_t cfstore_svm_init(struct _ARM_DRIVER_STORAGE *storage_mtd)
+int32_t cfstore_svm_init(struct _ARM_DRIVER_STORAGE *storage_mtd, struct _ARM_DRIVER_STORAGE *delta_mtd)
 {
     int32_t ret = ARM_DRIVER_OK;
 
@@ -72,5 +75,17 @@ int32_t cfstore_svm_init(struct _ARM_DRIVER_STORAGE *storage_mtd)
         CFSTORE_ERRLOG("%s:debug: storage_mtd->initialize() failed for storage_mtd=%p (ret=%d)", __func__, storage_mtd, (int) ret);
         return ret;
     }
+    if(CFSTORE_SVM_VOL_02_SIZE > 0) {
+        ret = volumeManager.addVolume_C(CFSTORE_SVM_VOL_02_START_OFFSET, CFSTORE_SVM_VOL_02_SIZE, delta_mtd);
+        if(ret < ARM_DRIVER_OK) {
+            CFSTORE_ERRLOG("%s:debug: volume-manager::addVolume_C() failed for delta_mtd=%p (ret=%d)", __func__, delta_mtd, (int) ret);
+            return ret;
+        }
+        ret = delta_mtd->Initialize(cfstore_svm_journal_mtc_callback);
+        if(ret < ARM_DRIVER_OK) {
+            CFSTORE_ERRLOG("%s:debug: delta_mtd->initialize() failed for delta_mtd=%p (ret=%d)", __func__, delta_mtd, (int) ret);
+            return ret;
+        }
+    }
     return ret;
 }
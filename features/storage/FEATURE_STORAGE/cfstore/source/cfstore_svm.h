@@ -31,7 +31,7 @@ extern "C" {
 #endif
 
 
-int32_t cfstore_svm_init(struct _ARM_DRIVER_STORAGE *mtd);
+int32_t cfstore_svm_init(struct _ARM_DRIVER_STORAGE *mtd, struct _ARM_DRIVER_STORAGE *delta_mtd);
 
 
 #ifdef __cplusplus
@@ -20,6 +20,7 @@
 #include "cfstore_debug.h"
 #include "cfstore_list.h"
 #include "cfstore_fnmatch.h"
+#include "cfstore_index.h"
 #include "configuration_store.h"
 
 #if defined CFSTORE_CONFIG_MBED_OS_VERSION && CFSTORE_CONFIG_MBED_OS_VERSION == 3
@@ -32,6 +33,7 @@
 
 #ifdef CFSTORE_CONFIG_BACKEND_FLASH_ENABLED
 #include "cfstore_svm.h"
+#include "cfstore_delta.h"
 #include "flash_journal_strategy_sequential.h"
 #include "flash_journal.h"
 #include "Driver_Common.h"
@@ -62,6 +64,7 @@ ARM_DRIVER_STORAGE *cfstore_storage_drv = &ARM_Driver_Storage_MTD_K64F;
 #endif /* CFSTORE_CONFIG_BACKEND_FLASH_ENABLED */
 
 struct _ARM_DRIVER_STORAGE cfstore_journal_mtd;
+struct _ARM_DRIVER_STORAGE cfstore_delta_mtd;
 
 /*
  * Defines
@@ -79,6 +82,15 @@ struct _ARM_DRIVER_STORAGE cfstore_journal_mtd;
  *
  * ARM_DRIVER_OK_DONE
  *   value that indicates an operation has been done i.e. a value > 0
+ *
+ * CFSTORE_DELTA_DELETED_SIZE
+ *  size of the buffer recording the names of KVs deleted since the last flush, so
+ *  that DELETE records can be appended to the delta log. If the buffer overflows
+ *  the next flush writes a full snapshot instead
+ *
+ * CFSTORE_AREA_SIZE_MIN
+ *  minimum size of the memory allocated for the area, so that creating the first few
+ *  small KVs does not realloc() the area each time
  */
 #define CFSTORE_KEY_NAME_CHARS_ACCEPTABLE           "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ{}.-_@"
 #define CFSTORE_KEY_NAME_QUERY_CHARS_ACCEPTABLE     CFSTORE_KEY_NAME_CHARS_ACCEPTABLE"*"
@@ -92,6 +104,8 @@ struct _ARM_DRIVER_STORAGE cfstore_journal_mtd;
 #define CFSTORE_SENTINEL                            0x7fffffff
 #define CFSTORE_CALLBACK_RET_CODE_DEFAULT           0x1
 #define ARM_DRIVER_OK_DONE                          1
+#define CFSTORE_DELTA_DELETED_SIZE                  256
+#define CFSTORE_AREA_SIZE_MIN                       64
 
 /*
  * Simple Types
@@ -131,6 +145,9 @@ struct _ARM_DRIVER_STORAGE cfstore_journal_mtd;
  *
  * @param   delete
  *          indicates this KV is being deleted
+ *
+ * @param   dirty
+ *          indicates this KV has changed since the last flush
  */
 typedef struct cfstore_area_header_t
 {
@@ -146,7 +163,8 @@ typedef struct cfstore_area_header_t
     uint8_t refcount;
     struct flags_t {
         uint8_t delete : 1;
-        uint8_t reserved : 7;
+        uint8_t dirty : 1;
+        uint8_t reserved : 6;
     } flags ;
 } cfstore_area_header_t;
 
@@ -254,6 +272,7 @@ static int32_t cfstore_fsm_state_handle_event(cfstore_fsm_t* fsm, cfstore_fsm_ev
 static int32_t cfstore_fsm_state_set(cfstore_fsm_t* fsm, cfstore_fsm_state_t new_state, void* ctx);
 #endif  /* CFSTORE_CONFIG_BACKEND_FLASH_ENABLED */
 static int32_t cfstore_get_key_name_ex(cfstore_area_hkvt_t *hkvt, char* key_name, uint8_t *key_name_len);
+static int32_t cfstore_delete_ex(cfstore_area_hkvt_t* hkvt);
 
 
 /* Walking Area HKVT's While Inserting   a New HKVT:
@@ -346,8 +365,11 @@ static int32_t cfstore_get_key_name_ex(cfstore_area_hkvt_t *hkvt, char* key_name
  *          - accessed in app & intr context; hence needs CS protection.
  *
  * @param   area_0_len
- *          length of the area used for storing KVs, including padding to
- *          round to nearest program unit
+ *          size of the memory allocated for the area, a multiple of the
+ *          program unit. It may exceed the size of the KVs so that creating
+ *          KVs doesn't realloc() the area every time. The memory following
+ *          area_0_tail is kept zeroed, as it is the padding when the area is
+ *          written to flash.
  *
  * @param   rw_area0_lock
  *          lock used to make CS re-entrant e.g. only 1 flush operation can be
@@ -356,6 +378,23 @@ static int32_t cfstore_get_key_name_ex(cfstore_area_hkvt_t *hkvt, char* key_name
  *          - cfstore_ctx_g.area_0_head/cfstore_ctx_g.area_0_tail. Realloc()
  *            in Delete() and Create() can cause these pointers to change.
  *
+ * @param   index
+ *          index of the KVs in area_0 by key name, used by cfstore_find_ex()
+ *          to avoid walking the whole area. Entries are offsets from
+ *          area_0_head so they survive realloc() moving the area.
+ *
+ * @param   batch_ref_count
+ *          number of BeginBatch() calls not yet matched by EndBatch(). While
+ *          a batch is open, KVs being deleted are left in the area marked
+ *          deleted and are removed by a single compaction when the batch ends.
+ *
+ * @param   batch_reserve
+ *          size hint supplied to BeginBatch(), used to size the area when it
+ *          next grows.
+ *
+ * @param   batch_deleted_size
+ *          size of the KVs deleted in the open batch, still in the area.
+ *
  * @param   client_notify_data
  *          fsm handler functions set a flag for a client notification call
  *          to be made after fsm handler functions have been completed. This
@@ -365,6 +404,26 @@ static int32_t cfstore_get_key_name_ex(cfstore_area_hkvt_t *hkvt, char* key_name
  *          flag indicating that the area has been written and therefore is
  *          dirty with respect to the data persisted to flash.
  *
+ * @param   delta
+ *          delta log persisting the KVs changed by a flush without rewriting
+ *          the whole area to the journal. The journal holds the base snapshot
+ *          written by the last compaction.
+ *
+ * @param   delta_deleted
+ *          names of the KVs deleted since the last flush, each stored as the
+ *          name length followed by the name.
+ *
+ * @param   delta_deleted_overflow
+ *          flag indicating delta_deleted was too small, so the next flush
+ *          must write a full snapshot.
+ *
+ * @param   delta_compact_crc
+ *          CRC of the full snapshot being written by a compaction.
+ *
+ * @param   delta_compacting
+ *          flag indicating the flush in progress is writing a full snapshot
+ *          and resets the delta log when it has been committed.
+ *
  * @expected_blob_size  expected_blob_size = area_0_tail - area_0_head + pad
  *          In the case of reading from flash into sram, this will be be size
  *          of the flash blob (rounded to a multiple program_unit if not
@@ -385,6 +444,10 @@ typedef struct cfstore_ctx_t
     size_t area_0_len;
     cfstore_fsm_t fsm;
     int32_t status;
+    cfstore_index_t index;
+    int32_t batch_ref_count;
+    ARM_CFSTORE_SIZE batch_reserve;
+    ARM_CFSTORE_SIZE batch_deleted_size;
 
     /* client notification data */
     void* client_context;
@@ -402,6 +465,15 @@ typedef struct cfstore_ctx_t
     FlashJournal_Info_t info;
     FlashJournal_OpCode_t cmd_code;
     uint64_t expected_blob_size;
+
+    /* delta log related data */
+    cfstore_delta_log_t delta;
+    uint8_t delta_deleted[CFSTORE_DELTA_DELETED_SIZE];
+    uint32_t delta_deleted_len;
+    uint32_t delta_compact_crc;
+    uint32_t delta_deleted_overflow : 1;
+    uint32_t delta_compacting : 1;
+    uint32_t delta_reserved : 30;
 #endif /* CFSTORE_CONFIG_BACKEND_FLASH_ENABLED */
 } cfstore_ctx_t;
 
@@ -1169,6 +1241,17 @@ static CFSTORE_INLINE void cfstore_hkvt_set_flags_delete(cfstore_area_hkvt_t *hk
     ((cfstore_area_header_t*) hkvt->head)->flags.delete = flag;
 }
 
+static CFSTORE_INLINE bool cfstore_hkvt_get_flags_dirty(cfstore_area_hkvt_t *hkvt)
+{
+    return ((cfstore_area_header_t*) hkvt->head)->flags.dirty;
+}
+
+static CFSTORE_INLINE void cfstore_hkvt_set_flags_dirty(cfstore_area_hkvt_t *hkvt, bool flag)
+{
+    CFSTORE_ASSERT(hkvt != NULL);
+    ((cfstore_area_header_t*) hkvt->head)->flags.dirty = flag;
+}
+
 
 /*
  * struct cfstore_area_hkvt_t helper operations
@@ -1306,6 +1389,43 @@ static int32_t cfstore_get_next_hkvt(cfstore_area_hkvt_t* prev, cfstore_area_hkv
 }
 
 
+/*
+ * KV index support functions
+ */
+
+/* @brief   cfstore_index_key_t callback returning the key name of the KV at offset in the area */
+static const char* cfstore_index_key(uint32_t offset, uint8_t* len)
+{
+    cfstore_ctx_t* ctx = cfstore_ctx_get();
+
+    *len = ((cfstore_area_header_t*) (ctx->area_0_head + offset))->klength;
+    return (const char*) ctx->area_0_head + offset + sizeof(cfstore_area_header_t);
+}
+
+
+/* @brief   rebuild the index from the KVs in the area e.g. after the area
+ *          has been read from flash or compacted */
+static void cfstore_index_rebuild(cfstore_ctx_t* ctx)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+    cfstore_area_hkvt_t hkvt;
+
+    CFSTORE_FENTRYLOG("%s:entered\n", __func__);
+    cfstore_index_clear(&ctx->index);
+    ret = cfstore_get_head_hkvt(&hkvt);
+    while(ret == ARM_DRIVER_OK && cfstore_hkvt_is_valid(&hkvt, ctx->area_0_tail))
+    {
+        ret = cfstore_index_append(&ctx->index, hkvt.head - ctx->area_0_head);
+        if(ret < ARM_DRIVER_OK){
+            /* index has been invalidated so queries walk the area */
+            return;
+        }
+        ret = cfstore_get_next_hkvt(&hkvt, &hkvt);
+    }
+    cfstore_index_sort(&ctx->index);
+}
+
+
 /*
  * Flash support functions
  */
@@ -1380,6 +1500,45 @@ static int32_t cfstore_flash_set_tail(void)
 }
 
 
+/* @brief   compute the memory to allocate for an area holding size bytes
+ *          (already rounded to the program unit).
+ *
+ * The area grows by at least half its current size each time it is
+ * reallocated, so that creating N KVs moves the area O(log N) times
+ * rather than on every create. It is only shrunk once it is less than a
+ * quarter full, to avoid reallocating when KVs are created and deleted in
+ * turn. When the memory is a client supplied slab there is nothing to gain
+ * and the area is sized exactly.
+ */
+static ARM_CFSTORE_SIZE cfstore_area_capacity(cfstore_ctx_t* ctx, ARM_CFSTORE_SIZE size)
+{
+#ifndef CFSTORE_YOTTA_CFG_CFSTORE_SRAM_ADDR
+    ARM_CFSTORE_SIZE capacity = ctx->area_0_len;
+    uint32_t program_unit = cfstore_ctx_get_program_unit(ctx);
+
+    if(size > capacity){
+        capacity += capacity / 2;
+        if(capacity < size + ctx->batch_reserve){
+            capacity = size + ctx->batch_reserve;
+        }
+        if(capacity < CFSTORE_AREA_SIZE_MIN){
+            capacity = CFSTORE_AREA_SIZE_MIN;
+        }
+        ctx->batch_reserve = 0;
+    } else if(size < capacity / 4 && ctx->batch_ref_count == 0){
+        capacity = size;
+    }
+    if(capacity % program_unit > 0){
+        capacity += program_unit - (capacity % program_unit);
+    }
+    return capacity;
+#else
+    (void) ctx;
+    return size;
+#endif /* CFSTORE_YOTTA_CFG_CFSTORE_SRAM_ADDR */
+}
+
+
 /** @brief  Function to realloc the SRAM area used to store KVs.
  *
  * This function consolidates the code needed to:
@@ -1411,6 +1570,8 @@ static int32_t cfstore_realloc_ex(ARM_CFSTORE_SIZE size, uint64_t *allocated_siz
     cfstore_list_node_t* node;
     cfstore_list_node_t* file_list = &ctx->file_list;
     ARM_CFSTORE_SIZE total_kv_size = size;
+    ARM_CFSTORE_SIZE old_kv_size = cfstore_ctx_get_kv_total_len();
+    ARM_CFSTORE_SIZE capacity = 0;
 
     /* Switch on the size of the sram area to create:
      * - if size > 0 (but may be shrinking) then use REALLOC.
@@ -1431,8 +1592,26 @@ static int32_t cfstore_realloc_ex(ARM_CFSTORE_SIZE size, uint64_t *allocated_siz
         if(size % cfstore_ctx_get_program_unit(ctx) > 0){
             size += (cfstore_ctx_get_program_unit(ctx) - (size % cfstore_ctx_get_program_unit(ctx)));
         }
+        /* the KVs following area_0_tail become the flash padding so must be zero */
+        if(total_kv_size < old_kv_size){
+            memset(ctx->area_0_head + total_kv_size, 0, old_kv_size - total_kv_size);
+        }
+        capacity = cfstore_area_capacity(ctx, size);
+        if(capacity == ctx->area_0_len){
+            /* the area already has the required space */
+            ctx->area_0_tail = ctx->area_0_head + total_kv_size;
+            if(allocated_size != NULL) {
+                *allocated_size = size;
+            }
+            return ARM_DRIVER_OK;
+        }
 
-        ptr = (uint8_t*) CFSTORE_REALLOC((void*) ctx->area_0_head, size);
+        ptr = (uint8_t*) CFSTORE_REALLOC((void*) ctx->area_0_head, capacity);
+        if(ptr == NULL && capacity > size){
+            /* not enough memory for the spare capacity, so try again without it */
+            capacity = size;
+            ptr = (uint8_t*) CFSTORE_REALLOC((void*) ctx->area_0_head, capacity);
+        }
         if(ptr == NULL){
             CFSTORE_ERRLOG("%s:Error: unable to allocate memory (size=%d)\n", __func__, (int) size);
             /* realloc() has failed to allocate the required memory object. If previously
@@ -1452,15 +1631,14 @@ static int32_t cfstore_realloc_ex(ARM_CFSTORE_SIZE size, uint64_t *allocated_siz
             node = file_list->next;
             while(node != file_list){
                 file = (cfstore_file_t*) node;
-                file->head = (uint8_t *) (file->head - ctx->area_0_head);
-                file->head = (uint8_t *) ((int32_t) file->head + (int32_t) ptr);
+                file->head = ptr + (file->head - ctx->area_0_head);
                 node = node->next;
             }
             ctx->area_0_head = ptr;
         }
 
         /* If the area is growing then zero the new space at the end of the area */
-        len_diff = size - (int32_t) ctx->area_0_len;
+        len_diff = capacity - (int32_t) ctx->area_0_len;
         if(len_diff > 0) {
             memset(ptr + ctx->area_0_len, 0, len_diff);
         }
@@ -1468,7 +1646,7 @@ static int32_t cfstore_realloc_ex(ARM_CFSTORE_SIZE size, uint64_t *allocated_siz
          * This is the only place that area_0_tail should be changed, apart from cfstore_flash_set_tail()
          * which is only called when attributes are loaded from flash.
          */
-        ctx->area_0_len = size;
+        ctx->area_0_len = capacity;
         ctx->area_0_tail = ptr + total_kv_size;
         if(allocated_size != NULL) {
             *allocated_size = size;
@@ -1599,6 +1777,253 @@ static int32_t cfstore_fsm_stop_on_entry(void* context)
 /* static int32_t cfstore_fsm_stop_on_exit(void* context) {(void) context; }*/
 
 
+/*
+ * delta log helper functions
+ */
+
+/* @brief   record the name of a KV being deleted so the next flush can append
+ *          a DELETE record for it to the delta log */
+static void cfstore_delta_deleted_add(cfstore_ctx_t* ctx, cfstore_area_hkvt_t* hkvt)
+{
+    uint8_t key_len = cfstore_hkvt_get_key_len(hkvt);
+
+    if(!cfstore_delta_is_enabled(&ctx->delta)){
+        return;
+    }
+    if(ctx->delta_deleted_len + key_len + 1 > CFSTORE_DELTA_DELETED_SIZE){
+        CFSTORE_TP(CFSTORE_TP_DELETE, "%s:deleted key buffer full, next flush writes a full snapshot\n", __func__);
+        ctx->delta_deleted_overflow = true;
+        return;
+    }
+    ctx->delta_deleted[ctx->delta_deleted_len++] = key_len;
+    memcpy(&ctx->delta_deleted[ctx->delta_deleted_len], hkvt->key, key_len);
+    ctx->delta_deleted_len += key_len;
+}
+
+
+/* @brief   forget the changes made since the last flush once they have been persisted */
+static void cfstore_delta_clear_changes(cfstore_ctx_t* ctx)
+{
+    uint8_t* ptr = NULL;
+    cfstore_area_hkvt_t hkvt;
+
+    for(ptr = ctx->area_0_head; ptr != NULL && ptr < ctx->area_0_tail; ptr = hkvt.tail){
+        hkvt = cfstore_get_hkvt_from_head_ptr(ptr);
+        cfstore_hkvt_set_flags_dirty(&hkvt, false);
+    }
+    ctx->delta_deleted_len = 0;
+    ctx->delta_deleted_overflow = false;
+}
+
+
+/* @brief   compute the delta log space needed to flush the changes made since the last flush */
+static uint32_t cfstore_delta_flush_size(cfstore_ctx_t* ctx)
+{
+    uint32_t pos = 0;
+    uint32_t size = 0;
+    uint8_t* ptr = NULL;
+    cfstore_area_hkvt_t hkvt;
+
+    for(pos = 0; pos < ctx->delta_deleted_len; pos += ctx->delta_deleted[pos] + 1){
+        size += cfstore_delta_record_size(&ctx->delta, ctx->delta_deleted[pos]);
+    }
+    for(ptr = ctx->area_0_head; ptr != NULL && ptr < ctx->area_0_tail; ptr = hkvt.tail){
+        hkvt = cfstore_get_hkvt_from_head_ptr(ptr);
+        if(!cfstore_hkvt_get_flags_dirty(&hkvt)){
+            continue;
+        }
+        if(cfstore_hkvt_get_flags_delete(&hkvt)){
+            size += cfstore_delta_record_size(&ctx->delta, cfstore_hkvt_get_key_len(&hkvt));
+        } else {
+            size += cfstore_delta_record_size(&ctx->delta, cfstore_hkvt_get_size(&hkvt));
+        }
+    }
+    /* END record */
+    size += cfstore_delta_record_size(&ctx->delta, 0);
+    return size;
+}
+
+
+/* @brief   append the changes made since the last flush to the delta log
+ *
+ * @return  true if the changes have been persisted in the delta log, false
+ *          if a full snapshot has to be written to the journal instead.
+ */
+static bool cfstore_delta_flush(cfstore_ctx_t* ctx)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+    uint32_t pos = 0;
+    uint8_t* ptr = NULL;
+    cfstore_area_header_t hdr;
+    cfstore_area_hkvt_t hkvt;
+    cfstore_delta_log_t* log = &ctx->delta;
+
+    CFSTORE_FENTRYLOG("%s:entered\n", __func__);
+    if(!cfstore_delta_is_enabled(log) || ctx->delta_deleted_overflow){
+        return false;
+    }
+    if(!log->formatted){
+        ret = cfstore_delta_reset(log, log->base_crc);
+        if(ret < ARM_DRIVER_OK){
+            CFSTORE_ERRLOG("%s:Error: failed to reset delta log (ret=%d)\n", __func__, (int) ret);
+            return false;
+        }
+    }
+    if(log->needs_compaction || cfstore_delta_flush_size(ctx) > cfstore_delta_space(log)){
+        CFSTORE_TP(CFSTORE_TP_FLUSH, "%s:delta log needs compaction\n", __func__);
+        return false;
+    }
+    for(pos = 0; pos < ctx->delta_deleted_len; pos += ctx->delta_deleted[pos] + 1){
+        ret = cfstore_delta_append(log, CFSTORE_DELTA_RECORD_DELETE, &ctx->delta_deleted[pos+1], ctx->delta_deleted[pos], NULL, 0);
+        if(ret < ARM_DRIVER_OK){
+            return false;
+        }
+    }
+    for(ptr = ctx->area_0_head; ptr != NULL && ptr < ctx->area_0_tail; ptr = hkvt.tail){
+        hkvt = cfstore_get_hkvt_from_head_ptr(ptr);
+        if(!cfstore_hkvt_get_flags_dirty(&hkvt)){
+            continue;
+        }
+        if(cfstore_hkvt_get_flags_delete(&hkvt)){
+            ret = cfstore_delta_append(log, CFSTORE_DELTA_RECORD_DELETE, hkvt.key, cfstore_hkvt_get_key_len(&hkvt), NULL, 0);
+        } else {
+            /* the KV is persisted without the state of the open handles */
+            memcpy(&hdr, hkvt.head, sizeof(hdr));
+            hdr.refcount = 0;
+            memset(&hdr.flags, 0, sizeof(hdr.flags));
+            ret = cfstore_delta_append(log, CFSTORE_DELTA_RECORD_PUT, &hdr, sizeof(hdr), hkvt.key, cfstore_hkvt_get_size(&hkvt) - sizeof(hdr));
+        }
+        if(ret < ARM_DRIVER_OK){
+            return false;
+        }
+    }
+    ret = cfstore_delta_append(log, CFSTORE_DELTA_RECORD_END, NULL, 0, NULL, 0);
+    if(ret < ARM_DRIVER_OK){
+        return false;
+    }
+    CFSTORE_TP(CFSTORE_TP_FLUSH, "%s:changes appended to delta log (offset=%d)\n", __func__, (int) log->offset);
+    cfstore_delta_clear_changes(ctx);
+    return true;
+}
+
+
+/* @brief   prepare to fold the delta log into a full snapshot of the area
+ *          which is about to be logged to the journal */
+static int32_t cfstore_delta_compact(cfstore_ctx_t* ctx)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+
+    CFSTORE_FENTRYLOG("%s:entered\n", __func__);
+    /* the dirty flags are persisted in the snapshot, so clear them first */
+    cfstore_delta_clear_changes(ctx);
+    ctx->delta_compact_crc = cfstore_delta_crc(ctx->area_0_head, (uint32_t) ctx->expected_blob_size);
+    ret = cfstore_delta_compact_begin(&ctx->delta, ctx->delta_compact_crc);
+    if(ret < ARM_DRIVER_OK){
+        CFSTORE_ERRLOG("%s:Error: failed to start delta log compaction (ret=%d)\n", __func__, (int) ret);
+        return ret;
+    }
+    ctx->delta_compacting = true;
+    return ARM_DRIVER_OK;
+}
+
+
+/* @brief   find the KV with key name key, irrespective of its flags and permissions */
+static int32_t cfstore_delta_find(const uint8_t* key, uint8_t key_len, cfstore_area_hkvt_t* hkvt)
+{
+    uint8_t* ptr = NULL;
+    cfstore_ctx_t* ctx = cfstore_ctx_get();
+
+    for(ptr = ctx->area_0_head; ptr != NULL && ptr < ctx->area_0_tail; ptr = hkvt->tail){
+        *hkvt = cfstore_get_hkvt_from_head_ptr(ptr);
+        if(cfstore_hkvt_get_key_len(hkvt) == key_len && memcmp(hkvt->key, key, key_len) == 0){
+            return ARM_DRIVER_OK;
+        }
+    }
+    return ARM_CFSTORE_DRIVER_ERROR_KEY_NOT_FOUND;
+}
+
+
+/* @brief   cfstore_delta_replay() callback applying a PUT or DELETE record to the area */
+static int32_t cfstore_delta_apply(cfstore_delta_log_t* log, uint8_t type, uint32_t offset, uint32_t length, void* context)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+    uint8_t key[CFSTORE_KEY_NAME_MAX_LENGTH];
+    uint8_t key_len = 0;
+    uint8_t* head = NULL;
+    ARM_CFSTORE_SIZE area_size = 0;
+    cfstore_area_header_t hdr;
+    cfstore_area_hkvt_t hkvt;
+
+    (void) context;
+    if(type == CFSTORE_DELTA_RECORD_PUT){
+        ret = cfstore_delta_read(log, offset, &hdr, sizeof(hdr));
+        if(ret < ARM_DRIVER_OK){
+            return ret;
+        }
+        if(length != sizeof(hdr) + hdr.klength + hdr.vlength){
+            CFSTORE_ERRLOG("%s:Error: invalid PUT record\n", __func__);
+            return ARM_CFSTORE_DRIVER_ERROR_INTERNAL;
+        }
+        key_len = hdr.klength;
+        offset += sizeof(hdr);
+    } else {
+        key_len = (uint8_t) length;
+    }
+    if(key_len == 0 || key_len > CFSTORE_KEY_NAME_MAX_LENGTH || (type == CFSTORE_DELTA_RECORD_DELETE && length > CFSTORE_KEY_NAME_MAX_LENGTH)){
+        CFSTORE_ERRLOG("%s:Error: invalid key name length\n", __func__);
+        return ARM_CFSTORE_DRIVER_ERROR_INTERNAL;
+    }
+    ret = cfstore_delta_read(log, offset, key, key_len);
+    if(ret < ARM_DRIVER_OK){
+        return ret;
+    }
+    /* a PUT replaces any previous version of the KV */
+    if(cfstore_delta_find(key, key_len, &hkvt) == ARM_DRIVER_OK){
+        ret = cfstore_delete_ex(&hkvt);
+        if(ret < ARM_DRIVER_OK){
+            return ret;
+        }
+    }
+    if(type == CFSTORE_DELTA_RECORD_DELETE){
+        return ARM_DRIVER_OK;
+    }
+    area_size = cfstore_ctx_get_kv_total_len();
+    ret = cfstore_realloc_ex(area_size + length, NULL);
+    if(ret < ARM_DRIVER_OK){
+        return ret;
+    }
+    head = cfstore_ctx_get()->area_0_head + area_size;
+    hdr.refcount = 0;
+    memset(&hdr.flags, 0, sizeof(hdr.flags));
+    memcpy(head, &hdr, sizeof(hdr));
+    return cfstore_delta_read(log, offset, head + sizeof(hdr), length - sizeof(hdr));
+}
+
+
+/* @brief   replay the delta log on top of the base snapshot read from the journal
+ *
+ * @param   blob_size
+ *          size of the base snapshot at the start of the area, 0 if the
+ *          journal is empty.
+ */
+static int32_t cfstore_delta_load(cfstore_ctx_t* ctx, uint32_t blob_size)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+
+    CFSTORE_FENTRYLOG("%s:entered\n", __func__);
+    if(!cfstore_delta_is_enabled(&ctx->delta)){
+        return ARM_DRIVER_OK;
+    }
+    ret = cfstore_delta_replay(&ctx->delta, cfstore_delta_crc(ctx->area_0_head, blob_size), cfstore_delta_apply, ctx);
+    if(ret < ARM_DRIVER_OK){
+        CFSTORE_ERRLOG("%s:Error: failed to replay delta log (ret=%d)\n", __func__, (int) ret);
+        return ret;
+    }
+    cfstore_delta_clear_changes(ctx);
+    return ARM_DRIVER_OK;
+}
+
+
 /* @brief   fsm on entry function for the initing state
  * @note
  *  flash journal sync mode: (see async mode notes)
@@ -1614,13 +2039,21 @@ static int32_t cfstore_fsm_init_on_entry(void* context)
 
     CFSTORE_FENTRYLOG("%s:entered\n", __func__);
 
-    ret = cfstore_svm_init(&cfstore_journal_mtd);
+    ret = cfstore_svm_init(&cfstore_journal_mtd, &cfstore_delta_mtd);
     if(ret < ARM_DRIVER_OK){
         CFSTORE_DBGLOG("%s:Error: Unable to initialize storage volume manager\n", __func__);
         cfstore_fsm_state_set(&ctx->fsm, cfstore_fsm_state_formatting, ctx);
         return ARM_DRIVER_OK;
     }
 
+    /* without a delta log every flush writes a full snapshot to the journal */
+    ctx->delta_deleted_len = 0;
+    ctx->delta_deleted_overflow = false;
+    ret = cfstore_delta_init(&ctx->delta, CFSTORE_DELTA_LOG_SIZE > 0 ? &cfstore_delta_mtd : NULL);
+    if(ret < ARM_DRIVER_OK){
+        CFSTORE_DBGLOG("%s:delta log not in use (ret=%d)\n", __func__, (int) ret);
+    }
+
     ret = FlashJournal_initialize(&ctx->jrnl, (ARM_DRIVER_STORAGE *) &cfstore_journal_mtd, &FLASH_JOURNAL_STRATEGY_SEQUENTIAL, cfstore_flash_journal_callback);
     CFSTORE_TP(CFSTORE_TP_FSM, "%s:FlashJournal_initialize ret=%d\n", __func__, (int) ret);
     if(ret < ARM_DRIVER_OK){
@@ -1693,6 +2126,8 @@ static int32_t cfstore_fsm_read_on_entry(void* context)
 
     CFSTORE_FENTRYLOG("%s:entered\n", __func__);
     CFSTORE_ASSERT(ctx != NULL);
+    /* the index is rebuilt once the area has been read */
+    cfstore_index_deinit(&ctx->index);
     /* FlashJournal_getInfo() is synchronous */
     status = FlashJournal_getInfo(&ctx->jrnl, &ctx->info);
     if(status < JOURNAL_STATUS_OK){
@@ -1771,6 +2206,14 @@ static int32_t cfstore_fsm_reading(void* context)
                     memset(&ctx->info, 0, sizeof(ctx->info));
                     goto out;
                 }
+                ret = cfstore_delta_load(ctx, (uint32_t) ctx->expected_blob_size);
+                if(ret < ARM_DRIVER_OK){
+                    /* move to ready state. cfstore client is expected to Uninitialize() before further calls */
+                    ctx->status = ret;
+                    cfstore_fsm_state_set(&ctx->fsm, cfstore_fsm_state_ready, ctx);
+                    goto out;
+                }
+                cfstore_index_rebuild(ctx);
                 ret = cfstore_fsm_state_set(&ctx->fsm, cfstore_fsm_state_ready, ctx);
                 if(ret < ARM_DRIVER_OK){
                     CFSTORE_ERRLOG("%s:Error: cfstore_fsm_state_set() failed (ret=%d)\n", __func__, (int) ret);
@@ -1793,6 +2236,14 @@ static int32_t cfstore_fsm_reading(void* context)
         else
         {
             CFSTORE_TP(CFSTORE_TP_FSM, "%s:debug:ctx->status <= (int32_t) CFSTORE_FLASH_AREA_SIZE_MIN:\n", __func__);
+            ret = cfstore_delta_load(ctx, 0);
+            if(ret < ARM_DRIVER_OK){
+                /* move to ready state. cfstore client is expected to Uninitialize() before further calls */
+                ctx->status = ret;
+                cfstore_fsm_state_set(&ctx->fsm, cfstore_fsm_state_ready, ctx);
+                goto out;
+            }
+            cfstore_index_rebuild(ctx);
             ret = cfstore_fsm_state_set(&ctx->fsm, cfstore_fsm_state_ready, ctx);
             if(ret < ARM_DRIVER_OK){
                 /* move to ready state. cfstore client is expected to Uninitialize() before further calls */
@@ -1848,6 +2299,21 @@ int32_t cfstore_fsm_log_on_entry(void* context)
     if(ctx->expected_blob_size % info.program_unit > 0){
         ctx->expected_blob_size += (info.program_unit - (ctx->expected_blob_size % info.program_unit));
     }
+    ctx->delta_compacting = false;
+    if(ctx->area_dirty_flag == true && cfstore_delta_is_enabled(&ctx->delta))
+    {
+        if(cfstore_delta_flush(ctx)){
+            /* the changes are persisted in the delta log, so the journal is left as is */
+            ctx->area_dirty_flag = false;
+        } else {
+            ret = cfstore_delta_compact(ctx);
+            if(ret < ARM_DRIVER_OK){
+                /* move to ready state. cfstore client is expected to Uninitialize() before further calls */
+                cfstore_fsm_state_set(&ctx->fsm, cfstore_fsm_state_ready, ctx);
+                goto out0;
+            }
+        }
+    }
     /* log the changes to flash even when the area has shrunk to 0, as its necessary to erase the flash */
     if(ctx->area_dirty_flag == true)
     {
@@ -1990,6 +2456,13 @@ static int32_t cfstore_fsm_committing(void* context)
     }
     else
     {   /* ctx->status > 0. for flash-journal-strategy-sequential version >0.4.0, commit() return no longer reports size of commit block */
+        if(ctx->delta_compacting){
+            /* the snapshot now holds the delta log records */
+            if(cfstore_delta_reset(&ctx->delta, ctx->delta_compact_crc) < ARM_DRIVER_OK){
+                CFSTORE_ERRLOG("%s:Error: failed to reset delta log after compaction\n", __func__);
+            }
+            ctx->delta_compacting = false;
+        }
         ctx->status = cfstore_fsm_state_set(&ctx->fsm, cfstore_fsm_state_ready, ctx);
     }
     return ctx->status;
@@ -2298,6 +2771,7 @@ static int32_t cfstore_flash_init(void)
 }
 
 static int32_t cfstore_flash_deinit(void){ CFSTORE_FENTRYLOG("%s:SRAM:entered:\n", __func__); return ARM_DRIVER_OK; }
+static void cfstore_delta_deleted_add(cfstore_ctx_t* ctx, cfstore_area_hkvt_t* hkvt) { (void) ctx; (void) hkvt; }
 /* static int32_t cfstore_flash_reset(void) { CFSTORE_FENTRYLOG("%s:SRAM:entered:\n", __func__); return ARM_DRIVER_OK; }*/
 static int32_t cfstore_flash_flush(cfstore_ctx_t* ctx)
 {
@@ -2313,7 +2787,7 @@ static int32_t cfstore_flash_flush(cfstore_ctx_t* ctx)
 
 
 /** @brief  After a cfstore KV area memmove() operation, update the file pointers
- *          to reflect the new location in memory of KVs.
+ *          and the index to reflect the new location in memory of KVs.
  *
  * @param   head
  * the position at which size_diff bytes have been inserted/deleted
@@ -2348,6 +2822,8 @@ static int32_t cfstore_file_update(uint8_t* head, int32_t size_diff)
         }
         node = node->next;
     }
+    /* the KV at head itself has not moved */
+    cfstore_index_shift(&ctx->index, head - ctx->area_0_head, size_diff);
     return ARM_DRIVER_OK;
 }
 
@@ -2364,6 +2840,15 @@ static int32_t cfstore_delete_ex(cfstore_area_hkvt_t* hkvt)
     kv_size  = cfstore_hkvt_get_size(hkvt);
     kv_total_size = cfstore_ctx_get_kv_total_len();
 
+    if(ctx->batch_ref_count > 0 && hkvt->tail != ctx->area_0_tail){
+        /* leave the KV in the area marked deleted (find skips it) until
+         * cfstore_batch_compact() removes it, rather than moving all the following KVs now */
+        cfstore_index_remove(&ctx->index, hkvt->head - ctx->area_0_head);
+        cfstore_hkvt_set_flags_delete(hkvt, true);
+        ctx->batch_deleted_size += kv_size;
+        return ARM_DRIVER_OK;
+    }
+
     /* Note the following:
      *  1. memmove() above shifts the position of the KVs falling after the deleted KV to be at
      *     lower memory addresses. The code (A) updates the cfstore_file_t::head pointers for these KVs
@@ -2373,6 +2858,7 @@ static int32_t cfstore_delete_ex(cfstore_area_hkvt_t* hkvt)
      *     need to be updated. cfstore_realloc() can only do this starting from a set of correct
      *     cfstore_file_t::head pointers i.e. after 1. has been completed.
      */
+    cfstore_index_remove(&ctx->index, hkvt->head - ctx->area_0_head);
     memmove(hkvt->head, hkvt->tail, ctx->area_0_tail - hkvt->tail);
     /* zero the deleted KV memory */
     memset(ctx->area_0_tail-kv_size, 0, kv_size);
@@ -2396,6 +2882,58 @@ out0:
 }
 
 
+/* @brief   remove the KVs deleted while a batch was open from the area in a
+ *          single pass, moving each remaining KV at most once.
+ */
+static int32_t cfstore_batch_compact(cfstore_ctx_t* ctx)
+{
+    uint8_t* src = ctx->area_0_head;
+    uint8_t* dst = ctx->area_0_head;
+    int32_t ret = ARM_DRIVER_ERROR;
+    ARM_CFSTORE_SIZE kv_size = 0;
+    cfstore_area_hkvt_t hkvt;
+    cfstore_file_t* file;
+    cfstore_list_node_t* node;
+    cfstore_list_node_t* file_list = &ctx->file_list;
+
+    CFSTORE_FENTRYLOG("%s:entered:(batch_deleted_size=%d)\n", __func__, (int) ctx->batch_deleted_size);
+    if(ctx->batch_deleted_size == 0){
+        return ARM_DRIVER_OK;
+    }
+    while(src < ctx->area_0_tail)
+    {
+        hkvt = cfstore_get_hkvt_from_head_ptr(src);
+        kv_size = cfstore_hkvt_get_size(&hkvt);
+        /* KVs deleted with handles still open remain until the last handle is closed */
+        if(cfstore_hkvt_get_flags_delete(&hkvt) && ((cfstore_area_header_t*) hkvt.head)->refcount == 0){
+            src += kv_size;
+            continue;
+        }
+        if(dst != src){
+            memmove(dst, src, kv_size);
+            node = file_list->next;
+            while(node != file_list){
+                file = (cfstore_file_t*) node;
+                if(file->head == src){
+                    file->head = dst;
+                }
+                node = node->next;
+            }
+        }
+        src += kv_size;
+        dst += kv_size;
+    }
+    ctx->batch_deleted_size = 0;
+    ret = cfstore_realloc_ex(dst - ctx->area_0_head, NULL);
+    if(ret < ARM_DRIVER_OK){
+        CFSTORE_ERRLOG("%s:Error:realloc failed\n", __func__);
+        return ret;
+    }
+    cfstore_index_rebuild(ctx);
+    return ARM_DRIVER_OK;
+}
+
+
 /*
  * File operations
  */
@@ -2423,7 +2961,7 @@ static cfstore_file_t* cfstore_file_create(cfstore_area_hkvt_t* hkvt, ARM_CFSTOR
         file->flags.read = flags.read;
         file->flags.write = flags.write;
         if(list_head != NULL){
-            cfstore_listAdd(list_head, &file->node, list_head);
+            cfstore_listAdd(list_head, &file->node, list_head->next);
         }
     }
     return file;
@@ -2447,13 +2985,14 @@ static int32_t cfstore_file_destroy(cfstore_file_t* file)
             /* check for delete */
             CFSTORE_TP(CFSTORE_TP_FILE, "%s:checking delete flag\n", __func__);
             if(cfstore_hkvt_get_flags_delete(&hkvt)){
+                cfstore_delta_deleted_add(cfstore_ctx_get(), &hkvt);
                 ret = cfstore_delete_ex(&hkvt);
             }
-            /* reset client buffer to empty ready for reuse */
-            /* delete the file even if not deleting the KV*/
-            cfstore_listDel(&file->node);
-            memset(file, 0, sizeof(cfstore_file_t));
         }
+        /* reset client buffer to empty ready for reuse */
+        /* delete the file even if not deleting the KV or other handles to the KV remain open */
+        cfstore_listDel(&file->node);
+        memset(file, 0, sizeof(cfstore_file_t));
     }
     return ret;
 }
@@ -3098,6 +3637,7 @@ static int32_t cfstore_delete(ARM_CFSTORE_HANDLE hkey)
     cfstore_hkvt_set_flags_delete(&hkvt, true);
 
     /* set the dirty flag so the changes are persisted to backing store when flushed */
+    cfstore_hkvt_set_flags_dirty(&hkvt, true);
     ctx->area_dirty_flag = true;
 
 out0:
@@ -3108,7 +3648,71 @@ out0:
 }
 
 
+/** @brief  Internal find function using the index to examine only the KVs
+ *          whose key_name may match the query.
+ *
+ * As for cfstore_find_ex(), the KV returned is the first KV in the area
+ * following prev which matches the query, so Find() enumerates KVs in the
+ * same order whether or not the index is used.
+ *
+ * @param   iter
+ *          index iterator initialised with key_name_query
+ */
+static int32_t cfstore_find_ex_index(const char* key_name_query, cfstore_index_iter_t* iter, cfstore_area_hkvt_t *prev, cfstore_area_hkvt_t *next)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+    uint8_t key_len = 0;
+    uint32_t offset = 0;
+    uint32_t min_offset = 0;
+    uint32_t found = UINT32_MAX;
+    char key_name[CFSTORE_KEY_NAME_MAX_LENGTH+1];
+    cfstore_area_hkvt_t hkvt;
+    cfstore_ctx_t* ctx = cfstore_ctx_get();
+
+    CFSTORE_TP((CFSTORE_TP_FIND|CFSTORE_TP_FENTRY), "%s:entered: key_name_query=\"%s\", prev=%p, next=%p\n", __func__, key_name_query, prev, next);
+    if(prev != NULL){
+        min_offset = prev->tail - ctx->area_0_head;
+    }
+    while(cfstore_index_iter_next(&ctx->index, iter, &offset))
+    {
+        if(offset < min_offset || offset >= found){
+            continue;
+        }
+        hkvt = cfstore_get_hkvt_from_head_ptr(ctx->area_0_head + offset);
+        /* skip KVs being deleted and KVs the client cannot read, as cfstore_find_ex() */
+        if(cfstore_hkvt_get_flags_delete(&hkvt) || !cfstore_is_kv_client_readable(&hkvt)){
+            continue;
+        }
+        if(!iter->exact){
+            key_len = cfstore_hkvt_get_key_len(&hkvt);
+            key_len++;
+            cfstore_get_key_name_ex(&hkvt, key_name, &key_len);
+            ret = cfstore_fnmatch(key_name_query, key_name, 0);
+            if(ret == CFSTORE_FNM_NOMATCH){
+                continue;
+            } else if(ret != 0){
+                CFSTORE_ERRLOG("%s:Error: cfstore_fnmatch() error (ret=%d).\n", __func__, (int) ret);
+                return ARM_DRIVER_ERROR;
+            }
+        }
+        found = offset;
+    }
+    if(found == UINT32_MAX){
+        CFSTORE_TP(CFSTORE_TP_FIND, "%s:No more KVs found\n", __func__);
+        memset((void*) next, 0, sizeof(cfstore_area_hkvt_t));
+        return ARM_CFSTORE_DRIVER_ERROR_KEY_NOT_FOUND;
+    }
+    *next = cfstore_get_hkvt_from_head_ptr(ctx->area_0_head + found);
+    cfstore_hkvt_dump(next, __func__);
+    return ARM_DRIVER_OK;
+}
+
+
 /** @brief  Internal find function using hkvt's.
+ *
+ * Queries which the index can narrow down (those not starting with a
+ * wildcard) are handled by cfstore_find_ex_index(), otherwise the whole
+ * area is walked.
  *
  * @note
  * Not the following:
@@ -3127,8 +3731,12 @@ static int32_t cfstore_find_ex(const char* key_name_query, cfstore_area_hkvt_t *
     int32_t ret = ARM_DRIVER_ERROR;
     uint8_t next_key_len;
     char key_name[CFSTORE_KEY_NAME_MAX_LENGTH+1];
+    cfstore_index_iter_t iter;
     cfstore_ctx_t* ctx = cfstore_ctx_get();
 
+    if(cfstore_index_iter_init(&ctx->index, &iter, key_name_query)){
+        return cfstore_find_ex_index(key_name_query, &iter, prev, next);
+    }
     CFSTORE_TP((CFSTORE_TP_FIND|CFSTORE_TP_FENTRY), "%s:entered: key_name_query=\"%s\", prev=%p, next=%p\n", __func__, key_name_query, prev, next);
     if(prev == NULL){
         ret = cfstore_get_head_hkvt(next);
@@ -3297,6 +3905,12 @@ out2:
         memset(key_name, 0, CFSTORE_KEY_NAME_MAX_LENGTH+1);
 
         cfstore_file_destroy(cfstore_file_get(previous));
+        if(ret < ARM_DRIVER_OK){
+            goto out1;
+        }
+        /* deleting the previous KV may have moved the area, whereas the head of
+         * the next handle is kept up to date */
+        hkvt_next = cfstore_get_hkvt(next);
 
         /* check hkvt is valid before trying to retrieve name*/
         if(!cfstore_hkvt_is_valid(&hkvt_next, ctx->area_0_tail)){
@@ -3395,6 +4009,7 @@ static int32_t cfstore_recreate(const char* key_name, ARM_CFSTORE_SIZE value_len
     /* set the new value length in the header */
     cfstore_hkvt_set_value_len(hkvt, value_len);
     cfstore_file_create(hkvt, flags, hkey, &ctx->file_list);
+    cfstore_hkvt_set_flags_dirty(hkvt, true);
     ctx->area_dirty_flag = true;
 
 #ifdef CFSTORE_DEBUG
@@ -3528,6 +4143,8 @@ static int32_t cfstore_create(const char* key_name, ARM_CFSTORE_SIZE value_len,
     hdr->perm_other_execute = kdesc->acl.perm_other_execute;
     strncpy((char*)hdr + sizeof(cfstore_area_header_t), key_name, strlen(key_name));
     hkvt = cfstore_get_hkvt_from_head_ptr((uint8_t*) hdr);
+    /* failure to index the KV invalidates the index rather than failing the create */
+    cfstore_index_insert(&ctx->index, area_size);
     if(cfstore_flags_is_default(kdesc->flags)){
         /* set as read-only by default default */
         flags.read = true;
@@ -3537,6 +4154,7 @@ static int32_t cfstore_create(const char* key_name, ARM_CFSTORE_SIZE value_len,
         flags.write = kdesc->flags.write;
     }
     cfstore_file_create(&hkvt, flags, hkey, &ctx->file_list);
+    cfstore_hkvt_set_flags_dirty(&hkvt, true);
     ctx->area_dirty_flag = true;
     ret = ARM_DRIVER_OK;
 out1:
@@ -3826,6 +4444,7 @@ static int32_t cfstore_write(ARM_CFSTORE_HANDLE hkey, const char* data, ARM_CFST
     memcpy(hkvt.value + file->wlocation, data, *len);
     file->wlocation += *len;
     cfstore_hkvt_dump(&hkvt, __func__);
+    cfstore_hkvt_set_flags_dirty(&hkvt, true);
     ctx->area_dirty_flag = true;
     ret = *len;
 out0:
@@ -3914,6 +4533,11 @@ static int32_t cfstore_flush(void)
         CFSTORE_TP(CFSTORE_TP_FLUSH, "%s:Debug: flash journal operation pending (awaiting asynchronous notification).\n", __func__);
         return ARM_CFSTORE_DRIVER_ERROR_OPERATION_PENDING;
     }
+    /* KVs deleted in an open batch must not be persisted */
+    ret = cfstore_batch_compact(ctx);
+    if(ret < ARM_DRIVER_OK) {
+        goto out0;
+    }
     ret = cfstore_flash_flush(ctx);
     if(ret < ARM_DRIVER_OK) {
         CFSTORE_ERRLOG("%s:Error: cfstore_flash_flush() returned error (ret=%d).\n", __func__, (int) ret);
@@ -3923,6 +4547,60 @@ out0:
     return ret;
 }
 
+
+/* @brief  See definition in configuration_store.h for description. */
+static int32_t cfstore_begin_batch(ARM_CFSTORE_SIZE size_hint)
+{
+    cfstore_ctx_t* ctx = cfstore_ctx_get();
+
+    CFSTORE_FENTRYLOG("%s:entered: size_hint=%d\n", __func__, (int) size_hint);
+    if(!cfstore_ctx_is_initialised(ctx)) {
+        CFSTORE_ERRLOG("%s:Error: CFSTORE is not initialised.\n", __func__);
+        return ARM_CFSTORE_DRIVER_ERROR_UNINITIALISED;
+    }
+    /* the area cannot change while a flashJournal_log() is pending */
+    if(cfstore_flash_journal_is_async_op_pending(ctx)) {
+        CFSTORE_TP(CFSTORE_TP_CREATE, "%s:Debug: flash journal operation pending (awaiting asynchronous notification).\n", __func__);
+        return ARM_CFSTORE_DRIVER_ERROR_OPERATION_PENDING;
+    }
+    ctx->batch_ref_count++;
+    /* the next time the area grows, it grows by enough for the KVs about to be created */
+    ctx->batch_reserve += size_hint;
+    return ARM_DRIVER_OK;
+}
+
+
+/* @brief  See definition in configuration_store.h for description. */
+static int32_t cfstore_end_batch(void)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+    cfstore_ctx_t* ctx = cfstore_ctx_get();
+
+    CFSTORE_FENTRYLOG("%s:entered\n", __func__);
+    if(!cfstore_ctx_is_initialised(ctx)) {
+        CFSTORE_ERRLOG("%s:Error: CFSTORE is not initialised.\n", __func__);
+        return ARM_CFSTORE_DRIVER_ERROR_UNINITIALISED;
+    }
+    if(ctx->batch_ref_count == 0) {
+        CFSTORE_ERRLOG("%s:Error: no batch has been started.\n", __func__);
+        return ARM_DRIVER_ERROR;
+    }
+    if(cfstore_flash_journal_is_async_op_pending(ctx)) {
+        CFSTORE_TP(CFSTORE_TP_CREATE, "%s:Debug: flash journal operation pending (awaiting asynchronous notification).\n", __func__);
+        return ARM_CFSTORE_DRIVER_ERROR_OPERATION_PENDING;
+    }
+    if(--ctx->batch_ref_count > 0){
+        return ARM_DRIVER_OK;
+    }
+    ctx->batch_reserve = 0;
+    ret = cfstore_batch_compact(ctx);
+    if(ret < ARM_DRIVER_OK){
+        return ret;
+    }
+    /* release the spare capacity if the batch deleted most of the area */
+    return cfstore_realloc_ex(cfstore_ctx_get_kv_total_len(), NULL);
+}
+
 /* @brief  See definition in configuration_store.h for description. */
 static int32_t cfstore_initialise(ARM_CFSTORE_CALLBACK callback, void* client_context)
 {
@@ -3948,6 +4626,11 @@ static int32_t cfstore_initialise(ARM_CFSTORE_CALLBACK callback, void* client_co
         /* ctx->rw_area0_lock initialisation is not required here as the lock is statically initialised to 0 */
         ctx->area_0_head = NULL;
         ctx->area_0_tail = NULL;
+        cfstore_index_init(&ctx->index, cfstore_index_key);
+        ctx->area_0_len = 0;
+        ctx->batch_ref_count = 0;
+        ctx->batch_reserve = 0;
+        ctx->batch_deleted_size = 0;
 
         CFSTORE_ASSERT(sizeof(cfstore_file_t) == CFSTORE_HANDLE_BUFSIZE);
         if(sizeof(cfstore_file_t) != CFSTORE_HANDLE_BUFSIZE){
@@ -4045,7 +4728,12 @@ static int32_t cfstore_uninitialise(void)
             CFSTORE_FREE(ctx->area_0_head);
             ctx->area_0_head = NULL;
             ctx->area_0_tail = NULL;
+            ctx->area_0_len = 0;
         }
+        cfstore_index_deinit(&ctx->index);
+        ctx->batch_ref_count = 0;
+        ctx->batch_reserve = 0;
+        ctx->batch_deleted_size = 0;
     }
 out:
     /* notify client */
@@ -4264,6 +4952,33 @@ static int32_t cfstore_uvisor_write(ARM_CFSTORE_HANDLE hkey, const char* data, A
 	return secure_gateway(configuration_store, __cfstore_uvisor_write, hkey, data, len);
 }
 
+UVISOR_EXTERN int32_t __cfstore_uvisor_begin_batch(ARM_CFSTORE_SIZE size_hint)
+{
+    CFSTORE_FENTRYLOG("%s:entered\n", __func__);
+	return cfstore_begin_batch(size_hint);
+}
+
+static int32_t cfstore_uvisor_begin_batch(ARM_CFSTORE_SIZE size_hint)
+{
+    CFSTORE_FENTRYLOG("%s:entered\n", __func__);
+	return secure_gateway(configuration_store, __cfstore_uvisor_begin_batch, size_hint);
+}
+
+UVISOR_EXTERN int32_t __cfstore_uvisor_end_batch(int dummy)
+{
+    CFSTORE_FENTRYLOG("%s:entered\n", __func__);
+	(void) dummy;
+	return cfstore_end_batch();
+}
+
+static int32_t cfstore_uvisor_end_batch(void)
+{
+	int dummy = 0;
+
+    CFSTORE_FENTRYLOG("%s:entered\n", __func__);
+	return secure_gateway(configuration_store, __cfstore_uvisor_end_batch, dummy);
+}
+
 
 ARM_CFSTORE_DRIVER cfstore_driver =
 {
@@ -4284,6 +4999,8 @@ ARM_CFSTORE_DRIVER cfstore_driver =
         .Rseek = cfstore_uvisor_rseek,
         .Uninitialize = cfstore_uvisor_uninitialize,
         .Write = cfstore_uvisor_write,
+        .BeginBatch = cfstore_uvisor_begin_batch,
+        .EndBatch = cfstore_uvisor_end_batch,
 };
 
 #else
@@ -4308,6 +5025,8 @@ ARM_CFSTORE_DRIVER cfstore_driver =
         .Rseek = cfstore_rseek,
         .Uninitialize = cfstore_uninitialise,
         .Write = cfstore_write,
+        .BeginBatch = cfstore_begin_batch,
+        .EndBatch = cfstore_end_batch,
 };
 
 #endif /* YOTTA_CFG_CFSTORE_UVISOR */
@@ -0,0 +1,261 @@
+/*
+ * Copyright (c) 2006-2016, ARM Limited, All Rights Reserved
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __FLASH_JOURNAL_LOG_PRIVATE_H__
+#define __FLASH_JOURNAL_LOG_PRIVATE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include "flash-journal/flash_journal.h"
+
+static inline uint32_t logRoundUp_uint32(uint32_t N, uint32_t BOUNDARY) {
+    return ((((N) + (BOUNDARY) - 1) / (BOUNDARY)) * (BOUNDARY));
+}
+
+/* Size of every piece of metadata programmed into the ring: the head and use
+ * marker of a sector, and the head of a blob. Blobs are laid out at multiples
+ * of this size, and the program_unit of the MTD must divide it. */
+#define LOG_FLASH_JOURNAL_SIZEOF_METADATA 16
+
+/* Number of sectors to keep erased ahead of the log when the MTD operates
+ * asynchronously; these are erased in the background following a commit. */
+#ifndef LOG_FLASH_JOURNAL_SECTORS_ERASED_AHEAD
+#define LOG_FLASH_JOURNAL_SECTORS_ERASED_AHEAD 1
+#endif
+
+static const uint32_t LOG_FLASH_JOURNAL_INVALID_OFFSET               = 0xFFFFFFFFUL;
+static const uint32_t LOG_FLASH_JOURNAL_INVALID_NEXT_SEQUENCE_NUMBER = 0xFFFFFFFFUL;
+static const uint32_t LOG_FLASH_JOURNAL_BLOB_MAGIC                   = 0xCE0210B5UL;
+static const uint32_t LOG_FLASH_JOURNAL_SECTOR_HEAD_MAGIC            = 0xCE0215E5UL;
+static const uint32_t LOG_FLASH_JOURNAL_SECTOR_USE_MAGIC             = 0xCE021A5EUL;
+static const uint32_t LOG_FLASH_JOURNAL_HEADER_MAGIC                 = 0xCEA00A1FUL;
+static const uint32_t LOG_FLASH_JOURNAL_HEADER_VERSION               = 1;
+
+typedef enum {
+    LOG_JOURNAL_STATE_NOT_INITIALIZED,
+    LOG_JOURNAL_STATE_INITIALIZED,
+    LOG_JOURNAL_STATE_RESETING,
+    LOG_JOURNAL_STATE_LOGGING,
+    LOG_JOURNAL_STATE_READING,
+} LogFlashJournalState_t;
+
+/**
+ * Steps of a log() or commit() in progress. The state remains
+ * LOG_JOURNAL_STATE_LOGGING (with the step LOG_JOURNAL_STEP_BODY) between the
+ * log()s of a blob.
+ */
+typedef enum {
+    LOG_JOURNAL_STEP_RESERVE_HEAD, /**< reserve space for the head of a new blob, to be programmed upon commit. */
+    LOG_JOURNAL_STEP_SECTOR_USE,   /**< programming the use marker of the sector being entered by the log. */
+    LOG_JOURNAL_STEP_BODY,         /**< programming blob data. */
+    LOG_JOURNAL_STEP_COMMIT,       /**< setting up the head of the blob being committed. */
+    LOG_JOURNAL_STEP_BLOB_HEAD,    /**< programming the head of the blob being committed. */
+    LOG_JOURNAL_STEP_COMMITTED,
+} LogFlashJournalStep_t;
+
+/**
+ * Steps of the erase of a sector. Erases are carried out on behalf of log(),
+ * reset(), format(), and in the background.
+ */
+typedef enum {
+    LOG_JOURNAL_ERASE_STEP_NONE,
+    LOG_JOURNAL_ERASE_STEP_ERASING,
+    LOG_JOURNAL_ERASE_STEP_SECTOR_HEAD, /**< programming the sector head, which carries the erase count. */
+    LOG_JOURNAL_ERASE_STEP_DONE,
+} LogFlashJournalEraseStep_t;
+
+/**
+ * Meta-data placed at the head of a log-structured Journal.
+ */
+typedef struct _LogFlashJournalHeader {
+    FlashJournalHeader_t genericHeader; /** Generic meta-data placed at the head of a Journal; common to all journal types. */
+    uint32_t             magic;         /** Log journal header specific magic code. */
+    uint32_t             version;       /** Revision number for this log journal header. */
+    uint32_t             numSectors;    /** Number of sectors in the ring. */
+    uint32_t             sizeofSector;  /** Size of a sector; this is the erase unit of the MTD. */
+} LogFlashJournalHeader_t;
+
+/* The header is programmed as a whole, padded to a multiple of the program_unit. */
+#define LOG_FLASH_JOURNAL_SIZEOF_PROGRAMMED_HEADER \
+    (((sizeof(LogFlashJournalHeader_t) + LOG_FLASH_JOURNAL_SIZEOF_METADATA - 1) / LOG_FLASH_JOURNAL_SIZEOF_METADATA) * LOG_FLASH_JOURNAL_SIZEOF_METADATA)
+
+/**
+ * Meta-data programmed at the start of a sector right after it is erased.
+ *
+ * @note as with the other metadata, the magic is placed at the end so that a
+ *     partially programmed record won't be accepted as valid.
+ */
+typedef struct _LogFlashJournalSectorHead {
+    uint32_t eraseCount;     /**< number of times this sector has been erased. */
+    uint32_t reserved[2];
+    uint32_t magic;
+} LogFlashJournalSectorHead_t;
+
+/**
+ * Meta-data programmed following the sector head when the log enters the sector.
+ * A sector with a valid head and an erased use marker holds no data.
+ */
+typedef struct _LogFlashJournalSectorUse {
+    uint32_t sequenceNumber; /**< incremented for every sector entered by the log. */
+    uint32_t blobOffset;     /**< logical offset of the head of the blob being logged when the log entered this sector. */
+    uint32_t reserved;
+    uint32_t magic;
+} LogFlashJournalSectorUse_t;
+
+/**
+ * Meta-data placed ahead of the payload of a blob. Space for it is reserved
+ * when logging of a blob begins, and it is programmed upon commit.
+ */
+typedef struct _LogFlashJournalBlobHead {
+    uint32_t sizeofBlob;     /**< the size of the payload in this blob. */
+    uint32_t sequenceNumber;
+    uint32_t crc32;          /**< CRC32 of the payload followed by this head (with 'crc32' taken to be 0). */
+    uint32_t magic;
+} LogFlashJournalBlobHead_t;
+
+typedef union _LogFlashJournalMetadata {
+    LogFlashJournalSectorHead_t sectorHead;
+    LogFlashJournalSectorUse_t  sectorUse;
+    LogFlashJournalBlobHead_t   blobHead;
+    uint8_t                     octets[LOG_FLASH_JOURNAL_SIZEOF_METADATA];
+} LogFlashJournalMetadata_t;
+
+typedef char AssertLogJournalMetadataSize[sizeof(LogFlashJournalMetadata_t) == LOG_FLASH_JOURNAL_SIZEOF_METADATA ? 1 : -1];
+
+#define LOG_JOURNAL_VALID_SECTOR_HEAD(PTR) ((PTR)->magic == LOG_FLASH_JOURNAL_SECTOR_HEAD_MAGIC)
+#define LOG_JOURNAL_VALID_SECTOR_USE(PTR)  ((PTR)->magic == LOG_FLASH_JOURNAL_SECTOR_USE_MAGIC)
+#define LOG_JOURNAL_VALID_BLOB_HEAD(PTR)   ((PTR)->magic == LOG_FLASH_JOURNAL_BLOB_MAGIC)
+
+/**
+ * Offsets into the ring are 'logical': they run over the data area of the
+ * sectors (excluding the sector head and use marker), with sector 'N - 1'
+ * followed by sector 0.
+ */
+typedef struct _LogFlashJournal_t {
+    FlashJournal_Ops_t       ops;                      /**< the mandatory OPS table defining the strategy. */
+    FlashJournal_Callback_t  callback;                 /**< command completion callback. */
+    ARM_DRIVER_STORAGE      *mtd;                      /**< The underlying Memory-Technology-Device. */
+    uint64_t                 firstSectorAddr;          /**< storage address of sector 0. */
+    uint32_t                 numSectors;               /**< number of sectors in the ring. */
+    uint32_t                 sizeofSector;             /**< size of a sector; the erase unit. */
+    uint32_t                 programUnit;              /**< program_unit of the MTD. */
+    uint32_t                 sizeofJournaledBlob;      /**< size of the most recently committed blob. */
+    uint32_t                 nextSequenceNumber;       /**< sequence number of the next blob to be committed. */
+    uint32_t                 nextSectorSequenceNumber; /**< sequence number for the next sector entered by the log. */
+    uint32_t                 currentBlobOffset;        /**< offset of the most recently committed blob; LOG_FLASH_JOURNAL_INVALID_OFFSET if there is none. */
+    uint32_t                 writeOffset;              /**< offset at which the log continues. */
+    uint32_t                 writeSector;              /**< the sector most recently entered by the log. */
+    uint32_t                 numErasedSectors;         /**< number of sectors following writeSector which are known to be erased. */
+    uint32_t                 highestEraseCount;        /**< highest erase count of any sector; assumed for sectors whose head is lost. */
+    uint8_t                  state;                    /**< LogFlashJournalState_t. */
+    uint8_t                  prevCommand;              /**< FlashJournal_OpCode_t of the last command issued to the journal. */
+    uint8_t                  eraseStep;                /**< LogFlashJournalEraseStep_t of the sector erase in progress. */
+    uint8_t                  erasedValue        : 1;   /**< ARM_STORAGE_INFO::erased_value of the MTD. */
+    uint8_t                  asynchronous       : 1;   /**< ARM_STORAGE_CAPABILITIES::asynchronous_ops of the MTD. */
+    uint8_t                  backgroundErase    : 1;   /**< a sector is being erased in the background. */
+    uint8_t                  deferred           : 1;   /**< an operation is waiting for the background erase to finish. */
+    uint32_t                 eraseSector;              /**< sector being erased. */
+    uint32_t                 amountErased;             /**< amount of eraseSector erased so far. */
+    LogFlashJournalMetadata_t meta;                    /**< staging area for the metadata being programmed. */
+
+    /**
+     * The following is a union of sub-structures meant to keep state relevant
+     * to the commands during their execution.
+     */
+    union {
+        /** state relevant to logging of data. */
+        struct {
+            const uint8_t *dataBeingLogged; /**< temporary pointer aimed at the next data to be logged. */
+            uint32_t       sizeofChunk;     /**< size of the data passed to the ongoing log(). */
+            uint32_t       amountLeftToLog;
+            uint32_t       blobOffset;      /**< offset of the head reserved for the blob being logged. */
+            uint32_t       sizeofBlob;      /**< amount of the blob logged so far. */
+            uint32_t       crc32;           /**< CRC32 of the blob logged so far. */
+            uint8_t        step;            /**< LogFlashJournalStep_t. */
+            uint8_t        resumeStep;      /**< step to resume once the log has entered a new sector. */
+        } log;
+
+        /** state relevant to read-back of data. */
+        struct {
+            uint8_t       *dataBeingRead;   /**< temporary pointer aimed at the next data to be read-into. */
+            uint32_t       amountLeftToRead;
+            uint32_t       amountRead;
+            uint32_t       logicalOffset;   /**< the offset within the blob at which the next read will occur. */
+            uint8_t        verify;          /**< the blob is to be verified before it is read. */
+        } read;
+
+        /** state relevant to reset. */
+        struct {
+            uint32_t       sector;          /**< the next sector to be checked and erased if it isn't free. */
+        } reset;
+    };
+} LogFlashJournal_t;
+
+/**<
+ * A static assert to ensure that the size of LogFlashJournal_t is smaller than
+ * FlashJournal_t. The caller will only allocate a FlashJournal_t and expect the
+ * Log Strategy to reuse that space for a LogFlashJournal_t.
+ */
+typedef char AssertLogJournalSizeLessThanOrEqualToGenericJournal[sizeof(LogFlashJournal_t)<=sizeof(FlashJournal_t)?1:-1];
+
+#define LOG_SECTOR_ADDRESS(JOURNAL, INDEX) ((JOURNAL)->firstSectorAddr + ((uint64_t)(INDEX) * (JOURNAL)->sizeofSector))
+
+static inline uint32_t logSizeofSectorData(const LogFlashJournal_t *journal) {
+    return journal->sizeofSector - (2 * LOG_FLASH_JOURNAL_SIZEOF_METADATA);
+}
+static inline uint32_t logSizeofRing(const LogFlashJournal_t *journal) {
+    return journal->numSectors * logSizeofSectorData(journal);
+}
+static inline uint32_t logSectorOf(const LogFlashJournal_t *journal, uint32_t offset) {
+    return offset / logSizeofSectorData(journal);
+}
+static inline uint32_t logSectorStart(const LogFlashJournal_t *journal, uint32_t sector) {
+    return sector * logSizeofSectorData(journal);
+}
+static inline uint32_t logNextSector(const LogFlashJournal_t *journal, uint32_t sector) {
+    return ((sector + 1) == journal->numSectors) ? 0 : (sector + 1);
+}
+/* number of sectors to move forward from 'from' to reach 'to' */
+static inline uint32_t logSectorDistance(const LogFlashJournal_t *journal, uint32_t from, uint32_t to) {
+    return (to >= from) ? (to - from) : (to + journal->numSectors - from);
+}
+static inline uint32_t logAdvance(const LogFlashJournal_t *journal, uint32_t offset, uint32_t amount) {
+    return (uint32_t)(((uint64_t)offset + amount) % logSizeofRing(journal));
+}
+static inline uint32_t logAmountLeftInSector(const LogFlashJournal_t *journal, uint32_t offset) {
+    return logSizeofSectorData(journal) - (offset % logSizeofSectorData(journal));
+}
+static inline uint64_t logPhysicalAddress(const LogFlashJournal_t *journal, uint32_t offset) {
+    return LOG_SECTOR_ADDRESS(journal, logSectorOf(journal, offset)) +
+           (2 * LOG_FLASH_JOURNAL_SIZEOF_METADATA) + (offset % logSizeofSectorData(journal));
+}
+/* space taken up in the ring by a blob of the given size, including its head */
+static inline uint32_t logBlobFootprint(uint32_t sizeofBlob) {
+    return LOG_FLASH_JOURNAL_SIZEOF_METADATA + logRoundUp_uint32(sizeofBlob, LOG_FLASH_JOURNAL_SIZEOF_METADATA);
+}
+/* The largest blob; two such blobs need to fit in the ring together with a sector's worth of slack. */
+static inline uint32_t logCapacity(const LogFlashJournal_t *journal) {
+    return ((journal->numSectors - 1) / 2) * logSizeofSectorData(journal) - LOG_FLASH_JOURNAL_SIZEOF_METADATA;
+}
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif /* __FLASH_JOURNAL_LOG_PRIVATE_H__ */
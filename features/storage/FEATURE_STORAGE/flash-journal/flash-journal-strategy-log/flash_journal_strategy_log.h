@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2006-2016, ARM Limited, All Rights Reserved
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __FLASH_JOURNAL_STRATEGY_LOG_H__
+#define __FLASH_JOURNAL_STRATEGY_LOG_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include "flash-journal/flash_journal.h"
+
+/**
+ * Create/format a log-structured flash journal on a storage device.
+ *
+ * The log-structured journal treats the storage following the journal header
+ * as a ring of sectors, each the size of an erase unit. Every committed blob
+ * is appended to the ring right after the previous one, so a small blob only
+ * consumes as much of a sector as it needs; a sector is erased only once the
+ * log has come all the way around the ring back to it. Sectors are therefore
+ * erased in turn, and each sector keeps a count of the number of times it has
+ * been erased (see flashJournalStrategyLog_getEraseCounts()).
+ *
+ * When the underlying MTD executes operations asynchronously, the sector
+ * following the log is erased in the background once a commit has
+ * completed. Operations requested while the background erase is in progress
+ * are started once it finishes, and complete through the callback.
+ *
+ * This function must be called *once* for each incarnation of a log-structured
+ * journal. It erases every sector of the ring.
+ *
+ * @param[in] mtd
+ *              The underlying Storage driver. Its storage blocks are expected
+ *              to share a single erase unit, and the program unit should
+ *              divide 16.
+ *
+ * @param[in] callback
+ *                Caller-defined callback to be invoked upon command completion
+ *                in case the storage device executes operations asynchronously.
+ *                Use a NULL pointer when no callback signals are required.
+ *
+ * @note: this is an asynchronous operation, but it can finish
+ * synchronously if the underlying MTD supports that.
+ *
+ * @return
+ *   The function executes in the following ways:
+ *   - When the operation is asynchronous, the function only starts the
+ *     format and control returns to the caller with an
+ *     JOURNAL_STATUS_OK before the actual completion of the operation (or with
+ *     an appropriate error code in case of failure). When the operation is
+ *     completed the command callback is invoked with 1 passed in as the
+ *     'status' parameter of the callback. In case of errors, the completion
+ *     callback is invoked with an error status.
+ *   - When the operation is executed by the journal in a blocking (i.e.
+ *     synchronous) manner, control returns to the caller only upon the actual
+ *     completion of the operation or the discovery of a failure condition. In
+ *     this case, the function returns 1 to signal successful synchronous
+ *     completion or an appropriate error code, and no further
+ *     invocation of the completion callback should be expected at a later time.
+ *
+ *     +-------------------------------+    ^
+ *     |                               |    |
+ *     |  Journal Header               |    |
+ *     |  starts with generic header   |    |   multiple of program_unit
+ *     |  followed by specific header  |    |   and erase-boundary
+ *     |                               |    |
+ *     +-------------------------------+    v
+ *     +-------------------------------+
+ *     | sector head: erase count      |    ^
+ *     | sector use: sequence number,  |    |
+ *     |   offset of the blob spanning |    |
+ *     |   into the sector             |    |     sector 0
+ *     |                               |    |     one erase unit
+ *     | [blob head][BLOB0       ]     |    |
+ *     | [blob head][BLOB1][blob head] |    |
+ *     +-------------------------------+    v
+ *     +-------------------------------+
+ *     | sector head                   |    ^
+ *     | sector use                    |    |     sector 1
+ *     | [BLOB2 (continued)      ]     |    |
+ *     | [blob head][BLOB3 ]           |    |
+ *     .                               .    .
+ *     .                               .    .
+ *     +-------------------------------+
+ *     | sector head                   |          sector 'N - 1'; followed by sector 0
+ *     | (erased)                      |
+ *     +-------------------------------+
+ *
+ * The head of a blob is only programmed once the blob is committed, so an
+ * uncommitted blob is never mistaken for a valid one.
+ */
+int32_t               flashJournalStrategyLog_format(ARM_DRIVER_STORAGE      *mtd,
+                                                     FlashJournal_Callback_t  callback);
+
+int32_t               flashJournalStrategyLog_initialize(FlashJournal_t           *journal,
+                                                         ARM_DRIVER_STORAGE       *mtd,
+                                                         const FlashJournal_Ops_t *ops,
+                                                         FlashJournal_Callback_t   callback);
+FlashJournal_Status_t flashJournalStrategyLog_getInfo(FlashJournal_t *journal, FlashJournal_Info_t *info);
+int32_t               flashJournalStrategyLog_read(FlashJournal_t *journal, void *blob, size_t n);
+int32_t               flashJournalStrategyLog_readFrom(FlashJournal_t *journal, size_t offset, void *blob, size_t n);
+int32_t               flashJournalStrategyLog_log(FlashJournal_t *journal, const void *blob, size_t n);
+int32_t               flashJournalStrategyLog_commit(FlashJournal_t *journal);
+int32_t               flashJournalStrategyLog_reset(FlashJournal_t *journal);
+
+/**
+ * Fetch the number of times each sector of an initialized log-structured
+ * journal has been erased. A sector whose head has been lost (for instance to
+ * an erase interrupted by a power failure) reports 0.
+ *
+ * @param[in]  journal
+ *               A previously initialized log-structured journal.
+ * @param[out] eraseCounts
+ *               Caller-allocated array to be filled in with the erase count of
+ *               each sector, in ring order.
+ * @param[in]  numCounts
+ *               The number of entries in 'eraseCounts'. Only as many sectors
+ *               are reported.
+ *
+ * @return the number of sectors in the ring, or an appropriate error code.
+ *
+ * @note This API returns synchronously, and isn't expected to be called while
+ *     an asynchronous operation is pending.
+ */
+int32_t               flashJournalStrategyLog_getEraseCounts(FlashJournal_t *journal, uint32_t *eraseCounts, uint32_t numCounts);
+
+static const FlashJournal_Ops_t FLASH_JOURNAL_STRATEGY_LOG = {
+    flashJournalStrategyLog_initialize,
+    flashJournalStrategyLog_getInfo,
+    flashJournalStrategyLog_read,
+    flashJournalStrategyLog_readFrom,
+    flashJournalStrategyLog_log,
+    flashJournalStrategyLog_commit,
+    flashJournalStrategyLog_reset
+};
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif /* __FLASH_JOURNAL_STRATEGY_LOG_H__ */
@@ -0,0 +1,496 @@
+/*
+ * Copyright (c) 2006-2016, ARM Limited, All Rights Reserved
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flash-journal-strategy-log/flash_journal_log_private.h"
+#include "flash-journal-strategy-log/flash_journal_strategy_log.h"
+#include "support_funcs.h"
+#include <string.h>
+#include <stdio.h>
+
+LogFlashJournal_t *activeLogJournal;
+
+/*
+ * forward declarations of static-inline helper functions.
+ */
+static inline int32_t flashJournalStrategyLog_format_sanityChecks(ARM_DRIVER_STORAGE *mtd, uint32_t *sizeofSectorP);
+static inline int32_t flashJournalStrategyLog_read_sanityChecks(LogFlashJournal_t *journal, const void *blob, size_t sizeofBlob);
+static inline int32_t flashJournalStrategyLog_log_sanityChecks(LogFlashJournal_t *journal, const void *blob, size_t sizeofBlob);
+static inline int32_t flashJournalStrategyLog_commit_sanityChecks(LogFlashJournal_t *journal);
+static inline int32_t flashJournalStrategyLog_progress(LogFlashJournal_t *journal);
+
+
+int32_t flashJournalStrategyLog_format(ARM_DRIVER_STORAGE      *mtd,
+                                       FlashJournal_Callback_t  callback)
+{
+    int32_t rc;
+    uint32_t sizeofSector;
+    if ((rc = flashJournalStrategyLog_format_sanityChecks(mtd, &sizeofSector)) != JOURNAL_STATUS_OK) {
+        return rc;
+    }
+
+    ARM_STORAGE_INFO mtdInfo;
+    if (mtd->GetInfo(&mtdInfo) < ARM_DRIVER_OK) {
+        return JOURNAL_STATUS_STORAGE_API_ERROR;
+    }
+    uint64_t mtdAddr;
+    if (logJournalMtdGetStartAddr(mtd, &mtdAddr) < JOURNAL_STATUS_OK) {
+        return JOURNAL_STATUS_STORAGE_API_ERROR;
+    }
+
+    memset(logFormatInfoSingleton.programmedHeader, 0, sizeof(logFormatInfoSingleton.programmedHeader));
+    if ((rc = setupLogJournalHeader(&logFormatInfoSingleton.header, mtd, mtdInfo.total_storage, sizeofSector)) != JOURNAL_STATUS_OK) {
+        return rc;
+    }
+
+    logFormatInfoSingleton.callback     = callback;
+    logFormatInfoSingleton.mtdAddr      = mtdAddr;
+    logFormatInfoSingleton.amountErased = 0;
+    logFormatInfoSingleton.phase        = LOG_JOURNAL_FORMAT_ERASING_HEADER;
+
+    /* The sectors are erased through the reset machinery of a journal set up
+     * to match the header being created. */
+    LogFlashJournal_t *journal = &logFormatInfoSingleton.journal;
+    memset(journal, 0, sizeof(LogFlashJournal_t));
+    journal->mtd              = mtd;
+    journal->callback         = callback;
+    journal->firstSectorAddr  = mtdAddr + logFormatInfoSingleton.header.genericHeader.journalOffset;
+    journal->numSectors       = logFormatInfoSingleton.header.numSectors;
+    journal->sizeofSector     = sizeofSector;
+    journal->programUnit      = (mtdInfo.program_unit > 0) ? mtdInfo.program_unit : 1;
+    journal->erasedValue      = mtdInfo.erased_value;
+    journal->asynchronous     = mtd->GetCapabilities().asynchronous_ops;
+    journal->writeSector      = journal->numSectors - 1;
+    journal->eraseStep        = LOG_JOURNAL_ERASE_STEP_NONE;
+    journal->state            = LOG_JOURNAL_STATE_RESETING;
+    journal->prevCommand      = FLASH_JOURNAL_OPCODE_FORMAT;
+    journal->reset.sector     = 0;
+
+    /* initialize MTD */
+    rc = mtd->Initialize(logJournalFormatHandler);
+    if (rc < ARM_DRIVER_OK) {
+        return JOURNAL_STATUS_STORAGE_API_ERROR;
+    } else if (rc == ARM_DRIVER_OK) {
+        return JOURNAL_STATUS_OK; /* An asynchronous operation is pending; it will result in a completion callback
+                                   * where the rest of processing will take place. */
+    }
+    if (rc != 1) {
+        return JOURNAL_STATUS_STORAGE_API_ERROR; /* synchronous completion is expected to return 1 */
+    }
+
+    /* progress the rest of the create state-machine */
+    return flashJournalStrategyLog_format_progress();
+}
+
+/**
+ * Validate a header at the start of the MTD.
+ *
+ * @param [in/out] headerP
+ *                     Caller-allocated header which gets filled in during validation.
+
+ * @return JOURNAL_STATUS_OK if the header is sane. As a side-effect, the memory
+ *         pointed to by 'headerP' is initialized with the header.
+ */
+static int32_t readAndVerifyLogJournalHeader(ARM_DRIVER_STORAGE *mtd, uint64_t mtdAddr, LogFlashJournalHeader_t *headerP)
+{
+    int32_t rc = mtd->ReadData(mtdAddr, headerP, sizeof(LogFlashJournalHeader_t));
+    if (rc < ARM_DRIVER_OK) {
+        return JOURNAL_STATUS_STORAGE_IO_ERROR;
+    } else if (rc != sizeof(LogFlashJournalHeader_t)) {
+        return JOURNAL_STATUS_ERROR; /* TODO: handle init with pending asynchronous activity. */
+    }
+
+    if ((headerP->genericHeader.magic        != FLASH_JOURNAL_HEADER_MAGIC)      ||
+        (headerP->genericHeader.version      != FLASH_JOURNAL_HEADER_VERSION)    ||
+        (headerP->genericHeader.sizeofHeader != sizeof(LogFlashJournalHeader_t)) ||
+        (headerP->magic                      != LOG_FLASH_JOURNAL_HEADER_MAGIC)  ||
+        (headerP->version                    != LOG_FLASH_JOURNAL_HEADER_VERSION)) {
+        return JOURNAL_STATUS_NOT_FORMATTED;
+    }
+
+    if (logJournalHeaderChecksum(headerP) != headerP->genericHeader.checksum) {
+        return JOURNAL_STATUS_METADATA_ERROR;
+    }
+
+    /* the geometry of the ring */
+    if ((headerP->numSectors < 3)                                                      ||
+        (headerP->sizeofSector <= (3 * LOG_FLASH_JOURNAL_SIZEOF_METADATA))             ||
+        ((headerP->sizeofSector % LOG_FLASH_JOURNAL_SIZEOF_METADATA) != 0)             ||
+        (((uint64_t)headerP->numSectors * headerP->sizeofSector) > 0x7FFFFFFFUL)       ||
+        (headerP->genericHeader.totalSize != (headerP->genericHeader.journalOffset +
+                                              ((uint64_t)headerP->numSectors * headerP->sizeofSector)))) {
+        return JOURNAL_STATUS_METADATA_ERROR;
+    }
+
+    return JOURNAL_STATUS_OK;
+}
+
+int32_t flashJournalStrategyLog_initialize(FlashJournal_t           *_journal,
+                                           ARM_DRIVER_STORAGE       *mtd,
+                                           const FlashJournal_Ops_t *ops,
+                                           FlashJournal_Callback_t   callback)
+{
+    int32_t rc;
+
+    /* initialize MTD */
+    rc = mtd->Initialize(logJournalMtdHandler);
+    if (rc < ARM_DRIVER_OK) {
+        memset(_journal, 0, sizeof(FlashJournal_t));
+        return JOURNAL_STATUS_STORAGE_API_ERROR;
+    }
+    if (rc == ARM_DRIVER_OK) {
+        ARM_STORAGE_CAPABILITIES mtdCaps = mtd->GetCapabilities();
+        if (!mtdCaps.asynchronous_ops) {
+            return JOURNAL_STATUS_ERROR; /* asynchronous_ops must be set if MTD returns ARM_DRIVER_OK. */
+        }
+
+        return JOURNAL_STATUS_ERROR; /* TODO: handle init with pending asynchronous activity. */
+    }
+
+    LogFlashJournal_t *journal;
+    activeLogJournal = journal = (LogFlashJournal_t *)_journal;
+    journal->state             = LOG_JOURNAL_STATE_NOT_INITIALIZED;
+    journal->mtd               = mtd;
+
+    uint64_t mtdAddr;
+    if ((rc = logJournalMtdGetStartAddr(mtd, &mtdAddr)) != JOURNAL_STATUS_OK) {
+        return rc;
+    }
+    ARM_STORAGE_INFO mtdInfo;
+    if ((rc = mtd->GetInfo(&mtdInfo)) != ARM_DRIVER_OK) {
+        return JOURNAL_STATUS_STORAGE_API_ERROR;
+    }
+
+    LogFlashJournalHeader_t journalHeader;
+    if ((rc = readAndVerifyLogJournalHeader(mtd, mtdAddr, &journalHeader)) != JOURNAL_STATUS_OK) {
+        return rc;
+    }
+    if (journalHeader.genericHeader.totalSize > mtdInfo.total_storage) {
+        /* the journal was formatted for a larger storage volume */
+        return JOURNAL_STATUS_NOT_FORMATTED;
+    }
+
+    /* initialize the journal structure */
+    memcpy(&journal->ops, ops, sizeof(FlashJournal_Ops_t));
+    journal->callback        = callback;
+    journal->firstSectorAddr = mtdAddr + journalHeader.genericHeader.journalOffset;
+    journal->numSectors      = journalHeader.numSectors;
+    journal->sizeofSector    = journalHeader.sizeofSector;
+    journal->programUnit     = (mtdInfo.program_unit > 0) ? mtdInfo.program_unit : 1;
+    journal->erasedValue     = mtdInfo.erased_value;
+    journal->asynchronous    = mtd->GetCapabilities().asynchronous_ops;
+    journal->backgroundErase = 0;
+    journal->deferred        = 0;
+    journal->eraseStep       = LOG_JOURNAL_ERASE_STEP_NONE;
+    journal->prevCommand     = FLASH_JOURNAL_OPCODE_INITIALIZE;
+    if ((LOG_FLASH_JOURNAL_SIZEOF_METADATA % journal->programUnit) != 0) {
+        return JOURNAL_STATUS_PARAMETER;
+    }
+
+    if ((rc = logJournalDiscoverLatestLoggedBlob(journal)) != JOURNAL_STATUS_OK) {
+        return rc;
+    }
+    journal->state = LOG_JOURNAL_STATE_INITIALIZED;
+
+    return 1; /* synchronous completion */
+}
+
+FlashJournal_Status_t flashJournalStrategyLog_getInfo(FlashJournal_t *_journal, FlashJournal_Info_t *infoP)
+{
+    LogFlashJournal_t *journal;
+    activeLogJournal = journal = (LogFlashJournal_t *)_journal;
+
+    infoP->capacity            = logCapacity(journal);
+    infoP->program_unit        = journal->programUnit;
+    infoP->sizeofJournaledBlob = journal->sizeofJournaledBlob;
+    return JOURNAL_STATUS_OK;
+}
+
+int32_t flashJournalStrategyLog_read(FlashJournal_t *_journal, void *blob, size_t sizeofBlob)
+{
+    LogFlashJournal_t *journal;
+    activeLogJournal = journal = (LogFlashJournal_t *)_journal;
+
+    if (journal->prevCommand != FLASH_JOURNAL_OPCODE_READ_BLOB) {
+        journal->read.logicalOffset = 0;
+    }
+
+    int32_t rc;
+    if ((rc = flashJournalStrategyLog_read_sanityChecks(journal, blob, sizeofBlob)) != JOURNAL_STATUS_OK) {
+        return rc;
+    }
+
+    /* Establish the sanity of the blob at the start of a read sequence. */
+    journal->read.verify           = (journal->read.logicalOffset == 0);
+    journal->read.dataBeingRead    = blob;
+    journal->read.amountRead       = 0;
+    journal->read.amountLeftToRead = ((journal->sizeofJournaledBlob - journal->read.logicalOffset) < sizeofBlob) ?
+                                        (journal->sizeofJournaledBlob - journal->read.logicalOffset) : sizeofBlob;
+
+    journal->state       = LOG_JOURNAL_STATE_READING;
+    journal->prevCommand = FLASH_JOURNAL_OPCODE_READ_BLOB;
+    return flashJournalStrategyLog_progress(journal);
+}
+
+int32_t flashJournalStrategyLog_readFrom(FlashJournal_t *_journal, size_t offset, void *blob, size_t sizeofBlob)
+{
+    LogFlashJournal_t *journal;
+    activeLogJournal = journal = (LogFlashJournal_t *)_journal;
+
+    journal->read.logicalOffset = offset;
+    int32_t rc;
+    if ((rc = flashJournalStrategyLog_read_sanityChecks(journal, blob, sizeofBlob)) != JOURNAL_STATUS_OK) {
+        return rc;
+    }
+
+    journal->read.verify           = 0; /* only reads of the entire blob are verified */
+    journal->read.dataBeingRead    = blob;
+    journal->read.amountRead       = 0;
+    journal->read.amountLeftToRead = ((journal->sizeofJournaledBlob - journal->read.logicalOffset) < sizeofBlob) ?
+                                        (journal->sizeofJournaledBlob - journal->read.logicalOffset) : sizeofBlob;
+
+    journal->state       = LOG_JOURNAL_STATE_READING;
+    journal->prevCommand = FLASH_JOURNAL_OPCODE_READ_BLOB;
+    return flashJournalStrategyLog_progress(journal);
+}
+
+int32_t flashJournalStrategyLog_log(FlashJournal_t *_journal, const void *blob, size_t size)
+{
+    LogFlashJournal_t *journal;
+    activeLogJournal = journal = (LogFlashJournal_t *)_journal;
+
+    int32_t rc;
+    if ((rc = flashJournalStrategyLog_log_sanityChecks(journal, blob, size)) != JOURNAL_STATUS_OK) {
+        return rc;
+    }
+
+    if (journal->state == LOG_JOURNAL_STATE_INITIALIZED) {
+        /* This is the first log in the sequence; the new blob follows the previous one. */
+        journal->log.blobOffset = journal->writeOffset;
+        journal->log.sizeofBlob = 0;
+        journal->log.crc32      = 0;
+        journal->log.step       = LOG_JOURNAL_STEP_RESERVE_HEAD;
+        journal->state          = LOG_JOURNAL_STATE_LOGGING;
+    }
+    journal->log.dataBeingLogged = (const uint8_t *)blob;
+    journal->log.sizeofChunk     = size;
+    journal->log.amountLeftToLog = size;
+
+    journal->prevCommand = FLASH_JOURNAL_OPCODE_LOG_BLOB;
+    return flashJournalStrategyLog_progress(journal);
+}
+
+int32_t flashJournalStrategyLog_commit(FlashJournal_t *_journal)
+{
+    LogFlashJournal_t *journal;
+    activeLogJournal = journal = (LogFlashJournal_t *)_journal;
+
+    int32_t rc;
+    if ((rc = flashJournalStrategyLog_commit_sanityChecks(journal)) != JOURNAL_STATUS_OK) {
+        return rc;
+    }
+
+    if (journal->state == LOG_JOURNAL_STATE_LOGGING) {
+        journal->log.step = LOG_JOURNAL_STEP_COMMIT;
+    } else {
+        /* commit without a preceding log() results in an empty blob. */
+        journal->log.blobOffset = journal->writeOffset;
+        journal->log.sizeofBlob = 0;
+        journal->log.crc32      = 0;
+        journal->log.step       = LOG_JOURNAL_STEP_RESERVE_HEAD;
+        journal->state          = LOG_JOURNAL_STATE_LOGGING;
+    }
+
+    journal->prevCommand = FLASH_JOURNAL_OPCODE_COMMIT;
+    return flashJournalStrategyLog_progress(journal);
+}
+
+int32_t flashJournalStrategyLog_reset(FlashJournal_t *_journal)
+{
+    LogFlashJournal_t *journal;
+    activeLogJournal = journal = (LogFlashJournal_t *)_journal;
+
+    if (journal->state == LOG_JOURNAL_STATE_NOT_INITIALIZED) {
+        return JOURNAL_STATUS_NOT_INITIALIZED;
+    }
+
+    journal->state        = LOG_JOURNAL_STATE_RESETING;
+    journal->reset.sector = 0;
+
+    journal->prevCommand = FLASH_JOURNAL_OPCODE_RESET;
+    return flashJournalStrategyLog_progress(journal);
+}
+
+int32_t flashJournalStrategyLog_getEraseCounts(FlashJournal_t *_journal, uint32_t *eraseCounts, uint32_t numCounts)
+{
+    LogFlashJournal_t *journal = (LogFlashJournal_t *)_journal;
+
+    if ((journal == NULL) || ((eraseCounts == NULL) && (numCounts > 0))) {
+        return JOURNAL_STATUS_PARAMETER;
+    }
+    if (journal->state == LOG_JOURNAL_STATE_NOT_INITIALIZED) {
+        return JOURNAL_STATUS_NOT_INITIALIZED;
+    }
+    if (journal->backgroundErase) {
+        return JOURNAL_STATUS_BUSY;
+    }
+
+    for (uint32_t sector = 0; (sector < numCounts) && (sector < journal->numSectors); sector++) {
+        LogFlashJournalSectorHead_t head;
+        /* TODO: add support for asynchronous read */
+        if (journal->mtd->ReadData(LOG_SECTOR_ADDRESS(journal, sector), &head, sizeof(head)) != sizeof(head)) {
+            return JOURNAL_STATUS_STORAGE_IO_ERROR;
+        }
+        eraseCounts[sector] = LOG_JOURNAL_VALID_SECTOR_HEAD(&head) ? head.eraseCount : 0;
+    }
+
+    return journal->numSectors;
+}
+
+/**
+ * Progress the operation which has just been set up by one of the APIs above.
+ * If a sector is being erased in the background, the operation is deferred
+ * until the erase finishes; it is then started from the MTD's completion
+ * callback.
+ */
+int32_t flashJournalStrategyLog_progress(LogFlashJournal_t *journal)
+{
+    if (journal->backgroundErase) {
+        journal->deferred = 1;
+        return JOURNAL_STATUS_OK;
+    }
+
+    int32_t rc = logJournal_progress(journal);
+    if ((rc < JOURNAL_STATUS_OK) && (rc != JOURNAL_STATUS_SMALL_LOG_REQUEST)) {
+        logJournalAbort(journal); /* reset journal state to allow further operation. */
+    }
+    return rc;
+}
+
+int32_t flashJournalStrategyLog_format_sanityChecks(ARM_DRIVER_STORAGE *mtd, uint32_t *sizeofSectorP)
+{
+    /*
+     * basic parameter checking
+     */
+    if (mtd == NULL) {
+        return JOURNAL_STATUS_PARAMETER;
+    }
+
+    ARM_STORAGE_INFO mtdInfo;
+    if (mtd->GetInfo(&mtdInfo) < ARM_DRIVER_OK) {
+        return JOURNAL_STATUS_STORAGE_API_ERROR;
+    }
+    if (mtdInfo.total_storage == 0) {
+        return JOURNAL_STATUS_STORAGE_API_ERROR;
+    }
+
+    uint64_t mtdAddr;
+    if (logJournalMtdGetStartAddr(mtd, &mtdAddr) < JOURNAL_STATUS_OK) {
+        return JOURNAL_STATUS_STORAGE_API_ERROR;
+    }
+    ARM_STORAGE_BLOCK firstBlock;
+    ARM_STORAGE_BLOCK lastBlock;
+    if (mtd->GetBlock(mtdAddr, &firstBlock) < ARM_DRIVER_OK) { /* check validity of journal's start address */
+        return JOURNAL_STATUS_PARAMETER;
+    }
+    if (mtd->GetBlock(mtdAddr + mtdInfo.total_storage - 1, &lastBlock) < ARM_DRIVER_OK) { /* check validity of the journal's end address */
+        return JOURNAL_STATUS_PARAMETER;
+    }
+
+    /* Sectors are erase units, so the storage needs to have a uniform erase unit. */
+    uint32_t sizeofSector = firstBlock.attributes.erase_unit;
+    if ((sizeofSector == 0) || (lastBlock.attributes.erase_unit != sizeofSector)) {
+        return JOURNAL_STATUS_PARAMETER;
+    }
+    if ((mtdAddr % sizeofSector) != 0) { /* ensure that the journal starts at an erase-boundary */
+        return JOURNAL_STATUS_PARAMETER;
+    }
+    if (((sizeofSector % LOG_FLASH_JOURNAL_SIZEOF_METADATA) != 0) || (sizeofSector <= (3 * LOG_FLASH_JOURNAL_SIZEOF_METADATA))) {
+        return JOURNAL_STATUS_PARAMETER;
+    }
+    if ((mtdInfo.program_unit > 0) && ((LOG_FLASH_JOURNAL_SIZEOF_METADATA % mtdInfo.program_unit) != 0)) {
+        return JOURNAL_STATUS_PARAMETER;
+    }
+
+    *sizeofSectorP = sizeofSector;
+    return JOURNAL_STATUS_OK;
+}
+
+int32_t flashJournalStrategyLog_read_sanityChecks(LogFlashJournal_t *journal, const void *blob, size_t sizeofBlob)
+{
+    if ((journal == NULL) || (blob == NULL) || (sizeofBlob == 0)) {
+        return JOURNAL_STATUS_PARAMETER;
+    }
+    if (journal->state == LOG_JOURNAL_STATE_NOT_INITIALIZED) {
+        return JOURNAL_STATUS_NOT_INITIALIZED;
+    }
+    if (journal->state != LOG_JOURNAL_STATE_INITIALIZED) {
+        return JOURNAL_STATUS_ERROR; /* journal is in an un-expected state. */
+    }
+    if ((journal->sizeofJournaledBlob == 0) || (journal->read.logicalOffset >= journal->sizeofJournaledBlob)) {
+        journal->read.logicalOffset = 0;
+        return JOURNAL_STATUS_EMPTY;
+    }
+
+    return JOURNAL_STATUS_OK;
+}
+
+int32_t flashJournalStrategyLog_log_sanityChecks(LogFlashJournal_t *journal, const void *blob, size_t sizeofBlob)
+{
+    if ((journal == NULL) || (blob == NULL) || (sizeofBlob == 0)) {
+        return JOURNAL_STATUS_PARAMETER;
+    }
+    if (journal->state == LOG_JOURNAL_STATE_NOT_INITIALIZED) {
+        return JOURNAL_STATUS_NOT_INITIALIZED;
+    }
+    if ((journal->state != LOG_JOURNAL_STATE_INITIALIZED) && (journal->state != LOG_JOURNAL_STATE_LOGGING)) {
+        return JOURNAL_STATUS_ERROR; /* journal is in an un-expected state. */
+    }
+    if ((journal->state == LOG_JOURNAL_STATE_LOGGING) && (journal->log.step != LOG_JOURNAL_STEP_BODY)) {
+        return JOURNAL_STATUS_ERROR; /* an operation is still in progress. */
+    }
+
+    uint32_t amountLogged = (journal->state == LOG_JOURNAL_STATE_LOGGING) ? journal->log.sizeofBlob : 0;
+    if (sizeofBlob > (logCapacity(journal) - amountLogged)) {
+        return JOURNAL_STATUS_BOUNDED_CAPACITY; /* adding this log chunk would cause us to exceed capacity. */
+    }
+
+    /* ensure that the request is at least as large as the minimum program unit */
+    if (sizeofBlob < journal->programUnit) {
+        return JOURNAL_STATUS_SMALL_LOG_REQUEST;
+    }
+
+    return JOURNAL_STATUS_OK;
+}
+
+int32_t flashJournalStrategyLog_commit_sanityChecks(LogFlashJournal_t *journal)
+{
+    if (journal == NULL) {
+        return JOURNAL_STATUS_PARAMETER;
+    }
+    if (journal->state == LOG_JOURNAL_STATE_NOT_INITIALIZED) {
+        return JOURNAL_STATUS_NOT_INITIALIZED;
+    }
+    if ((journal->state != LOG_JOURNAL_STATE_INITIALIZED) && (journal->state != LOG_JOURNAL_STATE_LOGGING)) {
+        return JOURNAL_STATUS_ERROR; /* journal is in an un-expected state. */
+    }
+    if ((journal->state == LOG_JOURNAL_STATE_LOGGING) &&
+        ((journal->prevCommand != FLASH_JOURNAL_OPCODE_LOG_BLOB) || (journal->log.step != LOG_JOURNAL_STEP_BODY))) {
+        return JOURNAL_STATUS_ERROR; /* an operation is still in progress. */
+    }
+
+    return JOURNAL_STATUS_OK;
+}
@@ -0,0 +1,969 @@
+/*
+ * Copyright (c) 2006-2016, ARM Limited, All Rights Reserved
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flash-journal-strategy-sequential/flash_journal_crc.h"
+#include "support_funcs.h"
+#include <string.h>
+#include <stdio.h>
+
+struct LogFormatInfo_t logFormatInfoSingleton;
+
+/* granularity of the synchronous reads used to verify and scan the ring */
+#define LOG_JOURNAL_SCRATCH_SIZE 64
+
+int32_t logJournalMtdGetStartAddr(ARM_DRIVER_STORAGE *mtd, uint64_t *startAddrP)
+{
+    ARM_STORAGE_BLOCK mtdBlock;
+    if ((mtd->GetNextBlock(NULL, &mtdBlock)) != ARM_DRIVER_OK) {
+        return JOURNAL_STATUS_STORAGE_API_ERROR;
+    }
+    if (!ARM_STORAGE_VALID_BLOCK(&mtdBlock)) {
+        return JOURNAL_STATUS_ERROR;
+    }
+
+    *startAddrP = mtdBlock.addr;
+    return JOURNAL_STATUS_OK;
+}
+
+int32_t logJournalMapStorageError(int32_t rc)
+{
+    /* Map integrity failures reported by the Storage driver appropriately. */
+    if (rc == ARM_STORAGE_ERROR_RUNTIME_OR_INTEGRITY_FAILURE) {
+        return JOURNAL_STATUS_STORAGE_RUNTIME_OR_INTEGRITY_FAILURE;
+    }
+    return JOURNAL_STATUS_STORAGE_IO_ERROR;
+}
+
+uint32_t logJournalHeaderChecksum(const LogFlashJournalHeader_t *headerP)
+{
+    /* The checksum field needs to contain 0 before CRC32 can be computed over the header. */
+    LogFlashJournalHeader_t header = *headerP;
+    header.genericHeader.checksum = 0;
+
+    return flashJournalCrcUpdate(0, (const unsigned char *)&header, sizeof(LogFlashJournalHeader_t));
+}
+
+int32_t setupLogJournalHeader(LogFlashJournalHeader_t *headerP, ARM_DRIVER_STORAGE *mtd, uint64_t totalSize, uint32_t sizeofSector)
+{
+    ARM_STORAGE_INFO mtdInfo;
+    if (mtd->GetInfo(&mtdInfo) < ARM_DRIVER_OK) {
+        return JOURNAL_STATUS_STORAGE_API_ERROR;
+    }
+
+    memset(headerP, 0, sizeof(LogFlashJournalHeader_t));
+    headerP->genericHeader.magic        = FLASH_JOURNAL_HEADER_MAGIC;
+    headerP->genericHeader.version      = FLASH_JOURNAL_HEADER_VERSION;
+    headerP->genericHeader.sizeofHeader = sizeof(LogFlashJournalHeader_t);
+
+    /* The journal header occupies whole sectors, so that sector 0 can be erased independently. */
+    headerP->genericHeader.journalOffset = logRoundUp_uint32(headerP->genericHeader.sizeofHeader, sizeofSector);
+
+    headerP->magic        = LOG_FLASH_JOURNAL_HEADER_MAGIC;
+    headerP->version      = LOG_FLASH_JOURNAL_HEADER_VERSION;
+    headerP->sizeofSector = sizeofSector;
+
+    /* Determine 'numSectors'.
+     * Constraint: logical offsets into the ring need to fit comfortably within 32 bits.
+     */
+    uint64_t numSectors = (totalSize - headerP->genericHeader.journalOffset) / sizeofSector;
+    uint64_t maxSectors = 0x7FFFFFFFUL / sizeofSector;
+    if (numSectors > maxSectors) {
+        numSectors = maxSectors;
+    }
+    if (numSectors < 3) {
+        return JOURNAL_STATUS_PARAMETER;
+    }
+    headerP->numSectors = (uint32_t)numSectors;
+
+    headerP->genericHeader.totalSize = headerP->genericHeader.journalOffset + ((uint64_t)headerP->numSectors * sizeofSector);
+
+    /* compute checksum over the entire header */
+    headerP->genericHeader.checksum = logJournalHeaderChecksum(headerP);
+
+    return JOURNAL_STATUS_OK;
+}
+
+int32_t logJournalReadSync(LogFlashJournal_t *journal, uint32_t offset, void *data, uint32_t size)
+{
+    uint8_t *dataP = (uint8_t *)data;
+
+    while (size > 0) {
+        uint32_t xfer = logAmountLeftInSector(journal, offset);
+        if (xfer > size) {
+            xfer = size;
+        }
+
+        /* TODO: add support for asynchronous read */
+        int32_t rc = journal->mtd->ReadData(logPhysicalAddress(journal, offset), dataP, xfer);
+        if (rc != (int32_t)xfer) {
+            if ((rc == ARM_DRIVER_OK) && journal->asynchronous) {
+                return JOURNAL_STATUS_UNSUPPORTED;
+            }
+            return JOURNAL_STATUS_STORAGE_IO_ERROR;
+        }
+
+        dataP  += xfer;
+        size   -= xfer;
+        offset  = logAdvance(journal, offset, xfer);
+    }
+
+    return JOURNAL_STATUS_OK;
+}
+
+static int32_t logJournalReadSectorMetadata(LogFlashJournal_t *journal, uint32_t sector, LogFlashJournalMetadata_t metadata[2])
+{
+    /* TODO: add support for asynchronous read */
+    int32_t rc = journal->mtd->ReadData(LOG_SECTOR_ADDRESS(journal, sector), metadata, 2 * LOG_FLASH_JOURNAL_SIZEOF_METADATA);
+    if (rc != (2 * LOG_FLASH_JOURNAL_SIZEOF_METADATA)) {
+        if ((rc == ARM_DRIVER_OK) && journal->asynchronous) {
+            return JOURNAL_STATUS_UNSUPPORTED;
+        }
+        return JOURNAL_STATUS_STORAGE_IO_ERROR;
+    }
+
+    return JOURNAL_STATUS_OK;
+}
+
+static int isErased(const LogFlashJournal_t *journal, const void *data, uint32_t size)
+{
+    const uint8_t erased = journal->erasedValue ? 0xFF : 0x00;
+    const uint8_t *dataP = (const uint8_t *)data;
+    for (; size > 0; size--, dataP++) {
+        if (*dataP != erased) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/* A free sector has been erased (and carries a valid head), but hasn't been entered by the log. */
+static int sectorIsFree(const LogFlashJournal_t *journal, const LogFlashJournalMetadata_t metadata[2])
+{
+    return LOG_JOURNAL_VALID_SECTOR_HEAD(&metadata[0].sectorHead) &&
+           isErased(journal, &metadata[1], LOG_FLASH_JOURNAL_SIZEOF_METADATA);
+}
+
+static int32_t regionIsErased(LogFlashJournal_t *journal, uint32_t offset, uint32_t size)
+{
+    uint8_t scratch[LOG_JOURNAL_SCRATCH_SIZE];
+
+    while (size > 0) {
+        uint32_t xfer = (size < sizeof(scratch)) ? size : sizeof(scratch);
+
+        int32_t rc;
+        if ((rc = logJournalReadSync(journal, offset, scratch, xfer)) != JOURNAL_STATUS_OK) {
+            return rc;
+        }
+        if (!isErased(journal, scratch, xfer)) {
+            return 0;
+        }
+
+        size   -= xfer;
+        offset  = logAdvance(journal, offset, xfer);
+    }
+
+    return 1;
+}
+
+int32_t logJournalBlobIsSane(LogFlashJournal_t *journal, uint32_t offset, LogFlashJournalBlobHead_t *headP)
+{
+    int32_t rc;
+    if ((rc = logJournalReadSync(journal, offset, headP, sizeof(LogFlashJournalBlobHead_t))) != JOURNAL_STATUS_OK) {
+        return rc;
+    }
+    if (!LOG_JOURNAL_VALID_BLOB_HEAD(headP) || (headP->sizeofBlob > logCapacity(journal))) {
+        return JOURNAL_STATUS_ERROR;
+    }
+
+    /* compute the CRC32 of the payload */
+    uint8_t  scratch[LOG_JOURNAL_SCRATCH_SIZE];
+    uint32_t crc32         = 0;
+    uint32_t amountLeft    = headP->sizeofBlob;
+    uint32_t payloadOffset = logAdvance(journal, offset, LOG_FLASH_JOURNAL_SIZEOF_METADATA);
+    while (amountLeft > 0) {
+        uint32_t xfer = (amountLeft < sizeof(scratch)) ? amountLeft : sizeof(scratch);
+        if ((rc = logJournalReadSync(journal, payloadOffset, scratch, xfer)) != JOURNAL_STATUS_OK) {
+            return rc;
+        }
+        crc32 = flashJournalCrcUpdate(crc32, scratch, xfer);
+
+        amountLeft    -= xfer;
+        payloadOffset  = logAdvance(journal, payloadOffset, xfer);
+    }
+
+    /* The CRC32 field in the head needs to contain 0 before CRC32 can be computed over it. */
+    LogFlashJournalBlobHead_t head = *headP;
+    head.crc32 = 0;
+    crc32 = flashJournalCrcUpdate(crc32, (const unsigned char *)&head, sizeof(LogFlashJournalBlobHead_t));
+
+    return (crc32 == headP->crc32) ? 1 : JOURNAL_STATUS_ERROR;
+}
+
+static uint32_t logPrevSector(const LogFlashJournal_t *journal, uint32_t sector)
+{
+    return (sector == 0) ? (journal->numSectors - 1) : (sector - 1);
+}
+
+/**
+ * Walk the blobs following a given offset, up to the end of the sector most
+ * recently entered by the log (journal->writeSector). The last valid blob
+ * encountered becomes the current blob.
+ *
+ * @return the offset at which the walk stopped; i.e. the first location past
+ *     the valid blobs.
+ */
+static uint32_t scanBlobs(LogFlashJournal_t *journal, uint32_t offset)
+{
+    const uint32_t firstSector = logSectorOf(journal, offset);
+    const uint32_t limit       = logSectorDistance(journal, firstSector, journal->writeSector);
+    uint32_t       walked      = 0;
+
+    while (walked < logSizeofRing(journal)) {
+        if (logSectorDistance(journal, firstSector, logSectorOf(journal, offset)) > limit) {
+            break; /* reached the sector following the log */
+        }
+
+        LogFlashJournalBlobHead_t head;
+        if (logJournalBlobIsSane(journal, offset, &head) != 1) {
+            break; /* either the end of the log, or an uncommitted (or torn) blob */
+        }
+        uint32_t footprint = logBlobFootprint(head.sizeofBlob);
+        uint32_t lastByte  = logAdvance(journal, offset, footprint - 1);
+        if (logSectorDistance(journal, firstSector, logSectorOf(journal, lastByte)) > limit) {
+            break; /* a stale blob from a previous pass over the ring */
+        }
+
+        journal->currentBlobOffset   = offset;
+        journal->sizeofJournaledBlob = head.sizeofBlob;
+        journal->nextSequenceNumber  = head.sequenceNumber + 1;
+        if (journal->nextSequenceNumber == LOG_FLASH_JOURNAL_INVALID_NEXT_SEQUENCE_NUMBER) {
+            journal->nextSequenceNumber = 0;
+        }
+
+        offset  = logAdvance(journal, offset, footprint);
+        walked += footprint;
+    }
+
+    return offset;
+}
+
+int32_t logJournalDiscoverLatestLoggedBlob(LogFlashJournal_t *journal)
+{
+    int32_t                   rc;
+    LogFlashJournalMetadata_t metadata[2];
+    uint32_t                  newestSector         = LOG_FLASH_JOURNAL_INVALID_OFFSET;
+    uint32_t                  newestSequenceNumber = 0;
+
+    /* Find the sector most recently entered by the log. */
+    journal->highestEraseCount = 0;
+    for (uint32_t sector = 0; sector < journal->numSectors; sector++) {
+        if ((rc = logJournalReadSectorMetadata(journal, sector, metadata)) != JOURNAL_STATUS_OK) {
+            return rc;
+        }
+
+        if (LOG_JOURNAL_VALID_SECTOR_HEAD(&metadata[0].sectorHead) && (metadata[0].sectorHead.eraseCount > journal->highestEraseCount)) {
+            journal->highestEraseCount = metadata[0].sectorHead.eraseCount;
+        }
+        if (LOG_JOURNAL_VALID_SECTOR_USE(&metadata[1].sectorUse) &&
+            ((newestSector == LOG_FLASH_JOURNAL_INVALID_OFFSET) ||
+             ((int32_t)(metadata[1].sectorUse.sequenceNumber - newestSequenceNumber) > 0))) {
+            newestSector         = sector;
+            newestSequenceNumber = metadata[1].sectorUse.sequenceNumber;
+        }
+    }
+
+    journal->currentBlobOffset   = LOG_FLASH_JOURNAL_INVALID_OFFSET;
+    journal->sizeofJournaledBlob = 0;
+    journal->nextSequenceNumber  = 0;
+
+    uint32_t maxErasedSectors;
+    if (newestSector == LOG_FLASH_JOURNAL_INVALID_OFFSET) {
+        /* The log hasn't entered any sector; it begins at sector 0. */
+        journal->writeSector              = journal->numSectors - 1;
+        journal->writeOffset              = 0;
+        journal->nextSectorSequenceNumber = 0;
+        maxErasedSectors                  = journal->numSectors;
+    } else {
+        journal->writeSector              = newestSector;
+        journal->nextSectorSequenceNumber = newestSequenceNumber + 1;
+        maxErasedSectors                  = journal->numSectors - 1;
+
+        /* Walk the blobs starting from the blob which spans into the newest
+         * sector; should that fail to find a committed blob, fall back to the
+         * sectors entered before it. */
+        uint32_t frontier = LOG_FLASH_JOURNAL_INVALID_OFFSET;
+        uint32_t sector   = newestSector;
+        for (uint32_t i = 0; i < journal->numSectors; i++, sector = logPrevSector(journal, sector)) {
+            if ((rc = logJournalReadSectorMetadata(journal, sector, metadata)) != JOURNAL_STATUS_OK) {
+                return rc;
+            }
+            if (!LOG_JOURNAL_VALID_SECTOR_USE(&metadata[1].sectorUse)                  ||
+                (metadata[1].sectorUse.sequenceNumber != (newestSequenceNumber - i))   ||
+                (metadata[1].sectorUse.blobOffset >= logSizeofRing(journal))           ||
+                ((metadata[1].sectorUse.blobOffset % LOG_FLASH_JOURNAL_SIZEOF_METADATA) != 0)) {
+                break;
+            }
+
+            uint32_t walkFrontier = scanBlobs(journal, metadata[1].sectorUse.blobOffset);
+            if (frontier == LOG_FLASH_JOURNAL_INVALID_OFFSET) {
+                frontier = walkFrontier;
+            }
+            if (journal->currentBlobOffset != LOG_FLASH_JOURNAL_INVALID_OFFSET) {
+                frontier = walkFrontier;
+                break;
+            }
+        }
+
+        /* The log may only be continued from the frontier if everything after
+         * it in the newest sector is still erased; otherwise it moves on to the
+         * next sector. */
+        uint32_t nextSectorStart = logSectorStart(journal, logNextSector(journal, newestSector));
+        if ((frontier != LOG_FLASH_JOURNAL_INVALID_OFFSET) && (frontier != nextSectorStart)) {
+            if (logSectorOf(journal, frontier) != newestSector) {
+                frontier = nextSectorStart;
+            } else if ((rc = regionIsErased(journal, frontier, logAmountLeftInSector(journal, frontier))) != 1) {
+                if (rc < JOURNAL_STATUS_OK) {
+                    return rc;
+                }
+                frontier = nextSectorStart;
+            }
+        }
+        journal->writeOffset = (frontier == LOG_FLASH_JOURNAL_INVALID_OFFSET) ? nextSectorStart : frontier;
+    }
+
+    /* Count the free sectors ahead of the log. */
+    journal->numErasedSectors = 0;
+    for (uint32_t sector = logNextSector(journal, journal->writeSector);
+         journal->numErasedSectors < maxErasedSectors;
+         sector = logNextSector(journal, sector)) {
+        if ((rc = logJournalReadSectorMetadata(journal, sector, metadata)) != JOURNAL_STATUS_OK) {
+            return rc;
+        }
+        if (!sectorIsFree(journal, metadata)) {
+            break;
+        }
+        journal->numErasedSectors++;
+    }
+
+    return JOURNAL_STATUS_OK;
+}
+
+/**
+ * Determine whether a sector holds part of a blob; given that the blob has
+ * been logged before the log entered journal->writeSector.
+ */
+static int sectorHoldsBlob(const LogFlashJournal_t *journal, uint32_t sector, uint32_t blobOffset)
+{
+    if (blobOffset == LOG_FLASH_JOURNAL_INVALID_OFFSET) {
+        return 0;
+    }
+
+    uint32_t blobSector = logSectorOf(journal, blobOffset);
+    return logSectorDistance(journal, blobSector, sector) <= logSectorDistance(journal, blobSector, journal->writeSector);
+}
+
+/**
+ * Setup the erase of a sector; this is then carried out by logJournalErase_progress().
+ * The erase count of the sector is fetched from its head before it is lost.
+ */
+static int32_t logJournalBeginSectorErase(LogFlashJournal_t *journal, uint32_t sector)
+{
+    int32_t                   rc;
+    LogFlashJournalMetadata_t metadata[2];
+    if ((rc = logJournalReadSectorMetadata(journal, sector, metadata)) != JOURNAL_STATUS_OK) {
+        return rc;
+    }
+
+    uint32_t eraseCount = journal->highestEraseCount; /* the head has been lost; assume the worst */
+    if (LOG_JOURNAL_VALID_SECTOR_HEAD(&metadata[0].sectorHead)) {
+        eraseCount = metadata[0].sectorHead.eraseCount + 1;
+    }
+    if (eraseCount > journal->highestEraseCount) {
+        journal->highestEraseCount = eraseCount;
+    }
+
+    memset(&journal->meta, 0, sizeof(journal->meta));
+    journal->meta.sectorHead.eraseCount = eraseCount;
+    journal->meta.sectorHead.magic      = LOG_FLASH_JOURNAL_SECTOR_HEAD_MAGIC;
+
+    journal->eraseSector  = sector;
+    journal->amountErased = 0;
+    journal->eraseStep    = LOG_JOURNAL_ERASE_STEP_ERASING;
+    return JOURNAL_STATUS_OK;
+}
+
+static int32_t logJournalErase_complete(LogFlashJournal_t *journal, int32_t status)
+{
+    switch (journal->eraseStep) {
+        case LOG_JOURNAL_ERASE_STEP_ERASING:
+            if (status <= ARM_DRIVER_OK) {
+                return JOURNAL_STATUS_STORAGE_API_ERROR;
+            }
+            journal->amountErased += status;
+            if (journal->amountErased >= journal->sizeofSector) {
+                journal->eraseStep = LOG_JOURNAL_ERASE_STEP_SECTOR_HEAD;
+            }
+            return JOURNAL_STATUS_OK;
+
+        case LOG_JOURNAL_ERASE_STEP_SECTOR_HEAD:
+            if (status != LOG_FLASH_JOURNAL_SIZEOF_METADATA) {
+                return JOURNAL_STATUS_STORAGE_API_ERROR;
+            }
+            journal->eraseStep = LOG_JOURNAL_ERASE_STEP_DONE;
+            return JOURNAL_STATUS_OK;
+
+        default:
+            return JOURNAL_STATUS_ERROR;
+    }
+}
+
+/**
+ * Progress the erase of journal->eraseSector.
+ * @return  < JOURNAL_STATUS_OK for error
+ *          = JOURNAL_STATUS_OK to signal pending asynchronous activity
+ *          1 once the sector is erased and its head programmed
+ */
+static int32_t logJournalErase_progress(LogFlashJournal_t *journal)
+{
+    int32_t rc;
+    while (journal->eraseStep != LOG_JOURNAL_ERASE_STEP_DONE) {
+        if (journal->eraseStep == LOG_JOURNAL_ERASE_STEP_ERASING) {
+            rc = journal->mtd->Erase(LOG_SECTOR_ADDRESS(journal, journal->eraseSector) + journal->amountErased,
+                                     journal->sizeofSector - journal->amountErased);
+        } else {
+            rc = journal->mtd->ProgramData(LOG_SECTOR_ADDRESS(journal, journal->eraseSector),
+                                           &journal->meta,
+                                           LOG_FLASH_JOURNAL_SIZEOF_METADATA);
+        }
+        if (rc < ARM_DRIVER_OK) {
+            return logJournalMapStorageError(rc);
+        }
+        if (journal->asynchronous && (rc == ARM_DRIVER_OK)) {
+            return JOURNAL_STATUS_OK; /* we've got pending asynchronous activity */
+        }
+        if ((rc = logJournalErase_complete(journal, rc)) < JOURNAL_STATUS_OK) {
+            return rc;
+        }
+    }
+
+    journal->eraseStep = LOG_JOURNAL_ERASE_STEP_NONE;
+    return 1;
+}
+
+/**
+ * Setup the entry of the log into the sector following journal->writeSector.
+ * The sector is erased first unless it is known to be erased already.
+ */
+static int32_t logJournalEnterNextSector(LogFlashJournal_t *journal)
+{
+    uint32_t sector = logNextSector(journal, journal->writeSector);
+
+    /* The log is not allowed to run over the current blob, or over the blob being logged. */
+    if (sectorHoldsBlob(journal, sector, journal->currentBlobOffset) ||
+        ((journal->log.step == LOG_JOURNAL_STEP_BODY) && sectorHoldsBlob(journal, sector, journal->log.blobOffset))) {
+        return JOURNAL_STATUS_BOUNDED_CAPACITY;
+    }
+
+    if (journal->numErasedSectors == 0) {
+        return logJournalBeginSectorErase(journal, sector);
+    }
+
+    memset(&journal->meta, 0, sizeof(journal->meta));
+    journal->meta.sectorUse.sequenceNumber = journal->nextSectorSequenceNumber;
+    journal->meta.sectorUse.blobOffset     = journal->log.blobOffset;
+    journal->meta.sectorUse.magic          = LOG_FLASH_JOURNAL_SECTOR_USE_MAGIC;
+
+    journal->log.resumeStep = journal->log.step;
+    journal->log.step       = LOG_JOURNAL_STEP_SECTOR_USE;
+    return JOURNAL_STATUS_OK;
+}
+
+static int32_t logJournalLog_complete(LogFlashJournal_t *journal, int32_t status)
+{
+    switch (journal->log.step) {
+        case LOG_JOURNAL_STEP_SECTOR_USE:
+            if (status != LOG_FLASH_JOURNAL_SIZEOF_METADATA) {
+                return JOURNAL_STATUS_STORAGE_API_ERROR;
+            }
+            journal->writeSector = logNextSector(journal, journal->writeSector);
+            journal->numErasedSectors--;
+            journal->nextSectorSequenceNumber++;
+            journal->log.step = journal->log.resumeStep;
+            return JOURNAL_STATUS_OK;
+
+        case LOG_JOURNAL_STEP_BODY:
+            if ((status <= ARM_DRIVER_OK) || ((uint32_t)status > journal->log.amountLeftToLog)) {
+                return JOURNAL_STATUS_STORAGE_API_ERROR;
+            }
+            journal->log.crc32            = flashJournalCrcUpdate(journal->log.crc32, journal->log.dataBeingLogged, status);
+            journal->log.dataBeingLogged += status;
+            journal->log.amountLeftToLog -= status;
+            journal->log.sizeofBlob      += status;
+            journal->writeOffset          = logAdvance(journal, journal->writeOffset, status);
+            return JOURNAL_STATUS_OK;
+
+        case LOG_JOURNAL_STEP_BLOB_HEAD:
+            if (status != LOG_FLASH_JOURNAL_SIZEOF_METADATA) {
+                return JOURNAL_STATUS_STORAGE_API_ERROR;
+            }
+            journal->log.step = LOG_JOURNAL_STEP_COMMITTED;
+            return JOURNAL_STATUS_OK;
+
+        default:
+            return JOURNAL_STATUS_ERROR;
+    }
+}
+
+static int32_t logJournalRead_complete(LogFlashJournal_t *journal, int32_t status)
+{
+    if ((status <= ARM_DRIVER_OK) || ((uint32_t)status > journal->read.amountLeftToRead)) {
+        return JOURNAL_STATUS_STORAGE_API_ERROR;
+    }
+
+    journal->read.dataBeingRead    += status;
+    journal->read.amountLeftToRead -= status;
+    journal->read.amountRead       += status;
+    journal->read.logicalOffset    += status;
+    return JOURNAL_STATUS_OK;
+}
+
+int32_t logJournal_complete(LogFlashJournal_t *journal, int32_t status)
+{
+    if ((journal->eraseStep == LOG_JOURNAL_ERASE_STEP_ERASING) || (journal->eraseStep == LOG_JOURNAL_ERASE_STEP_SECTOR_HEAD)) {
+        return logJournalErase_complete(journal, status);
+    }
+
+    switch (journal->state) {
+        case LOG_JOURNAL_STATE_LOGGING:
+            return logJournalLog_complete(journal, status);
+        case LOG_JOURNAL_STATE_READING:
+            return logJournalRead_complete(journal, status);
+        default:
+            return JOURNAL_STATUS_ERROR; /* journal is in an un-expected state. */
+    }
+}
+
+static int32_t logJournalBackground_progress(LogFlashJournal_t *journal)
+{
+    int32_t rc;
+    while (true) {
+        if (journal->eraseStep != LOG_JOURNAL_ERASE_STEP_NONE) {
+            if ((rc = logJournalErase_progress(journal)) != 1) {
+                return rc;
+            }
+            journal->numErasedSectors++;
+        }
+
+        if (journal->numErasedSectors >= LOG_FLASH_JOURNAL_SECTORS_ERASED_AHEAD) {
+            return 1;
+        }
+        uint32_t sector = (journal->writeSector + 1 + journal->numErasedSectors) % journal->numSectors;
+        if (((journal->numErasedSectors + 1) >= journal->numSectors) || sectorHoldsBlob(journal, sector, journal->currentBlobOffset)) {
+            return 1; /* the next sector is still in use */
+        }
+        if ((rc = logJournalBeginSectorErase(journal, sector)) != JOURNAL_STATUS_OK) {
+            return rc;
+        }
+    }
+}
+
+void logJournalStartBackgroundErase(LogFlashJournal_t *journal)
+{
+    if (!journal->asynchronous || journal->backgroundErase) {
+        return;
+    }
+
+    journal->backgroundErase = 1;
+    if (logJournalBackground_progress(journal) != JOURNAL_STATUS_OK) {
+        /* Either there was nothing to erase, or the erase failed; in the
+         * latter case, the sector gets erased once the log reaches it. */
+        journal->backgroundErase = 0;
+        journal->eraseStep       = LOG_JOURNAL_ERASE_STEP_NONE;
+    }
+}
+
+static void logJournalSetupBlobHead(LogFlashJournal_t *journal)
+{
+    memset(&journal->meta, 0, sizeof(journal->meta));
+    journal->meta.blobHead.sizeofBlob     = journal->log.sizeofBlob;
+    journal->meta.blobHead.sequenceNumber = journal->nextSequenceNumber;
+    journal->meta.blobHead.magic          = LOG_FLASH_JOURNAL_BLOB_MAGIC;
+
+    /* the payload has already been included in the crc32; complete it with the head. */
+    journal->meta.blobHead.crc32 = flashJournalCrcUpdate(journal->log.crc32,
+                                                         (const unsigned char *)&journal->meta.blobHead,
+                                                         sizeof(LogFlashJournalBlobHead_t));
+}
+
+int32_t flashJournalStrategyLog_log_progress(LogFlashJournal_t *journal)
+{
+    int32_t rc;
+
+    if (journal->state != LOG_JOURNAL_STATE_LOGGING) {
+        return JOURNAL_STATUS_ERROR; /* journal is in an un-expected state. */
+    }
+
+    while (true) {
+        if (journal->eraseStep != LOG_JOURNAL_ERASE_STEP_NONE) {
+            if ((rc = logJournalErase_progress(journal)) != 1) {
+                return rc;
+            }
+            journal->numErasedSectors++;
+            continue;
+        }
+
+        switch (journal->log.step) {
+            case LOG_JOURNAL_STEP_RESERVE_HEAD:
+            case LOG_JOURNAL_STEP_BODY:
+                if (logSectorOf(journal, journal->writeOffset) != journal->writeSector) {
+                    if ((rc = logJournalEnterNextSector(journal)) != JOURNAL_STATUS_OK) {
+                        return rc;
+                    }
+                    continue;
+                }
+
+                if (journal->log.step == LOG_JOURNAL_STEP_RESERVE_HEAD) {
+                    /* The head is left erased until the blob is committed. */
+                    journal->writeOffset = logAdvance(journal, journal->writeOffset, LOG_FLASH_JOURNAL_SIZEOF_METADATA);
+                    journal->log.step    = (journal->prevCommand == FLASH_JOURNAL_OPCODE_COMMIT) ?
+                                               LOG_JOURNAL_STEP_COMMIT : LOG_JOURNAL_STEP_BODY;
+                    continue;
+                }
+
+                if (journal->log.amountLeftToLog < journal->programUnit) {
+                    uint32_t amountLogged = journal->log.sizeofChunk - journal->log.amountLeftToLog;
+                    return (amountLogged > 0) ? (int32_t)amountLogged : JOURNAL_STATUS_SMALL_LOG_REQUEST;
+                }
+
+                {
+                    uint32_t xfer = journal->log.amountLeftToLog - (journal->log.amountLeftToLog % journal->programUnit);
+                    if (xfer > logAmountLeftInSector(journal, journal->writeOffset)) {
+                        xfer = logAmountLeftInSector(journal, journal->writeOffset);
+                    }
+                    rc = journal->mtd->ProgramData(logPhysicalAddress(journal, journal->writeOffset), journal->log.dataBeingLogged, xfer);
+                }
+                break;
+
+            case LOG_JOURNAL_STEP_SECTOR_USE:
+                rc = journal->mtd->ProgramData(LOG_SECTOR_ADDRESS(journal, logNextSector(journal, journal->writeSector)) + LOG_FLASH_JOURNAL_SIZEOF_METADATA,
+                                               &journal->meta,
+                                               LOG_FLASH_JOURNAL_SIZEOF_METADATA);
+                break;
+
+            case LOG_JOURNAL_STEP_COMMIT:
+                logJournalSetupBlobHead(journal);
+                journal->log.step = LOG_JOURNAL_STEP_BLOB_HEAD;
+                continue;
+
+            case LOG_JOURNAL_STEP_BLOB_HEAD:
+                rc = journal->mtd->ProgramData(logPhysicalAddress(journal, journal->log.blobOffset), &journal->meta, LOG_FLASH_JOURNAL_SIZEOF_METADATA);
+                break;
+
+            case LOG_JOURNAL_STEP_COMMITTED:
+                journal->currentBlobOffset   = journal->log.blobOffset;
+                journal->sizeofJournaledBlob = journal->log.sizeofBlob;
+                journal->writeOffset         = logAdvance(journal, journal->log.blobOffset, logBlobFootprint(journal->log.sizeofBlob));
+
+                ++journal->nextSequenceNumber;
+                if (journal->nextSequenceNumber == LOG_FLASH_JOURNAL_INVALID_NEXT_SEQUENCE_NUMBER) {
+                    ++journal->nextSequenceNumber;
+                }
+
+                journal->state = LOG_JOURNAL_STATE_INITIALIZED;
+                logJournalStartBackgroundErase(journal);
+                return 1; /* commit returns 1 upon completion. */
+
+            default:
+                return JOURNAL_STATUS_ERROR;
+        }
+
+        if (rc < ARM_DRIVER_OK) {
+            return logJournalMapStorageError(rc);
+        }
+        if (journal->asynchronous && (rc == ARM_DRIVER_OK)) {
+            return JOURNAL_STATUS_OK; /* we've got pending asynchronous activity */
+        }
+        if ((rc = logJournalLog_complete(journal, rc)) < JOURNAL_STATUS_OK) {
+            return rc;
+        }
+    }
+}
+
+int32_t flashJournalStrategyLog_read_progress(LogFlashJournal_t *journal)
+{
+    int32_t rc;
+
+    if (journal->state != LOG_JOURNAL_STATE_READING) {
+        return JOURNAL_STATUS_ERROR; /* journal is in an un-expected state. */
+    }
+
+    if (journal->read.verify) {
+        /* Establish the sanity of the blob before proceeding with the read. */
+        LogFlashJournalBlobHead_t head;
+        journal->read.verify = 0;
+        if ((logJournalBlobIsSane(journal, journal->currentBlobOffset, &head) != 1) ||
+            (head.sizeofBlob != journal->sizeofJournaledBlob)) {
+            return JOURNAL_STATUS_STORAGE_IO_ERROR;
+        }
+    }
+
+    while (journal->read.amountLeftToRead > 0) {
+        uint32_t offset = logAdvance(journal, journal->currentBlobOffset, LOG_FLASH_JOURNAL_SIZEOF_METADATA + journal->read.logicalOffset);
+        uint32_t xfer   = logAmountLeftInSector(journal, offset);
+        if (xfer > journal->read.amountLeftToRead) {
+            xfer = journal->read.amountLeftToRead;
+        }
+
+        rc = journal->mtd->ReadData(logPhysicalAddress(journal, offset), journal->read.dataBeingRead, xfer);
+        if (rc < ARM_DRIVER_OK) {
+            return logJournalMapStorageError(rc);
+        }
+        if (journal->asynchronous && (rc == ARM_DRIVER_OK)) {
+            return JOURNAL_STATUS_OK; /* we've got pending asynchronous activity */
+        }
+        if ((rc = logJournalRead_complete(journal, rc)) < JOURNAL_STATUS_OK) {
+            return rc;
+        }
+    }
+
+    journal->state = LOG_JOURNAL_STATE_INITIALIZED;
+    return journal->read.amountRead;
+}
+
+int32_t flashJournalStrategyLog_reset_progress(LogFlashJournal_t *journal)
+{
+    int32_t                   rc;
+    LogFlashJournalMetadata_t metadata[2];
+
+    if (journal->state != LOG_JOURNAL_STATE_RESETING) {
+        return JOURNAL_STATUS_ERROR; /* journal is in an un-expected state. */
+    }
+
+    /* Erase every sector which isn't already free. */
+    while (true) {
+        if (journal->eraseStep != LOG_JOURNAL_ERASE_STEP_NONE) {
+            if ((rc = logJournalErase_progress(journal)) != 1) {
+                return rc;
+            }
+            journal->reset.sector++;
+        }
+
+        if (journal->reset.sector >= journal->numSectors) {
+            break;
+        }
+        if ((rc = logJournalReadSectorMetadata(journal, journal->reset.sector, metadata)) != JOURNAL_STATUS_OK) {
+            return rc;
+        }
+        if (sectorIsFree(journal, metadata)) {
+            journal->reset.sector++;
+            continue;
+        }
+        if ((rc = logJournalBeginSectorErase(journal, journal->reset.sector)) != JOURNAL_STATUS_OK) {
+            return rc;
+        }
+    }
+
+    /* Sequence numbers carry on from where they were. */
+    journal->currentBlobOffset   = LOG_FLASH_JOURNAL_INVALID_OFFSET;
+    journal->sizeofJournaledBlob = 0;
+    journal->writeOffset         = logSectorStart(journal, logNextSector(journal, journal->writeSector));
+    journal->numErasedSectors    = journal->numSectors;
+    journal->state               = LOG_JOURNAL_STATE_INITIALIZED;
+    return 1; /* reset returns 1 upon completion. */
+}
+
+int32_t logJournal_progress(LogFlashJournal_t *journal)
+{
+    if (journal->backgroundErase) {
+        return logJournalBackground_progress(journal);
+    }
+
+    switch (journal->state) {
+        case LOG_JOURNAL_STATE_LOGGING:
+            return flashJournalStrategyLog_log_progress(journal);
+        case LOG_JOURNAL_STATE_READING:
+            return flashJournalStrategyLog_read_progress(journal);
+        case LOG_JOURNAL_STATE_RESETING:
+            return flashJournalStrategyLog_reset_progress(journal);
+        default:
+            return JOURNAL_STATUS_ERROR; /* journal is in an un-expected state. */
+    }
+}
+
+void logJournalAbort(LogFlashJournal_t *journal)
+{
+    if (journal->state == LOG_JOURNAL_STATE_LOGGING) {
+        if (journal->log.step == LOG_JOURNAL_STEP_SECTOR_USE) {
+            /* The use marker may be partially programmed; erase the sector again before entering it. */
+            journal->numErasedSectors = 0;
+        }
+        if (journal->writeOffset != journal->log.blobOffset) {
+            /* Parts of the blob may have been programmed after its (erased)
+             * head. Continue the log from the next sector, so that the blobs
+             * logged from here on can be found by initialize(). */
+            journal->writeOffset = logSectorStart(journal, logNextSector(journal, journal->writeSector));
+        }
+    }
+
+    journal->eraseStep = LOG_JOURNAL_ERASE_STEP_NONE;
+    journal->state     = LOG_JOURNAL_STATE_INITIALIZED;
+}
+
+static int32_t logJournalFormat_complete(int32_t status)
+{
+    switch (logFormatInfoSingleton.phase) {
+        case LOG_JOURNAL_FORMAT_ERASING_HEADER:
+            if (status <= ARM_DRIVER_OK) {
+                return JOURNAL_STATUS_STORAGE_API_ERROR;
+            }
+            logFormatInfoSingleton.amountErased += status;
+            if (logFormatInfoSingleton.amountErased >= logFormatInfoSingleton.header.genericHeader.journalOffset) {
+                logFormatInfoSingleton.phase = LOG_JOURNAL_FORMAT_ERASING_SECTORS;
+            }
+            return JOURNAL_STATUS_OK;
+
+        case LOG_JOURNAL_FORMAT_ERASING_SECTORS:
+            return logJournal_complete(&logFormatInfoSingleton.journal, status);
+
+        case LOG_JOURNAL_FORMAT_PROGRAMMING_HEADER:
+            if (status != LOG_FLASH_JOURNAL_SIZEOF_PROGRAMMED_HEADER) {
+                return JOURNAL_STATUS_STORAGE_API_ERROR;
+            }
+            logFormatInfoSingleton.phase = LOG_JOURNAL_FORMAT_DONE;
+            return JOURNAL_STATUS_OK;
+
+        default:
+            return JOURNAL_STATUS_ERROR;
+    }
+}
+
+int32_t flashJournalStrategyLog_format_progress(void)
+{
+    LogFlashJournal_t *journal = &logFormatInfoSingleton.journal;
+    ARM_DRIVER_STORAGE *mtd    = journal->mtd;
+    int32_t rc;
+
+    while (true) {
+        switch (logFormatInfoSingleton.phase) {
+            case LOG_JOURNAL_FORMAT_ERASING_HEADER:
+                rc = mtd->Erase(logFormatInfoSingleton.mtdAddr + logFormatInfoSingleton.amountErased,
+                                logFormatInfoSingleton.header.genericHeader.journalOffset - logFormatInfoSingleton.amountErased);
+                break;
+
+            case LOG_JOURNAL_FORMAT_ERASING_SECTORS:
+                if ((rc = flashJournalStrategyLog_reset_progress(journal)) != 1) {
+                    return rc;
+                }
+                logFormatInfoSingleton.phase = LOG_JOURNAL_FORMAT_PROGRAMMING_HEADER;
+                continue;
+
+            case LOG_JOURNAL_FORMAT_PROGRAMMING_HEADER:
+                rc = mtd->ProgramData(logFormatInfoSingleton.mtdAddr,
+                                      logFormatInfoSingleton.programmedHeader,
+                                      LOG_FLASH_JOURNAL_SIZEOF_PROGRAMMED_HEADER);
+                break;
+
+            case LOG_JOURNAL_FORMAT_DONE:
+                return 1; /* acknowledge the completion of format */
+
+            default:
+                return JOURNAL_STATUS_ERROR;
+        }
+
+        if (rc < ARM_DRIVER_OK) {
+            return logJournalMapStorageError(rc);
+        }
+        if (journal->asynchronous && (rc == ARM_DRIVER_OK)) {
+            return JOURNAL_STATUS_OK; /* we've got pending asynchronous activity */
+        }
+        if ((rc = logJournalFormat_complete(rc)) < JOURNAL_STATUS_OK) {
+            return rc;
+        }
+    }
+}
+
+void logJournalFormatHandler(int32_t status, ARM_STORAGE_OPERATION operation)
+{
+    int32_t rc;
+
+    if (status < ARM_DRIVER_OK) {
+        rc = logJournalMapStorageError(status);
+    } else if (operation == ARM_STORAGE_OPERATION_INITIALIZE) {
+        rc = flashJournalStrategyLog_format_progress();
+    } else if ((rc = logJournalFormat_complete(status)) == JOURNAL_STATUS_OK) {
+        rc = flashJournalStrategyLog_format_progress();
+    }
+
+    if (rc != JOURNAL_STATUS_OK) {
+        if (logFormatInfoSingleton.callback) {
+            logFormatInfoSingleton.callback(rc, FLASH_JOURNAL_OPCODE_FORMAT);
+        }
+    }
+}
+
+void logJournalMtdHandler(int32_t status, ARM_STORAGE_OPERATION operation)
+{
+    LogFlashJournal_t *journal = activeLogJournal;
+    int32_t rc;
+
+    if (operation == ARM_STORAGE_OPERATION_INITIALIZE) {
+        if (journal->callback) {
+            journal->callback((status < ARM_DRIVER_OK) ? logJournalMapStorageError(status) : JOURNAL_STATUS_OK,
+                              FLASH_JOURNAL_OPCODE_INITIALIZE);
+        }
+        return;
+    }
+
+    /* Note whether this completes a step of the background erase before
+     * progressing; the operation may itself start a background erase. */
+    bool background = journal->backgroundErase;
+
+    if (status < ARM_DRIVER_OK) {
+        rc = logJournalMapStorageError(status);
+    } else if ((rc = logJournal_complete(journal, status)) == JOURNAL_STATUS_OK) {
+        rc = logJournal_progress(journal);
+    }
+
+    if (background) {
+        if (rc == JOURNAL_STATUS_OK) {
+            return; /* the background erase is still under way */
+        }
+
+        /* The outcome of a background erase isn't reported; should it have
+         * failed, the sector gets erased once the log reaches it. */
+        journal->backgroundErase = 0;
+        journal->eraseStep       = LOG_JOURNAL_ERASE_STEP_NONE;
+        if (!journal->deferred) {
+            return;
+        }
+
+        /* start the operation which has been waiting for the erase to finish */
+        journal->deferred = 0;
+        rc = logJournal_progress(journal);
+    }
+
+    if (rc == JOURNAL_STATUS_OK) {
+        return; /* we've got pending asynchronous activity */
+    }
+    if ((rc < JOURNAL_STATUS_OK) && (rc != JOURNAL_STATUS_SMALL_LOG_REQUEST)) {
+        logJournalAbort(journal); /* reset journal state to allow further operation. */
+    }
+    if (journal->callback) {
+        journal->callback(rc, (FlashJournal_OpCode_t)journal->prevCommand);
+    }
+}
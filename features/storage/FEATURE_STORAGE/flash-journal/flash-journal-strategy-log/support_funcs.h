@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2006-2016, ARM Limited, All Rights Reserved
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __FLASH_JOURNAL_LOG_STRATEGY_SUPPORT_FUNCTIONS_H__
+#define __FLASH_JOURNAL_LOG_STRATEGY_SUPPORT_FUNCTIONS_H__
+
+#include "flash-journal-strategy-log/flash_journal_log_private.h"
+#include "flash-journal-strategy-log/flash_journal_strategy_log.h"
+
+typedef enum {
+    LOG_JOURNAL_FORMAT_ERASING_HEADER,
+    LOG_JOURNAL_FORMAT_ERASING_SECTORS,
+    LOG_JOURNAL_FORMAT_PROGRAMMING_HEADER,
+    LOG_JOURNAL_FORMAT_DONE,
+} LogFlashJournalFormatPhase_t;
+
+/* The following singleton captures the state of the format machine. Format is
+ * handled differently because it executes even before a journal exists (or a
+ * Journal_t can be initialized). The sectors are erased through the reset
+ * machinery of a journal held within the singleton. */
+extern struct LogFormatInfo_t {
+    LogFlashJournal_t              journal;
+    union {
+        LogFlashJournalHeader_t    header;
+        uint8_t                    programmedHeader[LOG_FLASH_JOURNAL_SIZEOF_PROGRAMMED_HEADER];
+    };
+    FlashJournal_Callback_t        callback;
+    uint64_t                       mtdAddr;
+    uint32_t                       amountErased;
+    LogFlashJournalFormatPhase_t   phase;
+} logFormatInfoSingleton;
+
+extern LogFlashJournal_t *activeLogJournal;
+
+int32_t logJournalMtdGetStartAddr(ARM_DRIVER_STORAGE *mtd, uint64_t *startAddrP);
+int32_t logJournalMapStorageError(int32_t rc);
+int32_t setupLogJournalHeader(LogFlashJournalHeader_t *headerP, ARM_DRIVER_STORAGE *mtd, uint64_t totalSize, uint32_t sizeofSector);
+uint32_t logJournalHeaderChecksum(const LogFlashJournalHeader_t *headerP);
+
+/**
+ * Read from the ring synchronously.
+ * @param offset
+ *          logical offset; the read may span sectors.
+ * @return JOURNAL_STATUS_OK if 'size' bytes were read.
+ */
+int32_t logJournalReadSync(LogFlashJournal_t *journal, uint32_t offset, void *data, uint32_t size);
+
+/**
+ * Check the sanity of the blob at a given offset.
+ * @param       journal
+ * @param       offset
+ * @param [out] headP
+ *                  the head of the blob.
+ * @return 1 if the head is valid and the CRC32 of the blob agrees.
+ */
+int32_t logJournalBlobIsSane(LogFlashJournal_t *journal, uint32_t offset, LogFlashJournalBlobHead_t *headP);
+
+/**
+ * Scan the sectors for the most recently committed blob and the point from
+ * which to continue the log. This is done synchronously.
+ */
+int32_t logJournalDiscoverLatestLoggedBlob(LogFlashJournal_t *journal);
+
+/**
+ * Apply the result of a completed MTD operation to the operation in progress.
+ * @return  < JOURNAL_STATUS_OK for error
+ *          = JOURNAL_STATUS_OK to continue progressing the operation
+ */
+int32_t logJournal_complete(LogFlashJournal_t *journal, int32_t status);
+
+/**
+ * Progress the state machine for the operation in progress. This method can also be called from an interrupt handler.
+ * @return  < JOURNAL_STATUS_OK for error
+ *          = JOURNAL_STATUS_OK to signal pending asynchronous activity
+ *          > JOURNAL_STATUS_OK for completion
+ */
+int32_t logJournal_progress(LogFlashJournal_t *journal);
+
+/**
+ * Put the journal back into the initialized state following the failure of an
+ * operation.
+ */
+void    logJournalAbort(LogFlashJournal_t *journal);
+
+/**
+ * Erase the sector following the log in the background, if the MTD operates
+ * asynchronously and the log doesn't have enough erased sectors ahead of it.
+ */
+void    logJournalStartBackgroundErase(LogFlashJournal_t *journal);
+
+int32_t flashJournalStrategyLog_format_progress(void);
+int32_t flashJournalStrategyLog_log_progress(LogFlashJournal_t *journal);
+int32_t flashJournalStrategyLog_reset_progress(LogFlashJournal_t *journal);
+int32_t flashJournalStrategyLog_read_progress(LogFlashJournal_t *journal);
+
+void    logJournalMtdHandler(int32_t status, ARM_STORAGE_OPERATION operation);
+void    logJournalFormatHandler(int32_t status, ARM_STORAGE_OPERATION operation);
+
+#endif /*__FLASH_JOURNAL_LOG_STRATEGY_SUPPORT_FUNCTIONS_H__*/
@@ -27,6 +27,17 @@ typedef uint32_t  flash_journal_crc32_t;
 void flashJournalCrcReset(void);
 flash_journal_crc32_t flashJournalCrcCummulative(unsigned char const message[], int nBytes);
 
+/*
+ * Stateless form of flashJournalCrcCummulative(): returns the CRC of a
+ * message given the CRC of the preceding fragments (0 for the first
+ * fragment). Unlike flashJournalCrcCummulative() it may be used to compute
+ * several CRCs at once, e.g. while verifying a blob as it is read.
+ *
+ * Defining FLASH_JOURNAL_CRC_UPDATE_ALT removes the software implementation
+ * so that a target can provide one using its CRC unit.
+ */
+flash_journal_crc32_t flashJournalCrcUpdate(flash_journal_crc32_t crc, unsigned char const message[], int nBytes);
+
 #ifdef __cplusplus
 }
 #endif
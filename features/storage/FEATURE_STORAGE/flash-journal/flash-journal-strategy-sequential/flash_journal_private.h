@@ -155,6 +155,8 @@ typedef struct _SequentialFlashJournal_t {
             uint8_t       *dataBeingRead;      /**< temporary pointer aimed at the next data to be read-into. */
             size_t         amountLeftToRead;
             size_t         logicalOffset;      /**< the logical offset within the blob at which the next read will occur. */
+            uint32_t       crc32;              /**< CRC32 of the slot so far, when the blob is being verified as it is read. */
+            SequentialFlashJournalLogTail_t tail; /**< tail of the slot being verified; tail.magic is 0 when not verifying. */
         } read;
     };
 } SequentialFlashJournal_t;
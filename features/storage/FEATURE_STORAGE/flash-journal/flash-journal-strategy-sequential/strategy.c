@@ -170,6 +170,10 @@ int32_t flashJournalStrategySequential_initialize(FlashJournal_t           *_jou
     if ((rc = readAndVerifyJournalHeader(journal, &journalHeader)) != JOURNAL_STATUS_OK) {
         return rc;
     }
+    if (journalHeader.genericHeader.totalSize > mtdCapacity) {
+        /* the journal was formatted for a larger storage volume */
+        return JOURNAL_STATUS_NOT_FORMATTED;
+    }
 
     /* initialize the journal structure */
     memcpy(&journal->ops, ops, sizeof(FlashJournal_Ops_t));
@@ -220,9 +224,23 @@ int32_t flashJournalStrategySequential_read(FlashJournal_t *_journal, void *blob
     journal->read.blob       = blob;
     journal->read.sizeofBlob = sizeofBlob;
 
+    journal->read.tail.magic = 0;
     if (journal->read.logicalOffset == 0) {
-        { /* Establish the sanity of this slot before proceeding with the read. */
-            uint32_t headSequenceNumber;
+        uint32_t headSequenceNumber;
+        if (!journal->mtdCapabilities.asynchronous_ops && (sizeofBlob >= journal->info.sizeofJournaledBlob)) {
+            /* The entire blob is being read synchronously, so its CRC32 is
+             * computed as the data is read and the read fails if the slot turns
+             * out not to be sane. Only the head and tail are checked up front. */
+            if ((slotHeadAndTailAreSane(journal,
+                                        SLOT_ADDRESS(journal, journal->currentBlobIndex),
+                                        &headSequenceNumber,
+                                        &journal->read.tail,
+                                        &journal->read.crc32) != 1) ||
+                (journal->read.tail.sizeofBlob != journal->info.sizeofJournaledBlob)) {
+                journal->read.tail.magic = 0;
+                return JOURNAL_STATUS_STORAGE_IO_ERROR;
+            }
+        } else { /* Establish the sanity of this slot before proceeding with the read. */
             SequentialFlashJournalLogTail_t tail;
             if (slotIsSane(journal,
                            SLOT_ADDRESS(journal, journal->currentBlobIndex),
@@ -263,6 +281,7 @@ int32_t flashJournalStrategySequential_readFrom(FlashJournal_t *_journal, size_t
     journal->read.sizeofBlob       = sizeofBlob;
 
     journal->read.mtdOffset        = SLOT_ADDRESS(journal, journal->currentBlobIndex) + sizeof(SequentialFlashJournalLogHead_t) + offset;
+    journal->read.tail.magic       = 0; /* only reads of the entire blob are verified */
 
     journal->read.dataBeingRead    = blob;
     journal->read.amountLeftToRead = ((journal->info.sizeofJournaledBlob - journal->read.logicalOffset) < sizeofBlob) ?
@@ -38,19 +38,22 @@ int32_t mtdGetStartAddr(ARM_DRIVER_STORAGE *mtd, uint64_t *startAddrP)
 }
 
 /**
- * Check the sanity of a given slot
+ * Check the head and tail of a given slot, without reading the body.
  * @param       journal
  * @param       slotOffset
  * @param [out] headSequenceNumberP
  *                  sequence number of the slot as read from the header.
  * @param [out] tailP
  *                  the tail of the slot
- * @return 1 if the slot is valid; i.e. if head and tail match, and if CRC32 agrees.
+ * @param [out] crc32P
+ *                  the CRC32 of the head, from which to continue computing the CRC32 of the slot.
+ * @return 1 if head and tail match.
  */
-int32_t slotIsSane(SequentialFlashJournal_t        *journal,
-                   uint64_t                         slotOffset,
-                   uint32_t                        *headSequenceNumberP,
-                   SequentialFlashJournalLogTail_t *tailP)
+int32_t slotHeadAndTailAreSane(SequentialFlashJournal_t        *journal,
+                               uint64_t                         slotOffset,
+                               uint32_t                        *headSequenceNumberP,
+                               SequentialFlashJournalLogTail_t *tailP,
+                               uint32_t                        *crc32P)
 {
     int32_t rc;
     ARM_DRIVER_STORAGE *mtd = journal->mtd;
@@ -67,8 +70,7 @@ int32_t slotIsSane(SequentialFlashJournal_t        *journal,
     }
 
     /* compute the CRC32 of the header */
-    flashJournalCrcReset();
-    flashJournalCrcCummulative((const unsigned char *)&head, sizeof(SequentialFlashJournalLogHead_t));
+    *crc32P = flashJournalCrcUpdate(0, (const unsigned char *)&head, sizeof(SequentialFlashJournalLogHead_t));
 
     // printf("head->version: %lu\n", journal->initScan.head.version);
     // printf("head->magic: %lx\n", journal->initScan.head.magic);
@@ -93,45 +95,79 @@ int32_t slotIsSane(SequentialFlashJournal_t        *journal,
 
         if (SEQUENTIAL_JOURNAL_VALID_TAIL(tailP) && (tailP->sequenceNumber == *headSequenceNumberP)) {
             // printf("found valid tail\n");
+            return 1;
+        }
+    }
 
-            /* iterate over the body of the slot computing CRC */
-            #define CRC_CHUNK_SIZE 64
-            uint8_t crcBuffer[CRC_CHUNK_SIZE];
-            uint64_t bodyIndex = 0;
-            uint64_t bodyOffset = slotOffset + sizeof(SequentialFlashJournalLogHead_t);
-            while (bodyIndex < tailP->sizeofBlob) {
-                size_t sizeofReadOperation;
-                if ((tailP->sizeofBlob - bodyIndex) > CRC_CHUNK_SIZE) {
-                    sizeofReadOperation = CRC_CHUNK_SIZE;
-                } else {
-                    sizeofReadOperation = (tailP->sizeofBlob - bodyIndex);
-                }
+    return JOURNAL_STATUS_ERROR;
+}
 
-                /* TODO: add support for asynchronous read */
-                rc = mtd->ReadData(bodyOffset + bodyIndex, crcBuffer, sizeofReadOperation);
-                if (rc != (int32_t)sizeofReadOperation) {
-                    return JOURNAL_STATUS_STORAGE_IO_ERROR;
-                }
+/**
+ * Complete the CRC32 of a slot with its tail.
+ * @param tailP
+ *          the tail of the slot.
+ * @param crc32
+ *          the CRC32 of the head and body of the slot.
+ * @return 1 if the CRC32 agrees with the one held in the tail.
+ */
+int32_t slotTailMatchesCRC(const SequentialFlashJournalLogTail_t *tailP, uint32_t crc32)
+{
+    /* The CRC32 field in the tail needs to contain 0 before CRC32 can be computed over it. */
+    SequentialFlashJournalLogTail_t tail = *tailP;
+    tail.crc32 = 0;
 
-                bodyIndex += sizeofReadOperation;
-                flashJournalCrcCummulative(crcBuffer, sizeofReadOperation);
-            }
+    crc32 = flashJournalCrcUpdate(crc32, (const unsigned char *)&tail, sizeof(SequentialFlashJournalLogTail_t));
+    // printf("expectedCRC32: 0x%x, computedCRC32: 0x%x\n", tailP->crc32, crc32);
+    return (crc32 == tailP->crc32) ? 1 : JOURNAL_STATUS_ERROR;
+}
 
-            /* compute CRC32 over the tail */
-            /* extract existing CRC32 from the tail. The CRC32 field in the tail needs to contain 0 before CRC32 can be computed over it. */
-            uint32_t expectedCRC32 = tailP->crc32;
-            tailP->crc32 = 0;
+/**
+ * Check the sanity of a given slot
+ * @param       journal
+ * @param       slotOffset
+ * @param [out] headSequenceNumberP
+ *                  sequence number of the slot as read from the header.
+ * @param [out] tailP
+ *                  the tail of the slot
+ * @return 1 if the slot is valid; i.e. if head and tail match, and if CRC32 agrees.
+ */
+int32_t slotIsSane(SequentialFlashJournal_t        *journal,
+                   uint64_t                         slotOffset,
+                   uint32_t                        *headSequenceNumberP,
+                   SequentialFlashJournalLogTail_t *tailP)
+{
+    int32_t rc;
+    uint32_t crc32;
+    ARM_DRIVER_STORAGE *mtd = journal->mtd;
 
-            uint32_t crc32 = flashJournalCrcCummulative((const unsigned char *)tailP, sizeof(SequentialFlashJournalLogTail_t));
-            flashJournalCrcReset();
-            // printf("expectedCRC32: 0x%x, computedCRC32: 0x%x\n", expectedCRC32, crc32);
-            if (crc32 == expectedCRC32) {
-                return 1;
-            }
+    if ((rc = slotHeadAndTailAreSane(journal, slotOffset, headSequenceNumberP, tailP, &crc32)) != 1) {
+        return rc;
+    }
+
+    /* iterate over the body of the slot computing CRC */
+    #define CRC_CHUNK_SIZE 64
+    uint8_t crcBuffer[CRC_CHUNK_SIZE];
+    uint64_t bodyIndex = 0;
+    uint64_t bodyOffset = slotOffset + sizeof(SequentialFlashJournalLogHead_t);
+    while (bodyIndex < tailP->sizeofBlob) {
+        size_t sizeofReadOperation;
+        if ((tailP->sizeofBlob - bodyIndex) > CRC_CHUNK_SIZE) {
+            sizeofReadOperation = CRC_CHUNK_SIZE;
+        } else {
+            sizeofReadOperation = (tailP->sizeofBlob - bodyIndex);
+        }
+
+        /* TODO: add support for asynchronous read */
+        rc = mtd->ReadData(bodyOffset + bodyIndex, crcBuffer, sizeofReadOperation);
+        if (rc != (int32_t)sizeofReadOperation) {
+            return JOURNAL_STATUS_STORAGE_IO_ERROR;
         }
+
+        bodyIndex += sizeofReadOperation;
+        crc32 = flashJournalCrcUpdate(crc32, crcBuffer, sizeofReadOperation);
     }
 
-    return JOURNAL_STATUS_ERROR;
+    return slotTailMatchesCRC(tailP, crc32);
 }
 
 int32_t setupSequentialJournalHeader(SequentialFlashJournalHeader_t *headerP, ARM_DRIVER_STORAGE *mtd, uint64_t totalSize, uint32_t numSlots)
@@ -379,6 +415,10 @@ int32_t flashJournalStrategySequential_read_progress(void)
             return JOURNAL_STATUS_OK; /* we've got pending asynchronous activity. */
         } else {
             /* synchronous completion. 'rc' contains the actual number of bytes transferred. */
+            if (journal->read.tail.magic) {
+                /* verify the blob as it is read rather than in a separate pass over the slot */
+                journal->read.crc32 = flashJournalCrcUpdate(journal->read.crc32, journal->read.dataBeingRead, rc);
+            }
             journal->read.mtdOffset        += rc;
             journal->read.amountLeftToRead -= rc;
             journal->read.dataBeingRead    += rc;
@@ -387,6 +427,14 @@ int32_t flashJournalStrategySequential_read_progress(void)
     }
 
     journal->state = SEQUENTIAL_JOURNAL_STATE_INITIALIZED;
+    if (journal->read.tail.magic) {
+        rc = slotTailMatchesCRC(&journal->read.tail, journal->read.crc32);
+        journal->read.tail.magic = 0;
+        if (rc != 1) {
+            /* the slot no longer matches the CRC that initialize() verified */
+            return JOURNAL_STATUS_STORAGE_IO_ERROR;
+        }
+    }
     return (journal->read.dataBeingRead - journal->read.blob);
 }
 
@@ -49,6 +49,30 @@ int32_t slotIsSane(SequentialFlashJournal_t        *journal,
                    uint32_t                        *headSequenceNumberP,
                    SequentialFlashJournalLogTail_t *tailP);
 
+/**
+ * Check the head and tail of a given slot, without reading the body.
+ * @param       journal
+ * @param       slotOffset
+ * @param [out] headSequenceNumberP
+ *                  sequence number of the slot as read from the header.
+ * @param [out] tailP
+ *                  the tail of the slot
+ * @param [out] crc32P
+ *                  the CRC32 of the head, from which to continue computing the CRC32 of the slot.
+ * @return 1 if head and tail match.
+ */
+int32_t slotHeadAndTailAreSane(SequentialFlashJournal_t        *journal,
+                               uint64_t                         slotOffset,
+                               uint32_t                        *headSequenceNumberP,
+                               SequentialFlashJournalLogTail_t *tailP,
+                               uint32_t                        *crc32P);
+
+/**
+ * Complete the CRC32 of a slot with its tail.
+ * @return 1 if the CRC32 agrees with the one held in the tail.
+ */
+int32_t slotTailMatchesCRC(const SequentialFlashJournalLogTail_t *tailP, uint32_t crc32);
+
 int32_t mtdGetStartAddr(ARM_DRIVER_STORAGE *mtd, uint64_t *startAddrP);
 int32_t setupSequentialJournalHeader(SequentialFlashJournalHeader_t *headerP, ARM_DRIVER_STORAGE *mtd, uint64_t totalSize, uint32_t numSlots);
 int32_t discoverLatestLoggedBlob(SequentialFlashJournal_t *journal);
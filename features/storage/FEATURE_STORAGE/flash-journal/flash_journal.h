@@ -358,7 +358,9 @@ static inline FlashJournal_Status_t FlashJournal_getInfo(FlashJournal_t *journal
  * @param [out] buffer
  *                The destination of the read operation. The memory is owned
  *                by the caller and should remain valid for the lifetime
- *                of this operation.
+ *                of this operation. If the read fails, the contents of the
+ *                buffer are undefined; in particular a read of the entire
+ *                blob may be verified as the data is read into the buffer.
  *
  * @param  [in] size
  *                The maximum amount of data which can be read in this
@@ -29,6 +29,13 @@ void StorageVolume::setup(uint64_t _addr, uint64_t _size, StorageVolumeManager *
     volumeSize    = _size;
     volumeManager = _volumeManager;
     allocated     = true;
+    request.state = REQUEST_IDLE;
+    resetStats();
+}
+
+void StorageVolume::resetStats(void)
+{
+    memset(&stats, 0, sizeof(stats));
 }
 
 ARM_DRIVER_VERSION StorageVolume::GetVersion(void)
@@ -77,16 +84,15 @@ int32_t StorageVolume::PowerControl(ARM_POWER_STATE state)
     if (!allocated) {
         return STORAGE_VOLUME_MANAGER_STATUS_ERROR_VOLUME_NOT_ALLOCATED;
     }
-    if (volumeManager->activeVolume != NULL) {
+    if (request.state != REQUEST_IDLE) {
         return ARM_DRIVER_ERROR_BUSY;
     }
 
-    volumeManager->activeVolume = this;
-    int32_t rc = volumeManager->getStorage()->PowerControl(state);
-    if (rc != ARM_DRIVER_OK) {
-        volumeManager->activeVolume = NULL; /* we're certain that there is no more pending asynch. activity */
-    }
-    return rc;
+    request.operation  = ARM_STORAGE_OPERATION_POWER_CONTROL;
+    request.addr       = volumeOffset;
+    request.powerState = state;
+    request.size       = 0;
+    return volumeManager->submit(this);
 }
 
 int32_t StorageVolume::ReadData(uint64_t addr, void *data, uint32_t size)
@@ -95,19 +101,18 @@ int32_t StorageVolume::ReadData(uint64_t addr, void *data, uint32_t size)
     if (!allocated) {
         return STORAGE_VOLUME_MANAGER_STATUS_ERROR_VOLUME_NOT_ALLOCATED;
     }
-    if (volumeManager->activeVolume != NULL) {
+    if (request.state != REQUEST_IDLE) {
         return ARM_DRIVER_ERROR_BUSY;
     }
     if ((size > volumeSize) || ((addr + size) > volumeSize)) {
         return ARM_DRIVER_ERROR_PARAMETER;
     }
 
-    volumeManager->activeVolume = this;
-    int32_t rc = volumeManager->getStorage()->ReadData(volumeOffset + addr, data, size);
-    if (rc != ARM_DRIVER_OK) {
-        volumeManager->activeVolume = NULL; /* we're certain that there is no more pending asynch. activity */
-    }
-    return rc;
+    request.operation = ARM_STORAGE_OPERATION_READ_DATA;
+    request.addr      = volumeOffset + addr;
+    request.data      = data;
+    request.size      = size;
+    return volumeManager->submit(this);
 }
 
 int32_t StorageVolume::ProgramData(uint64_t addr, const void *data, uint32_t size)
@@ -116,19 +121,18 @@ int32_t StorageVolume::ProgramData(uint64_t addr, const void *data, uint32_t siz
     if (!allocated) {
         return STORAGE_VOLUME_MANAGER_STATUS_ERROR_VOLUME_NOT_ALLOCATED;
     }
-    if (volumeManager->activeVolume != NULL) {
+    if (request.state != REQUEST_IDLE) {
         return ARM_DRIVER_ERROR_BUSY;
     }
     if ((size > volumeSize) || ((addr + size) > volumeSize)) {
         return ARM_DRIVER_ERROR_PARAMETER;
     }
 
-    volumeManager->activeVolume = this;
-    int32_t rc = volumeManager->getStorage()->ProgramData(volumeOffset + addr, data, size);
-    if (rc != ARM_DRIVER_OK) {
-        volumeManager->activeVolume = NULL; /* we're certain that there is no more pending asynch. activity */
-    }
-    return rc;
+    request.operation   = ARM_STORAGE_OPERATION_PROGRAM_DATA;
+    request.addr        = volumeOffset + addr;
+    request.programData = data;
+    request.size        = size;
+    return volumeManager->submit(this);
 }
 
 int32_t StorageVolume::Erase(uint64_t addr, uint32_t size)
@@ -137,19 +141,17 @@ int32_t StorageVolume::Erase(uint64_t addr, uint32_t size)
     if (!allocated) {
         return STORAGE_VOLUME_MANAGER_STATUS_ERROR_VOLUME_NOT_ALLOCATED;
     }
-    if (volumeManager->activeVolume != NULL) {
+    if (request.state != REQUEST_IDLE) {
         return ARM_DRIVER_ERROR_BUSY;
     }
     if ((size > volumeSize) || ((addr + size) > volumeSize)) {
         return ARM_DRIVER_ERROR_PARAMETER;
     }
 
-    volumeManager->activeVolume = this;
-    int32_t rc = volumeManager->getStorage()->Erase(volumeOffset + addr, size);
-    if (rc != ARM_DRIVER_OK) {
-        volumeManager->activeVolume = NULL; /* we're certain that there is no more pending asynch. activity */
-    }
-    return rc;
+    request.operation = ARM_STORAGE_OPERATION_ERASE;
+    request.addr      = volumeOffset + addr;
+    request.size      = size;
+    return volumeManager->submit(this);
 }
 
 int32_t StorageVolume::EraseAll(void)
@@ -158,7 +160,7 @@ int32_t StorageVolume::EraseAll(void)
     if (!allocated) {
         return STORAGE_VOLUME_MANAGER_STATUS_ERROR_VOLUME_NOT_ALLOCATED;
     }
-    if (volumeManager->activeVolume != NULL) {
+    if (request.state != REQUEST_IDLE) {
         return ARM_DRIVER_ERROR_BUSY;
     }
 
@@ -177,17 +179,17 @@ int32_t StorageVolume::EraseAll(void)
         }
     }
 
-    volumeManager->activeVolume = this;
-    rc = volumeManager->getStorage()->EraseAll();
-    if (rc != ARM_DRIVER_OK) {
-        volumeManager->activeVolume = NULL; /* we're certain that there is no more pending asynch. activity */
-    }
-    return rc;
+    request.operation = ARM_STORAGE_OPERATION_ERASE_ALL;
+    request.addr      = volumeOffset;
+    request.size      = (uint32_t)volumeSize;
+    return volumeManager->submit(this);
 }
 
 ARM_STORAGE_STATUS StorageVolume::GetStatus(void)
 {
-    const uint32_t busy = ((volumeManager->activeVolume != NULL) ? (uint32_t)1 : (uint32_t)0);
+    /* A volume is busy only while it has a request of its own outstanding;
+     * activity on behalf of other volumes merely delays its next request. */
+    const uint32_t busy = ((request.state != REQUEST_IDLE) ? (uint32_t)1 : (uint32_t)0);
     ARM_STORAGE_STATUS status = {0, 0};
     status.busy = busy;
     return status;
@@ -16,6 +16,7 @@
  */
 
 #include "storage-volume-manager/storage_volume_manager.h"
+#include "platform/critical.h"
 #include <string.h>
 #include <inttypes.h>
 
@@ -107,6 +108,8 @@ int32_t StorageVolumeManager::initialize(ARM_DRIVER_STORAGE *mtd, InitializeCall
 {
     activeVolume        = NULL;
     initializeCallback  = callback;
+    nextSequence        = 0;
+    readsBypassed       = 0;
 
     storage             = mtd;
     storageCapabilities = mtd->GetCapabilities();
@@ -257,15 +260,13 @@ void StorageVolumeManager::storageCallback(int32_t status, ARM_STORAGE_OPERATION
         case ARM_STORAGE_OPERATION_ERASE:
         case ARM_STORAGE_OPERATION_ERASE_ALL:
             if (volumeManager->activeVolume != NULL) {
-                /* Reset activeVolume and invoke callback. We reset activeVolume before the
-                 * callback because the callback may attempt to launch another asynchronous
-                 * operation, which requires 'activeVolume' to be NULL. */
-                StorageVolume *callbackVolume = volumeManager->activeVolume; /* remember the volume which will receive the callback. */
-                volumeManager->activeVolume   = NULL;
-
-                if (callbackVolume->isAllocated() && callbackVolume->getCallback()) {
-                    (callbackVolume->getCallback())(status, operation);
-                }
+                /* Retire the active requests and issue the next queued request
+                 * before invoking callbacks. A callback may launch another
+                 * operation; issuing first ensures that the new request goes to
+                 * the back of the queue rather than overtaking the waiting ones. */
+                volumeManager->completeActiveRequests(status);
+                volumeManager->issueQueuedRequests();
+                volumeManager->invokeCompletionCallbacks();
             }
             break;
 
@@ -284,3 +285,239 @@ size_t StorageVolumeManager::findIndexOfUnusedVolume(void) const {
     }
     return index;
 }
+
+int32_t StorageVolumeManager::submit(StorageVolume *volume)
+{
+    StorageVolume::Request_t *requestP = &volume->request;
+
+    /* The completion of an asynchronous MTD runs in interrupt context and
+     * issues the queued requests, so either queue behind the active request
+     * or claim the MTD without the completion coming in between. */
+    core_util_critical_section_enter();
+    requestP->sequence   = nextSequence++;
+    requestP->submitTime = now();
+
+    if (activeVolume != NULL) {
+        requestP->state = StorageVolume::REQUEST_QUEUED;
+        volume->stats.queuedOps++;
+        core_util_critical_section_exit();
+        tr_debug("StorageVolumeManager::submit: queueing operation %u", requestP->operation);
+        return ARM_DRIVER_OK; /* the callback will follow once the request has been issued and completed */
+    }
+    activeVolume = volume;
+    core_util_critical_section_exit();
+
+    int32_t rc = issue(volume);
+    if (rc != ARM_DRIVER_OK) {
+        /* Synchronous completion or failure; the queue was empty when the MTD
+         * was claimed, so nothing can have been merged into this request. */
+        completeActiveRequests(rc);
+        requestP->state = StorageVolume::REQUEST_IDLE;
+        rc              = requestP->status;
+
+        /* Requests queued from interrupt context in the meantime */
+        issueQueuedRequests();
+        invokeCompletionCallbacks();
+    }
+    return rc;
+}
+
+int32_t StorageVolumeManager::issue(StorageVolume *volume)
+{
+    StorageVolume::Request_t *requestP = &volume->request;
+
+    requestP->issueTime = now();
+    if (requestP->state == StorageVolume::REQUEST_QUEUED) {
+        volume->stats.queueTime += requestP->issueTime - requestP->submitTime;
+    }
+    requestP->state     = StorageVolume::REQUEST_ACTIVE;
+    activeVolume        = volume;
+    activeAddr          = requestP->addr;
+
+    switch (requestP->operation) {
+        case ARM_STORAGE_OPERATION_POWER_CONTROL:
+            return storage->PowerControl(requestP->powerState);
+        case ARM_STORAGE_OPERATION_READ_DATA:
+            return storage->ReadData(requestP->addr, requestP->data, requestP->size);
+        case ARM_STORAGE_OPERATION_PROGRAM_DATA:
+            return issueProgram(volume);
+        case ARM_STORAGE_OPERATION_ERASE:
+            return storage->Erase(requestP->addr, requestP->size);
+        case ARM_STORAGE_OPERATION_ERASE_ALL:
+            return storage->EraseAll();
+        default:
+            return ARM_DRIVER_ERROR;
+    }
+}
+
+int32_t StorageVolumeManager::issueProgram(StorageVolume *volume)
+{
+    StorageVolume::Request_t *requestP = &volume->request;
+
+#if STORAGE_VOLUME_MANAGER_MERGE_BUFFER_SIZE > 0
+    /* Grow the range to be programmed with queued programs to either end of it. */
+    uint64_t runStart = requestP->addr;
+    uint64_t runEnd   = requestP->addr + requestP->size;
+    bool     extended;
+    do {
+        extended = false;
+        for (size_t index = 0; index < MAX_VOLUMES; index++) {
+            StorageVolume::Request_t *candidateP = &volumes[index].request;
+            if ((candidateP->state != StorageVolume::REQUEST_QUEUED) ||
+                (candidateP->operation != ARM_STORAGE_OPERATION_PROGRAM_DATA) ||
+                (((runEnd - runStart) + candidateP->size) > STORAGE_VOLUME_MANAGER_MERGE_BUFFER_SIZE)) {
+                continue;
+            }
+
+            if (candidateP->addr == runEnd) {
+                runEnd = candidateP->addr + candidateP->size;
+            } else if ((candidateP->addr + candidateP->size) == runStart) {
+                runStart = candidateP->addr;
+            } else {
+                continue;
+            }
+            candidateP->state     = StorageVolume::REQUEST_ACTIVE;
+            candidateP->issueTime = requestP->issueTime;
+            volumes[index].stats.queueTime += candidateP->issueTime - candidateP->submitTime;
+            extended              = true;
+        }
+    } while (extended);
+
+    if ((runEnd - runStart) > requestP->size) {
+        for (size_t index = 0; index < MAX_VOLUMES; index++) {
+            StorageVolume::Request_t *mergedP = &volumes[index].request;
+            if (mergedP->state == StorageVolume::REQUEST_ACTIVE) {
+                memcpy(&mergeBuffer[mergedP->addr - runStart], mergedP->programData, mergedP->size);
+                volumes[index].stats.mergedOps++;
+            }
+        }
+
+        tr_debug("StorageVolumeManager::issueProgram: merged programs into [%" PRIu32 ", %" PRIu32 ")", (uint32_t)runStart, (uint32_t)runEnd);
+        activeAddr = runStart;
+        return storage->ProgramData(runStart, mergeBuffer, (uint32_t)(runEnd - runStart));
+    }
+#endif /* #if STORAGE_VOLUME_MANAGER_MERGE_BUFFER_SIZE > 0 */
+
+    return storage->ProgramData(requestP->addr, requestP->programData, requestP->size);
+}
+
+StorageVolume *StorageVolumeManager::selectNextRequest(void)
+{
+    StorageVolume *oldest     = NULL;
+    StorageVolume *oldestRead = NULL;
+    for (size_t index = 0; index < MAX_VOLUMES; index++) {
+        StorageVolume *volume = &volumes[index];
+        if (volume->request.state != StorageVolume::REQUEST_QUEUED) {
+            continue;
+        }
+
+        /* sequence numbers are compared in a manner which tolerates wrap-around */
+        if ((oldest == NULL) || ((int32_t)(volume->request.sequence - oldest->request.sequence) < 0)) {
+            oldest = volume;
+        }
+        if ((volume->request.operation == ARM_STORAGE_OPERATION_READ_DATA) &&
+            ((oldestRead == NULL) || ((int32_t)(volume->request.sequence - oldestRead->request.sequence) < 0))) {
+            oldestRead = volume;
+        }
+    }
+
+    if ((oldestRead != NULL) && (oldestRead != oldest) && (readsBypassed < STORAGE_VOLUME_MANAGER_MAX_READ_BYPASS)) {
+        readsBypassed++;
+        return oldestRead;
+    }
+    readsBypassed = 0;
+    return oldest;
+}
+
+void StorageVolumeManager::issueQueuedRequests(void)
+{
+    while (true) {
+        /* claim the MTD for the next request, unless a submit got there first */
+        core_util_critical_section_enter();
+        StorageVolume *volume = (activeVolume == NULL) ? selectNextRequest() : NULL;
+        if (volume != NULL) {
+            activeVolume = volume;
+        }
+        core_util_critical_section_exit();
+        if (volume == NULL) {
+            break;
+        }
+
+        int32_t rc = issue(volume);
+        if (rc != ARM_DRIVER_OK) {
+            /* synchronous completion or failure; either is reported through the callback */
+            completeActiveRequests(rc);
+        }
+    }
+}
+
+void StorageVolumeManager::completeActiveRequests(int32_t status)
+{
+    const uint32_t completionTime = now();
+
+    for (size_t index = 0; index < MAX_VOLUMES; index++) {
+        StorageVolume            *volume   = &volumes[index];
+        StorageVolume::Request_t *requestP = &volume->request;
+        if (requestP->state != StorageVolume::REQUEST_ACTIVE) {
+            continue;
+        }
+
+        int32_t requestStatus = status;
+        if ((status > ARM_DRIVER_OK) && (requestP->operation == ARM_STORAGE_OPERATION_PROGRAM_DATA)) {
+            /* apportion the bytes programmed by a merged program */
+            uint64_t offset = requestP->addr - activeAddr;
+            if ((uint64_t)status <= offset) {
+                requestStatus = ARM_DRIVER_ERROR;
+            } else if (((uint64_t)status - offset) < requestP->size) {
+                requestStatus = (int32_t)((uint64_t)status - offset);
+            } else {
+                requestStatus = (int32_t)requestP->size;
+            }
+        }
+
+        if (requestStatus >= ARM_DRIVER_OK) {
+            StorageVolumeStats_t *statsP = &volume->stats;
+            statsP->serviceTime += completionTime - requestP->issueTime;
+            switch (requestP->operation) {
+                case ARM_STORAGE_OPERATION_READ_DATA:
+                    statsP->readOps++;
+                    statsP->bytesRead += (uint32_t)requestStatus;
+                    break;
+                case ARM_STORAGE_OPERATION_PROGRAM_DATA:
+                    statsP->programOps++;
+                    statsP->bytesProgrammed += (uint32_t)requestStatus;
+                    break;
+                case ARM_STORAGE_OPERATION_ERASE:
+                case ARM_STORAGE_OPERATION_ERASE_ALL:
+                    statsP->eraseOps++;
+                    statsP->bytesErased += (uint32_t)requestStatus;
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        requestP->status = requestStatus;
+        requestP->state  = StorageVolume::REQUEST_COMPLETED;
+    }
+
+    activeVolume = NULL;
+}
+
+void StorageVolumeManager::invokeCompletionCallbacks(void)
+{
+    for (size_t index = 0; index < MAX_VOLUMES; index++) {
+        StorageVolume            *volume   = &volumes[index];
+        StorageVolume::Request_t *requestP = &volume->request;
+        if (requestP->state != StorageVolume::REQUEST_COMPLETED) {
+            continue;
+        }
+
+        /* The request is retired before the callback because the callback may
+         * attempt to launch another operation on the same volume. */
+        requestP->state = StorageVolume::REQUEST_IDLE;
+        if (volume->isAllocated() && volume->getCallback()) {
+            (volume->getCallback())(requestP->status, requestP->operation);
+        }
+    }
+}
@@ -38,6 +38,29 @@
 typedef char AssertStorageVolumeManagerMaxVolumesIsSane[(((MAX_VOLUMES) > 0) && ((MAX_VOLUMES) <= 8)) ? 0:-1];
 #endif
 
+/**<
+ * Size of the buffer used to merge programs to adjacent ranges (typically
+ * belonging to neighbouring volumes) into a single ProgramData() on the
+ * underlying MTD. Setting this to 0 disables merging.
+ */
+#if !defined(YOTTA_CFG_STORAGE_VOLUME_MANAGER_MERGE_BUFFER_SIZE)
+#define STORAGE_VOLUME_MANAGER_MERGE_BUFFER_SIZE 512
+#else
+#define STORAGE_VOLUME_MANAGER_MERGE_BUFFER_SIZE YOTTA_CFG_STORAGE_VOLUME_MANAGER_MERGE_BUFFER_SIZE
+#endif
+
+/**<
+ * The number of queued reads which may be issued in succession ahead of an
+ * older program or erase. Reads are favoured because their callers are usually
+ * waiting on the result; the bound keeps a stream of reads from starving the
+ * other volumes.
+ */
+#if !defined(YOTTA_CFG_STORAGE_VOLUME_MANAGER_MAX_READ_BYPASS)
+#define STORAGE_VOLUME_MANAGER_MAX_READ_BYPASS 4
+#else
+#define STORAGE_VOLUME_MANAGER_MAX_READ_BYPASS YOTTA_CFG_STORAGE_VOLUME_MANAGER_MAX_READ_BYPASS
+#endif
+
 #define CONCATENATE(A, B) A ## B
 #define EXPAND(X) X /* this adds a level of indirection needed to allow macro-expansion following a token-paste operation (see use of CONCATENATE() below). */
 
@@ -84,11 +107,38 @@ typedef enum _StorageVolumeManager_Status
 } StorageVolumeManager_Status_t;
 
 typedef void (*InitializeCallback_t)(int32_t status);
+
+/**
+ * A free-running clock used to time requests for StorageVolumeStats_t. It may
+ * count in any unit (for instance, microseconds from the us_ticker); the
+ * statistics are reported in the same unit.
+ */
+typedef uint32_t (*StorageVolumeManagerClock_t)(void);
+
+/**
+ * Per-volume statistics. Operations are counted upon successful completion.
+ */
+typedef struct _StorageVolumeStats
+{
+    uint32_t readOps;
+    uint32_t programOps;
+    uint32_t eraseOps;
+    uint64_t bytesRead;
+    uint64_t bytesProgrammed;
+    uint64_t bytesErased;
+    uint32_t queuedOps;   ///< requests which had to wait for another volume's activity to finish
+    uint32_t mergedOps;   ///< programs which were merged with a program to an adjacent range
+    uint32_t queueTime;   ///< cumulative time spent by requests waiting in the queue
+    uint32_t serviceTime; ///< cumulative time between issuing requests to the MTD and their completion
+} StorageVolumeStats_t;
+
 class StorageVolumeManager; /* forward declaration */
 
 class StorageVolume {
 public:
-    StorageVolume() : allocated(false) { /* empty */ }
+    StorageVolume() : allocated(false) {
+        request.state = REQUEST_IDLE;
+    }
 
 public:
     void setup(uint64_t addr, uint64_t size, StorageVolumeManager *volumeManager);
@@ -134,6 +184,10 @@ public:
     const ARM_Storage_Callback_t &getCallback(void) const {
         return callback;
     }
+    const StorageVolumeStats_t &getStats(void) const {
+        return stats;
+    }
+    void resetStats(void);
 
 private:
     bool overlapsWithBlock(const ARM_STORAGE_BLOCK* blockP) const {
@@ -151,17 +205,48 @@ private:
         blockP->addr -= volumeOffset;
     }
 
+private:
+    friend class StorageVolumeManager;
+
+    typedef enum {
+        REQUEST_IDLE,
+        REQUEST_QUEUED,    /* waiting for the MTD to finish activity on behalf of another volume */
+        REQUEST_ACTIVE,    /* issued to the MTD */
+        REQUEST_COMPLETED, /* completed asynchronously; the callback is yet to be invoked */
+    } RequestState_t;
+
+    /* Each volume may have a single outstanding request; this mirrors the
+     * semantics of ARM_DRIVER_STORAGE, where a completion callback doesn't
+     * identify the request. */
+    struct Request_t {
+        RequestState_t          state;
+        ARM_STORAGE_OPERATION   operation;
+        uint64_t                addr; /* absolute address on the MTD */
+        union {
+            void               *data;
+            const void         *programData;
+            ARM_POWER_STATE     powerState;
+        };
+        uint32_t                size;
+        uint32_t                sequence;  /* order of submission; used to pick the next request */
+        uint32_t                submitTime;
+        uint32_t                issueTime;
+        int32_t                 status;    /* status to be reported to the callback */
+    };
+
 private:
     bool                    allocated;
     uint64_t                volumeOffset;
     uint64_t                volumeSize;
     ARM_Storage_Callback_t  callback;
     StorageVolumeManager   *volumeManager;
+    Request_t               request;
+    StorageVolumeStats_t    stats;
 };
 
 class StorageVolumeManager {
 public:
-    StorageVolumeManager()  { /* empty */ }
+    StorageVolumeManager() : clock(NULL) { /* empty */ }
     ~StorageVolumeManager() { /* empty */ }
 
     /**
@@ -185,6 +270,14 @@ public:
     int32_t addVolume_C(uint64_t addr, uint64_t size, _ARM_DRIVER_STORAGE *mtd);
     int32_t lookupVolume(uint64_t addr, StorageVolume **volumePP);
 
+    /**
+     * Install a clock to time requests for the per-volume statistics. Without
+     * a clock, only operations and bytes are counted.
+     */
+    void setClock(StorageVolumeManagerClock_t _clock) {
+        clock = _clock;
+    }
+
     /*
      * Accessor methods.
      */
@@ -218,10 +311,10 @@ private:
     StorageVolume *activeVolume; /* This state-variable is set to point to a volume
                                   * while there is pending activity. It tracks
                                   * the volume which is at the source of the
-                                  * activity. Once the activity finishes, this
-                                  * variable is reset. Having this variable set
-                                  * might be used as an indication that the
-                                  * underlying storage is busy. */
+                                  * activity (other volumes may have had their
+                                  * programs merged into it). Once the activity
+                                  * finishes, this variable is reset. Requests
+                                  * submitted while it is set are queued. */
 
 #define FRIEND_DECLARATIONS_FOR_VOLUME(N) \
   friend ARM_DRIVER_VERSION       GetVersion_ ## N(void);                                                       \
@@ -253,12 +346,37 @@ private:
 private:
     size_t findIndexOfUnusedVolume(void) const;
 
+    /*
+     * Request queue. A volume's request is submitted to the MTD right away if
+     * the MTD is idle; otherwise it waits until the activity in progress
+     * completes. Queued reads are issued ahead of older programs and erases
+     * (up to STORAGE_VOLUME_MANAGER_MAX_READ_BYPASS times in a row), and
+     * queued programs to adjacent ranges are merged into a single program.
+     */
+    int32_t submit(StorageVolume *volume);
+    int32_t issue(StorageVolume *volume);
+    int32_t issueProgram(StorageVolume *volume);
+    StorageVolume *selectNextRequest(void);
+    void issueQueuedRequests(void);
+    void completeActiveRequests(int32_t status);
+    void invokeCompletionCallbacks(void);
+    uint32_t now(void) const {
+        return (clock != NULL) ? clock() : 0;
+    }
+
 private:
     bool                      initialized;
     ARM_DRIVER_STORAGE       *storage;
     ARM_STORAGE_INFO          storageInfo;
     ARM_STORAGE_CAPABILITIES  storageCapabilities;
     StorageVolume             volumes[MAX_VOLUMES];
+    StorageVolumeManagerClock_t clock;
+    uint64_t                  activeAddr;     /* start of the range covered by the active program */
+    uint32_t                  nextSequence;
+    uint32_t                  readsBypassed;  /* consecutive reads issued ahead of an older request */
+#if STORAGE_VOLUME_MANAGER_MERGE_BUFFER_SIZE > 0
+    uint8_t                   mergeBuffer[STORAGE_VOLUME_MANAGER_MERGE_BUFFER_SIZE];
+#endif
 };
 
 #endif /* __STORAGE_VOLUME_MANAGER_H__ */
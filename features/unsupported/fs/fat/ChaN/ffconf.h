@@ -45,7 +45,7 @@
 /* This option switches f_mkfs() function. (0:Disable or 1:Enable) */
 
 
-#define	_USE_FASTSEEK	0
+#define	_USE_FASTSEEK	1
 /* This option switches fast seek feature. (0:Disable or 1:Enable) */
 
 
@@ -92,13 +92,15 @@
 */
 
 
-#define	_USE_LFN	1
+#define	_USE_LFN	2
 #define	_MAX_LFN	255
 /* The _USE_LFN option switches the LFN feature.
 /
 /   0: Disable LFN feature. _MAX_LFN has no effect.
 /   1: Enable LFN with static working buffer on the BSS. Always NOT thread-safe.
 /   2: Enable LFN with dynamic working buffer on the STACK.
+/  The buffer takes (_MAX_LFN + 1) * 2 bytes of the stack of the calling thread
+/  in the functions which look up a path.
 /   3: Enable LFN with dynamic working buffer on the HEAP.
 /
 /  When enable the LFN feature, Unicode handling functions (option/unicode.c) must
@@ -140,7 +142,7 @@
 / Drive/Volume Configurations
 /---------------------------------------------------------------------------*/
 
-#define _VOLUMES	1
+#define _VOLUMES	4
 /* Number of volumes (logical drives) to be used. */
 
 
@@ -216,7 +218,7 @@
 /  These options have no effect at read-only configuration (_FS_READONLY == 1). */
 
 
-#define	_FS_LOCK	0
+#define	_FS_LOCK	16
 /* The _FS_LOCK option switches file lock feature to control duplicated file open
 /  and illegal operation to open objects. This option must be 0 when _FS_READONLY
 /  is 1.
@@ -225,12 +227,17 @@
 /      should avoid illegal open, remove and rename to the open objects.
 /  >0: Enable file lock feature. The value defines how many files/sub-directories
 /      can be opened simultaneously under file lock control. Note that the file
-/      lock feature is independent of re-entrancy. */
+/      lock feature is independent of re-entrancy.
+/
+/  With the lock, a file can be open for reading any number of times or for
+/  writing once. The lock table is shared by all volumes, so FATFileSystem
+/  serializes the functions which use it (open, close, unlink and rename).
+/  16 matches the number of file handles retarget.cpp can have open. */
 
 
-#define _FS_REENTRANT	0
+#define _FS_REENTRANT	1
 #define _FS_TIMEOUT		1000
-#define	_SYNC_t			HANDLE
+#define	_SYNC_t			void*
 /* The _FS_REENTRANT option switches the re-entrancy (thread safe) of the FatFs
 /  module itself. Note that regardless of this option, file access to different
 /  volume is always re-entrant and volume control functions, f_mount(), f_mkfs()
@@ -246,7 +253,11 @@
 /  The _FS_TIMEOUT defines timeout period in unit of time tick.
 /  The _SYNC_t defines O/S dependent sync object type. e.g. HANDLE, ID, OS_EVENT*,
 /  SemaphoreHandle_t and etc.. A header file for O/S definitions needs to be
-/  included somewhere in the scope of ff.c. */
+/  included somewhere in the scope of ff.c.
+/
+/  The sync object of a volume is the PlatformMutex of its FATFileSystem, see
+/  syscall.cpp. The grant is waited for without a timeout, so _FS_TIMEOUT has
+/  no effect. */
 
 
 #define _WORD_ACCESS	0
@@ -0,0 +1,64 @@
+/*-----------------------------------------------------------------------*/
+/* OS dependent controls for FatFs                                        */
+/*-----------------------------------------------------------------------*/
+/* The sync object of a volume is the mutex of the FATFileSystem which     */
+/* owns it, so it is created and deleted along with the FATFileSystem      */
+/* rather than on f_mount().                                              */
+/*-----------------------------------------------------------------------*/
+
+#include "ff.h"
+#include "FATFileSystem.h"
+
+#if _FS_REENTRANT
+
+/*-----------------------------------------------------------------------*/
+/* Create a Synchronization Object                                       */
+/*-----------------------------------------------------------------------*/
+
+int ff_cre_syncobj (
+    BYTE vol,          /* Corresponding volume (logical drive number) */
+    _SYNC_t *sobj      /* Pointer to return the created sync object */
+)
+{
+    if (FATFileSystem::_ffs[vol] == NULL) {
+        return 0;
+    }
+    *sobj = &FATFileSystem::_ffs[vol]->_volume_mutex;
+    return 1;
+}
+
+/*-----------------------------------------------------------------------*/
+/* Delete a Synchronization Object                                       */
+/*-----------------------------------------------------------------------*/
+
+int ff_del_syncobj (
+    _SYNC_t sobj       /* Sync object tied to the logical drive to be deleted */
+)
+{
+    return 1;
+}
+
+/*-----------------------------------------------------------------------*/
+/* Request Grant to Access the Volume                                    */
+/*-----------------------------------------------------------------------*/
+
+int ff_req_grant (
+    _SYNC_t sobj       /* Sync object to wait */
+)
+{
+    static_cast<PlatformMutex *>(sobj)->lock();
+    return 1;
+}
+
+/*-----------------------------------------------------------------------*/
+/* Release Grant to Access the Volume                                    */
+/*-----------------------------------------------------------------------*/
+
+void ff_rel_grant (
+    _SYNC_t sobj       /* Sync object to be signaled */
+)
+{
+    static_cast<PlatformMutex *>(sobj)->unlock();
+}
+
+#endif
@@ -0,0 +1,414 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2017 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "ffconf.h"
+#include "mbed_debug.h"
+
+#include "FATFileSystem.h"
+#include "FATBlockCache.h"
+
+#define SECTOR_SIZE     _MAX_SS
+#define NO_SECTOR       0xFFFFFFFF
+
+FATBlockCache::FATBlockCache(FATFileSystem *fs) :
+    _fs(fs), _blocks(FAT_CACHE_BLOCKS), _window_size(FAT_CACHE_READ_AHEAD), _streams(FAT_CACHE_STREAMS),
+    _allocated(false), _lines(NULL), _line_data(NULL), _windows(NULL), _window_data(NULL), _clock(0),
+    _next_read(NO_SECTOR), _next_write(NO_SECTOR) {
+}
+
+FATBlockCache::~FATBlockCache() {
+    release();
+}
+
+int FATBlockCache::configure(uint32_t blocks, uint32_t read_ahead, uint32_t streams) {
+    if (sync()) {
+        return -1;
+    }
+    release();
+    _blocks = blocks;
+    _window_size = read_ahead;
+    _streams = streams;
+    return 0;
+}
+
+void FATBlockCache::allocate() {
+    if (_allocated) {
+        return;
+    }
+    if (!_window_size) {
+        _streams = 0;
+    }
+    if (_blocks) {
+        _lines = (Line *)calloc(_blocks, sizeof(Line));
+        _line_data = (uint8_t *)malloc(_blocks * SECTOR_SIZE);
+    }
+    if (_streams) {
+        _windows = (Window *)calloc(_streams, sizeof(Window));
+        _window_data = (uint8_t *)malloc(_streams * _window_size * SECTOR_SIZE);
+    }
+    if ((_blocks && (!_lines || !_line_data)) || (_streams && (!_windows || !_window_data))) {
+        // Carry on uncached rather than failing the filesystem
+        debug_if(FFS_DBG, "FATBlockCache: couldn't allocate %d + %d x %d sectors\n", _blocks, _streams, _window_size);
+        release();
+        _blocks = 0;
+        _streams = 0;
+    }
+    for (uint32_t i = 0; i < _streams; i++) {
+        _windows[i].data = &_window_data[i * _window_size * SECTOR_SIZE];
+    }
+    _allocated = true;
+}
+
+void FATBlockCache::release() {
+    free(_lines);
+    free(_line_data);
+    free(_windows);
+    free(_window_data);
+    _lines = NULL;
+    _line_data = NULL;
+    _windows = NULL;
+    _window_data = NULL;
+    _allocated = false;
+    invalidate();
+}
+
+void FATBlockCache::invalidate() {
+    for (uint32_t i = 0; _lines && i < _blocks; i++) {
+        _lines[i].valid = false;
+        _lines[i].dirty = false;
+    }
+    for (uint32_t i = 0; _windows && i < _streams; i++) {
+        _windows[i].count = 0;
+        _windows[i].dirty = false;
+    }
+    _next_read = NO_SECTOR;
+    _next_write = NO_SECTOR;
+}
+
+FATBlockCache::Line *FATBlockCache::lookup(uint32_t sector) {
+    for (uint32_t i = 0; i < _blocks; i++) {
+        if (_lines[i].valid && _lines[i].sector == sector) {
+            return &_lines[i];
+        }
+    }
+    return NULL;
+}
+
+FATBlockCache::Line *FATBlockCache::victim() {
+    Line *oldest = &_lines[0];
+    for (uint32_t i = 0; i < _blocks; i++) {
+        if (!_lines[i].valid) {
+            return &_lines[i];
+        }
+        if ((int32_t)(_lines[i].stamp - oldest->stamp) < 0) {
+            oldest = &_lines[i];
+        }
+    }
+    return oldest;
+}
+
+uint8_t *FATBlockCache::line_data(Line *line) {
+    return &_line_data[(line - _lines) * SECTOR_SIZE];
+}
+
+int FATBlockCache::flush_line(Line *line) {
+    if (line->valid && line->dirty) {
+        if (_fs->disk_write(line_data(line), line->sector, 1)) {
+            return -1;
+        }
+        line->dirty = false;
+    }
+    return 0;
+}
+
+/* Find the window holding 'sector', or, with 'dirty', the dirty window holding
+ * it. Any window holding a sector has its current contents. */
+FATBlockCache::Window *FATBlockCache::find_window(uint32_t sector, bool dirty) {
+    for (uint32_t i = 0; i < _streams; i++) {
+        Window *window = &_windows[i];
+        if (window->count && sector >= window->sector && sector < window->sector + window->count &&
+            (window->dirty || !dirty)) {
+            return window;
+        }
+    }
+    return NULL;
+}
+
+FATBlockCache::Window *FATBlockCache::window_victim() {
+    Window *oldest = &_windows[0];
+    for (uint32_t i = 0; i < _streams; i++) {
+        if (!_windows[i].count) {
+            return &_windows[i];
+        }
+        if ((int32_t)(_windows[i].stamp - oldest->stamp) < 0) {
+            oldest = &_windows[i];
+        }
+    }
+    return oldest;
+}
+
+int FATBlockCache::flush_window(Window *window) {
+    if (window->dirty) {
+        if (_fs->disk_write(window->data, window->sector, window->count)) {
+            return -1;
+        }
+        // The contents stay valid for reading
+        window->dirty = false;
+    }
+    return 0;
+}
+
+/* Copy those sectors of 'buffer' which are also held in 'copy' over to 'copy'. */
+static void update_copy(uint8_t *copy, uint32_t copy_sector, uint32_t copy_count,
+                        const uint8_t *buffer, uint32_t sector, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        if (sector + i >= copy_sector && sector + i < copy_sector + copy_count) {
+            memcpy(&copy[(sector + i - copy_sector) * SECTOR_SIZE], &buffer[i * SECTOR_SIZE], SECTOR_SIZE);
+        }
+    }
+}
+
+void FATBlockCache::update_windows(const uint8_t *buffer, uint32_t sector, uint32_t count) {
+    for (uint32_t i = 0; i < _streams; i++) {
+        update_copy(_windows[i].data, _windows[i].sector, _windows[i].count, buffer, sector, count);
+    }
+}
+
+int FATBlockCache::fill_window(Window *window, uint32_t sector) {
+    if (flush_window(window)) {
+        return -1;
+    }
+    uint32_t count = _window_size;
+    uint32_t sectors = _fs->disk_sectors();
+    if (sector < sectors && sectors - sector < count) {
+        count = sectors - sector;
+    }
+    window->count = 0;
+    if (_fs->disk_read(window->data, sector, count)) {
+        return -1;
+    }
+
+    // Sectors which haven't been written back yet are newer
+    for (uint32_t i = 0; i < _blocks; i++) {
+        if (_lines[i].valid && _lines[i].dirty) {
+            update_copy(window->data, sector, count, line_data(&_lines[i]), _lines[i].sector, 1);
+        }
+    }
+    for (uint32_t i = 0; i < _streams; i++) {
+        if (_windows[i].dirty) {
+            update_copy(window->data, sector, count, _windows[i].data, _windows[i].sector, _windows[i].count);
+        }
+    }
+    window->sector = sector;
+    window->count = count;
+    window->stamp = ++_clock;
+    return 0;
+}
+
+int FATBlockCache::read(uint8_t *buffer, uint32_t sector, uint32_t count) {
+    allocate();
+
+    if (count == 1) {
+        Line *line = _blocks ? lookup(sector) : NULL;
+        if (line) {
+            memcpy(buffer, line_data(line), SECTOR_SIZE);
+            line->stamp = ++_clock;
+            _next_read = sector + 1;
+            return 0;
+        }
+        Window *window = find_window(sector, false);
+        if (window) {
+            memcpy(buffer, &window->data[(sector - window->sector) * SECTOR_SIZE], SECTOR_SIZE);
+            window->stamp = ++_clock;
+            _next_read = sector + 1;
+            return 0;
+        }
+        if (_streams) {
+            // Sequential reads (file data, directory scans) bypass the LRU so
+            // that they don't evict the FAT sectors. A read following on from
+            // a window continues that stream; otherwise a new one is started.
+            for (uint32_t i = 0; i < _streams && !window; i++) {
+                if (_windows[i].count && !_windows[i].dirty && sector == _windows[i].sector + _windows[i].count) {
+                    window = &_windows[i];
+                }
+            }
+            if (!window && sector == _next_read) {
+                window = window_victim();
+            }
+        }
+        if (window) {
+            if (fill_window(window, sector)) {
+                return 1;
+            }
+            memcpy(buffer, window->data, SECTOR_SIZE);
+            _next_read = sector + 1;
+            return 0;
+        }
+        if (_blocks) {
+            line = victim();
+            if (flush_line(line)) {
+                return 1;
+            }
+            line->valid = false;
+            if (_fs->disk_read(line_data(line), sector, 1)) {
+                return 1;
+            }
+            line->valid = true;
+            line->dirty = false;
+            line->sector = sector;
+            line->stamp = ++_clock;
+            memcpy(buffer, line_data(line), SECTOR_SIZE);
+            _next_read = sector + 1;
+            return 0;
+        }
+    }
+
+    if (_fs->disk_read(buffer, sector, count)) {
+        return 1;
+    }
+    // Overlay the sectors which haven't been written back yet
+    for (uint32_t i = 0; i < _blocks; i++) {
+        if (_lines[i].valid && _lines[i].dirty) {
+            update_copy(buffer, sector, count, line_data(&_lines[i]), _lines[i].sector, 1);
+        }
+    }
+    for (uint32_t i = 0; i < _streams; i++) {
+        if (_windows[i].dirty) {
+            update_copy(buffer, sector, count, _windows[i].data, _windows[i].sector, _windows[i].count);
+        }
+    }
+    _next_read = sector + count;
+    return 0;
+}
+
+int FATBlockCache::write(const uint8_t *buffer, uint32_t sector, uint32_t count) {
+    allocate();
+
+    if (count == 1) {
+        Window *window = find_window(sector, true);
+        if (window) {
+            memcpy(&window->data[(sector - window->sector) * SECTOR_SIZE], buffer, SECTOR_SIZE);
+            window->stamp = ++_clock;
+            update_windows(buffer, sector, 1);
+            _next_write = sector + 1;
+            return 0;
+        }
+        Line *line = _blocks ? lookup(sector) : NULL;
+        if (line) {
+            memcpy(line_data(line), buffer, SECTOR_SIZE);
+            line->dirty = true;
+            line->stamp = ++_clock;
+            update_windows(buffer, sector, 1);
+            _next_write = sector + 1;
+            return 0;
+        }
+        if (_streams) {
+            // Sequential writes (appends) are collected in a window and written
+            // with a single multiple sector write
+            for (uint32_t i = 0; i < _streams && !window; i++) {
+                if (_windows[i].dirty && sector == _windows[i].sector + _windows[i].count) {
+                    window = &_windows[i];
+                }
+            }
+            if (window && window->count < _window_size) {
+                memcpy(&window->data[window->count * SECTOR_SIZE], buffer, SECTOR_SIZE);
+                window->count++;
+                window->stamp = ++_clock;
+                update_windows(buffer, sector, 1);
+                _next_write = sector + 1;
+                return 0;
+            }
+            if (!window && sector == _next_write) {
+                window = window_victim();
+            }
+            if (window) {
+                if (flush_window(window)) {
+                    return 1;
+                }
+                update_windows(buffer, sector, 1);
+                memcpy(window->data, buffer, SECTOR_SIZE);
+                window->sector = sector;
+                window->count = 1;
+                window->stamp = ++_clock;
+                window->dirty = true;
+                _next_write = sector + 1;
+                return 0;
+            }
+        }
+        if (_blocks) {
+            line = victim();
+            if (flush_line(line)) {
+                return 1;
+            }
+            memcpy(line_data(line), buffer, SECTOR_SIZE);
+            line->valid = true;
+            line->dirty = true;
+            line->sector = sector;
+            line->stamp = ++_clock;
+            update_windows(buffer, sector, 1);
+            _next_write = sector + 1;
+            return 0;
+        }
+    }
+
+    if (_fs->disk_write(buffer, sector, count)) {
+        return 1;
+    }
+    for (uint32_t i = 0; i < _blocks; i++) {
+        if (_lines[i].valid && _lines[i].sector >= sector && _lines[i].sector < sector + count) {
+            memcpy(line_data(&_lines[i]), &buffer[(_lines[i].sector - sector) * SECTOR_SIZE], SECTOR_SIZE);
+            _lines[i].dirty = false;
+        }
+    }
+    update_windows(buffer, sector, count);
+    _next_write = sector + count;
+    return 0;
+}
+
+int FATBlockCache::sync() {
+    if (!_allocated) {
+        return 0;
+    }
+    int err = 0;
+    for (uint32_t i = 0; i < _streams; i++) {
+        if (flush_window(&_windows[i])) {
+            err = -1;
+        }
+    }
+    for (;;) {
+        Line *next = NULL;
+        for (uint32_t i = 0; i < _blocks; i++) {
+            if (_lines[i].valid && _lines[i].dirty && (!next || _lines[i].sector < next->sector)) {
+                next = &_lines[i];
+            }
+        }
+        if (!next) {
+            break;
+        }
+        if (flush_line(next)) {
+            return -1;
+        }
+    }
+    return err;
+}
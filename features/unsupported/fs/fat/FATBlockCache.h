@@ -0,0 +1,128 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2017 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef MBED_FATBLOCKCACHE_H
+#define MBED_FATBLOCKCACHE_H
+
+#include <stdint.h>
+
+/* Number of sectors held in the LRU cache of each FATFileSystem. FAT and
+ * directory sectors live here; single sector writes are held dirty until they
+ * are evicted or the filesystem is synced. 0 disables the cache. */
+#ifndef FAT_CACHE_BLOCKS
+#define FAT_CACHE_BLOCKS        4
+#endif
+
+/* Number of sectors in the sequential window. The window is filled with a
+ * single multiple sector read when reads run sequentially, and collects
+ * sequential single sector writes (appends) so that they reach the device as
+ * a single multiple sector write. 0 disables read-ahead and write combining. */
+#ifndef FAT_CACHE_READ_AHEAD
+#define FAT_CACHE_READ_AHEAD    4
+#endif
+
+/* Number of sequential windows, so that the streams of threads reading or
+ * appending to different files at the same time don't evict each other. */
+#ifndef FAT_CACHE_STREAMS
+#define FAT_CACHE_STREAMS       2
+#endif
+
+class FATFileSystem;
+
+/**
+ * Write-back sector cache between FatFs and the disk_* methods of a
+ * FATFileSystem.
+ *
+ * Dirty sectors reach the device when they are evicted or on sync(), which is
+ * called for CTRL_SYNC (f_sync(), f_close()) and on unmount. The cache is not
+ * locked itself; it is only used with the _volume_mutex of its volume held.
+ */
+class FATBlockCache {
+public:
+
+    FATBlockCache(FATFileSystem *fs);
+    ~FATBlockCache();
+
+    /**
+     * Change the number of sectors held, flushing the current contents first.
+     * The buffers are allocated on first use.
+     * @return 0 on success, nonzero if flushing failed
+     */
+    int configure(uint32_t blocks, uint32_t read_ahead, uint32_t streams);
+
+    int read(uint8_t *buffer, uint32_t sector, uint32_t count);
+    int write(const uint8_t *buffer, uint32_t sector, uint32_t count);
+
+    /** Write all dirty sectors to the device: the sequential windows first,
+     * then the cached sectors in ascending order. */
+    int sync();
+
+    /** Drop the cached sectors without writing them back, e.g. when the device
+     * is (re)initialized. */
+    void invalidate();
+
+private:
+
+    struct Line {
+        uint32_t sector;
+        uint32_t stamp;
+        bool valid;
+        bool dirty;
+    };
+
+    struct Window {
+        uint8_t *data;
+        uint32_t sector;            // first sector held
+        uint32_t count;             // number of valid sectors
+        uint32_t stamp;
+        bool dirty;                 // holds combined writes rather than read-ahead
+    };
+
+    void allocate();
+    void release();
+    Line *lookup(uint32_t sector);
+    Line *victim();
+    uint8_t *line_data(Line *line);
+    int flush_line(Line *line);
+    Window *find_window(uint32_t sector, bool dirty);
+    Window *window_victim();
+    int flush_window(Window *window);
+    int fill_window(Window *window, uint32_t sector);
+    void update_windows(const uint8_t *buffer, uint32_t sector, uint32_t count);
+
+    FATFileSystem *_fs;
+
+    uint32_t _blocks;               // configured number of cache lines
+    uint32_t _window_size;          // configured size of a sequential window in sectors
+    uint32_t _streams;              // configured number of sequential windows
+    bool _allocated;
+
+    Line *_lines;
+    uint8_t *_line_data;
+    Window *_windows;
+    uint8_t *_window_data;
+    uint32_t _clock;                // LRU stamp
+
+    uint32_t _next_read;            // sector following the last read
+    uint32_t _next_write;           // sector following the last write
+};
+
+#endif
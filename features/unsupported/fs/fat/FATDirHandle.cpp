@@ -25,14 +25,17 @@
 
 using namespace mbed;
 
-FATDirHandle::FATDirHandle(const FATFS_DIR &the_dir, PlatformMutex * mutex): _mutex(mutex) {
+FATDirHandle::FATDirHandle(const FATFS_DIR &the_dir, PlatformMutex * mutex, PlatformMutex * table_mutex):
+    _mutex(mutex), _table_mutex(table_mutex) {
     dir = the_dir;
 }
 
 int FATDirHandle::closedir() {
+    _table_mutex->lock();
     lock();
     int retval = f_closedir(&dir);
     unlock();
+    _table_mutex->unlock();
     delete this;
     return retval;
 }
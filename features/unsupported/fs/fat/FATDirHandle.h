@@ -30,7 +30,7 @@ using namespace mbed;
 class FATDirHandle : public DirHandle {
 
  public:
-    FATDirHandle(const FATFS_DIR &the_dir, PlatformMutex * mutex);
+    FATDirHandle(const FATFS_DIR &the_dir, PlatformMutex * mutex, PlatformMutex * table_mutex);
     virtual int closedir();
     virtual struct dirent *readdir();
     virtual void rewinddir();
@@ -42,7 +42,8 @@ class FATDirHandle : public DirHandle {
     virtual void lock();
     virtual void unlock();
 
-    PlatformMutex * _mutex;
+    PlatformMutex * _mutex;         // volume
+    PlatformMutex * _table_mutex;   // FatFs file lock table, taken to close
 
  private:
     FATFS_DIR dir;
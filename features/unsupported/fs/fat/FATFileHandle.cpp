@@ -19,20 +19,28 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
  * SOFTWARE.
  */
+#include <stdlib.h>
+
 #include "ff.h"
 #include "ffconf.h"
 #include "mbed_debug.h"
 
 #include "FATFileHandle.h"
 
-FATFileHandle::FATFileHandle(FIL fh, PlatformMutex * mutex): _mutex(mutex) {
+FATFileHandle::FATFileHandle(FIL fh, PlatformMutex * mutex, PlatformMutex * table_mutex):
+    _linkmap_checked(false), _mutex(mutex), _table_mutex(table_mutex) {
     _fh = fh;
 }
 
 int FATFileHandle::close() {
+    _table_mutex->lock();
     lock();
     int retval = f_close(&_fh);
+#if _USE_FASTSEEK
+    free(_fh.cltbl);
+#endif
     unlock();
+    _table_mutex->unlock();
     delete this;
     return retval;
 }
@@ -70,6 +78,9 @@ int FATFileHandle::isatty() {
 
 off_t FATFileHandle::lseek(off_t position, int whence) {
     lock();
+    if (!_linkmap_checked) {
+        create_linkmap();
+    }
     if (whence == SEEK_END) {
         position += _fh.fsize;
     } else if(whence==SEEK_CUR) {
@@ -106,6 +117,37 @@ off_t FATFileHandle::flen() {
     return size;
 }
 
+void FATFileHandle::create_linkmap() {
+    _linkmap_checked = true;
+#if _USE_FASTSEEK
+    // Fast seek mode can't extend a file, so only read only files use it
+    if ((_fh.flag & FA_WRITE) || _fh.fsize / _MAX_SS / _fh.fs->csize < FAT_FASTSEEK_MIN_CLUSTERS) {
+        return;
+    }
+    DWORD size = FAT_FASTSEEK_MAP_SIZE;
+    for (int i = 0; i < 2; i++) {
+        DWORD *linkmap = (DWORD *)realloc(_fh.cltbl, size * sizeof(DWORD));
+        if (linkmap == NULL) {
+            break;
+        }
+        linkmap[0] = size;
+        _fh.cltbl = linkmap;
+        FRESULT res = f_lseek(&_fh, CREATE_LINKMAP);
+        if (res == FR_OK) {
+            debug_if(FFS_DBG, "fast seek enabled, %d link map entries\n", linkmap[0]);
+            return;
+        }
+        if (res != FR_NOT_ENOUGH_CORE) {
+            break;
+        }
+        size = linkmap[0];
+    }
+    // Carry on with the normal seek
+    free(_fh.cltbl);
+    _fh.cltbl = NULL;
+#endif
+}
+
 void FATFileHandle::lock() {
     _mutex->lock();
 }
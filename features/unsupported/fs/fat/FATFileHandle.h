@@ -27,10 +27,23 @@
 
 using namespace mbed;
 
+/* Files opened for reading only which span at least this many clusters get a
+ * cluster link map on their first seek, so that seeking doesn't follow the
+ * cluster chain through the FAT (FatFs fast seek). */
+#ifndef FAT_FASTSEEK_MIN_CLUSTERS
+#define FAT_FASTSEEK_MIN_CLUSTERS   16
+#endif
+
+/* Initial size of the link map in DWORDs, enough for (n - 2) / 2 fragments.
+ * The map is enlarged once if the file is more fragmented. */
+#ifndef FAT_FASTSEEK_MAP_SIZE
+#define FAT_FASTSEEK_MAP_SIZE       16
+#endif
+
 class FATFileHandle : public FileHandle {
 public:
 
-    FATFileHandle(FIL fh, PlatformMutex * mutex);
+    FATFileHandle(FIL fh, PlatformMutex * mutex, PlatformMutex * table_mutex);
     virtual int close();
     virtual ssize_t write(const void* buffer, size_t length);
     virtual ssize_t read(void* buffer, size_t length);
@@ -44,8 +57,12 @@ protected:
     virtual void lock();
     virtual void unlock();
 
+    void create_linkmap();
+
     FIL _fh;
-    PlatformMutex * _mutex;
+    bool _linkmap_checked;
+    PlatformMutex * _mutex;         // volume
+    PlatformMutex * _table_mutex;   // FatFs file lock table, taken to close
 
 };
 
@@ -41,6 +41,15 @@ DWORD get_fattime(void) {
          | (DWORD)(ptm->tm_sec/2    );
 }
 
+/* Room for the drive, a name of up to _MAX_LFN characters and the terminator */
+#define FAT_PATH_SIZE   (sizeof("0:/") + _MAX_LFN)
+
+/* Prefix the FatFs drive to a path; false if it doesn't fit */
+static bool fat_path(char (&path)[FAT_PATH_SIZE], const char *fsid, const char *name) {
+    int len = snprintf(path, sizeof(path), "%s/%s", fsid, name);
+    return (len >= 0) && ((size_t)len < sizeof(path));
+}
+
 FATFileSystem *FATFileSystem::_ffs[_VOLUMES] = {0};
 static PlatformMutex * mutex = NULL;
 
@@ -59,14 +68,15 @@ PlatformMutex * get_fat_mutex() {
     return mutex;
 }
 
-FATFileSystem::FATFileSystem(const char* n) : FileSystemLike(n), _mutex(get_fat_mutex()) {
+FATFileSystem::FATFileSystem(const char* n) : FileSystemLike(n), _cache(this), _mutex(get_fat_mutex()) {
     lock();
     debug_if(FFS_DBG, "FATFileSystem(%s)\n", n);
     for(int i=0; i<_VOLUMES; i++) {
         if(_ffs[i] == 0) {
             _ffs[i] = this;
             _fsid[0] = '0' + i;
-            _fsid[1] = '\0';
+            _fsid[1] = ':';
+            _fsid[2] = '\0';
             debug_if(FFS_DBG, "Mounting [%s] on ffs drive [%s]\n", getName(), _fsid);
             f_mount(&_fs, _fsid, 0);
             unlock();
@@ -91,8 +101,11 @@ FATFileSystem::~FATFileSystem() {
 FileHandle *FATFileSystem::open(const char* name, int flags) {
     lock();
     debug_if(FFS_DBG, "open(%s) on filesystem [%s], drv [%s]\n", name, getName(), _fsid);
-    char n[64];
-    sprintf(n, "%s:/%s", _fsid, name);
+    char n[FAT_PATH_SIZE];
+    if (!fat_path(n, _fsid, name)) {
+        unlock();
+        return NULL;
+    }
 
     /* POSIX flags -> FatFS open mode */
     BYTE openmode;
@@ -121,14 +134,19 @@ FileHandle *FATFileSystem::open(const char* name, int flags) {
     if (flags & O_APPEND) {
         f_lseek(&fh, fh.fsize);
     }
-    FATFileHandle * handle = new FATFileHandle(fh, _mutex);
+    FATFileHandle * handle = new FATFileHandle(fh, &_volume_mutex, _mutex);
     unlock();
     return handle;
 }
 
 int FATFileSystem::remove(const char *filename) {
     lock();
-    FRESULT res = f_unlink(filename);
+    char n[FAT_PATH_SIZE];
+    if (!fat_path(n, _fsid, filename)) {
+        unlock();
+        return -1;
+    }
+    FRESULT res = f_unlink(n);
     if (res) {
         debug_if(FFS_DBG, "f_unlink() failed: %d\n", res);
         unlock();
@@ -140,7 +158,12 @@ int FATFileSystem::remove(const char *filename) {
 
 int FATFileSystem::rename(const char *oldname, const char *newname) {
     lock();
-    FRESULT res = f_rename(oldname, newname);
+    char n[FAT_PATH_SIZE];
+    if (!fat_path(n, _fsid, oldname)) {
+        unlock();
+        return -1;
+    }
+    FRESULT res = f_rename(n, newname);
     if (res) {
         debug_if(FFS_DBG, "f_rename() failed: %d\n", res);
         unlock();
@@ -152,7 +175,9 @@ int FATFileSystem::rename(const char *oldname, const char *newname) {
 
 int FATFileSystem::format() {
     lock();
+    _volume_mutex.lock();
     FRESULT res = f_mkfs(_fsid, 0, 512); // Logical drive number, Partitioning rule, Allocation unit size (bytes per cluster)
+    _volume_mutex.unlock();
     if (res) {
         debug_if(FFS_DBG, "f_mkfs() failed: %d\n", res);
         unlock();
@@ -164,42 +189,64 @@ int FATFileSystem::format() {
 
 DirHandle *FATFileSystem::opendir(const char *name) {
     lock();
+    char n[FAT_PATH_SIZE];
+    if (!fat_path(n, _fsid, name)) {
+        unlock();
+        return NULL;
+    }
     FATFS_DIR dir;
-    FRESULT res = f_opendir(&dir, name);
+    FRESULT res = f_opendir(&dir, n);
     if (res != 0) {
         unlock();
         return NULL;
     }
-    FATDirHandle *handle = new FATDirHandle(dir, _mutex);
+    FATDirHandle *handle = new FATDirHandle(dir, &_volume_mutex, _mutex);
     unlock();
     return handle;
 }
 
 int FATFileSystem::mkdir(const char *name, mode_t mode) {
     lock();
-    FRESULT res = f_mkdir(name);
+    char n[FAT_PATH_SIZE];
+    if (!fat_path(n, _fsid, name)) {
+        unlock();
+        return -1;
+    }
+    FRESULT res = f_mkdir(n);
     unlock();
     return res == 0 ? 0 : -1;
 }
 
 int FATFileSystem::mount() {
     lock();
+    _volume_mutex.lock();
     FRESULT res = f_mount(&_fs, _fsid, 1);
+    _volume_mutex.unlock();
     unlock();
     return res == 0 ? 0 : -1;
 }
 
 int FATFileSystem::unmount() {
     lock();
-    if (disk_sync()) {
+    _volume_mutex.lock();
+    if (_cache.sync() || disk_sync()) {
+        _volume_mutex.unlock();
         unlock();
         return -1;
     }
     FRESULT res = f_mount(NULL, _fsid, 0);
+    _volume_mutex.unlock();
     unlock();
     return res == 0 ? 0 : -1;
 }
 
+int FATFileSystem::set_cache(uint32_t blocks, uint32_t read_ahead, uint32_t streams) {
+    _volume_mutex.lock();
+    int res = _cache.configure(blocks, read_ahead, streams);
+    _volume_mutex.unlock();
+    return res == 0 ? 0 : -1;
+}
+
 void FATFileSystem::lock() {
     _mutex->lock();
 }
@@ -27,11 +27,21 @@
 #include "ff.h"
 #include <stdint.h>
 #include "PlatformMutex.h"
+#include "FATBlockCache.h"
 
 using namespace mbed;
 
 /**
- * FATFileSystem based on ChaN's Fat Filesystem library v0.8 
+ * FATFileSystem based on ChaN's Fat Filesystem library v0.8
+ *
+ * Threads may use different volumes at the same time. Accesses to one volume,
+ * reads included, are serialized by its _volume_mutex.
+ *
+ * TODO: concurrent reads on one volume (a reader/writer split of
+ * _volume_mutex) are not implemented. FatFs keeps a single sector window per
+ * volume, which f_read() moves while following the cluster chain, and the
+ * FATBlockCache is unlocked and performs device I/O itself, so both need
+ * their own locking first, with device I/O outside of it.
  */
 class FATFileSystem : public FileSystemLike {
 public:
@@ -41,7 +51,9 @@ public:
 
     static FATFileSystem * _ffs[_VOLUMES];   // FATFileSystem objects, as parallel to FatFs drives array
     FATFS _fs;                               // Work area (file system object) for logical drive
-    char _fsid[2];
+    char _fsid[3];                           // FatFs drive, "0:"
+    FATBlockCache _cache;                    // Sectors between FatFs and the disk_* methods
+    PlatformMutex _volume_mutex;             // FatFs sync object of the volume, held for file access
 
     /**
      * Opens a file on the filesystem
@@ -83,6 +95,14 @@ public:
      */
     virtual int unmount();
 
+    /**
+     * Sets the number of sectors cached, the size of the sequential
+     * read-ahead/write windows and the number of windows (FAT_CACHE_BLOCKS,
+     * FAT_CACHE_READ_AHEAD and FAT_CACHE_STREAMS by default). Dirty sectors
+     * are written back first; 0 disables either.
+     */
+    int set_cache(uint32_t blocks, uint32_t read_ahead, uint32_t streams = FAT_CACHE_STREAMS);
+
     virtual int disk_initialize() { return 0; }
     virtual int disk_status() { return 0; }
     virtual int disk_read(uint8_t *buffer, uint32_t sector, uint32_t count) = 0;
@@ -92,6 +112,8 @@ public:
 
 protected:
 
+    /* Serializes the volume control functions (mount, unmount, format) and
+     * the FatFs file lock table, both of which are shared by all volumes. */
     virtual void lock();
     virtual void unlock();
 
@@ -0,0 +1,329 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ */
+#include "CppUTest/TestHarness.h"
+#include "FATFileSystem.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* FATFileSystem on RAM disks with threads reading and writing at the same
+ * time. Every record written can be recognised on its own, so readers check
+ * the data of files that writers are still appending to, and a volume that
+ * is left inconsistent shows up again after remounting. */
+
+#define DISK_SECTORS        2048
+#define RECORD_SIZE         64
+#define RECORDS_PER_OPEN    10
+#define WRITERS             3
+#define READERS             3
+#define WRITER_ROUNDS       20
+#define STATIC_RECORDS      200
+#define STATIC_ID           99
+#define OPEN_TRIES          10000
+#define BENCH_ROUNDS        10
+#define STRESS_LATENCY_US   20
+#define BENCH_LATENCY_US    200
+
+class RamDisk : public FATFileSystem {
+public:
+    RamDisk(const char *name) : FATFileSystem(name), latency_us(0), accesses(0), overlaps(0), _inside(0) {
+        _data = (uint8_t *)calloc(DISK_SECTORS, 512);
+    }
+
+    virtual ~RamDisk() {
+        free(_data);
+    }
+
+    virtual int disk_read(uint8_t *buffer, uint32_t sector, uint32_t count) {
+        if (sector + count > DISK_SECTORS) {
+            return 1;
+        }
+        enter();
+        memcpy(buffer, &_data[sector * 512], count * 512);
+        leave();
+        return 0;
+    }
+
+    virtual int disk_write(const uint8_t *buffer, uint32_t sector, uint32_t count) {
+        if (sector + count > DISK_SECTORS) {
+            return 1;
+        }
+        enter();
+        memcpy(&_data[sector * 512], buffer, count * 512);
+        leave();
+        return 0;
+    }
+
+    virtual uint32_t disk_sectors() {
+        return DISK_SECTORS;
+    }
+
+    int latency_us;
+    volatile int accesses;
+    volatile int overlaps;      // Accesses made while another was in progress
+
+private:
+    void enter() {
+        __sync_fetch_and_add(&accesses, 1);
+        if (__sync_fetch_and_add(&_inside, 1) != 0) {
+            __sync_fetch_and_add(&overlaps, 1);
+        }
+        if (latency_us) {
+            usleep(latency_us);
+        }
+    }
+
+    void leave() {
+        __sync_fetch_and_sub(&_inside, 1);
+    }
+
+    uint8_t *_data;
+    volatile int _inside;
+};
+
+typedef struct {
+    RamDisk *disk;
+    int id;
+    int rounds;
+} worker_t;
+
+static volatile int failures;
+static volatile int writers_running;
+static volatile int reads_checked;
+
+static void fail(const char *what, int id)
+{
+    printf("%s (%d)\n", what, id);
+    __sync_fetch_and_add(&failures, 1);
+}
+
+static void make_record(uint8_t *record, int id, uint32_t index)
+{
+    for (int i = 0; i < RECORD_SIZE; i++) {
+        record[i] = (uint8_t)(id * 131 + index * 31 + i);
+    }
+    memcpy(record, &index, sizeof(index));
+}
+
+static void file_name(char *name, int id)
+{
+    sprintf(name, "f%d.dat", id);
+}
+
+static void append_records(RamDisk *disk, int id, uint32_t first, uint32_t count)
+{
+    char name[16];
+    uint8_t record[RECORD_SIZE];
+
+    // The open is refused while a reader has the file
+    file_name(name, id);
+    FileHandle *file = disk->open(name, O_WRONLY | O_CREAT | O_APPEND);
+    for (int tries = 0; file == NULL && tries < OPEN_TRIES; tries++) {
+        usleep(100);
+        file = disk->open(name, O_WRONLY | O_CREAT | O_APPEND);
+    }
+    if (file == NULL) {
+        fail("open for append", id);
+        return;
+    }
+    for (uint32_t i = first; i < first + count; i++) {
+        make_record(record, id, i);
+        if (file->write(record, RECORD_SIZE) != RECORD_SIZE) {
+            fail("write", id);
+        }
+    }
+    if (file->close() != 0) {
+        fail("close after append", id);
+    }
+}
+
+/* Checks every record of a file, returns the number of records or -1 if the
+ * file is open for writing */
+static int check_file(RamDisk *disk, int id)
+{
+    char name[16];
+    uint8_t record[RECORD_SIZE];
+    uint8_t expected[RECORD_SIZE];
+    int count = 0;
+
+    file_name(name, id);
+    FileHandle *file = disk->open(name, O_RDONLY);
+    if (file == NULL) {
+        return -1;
+    }
+    while (true) {
+        ssize_t n = file->read(record, RECORD_SIZE);
+        if (n == 0) {
+            break;
+        }
+        make_record(expected, id, count);
+        if (n != RECORD_SIZE || memcmp(record, expected, RECORD_SIZE) != 0) {
+            fail("record corrupted", id);
+            break;
+        }
+        count++;
+    }
+    file->close();
+    return count;
+}
+
+static void *writer_thread(void *arg)
+{
+    worker_t *worker = (worker_t *)arg;
+    char name[16];
+
+    for (int round = 0; round < worker->rounds; round++) {
+        append_records(worker->disk, worker->id, round * RECORDS_PER_OPEN, RECORDS_PER_OPEN);
+
+        // While the file is open for writing nobody else may write it. The
+        // first open fails too while a reader has the file.
+        file_name(name, worker->id);
+        FileHandle *file = worker->disk->open(name, O_WRONLY);
+        FileHandle *other = worker->disk->open(name, O_WRONLY);
+        if (file != NULL && other != NULL) {
+            fail("exclusive write open", worker->id);
+        }
+        if (file != NULL) {
+            file->close();
+        }
+        if (other != NULL) {
+            other->close();
+        }
+    }
+    __sync_fetch_and_sub(&writers_running, 1);
+    return NULL;
+}
+
+static void *reader_thread(void *arg)
+{
+    worker_t *worker = (worker_t *)arg;
+
+    for (int round = 0; writers_running > 0 || round < worker->rounds; round++) {
+        // The shared file, which all readers may have open at once
+        if (check_file(worker->disk, STATIC_ID) != STATIC_RECORDS) {
+            fail("static file", worker->id);
+        }
+        // A file being appended to: whatever is there must be whole records
+        int count = check_file(worker->disk, round % WRITERS);
+        if (count >= 0) {
+            if (count % RECORDS_PER_OPEN != 0) {
+                fail("partial append visible", worker->id);
+            }
+            __sync_fetch_and_add(&reads_checked, 1);
+        }
+    }
+    return NULL;
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Runs one writer per disk appending to its own file, returns the time taken */
+static double run_writers(RamDisk **disks, int count, int first_id)
+{
+    pthread_t threads[4];
+    worker_t workers[4];
+    double start = now();
+
+    writers_running = count;
+    for (int i = 0; i < count; i++) {
+        workers[i].disk = disks[i];
+        workers[i].id = first_id + i;
+        workers[i].rounds = BENCH_ROUNDS;
+        pthread_create(&threads[i], NULL, writer_thread, &workers[i]);
+    }
+    for (int i = 0; i < count; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    return now() - start;
+}
+
+static RamDisk *disk_a;
+static RamDisk *disk_b;
+
+TEST_GROUP(fat)
+{
+    void setup() {
+        failures = 0;
+        reads_checked = 0;
+        disk_a = new RamDisk("a");
+        disk_b = new RamDisk("b");
+        CHECK(disk_a->format() == 0);
+        CHECK(disk_b->format() == 0);
+        CHECK(disk_a->mount() == 0);
+        CHECK(disk_b->mount() == 0);
+    }
+
+    void teardown() {
+        CHECK(disk_a->unmount() == 0);
+        CHECK(disk_b->unmount() == 0);
+        delete disk_a;
+        delete disk_b;
+    }
+};
+
+TEST(fat, readers_and_writers_on_one_volume)
+{
+    pthread_t threads[WRITERS + READERS];
+    worker_t workers[WRITERS + READERS];
+
+    append_records(disk_a, STATIC_ID, 0, STATIC_RECORDS);
+
+    // A slow device, so that the threads are in the middle of their accesses
+    // at the same time
+    disk_a->latency_us = STRESS_LATENCY_US;
+    writers_running = WRITERS;
+    for (int i = 0; i < WRITERS + READERS; i++) {
+        workers[i].disk = disk_a;
+        workers[i].id = i;
+        workers[i].rounds = i < WRITERS ? WRITER_ROUNDS : 1;
+        pthread_create(&threads[i], NULL, i < WRITERS ? writer_thread : reader_thread, &workers[i]);
+    }
+    for (int i = 0; i < WRITERS + READERS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    CHECK(failures == 0);
+    CHECK(reads_checked > 0);
+    // The device is only ever entered by one thread at a time
+    CHECK(disk_a->overlaps == 0);
+
+    // Everything is there, also after the volume is remounted
+    for (int pass = 0; pass < 2; pass++) {
+        for (int i = 0; i < WRITERS; i++) {
+            CHECK(check_file(disk_a, i) == WRITER_ROUNDS * RECORDS_PER_OPEN);
+        }
+        CHECK(check_file(disk_a, STATIC_ID) == STATIC_RECORDS);
+        CHECK(disk_a->unmount() == 0);
+        CHECK(disk_a->mount() == 0);
+    }
+    CHECK(failures == 0);
+}
+
+TEST(fat, volumes_in_parallel)
+{
+    RamDisk *disks[2] = { disk_a, disk_b };
+
+    disk_a->latency_us = BENCH_LATENCY_US;
+    disk_b->latency_us = BENCH_LATENCY_US;
+    disk_a->set_cache(0, 0);
+    disk_b->set_cache(0, 0);
+
+    double one = run_writers(disks, 1, 0);
+    double two = run_writers(disks, 2, 10);
+    CHECK(failures == 0);
+    CHECK(check_file(disk_a, 0) == BENCH_ROUNDS * RECORDS_PER_OPEN);
+    CHECK(check_file(disk_a, 10) == BENCH_ROUNDS * RECORDS_PER_OPEN);
+    CHECK(check_file(disk_b, 11) == BENCH_ROUNDS * RECORDS_PER_OPEN);
+
+    printf("\n1 writer on 1 volume: %.3fs, 2 writers on 2 volumes: %.3fs (%.2fx the work per second)\n",
+           one, two, 2 * one / two);
+}
@@ -0,0 +1,28 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ */
+#ifndef MBED_DIRHANDLE_H_STUB_
+#define MBED_DIRHANDLE_H_STUB_
+
+#include <dirent.h>
+#include "FileHandle.h"
+
+namespace mbed {
+
+class DirHandle {
+public:
+    virtual ~DirHandle() {}
+    virtual int closedir() = 0;
+    virtual struct dirent *readdir() = 0;
+    virtual void rewinddir() = 0;
+    virtual off_t telldir() { return -1; }
+    virtual void seekdir(off_t location) {}
+
+protected:
+    virtual void lock() {}
+    virtual void unlock() {}
+};
+
+}
+
+#endif /* MBED_DIRHANDLE_H_STUB_ */
@@ -0,0 +1,31 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ */
+#ifndef MBED_FILEHANDLE_H_STUB_
+#define MBED_FILEHANDLE_H_STUB_
+
+#include <stdio.h>
+#include <sys/types.h>
+#include <fcntl.h>
+
+namespace mbed {
+
+class FileHandle {
+public:
+    virtual ~FileHandle() {}
+    virtual ssize_t write(const void *buffer, size_t length) = 0;
+    virtual int close() = 0;
+    virtual ssize_t read(void *buffer, size_t length) = 0;
+    virtual int isatty() = 0;
+    virtual off_t lseek(off_t offset, int whence) = 0;
+    virtual int fsync() = 0;
+    virtual off_t flen() { return 0; }
+
+protected:
+    virtual void lock() {}
+    virtual void unlock() {}
+};
+
+}
+
+#endif /* MBED_FILEHANDLE_H_STUB_ */
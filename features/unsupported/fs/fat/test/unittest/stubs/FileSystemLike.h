@@ -0,0 +1,32 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ */
+#ifndef MBED_FILESYSTEMLIKE_H_STUB_
+#define MBED_FILESYSTEMLIKE_H_STUB_
+
+#include <sys/stat.h>
+#include "FileHandle.h"
+#include "DirHandle.h"
+
+namespace mbed {
+
+class FileSystemLike {
+public:
+    FileSystemLike(const char *name) : _name(name) {}
+    virtual ~FileSystemLike() {}
+
+    const char *getName() { return _name; }
+
+    virtual FileHandle *open(const char *filename, int flags) = 0;
+    virtual int remove(const char *filename) { return -1; }
+    virtual int rename(const char *oldname, const char *newname) { return -1; }
+    virtual DirHandle *opendir(const char *name) { return NULL; }
+    virtual int mkdir(const char *name, mode_t mode) { return -1; }
+
+private:
+    const char *_name;
+};
+
+}
+
+#endif /* MBED_FILESYSTEMLIKE_H_STUB_ */
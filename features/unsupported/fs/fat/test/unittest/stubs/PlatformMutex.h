@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ */
+#ifndef PLATFORM_MUTEX_H_STUB_
+#define PLATFORM_MUTEX_H_STUB_
+
+#include <pthread.h>
+#include <assert.h>
+
+/* A recursive mutex on POSIX threads which checks that only the owner
+ * unlocks it, as the RTX mutex behind the real PlatformMutex does */
+class PlatformMutex {
+public:
+    PlatformMutex() : _count(0) {
+        pthread_mutexattr_t attr;
+        pthread_mutexattr_init(&attr);
+        pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+        pthread_mutex_init(&_mutex, &attr);
+        pthread_mutexattr_destroy(&attr);
+    }
+
+    ~PlatformMutex() {
+        pthread_mutex_destroy(&_mutex);
+    }
+
+    void lock() {
+        pthread_mutex_lock(&_mutex);
+        _owner = pthread_self();
+        _count++;
+    }
+
+    void unlock() {
+        assert(_count > 0 && pthread_equal(_owner, pthread_self()));
+        _count--;
+        pthread_mutex_unlock(&_mutex);
+    }
+
+private:
+    pthread_mutex_t _mutex;
+    pthread_t _owner;
+    int _count;
+};
+
+#endif /* PLATFORM_MUTEX_H_STUB_ */
@@ -0,0 +1,11 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ */
+#ifndef CRITICAL_H_STUB_
+#define CRITICAL_H_STUB_
+
+/* A recursive mutex standing in for masked interrupts */
+void core_util_critical_section_enter(void);
+void core_util_critical_section_exit(void);
+
+#endif /* CRITICAL_H_STUB_ */
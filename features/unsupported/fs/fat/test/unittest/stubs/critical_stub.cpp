@@ -0,0 +1,17 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ */
+#include <pthread.h>
+#include "critical.h"
+
+static pthread_mutex_t critical_mutex = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+
+void core_util_critical_section_enter(void)
+{
+    pthread_mutex_lock(&critical_mutex);
+}
+
+void core_util_critical_section_exit(void)
+{
+    pthread_mutex_unlock(&critical_mutex);
+}
@@ -0,0 +1,14 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ */
+#ifndef MBED_H_STUB_
+#define MBED_H_STUB_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define error(...) do { fprintf(stderr, __VA_ARGS__); abort(); } while (0)
+
+#endif /* MBED_H_STUB_ */
@@ -0,0 +1,10 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ */
+#ifndef MBED_DEBUG_H_STUB_
+#define MBED_DEBUG_H_STUB_
+
+static inline void debug(const char *format, ...) {}
+static inline void debug_if(int condition, const char *format, ...) {}
+
+#endif /* MBED_DEBUG_H_STUB_ */
@@ -52,18 +52,22 @@
  * card always responds to commands, data blocks and errors.
  *
  * The protocol supports a CRC, but by default it is off (except for the
- * first reset CMD0, where the CRC can just be pre-calculated, and CMD8)
- * I'll leave the CRC off I think!
+ * first reset CMD0, where the CRC can just be pre-calculated, and CMD8).
+ * Once the card is initialised, CRC checking is turned on with CMD59 (see
+ * SD_CRC_ENABLED) so that corrupted transfers get caught: every command
+ * carries its CRC7, and every data block its CRC16.
  *
  * Standard capacity cards have variable data block sizes, whereas High
  * Capacity cards fix the size of data block to 512 bytes. I'll therefore
  * just always use the Standard Capacity cards with a block size of 512 bytes.
  * This is set with CMD16.
  *
- * You can read and write single blocks (CMD17, CMD25) or multiple blocks
- * (CMD18, CMD25). For simplicity, I'll just use single block accesses. When
- * the card gets a read command, it responds with a response token, and then
- * a data token or an error.
+ * You can read and write single blocks (CMD17, CMD24) or multiple blocks
+ * (CMD18, CMD25). Single block accesses are used for one sector, and multiple
+ * block accesses for runs of sectors, which saves a command and the card's
+ * access latency for every sector after the first. When the card gets a read
+ * command, it responds with a response token, and then a data token or an
+ * error.
  *
  * SPI Command Format
  * ------------------
@@ -73,7 +77,7 @@
  * | 01 | cmd[5:0] | arg[31:24] | arg[23:16] | arg[15:8] | arg[7:0] | crc[6:0] | 1 |
  * +---------------+------------+------------+-----------+----------+--------------+
  *
- * As I'm not using CRC, I can fix that byte to what is needed for CMD0 (0x95)
+ * The CRC7 is computed for every command, even while the card ignores it.
  *
  * All Application Specific commands shall be preceded with APP_CMD (CMD55).
  *
@@ -111,21 +115,52 @@
  * +------+---------+---------+- -  - -+---------+-----------+----------+
  * | 0xFE | data[0] | data[1] |        | data[n] | crc[15:8] | crc[7:0] |
  * +------+---------+---------+- -  - -+---------+-----------+----------+
+ *
+ * Multiple Block Read and Write
+ * -----------------------------
+ *
+ * After CMD18, the card sends data blocks (each with the 0xFE token) until
+ * it receives STOP_TRANSMISSION (CMD12). CMD12 is followed by a stuff byte,
+ * which is discarded, and an R1b response.
+ *
+ * Before CMD25, the number of blocks about to be written is passed to the
+ * card with SET_WR_BLK_ERASE_COUNT (ACMD23) so that it can pre-erase them.
+ * Each block is then sent with the 0xFC token and acknowledged with a data
+ * response token followed by busy; the transfer ends with the 0xFD stop
+ * token, again followed by busy.
+ *
+ * Data blocks are moved with the asynchronous SPI API where the target
+ * supports it (DEVICE_SPI_ASYNCH), letting the SPI driver use DMA; the CRC
+ * of a block being written is computed while it is in flight.
  */
 #include "SDFileSystem.h"
 #include "mbed_debug.h"
 
 #define SD_COMMAND_TIMEOUT 5000
+#define SD_DATA_TIMEOUT_MS 500  // upper bound for the read access time and for write busy
 
 #define SD_DBG             0
 
+#ifndef SD_CRC_ENABLED
+#define SD_CRC_ENABLED     1
+#endif
+
+// Data tokens
+#define SD_TOKEN_START_BLOCK        0xFE
+#define SD_TOKEN_START_MULTI_WRITE  0xFC
+#define SD_TOKEN_STOP_TRAN          0xFD
+
 SDFileSystem::SDFileSystem(PinName mosi, PinName miso, PinName sclk, PinName cs, const char* name) :
-    FATFileSystem(name), _spi(mosi, miso, sclk), _cs(cs), _is_initialized(0) {
+    FATFileSystem(name), _spi(mosi, miso, sclk), _cs(cs), _is_initialized(0), _crc_on(0) {
     _cs = 1;
 
     // Set default to 100kHz for initialisation and 1MHz for data transfer
     _init_sck = 100000;
     _transfer_sck = 1000000;
+
+#if DEVICE_SPI_ASYNCH
+    _spi.set_dma_usage(DMA_USAGE_OPPORTUNISTIC);
+#endif
 }
 
 #define R1_IDLE_STATE           (1 << 0)
@@ -207,6 +242,7 @@ int SDFileSystem::initialise_card_v2() {
 
 int SDFileSystem::disk_initialize() {
     lock();
+    _crc_on = 0; // CMD0 puts the card back into its default state, with CRC checking off
     _is_initialized = initialise_card();
     if (_is_initialized == 0) {
         debug("Fail to initialize card\n");
@@ -223,6 +259,15 @@ int SDFileSystem::disk_initialize() {
         return 1;
     }
 
+    // Turn on CRC checking (CMD59); without it, transfers go unchecked
+    if (SD_CRC_ENABLED) {
+        if (_cmd(59, 1) == 0) {
+            _crc_on = 1;
+        } else {
+            debug("Failed to enable CRC checking\n");
+        }
+    }
+
     // Set SCK for data transfer
     _spi.frequency(_transfer_sck);
     unlock();
@@ -235,21 +280,23 @@ int SDFileSystem::disk_write(const uint8_t* buffer, uint32_t block_number, uint3
         unlock();
         return -1;
     }
-    
-    for (uint32_t b = block_number; b < block_number + count; b++) {
+
+    int ret;
+    if (count == 1) {
         // set write address for single block (CMD24)
-        if (_cmd(24, b * cdv) != 0) {
+        if (_cmd(24, block_number * cdv) != 0) {
             unlock();
             return 1;
         }
-        
+
         // send the data block
-        _write(buffer, 512);
-        buffer += 512;
+        ret = _write(buffer, 512);
+    } else {
+        ret = _write_blocks(buffer, block_number, count);
     }
-    
+
     unlock();
-    return 0;
+    return ret ? 1 : 0;
 }
 
 int SDFileSystem::disk_read(uint8_t* buffer, uint32_t block_number, uint32_t count) {
@@ -258,21 +305,23 @@ int SDFileSystem::disk_read(uint8_t* buffer, uint32_t block_number, uint32_t cou
         unlock();
         return -1;
     }
-    
-    for (uint32_t b = block_number; b < block_number + count; b++) {
+
+    int ret;
+    if (count == 1) {
         // set read address for single block (CMD17)
-        if (_cmd(17, b * cdv) != 0) {
+        if (_cmd(17, block_number * cdv) != 0) {
             unlock();
             return 1;
         }
-        
+
         // receive the data
-        _read(buffer, 512);
-        buffer += 512;
+        ret = _read(buffer, 512);
+    } else {
+        ret = _read_blocks(buffer, block_number, count);
     }
 
     unlock();
-    return 0;
+    return ret ? 1 : 0;
 }
 
 int SDFileSystem::disk_status() {
@@ -293,92 +342,109 @@ uint32_t SDFileSystem::disk_sectors() {
 
 
 // PRIVATE FUNCTIONS
-int SDFileSystem::_cmd(int cmd, int arg) {
-    _spi.lock();
-    _cs = 0;
+static uint8_t crc7(const uint8_t *data, uint32_t length) {
+    uint8_t crc = 0;
+    for (uint32_t i = 0; i < length; i++) {
+        uint8_t byte = data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc <<= 1;
+            if ((byte ^ crc) & 0x80) {
+                crc ^= 0x09;
+            }
+            byte <<= 1;
+        }
+    }
+    return crc & 0x7F;
+}
 
-    // send a command
-    _spi.write(0x40 | cmd);
-    _spi.write(arg >> 24);
-    _spi.write(arg >> 16);
-    _spi.write(arg >> 8);
-    _spi.write(arg >> 0);
-    _spi.write(0x95);
+// CRC16-CCITT (x^16 + x^12 + x^5 + 1), processed a nibble at a time
+static const uint16_t crc16_table[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7,
+    0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef,
+};
 
-    // wait for the repsonse (response[7] == 0)
+static uint16_t crc16(const uint8_t *data, uint32_t length) {
+    uint16_t crc = 0;
+    for (uint32_t i = 0; i < length; i++) {
+        crc = (crc << 4) ^ crc16_table[(crc >> 12) ^ (data[i] >> 4)];
+        crc = (crc << 4) ^ crc16_table[(crc >> 12) ^ (data[i] & 0x0F)];
+    }
+    return crc;
+}
+
+// Send a command frame; the card must be selected
+void SDFileSystem::_send_cmd(int cmd, int arg) {
+    uint8_t frame[6];
+    frame[0] = 0x40 | cmd;
+    frame[1] = arg >> 24;
+    frame[2] = arg >> 16;
+    frame[3] = arg >> 8;
+    frame[4] = arg >> 0;
+    frame[5] = (crc7(frame, 5) << 1) | 1;
+    for (int i = 0; i < 6; i++) {
+        _spi.write(frame[i]);
+    }
+}
+
+// Wait for the R1 response (response[7] == 0)
+int SDFileSystem::_response() {
     for (int i = 0; i < SD_COMMAND_TIMEOUT; i++) {
         int response = _spi.write(0xFF);
         if (!(response & 0x80)) {
-            _cs = 1;
-            _spi.write(0xFF);
-            _spi.unlock();
             return response;
         }
     }
+    return -1; // timeout
+}
+
+int SDFileSystem::_cmd(int cmd, int arg) {
+    _spi.lock();
+    _cs = 0;
+
+    // send a command
+    _send_cmd(cmd, arg);
+
+    int response = _response();
     _cs = 1;
     _spi.write(0xFF);
     _spi.unlock();
-    return -1; // timeout
+    return response;
 }
 int SDFileSystem::_cmdx(int cmd, int arg) {
     _spi.lock();
     _cs = 0;
 
     // send a command
-    _spi.write(0x40 | cmd);
-    _spi.write(arg >> 24);
-    _spi.write(arg >> 16);
-    _spi.write(arg >> 8);
-    _spi.write(arg >> 0);
-    _spi.write(0x95);
+    _send_cmd(cmd, arg);
 
-    // wait for the repsonse (response[7] == 0)
-    for (int i = 0; i < SD_COMMAND_TIMEOUT; i++) {
-        int response = _spi.write(0xFF);
-        if (!(response & 0x80)) {
-            _cs = 1;
-            _spi.unlock();
-            return response;
-        }
-    }
+    int response = _response();
     _cs = 1;
-    _spi.write(0xFF);
+    if (response < 0) {
+        _spi.write(0xFF);
+    }
     _spi.unlock();
-    return -1; // timeout
+    return response;
 }
 
 
 int SDFileSystem::_cmd58() {
     _spi.lock();
     _cs = 0;
-    int arg = 0;
 
     // send a command
-    _spi.write(0x40 | 58);
-    _spi.write(arg >> 24);
-    _spi.write(arg >> 16);
-    _spi.write(arg >> 8);
-    _spi.write(arg >> 0);
-    _spi.write(0x95);
-
-    // wait for the repsonse (response[7] == 0)
-    for (int i = 0; i < SD_COMMAND_TIMEOUT; i++) {
-        int response = _spi.write(0xFF);
-        if (!(response & 0x80)) {
-            int ocr = _spi.write(0xFF) << 24;
-            ocr |= _spi.write(0xFF) << 16;
-            ocr |= _spi.write(0xFF) << 8;
-            ocr |= _spi.write(0xFF) << 0;
-            _cs = 1;
-            _spi.write(0xFF);
-            _spi.unlock();
-            return response;
-        }
+    _send_cmd(58, 0);
+
+    int response = _response();
+    if (response >= 0) {
+        int ocr = _spi.write(0xFF) << 24;
+        ocr |= _spi.write(0xFF) << 16;
+        ocr |= _spi.write(0xFF) << 8;
+        ocr |= _spi.write(0xFF) << 0;
     }
     _cs = 1;
     _spi.write(0xFF);
     _spi.unlock();
-    return -1; // timeout
+    return response;
 }
 
 int SDFileSystem::_cmd8() {
@@ -417,55 +483,207 @@ int SDFileSystem::_read(uint8_t *buffer, uint32_t length) {
     _spi.lock();
     _cs = 0;
 
-    // read until start byte (0xFF)
-    while (_spi.write(0xFF) != 0xFE);
+    int ret = _read_block(buffer, length);
 
-    // read data
-    for (uint32_t i = 0; i < length; i++) {
-        buffer[i] = _spi.write(0xFF);
-    }
-    _spi.write(0xFF); // checksum
+    _cs = 1;
+    _spi.write(0xFF);
+    _spi.unlock();
+    return ret;
+}
+
+int SDFileSystem::_write(const uint8_t*buffer, uint32_t length) {
+    _spi.lock();
+    _cs = 0;
+
+    int ret = _write_block(buffer, SD_TOKEN_START_BLOCK, length);
+
+    _cs = 1;
     _spi.write(0xFF);
+    _spi.unlock();
+    return ret;
+}
+
+int SDFileSystem::_read_blocks(uint8_t *buffer, uint32_t block_number, uint32_t count) {
+    _spi.lock();
+    _cs = 0;
+
+    // set read address for multiple blocks (CMD18)
+    _send_cmd(18, block_number * cdv);
+    int ret = (_response() != 0);
+
+    for (uint32_t b = 0; (b < count) && (ret == 0); b++) {
+        ret = _read_block(buffer, 512);
+        buffer += 512;
+    }
+
+    // stop the transmission (CMD12), even if a block failed: the card would
+    // otherwise carry on sending data
+    _send_cmd(12, 0);
+    _spi.write(0xFF); // stuff byte
+    if ((_response() != 0) || (_wait_ready() != 0)) {
+        ret = 1;
+    }
 
     _cs = 1;
     _spi.write(0xFF);
     _spi.unlock();
-    return 0;
+    return ret;
 }
 
-int SDFileSystem::_write(const uint8_t*buffer, uint32_t length) {
+int SDFileSystem::_write_blocks(const uint8_t *buffer, uint32_t block_number, uint32_t count) {
+    // let the card pre-erase the blocks about to be written (ACMD23); this is
+    // only a hint, so a failure is not an error
+    _cmd(55, 0);
+    _cmd(23, count);
+
     _spi.lock();
     _cs = 0;
 
+    // set write address for multiple blocks (CMD25)
+    _send_cmd(25, block_number * cdv);
+    int ret = (_response() != 0);
+    if (ret == 0) {
+        for (uint32_t b = 0; b < count; b++) {
+            if (_write_block(buffer, SD_TOKEN_START_MULTI_WRITE, 512) != 0) {
+                ret = 1;
+                break;
+            }
+            buffer += 512;
+        }
+
+        // end the transmission and wait for the card to finish programming
+        _spi.write(SD_TOKEN_STOP_TRAN);
+        _spi.write(0xFF);
+        if (_wait_ready() != 0) {
+            ret = 1;
+        }
+    }
+
+    _cs = 1;
+    _spi.write(0xFF);
+    _spi.unlock();
+    return ret;
+}
+
+// Receive a data block; the card must be selected
+int SDFileSystem::_read_block(uint8_t *buffer, uint32_t length) {
+    // wait for the start token
+    Timer timer;
+    timer.start();
+    int token;
+    while ((token = _spi.write(0xFF)) == 0xFF) {
+        if (timer.read_ms() > SD_DATA_TIMEOUT_MS) {
+            debug("Timeout waiting for a data block\n");
+            return 1;
+        }
+    }
+    if (token != SD_TOKEN_START_BLOCK) {
+        debug_if(SD_DBG, "Read error token 0x%02x\n", token);
+        return 1;
+    }
+
+    // read data
+    _transfer_start(NULL, buffer, length);
+    if (_transfer_wait() != 0) {
+        return 1;
+    }
+
+    // checksum
+    uint16_t crc = _spi.write(0xFF) << 8;
+    crc |= _spi.write(0xFF);
+    if (_crc_on && (crc != crc16(buffer, length))) {
+        debug("CRC error on read\n");
+        return 1;
+    }
+    return 0;
+}
+
+// Send a data block, and wait for the card to program it; the card must be selected
+int SDFileSystem::_write_block(const uint8_t *buffer, uint8_t token, uint32_t length) {
     // indicate start of block
-    _spi.write(0xFE);
+    _spi.write(token);
 
-    // write the data
-    for (uint32_t i = 0; i < length; i++) {
-        _spi.write(buffer[i]);
+    // write the data; the checksum is computed while the transfer is in flight
+    _transfer_start(buffer, NULL, length);
+    uint16_t crc = _crc_on ? crc16(buffer, length) : 0xFFFF;
+    if (_transfer_wait() != 0) {
+        return 1;
     }
 
     // write the checksum
-    _spi.write(0xFF);
-    _spi.write(0xFF);
+    _spi.write(crc >> 8);
+    _spi.write(crc & 0xFF);
 
     // check the response token
-    if ((_spi.write(0xFF) & 0x1F) != 0x05) {
-        _cs = 1;
-        _spi.write(0xFF);
-        _spi.unlock();
+    int response = _spi.write(0xFF);
+    if ((response & 0x1F) != 0x05) {
+        debug_if(SD_DBG, "Write error response 0x%02x\n", response);
         return 1;
     }
 
     // wait for write to finish
-    while (_spi.write(0xFF) == 0);
+    return _wait_ready();
+}
 
-    _cs = 1;
-    _spi.write(0xFF);
-    _spi.unlock();
+// Wait while the card signals busy
+int SDFileSystem::_wait_ready() {
+    Timer timer;
+    timer.start();
+    while (_spi.write(0xFF) != 0xFF) {
+        if (timer.read_ms() > SD_DATA_TIMEOUT_MS) {
+            debug("Timeout waiting for the card to finish programming\n");
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Start a block transfer; either buffer may be NULL, in which case 0xFF is
+// sent or the received data is discarded
+void SDFileSystem::_transfer_start(const uint8_t *tx, uint8_t *rx, uint32_t length) {
+#if DEVICE_SPI_ASYNCH
+    _transfer_event = 0;
+    if (_spi.transfer(tx, tx ? length : 0, rx, rx ? length : 0,
+                      callback(this, &SDFileSystem::_transfer_complete), SPI_EVENT_ALL) == 0) {
+        return;
+    }
+    _transfer_event = SPI_EVENT_COMPLETE; // the SPI is busy; fall back to a blocking transfer
+#endif
+    for (uint32_t i = 0; i < length; i++) {
+        int response = _spi.write(tx ? tx[i] : 0xFF);
+        if (rx) {
+            rx[i] = response;
+        }
+    }
+}
+
+// Wait for the block transfer to end; a transfer which fails or does not
+// complete in time is aborted
+int SDFileSystem::_transfer_wait() {
+#if DEVICE_SPI_ASYNCH
+    Timer timer;
+    timer.start();
+    while (_transfer_event == 0) {
+        if (timer.read_ms() > SD_DATA_TIMEOUT_MS) {
+            _spi.abort_transfer();
+            debug("Timeout waiting for a block transfer\n");
+            return 1;
+        }
+    }
+    if (_transfer_event & (SPI_EVENT_ERROR | SPI_EVENT_RX_OVERFLOW)) {
+        debug("Block transfer error 0x%02x\n", _transfer_event);
+        return 1;
+    }
+#endif
     return 0;
 }
 
+#if DEVICE_SPI_ASYNCH
+void SDFileSystem::_transfer_complete(int event) {
+    _transfer_event = event;
+}
+#endif
+
 static uint32_t ext_bits(unsigned char *data, int msb, int lsb) {
     uint32_t bits = 0;
     uint32_t size = 1 + msb - lsb;
@@ -61,6 +61,8 @@ public:
 
 protected:
 
+    void _send_cmd(int cmd, int arg);
+    int _response();
     int _cmd(int cmd, int arg);
     int _cmdx(int cmd, int arg);
     int _cmd8();
@@ -71,6 +73,17 @@ protected:
 
     int _read(uint8_t * buffer, uint32_t length);
     int _write(const uint8_t *buffer, uint32_t length);
+    int _read_blocks(uint8_t *buffer, uint32_t block_number, uint32_t count);
+    int _write_blocks(const uint8_t *buffer, uint32_t block_number, uint32_t count);
+    int _read_block(uint8_t *buffer, uint32_t length);
+    int _write_block(const uint8_t *buffer, uint8_t token, uint32_t length);
+    int _wait_ready();
+    void _transfer_start(const uint8_t *tx, uint8_t *rx, uint32_t length);
+    int _transfer_wait();
+#if DEVICE_SPI_ASYNCH
+    void _transfer_complete(int event);
+    volatile int _transfer_event;
+#endif
     uint32_t _sd_sectors();
     uint32_t _sectors;
 
@@ -84,6 +97,7 @@ protected:
     DigitalOut _cs;
     int cdv;
     int _is_initialized;
+    int _crc_on;
 };
 
 #endif
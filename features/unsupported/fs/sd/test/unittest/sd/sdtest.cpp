@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ */
+#include "CppUTest/TestHarness.h"
+#include "SDFileSystem.h"
+#include "sd_card_stub.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* SDFileSystem against an emulated SDHC card on a mock SPI bus. The card
+ * counts the bytes clocked, which gives the throughput at a given SPI clock
+ * rate independently of the host. */
+
+#define BENCH_SECTORS   128
+#define BENCH_SCK       25000000
+
+static uint8_t write_buf[BENCH_SECTORS * 512];
+static uint8_t read_buf[BENCH_SECTORS * 512];
+static SDFileSystem *sd;
+
+static int sectors_per_second(unsigned long bytes, int sectors)
+{
+    return (int)(sectors * (double)BENCH_SCK / (bytes * 8));
+}
+
+TEST_GROUP(sd)
+{
+    void setup() {
+        sd_card_stub_reset();
+        srand(1);
+        for (size_t i = 0; i < sizeof(write_buf); i++) {
+            write_buf[i] = rand();
+        }
+        memset(read_buf, 0, sizeof(read_buf));
+        sd = new SDFileSystem(0, 0, 0, 0, "sd");
+        CHECK(sd->disk_initialize() == 0);
+        memset(sd_card_stub.commands, 0, sizeof(sd_card_stub.commands));
+        memset(&spi_stub, 0, sizeof(spi_stub));
+    }
+
+    void teardown() {
+        delete sd;
+    }
+};
+
+TEST(sd, initialise)
+{
+    CHECK(sd->disk_sectors() == SD_CARD_STUB_SECTORS);
+    CHECK(sd_card_stub.crc_on);
+}
+
+TEST(sd, single_block)
+{
+    CHECK(sd->disk_write(write_buf, 7, 1) == 0);
+    CHECK(memcmp(&sd_card_stub.memory[7 * 512], write_buf, 512) == 0);
+    CHECK(sd->disk_read(read_buf, 7, 1) == 0);
+    CHECK(memcmp(read_buf, write_buf, 512) == 0);
+    CHECK(sd_card_stub.commands[24] == 1);
+    CHECK(sd_card_stub.commands[17] == 1);
+    CHECK(spi_stub.async_transfers == 2);
+}
+
+TEST(sd, multiple_blocks)
+{
+    CHECK(sd->disk_write(write_buf, 100, 64) == 0);
+    CHECK(memcmp(&sd_card_stub.memory[100 * 512], write_buf, 64 * 512) == 0);
+    CHECK(sd->disk_read(read_buf, 100, 64) == 0);
+    CHECK(memcmp(read_buf, write_buf, 64 * 512) == 0);
+
+    // One command each way, the write pre-erased and the read stopped
+    CHECK(sd_card_stub.commands[25] == 1);
+    CHECK(sd_card_stub.commands[18] == 1);
+    CHECK(sd_card_stub.commands[12] == 1);
+    CHECK(sd_card_stub.commands[24] == 0);
+    CHECK(sd_card_stub.commands[17] == 0);
+    CHECK(sd_card_stub.erase_count == 64);
+    CHECK(spi_stub.async_transfers == 128);
+    CHECK(sd_card_stub.crc_errors == 0);
+
+    // Single block commands still work afterwards
+    CHECK(sd->disk_read(read_buf, 130, 1) == 0);
+    CHECK(memcmp(read_buf, write_buf + 30 * 512, 512) == 0);
+}
+
+TEST(sd, read_crc_error)
+{
+    CHECK(sd->disk_write(write_buf, 100, 4) == 0);
+
+    sd_card_stub.corrupt_next_read = 1;
+    CHECK(sd->disk_read(read_buf, 100, 4) == 1);
+    sd_card_stub.corrupt_next_read = 1;
+    CHECK(sd->disk_read(read_buf, 100, 1) == 1);
+
+    CHECK(sd->disk_read(read_buf, 100, 4) == 0);
+    CHECK(memcmp(read_buf, write_buf, 4 * 512) == 0);
+}
+
+TEST(sd, out_of_range)
+{
+    CHECK(sd->disk_read(read_buf, SD_CARD_STUB_SECTORS + 100, 2) == 1);
+    CHECK(sd->disk_write(write_buf, SD_CARD_STUB_SECTORS + 100, 2) == 1);
+
+    CHECK(sd->disk_write(write_buf, 100, 2) == 0);
+    CHECK(sd->disk_read(read_buf, 100, 2) == 0);
+    CHECK(memcmp(read_buf, write_buf, 2 * 512) == 0);
+}
+
+TEST(sd, busy_spi_falls_back_to_blocking)
+{
+    spi_stub.busy_next = 3;
+    CHECK(sd->disk_write(write_buf, 200, 3) == 0);
+    CHECK(sd->disk_read(read_buf, 200, 3) == 0);
+    CHECK(memcmp(read_buf, write_buf, 3 * 512) == 0);
+    CHECK(spi_stub.busy_refusals == 3);
+    CHECK(spi_stub.async_transfers == 3);
+}
+
+TEST(sd, failed_transfer)
+{
+    spi_stub.error_next = 1;
+    CHECK(sd->disk_read(read_buf, 100, 4) == 1);
+    spi_stub.error_next = 1;
+    CHECK(sd->disk_write(write_buf, 300, 4) == 1);
+    CHECK(spi_stub.aborts == 0);
+
+    CHECK(sd->disk_write(write_buf, 300, 4) == 0);
+    CHECK(sd->disk_read(read_buf, 300, 4) == 0);
+    CHECK(memcmp(read_buf, write_buf, 4 * 512) == 0);
+}
+
+TEST(sd, lost_transfer_is_aborted)
+{
+    spi_stub.lose_next = 1;
+    CHECK(sd->disk_read(read_buf, 100, 4) == 1);
+    CHECK(spi_stub.aborts == 1);
+    spi_stub.lose_next = 1;
+    CHECK(sd->disk_write(write_buf, 300, 4) == 1);
+    CHECK(spi_stub.aborts == 2);
+
+    CHECK(sd->disk_write(write_buf, 300, 4) == 0);
+    CHECK(sd->disk_read(read_buf, 300, 4) == 0);
+    CHECK(memcmp(read_buf, write_buf, 4 * 512) == 0);
+}
+
+TEST(sd, throughput)
+{
+    unsigned long start = sd_card_stub.clocked_bytes;
+    for (int i = 0; i < BENCH_SECTORS; i++) {
+        CHECK(sd->disk_write(write_buf + i * 512, 1000 + i, 1) == 0);
+    }
+    unsigned long write_single = sd_card_stub.clocked_bytes - start;
+
+    start = sd_card_stub.clocked_bytes;
+    for (int i = 0; i < BENCH_SECTORS; i++) {
+        CHECK(sd->disk_read(read_buf + i * 512, 1000 + i, 1) == 0);
+    }
+    unsigned long read_single = sd_card_stub.clocked_bytes - start;
+    CHECK(memcmp(read_buf, write_buf, sizeof(read_buf)) == 0);
+
+    start = sd_card_stub.clocked_bytes;
+    CHECK(sd->disk_write(write_buf, 2000, BENCH_SECTORS) == 0);
+    unsigned long write_multi = sd_card_stub.clocked_bytes - start;
+
+    start = sd_card_stub.clocked_bytes;
+    CHECK(sd->disk_read(read_buf, 2000, BENCH_SECTORS) == 0);
+    unsigned long read_multi = sd_card_stub.clocked_bytes - start;
+    CHECK(memcmp(read_buf, write_buf, sizeof(read_buf)) == 0);
+
+    printf("\nSectors/s at %d MHz:\n", BENCH_SCK / 1000000);
+    printf("  write: %d single, %d in runs of %d\n", sectors_per_second(write_single, BENCH_SECTORS),
+           sectors_per_second(write_multi, BENCH_SECTORS), BENCH_SECTORS);
+    printf("  read:  %d single, %d in runs of %d\n", sectors_per_second(read_single, BENCH_SECTORS),
+           sectors_per_second(read_multi, BENCH_SECTORS), BENCH_SECTORS);
+
+    // Bytes on the bus are fixed by the protocol, so this does not depend on the host
+    CHECK(write_multi < write_single);
+    CHECK(read_multi < read_single);
+}
@@ -0,0 +1,32 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ */
+#ifndef FATFILESYSTEM_H_STUB_
+#define FATFILESYSTEM_H_STUB_
+
+#include <stdint.h>
+
+/* Only the disk interface, the driver is tested below the file system */
+class FATFileSystem {
+public:
+    FATFileSystem(const char *name) {
+    }
+
+    virtual ~FATFileSystem() {
+    }
+
+    virtual int disk_initialize() { return 0; }
+    virtual int disk_status() { return 0; }
+    virtual int disk_read(uint8_t *buffer, uint32_t sector, uint32_t count) = 0;
+    virtual int disk_write(const uint8_t *buffer, uint32_t sector, uint32_t count) = 0;
+    virtual int disk_sync() { return 0; }
+    virtual uint32_t disk_sectors() = 0;
+
+    virtual void lock() {
+    }
+
+    virtual void unlock() {
+    }
+};
+
+#endif /* FATFILESYSTEM_H_STUB_ */
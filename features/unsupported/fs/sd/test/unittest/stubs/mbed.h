@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ */
+#ifndef MBED_H_STUB_
+#define MBED_H_STUB_
+
+/* The parts of the mbed API that SDFileSystem uses, with the SPI bus wired
+ * to the emulated card of sd_card_stub. Asynchronous transfers run to
+ * completion inside transfer() and can be made to fail on demand. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include "sd_card_stub.h"
+
+#ifndef DEVICE_SPI_ASYNCH
+#define DEVICE_SPI_ASYNCH 1
+#endif
+
+#define SPI_EVENT_ERROR         (1 << 1)
+#define SPI_EVENT_COMPLETE      (1 << 2)
+#define SPI_EVENT_RX_OVERFLOW   (1 << 3)
+#define SPI_EVENT_ALL           (SPI_EVENT_ERROR | SPI_EVENT_COMPLETE | SPI_EVENT_RX_OVERFLOW)
+
+typedef int PinName;
+
+enum DMAUsage {
+    DMA_USAGE_NEVER,
+    DMA_USAGE_OPPORTUNISTIC
+};
+
+typedef struct {
+    int busy_next;          /**< Refuse this many asynchronous transfers as busy */
+    int error_next;         /**< Complete this many transfers with an error */
+    int lose_next;          /**< Never complete this many transfers */
+    int async_transfers;    /**< Asynchronous transfers started */
+    int busy_refusals;      /**< Asynchronous transfers refused as busy */
+    int aborts;             /**< Calls to abort_transfer() */
+    int frequency;          /**< Last clock rate set, in Hz */
+} spi_stub_def;
+
+extern spi_stub_def spi_stub;
+
+class SDFileSystem;
+
+class event_callback_t {
+public:
+    event_callback_t(SDFileSystem *obj, void (SDFileSystem::*func)(int)) : _obj(obj), _func(func) {
+    }
+
+    void call(int event) const {
+        (_obj->*_func)(event);
+    }
+
+private:
+    SDFileSystem *_obj;
+    void (SDFileSystem::*_func)(int);
+};
+
+template <typename T>
+event_callback_t callback(T *obj, void (T::*func)(int)) {
+    return event_callback_t(obj, func);
+}
+
+class SPI {
+public:
+    SPI(PinName mosi, PinName miso, PinName sclk) {
+    }
+
+    int write(int value) {
+        return sd_card_stub_exchange(value);
+    }
+
+    void frequency(int hz) {
+        spi_stub.frequency = hz;
+    }
+
+    void lock() {
+    }
+
+    void unlock() {
+    }
+
+    int set_dma_usage(DMAUsage usage) {
+        return 0;
+    }
+
+    template <typename Type>
+    int transfer(const Type *tx, int tx_length, Type *rx, int rx_length,
+                 const event_callback_t &cb, int event = SPI_EVENT_COMPLETE) {
+        if (spi_stub.busy_next) {
+            spi_stub.busy_next--;
+            spi_stub.busy_refusals++;
+            return -1;
+        }
+        int length = tx_length > rx_length ? tx_length : rx_length;
+        for (int i = 0; i < length; i++) {
+            uint8_t response = sd_card_stub_exchange(i < tx_length ? tx[i] : 0xFF);
+            if (i < rx_length) {
+                rx[i] = response;
+            }
+        }
+        spi_stub.async_transfers++;
+        if (spi_stub.lose_next) {
+            spi_stub.lose_next--;
+        } else if (spi_stub.error_next) {
+            spi_stub.error_next--;
+            cb.call(SPI_EVENT_ERROR & event);
+        } else {
+            cb.call(SPI_EVENT_COMPLETE & event);
+        }
+        return 0;
+    }
+
+    void abort_transfer() {
+        spi_stub.aborts++;
+    }
+};
+
+class DigitalOut {
+public:
+    DigitalOut(PinName pin) {
+    }
+
+    DigitalOut &operator=(int value) {
+        sd_card_stub_select(value);
+        return *this;
+    }
+};
+
+/* Every read moves the clock on, so that timeouts expire however fast the
+ * host runs */
+class Timer {
+public:
+    Timer() : _reads(0) {
+    }
+
+    void start() {
+    }
+
+    void stop() {
+    }
+
+    void reset() {
+        _reads = 0;
+    }
+
+    int read_ms() {
+        return _reads++ / 16;
+    }
+
+    int read_us() {
+        return read_ms() * 1000;
+    }
+
+private:
+    int _reads;
+};
+
+inline void wait_ms(int ms) {
+}
+
+#endif /* MBED_H_STUB_ */
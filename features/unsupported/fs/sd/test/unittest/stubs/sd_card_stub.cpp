@@ -0,0 +1,321 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ */
+
+/* A byte-level SDHC card in SPI mode: enough of the initialisation sequence,
+ * CMD9, single and multiple block reads and writes, ACMD23, CMD12, CRC7 and
+ * CRC16 checking and write busy for SDFileSystem to run against it. Bytes the
+ * card sends are queued and clocked out as the host clocks bytes in. */
+
+#include <deque>
+#include <string.h>
+#include "sd_card_stub.h"
+
+#define R1_IDLE_STATE           0x01
+#define R1_COM_CRC_ERROR        0x08
+#define R1_ILLEGAL_COMMAND      0x04
+#define R1_ADDRESS_ERROR        0x20
+
+#define TOKEN_START_BLOCK       0xFE
+#define TOKEN_START_MULTI_WRITE 0xFC
+#define TOKEN_STOP_TRAN         0xFD
+
+#define DATA_ACCEPTED           0xE5
+#define DATA_CRC_ERROR          0xEB
+#define DATA_WRITE_ERROR        0xED
+
+// A multiple block read sends the next block after this many 0xFF bytes
+#define NEXT_BLOCK_LATENCY      8
+// Blocks pre-erased with ACMD23 program quickly
+#define PRE_ERASED_BUSY         40
+
+sd_card_stub_def sd_card_stub;
+
+enum card_mode_t { IDLE, READ_MULTI, WRITE_SINGLE, WRITE_MULTI };
+
+static std::deque<uint8_t> out;
+static int selected;
+static int app_cmd;
+static int acmd41_tries;
+static uint8_t frame[6];
+static int frame_len;
+static card_mode_t mode;
+static uint32_t block;
+static uint32_t erase_left;
+static uint8_t write_buf[514];
+static int write_len;
+static int write_receiving;
+
+static uint8_t crc7(const uint8_t *data, int length)
+{
+    uint8_t crc = 0;
+    for (int i = 0; i < length; i++) {
+        uint8_t byte = data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc <<= 1;
+            if ((byte ^ crc) & 0x80) {
+                crc ^= 0x09;
+            }
+            byte <<= 1;
+        }
+    }
+    return crc & 0x7F;
+}
+
+static uint16_t crc16(const uint8_t *data, int length)
+{
+    uint16_t crc = 0;
+    for (int i = 0; i < length; i++) {
+        crc ^= data[i] << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+static void send_block(const uint8_t *data, int length, int latency)
+{
+    for (int i = 0; i < latency; i++) {
+        out.push_back(0xFF);
+    }
+    out.push_back(TOKEN_START_BLOCK);
+    uint16_t crc = crc16(data, length);
+    for (int i = 0; i < length; i++) {
+        out.push_back(data[i]);
+    }
+    if (sd_card_stub.corrupt_next_read) {
+        sd_card_stub.corrupt_next_read = 0;
+        out[out.size() - length / 2] ^= 0x10;
+    }
+    out.push_back(crc >> 8);
+    out.push_back(crc & 0xFF);
+}
+
+static void send_busy(int length)
+{
+    for (int i = 0; i < length; i++) {
+        out.push_back(0x00);
+    }
+}
+
+static void command(void)
+{
+    int cmd = frame[0] & 0x3F;
+    uint32_t arg = (frame[1] << 24) | (frame[2] << 16) | (frame[3] << 8) | frame[4];
+    bool acmd = app_cmd;
+
+    app_cmd = 0;
+    sd_card_stub.commands[cmd]++;
+    if ((sd_card_stub.crc_on || cmd == 0 || cmd == 8) && (frame[5] >> 1) != crc7(frame, 5)) {
+        sd_card_stub.crc_errors++;
+        out.push_back(0xFF);
+        out.push_back(R1_COM_CRC_ERROR);
+        return;
+    }
+
+    if (cmd == 12) {
+        // Stops a transfer in progress: a stuff byte, R1 and busy
+        out.clear();
+        mode = IDLE;
+        out.push_back(0x3F);
+        out.push_back(0x00);
+        send_busy(20);
+        return;
+    }
+
+    out.clear();
+    out.push_back(0xFF);
+    switch (cmd) {
+        case 0:
+            sd_card_stub.crc_on = 0;
+            acmd41_tries = 0;
+            out.push_back(R1_IDLE_STATE);
+            break;
+        case 8:
+            out.push_back(R1_IDLE_STATE);
+            out.push_back(0x00);
+            out.push_back(0x00);
+            out.push_back(0x01);
+            out.push_back(0xAA);
+            break;
+        case 55:
+            app_cmd = 1;
+            out.push_back(acmd41_tries >= 2 ? 0x00 : R1_IDLE_STATE);
+            break;
+        case 41:
+            // Leaves the idle state on the second attempt
+            out.push_back(++acmd41_tries >= 2 ? 0x00 : R1_IDLE_STATE);
+            break;
+        case 58:
+            // OCR with the card capacity status bit set
+            out.push_back(0x00);
+            out.push_back(0xC0);
+            out.push_back(0xFF);
+            out.push_back(0x80);
+            out.push_back(0x00);
+            break;
+        case 16:
+            out.push_back(0x00);
+            break;
+        case 59:
+            sd_card_stub.crc_on = arg & 1;
+            out.push_back(0x00);
+            break;
+        case 23:
+            if (acmd) {
+                sd_card_stub.erase_count = arg;
+                erase_left = arg;
+                out.push_back(0x00);
+            } else {
+                out.push_back(R1_ILLEGAL_COMMAND);
+            }
+            break;
+        case 9: {
+            // Version 2 CSD, C_SIZE counts 512 KiB units
+            uint8_t csd[16];
+            uint32_t c_size = SD_CARD_STUB_SECTORS / 1024 - 1;
+            memset(csd, 0, sizeof(csd));
+            csd[0] = 0x40;
+            csd[7] = c_size >> 16;
+            csd[8] = c_size >> 8;
+            csd[9] = c_size;
+            out.push_back(0x00);
+            send_block(csd, sizeof(csd), sd_card_stub.read_latency);
+            break;
+        }
+        case 17:
+        case 18:
+            if (arg >= SD_CARD_STUB_SECTORS) {
+                out.push_back(R1_ADDRESS_ERROR);
+                break;
+            }
+            out.push_back(0x00);
+            block = arg;
+            send_block(&sd_card_stub.memory[block * 512], 512, sd_card_stub.read_latency);
+            block++;
+            mode = cmd == 18 ? READ_MULTI : IDLE;
+            break;
+        case 24:
+        case 25:
+            if (arg >= SD_CARD_STUB_SECTORS) {
+                out.push_back(R1_ADDRESS_ERROR);
+                break;
+            }
+            out.push_back(0x00);
+            block = arg;
+            mode = cmd == 25 ? WRITE_MULTI : WRITE_SINGLE;
+            write_receiving = 0;
+            break;
+        default:
+            out.push_back(R1_ILLEGAL_COMMAND);
+            break;
+    }
+}
+
+static void receive_data(uint8_t in)
+{
+    write_buf[write_len++] = in;
+    if (write_len < (int)sizeof(write_buf)) {
+        return;
+    }
+
+    write_receiving = 0;
+    uint16_t crc = (write_buf[512] << 8) | write_buf[513];
+    if (sd_card_stub.crc_on && crc != crc16(write_buf, 512)) {
+        sd_card_stub.crc_errors++;
+        out.push_back(DATA_CRC_ERROR);
+        mode = IDLE;
+        return;
+    }
+    if (block >= SD_CARD_STUB_SECTORS) {
+        out.push_back(DATA_WRITE_ERROR);
+        mode = IDLE;
+        return;
+    }
+    memcpy(&sd_card_stub.memory[block * 512], write_buf, 512);
+    block++;
+    out.push_back(DATA_ACCEPTED);
+    if (mode == WRITE_MULTI && erase_left > 0) {
+        erase_left--;
+        send_busy(PRE_ERASED_BUSY);
+    } else {
+        send_busy(sd_card_stub.write_busy);
+    }
+    if (mode == WRITE_SINGLE) {
+        mode = IDLE;
+    }
+}
+
+void sd_card_stub_reset(void)
+{
+    memset(&sd_card_stub, 0, sizeof(sd_card_stub));
+    sd_card_stub.read_latency = 100;
+    sd_card_stub.write_busy = 300;
+    out.clear();
+    selected = 0;
+    app_cmd = 0;
+    acmd41_tries = 0;
+    frame_len = 0;
+    mode = IDLE;
+    erase_left = 0;
+    write_receiving = 0;
+}
+
+void sd_card_stub_select(int level)
+{
+    selected = !level;
+}
+
+uint8_t sd_card_stub_exchange(uint8_t in)
+{
+    sd_card_stub.clocked_bytes++;
+    if (!selected) {
+        return 0xFF;
+    }
+
+    uint8_t response = 0xFF;
+    if (!out.empty()) {
+        response = out.front();
+        out.pop_front();
+    }
+    if (mode == READ_MULTI && out.empty() && block < SD_CARD_STUB_SECTORS) {
+        send_block(&sd_card_stub.memory[block * 512], 512, NEXT_BLOCK_LATENCY);
+        block++;
+    }
+
+    if (mode == WRITE_SINGLE || mode == WRITE_MULTI) {
+        if (write_receiving) {
+            receive_data(in);
+            return response;
+        }
+        if (out.empty() || response == 0xFF) {
+            if ((mode == WRITE_SINGLE && in == TOKEN_START_BLOCK) ||
+                (mode == WRITE_MULTI && in == TOKEN_START_MULTI_WRITE)) {
+                write_receiving = 1;
+                write_len = 0;
+                return response;
+            }
+            if (mode == WRITE_MULTI && in == TOKEN_STOP_TRAN) {
+                mode = IDLE;
+                out.push_back(0xFF);
+                send_busy(sd_card_stub.write_busy);
+                return response;
+            }
+        }
+        if (in == 0xFF) {
+            return response;
+        }
+    }
+
+    // Commands start with 01 in the top bits
+    if (frame_len == 0 && (in & 0xC0) != 0x40) {
+        return response;
+    }
+    frame[frame_len++] = in;
+    if (frame_len == sizeof(frame)) {
+        frame_len = 0;
+        command();
+    }
+    return response;
+}
@@ -0,0 +1,35 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ */
+#ifndef SD_CARD_STUB_H_
+#define SD_CARD_STUB_H_
+
+#include <stdint.h>
+
+#define SD_CARD_STUB_SECTORS    4096
+
+/* SDHC card in SPI mode, emulated one byte at a time on the SPI bus */
+typedef struct {
+    uint8_t memory[SD_CARD_STUB_SECTORS * 512]; /**< Card contents */
+    unsigned long clocked_bytes;    /**< Bytes clocked on the bus, selected or not */
+    unsigned long commands[64];     /**< Number of each command received */
+    uint32_t erase_count;           /**< Argument of the last ACMD23 */
+    int crc_on;                     /**< CRC checking enabled by CMD59 */
+    int crc_errors;                 /**< Commands and data blocks with a bad CRC */
+    int corrupt_next_read;          /**< Flip a bit in the next data block sent */
+    int read_latency;               /**< 0xFF bytes before the first data block */
+    int write_busy;                 /**< Busy bytes after programming a block */
+} sd_card_stub_def;
+
+extern sd_card_stub_def sd_card_stub;
+
+/** Power the card up, erased and in the idle state */
+void sd_card_stub_reset(void);
+
+/** Drive the chip select, 0 selects the card */
+void sd_card_stub_select(int level);
+
+/** Clock one byte in and out of the card */
+uint8_t sd_card_stub_exchange(uint8_t in);
+
+#endif /* SD_CARD_STUB_H_ */
@@ -0,0 +1,6 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ */
+#include "mbed.h"
+
+spi_stub_def spi_stub;
@@ -0,0 +1,171 @@
+#include "mbed.h"
+#include "FATFileSystem.h"
+#include "test_env.h"
+#include <stdlib.h>
+
+/* Counts the device I/Os FATFileSystem issues for a few workloads, with the
+ * block cache disabled and at its default size, on a RAM disk. */
+
+namespace {
+const uint32_t SECTOR_SIZE = 512;
+const uint32_t DISK_SECTORS = 256;
+const uint32_t RECORD_SIZE = 64;
+const uint32_t NUM_RECORDS = 128;   // 8 KiB file, 16 clusters
+const uint32_t NUM_SEEKS = 100;
+const uint32_t NUM_FILES = 8;
+}
+
+/* Sectors are allocated when first written, as most of the disk stays empty */
+class RamDisk : public FATFileSystem {
+public:
+    RamDisk(const char *name) : FATFileSystem(name), reads(0), writes(0) {
+        memset(sectors, 0, sizeof(sectors));
+    }
+
+    virtual ~RamDisk() {
+        for (uint32_t i = 0; i < DISK_SECTORS; i++) {
+            free(sectors[i]);
+        }
+    }
+
+    virtual int disk_read(uint8_t *buffer, uint32_t sector, uint32_t count) {
+        reads++;
+        for (uint32_t i = 0; i < count; i++, sector++, buffer += SECTOR_SIZE) {
+            if (sector >= DISK_SECTORS) {
+                return 1;
+            }
+            if (sectors[sector]) {
+                memcpy(buffer, sectors[sector], SECTOR_SIZE);
+            } else {
+                memset(buffer, 0, SECTOR_SIZE);
+            }
+        }
+        return 0;
+    }
+
+    virtual int disk_write(const uint8_t *buffer, uint32_t sector, uint32_t count) {
+        writes++;
+        for (uint32_t i = 0; i < count; i++, sector++, buffer += SECTOR_SIZE) {
+            if (sector >= DISK_SECTORS) {
+                return 1;
+            }
+            if (sectors[sector] == NULL) {
+                sectors[sector] = (uint8_t *)malloc(SECTOR_SIZE);
+                if (sectors[sector] == NULL) {
+                    return 1;
+                }
+            }
+            memcpy(sectors[sector], buffer, SECTOR_SIZE);
+        }
+        return 0;
+    }
+
+    virtual uint32_t disk_sectors() { return DISK_SECTORS; }
+
+    uint32_t reads;
+    uint32_t writes;
+
+private:
+    uint8_t *sectors[DISK_SECTORS];
+};
+
+RamDisk ram("ram");
+
+void notify_ios(const char *workload, bool cached) {
+    char name[32];
+    printf("%-8s %-8s %4lu reads %4lu writes\r\n", workload, cached ? "cached" : "uncached", ram.reads, ram.writes);
+    sprintf(name, "%s_%s_ios", workload, cached ? "cached" : "uncached");
+    notify_performance_coefficient(name, (unsigned int)(ram.reads + ram.writes));
+    ram.reads = 0;
+    ram.writes = 0;
+}
+
+bool test_workloads(bool cached) {
+    const char prefix = cached ? 'c' : 'u';
+    uint8_t record[RECORD_SIZE];
+    char name[16];
+
+    if (cached) {
+        ram.set_cache(FAT_CACHE_BLOCKS, FAT_CACHE_READ_AHEAD);
+    } else {
+        ram.set_cache(0, 0);
+    }
+    if (ram.mount() != 0) {
+        printf("Couldn't mount the RAM disk\r\n");
+        return false;
+    }
+    ram.reads = 0;
+    ram.writes = 0;
+
+    // Append small records to a log
+    sprintf(name, "%clog.bin", prefix);
+    FileHandle *f = ram.open(name, O_WRONLY | O_CREAT | O_TRUNC);
+    if (f == NULL) {
+        return false;
+    }
+    for (uint32_t i = 0; i < NUM_RECORDS; i++) {
+        memset(record, i, sizeof(record));
+        if (f->write(record, sizeof(record)) != (ssize_t)sizeof(record)) {
+            f->close();
+            return false;
+        }
+    }
+    f->close();
+    notify_ios("append", cached);
+
+    // Read them back in order
+    f = ram.open(name, O_RDONLY);
+    for (uint32_t i = 0; i < NUM_RECORDS; i++) {
+        if (f->read(record, sizeof(record)) != (ssize_t)sizeof(record) || record[0] != (uint8_t)i) {
+            f->close();
+            return false;
+        }
+    }
+    notify_ios("read", cached);
+
+    // Seek to random records
+    for (uint32_t i = 0; i < NUM_SEEKS; i++) {
+        uint32_t n = rand() % NUM_RECORDS;
+        if (f->lseek(n * RECORD_SIZE, SEEK_SET) != (off_t)(n * RECORD_SIZE) ||
+            f->read(record, sizeof(record)) != (ssize_t)sizeof(record) || record[0] != (uint8_t)n) {
+            f->close();
+            return false;
+        }
+    }
+    f->close();
+    notify_ios("seek", cached);
+
+    // Create small files, which is all FAT and directory updates
+    for (uint32_t i = 0; i < NUM_FILES; i++) {
+        sprintf(name, "%c%02lu.txt", prefix, i);
+        f = ram.open(name, O_WRONLY | O_CREAT | O_TRUNC);
+        if (f == NULL) {
+            return false;
+        }
+        f->write(name, strlen(name));
+        f->close();
+    }
+    notify_ios("create", cached);
+
+    return ram.unmount() == 0;
+}
+
+int main() {
+    MBED_HOSTTEST_TIMEOUT(20);
+    MBED_HOSTTEST_SELECT(default_auto);
+    MBED_HOSTTEST_DESCRIPTION(FAT Block Cache Device IO);
+    MBED_HOSTTEST_START("PERF_5");
+
+    // Test header
+    printf("\r\n");
+    printf("FAT Block Cache I/O Count Test\r\n");
+
+    srand(testenv_randseed());
+    bool result = (ram.format() == 0);
+    if (!result) {
+        printf("Couldn't format the RAM disk\r\n");
+    }
+    result = result && test_workloads(false);
+    result = result && test_workloads(true);
+    MBED_HOSTTEST_RESULT(result);
+}
@@ -0,0 +1,179 @@
+#include "mbed.h"
+#include "SDFileSystem.h"
+#include "test_env.h"
+#include "platform/critical.h"
+#include <stdlib.h>
+
+/* Gives the test access to a bare block transfer */
+class TestSDFileSystem : public SDFileSystem {
+public:
+    TestSDFileSystem(PinName mosi, PinName miso, PinName sclk, PinName cs, const char* name) :
+        SDFileSystem(mosi, miso, sclk, cs, name) {}
+
+#if DEVICE_SPI_ASYNCH && !MBED_CONF_RTOS_PRESENT
+    /* Clock a block with the card deselected and interrupts masked, so the
+     * transfer never reports its completion. The SPI takes a mutex to start
+     * the transfer, so this needs the build without the RTOS */
+    int lost_completion(uint8_t *buffer, uint32_t length) {
+        core_util_critical_section_enter();
+        _transfer_start(NULL, buffer, length);
+        int ret = _transfer_wait();
+        core_util_critical_section_exit();
+        return ret;
+    }
+#endif
+};
+
+#if defined(TARGET_KL25Z)
+TestSDFileSystem sd(PTD2, PTD3, PTD1, PTD0, "sd");
+
+#elif defined(TARGET_KL46Z)
+TestSDFileSystem sd(PTD6, PTD7, PTD5, PTD4, "sd");
+
+#elif defined(TARGET_K64F) || defined(TARGET_K66F)
+TestSDFileSystem sd(PTE3, PTE1, PTE2, PTE4, "sd");
+
+#elif defined(TARGET_K22F)
+TestSDFileSystem sd(PTD6, PTD7, PTD5, PTD4, "sd");
+
+#elif defined(TARGET_K20D50M)
+TestSDFileSystem sd(PTD2, PTD3, PTD1, PTC2, "sd");
+
+#elif defined(TARGET_nRF51822)
+TestSDFileSystem sd(p12, p13, p15, p14, "sd");
+
+#elif defined(TARGET_NUCLEO_F030R8) || \
+      defined(TARGET_NUCLEO_F070RB) || \
+      defined(TARGET_NUCLEO_F072RB) || \
+      defined(TARGET_NUCLEO_F091RC) || \
+      defined(TARGET_NUCLEO_F103RB) || \
+      defined(TARGET_NUCLEO_F302R8) || \
+      defined(TARGET_NUCLEO_F303RE) || \
+      defined(TARGET_NUCLEO_F334R8) || \
+      defined(TARGET_NUCLEO_F401RE) || \
+      defined(TARGET_NUCLEO_F410RB) || \
+      defined(TARGET_NUCLEO_F411RE) || \
+      defined(TARGET_NUCLEO_L053R8) || \
+      defined(TARGET_NUCLEO_L073RZ) || \
+      defined(TARGET_NUCLEO_L152RE)
+TestSDFileSystem sd(D11, D12, D13, D10, "sd");
+
+#elif defined(TARGET_DISCO_F051R8)
+TestSDFileSystem sd(SPI_MOSI, SPI_MISO, SPI_SCK, SPI_CS, "sd");
+
+#elif defined(TARGET_LPC2368)
+TestSDFileSystem sd(p11, p12, p13, p14, "sd");
+
+#elif defined(TARGET_LPC11U68)
+TestSDFileSystem sd(D11, D12, D13, D10, "sd");
+
+#elif defined(TARGET_LPC1549)
+TestSDFileSystem sd(D11, D12, D13, D10, "sd");
+
+#elif defined(TARGET_LPC11U37H_401)
+TestSDFileSystem sd(SDMOSI, SDMISO, SDSCLK, SDSSEL, "sd");
+
+#else
+TestSDFileSystem sd(p11, p12, p13, p14, "sd");
+#endif
+
+namespace {
+const uint32_t SECTOR_SIZE = 512;
+const uint32_t RUN_LENGTH = 32;  // sectors per disk_read()/disk_write() for multiple block transfers
+const uint32_t NUM_RUNS = 8;
+uint8_t buffer[RUN_LENGTH * SECTOR_SIZE];
+uint8_t verify_buffer[RUN_LENGTH * SECTOR_SIZE];
+Timer timer;
+}
+
+/* Transfer NUM_RUNS * RUN_LENGTH sectors, 'per_call' sectors at a time, and
+ * report the throughput in sectors/second. The sectors at the end of the card
+ * are used to stay clear of the filesystem. */
+bool test_sd_blocks(bool write, uint32_t per_call, const char *coefficient) {
+    const uint32_t total = NUM_RUNS * RUN_LENGTH;
+    const uint32_t first = sd.disk_sectors() - total;
+
+    timer.reset();
+    timer.start();
+    for (uint32_t sector = 0; sector < total; sector += per_call) {
+        uint32_t offset = (sector % RUN_LENGTH) * SECTOR_SIZE;
+        int ret = write ? sd.disk_write(&buffer[offset], first + sector, per_call) : sd.disk_read(&verify_buffer[offset], first + sector, per_call);
+        if (ret != 0) {
+            printf("%s error at sector %lu\r\n", write ? "Write" : "Read", first + sector);
+            return false;
+        }
+    }
+    timer.stop();
+
+    double test_time_sec = timer.read_us() / 1000000.0;
+    double speed = total / test_time_sec;
+    printf("%lu sectors %s %lu at a time in %.3f sec: %.1f sectors/s\r\n", total, write ? "written" : "read", per_call, test_time_sec, speed);
+    notify_performance_coefficient(coefficient, speed);
+    return true;
+}
+
+bool verify_sd_blocks() {
+    const uint32_t total = NUM_RUNS * RUN_LENGTH;
+    const uint32_t first = sd.disk_sectors() - total;
+
+    for (uint32_t sector = 0; sector < total; sector += RUN_LENGTH) {
+        if (sd.disk_read(verify_buffer, first + sector, RUN_LENGTH) != 0) {
+            return false;
+        }
+        if (memcmp(verify_buffer, buffer, sizeof(buffer)) != 0) {
+            printf("Data mismatch in sectors %lu..%lu\r\n", first + sector, first + sector + RUN_LENGTH - 1);
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Multiple block transfers past the end of the card, and a block transfer
+ * which never completes, fail rather than hang, and leave the card usable */
+bool test_sd_errors() {
+    const uint32_t last = sd.disk_sectors() - 1;
+
+    if ((sd.disk_read(verify_buffer, last, RUN_LENGTH) == 0) || (sd.disk_write(buffer, last + 1, RUN_LENGTH) == 0)) {
+        printf("Transfer past the end of the card did not fail\r\n");
+        return false;
+    }
+#if DEVICE_SPI_ASYNCH && !MBED_CONF_RTOS_PRESENT
+    timer.reset();
+    timer.start();
+    int ret = sd.lost_completion(verify_buffer, SECTOR_SIZE);
+    timer.stop();
+    printf("Lost block transfer completion: %s after %d ms\r\n", ret ? "failed" : "succeeded", timer.read_ms());
+    if (ret == 0) {
+        return false;
+    }
+#endif
+    return verify_sd_blocks();
+}
+
+int main() {
+    MBED_HOSTTEST_TIMEOUT(30);
+    MBED_HOSTTEST_SELECT(default_auto);
+    MBED_HOSTTEST_DESCRIPTION(SD Block Device RW Speed);
+    MBED_HOSTTEST_START("PERF_4");
+
+    // Test header
+    printf("\r\n");
+    printf("SD Card Block Device Performance Test\r\n");
+
+    srand(testenv_randseed());
+    for (uint32_t i = 0; i < sizeof(buffer); i++) {
+        buffer[i] = rand();
+    }
+
+    bool result = (sd.disk_initialize() == 0) && (sd.disk_sectors() > NUM_RUNS * RUN_LENGTH);
+    if (!result) {
+        printf("Card not initialized\r\n");
+    }
+    result = result && test_sd_blocks(true,  1,          "write_single_sps");
+    result = result && test_sd_blocks(true,  RUN_LENGTH, "write_multiple_sps");
+    result = result && test_sd_blocks(false, 1,          "read_single_sps");
+    result = result && test_sd_blocks(false, RUN_LENGTH, "read_multiple_sps");
+    result = result && verify_sd_blocks();
+    result = result && test_sd_errors();
+    MBED_HOSTTEST_RESULT(result);
+}
@@ -0,0 +1,165 @@
+#include "mbed.h"
+#include "FATFileSystem.h"
+#include "test_env.h"
+#include "rtos.h"
+
+#if defined(MBED_RTOS_SINGLE_THREAD)
+  #error [NOT_SUPPORTED] test not supported
+#endif
+
+/* Threads append records to their own file on two RAM disks at the same time
+ * and read back everything written so far after each round. */
+
+namespace {
+const uint32_t SECTOR_SIZE = 512;
+const uint32_t DISK_SECTORS = 256;
+const uint32_t RECORD_SIZE = 100;
+const uint32_t RECORDS_PER_ROUND = 10;
+const uint32_t ROUNDS = 6;
+const int THREADS_PER_DISK = 2;
+}
+
+/* Sectors are allocated when first written, as most of the disk stays empty */
+class RamDisk : public FATFileSystem {
+public:
+    RamDisk(const char *name) : FATFileSystem(name) {
+        memset(sectors, 0, sizeof(sectors));
+    }
+
+    virtual int disk_read(uint8_t *buffer, uint32_t sector, uint32_t count) {
+        for (uint32_t i = 0; i < count; i++, sector++, buffer += SECTOR_SIZE) {
+            if (sector >= DISK_SECTORS) {
+                return 1;
+            }
+            if (sectors[sector]) {
+                memcpy(buffer, sectors[sector], SECTOR_SIZE);
+            } else {
+                memset(buffer, 0, SECTOR_SIZE);
+            }
+        }
+        Thread::yield();
+        return 0;
+    }
+
+    virtual int disk_write(const uint8_t *buffer, uint32_t sector, uint32_t count) {
+        for (uint32_t i = 0; i < count; i++, sector++, buffer += SECTOR_SIZE) {
+            if (sector >= DISK_SECTORS) {
+                return 1;
+            }
+            if (sectors[sector] == NULL) {
+                sectors[sector] = (uint8_t *)malloc(SECTOR_SIZE);
+                if (sectors[sector] == NULL) {
+                    return 1;
+                }
+            }
+            memcpy(sectors[sector], buffer, SECTOR_SIZE);
+        }
+        Thread::yield();
+        return 0;
+    }
+
+    virtual uint32_t disk_sectors() { return DISK_SECTORS; }
+
+private:
+    uint8_t *sectors[DISK_SECTORS];
+};
+
+RamDisk disk_a("a");
+RamDisk disk_b("b");
+Semaphore done(0);
+volatile bool failed = false;
+
+uint8_t record_byte(int id, uint32_t record, uint32_t i) {
+    return (uint8_t)(id * 37 + record * 11 + i);
+}
+
+bool append_and_verify(FATFileSystem *fs, int id) {
+    char name[16];
+    uint8_t record[RECORD_SIZE];
+    uint32_t written = 0;
+
+    sprintf(name, "t%d.log", id);
+    for (uint32_t round = 0; round < ROUNDS; round++) {
+        FileHandle *f = fs->open(name, O_WRONLY | O_CREAT | O_APPEND);
+        if (f == NULL) {
+            printf("MBED: thread %d can't open '%s' for writing" NL, id, name);
+            return false;
+        }
+        for (uint32_t r = 0; r < RECORDS_PER_ROUND; r++, written++) {
+            for (uint32_t i = 0; i < RECORD_SIZE; i++) {
+                record[i] = record_byte(id, written, i);
+            }
+            if (f->write(record, RECORD_SIZE) != (ssize_t)RECORD_SIZE) {
+                f->close();
+                return false;
+            }
+        }
+        // A file is open for writing once
+        FileHandle *second = fs->open(name, O_WRONLY);
+        if (second != NULL) {
+            printf("MBED: '%s' opened for writing twice" NL, name);
+            second->close();
+            f->close();
+            return false;
+        }
+        f->close();
+
+        // but for reading any number of times
+        f = fs->open(name, O_RDONLY);
+        second = fs->open(name, O_RDONLY);
+        if (f == NULL || second == NULL) {
+            printf("MBED: thread %d can't open '%s' for reading" NL, id, name);
+            return false;
+        }
+        second->close();
+        for (uint32_t r = 0; r < written; r++) {
+            if (f->read(record, RECORD_SIZE) != (ssize_t)RECORD_SIZE) {
+                f->close();
+                return false;
+            }
+            for (uint32_t i = 0; i < RECORD_SIZE; i++) {
+                if (record[i] != record_byte(id, r, i)) {
+                    printf("MBED: '%s' record %lu corrupted" NL, name, r);
+                    f->close();
+                    return false;
+                }
+            }
+        }
+        f->close();
+    }
+    return true;
+}
+
+void file_thread(void const *argument) {
+    int id = (int)argument;
+    if (!append_and_verify(id < THREADS_PER_DISK ? &disk_a : &disk_b, id)) {
+        failed = true;
+    }
+    done.release();
+}
+
+int main() {
+    MBED_HOSTTEST_TIMEOUT(20);
+    MBED_HOSTTEST_SELECT(default_auto);
+    MBED_HOSTTEST_DESCRIPTION(FAT concurrent file access);
+    MBED_HOSTTEST_START("RTOS_10");
+
+    if (disk_a.format() != 0 || disk_b.format() != 0 || disk_a.mount() != 0 || disk_b.mount() != 0) {
+        printf("MBED: Can't format the RAM disks" NL);
+        MBED_HOSTTEST_RESULT(false);
+    }
+
+    Thread *threads[2 * THREADS_PER_DISK];
+    for (int i = 0; i < 2 * THREADS_PER_DISK; i++) {
+        threads[i] = new Thread(file_thread, (void *)i, osPriorityNormal, (DEFAULT_STACK_SIZE * 2.25));
+    }
+    for (int i = 0; i < 2 * THREADS_PER_DISK; i++) {
+        done.wait();
+    }
+    for (int i = 0; i < 2 * THREADS_PER_DISK; i++) {
+        delete threads[i];
+    }
+
+    bool result = !failed && disk_a.unmount() == 0 && disk_b.unmount() == 0;
+    MBED_HOSTTEST_RESULT(result);
+}
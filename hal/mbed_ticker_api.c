@@ -14,9 +14,109 @@
  * limitations under the License.
  */
 #include <stddef.h>
+#include <string.h>
 #include "hal/ticker_api.h"
 #include "platform/critical.h"
 
+/* The events are kept in a pairing heap: the first event is the head, and
+ * every event comes before the events in its child list. The child lists
+ * are doubly linked through next and prev, with the prev of the first child
+ * pointing to the parent, so any event can be cut out in constant time.
+ * Inserting is constant time, removing the head or any other event takes
+ * O(log n) amortized time to merge its children. */
+
+/* Earlier timestamp first, and the first inserted of events with the same
+ * timestamp */
+static inline int ticker_before(const ticker_event_t *a, const ticker_event_t *b) {
+    int diff = (int)(a->timestamp - b->timestamp);
+    return diff < 0 || (diff == 0 && (int)(a->seq - b->seq) < 0);
+}
+
+static inline int ticker_queued(const ticker_event_queue_t *queue, const ticker_event_t *obj) {
+    return obj == queue->head || obj->prev != NULL;
+}
+
+/* Merge two heaps, the later head becomes the first child of the other */
+static ticker_event_t *ticker_meld(ticker_event_t *a, ticker_event_t *b) {
+    if (a == NULL) {
+        return b;
+    }
+    if (b == NULL) {
+        return a;
+    }
+    if (ticker_before(b, a)) {
+        ticker_event_t *t = a;
+        a = b;
+        b = t;
+    }
+    b->prev = a;
+    b->next = a->child;
+    if (a->child != NULL) {
+        a->child->prev = b;
+    }
+    a->child = b;
+    return a;
+}
+
+/* Merge a child list into one heap: meld the children in pairs from the
+ * left, then the pairs into one from the right */
+static ticker_event_t *ticker_merge_pairs(ticker_event_t *first) {
+    ticker_event_t *pairs = NULL;
+    while (first != NULL) {
+        ticker_event_t *a = first;
+        ticker_event_t *b = a->next;
+        first = b != NULL ? b->next : NULL;
+        a->next = a->prev = NULL;
+        if (b != NULL) {
+            b->next = b->prev = NULL;
+        }
+        a = ticker_meld(a, b);
+        // Stack the pairs through next, the root of each is unlinked
+        a->next = pairs;
+        pairs = a;
+    }
+
+    ticker_event_t *root = NULL;
+    while (pairs != NULL) {
+        ticker_event_t *a = pairs;
+        pairs = a->next;
+        a->next = NULL;
+        root = ticker_meld(a, root);
+    }
+    return root;
+}
+
+static void ticker_heap_remove(ticker_event_queue_t *queue, ticker_event_t *obj) {
+    if (obj == queue->head) {
+        queue->head = ticker_merge_pairs(obj->child);
+    } else {
+        // Cut it out of its parent's child list, then merge back its children
+        if (obj->prev->child == obj) {
+            obj->prev->child = obj->next;
+        } else {
+            obj->prev->next = obj->next;
+        }
+        if (obj->next != NULL) {
+            obj->next->prev = obj->prev;
+        }
+        queue->head = ticker_meld(queue->head, ticker_merge_pairs(obj->child));
+    }
+    obj->child = obj->next = obj->prev = NULL;
+}
+
+/* Set the interrupt for the first event, or disable it if there are none.
+ * While the IRQ handler runs events it does this once they have run. */
+static void ticker_schedule(const ticker_data_t *const data) {
+    if (data->queue->dispatching) {
+        return;
+    }
+    if (data->queue->head == NULL) {
+        data->interface->disable_interrupt();
+    } else {
+        data->interface->set_interrupt(data->queue->head->timestamp);
+    }
+}
+
 void ticker_set_handler(const ticker_data_t *const data, ticker_event_handler handler) {
     data->interface->init();
 
@@ -24,90 +124,110 @@ void ticker_set_handler(const ticker_data_t *const data, ticker_event_handler ha
 }
 
 void ticker_irq_handler(const ticker_data_t *const data) {
+    ticker_event_queue_t *queue = data->queue;
+
     data->interface->clear_interrupt();
 
+    core_util_critical_section_enter();
+    queue->dispatching = 1;
     /* Go through all the pending TimerEvents */
     while (1) {
-        if (data->queue->head == NULL) {
+        ticker_event_t *p = queue->head;
+        if (p == NULL) {
             // There are no more TimerEvents left, so disable matches.
             data->interface->disable_interrupt();
-            return;
+            break;
         }
 
-        if ((int)(data->queue->head->timestamp - data->interface->read()) <= 0) {
-            // This event was in the past:
-            //      point to the following one and execute its handler
-            ticker_event_t *p = data->queue->head;
-            data->queue->head = data->queue->head->next;
-            if (data->queue->event_handler != NULL) {
-                (*data->queue->event_handler)(p->id); // NOTE: the handler can set new events
-            }
-            /* Note: We continue back to examining the head because calling the
-             * event handler may have altered the chain of pending events. */
-        } else {
-            // This event and the following ones in the list are in the future:
+        uint32_t late = data->interface->read() - p->timestamp;
+        if ((int)late < 0) {
+            // This event and the following ones are in the future:
             //      set it as next interrupt and return
-            data->interface->set_interrupt(data->queue->head->timestamp);
-            return;
+            queue->dispatching = 0;
+            data->interface->set_interrupt(p->timestamp);
+            break;
+        }
+
+        // This event was in the past:
+        //      take it off the queue and execute its handler
+        ticker_heap_remove(queue, p);
+        queue->stats.dispatched++;
+        if (late > queue->stats.late_max) {
+            queue->stats.late_max = late;
         }
+        core_util_critical_section_exit();
+        if (queue->event_handler != NULL) {
+            (*queue->event_handler)(p->id); // NOTE: the handler can set new events
+        }
+        /* Note: We continue back to examining the head because calling the
+         * event handler may have altered the pending events. */
+        core_util_critical_section_enter();
     }
+    queue->dispatching = 0;
+    core_util_critical_section_exit();
 }
 
 void ticker_insert_event(const ticker_data_t *const data, ticker_event_t *obj, timestamp_t timestamp, uint32_t id) {
+    ticker_event_queue_t *queue = data->queue;
+
     /* disable interrupts for the duration of the function */
     core_util_critical_section_enter();
 
+    ticker_event_t *head = queue->head;
+    if (ticker_queued(queue, obj)) {
+        ticker_heap_remove(queue, obj);
+    }
+
     // initialise our data
     obj->timestamp = timestamp;
     obj->id = id;
+    obj->seq = queue->seq++;
+    obj->child = obj->next = obj->prev = NULL;
+    queue->head = ticker_meld(queue->head, obj);
 
-    /* Go through the list until we either reach the end, or find
-       an element this should come before (which is possibly the
-       head). */
-    ticker_event_t *prev = NULL, *p = data->queue->head;
-    while (p != NULL) {
-        /* check if we come before p */
-        if ((int)(timestamp - p->timestamp) < 0) {
-            break;
-        }
-        /* go to the next element */
-        prev = p;
-        p = p->next;
-    }
-    /* if prev is NULL we're at the head */
-    if (prev == NULL) {
-        data->queue->head = obj;
-        data->interface->set_interrupt(timestamp);
-    } else {
-        prev->next = obj;
+    if (queue->head != head || obj == head) {
+        ticker_schedule(data);
+    }
+
+    core_util_critical_section_exit();
+}
+
+void ticker_rearm_event(const ticker_data_t *const data, ticker_event_t *obj, timestamp_t period) {
+    ticker_event_queue_t *queue = data->queue;
+
+    core_util_critical_section_enter();
+
+    ticker_event_t *head = queue->head;
+    if (ticker_queued(queue, obj)) {
+        ticker_heap_remove(queue, obj);
+    }
+
+    obj->timestamp += period;
+    if ((int)(data->interface->read() - obj->timestamp) >= 0) {
+        queue->stats.catch_up++;
+    }
+    obj->seq = queue->seq++;
+    obj->child = obj->next = obj->prev = NULL;
+    queue->head = ticker_meld(queue->head, obj);
+
+    if (queue->head != head || obj == head) {
+        ticker_schedule(data);
     }
-    /* if we're at the end p will be NULL, which is correct */
-    obj->next = p;
 
     core_util_critical_section_exit();
 }
 
 void ticker_remove_event(const ticker_data_t *const data, ticker_event_t *obj) {
+    ticker_event_queue_t *queue = data->queue;
+
     core_util_critical_section_enter();
 
-    // remove this object from the list
-    if (data->queue->head == obj) {
-        // first in the list, so just drop me
-        data->queue->head = obj->next;
-        if (data->queue->head == NULL) {
-            data->interface->disable_interrupt();
-        } else {
-            data->interface->set_interrupt(data->queue->head->timestamp);
-        }
-    } else {
-        // find the object before me, then drop me
-        ticker_event_t* p = data->queue->head;
-        while (p != NULL) {
-            if (p->next == obj) {
-                p->next = obj->next;
-                break;
-            }
-            p = p->next;
+    if (ticker_queued(queue, obj)) {
+        ticker_event_t *head = queue->head;
+        ticker_heap_remove(queue, obj);
+        if (obj == head) {
+            // first in the queue, so the interrupt moves to the next one
+            ticker_schedule(data);
         }
     }
 
@@ -133,3 +253,17 @@ int ticker_get_next_timestamp(const ticker_data_t *const data, timestamp_t *time
 
     return ret;
 }
+
+void ticker_get_stats(const ticker_data_t *const data, ticker_stats_t *stats)
+{
+    core_util_critical_section_enter();
+    *stats = data->queue->stats;
+    core_util_critical_section_exit();
+}
+
+void ticker_reset_stats(const ticker_data_t *const data)
+{
+    core_util_critical_section_enter();
+    memset(&data->queue->stats, 0, sizeof(data->queue->stats));
+    core_util_critical_section_exit();
+}
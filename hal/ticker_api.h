@@ -25,11 +25,17 @@
 typedef uint32_t timestamp_t;
 
 /** Ticker's event structure
+ *
+ * Events must be zero initialized, or have been inserted, before they are
+ * removed. The links are only used by the queue.
  */
 typedef struct ticker_event_s {
     timestamp_t            timestamp; /**< Event's timestamp */
     uint32_t               id;        /**< TimerEvent object */
-    struct ticker_event_s *next;      /**< Next event in the queue */
+    uint32_t               seq;       /**< Insertion order, among events with the same timestamp */
+    struct ticker_event_s *child;     /**< First of the later events under this one */
+    struct ticker_event_s *next;      /**< Next event under the same parent */
+    struct ticker_event_s *prev;      /**< Previous event under the same parent, or the parent */
 } ticker_event_t;
 
 typedef void (*ticker_event_handler)(uint32_t id);
@@ -44,11 +50,26 @@ typedef struct {
     void (*set_interrupt)(timestamp_t timestamp); /**< Set interrupt function */
 } ticker_interface_t;
 
+/** Ticker's event statistics
+ */
+typedef struct {
+    uint32_t dispatched;                /**< Events run by the IRQ handler */
+    uint32_t late_max;                  /**< Longest an event ran after its timestamp, in ticks */
+    uint32_t catch_up;                  /**< Periodic events rearmed to a timestamp already passed */
+} ticker_stats_t;
+
 /** Ticker's event queue structure
+ *
+ * The events are kept in a pairing heap, ordered by timestamp relative to
+ * each other, so pending events must all be within 2^31 ticks of each other.
+ * Events with the same timestamp run in the order they were inserted.
  */
 typedef struct {
     ticker_event_handler event_handler; /**< Event handler */
-    ticker_event_t *head;               /**< A pointer to head */
+    ticker_event_t *head;               /**< A pointer to head, the first event */
+    uint32_t seq;                       /**< Sequence number of the next event inserted */
+    uint8_t dispatching;                /**< The IRQ handler is running events */
+    ticker_stats_t stats;               /**< Event statistics */
 } ticker_event_queue_t;
 
 /** Ticker's data structure
@@ -80,14 +101,14 @@ void ticker_set_handler(const ticker_data_t *const data, ticker_event_handler ha
  */
 void ticker_irq_handler(const ticker_data_t *const data);
 
-/** Remove an event from the queue
+/** Remove an event from the queue, if it is in it
  *
  * @param data The ticker's data
  * @param obj  The event object to be removed from the queue
  */
 void ticker_remove_event(const ticker_data_t *const data, ticker_event_t *obj);
 
-/** Insert an event to the queue
+/** Insert an event to the queue, or move it if it is already in it
  *
  * @param data      The ticker's data
  * @param obj       The event object to be inserted to the queue
@@ -96,6 +117,20 @@ void ticker_remove_event(const ticker_data_t *const data, ticker_event_t *obj);
  */
 void ticker_insert_event(const ticker_data_t *const data, ticker_event_t *obj, timestamp_t timestamp, uint32_t id);
 
+/** Insert a periodic event back to the queue, one period after its last timestamp
+ *
+ * Meant to be called from the event handler once the event has run, so the
+ * timestamps stay in step with the period however late the handler runs.
+ * Events inserted by the handlers are gathered and the interrupt is set once
+ * they return. If the new timestamp has already passed, the event runs again
+ * straight away and is counted in the catch_up statistic.
+ *
+ * @param data   The ticker's data
+ * @param obj    The event object
+ * @param period The time from the event's last timestamp
+ */
+void ticker_rearm_event(const ticker_data_t *const data, ticker_event_t *obj, timestamp_t period);
+
 /** Read the current ticker's timestamp
  *
  * @param data The ticker's data
@@ -110,6 +145,19 @@ timestamp_t ticker_read(const ticker_data_t *const data);
  */
 int ticker_get_next_timestamp(const ticker_data_t *const data, timestamp_t *timestamp);
 
+/** Read the ticker's event statistics
+ *
+ * @param data  The ticker's data
+ * @param stats The structure to fill
+ */
+void ticker_get_stats(const ticker_data_t *const data, ticker_stats_t *stats);
+
+/** Reset the ticker's event statistics
+ *
+ * @param data The ticker's data
+ */
+void ticker_reset_stats(const ticker_data_t *const data);
+
 /**@}*/
 
 #ifdef __cplusplus
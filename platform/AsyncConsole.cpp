@@ -0,0 +1,292 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "platform/AsyncConsole.h"
+#include "platform/critical.h"
+#include "platform/mbed_assert.h"
+#include "platform/wait_api.h"
+#include "cmsis.h"
+#include <stdio.h>
+#include <string.h>
+
+#define DRAIN_SIGNAL    0x1
+
+namespace mbed {
+
+AsyncConsole::AsyncConsole(FileHandle *output, uint32_t buffer_size, OverflowPolicy policy)
+    : _output(output), _mask(buffer_size - 1), _policy(policy),
+      _reserve(0), _commit(0), _tail(0), _draining(0), _kicked(0), _dropped_unreported(0)
+#ifdef MBED_CONF_RTOS_PRESENT
+      , _thread(NULL)
+#endif
+{
+    MBED_ASSERT(buffer_size >= 16 && (buffer_size & (buffer_size - 1)) == 0);
+    _buffer = new char[buffer_size];
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+AsyncConsole::~AsyncConsole() {
+#ifdef MBED_CONF_RTOS_PRESENT
+    if (_thread) {
+        _thread->terminate();
+        delete _thread;
+    }
+#endif
+    delete[] _buffer;
+}
+
+bool AsyncConsole::reserve(uint32_t length, uint32_t *start) {
+    uint32_t reserve = _reserve;
+    do {
+        if (reserve + length - _tail > _mask + 1) {
+            return false;
+        }
+    } while (!core_util_atomic_cas_u32((uint32_t *)&_reserve, &reserve, reserve + length));
+
+    *start = reserve;
+    return true;
+}
+
+void AsyncConsole::commit(uint32_t length) {
+    // Make the copied data visible before the drain side can see it
+    __DMB();
+    core_util_atomic_incr_u32((uint32_t *)&_commit, length);
+}
+
+ssize_t AsyncConsole::write(const void *buffer, size_t length) {
+    const char *ptr = (const char *)buffer;
+    size_t remaining = length;
+    // Split long writes so that a single one can never exceed the ring
+    const uint32_t chunk_max = (_mask + 1) / 4;
+    bool can_wait = !core_util_is_isr_active() && core_util_are_interrupts_enabled();
+    bool self_drain = !_kick_cb && can_wait;
+#ifdef MBED_CONF_RTOS_PRESENT
+    self_drain = self_drain && !_thread;
+#endif
+
+    while (remaining > 0) {
+        uint32_t size = remaining < chunk_max ? remaining : chunk_max;
+        uint32_t start;
+        bool reserved;
+
+        while (!(reserved = reserve(size, &start)) && _policy == OverflowBlock && can_wait) {
+            if (!(self_drain && drain() > 0)) {
+                kick();
+                wait_ms(1);
+            }
+        }
+
+        if (reserved) {
+            uint32_t index = start & _mask;
+            uint32_t first = _mask + 1 - index;
+            if (first > size) {
+                first = size;
+            }
+            memcpy(&_buffer[index], ptr, first);
+            memcpy(&_buffer[0], ptr + first, size - first);
+            commit(size);
+
+            core_util_atomic_incr_u32(&_stats.bytes_written, size);
+            uint32_t used = start + size - _tail;
+            uint32_t max_used = _stats.max_used;
+            while (used > max_used &&
+                   !core_util_atomic_cas_u32(&_stats.max_used, &max_used, used));
+        } else {
+            core_util_atomic_incr_u32(&_stats.bytes_dropped, size);
+            core_util_atomic_incr_u32((uint32_t *)&_dropped_unreported, size);
+        }
+
+        ptr += size;
+        remaining -= size;
+    }
+
+    if (self_drain) {
+        drain();
+    } else {
+        kick();
+    }
+
+    return length;
+}
+
+ssize_t AsyncConsole::read(void *buffer, size_t length) {
+    return _output->read(buffer, length);
+}
+
+int AsyncConsole::close() {
+    return 0;
+}
+
+int AsyncConsole::isatty() {
+    return 1;
+}
+
+off_t AsyncConsole::lseek(off_t offset, int whence) {
+    return -1;
+}
+
+int AsyncConsole::fsync() {
+    if (core_util_is_isr_active() || !core_util_are_interrupts_enabled()) {
+        return 0;
+    }
+
+    uint32_t target = _reserve;
+    while ((int32_t)(target - _tail) > 0) {
+        bool self_drain = !_kick_cb;
+#ifdef MBED_CONF_RTOS_PRESENT
+        self_drain = self_drain && !_thread;
+#endif
+        if (!(self_drain && drain() > 0)) {
+            kick();
+            wait_ms(1);
+        }
+    }
+
+    return _output->fsync();
+}
+
+short AsyncConsole::poll(short events) const {
+    short revents = 0;
+    if (_reserve - _tail <= _mask) {
+        revents |= POLLOUT;
+    }
+    if (events & POLLIN) {
+        revents |= _output->poll(POLLIN);
+    }
+    return revents & events;
+}
+
+uint32_t AsyncConsole::drain() {
+    uint8_t idle = 0;
+    if (!core_util_atomic_cas_u8((uint8_t *)&_draining, &idle, 1)) {
+        return 0;
+    }
+
+    // Writes committed from now on must kick again
+    _kicked = 0;
+    uint32_t count = drain_to(_output);
+
+    _draining = 0;
+    return count;
+}
+
+void AsyncConsole::panic_drain(FileHandle *target) {
+    drain_to(target);
+}
+
+uint32_t AsyncConsole::drain_to(FileHandle *target) {
+    uint32_t count = 0;
+
+    while (true) {
+        // Data is only known to be complete when no write is in progress,
+        // i.e. when everything reserved has also been committed. Reading
+        // _commit first guarantees that held at that moment.
+        uint32_t commit = _commit;
+        __DMB();
+        if (commit != _reserve) {
+            // The writer kicks again once it has committed
+            break;
+        }
+
+        uint32_t tail = _tail;
+        if (commit == tail) {
+            break;
+        }
+
+        uint32_t index = tail & _mask;
+        uint32_t size = _mask + 1 - index;
+        if (size > commit - tail) {
+            size = commit - tail;
+        }
+
+        ssize_t written = target->write(&_buffer[index], size);
+        if (written <= 0) {
+            break;
+        }
+
+        __DMB();
+        _tail = tail + written;
+        count += written;
+    }
+
+    core_util_atomic_incr_u32(&_stats.bytes_drained, count);
+
+    if (_policy == OverflowReport && _dropped_unreported) {
+        uint32_t dropped = _dropped_unreported;
+        while (!core_util_atomic_cas_u32((uint32_t *)&_dropped_unreported, &dropped, 0));
+
+        char msg[40];
+        int len = snprintf(msg, sizeof(msg), "\n[console: %lu bytes dropped]\n", (unsigned long)dropped);
+        if (len > 0) {
+            target->write(msg, len);
+        }
+    }
+
+    return count;
+}
+
+void AsyncConsole::kick() {
+    if (_kicked) {
+        return;
+    }
+
+#ifdef MBED_CONF_RTOS_PRESENT
+    if (_thread) {
+        _kicked = 1;
+        _thread->signal_set(DRAIN_SIGNAL);
+        return;
+    }
+#endif
+    if (_kick_cb) {
+        _kicked = 1;
+        _kick_cb.call();
+    }
+}
+
+void AsyncConsole::attach(Callback<void()> func) {
+    core_util_critical_section_enter();
+    _kick_cb = func;
+    core_util_critical_section_exit();
+}
+
+#ifdef MBED_CONF_RTOS_PRESENT
+osStatus AsyncConsole::start(osPriority priority, uint32_t stack_size) {
+    if (_thread) {
+        return osErrorResource;
+    }
+
+    _thread = new rtos::Thread(priority, stack_size);
+    return _thread->start(callback(this, &AsyncConsole::drain_thread));
+}
+
+void AsyncConsole::drain_thread() {
+    while (true) {
+        rtos::Thread::signal_wait(DRAIN_SIGNAL);
+        drain();
+    }
+}
+#endif
+
+void AsyncConsole::set_overflow_policy(OverflowPolicy policy) {
+    _policy = policy;
+}
+
+void AsyncConsole::get_stats(Stats *stats) const {
+    core_util_critical_section_enter();
+    memcpy(stats, &_stats, sizeof(*stats));
+    core_util_critical_section_exit();
+}
+
+} // namespace mbed
@@ -0,0 +1,198 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef MBED_ASYNCCONSOLE_H
+#define MBED_ASYNCCONSOLE_H
+
+#include <stdint.h>
+#include "drivers/FileHandle.h"
+#include "platform/Callback.h"
+
+#ifdef MBED_CONF_RTOS_PRESENT
+#include "rtos/Thread.h"
+#endif
+
+namespace mbed {
+/** \addtogroup platform */
+/** @{*/
+
+/** Console that decouples writers from a slow output device
+ *
+ *  Writes are appended to a log ring and return immediately; the ring is
+ *  drained in bulk to the output FileHandle by a low priority thread (see
+ *  start()), by whatever calls drain() (for example an EventQueue event
+ *  scheduled from the attach() callback), or, when neither is set up, by
+ *  the writer itself once its data is queued.
+ *
+ *  The ring is lock-free for any number of writers, including interrupt
+ *  handlers: each write reserves its space with a compare-and-swap, copies
+ *  its data and then publishes it. The drain side only ever sees complete
+ *  writes.
+ *
+ *  Writes are published with a single counter, so the ring only drains
+ *  once every write in progress has completed: a writer preempted half way,
+ *  for example by a higher priority thread that keeps writing, holds back
+ *  the output until it runs again.
+ *
+ *  @Note Synchronization level: Interrupt safe for write(); drain() is
+ *        serialized internally
+ */
+class AsyncConsole : public FileHandle {
+
+public:
+    /** What write() does when the ring has no room for the data */
+    enum OverflowPolicy {
+        OverflowDrop = 0,   /**< Discard the data, counted in the statistics */
+        OverflowReport = 1, /**< Discard the data and report the loss in the output */
+        OverflowBlock = 2,  /**< Wait for the ring to drain (drops from interrupts) */
+    };
+
+    /** Console statistics */
+    struct Stats {
+        uint32_t bytes_written;  /**< Bytes accepted into the ring */
+        uint32_t bytes_dropped;  /**< Bytes discarded because the ring was full */
+        uint32_t bytes_drained;  /**< Bytes passed to the output */
+        uint32_t max_used;       /**< High-water mark of the ring, in bytes */
+    };
+
+    /** Create a console
+     *
+     *  @param output       FileHandle the data is eventually written to
+     *  @param buffer_size  Size of the log ring in bytes, a power of two
+     *  @param policy       Overflow policy
+     */
+    AsyncConsole(FileHandle *output, uint32_t buffer_size, OverflowPolicy policy = OverflowReport);
+
+    virtual ~AsyncConsole();
+
+    /** Queue data for output
+     *
+     *  @param buffer the buffer to write from
+     *  @param length the number of bytes to write
+     *
+     *  @returns
+     *    length, even if the data was dropped by the overflow policy
+     */
+    virtual ssize_t write(const void *buffer, size_t length);
+
+    /** Read from the output FileHandle */
+    virtual ssize_t read(void *buffer, size_t length);
+
+    virtual int close();
+    virtual int isatty();
+    virtual off_t lseek(off_t offset, int whence);
+
+    /** Wait until everything queued so far has reached the output
+     *
+     *  @returns the result of fsync on the output
+     */
+    virtual int fsync();
+
+    /** Check for readiness without blocking
+     *
+     *  @returns POLLOUT if there is room in the ring, POLLIN as reported by
+     *           the output, masked by events
+     */
+    virtual short poll(short events) const;
+
+    /** Move every complete write from the ring to the output
+     *
+     *  Returns immediately if another context is already draining.
+     *
+     *  @returns the number of bytes written to the output
+     */
+    uint32_t drain();
+
+    /** Drain the ring synchronously to another FileHandle
+     *
+     *  For fatal error paths: ignores any drain in progress and does not
+     *  take any lock, so target must be usable with interrupts disabled.
+     *
+     *  @param target FileHandle to write to instead of the output
+     */
+    void panic_drain(FileHandle *target);
+
+    /** Attach a function to call when data is queued and nothing is
+     *  draining yet, e.g. to post drain() to an EventQueue
+     *
+     *  @param func Function to call from the writer's context, or an
+     *              empty Callback to remove it
+     */
+    void attach(Callback<void()> func);
+
+#ifdef MBED_CONF_RTOS_PRESENT
+    /** Drain the ring from a dedicated thread
+     *
+     *  @param priority   Priority of the drain thread, normally below the
+     *                    threads that write to the console
+     *  @param stack_size Stack size of the drain thread
+     *
+     *  @returns status code from starting the thread
+     */
+    osStatus start(osPriority priority = osPriorityLow, uint32_t stack_size = 768);
+#endif
+
+    /** Change the overflow policy
+     *
+     *  @param policy New policy
+     */
+    void set_overflow_policy(OverflowPolicy policy);
+
+    /** Get the console statistics
+     *
+     *  @param stats Filled with a snapshot of the counters
+     */
+    void get_stats(Stats *stats) const;
+
+private:
+    bool reserve(uint32_t length, uint32_t *start);
+    void commit(uint32_t length);
+    uint32_t drain_to(FileHandle *target);
+    void kick();
+#ifdef MBED_CONF_RTOS_PRESENT
+    void drain_thread();
+#endif
+
+    FileHandle *_output;
+    char *_buffer;
+    uint32_t _mask;
+    OverflowPolicy _policy;
+    Callback<void()> _kick_cb;
+
+    // Free-running byte counters: space is claimed by advancing _reserve
+    // and published by adding to _commit once the copy is complete
+    volatile uint32_t _reserve;
+    volatile uint32_t _commit;
+    volatile uint32_t _tail;
+
+    volatile uint8_t _draining;
+    volatile uint8_t _kicked;
+    volatile uint32_t _dropped_unreported;
+    Stats _stats;
+
+#ifdef MBED_CONF_RTOS_PRESENT
+    rtos::Thread *_thread;
+#endif
+
+    /* disallow copy constructor and assignment operators */
+    AsyncConsole(const AsyncConsole&);
+    AsyncConsole & operator = (const AsyncConsole&);
+};
+
+} // namespace mbed
+
+#endif
+
+/** @}*/
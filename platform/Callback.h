@@ -27,13 +27,6 @@ namespace mbed {
 /** @{*/
 
 
-/** Callback class based on template specialization
- *
- * @Note Synchronization level: Not protected
- */
-template <typename F>
-class Callback;
-
 // Internal sfinae declarations
 //
 // These are used to eliminate overloads based on type attributes
@@ -56,20 +49,83 @@ namespace detail {
     struct is_type {
         static const bool value = true;
     };
+
+    // Storage of a function object, at least large enough for a member
+    // function pointer and an object pointer, and aligned for them
+    struct _class;
+
+    const size_t callback_default_size = sizeof(void (_class::*)()) + sizeof(void*);
+
+    template <size_t N>
+    union callback_storage {
+        char data[N > callback_default_size ? N : callback_default_size];
+        void (*staticfunc)();
+        void (_class::*methodfunc)();
+        void *obj;
+    };
+
+    template <typename T>
+    struct alignment_of {
+        struct probe { char c; T t; };
+        static const size_t value = sizeof(probe) - sizeof(T);
+    };
+
+    template <typename F, size_t N>
+    struct callback_fits {
+        static const bool value = sizeof(F) <= sizeof(callback_storage<N>) &&
+                alignment_of<F>::value <= alignment_of<callback_storage<N> >::value;
+    };
+
+    // Function objects that can be copied with memcpy and need no destructor
+    template <typename F>
+    struct is_trivial {
+#if defined(__GNUC__) || defined(__clang__)
+        static const bool value = __has_trivial_copy(F) && __has_trivial_destructor(F);
+#else
+        static const bool value = false;
+#endif
+    };
 }
 
+/** Callback class based on template specialization
+ *
+ *  Function objects are stored inside the Callback, so attaching one never
+ *  allocates memory. By default there is room for a member function pointer
+ *  and an object pointer; a larger N makes room for function objects with
+ *  more state, up to N bytes. Function objects that are trivially copyable
+ *  are copied without an indirect call and need no destructor call.
+ *
+ *  @code
+ *  struct Sample {
+ *      uint32_t channel, value, time;
+ *      void operator()() const { ... }
+ *  };
+ *
+ *  Sample sample = {1, 2, 3};
+ *  Callback<void(), sizeof(Sample)> cb(sample);
+ *  queue.call(cb);     // Takes an event of sizeof(cb) from the EventQueue
+ *  @endcode
+ *
+ *  The default Callback keeps its size, which EVENTS_EVENT_SIZE is based on.
+ *
+ * @Note Synchronization level: Not protected
+ */
+template <typename F, size_t N = detail::callback_default_size>
+class Callback;
+
 /** Callback class based on template specialization
  *
  * @Note Synchronization level: Not protected
  */
-template <typename R>
-class Callback<R()> {
+template <typename R, size_t N>
+class Callback<R(), N> {
 public:
     /** Create a Callback with a static function
      *  @param func     Static function to attach
      */
     Callback(R (*func)() = 0) {
         if (!func) {
+            memset(&_storage, 0, sizeof(_storage));
             _ops = 0;
         } else {
             generate(func);
@@ -79,9 +135,11 @@ public:
     /** Attach a Callback
      *  @param func     The Callback to attach
      */
-    Callback(const Callback<R()> &func) {
-        if (func._ops) {
+    Callback(const Callback &func) {
+        if (func._ops && func._ops->move) {
             func._ops->move(this, &func);
+        } else {
+            memcpy(&_storage, &func._storage, sizeof(_storage));
         }
         _ops = func._ops;
     }
@@ -192,48 +250,48 @@ public:
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     Callback(F f, typename detail::enable_if<
                 detail::is_type<R (F::*)(), &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         generate(f);
     }
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     Callback(const F f, typename detail::enable_if<
                 detail::is_type<R (F::*)() const, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         generate(f);
     }
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     Callback(volatile F f, typename detail::enable_if<
                 detail::is_type<R (F::*)() volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         generate(f);
     }
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     Callback(const volatile F f, typename detail::enable_if<
                 detail::is_type<R (F::*)() const volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         generate(f);
     }
@@ -341,7 +399,7 @@ public:
     /** Destroy a callback
      */
     ~Callback() {
-        if (_ops) {
+        if (_ops && _ops->dtor) {
             _ops->dtor(this);
         }
     }
@@ -357,7 +415,7 @@ public:
     /** Attach a Callback
      *  @param func     The Callback to attach
      */
-    void attach(const Callback<R()> &func) {
+    void attach(const Callback &func) {
         this->~Callback();
         new (this) Callback(func);
     }
@@ -480,12 +538,12 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     void attach(F f, typename detail::enable_if<
                 detail::is_type<R (F::*)(), &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -493,12 +551,12 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     void attach(const F f, typename detail::enable_if<
                 detail::is_type<R (F::*)() const, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -506,12 +564,12 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     void attach(volatile F f, typename detail::enable_if<
                 detail::is_type<R (F::*)() volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -519,12 +577,12 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     void attach(const volatile F f, typename detail::enable_if<
                 detail::is_type<R (F::*)() const volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -688,16 +746,9 @@ public:
     }
 
 private:
-    // Stored as pointer to function and pointer to optional object
-    // Function pointer is stored as union of possible function types
-    // to garuntee proper size and alignment
-    struct _class;
-    union {
-        void (*_staticfunc)();
-        void (*_boundfunc)(_class*);
-        void (_class::*_methodfunc)();
-    } _func;
-    void *_obj;
+    // Function object stored in place, function pointers and member
+    // function pointers are stored in function objects as well
+    detail::callback_storage<N> _storage;
 
     // Dynamically dispatched operations
     const struct ops {
@@ -709,13 +760,16 @@ private:
     // Generate operations for function object
     template <typename F>
     void generate(const F &f) {
+        // Trivial function objects are copied with memcpy and not destroyed
         static const ops ops = {
             &Callback::function_call<F>,
-            &Callback::function_move<F>,
-            &Callback::function_dtor<F>,
+            detail::is_trivial<F>::value ? 0 : &Callback::function_move<F>,
+            detail::is_trivial<F>::value ? 0 : &Callback::function_dtor<F>,
         };
 
-        MBED_ASSERT(sizeof(Callback) - sizeof(_ops) >= sizeof(F));
+        MBED_ASSERT(sizeof(_storage) >= sizeof(F));
+        // Cleared so that equal function objects compare equal
+        memset(&_storage, 0, sizeof(_storage));
         new (this) F(f);
         _ops = &ops;
     }
@@ -768,14 +822,15 @@ private:
  *
  * @Note Synchronization level: Not protected
  */
-template <typename R, typename A0>
-class Callback<R(A0)> {
+template <typename R, typename A0, size_t N>
+class Callback<R(A0), N> {
 public:
     /** Create a Callback with a static function
      *  @param func     Static function to attach
      */
     Callback(R (*func)(A0) = 0) {
         if (!func) {
+            memset(&_storage, 0, sizeof(_storage));
             _ops = 0;
         } else {
             generate(func);
@@ -785,9 +840,11 @@ public:
     /** Attach a Callback
      *  @param func     The Callback to attach
      */
-    Callback(const Callback<R(A0)> &func) {
-        if (func._ops) {
+    Callback(const Callback &func) {
+        if (func._ops && func._ops->move) {
             func._ops->move(this, &func);
+        } else {
+            memcpy(&_storage, &func._storage, sizeof(_storage));
         }
         _ops = func._ops;
     }
@@ -898,48 +955,48 @@ public:
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     Callback(F f, typename detail::enable_if<
                 detail::is_type<R (F::*)(A0), &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         generate(f);
     }
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     Callback(const F f, typename detail::enable_if<
                 detail::is_type<R (F::*)(A0) const, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         generate(f);
     }
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     Callback(volatile F f, typename detail::enable_if<
                 detail::is_type<R (F::*)(A0) volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         generate(f);
     }
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     Callback(const volatile F f, typename detail::enable_if<
                 detail::is_type<R (F::*)(A0) const volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         generate(f);
     }
@@ -1047,7 +1104,7 @@ public:
     /** Destroy a callback
      */
     ~Callback() {
-        if (_ops) {
+        if (_ops && _ops->dtor) {
             _ops->dtor(this);
         }
     }
@@ -1063,7 +1120,7 @@ public:
     /** Attach a Callback
      *  @param func     The Callback to attach
      */
-    void attach(const Callback<R(A0)> &func) {
+    void attach(const Callback &func) {
         this->~Callback();
         new (this) Callback(func);
     }
@@ -1186,12 +1243,12 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     void attach(F f, typename detail::enable_if<
                 detail::is_type<R (F::*)(A0), &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -1199,12 +1256,12 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     void attach(const F f, typename detail::enable_if<
                 detail::is_type<R (F::*)(A0) const, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -1212,12 +1269,12 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     void attach(volatile F f, typename detail::enable_if<
                 detail::is_type<R (F::*)(A0) volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -1225,12 +1282,12 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     void attach(const volatile F f, typename detail::enable_if<
                 detail::is_type<R (F::*)(A0) const volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -1394,16 +1451,9 @@ public:
     }
 
 private:
-    // Stored as pointer to function and pointer to optional object
-    // Function pointer is stored as union of possible function types
-    // to garuntee proper size and alignment
-    struct _class;
-    union {
-        void (*_staticfunc)(A0);
-        void (*_boundfunc)(_class*, A0);
-        void (_class::*_methodfunc)(A0);
-    } _func;
-    void *_obj;
+    // Function object stored in place, function pointers and member
+    // function pointers are stored in function objects as well
+    detail::callback_storage<N> _storage;
 
     // Dynamically dispatched operations
     const struct ops {
@@ -1415,13 +1465,16 @@ private:
     // Generate operations for function object
     template <typename F>
     void generate(const F &f) {
+        // Trivial function objects are copied with memcpy and not destroyed
         static const ops ops = {
             &Callback::function_call<F>,
-            &Callback::function_move<F>,
-            &Callback::function_dtor<F>,
+            detail::is_trivial<F>::value ? 0 : &Callback::function_move<F>,
+            detail::is_trivial<F>::value ? 0 : &Callback::function_dtor<F>,
         };
 
-        MBED_ASSERT(sizeof(Callback) - sizeof(_ops) >= sizeof(F));
+        MBED_ASSERT(sizeof(_storage) >= sizeof(F));
+        // Cleared so that equal function objects compare equal
+        memset(&_storage, 0, sizeof(_storage));
         new (this) F(f);
         _ops = &ops;
     }
@@ -1474,14 +1527,15 @@ private:
  *
  * @Note Synchronization level: Not protected
  */
-template <typename R, typename A0, typename A1>
-class Callback<R(A0, A1)> {
+template <typename R, typename A0, typename A1, size_t N>
+class Callback<R(A0, A1), N> {
 public:
     /** Create a Callback with a static function
      *  @param func     Static function to attach
      */
     Callback(R (*func)(A0, A1) = 0) {
         if (!func) {
+            memset(&_storage, 0, sizeof(_storage));
             _ops = 0;
         } else {
             generate(func);
@@ -1491,9 +1545,11 @@ public:
     /** Attach a Callback
      *  @param func     The Callback to attach
      */
-    Callback(const Callback<R(A0, A1)> &func) {
-        if (func._ops) {
+    Callback(const Callback &func) {
+        if (func._ops && func._ops->move) {
             func._ops->move(this, &func);
+        } else {
+            memcpy(&_storage, &func._storage, sizeof(_storage));
         }
         _ops = func._ops;
     }
@@ -1604,48 +1660,48 @@ public:
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     Callback(F f, typename detail::enable_if<
                 detail::is_type<R (F::*)(A0, A1), &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         generate(f);
     }
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     Callback(const F f, typename detail::enable_if<
                 detail::is_type<R (F::*)(A0, A1) const, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         generate(f);
     }
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     Callback(volatile F f, typename detail::enable_if<
                 detail::is_type<R (F::*)(A0, A1) volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         generate(f);
     }
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     Callback(const volatile F f, typename detail::enable_if<
                 detail::is_type<R (F::*)(A0, A1) const volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         generate(f);
     }
@@ -1753,7 +1809,7 @@ public:
     /** Destroy a callback
      */
     ~Callback() {
-        if (_ops) {
+        if (_ops && _ops->dtor) {
             _ops->dtor(this);
         }
     }
@@ -1769,7 +1825,7 @@ public:
     /** Attach a Callback
      *  @param func     The Callback to attach
      */
-    void attach(const Callback<R(A0, A1)> &func) {
+    void attach(const Callback &func) {
         this->~Callback();
         new (this) Callback(func);
     }
@@ -1892,12 +1948,12 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     void attach(F f, typename detail::enable_if<
                 detail::is_type<R (F::*)(A0, A1), &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -1905,12 +1961,12 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     void attach(const F f, typename detail::enable_if<
                 detail::is_type<R (F::*)(A0, A1) const, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -1918,12 +1974,12 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     void attach(volatile F f, typename detail::enable_if<
                 detail::is_type<R (F::*)(A0, A1) volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -1931,12 +1987,12 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     void attach(const volatile F f, typename detail::enable_if<
                 detail::is_type<R (F::*)(A0, A1) const volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -2100,16 +2156,9 @@ public:
     }
 
 private:
-    // Stored as pointer to function and pointer to optional object
-    // Function pointer is stored as union of possible function types
-    // to garuntee proper size and alignment
-    struct _class;
-    union {
-        void (*_staticfunc)(A0, A1);
-        void (*_boundfunc)(_class*, A0, A1);
-        void (_class::*_methodfunc)(A0, A1);
-    } _func;
-    void *_obj;
+    // Function object stored in place, function pointers and member
+    // function pointers are stored in function objects as well
+    detail::callback_storage<N> _storage;
 
     // Dynamically dispatched operations
     const struct ops {
@@ -2121,13 +2170,16 @@ private:
     // Generate operations for function object
     template <typename F>
     void generate(const F &f) {
+        // Trivial function objects are copied with memcpy and not destroyed
         static const ops ops = {
             &Callback::function_call<F>,
-            &Callback::function_move<F>,
-            &Callback::function_dtor<F>,
+            detail::is_trivial<F>::value ? 0 : &Callback::function_move<F>,
+            detail::is_trivial<F>::value ? 0 : &Callback::function_dtor<F>,
         };
 
-        MBED_ASSERT(sizeof(Callback) - sizeof(_ops) >= sizeof(F));
+        MBED_ASSERT(sizeof(_storage) >= sizeof(F));
+        // Cleared so that equal function objects compare equal
+        memset(&_storage, 0, sizeof(_storage));
         new (this) F(f);
         _ops = &ops;
     }
@@ -2180,14 +2232,15 @@ private:
  *
  * @Note Synchronization level: Not protected
  */
-template <typename R, typename A0, typename A1, typename A2>
-class Callback<R(A0, A1, A2)> {
+template <typename R, typename A0, typename A1, typename A2, size_t N>
+class Callback<R(A0, A1, A2), N> {
 public:
     /** Create a Callback with a static function
      *  @param func     Static function to attach
      */
     Callback(R (*func)(A0, A1, A2) = 0) {
         if (!func) {
+            memset(&_storage, 0, sizeof(_storage));
             _ops = 0;
         } else {
             generate(func);
@@ -2197,9 +2250,11 @@ public:
     /** Attach a Callback
      *  @param func     The Callback to attach
      */
-    Callback(const Callback<R(A0, A1, A2)> &func) {
-        if (func._ops) {
+    Callback(const Callback &func) {
+        if (func._ops && func._ops->move) {
             func._ops->move(this, &func);
+        } else {
+            memcpy(&_storage, &func._storage, sizeof(_storage));
         }
         _ops = func._ops;
     }
@@ -2310,48 +2365,48 @@ public:
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     Callback(F f, typename detail::enable_if<
                 detail::is_type<R (F::*)(A0, A1, A2), &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         generate(f);
     }
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     Callback(const F f, typename detail::enable_if<
                 detail::is_type<R (F::*)(A0, A1, A2) const, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         generate(f);
     }
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     Callback(volatile F f, typename detail::enable_if<
                 detail::is_type<R (F::*)(A0, A1, A2) volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         generate(f);
     }
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     Callback(const volatile F f, typename detail::enable_if<
                 detail::is_type<R (F::*)(A0, A1, A2) const volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         generate(f);
     }
@@ -2459,7 +2514,7 @@ public:
     /** Destroy a callback
      */
     ~Callback() {
-        if (_ops) {
+        if (_ops && _ops->dtor) {
             _ops->dtor(this);
         }
     }
@@ -2475,7 +2530,7 @@ public:
     /** Attach a Callback
      *  @param func     The Callback to attach
      */
-    void attach(const Callback<R(A0, A1, A2)> &func) {
+    void attach(const Callback &func) {
         this->~Callback();
         new (this) Callback(func);
     }
@@ -2598,12 +2653,12 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     void attach(F f, typename detail::enable_if<
                 detail::is_type<R (F::*)(A0, A1, A2), &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -2611,12 +2666,12 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     void attach(const F f, typename detail::enable_if<
                 detail::is_type<R (F::*)(A0, A1, A2) const, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -2624,12 +2679,12 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     void attach(volatile F f, typename detail::enable_if<
                 detail::is_type<R (F::*)(A0, A1, A2) volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -2637,12 +2692,12 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     void attach(const volatile F f, typename detail::enable_if<
                 detail::is_type<R (F::*)(A0, A1, A2) const volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -2806,16 +2861,9 @@ public:
     }
 
 private:
-    // Stored as pointer to function and pointer to optional object
-    // Function pointer is stored as union of possible function types
-    // to garuntee proper size and alignment
-    struct _class;
-    union {
-        void (*_staticfunc)(A0, A1, A2);
-        void (*_boundfunc)(_class*, A0, A1, A2);
-        void (_class::*_methodfunc)(A0, A1, A2);
-    } _func;
-    void *_obj;
+    // Function object stored in place, function pointers and member
+    // function pointers are stored in function objects as well
+    detail::callback_storage<N> _storage;
 
     // Dynamically dispatched operations
     const struct ops {
@@ -2827,13 +2875,16 @@ private:
     // Generate operations for function object
     template <typename F>
     void generate(const F &f) {
+        // Trivial function objects are copied with memcpy and not destroyed
         static const ops ops = {
             &Callback::function_call<F>,
-            &Callback::function_move<F>,
-            &Callback::function_dtor<F>,
+            detail::is_trivial<F>::value ? 0 : &Callback::function_move<F>,
+            detail::is_trivial<F>::value ? 0 : &Callback::function_dtor<F>,
         };
 
-        MBED_ASSERT(sizeof(Callback) - sizeof(_ops) >= sizeof(F));
+        MBED_ASSERT(sizeof(_storage) >= sizeof(F));
+        // Cleared so that equal function objects compare equal
+        memset(&_storage, 0, sizeof(_storage));
         new (this) F(f);
         _ops = &ops;
     }
@@ -2886,14 +2937,15 @@ private:
  *
  * @Note Synchronization level: Not protected
  */
-template <typename R, typename A0, typename A1, typename A2, typename A3>
-class Callback<R(A0, A1, A2, A3)> {
+template <typename R, typename A0, typename A1, typename A2, typename A3, size_t N>
+class Callback<R(A0, A1, A2, A3), N> {
 public:
     /** Create a Callback with a static function
      *  @param func     Static function to attach
      */
     Callback(R (*func)(A0, A1, A2, A3) = 0) {
         if (!func) {
+            memset(&_storage, 0, sizeof(_storage));
             _ops = 0;
         } else {
             generate(func);
@@ -2903,9 +2955,11 @@ public:
     /** Attach a Callback
      *  @param func     The Callback to attach
      */
-    Callback(const Callback<R(A0, A1, A2, A3)> &func) {
-        if (func._ops) {
+    Callback(const Callback &func) {
+        if (func._ops && func._ops->move) {
             func._ops->move(this, &func);
+        } else {
+            memcpy(&_storage, &func._storage, sizeof(_storage));
         }
         _ops = func._ops;
     }
@@ -3016,48 +3070,48 @@ public:
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     Callback(F f, typename detail::enable_if<
                 detail::is_type<R (F::*)(A0, A1, A2, A3), &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         generate(f);
     }
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     Callback(const F f, typename detail::enable_if<
                 detail::is_type<R (F::*)(A0, A1, A2, A3) const, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         generate(f);
     }
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     Callback(volatile F f, typename detail::enable_if<
                 detail::is_type<R (F::*)(A0, A1, A2, A3) volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         generate(f);
     }
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     Callback(const volatile F f, typename detail::enable_if<
                 detail::is_type<R (F::*)(A0, A1, A2, A3) const volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         generate(f);
     }
@@ -3165,7 +3219,7 @@ public:
     /** Destroy a callback
      */
     ~Callback() {
-        if (_ops) {
+        if (_ops && _ops->dtor) {
             _ops->dtor(this);
         }
     }
@@ -3181,7 +3235,7 @@ public:
     /** Attach a Callback
      *  @param func     The Callback to attach
      */
-    void attach(const Callback<R(A0, A1, A2, A3)> &func) {
+    void attach(const Callback &func) {
         this->~Callback();
         new (this) Callback(func);
     }
@@ -3304,12 +3358,12 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     void attach(F f, typename detail::enable_if<
                 detail::is_type<R (F::*)(A0, A1, A2, A3), &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -3317,12 +3371,12 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     void attach(const F f, typename detail::enable_if<
                 detail::is_type<R (F::*)(A0, A1, A2, A3) const, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -3330,12 +3384,12 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     void attach(volatile F f, typename detail::enable_if<
                 detail::is_type<R (F::*)(A0, A1, A2, A3) volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -3343,12 +3397,12 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     void attach(const volatile F f, typename detail::enable_if<
                 detail::is_type<R (F::*)(A0, A1, A2, A3) const volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -3512,16 +3566,9 @@ public:
     }
 
 private:
-    // Stored as pointer to function and pointer to optional object
-    // Function pointer is stored as union of possible function types
-    // to garuntee proper size and alignment
-    struct _class;
-    union {
-        void (*_staticfunc)(A0, A1, A2, A3);
-        void (*_boundfunc)(_class*, A0, A1, A2, A3);
-        void (_class::*_methodfunc)(A0, A1, A2, A3);
-    } _func;
-    void *_obj;
+    // Function object stored in place, function pointers and member
+    // function pointers are stored in function objects as well
+    detail::callback_storage<N> _storage;
 
     // Dynamically dispatched operations
     const struct ops {
@@ -3533,13 +3580,16 @@ private:
     // Generate operations for function object
     template <typename F>
     void generate(const F &f) {
+        // Trivial function objects are copied with memcpy and not destroyed
         static const ops ops = {
             &Callback::function_call<F>,
-            &Callback::function_move<F>,
-            &Callback::function_dtor<F>,
+            detail::is_trivial<F>::value ? 0 : &Callback::function_move<F>,
+            detail::is_trivial<F>::value ? 0 : &Callback::function_dtor<F>,
         };
 
-        MBED_ASSERT(sizeof(Callback) - sizeof(_ops) >= sizeof(F));
+        MBED_ASSERT(sizeof(_storage) >= sizeof(F));
+        // Cleared so that equal function objects compare equal
+        memset(&_storage, 0, sizeof(_storage));
         new (this) F(f);
         _ops = &ops;
     }
@@ -3592,14 +3642,15 @@ private:
  *
  * @Note Synchronization level: Not protected
  */
-template <typename R, typename A0, typename A1, typename A2, typename A3, typename A4>
-class Callback<R(A0, A1, A2, A3, A4)> {
+template <typename R, typename A0, typename A1, typename A2, typename A3, typename A4, size_t N>
+class Callback<R(A0, A1, A2, A3, A4), N> {
 public:
     /** Create a Callback with a static function
      *  @param func     Static function to attach
      */
     Callback(R (*func)(A0, A1, A2, A3, A4) = 0) {
         if (!func) {
+            memset(&_storage, 0, sizeof(_storage));
             _ops = 0;
         } else {
             generate(func);
@@ -3609,9 +3660,11 @@ public:
     /** Attach a Callback
      *  @param func     The Callback to attach
      */
-    Callback(const Callback<R(A0, A1, A2, A3, A4)> &func) {
-        if (func._ops) {
+    Callback(const Callback &func) {
+        if (func._ops && func._ops->move) {
             func._ops->move(this, &func);
+        } else {
+            memcpy(&_storage, &func._storage, sizeof(_storage));
         }
         _ops = func._ops;
     }
@@ -3722,48 +3775,48 @@ public:
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     Callback(F f, typename detail::enable_if<
                 detail::is_type<R (F::*)(A0, A1, A2, A3, A4), &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         generate(f);
     }
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     Callback(const F f, typename detail::enable_if<
                 detail::is_type<R (F::*)(A0, A1, A2, A3, A4) const, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         generate(f);
     }
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     Callback(volatile F f, typename detail::enable_if<
                 detail::is_type<R (F::*)(A0, A1, A2, A3, A4) volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         generate(f);
     }
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     Callback(const volatile F f, typename detail::enable_if<
                 detail::is_type<R (F::*)(A0, A1, A2, A3, A4) const volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         generate(f);
     }
@@ -3871,7 +3924,7 @@ public:
     /** Destroy a callback
      */
     ~Callback() {
-        if (_ops) {
+        if (_ops && _ops->dtor) {
             _ops->dtor(this);
         }
     }
@@ -3887,7 +3940,7 @@ public:
     /** Attach a Callback
      *  @param func     The Callback to attach
      */
-    void attach(const Callback<R(A0, A1, A2, A3, A4)> &func) {
+    void attach(const Callback &func) {
         this->~Callback();
         new (this) Callback(func);
     }
@@ -4010,12 +4063,12 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     void attach(F f, typename detail::enable_if<
                 detail::is_type<R (F::*)(A0, A1, A2, A3, A4), &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -4023,12 +4076,12 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     void attach(const F f, typename detail::enable_if<
                 detail::is_type<R (F::*)(A0, A1, A2, A3, A4) const, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -4036,12 +4089,12 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     void attach(volatile F f, typename detail::enable_if<
                 detail::is_type<R (F::*)(A0, A1, A2, A3, A4) volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -4049,12 +4102,12 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to N bytes of storage
      */
     template <typename F>
     void attach(const volatile F f, typename detail::enable_if<
                 detail::is_type<R (F::*)(A0, A1, A2, A3, A4) const volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::callback_fits<F, N>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -4218,16 +4271,9 @@ public:
     }
 
 private:
-    // Stored as pointer to function and pointer to optional object
-    // Function pointer is stored as union of possible function types
-    // to garuntee proper size and alignment
-    struct _class;
-    union {
-        void (*_staticfunc)(A0, A1, A2, A3, A4);
-        void (*_boundfunc)(_class*, A0, A1, A2, A3, A4);
-        void (_class::*_methodfunc)(A0, A1, A2, A3, A4);
-    } _func;
-    void *_obj;
+    // Function object stored in place, function pointers and member
+    // function pointers are stored in function objects as well
+    detail::callback_storage<N> _storage;
 
     // Dynamically dispatched operations
     const struct ops {
@@ -4239,13 +4285,16 @@ private:
     // Generate operations for function object
     template <typename F>
     void generate(const F &f) {
+        // Trivial function objects are copied with memcpy and not destroyed
         static const ops ops = {
             &Callback::function_call<F>,
-            &Callback::function_move<F>,
-            &Callback::function_dtor<F>,
+            detail::is_trivial<F>::value ? 0 : &Callback::function_move<F>,
+            detail::is_trivial<F>::value ? 0 : &Callback::function_dtor<F>,
         };
 
-        MBED_ASSERT(sizeof(Callback) - sizeof(_ops) >= sizeof(F));
+        MBED_ASSERT(sizeof(_storage) >= sizeof(F));
+        // Cleared so that equal function objects compare equal
+        memset(&_storage, 0, sizeof(_storage));
         new (this) F(f);
         _ops = &ops;
     }
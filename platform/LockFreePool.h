@@ -0,0 +1,165 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef MBED_LOCKFREEPOOL_H
+#define MBED_LOCKFREEPOOL_H
+
+#include <stdint.h>
+#include "platform/critical.h"
+
+namespace mbed {
+/** \addtogroup platform */
+/** @{*/
+
+/** Words of storage needed by a LockFreePool of count objects of type T
+ *
+ *  @code
+ *  MBED_ALIGN(4) uint32_t storage[LockFreePoolStorage<message_t, 16>::words];
+ *  LockFreePool pool(storage, sizeof(message_t), 16);
+ *  @endcode
+ */
+template<typename T, uint32_t count>
+struct LockFreePoolStorage {
+    enum { words = ((sizeof(T) + 3) / 4) * count };
+};
+
+/** Fixed-size block allocator over caller-provided storage
+ *
+ *  Free blocks form a singly linked list threaded through the blocks
+ *  themselves. The list head is a single word holding the index of the
+ *  first free block and a tag that changes on every update, so it is
+ *  swapped with one compare-and-swap and a block freed and reallocated
+ *  between another context's read and swap can't corrupt the list (the
+ *  ABA problem). On cores with exclusive access instructions no interrupts
+ *  are ever disabled; elsewhere core_util_atomic_cas_u32() briefly enters
+ *  a critical section. Needs no RTOS.
+ *
+ *  @Note Synchronization level: Interrupt safe
+ */
+class LockFreePool {
+public:
+    /** Create a pool with all blocks free
+     *
+     * @param storage    Word-aligned storage for count blocks, each block_size
+     *                   bytes rounded up to a whole number of words
+     * @param block_size Size of a block in bytes
+     * @param count      Number of blocks
+     */
+    LockFreePool(void *storage, uint32_t block_size, uint32_t count)
+        : _storage(static_cast<uint32_t *>(storage)),
+          _block_words(block_size ? (block_size + 3) / 4 : 1),
+          _count(count),
+          _index_mask(1) {
+        // The index takes as few bits as the pool needs, leaving the rest
+        // of the word to the tag so that it takes as long as possible to
+        // come round again
+        while (_index_mask < count) {
+            _index_mask = (_index_mask << 1) | 1;
+        }
+        for (uint32_t i = 0; i < count; i++) {
+            link(i) = i + 1 < count ? i + 1 : _index_mask;
+        }
+        _head = count ? 0 : _index_mask;
+    }
+
+    /** Allocate a block
+     *
+     * @return Pointer to the block, or NULL if all blocks are in use
+     */
+    void *alloc() {
+        uint32_t head = _head;
+        uint32_t index;
+        do {
+            index = head & _index_mask;
+            if (index == _index_mask) {
+                return NULL;
+            }
+            // If the block was taken meanwhile, the link may be anything but
+            // then the tag has moved on and the swap fails
+        } while (!core_util_atomic_cas_u32(&_head, &head, next_head(head, link(index))));
+        return block(index);
+    }
+
+    /** Return a block to the pool
+     *
+     * @param ptr Block previously returned by alloc()
+     * @return True if the block was freed, false if it is not from this pool
+     */
+    bool free(void *ptr) {
+        if (!contains(ptr)) {
+            return false;
+        }
+        uint32_t index = (static_cast<uint32_t *>(ptr) - _storage) / _block_words;
+        uint32_t head = _head;
+        do {
+            link(index) = head & _index_mask;
+        } while (!core_util_atomic_cas_u32(&_head, &head, next_head(head, index)));
+        return true;
+    }
+
+    /** Check if a pointer is the start of a block of this pool
+     *
+     * @param ptr Pointer to check
+     * @return True if the pointer is a block of this pool
+     */
+    bool contains(const void *ptr) const {
+        // Pointers below the storage wrap around to large offsets
+        uintptr_t offset = reinterpret_cast<uintptr_t>(ptr) - reinterpret_cast<uintptr_t>(_storage);
+        return offset < _block_words * 4 * _count && offset % (_block_words * 4) == 0;
+    }
+
+    /** Get the number of blocks in the pool
+     *
+     * @return Number of blocks, free or not
+     */
+    uint32_t count() const {
+        return _count;
+    }
+
+    /** Get the size of a block
+     *
+     * @return Usable size of a block in bytes
+     */
+    uint32_t block_size() const {
+        return _block_words * 4;
+    }
+
+private:
+    uint32_t next_head(uint32_t head, uint32_t index) const {
+        return ((head + _index_mask + 1) & ~_index_mask) | index;
+    }
+
+    volatile uint32_t &link(uint32_t index) {
+        return *reinterpret_cast<volatile uint32_t *>(block(index));
+    }
+
+    void *block(uint32_t index) {
+        return _storage + index * _block_words;
+    }
+
+    uint32_t *const _storage;
+    const uint32_t _block_words;
+    const uint32_t _count;
+    // Index bits of the head and links, all ones ends the list
+    uint32_t _index_mask;
+    // Tag in the upper bits, index of the first free block in the lower
+    uint32_t _head;
+};
+
+}
+
+#endif
+
+/** @}*/
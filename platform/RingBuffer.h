@@ -0,0 +1,289 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef MBED_RINGBUFFER_H
+#define MBED_RINGBUFFER_H
+
+#include "cmsis.h"
+#include "platform/critical.h"
+
+namespace mbed {
+/** \addtogroup platform */
+/** @{*/
+
+/** Synchronization policy for RingBuffer: every operation runs inside a
+ *  critical section, so any number of threads and interrupts may push
+ *  and pop concurrently.
+ */
+struct RingBufferInterruptSafe {
+    static void lock() {
+        core_util_critical_section_enter();
+    }
+
+    static void unlock() {
+        core_util_critical_section_exit();
+    }
+};
+
+/** Synchronization policy for RingBuffer: lock-free, for exactly one
+ *  producer and one consumer (for example a UART interrupt and a thread).
+ *  The indices are published with acquire/release ordering and interrupts
+ *  are never disabled.
+ */
+struct RingBufferSPSC {
+    static void lock() {
+    }
+
+    static void unlock() {
+    }
+};
+
+/** Templated ring buffer with bulk transfers
+ *
+ *  Unlike CircularBuffer, the capacity must be a power of two so indices
+ *  wrap with a mask, elements can be moved in bulk under a single lock,
+ *  and the free and used regions can be accessed in place for zero-copy
+ *  (e.g. DMA) transfers through write_span()/commit_write() and
+ *  read_span()/commit_read(). A full buffer rejects new data rather than
+ *  overwriting the oldest element.
+ *
+ *  @tparam T          Element type
+ *  @tparam BufferSize Capacity in elements, must be a power of two
+ *  @tparam SyncPolicy RingBufferInterruptSafe (default) or RingBufferSPSC
+ *
+ *  @Note Synchronization level: Interrupt safe with RingBufferInterruptSafe;
+ *        single producer, single consumer with RingBufferSPSC. The span
+ *        interface always assumes a single producer and a single consumer.
+ */
+template<typename T, uint32_t BufferSize, typename SyncPolicy = RingBufferInterruptSafe>
+class RingBuffer {
+    typedef char buffer_size_must_be_a_power_of_two[
+        (BufferSize != 0 && (BufferSize & (BufferSize - 1)) == 0) ? 1 : -1];
+
+public:
+    RingBuffer() : _head(0), _tail(0) {
+    }
+
+    ~RingBuffer() {
+    }
+
+    /** Push an element into the buffer
+     *
+     * @param data Element to be pushed
+     * @return True if the element was pushed, false if the buffer is full
+     */
+    bool push(const T &data) {
+        return push(&data, 1) == 1;
+    }
+
+    /** Push as many elements as fit into the buffer
+     *
+     * @param data Elements to be pushed
+     * @param size Number of elements in data
+     * @return Number of elements pushed
+     */
+    uint32_t push(const T *data, uint32_t size) {
+        SyncPolicy::lock();
+        uint32_t head = _head;
+        uint32_t space = BufferSize - (head - load_acquire(_tail));
+        if (size > space) {
+            size = space;
+        }
+        uint32_t index = head & (BufferSize - 1);
+        uint32_t first = BufferSize - index;
+        if (first > size) {
+            first = size;
+        }
+        copy(&_pool[index], data, first);
+        copy(&_pool[0], data + first, size - first);
+        store_release(_head, head + size);
+        SyncPolicy::unlock();
+        return size;
+    }
+
+    /** Pop an element from the buffer
+     *
+     * @param data Element popped from the buffer
+     * @return True if the buffer was not empty and data contains an element, false otherwise
+     */
+    bool pop(T &data) {
+        return pop(&data, 1) == 1;
+    }
+
+    /** Pop up to size elements from the buffer
+     *
+     * @param data Destination for the popped elements
+     * @param size Maximum number of elements to pop
+     * @return Number of elements popped
+     */
+    uint32_t pop(T *data, uint32_t size) {
+        SyncPolicy::lock();
+        uint32_t tail = _tail;
+        uint32_t used = load_acquire(_head) - tail;
+        if (size > used) {
+            size = used;
+        }
+        uint32_t index = tail & (BufferSize - 1);
+        uint32_t first = BufferSize - index;
+        if (first > size) {
+            first = size;
+        }
+        copy(data, &_pool[index], first);
+        copy(data + first, &_pool[0], size - first);
+        store_release(_tail, tail + size);
+        SyncPolicy::unlock();
+        return size;
+    }
+
+    /** Get the contiguous free region at the head of the buffer
+     *
+     *  The region may be filled in place and published with commit_write().
+     *  It can be shorter than the total free space when it would wrap.
+     *
+     * @param size Set to the number of elements available in the region
+     * @return Pointer to the start of the region
+     */
+    T *write_span(uint32_t &size) {
+        uint32_t head = _head;
+        uint32_t index = head & (BufferSize - 1);
+        uint32_t space = BufferSize - (head - load_acquire(_tail));
+        size = BufferSize - index;
+        if (size > space) {
+            size = space;
+        }
+        return &_pool[index];
+    }
+
+    /** Publish elements written through write_span()
+     *
+     * @param size Number of elements written, no more than the span size
+     */
+    void commit_write(uint32_t size) {
+        SyncPolicy::lock();
+        store_release(_head, _head + size);
+        SyncPolicy::unlock();
+    }
+
+    /** Get the contiguous region of data at the tail of the buffer
+     *
+     *  The region may be read in place and released with commit_read().
+     *  It can be shorter than the total data size when it would wrap.
+     *
+     * @param size Set to the number of elements available in the region
+     * @return Pointer to the start of the region
+     */
+    const T *read_span(uint32_t &size) {
+        uint32_t tail = _tail;
+        uint32_t index = tail & (BufferSize - 1);
+        uint32_t used = load_acquire(_head) - tail;
+        size = BufferSize - index;
+        if (size > used) {
+            size = used;
+        }
+        return &_pool[index];
+    }
+
+    /** Release elements read through read_span()
+     *
+     * @param size Number of elements consumed, no more than the span size
+     */
+    void commit_read(uint32_t size) {
+        SyncPolicy::lock();
+        store_release(_tail, _tail + size);
+        SyncPolicy::unlock();
+    }
+
+    /** Get the number of elements in the buffer
+     *
+     * @return Number of elements that can be popped
+     */
+    uint32_t size() const {
+        uint32_t tail = _tail;
+        return _head - tail;
+    }
+
+    /** Get the free space in the buffer
+     *
+     * @return Number of elements that can be pushed
+     */
+    uint32_t space() const {
+        return BufferSize - size();
+    }
+
+    /** Check if the buffer is empty
+     *
+     * @return True if the buffer is empty, false if not
+     */
+    bool empty() const {
+        return _head == _tail;
+    }
+
+    /** Check if the buffer is full
+     *
+     * @return True if the buffer is full, false if not
+     */
+    bool full() const {
+        return size() == BufferSize;
+    }
+
+    /** Get the capacity of the buffer
+     *
+     * @return Maximum number of elements the buffer holds
+     */
+    static uint32_t capacity() {
+        return BufferSize;
+    }
+
+    /** Reset the buffer
+     *
+     *  Must not run concurrently with a producer or consumer in
+     *  RingBufferSPSC mode.
+     */
+    void reset() {
+        SyncPolicy::lock();
+        _tail = _head;
+        SyncPolicy::unlock();
+    }
+
+private:
+    static uint32_t load_acquire(const volatile uint32_t &index) {
+        uint32_t value = index;
+        __DMB();
+        return value;
+    }
+
+    static void store_release(volatile uint32_t &index, uint32_t value) {
+        __DMB();
+        index = value;
+    }
+
+    static void copy(T *dst, const T *src, uint32_t size) {
+        for (uint32_t i = 0; i < size; i++) {
+            dst[i] = src[i];
+        }
+    }
+
+    T _pool[BufferSize];
+    // Free-running indices, written only by the producer and the consumer
+    // respectively; the difference is the number of elements stored
+    volatile uint32_t _head;
+    volatile uint32_t _tail;
+};
+
+}
+
+#endif
+
+/** @}*/
@@ -15,7 +15,10 @@
  */
 
 #include "platform/mbed_mem_trace.h"
+#include "platform/mbed_heap_profiler.h"
+#include "platform/mbed_tlsf.h"
 #include "platform/mbed_stats.h"
+#include "platform/critical.h"
 #include "platform/toolchain.h"
 #include "platform/SingletonPtr.h"
 #include "platform/PlatformMutex.h"
@@ -24,17 +27,19 @@
 #include <string.h>
 #include <stdlib.h>
 
-/* There are two memory tracers in mbed OS:
+/* There are three memory tracers in mbed OS:
 
 - the first can be used to detect the maximum heap usage at runtime. It is
   activated by defining the MBED_HEAP_STATS_ENABLED macro.
-- the second can be used to trace each memory call by automatically invoking
+- the second counts allocations per call site (see platform/mbed_heap_profiler.h).
+  It is activated by defining the MBED_HEAP_PROFILER_ENABLED macro.
+- the third can be used to trace each memory call by automatically invoking
   a callback on each memory operation (see hal/api/mbed_mem_trace.h). It is
   activated by defining the MBED_MEM_TRACING_ENABLED macro.
 
-Both tracers can be activated and deactivated in any combination. If both tracers
-are active, the second one (MBED_MEM_TRACING_ENABLED) will trace the first one's
-(MBED_HEAP_STATS_ENABLED) memory calls.*/
+The tracers can be activated and deactivated in any combination. The first two
+only update counters atomically, so they take no lock beyond the C library's
+own and are cheap enough to leave enabled.*/
 
 /******************************************************************************/
 /* Implementation of the runtime max heap usage checker                       */
@@ -43,28 +48,177 @@ are active, the second one (MBED_MEM_TRACING_ENABLED) will trace the first one's
 /* Size must be a multiple of 8 to keep alignment */
 typedef struct {
     uint32_t size;
-    uint32_t pad;
+    uint32_t site;
 } alloc_info_t;
 
+#if defined(MBED_HEAP_STATS_ENABLED) || defined(MBED_HEAP_PROFILER_ENABLED)
+#define MBED_ALLOC_INFO_ENABLED
+#endif
+
+#if MBED_CONF_PLATFORM_HEAP_TLSF && !defined(FEATURE_UVISOR) && (defined(TOOLCHAIN_GCC) || defined(TOOLCHAIN_ARM))
+#define MBED_TLSF_HEAP_ENABLED
+#endif
+
 #ifdef MBED_MEM_TRACING_ENABLED
 static SingletonPtr<PlatformMutex> mem_trace_mutex;
 #endif
 #ifdef MBED_HEAP_STATS_ENABLED
-static SingletonPtr<PlatformMutex> malloc_stats_mutex;
 static mbed_stats_heap_t heap_stats = {0, 0, 0, 0, 0};
 #endif
 
 void mbed_stats_heap_get(mbed_stats_heap_t *stats)
 {
 #ifdef MBED_HEAP_STATS_ENABLED
-    malloc_stats_mutex->lock();
+    // Each field is consistent on its own, but they may be read between
+    // the updates of one allocation
     memcpy(stats, &heap_stats, sizeof(mbed_stats_heap_t));
-    malloc_stats_mutex->unlock();
 #else
     memset(stats, 0, sizeof(mbed_stats_heap_t));
 #endif
 }
 
+#ifdef MBED_ALLOC_INFO_ENABLED
+/* Account a block just allocated with room for its info, NULL if the allocation failed */
+static void *alloc_info_attach(alloc_info_t *alloc_info, size_t size, void *caller)
+{
+    if (alloc_info == NULL) {
+#ifdef MBED_HEAP_STATS_ENABLED
+        core_util_atomic_incr_u32(&heap_stats.alloc_fail_cnt, 1);
+#endif
+        return NULL;
+    }
+    alloc_info->size = size;
+    alloc_info->site = 0;
+#ifdef MBED_HEAP_STATS_ENABLED
+    uint32_t current_size = core_util_atomic_incr_u32(&heap_stats.current_size, size);
+    core_util_atomic_incr_u32(&heap_stats.total_size, size);
+    core_util_atomic_incr_u32(&heap_stats.alloc_cnt, 1);
+    uint32_t max_size = heap_stats.max_size;
+    while (current_size > max_size &&
+           !core_util_atomic_cas_u32(&heap_stats.max_size, &max_size, current_size));
+#endif
+#ifdef MBED_HEAP_PROFILER_ENABLED
+    alloc_info->site = mbed_heap_profiler_alloc(size, caller);
+#endif
+    return (void*)(alloc_info + 1);
+}
+
+/* Account a block about to be freed, returns the pointer to free */
+static alloc_info_t *alloc_info_detach(void *ptr)
+{
+    if (ptr == NULL) {
+        return NULL;
+    }
+    alloc_info_t *alloc_info = ((alloc_info_t*)ptr) - 1;
+#ifdef MBED_HEAP_STATS_ENABLED
+    core_util_atomic_decr_u32(&heap_stats.current_size, alloc_info->size);
+    core_util_atomic_decr_u32(&heap_stats.alloc_cnt, 1);
+#endif
+#ifdef MBED_HEAP_PROFILER_ENABLED
+    mbed_heap_profiler_free(alloc_info->site, alloc_info->size);
+#endif
+    return alloc_info;
+}
+#endif // #ifdef MBED_ALLOC_INFO_ENABLED
+
+/******************************************************************************/
+/* Implementation of the TLSF heap                                            */
+/******************************************************************************/
+
+#ifdef MBED_TLSF_HEAP_ENABLED
+
+/* Smallest piece of the C library heap worth a region */
+#define TLSF_HEAP_MIN_REGION    256
+
+static SingletonPtr<PlatformMutex> tlsf_heap_mutex;
+// Zero initialized, as mbed_tlsf_init() leaves it
+static mbed_tlsf_t tlsf_heap;
+static bool tlsf_heap_ready = false;
+
+/* Take memory from the C library heap, defined with the wrappers below */
+static void *tlsf_heap_grab(size_t size);
+
+static void tlsf_heap_lock()
+{
+    tlsf_heap_mutex->lock();
+    if (!tlsf_heap_ready) {
+        // Take all of the C library heap, halving the requests until even
+        // small ones fail, so it ends up in a few large regions
+        tlsf_heap_ready = true;
+        for (size_t size = (size_t)1 << MBED_TLSF_FL_MAX; size >= TLSF_HEAP_MIN_REGION; size /= 2) {
+            void *region;
+            while ((region = tlsf_heap_grab(size)) != NULL) {
+                mbed_tlsf_add_region(&tlsf_heap, region, size);
+            }
+        }
+    }
+}
+
+static void tlsf_heap_unlock()
+{
+    tlsf_heap_mutex->unlock();
+}
+
+static void *tlsf_heap_malloc(size_t size)
+{
+    tlsf_heap_lock();
+    void *ptr = mbed_tlsf_malloc(&tlsf_heap, size);
+    tlsf_heap_unlock();
+    return ptr;
+}
+
+static void *tlsf_heap_realloc(void *ptr, size_t size)
+{
+    tlsf_heap_lock();
+    void *new_ptr = mbed_tlsf_realloc(&tlsf_heap, ptr, size);
+    tlsf_heap_unlock();
+    return new_ptr;
+}
+
+static void *tlsf_heap_calloc(size_t nmemb, size_t size)
+{
+    if (size != 0 && nmemb > (size_t)-1 / size) {
+        return NULL;
+    }
+    void *ptr = tlsf_heap_malloc(nmemb * size);
+    if (ptr != NULL) {
+        memset(ptr, 0, nmemb * size);
+    }
+    return ptr;
+}
+
+static void tlsf_heap_free(void *ptr)
+{
+    tlsf_heap_lock();
+    mbed_tlsf_free(&tlsf_heap, ptr);
+    tlsf_heap_unlock();
+}
+
+#endif // #ifdef MBED_TLSF_HEAP_ENABLED
+
+bool mbed_tlsf_heap_add_region(void *start, size_t size)
+{
+#ifdef MBED_TLSF_HEAP_ENABLED
+    tlsf_heap_lock();
+    bool added = mbed_tlsf_add_region(&tlsf_heap, start, size);
+    tlsf_heap_unlock();
+    return added;
+#else
+    return false;
+#endif
+}
+
+void mbed_tlsf_heap_get_info(mbed_tlsf_info_t *info)
+{
+#ifdef MBED_TLSF_HEAP_ENABLED
+    tlsf_heap_lock();
+    mbed_tlsf_get_info(&tlsf_heap, info);
+    tlsf_heap_unlock();
+#else
+    memset(info, 0, sizeof(mbed_tlsf_info_t));
+#endif
+}
+
 /******************************************************************************/
 /* GCC memory allocation wrappers                                             */
 /******************************************************************************/
@@ -82,30 +236,32 @@ extern "C" {
     void* __real__calloc_r(struct _reent * r, size_t nmemb, size_t size);
 }
 
+#ifdef MBED_TLSF_HEAP_ENABLED
+static void *tlsf_heap_grab(size_t size) {
+    return __real__malloc_r(_REENT, size);
+}
+
+#define heap_malloc(r, size)            tlsf_heap_malloc(size)
+#define heap_realloc(r, ptr, size)      tlsf_heap_realloc(ptr, size)
+#define heap_calloc(r, nmemb, size)     tlsf_heap_calloc(nmemb, size)
+#define heap_free(r, ptr)               tlsf_heap_free(ptr)
+#else // #ifdef MBED_TLSF_HEAP_ENABLED
+#define heap_malloc(r, size)            __real__malloc_r(r, size)
+#define heap_realloc(r, ptr, size)      __real__realloc_r(r, ptr, size)
+#define heap_calloc(r, nmemb, size)     __real__calloc_r(r, nmemb, size)
+#define heap_free(r, ptr)               __real__free_r(r, ptr)
+#endif // #ifdef MBED_TLSF_HEAP_ENABLED
+
 // TODO: memory tracing doesn't work with uVisor enabled.
 #if !defined(FEATURE_UVISOR)
 
 extern "C" void * __wrap__malloc_r(struct _reent * r, size_t size) {
     void *ptr = NULL;
-#ifdef MBED_HEAP_STATS_ENABLED
-    malloc_stats_mutex->lock();
-    alloc_info_t *alloc_info = (alloc_info_t*)__real__malloc_r(r, size + sizeof(alloc_info_t));
-    if (alloc_info != NULL) {
-        alloc_info->size = size;
-        ptr = (void*)(alloc_info + 1);
-        heap_stats.current_size += size;
-        heap_stats.total_size += size;
-        heap_stats.alloc_cnt += 1;
-        if (heap_stats.current_size > heap_stats.max_size) {
-            heap_stats.max_size = heap_stats.current_size;
-        }
-    } else {
-        heap_stats.alloc_fail_cnt += 1;
-    }
-    malloc_stats_mutex->unlock();
-#else // #ifdef MBED_HEAP_STATS_ENABLED
-    ptr = __real__malloc_r(r, size);
-#endif // #ifdef MBED_HEAP_STATS_ENABLED
+#ifdef MBED_ALLOC_INFO_ENABLED
+    ptr = alloc_info_attach((alloc_info_t*)heap_malloc(r, size + sizeof(alloc_info_t)), size, MBED_CALLER_ADDR());
+#else // #ifdef MBED_ALLOC_INFO_ENABLED
+    ptr = heap_malloc(r, size);
+#endif // #ifdef MBED_ALLOC_INFO_ENABLED
 #ifdef MBED_MEM_TRACING_ENABLED
     mem_trace_mutex->lock();
     mbed_mem_trace_malloc(ptr, size, MBED_CALLER_ADDR());
@@ -116,14 +272,12 @@ extern "C" void * __wrap__malloc_r(struct _reent * r, size_t size) {
 
 extern "C" void * __wrap__realloc_r(struct _reent * r, void * ptr, size_t size) {
     void *new_ptr = NULL;
-#ifdef MBED_HEAP_STATS_ENABLED
+#ifdef MBED_ALLOC_INFO_ENABLED
     // Implement realloc_r with malloc and free.
     // The function realloc_r can't be used here directly since
-    // it can call into __wrap__malloc_r (returns ptr + 4) or
+    // it can call into __wrap__malloc_r (returns ptr + 8) or
     // resize memory directly (returns ptr + 0).
 
-    // Note - no lock needed since malloc and free are thread safe
-
     // Get old size
     uint32_t old_size = 0;
     if (ptr != NULL) {
@@ -131,9 +285,9 @@ extern "C" void * __wrap__realloc_r(struct _reent * r, void * ptr, size_t size)
         old_size = alloc_info->size;
     }
 
-    // Allocate space
+    // Allocate space, accounted to the caller of realloc
     if (size != 0) {
-        new_ptr = malloc(size);
+        new_ptr = alloc_info_attach((alloc_info_t*)heap_malloc(r, size + sizeof(alloc_info_t)), size, MBED_CALLER_ADDR());
     }
 
     // If the new buffer has been allocated copy the data to it
@@ -141,11 +295,11 @@ extern "C" void * __wrap__realloc_r(struct _reent * r, void * ptr, size_t size)
     if (new_ptr != NULL) {
         uint32_t copy_size = (old_size < size) ? old_size : size;
         memcpy(new_ptr, (void*)ptr, copy_size);
-        free(ptr);
+        heap_free(r, (void*)alloc_info_detach(ptr));
     }
-#else // #ifdef MBED_HEAP_STATS_ENABLED
-    new_ptr = __real__realloc_r(r, ptr, size);
-#endif // #ifdef MBED_HEAP_STATS_ENABLED
+#else // #ifdef MBED_ALLOC_INFO_ENABLED
+    new_ptr = heap_realloc(r, ptr, size);
+#endif // #ifdef MBED_ALLOC_INFO_ENABLED
 #ifdef MBED_MEM_TRACING_ENABLED
     mem_trace_mutex->lock();
     mbed_mem_trace_realloc(new_ptr, ptr, size, MBED_CALLER_ADDR());
@@ -155,19 +309,11 @@ extern "C" void * __wrap__realloc_r(struct _reent * r, void * ptr, size_t size)
 }
 
 extern "C" void __wrap__free_r(struct _reent * r, void * ptr) {
-#ifdef MBED_HEAP_STATS_ENABLED
-    malloc_stats_mutex->lock();
-    alloc_info_t *alloc_info = NULL;
-    if (ptr != NULL) {
-        alloc_info = ((alloc_info_t*)ptr) - 1;
-        heap_stats.current_size -= alloc_info->size;
-        heap_stats.alloc_cnt -= 1;
-    }
-    __real__free_r(r, (void*)alloc_info);
-    malloc_stats_mutex->unlock();
-#else // #ifdef MBED_HEAP_STATS_ENABLED
-    __real__free_r(r, ptr);
-#endif // #ifdef MBED_HEAP_STATS_ENABLED
+#ifdef MBED_ALLOC_INFO_ENABLED
+    heap_free(r, (void*)alloc_info_detach(ptr));
+#else // #ifdef MBED_ALLOC_INFO_ENABLED
+    heap_free(r, ptr);
+#endif // #ifdef MBED_ALLOC_INFO_ENABLED
 #ifdef MBED_MEM_TRACING_ENABLED
     mem_trace_mutex->lock();
     mbed_mem_trace_free(ptr, MBED_CALLER_ADDR());
@@ -179,16 +325,19 @@ extern "C" void __wrap__free_r(struct _reent * r, void * ptr) {
 
 extern "C" void * __wrap__calloc_r(struct _reent * r, size_t nmemb, size_t size) {
     void *ptr = NULL;
-#ifdef MBED_HEAP_STATS_ENABLED
-    // Note - no lock needed since malloc is thread safe
-
-    ptr = malloc(nmemb * size);
+    // Every path below multiplies nmemb by size, so refuse an overflowing
+    // request before any of them runs
+    if (size != 0 && nmemb > (size_t)-1 / size) {
+        return NULL;
+    }
+#ifdef MBED_ALLOC_INFO_ENABLED
+    ptr = alloc_info_attach((alloc_info_t*)heap_malloc(r, nmemb * size + sizeof(alloc_info_t)), nmemb * size, MBED_CALLER_ADDR());
     if (ptr != NULL) {
         memset(ptr, 0, nmemb * size);
     }
-#else // #ifdef MBED_HEAP_STATS_ENABLED
-    ptr = __real__calloc_r(r, nmemb, size);
-#endif // #ifdef MBED_HEAP_STATS_ENABLED
+#else // #ifdef MBED_ALLOC_INFO_ENABLED
+    ptr = heap_calloc(r, nmemb, size);
+#endif // #ifdef MBED_ALLOC_INFO_ENABLED
 #ifdef MBED_MEM_TRACING_ENABLED
     mem_trace_mutex->lock();
     mbed_mem_trace_calloc(ptr, nmemb, size, MBED_CALLER_ADDR());
@@ -204,8 +353,8 @@ extern "C" void * __wrap__calloc_r(struct _reent * r, size_t nmemb, size_t size)
 
 #elif defined(TOOLCHAIN_ARM) // #if defined(TOOLCHAIN_GCC)
 
-/* Enable hooking of memory function only if tracing is also enabled */
-#if defined(MBED_MEM_TRACING_ENABLED) || defined(MBED_HEAP_STATS_ENABLED)
+/* Enable hooking of memory function only if tracing or the TLSF heap is also enabled */
+#if defined(MBED_MEM_TRACING_ENABLED) || defined(MBED_ALLOC_INFO_ENABLED) || defined(MBED_TLSF_HEAP_ENABLED)
 
 extern "C" {
     void *$Super$$malloc(size_t size);
@@ -214,27 +363,29 @@ extern "C" {
     void $Super$$free(void *ptr);
 }
 
+#ifdef MBED_TLSF_HEAP_ENABLED
+static void *tlsf_heap_grab(size_t size) {
+    return $Super$$malloc(size);
+}
+
+#define heap_malloc(size)               tlsf_heap_malloc(size)
+#define heap_realloc(ptr, size)         tlsf_heap_realloc(ptr, size)
+#define heap_calloc(nmemb, size)        tlsf_heap_calloc(nmemb, size)
+#define heap_free(ptr)                  tlsf_heap_free(ptr)
+#else // #ifdef MBED_TLSF_HEAP_ENABLED
+#define heap_malloc(size)               $Super$$malloc(size)
+#define heap_realloc(ptr, size)         $Super$$realloc(ptr, size)
+#define heap_calloc(nmemb, size)        $Super$$calloc(nmemb, size)
+#define heap_free(ptr)                  $Super$$free(ptr)
+#endif // #ifdef MBED_TLSF_HEAP_ENABLED
+
 extern "C" void* $Sub$$malloc(size_t size) {
     void *ptr = NULL;
-#ifdef MBED_HEAP_STATS_ENABLED
-    malloc_stats_mutex->lock();
-    alloc_info_t *alloc_info = (alloc_info_t*)$Super$$malloc(size + sizeof(alloc_info_t));
-    if (alloc_info != NULL) {
-        alloc_info->size = size;
-        ptr = (void*)(alloc_info + 1);
-        heap_stats.current_size += size;
-        heap_stats.total_size += size;
-        heap_stats.alloc_cnt += 1;
-        if (heap_stats.current_size > heap_stats.max_size) {
-            heap_stats.max_size = heap_stats.current_size;
-        }
-    } else {
-        heap_stats.alloc_fail_cnt += 1;
-    }
-    malloc_stats_mutex->unlock();
-#else // #ifdef MBED_HEAP_STATS_ENABLED
-    ptr = $Super$$malloc(size);
-#endif // #ifdef MBED_HEAP_STATS_ENABLED
+#ifdef MBED_ALLOC_INFO_ENABLED
+    ptr = alloc_info_attach((alloc_info_t*)heap_malloc(size + sizeof(alloc_info_t)), size, MBED_CALLER_ADDR());
+#else // #ifdef MBED_ALLOC_INFO_ENABLED
+    ptr = heap_malloc(size);
+#endif // #ifdef MBED_ALLOC_INFO_ENABLED
 #ifdef MBED_MEM_TRACING_ENABLED
     mem_trace_mutex->lock();
     mbed_mem_trace_malloc(ptr, size, MBED_CALLER_ADDR());
@@ -245,9 +396,7 @@ extern "C" void* $Sub$$malloc(size_t size) {
 
 extern "C" void* $Sub$$realloc(void *ptr, size_t size) {
     void *new_ptr = NULL;
-#ifdef MBED_HEAP_STATS_ENABLED
-    // Note - no lock needed since malloc and free are thread safe
-
+#ifdef MBED_ALLOC_INFO_ENABLED
     // Get old size
     uint32_t old_size = 0;
     if (ptr != NULL) {
@@ -255,9 +404,9 @@ extern "C" void* $Sub$$realloc(void *ptr, size_t size) {
         old_size = alloc_info->size;
     }
 
-    // Allocate space
+    // Allocate space, accounted to the caller of realloc
     if (size != 0) {
-        new_ptr = malloc(size);
+        new_ptr = alloc_info_attach((alloc_info_t*)heap_malloc(size + sizeof(alloc_info_t)), size, MBED_CALLER_ADDR());
     }
 
     // If the new buffer has been allocated copy the data to it
@@ -265,11 +414,11 @@ extern "C" void* $Sub$$realloc(void *ptr, size_t size) {
     if (new_ptr != NULL) {
         uint32_t copy_size = (old_size < size) ? old_size : size;
         memcpy(new_ptr, (void*)ptr, copy_size);
-        free(ptr);
+        heap_free((void*)alloc_info_detach(ptr));
     }
-#else // #ifdef MBED_HEAP_STATS_ENABLED
-    new_ptr = $Super$$realloc(ptr, size);
-#endif // #ifdef MBED_HEAP_STATS_ENABLED
+#else // #ifdef MBED_ALLOC_INFO_ENABLED
+    new_ptr = heap_realloc(ptr, size);
+#endif // #ifdef MBED_ALLOC_INFO_ENABLED
 #ifdef MBED_MEM_TRACING_ENABLED
     mem_trace_mutex->lock();
     mbed_mem_trace_realloc(new_ptr, ptr, size, MBED_CALLER_ADDR());
@@ -280,15 +429,19 @@ extern "C" void* $Sub$$realloc(void *ptr, size_t size) {
 
 extern "C" void *$Sub$$calloc(size_t nmemb, size_t size) {
     void *ptr = NULL;
-#ifdef MBED_HEAP_STATS_ENABLED
-    // Note - no lock needed since malloc is thread safe
-    ptr = malloc(nmemb * size);
+    // Every path below multiplies nmemb by size, so refuse an overflowing
+    // request before any of them runs
+    if (size != 0 && nmemb > (size_t)-1 / size) {
+        return NULL;
+    }
+#ifdef MBED_ALLOC_INFO_ENABLED
+    ptr = alloc_info_attach((alloc_info_t*)heap_malloc(nmemb * size + sizeof(alloc_info_t)), nmemb * size, MBED_CALLER_ADDR());
     if (ptr != NULL) {
         memset(ptr, 0, nmemb * size);
     }
-#else // #ifdef MBED_HEAP_STATS_ENABLED
-    ptr = $Super$$calloc(nmemb, size);
-#endif // #ifdef MBED_HEAP_STATS_ENABLED
+#else // #ifdef MBED_ALLOC_INFO_ENABLED
+    ptr = heap_calloc(nmemb, size);
+#endif // #ifdef MBED_ALLOC_INFO_ENABLED
 #ifdef MBED_MEM_TRACING_ENABLED
     mem_trace_mutex->lock();
     mbed_mem_trace_calloc(ptr, nmemb, size, MBED_CALLER_ADDR());
@@ -298,19 +451,11 @@ extern "C" void *$Sub$$calloc(size_t nmemb, size_t size) {
 }
 
 extern "C" void $Sub$$free(void *ptr) {
-#ifdef MBED_HEAP_STATS_ENABLED
-    malloc_stats_mutex->lock();
-    alloc_info_t *alloc_info = NULL;
-    if (ptr != NULL) {
-        alloc_info = ((alloc_info_t*)ptr) - 1;
-        heap_stats.current_size -= alloc_info->size;
-        heap_stats.alloc_cnt -= 1;
-    }
-    $Super$$free((void*)alloc_info);
-    malloc_stats_mutex->unlock();
-#else // #ifdef MBED_HEAP_STATS_ENABLED
-    $Super$$free(ptr);
-#endif // #ifdef MBED_HEAP_STATS_ENABLED
+#ifdef MBED_ALLOC_INFO_ENABLED
+    heap_free((void*)alloc_info_detach(ptr));
+#else // #ifdef MBED_ALLOC_INFO_ENABLED
+    heap_free(ptr);
+#endif // #ifdef MBED_ALLOC_INFO_ENABLED
 #ifdef MBED_MEM_TRACING_ENABLED
     mem_trace_mutex->lock();
     mbed_mem_trace_free(ptr, MBED_CALLER_ADDR());
@@ -318,7 +463,7 @@ extern "C" void $Sub$$free(void *ptr) {
 #endif // #ifdef MBED_MEM_TRACING_ENABLED
 }
 
-#endif // #if defined(MBED_MEM_TRACING_ENABLED) || defined(MBED_HEAP_STATS_ENABLED)
+#endif // #if defined(MBED_MEM_TRACING_ENABLED) || defined(MBED_ALLOC_INFO_ENABLED) || defined(MBED_TLSF_HEAP_ENABLED)
 
 /******************************************************************************/
 /* Allocation wrappers for other toolchains are not supported yet             */
@@ -334,5 +479,13 @@ extern "C" void $Sub$$free(void *ptr) {
 #warning Heap statistics are not supported with the current toolchain.
 #endif
 
+#ifdef MBED_HEAP_PROFILER_ENABLED
+#warning Heap profiling is not supported with the current toolchain.
+#endif
+
+#if MBED_CONF_PLATFORM_HEAP_TLSF
+#warning The TLSF heap is not supported with the current toolchain.
+#endif
+
 #endif // #if defined(TOOLCHAIN_GCC)
 
@@ -76,6 +76,7 @@ void mbed_error_printf(const char* format, ...) {
 void mbed_error_vfprintf(const char * format, va_list arg) {
 #if DEVICE_SERIAL
     core_util_critical_section_enter();
+    mbed_stdio_panic_flush();
     char buffer[128];
     int size = vsprintf(buffer, format, arg);
     if (size > 0) {
@@ -35,6 +35,17 @@ bool core_util_are_interrupts_enabled(void)
 #endif
 }
 
+bool core_util_is_isr_active(void)
+{
+#if defined(__CORTEX_A9)
+    /* Only user and system modes run thread code */
+    uint32_t mode = __get_CPSR() & 0x1FU;
+    return (mode != 0x10U) && (mode != 0x1FU);
+#else
+    return (__get_IPSR() != 0U);
+#endif
+}
+
 MBED_WEAK void core_util_critical_section_enter(void)
 {
     bool interrupts_disabled = !core_util_are_interrupts_enabled();
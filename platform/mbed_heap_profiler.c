@@ -0,0 +1,126 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include "platform/mbed_heap_profiler.h"
+#include "platform/critical.h"
+
+#ifdef MBED_HEAP_PROFILER_ENABLED
+
+#if (MBED_HEAP_PROFILER_SIZE & (MBED_HEAP_PROFILER_SIZE - 1)) != 0
+#error "MBED_HEAP_PROFILER_SIZE must be a power of two"
+#endif
+
+/******************************************************************************
+ * Internal variables, functions and helpers
+ *****************************************************************************/
+
+/* Call sites hashed by caller, the extra last entry for the ones that don't
+ * fit. An entry is claimed for good by swapping its NULL caller. */
+static mbed_heap_profile_t profile[MBED_HEAP_PROFILER_SIZE + 1];
+/* Allocations seen, for sampling */
+static uint32_t sample_count;
+
+static uint32_t site_index(void *caller) {
+    // Fibonacci hashing, skipping the Thumb bit
+    uint32_t hash = ((uint32_t)(uintptr_t)caller >> 1) * 2654435761U;
+    uint32_t index = hash >> (32 - 16);
+
+    for (uint32_t i = 0; i < MBED_HEAP_PROFILER_SIZE; i++) {
+        mbed_heap_profile_t *entry = &profile[(index + i) & (MBED_HEAP_PROFILER_SIZE - 1)];
+        void *current = entry->caller;
+        if (current == NULL) {
+            // On failure current is what the other context put there
+            core_util_atomic_cas_ptr(&entry->caller, &current, caller);
+            if (current == NULL) {
+                current = caller;
+            }
+        }
+        if (current == caller) {
+            return entry - profile;
+        }
+    }
+    return MBED_HEAP_PROFILER_SIZE;
+}
+
+/******************************************************************************
+ * Public interface
+ *****************************************************************************/
+
+uint32_t mbed_heap_profiler_alloc(size_t size, void *caller) {
+    if (core_util_atomic_incr_u32(&sample_count, 1) % MBED_HEAP_PROFILER_SAMPLE != 0) {
+        return 0;
+    }
+    if (caller == NULL) {
+        caller = (void *)1;
+    }
+    mbed_heap_profile_t *entry = &profile[site_index(caller)];
+    core_util_atomic_incr_u32(&entry->alloc_cnt, 1);
+    core_util_atomic_incr_u32(&entry->alloc_size, size);
+    core_util_atomic_incr_u32(&entry->live_cnt, 1);
+    core_util_atomic_incr_u32(&entry->live_size, size);
+    return entry - profile + 1;
+}
+
+void mbed_heap_profiler_free(uint32_t site, size_t size) {
+    if (site == 0 || site > MBED_HEAP_PROFILER_SIZE + 1) {
+        return;
+    }
+    mbed_heap_profile_t *entry = &profile[site - 1];
+    core_util_atomic_decr_u32(&entry->live_cnt, 1);
+    core_util_atomic_decr_u32(&entry->live_size, size);
+}
+
+size_t mbed_heap_profiler_get(mbed_heap_profile_t *entries, size_t count) {
+    size_t filled = 0;
+    for (uint32_t i = 0; i <= MBED_HEAP_PROFILER_SIZE && filled < count; i++) {
+        // The shared entry is claimed by no caller
+        if (profile[i].caller != NULL || profile[i].alloc_cnt != 0) {
+            entries[filled++] = profile[i];
+        }
+    }
+    return filled;
+}
+
+void mbed_heap_profiler_dump(void) {
+    printf(MBED_HEAP_PROFILER_PREFIX " sample %lu\n", (unsigned long)MBED_HEAP_PROFILER_SAMPLE);
+    for (uint32_t i = 0; i <= MBED_HEAP_PROFILER_SIZE; i++) {
+        mbed_heap_profile_t entry = profile[i];
+        if (entry.caller != NULL || entry.alloc_cnt != 0) {
+            printf(MBED_HEAP_PROFILER_PREFIX " %p %lu %lu %lu %lu\n", entry.caller,
+                   (unsigned long)entry.alloc_cnt, (unsigned long)entry.alloc_size,
+                   (unsigned long)entry.live_cnt, (unsigned long)entry.live_size);
+        }
+    }
+}
+
+#else // #ifdef MBED_HEAP_PROFILER_ENABLED
+
+uint32_t mbed_heap_profiler_alloc(size_t size, void *caller) {
+    return 0;
+}
+
+void mbed_heap_profiler_free(uint32_t site, size_t size) {
+}
+
+size_t mbed_heap_profiler_get(mbed_heap_profile_t *entries, size_t count) {
+    return 0;
+}
+
+void mbed_heap_profiler_dump(void) {
+}
+
+#endif // #ifdef MBED_HEAP_PROFILER_ENABLED
@@ -0,0 +1,96 @@
+/** \addtogroup platform */
+/** @{*/
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MBED_HEAP_PROFILER_H__
+#define __MBED_HEAP_PROFILER_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* The heap profiler is activated by defining the MBED_HEAP_PROFILER_ENABLED
+ * macro. It counts the allocations made from each call site in a table of
+ * MBED_HEAP_PROFILER_SIZE entries (a power of two, 64 by default); call
+ * sites that don't fit share one extra entry with a NULL caller. Only one in
+ * MBED_HEAP_PROFILER_SAMPLE allocations (1 by default) is counted, so the
+ * counts are scaled down by that factor. Updates take no locks. */
+
+#ifndef MBED_HEAP_PROFILER_SIZE
+#define MBED_HEAP_PROFILER_SIZE     64
+#endif
+
+#ifndef MBED_HEAP_PROFILER_SAMPLE
+#define MBED_HEAP_PROFILER_SAMPLE   1
+#endif
+
+/* Prefix of the lines printed by mbed_heap_profiler_dump() */
+#define MBED_HEAP_PROFILER_PREFIX   "@heap"
+
+typedef struct {
+    void *caller;               /**< Return address of the allocating call. */
+    uint32_t alloc_cnt;         /**< Allocations counted. */
+    uint32_t alloc_size;        /**< Bytes of the allocations counted. */
+    uint32_t live_cnt;          /**< Allocations counted and not freed yet. */
+    uint32_t live_size;         /**< Bytes of those allocations. */
+} mbed_heap_profile_t;
+
+/**
+ * Count an allocation. Called by the allocation wrappers.
+ *
+ * @param size the size of the allocation.
+ * @param caller the caller of the memory operation.
+ * @return the site to pass to mbed_heap_profiler_free(), 0 if not counted.
+ */
+uint32_t mbed_heap_profiler_alloc(size_t size, void *caller);
+
+/**
+ * Count the release of an allocation. Called by the allocation wrappers.
+ *
+ * @param site the value mbed_heap_profiler_alloc() returned for the allocation.
+ * @param size the size of the allocation.
+ */
+void mbed_heap_profiler_free(uint32_t site, size_t size);
+
+/**
+ * Copy the entries of the call sites seen so far.
+ *
+ * @param entries the array to fill.
+ * @param count the size of the array.
+ * @return the number of entries filled.
+ */
+size_t mbed_heap_profiler_get(mbed_heap_profile_t *entries, size_t count);
+
+/**
+ * Print the entries of the call sites seen so far, one per line, for
+ * tools/heap_profile.py to symbolize:
+ *
+ * @heap sample <MBED_HEAP_PROFILER_SAMPLE>
+ * @heap <caller> <alloc_cnt> <alloc_size> <live_cnt> <live_size>
+ */
+void mbed_heap_profiler_dump(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // #ifndef __MBED_HEAP_PROFILER_H__
+
+/** @}*/
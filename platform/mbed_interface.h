@@ -126,6 +126,14 @@ void mbed_error_printf(const char* format, ...);
  */
 void mbed_error_vfprintf(const char * format, va_list arg);
 
+/** Push out console output that is still buffered, without taking any
+ *  lock. Called before a fatal error message is printed so that earlier
+ *  output appears before it.
+ *
+ * @Note Synchronization level: Interrupt safe
+ */
+void mbed_stdio_panic_flush(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,33 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef MBED_POLL_H
+#define MBED_POLL_H
+
+/** \addtogroup platform */
+/** @{*/
+
+/* Readiness events reported by FileHandle::poll, with the POSIX values */
+#ifndef POLLIN
+#define POLLIN      0x0001  /*!< Data available to read without blocking */
+#define POLLOUT     0x0004  /*!< Space available to write without blocking */
+#define POLLERR     0x0008  /*!< Error condition */
+#define POLLHUP     0x0010  /*!< Device disconnected */
+#define POLLNVAL    0x0020  /*!< Invalid handle */
+#endif
+
+#endif
+
+/** @}*/
@@ -0,0 +1,46 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef MBED_RETARGET_H
+#define MBED_RETARGET_H
+
+#include "drivers/FileHandle.h"
+
+namespace mbed {
+/** \addtogroup platform */
+/** @{*/
+
+/** Send stdin, stdout and stderr to a FileHandle
+ *
+ *  Replaces the built-in console (the stdio UART, or the async console
+ *  when platform.stdio-async-console is set). The handle sees the raw
+ *  data; platform.stdio-convert-newlines is not applied to it.
+ *
+ *  @param handle FileHandle to use, or NULL to restore the built-in console
+ */
+void mbed_set_console(FileHandle *handle);
+
+/** Get the FileHandle stdio currently goes to
+ *
+ *  @returns the handle set with mbed_set_console, the async console if
+ *           enabled, or NULL if stdio uses the UART directly
+ */
+FileHandle *mbed_get_console();
+
+} // namespace mbed
+
+#endif
+
+/** @}*/
@@ -18,6 +18,8 @@
  */
 #ifndef MBED_STATS_H
 #define MBED_STATS_H
+#include <stdint.h>
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -36,6 +38,41 @@ typedef struct {
  */
 void mbed_stats_heap_get(mbed_stats_heap_t *stats);
 
+/* Times in the thread stats are counted in RTOS kernel system timer ticks,
+ * see osKernelSysTickFrequency; usually processor cycles. */
+typedef struct {
+    uint32_t id;                /**< Thread identifier (osThreadId). */
+    uint32_t task_id;           /**< Task number used in context switch records. */
+    uint64_t run_time;          /**< Time spent running. */
+    uint64_t ready_time_total;  /**< Time spent ready but waiting to run. */
+    uint32_t ready_time_max;    /**< Longest wait from ready to running. */
+    uint32_t switches;          /**< Number of times switched in. */
+    uint32_t preemptions;       /**< Number of times switched out while still ready. */
+} mbed_stats_thread_t;
+
+typedef struct {
+    uint32_t time;              /**< System timer ticks at the switch, wrapping. */
+    uint8_t from;               /**< Task switched out, 0 if it was terminated. */
+    uint8_t to;                 /**< Task switched in, 0xFF for the idle thread. */
+    uint8_t preempted;          /**< 1 if the task switched out was still ready. */
+    uint8_t prio;               /**< Kernel priority of the task switched in. */
+} mbed_stats_thread_switch_t;
+
+/**
+ * Fill the passed in array with the stats of every thread, the idle
+ * thread last, and return the number of entries filled. Returns 0 unless
+ * MBED_THREAD_STATS_ENABLED is defined to 1.
+ */
+size_t mbed_stats_thread_get_each(mbed_stats_thread_t *stats, size_t count);
+
+/**
+ * Move up to count of the oldest context switch records into the passed in
+ * array and return the number moved. lost, if not NULL, receives the number
+ * of records overwritten since the previous call. Records are only kept if
+ * MBED_THREAD_TRACE_SIZE is defined as well.
+ */
+size_t mbed_stats_thread_trace_read(mbed_stats_thread_switch_t *records, size_t count, uint32_t *lost);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,318 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include "platform/mbed_tlsf.h"
+
+#if MBED_TLSF_FL_MAX > 31 || MBED_TLSF_FL_COUNT < 1
+#error "MBED_TLSF_FL_MAX out of range"
+#endif
+
+/******************************************************************************
+ * Internal variables, functions and helpers
+ *****************************************************************************/
+
+typedef struct mbed_tlsf_block {
+    /* Previous block in memory, NULL for the first block of a region */
+    struct mbed_tlsf_block *prev_phys;
+    /* Size of the payload with the flags in the low bits, 0 for the
+     * marker ending a region */
+    size_t size;
+    /* Free list links, over the payload so only there while free */
+    struct mbed_tlsf_block *next_free;
+    struct mbed_tlsf_block *prev_free;
+} block_t;
+
+#define ALIGN_SIZE          ((size_t)1 << MBED_TLSF_ALIGN_LOG2)
+#define SMALL_BLOCK_SIZE    ((size_t)1 << MBED_TLSF_FL_SHIFT)
+#define HEADER_SIZE         offsetof(block_t, next_free)
+#define BLOCK_MIN           (sizeof(block_t) - HEADER_SIZE)
+#define BLOCK_MAX           (((size_t)1 << MBED_TLSF_FL_MAX) - ALIGN_SIZE)
+
+#define BLOCK_FREE          ((size_t)1)
+#define BLOCK_FLAGS         (ALIGN_SIZE - 1)
+
+static inline int tlsf_fls(uint32_t word) {
+#if defined(__CC_ARM)
+    return 31 - (int)__clz(word);
+#elif defined(__GNUC__)
+    return word ? 31 - __builtin_clz(word) : -1;
+#else
+    int bit = 31;
+    if (word == 0) {
+        return -1;
+    }
+    while (!(word & (1UL << bit))) {
+        bit--;
+    }
+    return bit;
+#endif
+}
+
+static inline int tlsf_ffs(uint32_t word) {
+    return tlsf_fls(word & (~word + 1));
+}
+
+static inline size_t block_size(const block_t *block) {
+    return block->size & ~BLOCK_FLAGS;
+}
+
+static inline bool block_is_free(const block_t *block) {
+    return (block->size & BLOCK_FREE) != 0;
+}
+
+static inline void *block_payload(block_t *block) {
+    return (char *)block + HEADER_SIZE;
+}
+
+static inline block_t *block_from_payload(const void *ptr) {
+    return (block_t *)((char *)ptr - HEADER_SIZE);
+}
+
+static inline block_t *block_next(block_t *block) {
+    return (block_t *)((char *)block_payload(block) + block_size(block));
+}
+
+/* List a block of this size is kept in */
+static void mapping_insert(size_t size, int *fl, int *sl) {
+    if (size < SMALL_BLOCK_SIZE) {
+        // The small sizes are linear, one list per alignment step
+        *fl = 0;
+        *sl = (int)(size >> MBED_TLSF_ALIGN_LOG2);
+    } else {
+        int bit = tlsf_fls((uint32_t)size);
+        *sl = (int)(size >> (bit - MBED_TLSF_SL_LOG2)) ^ MBED_TLSF_SL_COUNT;
+        *fl = bit - MBED_TLSF_FL_SHIFT + 1;
+    }
+}
+
+/* First list whose blocks are all at least this size */
+static void mapping_search(size_t size, int *fl, int *sl) {
+    if (size >= SMALL_BLOCK_SIZE) {
+        size += ((size_t)1 << (tlsf_fls((uint32_t)size) - MBED_TLSF_SL_LOG2)) - 1;
+    }
+    mapping_insert(size, fl, sl);
+}
+
+static block_t *find_free(mbed_tlsf_t *tlsf, int *fl, int *sl) {
+    uint32_t sl_map = tlsf->sl_bitmap[*fl] & (~(uint32_t)0 << *sl);
+    if (sl_map == 0) {
+        // Nothing in this power of two, take the next one with anything
+        uint32_t fl_map = tlsf->fl_bitmap & (~(uint32_t)0 << (*fl + 1));
+        if (fl_map == 0) {
+            return NULL;
+        }
+        *fl = tlsf_ffs(fl_map);
+        sl_map = tlsf->sl_bitmap[*fl];
+    }
+    *sl = tlsf_ffs(sl_map);
+    return tlsf->blocks[*fl][*sl];
+}
+
+static void insert_free(mbed_tlsf_t *tlsf, block_t *block) {
+    int fl, sl;
+    mapping_insert(block_size(block), &fl, &sl);
+    block_t *head = tlsf->blocks[fl][sl];
+    block->next_free = head;
+    block->prev_free = NULL;
+    if (head != NULL) {
+        head->prev_free = block;
+    }
+    tlsf->blocks[fl][sl] = block;
+    tlsf->fl_bitmap |= 1UL << fl;
+    tlsf->sl_bitmap[fl] |= 1UL << sl;
+}
+
+static void remove_free(mbed_tlsf_t *tlsf, block_t *block) {
+    int fl, sl;
+    mapping_insert(block_size(block), &fl, &sl);
+    if (block->next_free != NULL) {
+        block->next_free->prev_free = block->prev_free;
+    }
+    if (block->prev_free != NULL) {
+        block->prev_free->next_free = block->next_free;
+    } else {
+        tlsf->blocks[fl][sl] = block->next_free;
+        if (block->next_free == NULL) {
+            tlsf->sl_bitmap[fl] &= ~(1UL << sl);
+            if (tlsf->sl_bitmap[fl] == 0) {
+                tlsf->fl_bitmap &= ~(1UL << fl);
+            }
+        }
+    }
+}
+
+/* Free a used block, merging it with its free neighbours */
+static void release(mbed_tlsf_t *tlsf, block_t *block) {
+    block_t *prev = block->prev_phys;
+    block_t *next = block_next(block);
+
+    if (prev != NULL && block_is_free(prev) &&
+            block_size(prev) + HEADER_SIZE + block_size(block) <= BLOCK_MAX) {
+        remove_free(tlsf, prev);
+        prev->size += HEADER_SIZE + block_size(block);
+        block = prev;
+        next->prev_phys = block;
+    }
+    if (block_is_free(next) &&
+            block_size(block) + HEADER_SIZE + block_size(next) <= BLOCK_MAX) {
+        remove_free(tlsf, next);
+        block->size += HEADER_SIZE + block_size(next);
+        block_next(block)->prev_phys = block;
+    }
+    block->size |= BLOCK_FREE;
+    insert_free(tlsf, block);
+}
+
+/* Give back the end of a used block beyond size, if it makes a block */
+static void trim(mbed_tlsf_t *tlsf, block_t *block, size_t size) {
+    size_t current = block_size(block);
+    if (current >= size + HEADER_SIZE + BLOCK_MIN) {
+        block_t *rest = (block_t *)((char *)block_payload(block) + size);
+        rest->prev_phys = block;
+        rest->size = current - size - HEADER_SIZE;
+        block->size = size | (block->size & BLOCK_FLAGS);
+        block_next(rest)->prev_phys = rest;
+        release(tlsf, rest);
+    }
+}
+
+/* Size of the block for a request, 0 if too large */
+static size_t adjust_size(size_t size) {
+    if (size > BLOCK_MAX) {
+        return 0;
+    }
+    size = (size + ALIGN_SIZE - 1) & ~(ALIGN_SIZE - 1);
+    return size < BLOCK_MIN ? BLOCK_MIN : size;
+}
+
+/******************************************************************************
+ * Public interface
+ *****************************************************************************/
+
+void mbed_tlsf_init(mbed_tlsf_t *tlsf) {
+    memset(tlsf, 0, sizeof(*tlsf));
+}
+
+bool mbed_tlsf_add_region(mbed_tlsf_t *tlsf, void *start, size_t size) {
+    uintptr_t begin = ((uintptr_t)start + ALIGN_SIZE - 1) & ~(uintptr_t)(ALIGN_SIZE - 1);
+    uintptr_t end = ((uintptr_t)start + size) & ~(uintptr_t)(ALIGN_SIZE - 1);
+
+    // At least one block and the end marker
+    if (end < begin || end - begin < 2 * HEADER_SIZE + BLOCK_MIN) {
+        return false;
+    }
+    block_t *prev = NULL;
+    block_t *block = (block_t *)begin;
+    size_t left = end - begin - HEADER_SIZE;
+    while (left >= HEADER_SIZE + BLOCK_MIN) {
+        size_t size = left - HEADER_SIZE;
+        if (size > BLOCK_MAX) {
+            size = BLOCK_MAX;
+        }
+        block->prev_phys = prev;
+        block->size = size | BLOCK_FREE;
+        insert_free(tlsf, block);
+        left -= HEADER_SIZE + size;
+        prev = block;
+        block = block_next(block);
+    }
+    // The marker is a used empty block, so nothing merges past it
+    block->prev_phys = prev;
+    block->size = 0;
+    return true;
+}
+
+void *mbed_tlsf_malloc(mbed_tlsf_t *tlsf, size_t size) {
+    size_t adjusted = adjust_size(size);
+    int fl, sl;
+
+    if (adjusted == 0) {
+        return NULL;
+    }
+    mapping_search(adjusted, &fl, &sl);
+    if (fl >= MBED_TLSF_FL_COUNT) {
+        return NULL;
+    }
+    block_t *block = find_free(tlsf, &fl, &sl);
+    if (block == NULL) {
+        return NULL;
+    }
+    remove_free(tlsf, block);
+    block->size &= ~BLOCK_FREE;
+    trim(tlsf, block, adjusted);
+    return block_payload(block);
+}
+
+void *mbed_tlsf_realloc(mbed_tlsf_t *tlsf, void *ptr, size_t size) {
+    if (ptr == NULL) {
+        return mbed_tlsf_malloc(tlsf, size);
+    }
+    if (size == 0) {
+        mbed_tlsf_free(tlsf, ptr);
+        return NULL;
+    }
+    size_t adjusted = adjust_size(size);
+    if (adjusted == 0) {
+        return NULL;
+    }
+
+    block_t *block = block_from_payload(ptr);
+    size_t current = block_size(block);
+    if (adjusted > current) {
+        block_t *next = block_next(block);
+        if (!block_is_free(next) || current + HEADER_SIZE + block_size(next) < adjusted) {
+            void *moved = mbed_tlsf_malloc(tlsf, size);
+            if (moved != NULL) {
+                memcpy(moved, ptr, current);
+                release(tlsf, block);
+            }
+            return moved;
+        }
+        // Grow into the free block that follows
+        remove_free(tlsf, next);
+        block->size += HEADER_SIZE + block_size(next);
+        block_next(block)->prev_phys = block;
+    }
+    trim(tlsf, block, adjusted);
+    return ptr;
+}
+
+void mbed_tlsf_free(mbed_tlsf_t *tlsf, void *ptr) {
+    if (ptr != NULL) {
+        release(tlsf, block_from_payload(ptr));
+    }
+}
+
+size_t mbed_tlsf_block_size(const void *ptr) {
+    return block_size(block_from_payload(ptr));
+}
+
+void mbed_tlsf_get_info(const mbed_tlsf_t *tlsf, mbed_tlsf_info_t *info) {
+    memset(info, 0, sizeof(*info));
+    for (int fl = 0; fl < MBED_TLSF_FL_COUNT; fl++) {
+        for (int sl = 0; sl < MBED_TLSF_SL_COUNT; sl++) {
+            for (const block_t *block = tlsf->blocks[fl][sl]; block != NULL; block = block->next_free) {
+                size_t size = block_size(block);
+                info->free_size += size;
+                info->free_blocks++;
+                if (size > info->largest_free) {
+                    info->largest_free = size;
+                }
+            }
+        }
+    }
+}
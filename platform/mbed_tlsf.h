@@ -0,0 +1,158 @@
+/** \addtogroup platform */
+/** @{*/
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MBED_TLSF_H__
+#define __MBED_TLSF_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/* Two-level segregated fit allocator. Free blocks are kept in lists by
+ * size class: the first level splits sizes by powers of two, the second
+ * splits each power of two into MBED_TLSF_SL_COUNT linear steps. Two
+ * bitmaps of the non-empty lists find a free block big enough with a couple
+ * of bit scans, so malloc and free take constant time whatever the state of
+ * the heap. Freed blocks are merged with their free neighbours at once.
+ *
+ * Blocks are 8 byte aligned with an 8 byte header (16 bytes on 64-bit
+ * hosts). The allocator takes no locks. */
+
+/* log2 of the number of second level lists per power of two */
+#ifndef MBED_TLSF_SL_LOG2
+#define MBED_TLSF_SL_LOG2       4
+#endif
+
+/* Blocks are smaller than 2^MBED_TLSF_FL_MAX bytes, larger regions are
+ * split in several blocks */
+#ifndef MBED_TLSF_FL_MAX
+#define MBED_TLSF_FL_MAX        24
+#endif
+
+#define MBED_TLSF_ALIGN_LOG2    3
+#define MBED_TLSF_SL_COUNT      (1 << MBED_TLSF_SL_LOG2)
+#define MBED_TLSF_FL_SHIFT      (MBED_TLSF_SL_LOG2 + MBED_TLSF_ALIGN_LOG2)
+#define MBED_TLSF_FL_COUNT      (MBED_TLSF_FL_MAX - MBED_TLSF_FL_SHIFT + 1)
+
+struct mbed_tlsf_block;
+
+typedef struct {
+    uint32_t fl_bitmap;
+    uint32_t sl_bitmap[MBED_TLSF_FL_COUNT];
+    struct mbed_tlsf_block *blocks[MBED_TLSF_FL_COUNT][MBED_TLSF_SL_COUNT];
+} mbed_tlsf_t;
+
+typedef struct {
+    size_t free_size;           /**< Bytes free, headers excluded. */
+    size_t free_blocks;         /**< Number of free blocks. */
+    size_t largest_free;        /**< Size of the largest free block. */
+} mbed_tlsf_info_t;
+
+/**
+ * Initialize an allocator with no memory.
+ *
+ * @param tlsf the allocator.
+ */
+void mbed_tlsf_init(mbed_tlsf_t *tlsf);
+
+/**
+ * Give a region of memory to an allocator. Regions need not be contiguous.
+ *
+ * @param tlsf the allocator.
+ * @param start the start of the region.
+ * @param size the size of the region in bytes.
+ * @return true if the region was added, false if it is too small.
+ */
+bool mbed_tlsf_add_region(mbed_tlsf_t *tlsf, void *start, size_t size);
+
+/**
+ * Allocate a block.
+ *
+ * @param tlsf the allocator.
+ * @param size the size of the block.
+ * @return the block, NULL if no free block is large enough.
+ */
+void *mbed_tlsf_malloc(mbed_tlsf_t *tlsf, size_t size);
+
+/**
+ * Resize a block, in place if the memory after it is free.
+ *
+ * @param tlsf the allocator.
+ * @param ptr the block, or NULL to allocate one.
+ * @param size the new size, 0 to free the block.
+ * @return the block, NULL if it could not be resized (the block is then unchanged).
+ */
+void *mbed_tlsf_realloc(mbed_tlsf_t *tlsf, void *ptr, size_t size);
+
+/**
+ * Free a block.
+ *
+ * @param tlsf the allocator.
+ * @param ptr the block, or NULL.
+ */
+void mbed_tlsf_free(mbed_tlsf_t *tlsf, void *ptr);
+
+/**
+ * Get the usable size of a block, at least the size it was allocated with.
+ *
+ * @param ptr the block.
+ * @return the size of the block.
+ */
+size_t mbed_tlsf_block_size(const void *ptr);
+
+/**
+ * Get the free space of an allocator. This walks the free lists, so unlike
+ * the other calls it takes time proportional to the number of free blocks.
+ *
+ * @param tlsf the allocator.
+ * @param info the structure to fill.
+ */
+void mbed_tlsf_get_info(const mbed_tlsf_t *tlsf, mbed_tlsf_info_t *info);
+
+/**
+ * Give a region of memory, for example external SDRAM once it is set up, to
+ * the platform heap. Only available when the platform.heap-tlsf option is
+ * enabled, in which case the heap otherwise takes the memory the C library
+ * heap would have had.
+ *
+ * @param start the start of the region.
+ * @param size the size of the region in bytes.
+ * @return true if the region was added, false if it is too small or the
+ *         TLSF heap is not in use.
+ */
+bool mbed_tlsf_heap_add_region(void *start, size_t size);
+
+/**
+ * Get the free space of the platform heap, all zeroes unless the
+ * platform.heap-tlsf option is enabled.
+ *
+ * @param info the structure to fill.
+ */
+void mbed_tlsf_heap_get_info(mbed_tlsf_info_t *info);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // #ifndef __MBED_TLSF_H__
+
+/** @}*/
@@ -25,6 +25,9 @@
 #include "platform/PlatformMutex.h"
 #include "platform/mbed_error.h"
 #include "platform/mbed_stats.h"
+#include "drivers/BufferedSerial.h"
+#include "platform/AsyncConsole.h"
+#include "platform/mbed_retarget.h"
 #include <stdlib.h>
 #include <string.h>
 #if DEVICE_STDIO_MESSAGES
@@ -104,14 +107,207 @@ static char stdio_out_prev;
 #endif
 #endif
 
+#if DEVICE_SERIAL && MBED_CONF_PLATFORM_STDIO_BUFFERED_SERIAL
+/* Buffered, interrupt driven console on the stdio UART */
+class StdioBufferedSerial : public BufferedSerial {
+public:
+    StdioBufferedSerial() : BufferedSerial(STDIO_UART_TX, STDIO_UART_RX, MBED_CONF_PLATFORM_STDIO_BAUD_RATE) {
+    }
+};
+
+static SingletonPtr<StdioBufferedSerial> stdio_buffered_serial;
+#endif
+
 static void init_serial() {
 #if DEVICE_SERIAL
+#if MBED_CONF_PLATFORM_STDIO_BUFFERED_SERIAL
+    stdio_buffered_serial.get();
+#else
     if (stdio_uart_inited) return;
     serial_init(&stdio_uart, STDIO_UART_TX, STDIO_UART_RX);
 #if MBED_CONF_PLATFORM_STDIO_BAUD_RATE
     serial_baud(&stdio_uart, MBED_CONF_PLATFORM_STDIO_BAUD_RATE);
 #endif
 #endif
+#endif
+}
+
+#if DEVICE_SERIAL
+static void stdio_write(const unsigned char *buffer, unsigned int length) {
+#if MBED_CONF_PLATFORM_STDIO_BUFFERED_SERIAL
+#if MBED_CONF_PLATFORM_STDIO_CONVERT_NEWLINES
+    /* Convert into a small chunk so the UART buffer is still filled in bulk */
+    char chunk[32];
+    unsigned int used = 0;
+    for (unsigned int i = 0; i < length; i++) {
+        if (buffer[i] == '\n' && stdio_out_prev != '\r') {
+            chunk[used++] = '\r';
+        }
+        chunk[used++] = buffer[i];
+        stdio_out_prev = buffer[i];
+        if (used >= sizeof(chunk) - 1) {
+            stdio_buffered_serial->write(chunk, used);
+            used = 0;
+        }
+    }
+    if (used > 0) {
+        stdio_buffered_serial->write(chunk, used);
+    }
+#else
+    stdio_buffered_serial->write(buffer, length);
+#endif
+#else
+#if MBED_CONF_PLATFORM_STDIO_CONVERT_NEWLINES
+    for (unsigned int i = 0; i < length; i++) {
+        if (buffer[i] == '\n' && stdio_out_prev != '\r') {
+             serial_putc(&stdio_uart, '\r');
+        }
+        serial_putc(&stdio_uart, buffer[i]);
+        stdio_out_prev = buffer[i];
+    }
+#else
+    for (unsigned int i = 0; i < length; i++) {
+        serial_putc(&stdio_uart, buffer[i]);
+    }
+#endif
+#endif
+}
+
+static char stdio_getc() {
+#if MBED_CONF_PLATFORM_STDIO_BUFFERED_SERIAL
+    char c;
+    while (stdio_buffered_serial->read(&c, 1) != 1);
+    return c;
+#else
+    return serial_getc(&stdio_uart);
+#endif
+}
+
+static char stdio_read() {
+#if MBED_CONF_PLATFORM_STDIO_CONVERT_NEWLINES
+    while (true) {
+        char c = stdio_getc();
+        if ((c == '\r' && stdio_in_prev != '\n') ||
+            (c == '\n' && stdio_in_prev != '\r')) {
+            stdio_in_prev = c;
+            return '\n';
+        } else if ((c == '\r' && stdio_in_prev == '\n') ||
+                   (c == '\n' && stdio_in_prev == '\r')) {
+            stdio_in_prev = c;
+            // onto next character
+            continue;
+        } else {
+            stdio_in_prev = c;
+            return c;
+        }
+    }
+#else
+    return stdio_getc();
+#endif
+}
+#endif
+
+/* Console plugged in with mbed_set_console, NULL for the built-in one */
+static FileHandle *stdio_console;
+
+#if DEVICE_SERIAL && MBED_CONF_PLATFORM_STDIO_ASYNC_CONSOLE
+/* The built-in stdio backend as a FileHandle, drained into by the async console */
+class StdioSerial : public FileHandle {
+public:
+    virtual ssize_t write(const void *buffer, size_t length) {
+        init_serial();
+        stdio_write((const unsigned char *)buffer, length);
+        return length;
+    }
+    virtual ssize_t read(void *buffer, size_t length) {
+        init_serial();
+        *(char *)buffer = stdio_read();
+        return 1;
+    }
+    virtual int close() { return 0; }
+    virtual int isatty() { return 1; }
+    virtual off_t lseek(off_t offset, int whence) { return -1; }
+    virtual int fsync() {
+#if MBED_CONF_PLATFORM_STDIO_BUFFERED_SERIAL
+        return stdio_buffered_serial->fsync();
+#else
+        return 0;
+#endif
+    }
+};
+
+/* Polls the UART directly and takes no lock, for the fatal error path */
+class StdioPanicSerial : public StdioSerial {
+public:
+    virtual ssize_t write(const void *buffer, size_t length) {
+        const char *ptr = (const char *)buffer;
+        if (!stdio_uart_inited) {
+            serial_init(&stdio_uart, STDIO_UART_TX, STDIO_UART_RX);
+        }
+        for (size_t i = 0; i < length; i++) {
+#if MBED_CONF_PLATFORM_STDIO_CONVERT_NEWLINES
+            if (ptr[i] == '\n' && stdio_out_prev != '\r') {
+                serial_putc(&stdio_uart, '\r');
+            }
+            stdio_out_prev = ptr[i];
+#endif
+            serial_putc(&stdio_uart, ptr[i]);
+        }
+        return length;
+    }
+};
+
+static StdioSerial stdio_serial;
+
+class StdioAsyncConsole : public AsyncConsole {
+public:
+    StdioAsyncConsole() : AsyncConsole(&stdio_serial,
+            MBED_CONF_PLATFORM_STDIO_ASYNC_CONSOLE_BUFFER_SIZE,
+            (OverflowPolicy)MBED_CONF_PLATFORM_STDIO_ASYNC_CONSOLE_OVERFLOW) {
+#ifdef MBED_CONF_RTOS_PRESENT
+        start();
+#endif
+    }
+};
+
+static SingletonPtr<StdioAsyncConsole> stdio_async_console;
+#endif
+
+static FileHandle *get_console() {
+    if (stdio_console) {
+        return stdio_console;
+    }
+#if DEVICE_SERIAL && MBED_CONF_PLATFORM_STDIO_ASYNC_CONSOLE
+    return stdio_async_console.get();
+#else
+    return NULL;
+#endif
+}
+
+namespace mbed {
+
+void mbed_set_console(FileHandle *handle) {
+    stdio_console = handle;
+}
+
+FileHandle *mbed_get_console() {
+    return get_console();
+}
+
+} // namespace mbed
+
+extern "C" void mbed_stdio_panic_flush(void) {
+#if DEVICE_SERIAL && MBED_CONF_PLATFORM_STDIO_BUFFERED_SERIAL
+    if (stdio_buffered_serial._ptr) {
+        stdio_buffered_serial._ptr->flush_blocking();
+    }
+#endif
+#if DEVICE_SERIAL && MBED_CONF_PLATFORM_STDIO_ASYNC_CONSOLE
+    if (stdio_async_console._ptr) {
+        StdioPanicSerial panic_serial;
+        stdio_async_console._ptr->panic_drain(&panic_serial);
+    }
+#endif
 }
 
 static inline int openmode_to_posix(int openmode) {
@@ -249,23 +445,16 @@ extern "C" int PREFIX(_write)(FILEHANDLE fh, const unsigned char *buffer, unsign
 #endif
     int n; // n is the number of bytes written
     if (fh < 3) {
+        FileHandle *console = get_console();
+        if (console) {
+            n = console->write(buffer, length);
+        } else {
 #if DEVICE_SERIAL
-        if (!stdio_uart_inited) init_serial();
-#if MBED_CONF_PLATFORM_STDIO_CONVERT_NEWLINES
-        for (unsigned int i = 0; i < length; i++) {
-            if (buffer[i] == '\n' && stdio_out_prev != '\r') {
-                 serial_putc(&stdio_uart, '\r');
-            }
-            serial_putc(&stdio_uart, buffer[i]);
-            stdio_out_prev = buffer[i];
-        }
-#else
-        for (unsigned int i = 0; i < length; i++) {
-            serial_putc(&stdio_uart, buffer[i]);
-        }
-#endif
+            init_serial();
+            stdio_write(buffer, length);
 #endif
-        n = length;
+            n = length;
+        }
     } else {
         FileHandle* fhc = filehandles[fh-3];
         if (fhc == NULL) return -1;
@@ -287,32 +476,16 @@ extern "C" int PREFIX(_read)(FILEHANDLE fh, unsigned char *buffer, unsigned int
     int n; // n is the number of bytes read
     if (fh < 3) {
         // only read a character at a time from stdin
+        FileHandle *console = get_console();
+        if (console) {
+            n = console->read(buffer, 1);
+        } else {
 #if DEVICE_SERIAL
-        if (!stdio_uart_inited) init_serial();
-#if MBED_CONF_PLATFORM_STDIO_CONVERT_NEWLINES
-        while (true) {
-            char c = serial_getc(&stdio_uart);
-            if ((c == '\r' && stdio_in_prev != '\n') ||
-                (c == '\n' && stdio_in_prev != '\r')) {
-                stdio_in_prev = c;
-                *buffer = '\n';
-                break;
-            } else if ((c == '\r' && stdio_in_prev == '\n') ||
-                       (c == '\n' && stdio_in_prev == '\r')) {
-                stdio_in_prev = c;
-                // onto next character
-                continue;
-            } else {
-                stdio_in_prev = c;
-                *buffer = c;
-                break;
-            }
-        }
-#else
-        *buffer = serial_getc(&stdio_uart);
-#endif
+            init_serial();
+            *buffer = stdio_read();
 #endif
-        n = 1;
+            n = 1;
+        }
     } else {
         FileHandle* fhc = filehandles[fh-3];
         if (fhc == NULL) return -1;
@@ -622,6 +795,19 @@ extern "C" void exit(int return_code) {
 #if MBED_CONF_PLATFORM_STDIO_FLUSH_AT_EXIT
     fflush(stdout);
     fflush(stderr);
+    if (stdio_console) {
+        stdio_console->fsync();
+    }
+#if DEVICE_SERIAL && MBED_CONF_PLATFORM_STDIO_ASYNC_CONSOLE
+    if (stdio_async_console._ptr) {
+        stdio_async_console._ptr->fsync();
+    }
+#endif
+#if DEVICE_SERIAL && MBED_CONF_PLATFORM_STDIO_BUFFERED_SERIAL
+    if (stdio_uart_inited) {
+        stdio_buffered_serial->fsync();
+    }
+#endif
 #endif
 #endif
 
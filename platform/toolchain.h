@@ -72,6 +72,25 @@
 #endif
 #endif
 
+/** MBED_SECTION(name)
+ *  Place a variable in a named linker section, for example a separate
+ *  RAM bank that the target's linker script sets aside.
+ *
+ *  @code
+ *  #include "toolchain.h"
+ *
+ *  MBED_SECTION("AHBSRAM1") char buffer[1024];
+ *  @endcode
+ */
+#ifndef MBED_SECTION
+#if defined(__ICCARM__)
+#define _MBED_SECTION(x) _Pragma(#x)
+#define MBED_SECTION(name) _MBED_SECTION(location=name)
+#else
+#define MBED_SECTION(name) __attribute__((section(name)))
+#endif
+#endif
+
 /** MBED_UNUSED
  *  Declare a function argument to be unused, suppressing compiler warnings
  *
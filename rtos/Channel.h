@@ -0,0 +1,192 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef CHANNEL_H
+#define CHANNEL_H
+
+#include <stdint.h>
+
+#include "cmsis_os.h"
+#include "rtos/Semaphore.h"
+#include "platform/RingBuffer.h"
+#include "platform/critical.h"
+#include "hal/us_ticker_api.h"
+
+namespace rtos {
+/** \addtogroup rtos */
+/** @{*/
+
+/** The Channel class passes elements of a given type by value to a thread,
+ from other threads or interrupt service routines. Elements are copied into a
+ ring buffer, so unlike Mail no memory pool is involved, and put_n() and
+ get_n() move a whole batch of elements under a single lock.
+
+ Any number of threads may wait to put or to get. Elements arriving wake one
+ waiting getter each, and elements taken out wake one waiting putter each.
+ Calls with a time-out of 0 never wait and may be used from interrupt service
+ routines.
+  @tparam  T           data type of a single element, copied by assignment.
+  @tparam  channel_sz  maximum number of elements in the channel, a power of two.
+*/
+template<typename T, uint32_t channel_sz>
+class Channel {
+public:
+    /** Create and initialise an empty Channel. */
+    Channel() : _data_sem(0), _space_sem(0), _data_waiters(0), _space_waiters(0) {
+    }
+
+    /** Put elements in the Channel, waiting for space when it is full.
+      @param   data      elements to put.
+      @param   count     number of elements.
+      @param   millisec  timeout value or 0 in case of no time-out. (default: 0)
+      @return  number of elements put, less than count if the time-out expired.
+    */
+    uint32_t put_n(const T *data, uint32_t count, uint32_t millisec=0) {
+        uint32_t start = start_time(millisec);
+        uint32_t sent = 0;
+        uint32_t wait_ms;
+
+        for (;;) {
+            uint32_t pushed = _buffer.push(data + sent, count - sent);
+            if (pushed) {
+                sent += pushed;
+                wake(_data_sem, _data_waiters, pushed);
+            }
+            if (sent == count || (wait_ms = remaining(start, millisec)) == 0) {
+                return sent;
+            }
+            core_util_atomic_incr_u32(&_space_waiters, 1);
+            // Checked again as getters only wake threads counted as waiting
+            if (_buffer.full()) {
+                _space_sem.wait(wait_ms);
+            }
+            core_util_atomic_decr_u32(&_space_waiters, 1);
+        }
+    }
+
+    /** Get elements from the Channel, waiting for one when it is empty.
+      @param   data      buffer for the elements.
+      @param   count     maximum number of elements to get.
+      @param   millisec  timeout value or 0 in case of no time-out. (default: osWaitForever)
+      @return  number of elements got, as many as were there up to count, 0 if the time-out expired.
+    */
+    uint32_t get_n(T *data, uint32_t count, uint32_t millisec=osWaitForever) {
+        uint32_t start = start_time(millisec);
+        uint32_t wait_ms;
+
+        for (;;) {
+            uint32_t popped = _buffer.pop(data, count);
+            if (popped) {
+                wake(_space_sem, _space_waiters, popped);
+                return popped;
+            }
+            if (count == 0 || (wait_ms = remaining(start, millisec)) == 0) {
+                return 0;
+            }
+            core_util_atomic_incr_u32(&_data_waiters, 1);
+            // Checked again as putters only wake threads counted as waiting
+            if (_buffer.empty()) {
+                _data_sem.wait(wait_ms);
+            }
+            core_util_atomic_decr_u32(&_data_waiters, 1);
+        }
+    }
+
+    /** Put an element in the Channel.
+      @param   data      element to put.
+      @param   millisec  timeout value or 0 in case of no time-out. (default: 0)
+      @return  osOK, osErrorResource if full and no time-out was given, or osErrorTimeoutResource.
+    */
+    osStatus put(const T &data, uint32_t millisec=0) {
+        if (put_n(&data, 1, millisec)) {
+            return osOK;
+        }
+        return millisec ? osErrorTimeoutResource : osErrorResource;
+    }
+
+    /** Get an element from the Channel.
+      @param   data      set to the element got.
+      @param   millisec  timeout value or 0 in case of no time-out. (default: osWaitForever)
+      @return  osOK, osErrorResource if empty and no time-out was given, or osEventTimeout.
+    */
+    osStatus get(T &data, uint32_t millisec=osWaitForever) {
+        if (get_n(&data, 1, millisec)) {
+            return osOK;
+        }
+        return millisec ? osEventTimeout : osErrorResource;
+    }
+
+    /** Get the number of elements in the Channel.
+      @return  number of elements that can be got without waiting.
+    */
+    uint32_t size() const {
+        return _buffer.size();
+    }
+
+    /** Check if the Channel is empty.
+      @return  true if there are no elements.
+    */
+    bool empty() const {
+        return _buffer.empty();
+    }
+
+    /** Check if the Channel is full.
+      @return  true if no element can be put without waiting.
+    */
+    bool full() const {
+        return _buffer.full();
+    }
+
+private:
+    static uint32_t start_time(uint32_t millisec) {
+        return millisec && millisec != osWaitForever ? us_ticker_read() : 0;
+    }
+
+    static uint32_t remaining(uint32_t start, uint32_t millisec) {
+        if (millisec == 0 || millisec == osWaitForever) {
+            return millisec;
+        }
+        uint32_t elapsed = (us_ticker_read() - start) / 1000;
+        return elapsed < millisec ? millisec - elapsed : 0;
+    }
+
+    static void wake(Semaphore &sem, uint32_t &waiters, uint32_t count) {
+        // A woken thread that finds nothing to do waits again
+        uint32_t threads = waiters;
+        if (threads > count) {
+            threads = count;
+        }
+        while (threads--) {
+            sem.release();
+        }
+    }
+
+    mbed::RingBuffer<T, channel_sz> _buffer;
+    Semaphore _data_sem;
+    Semaphore _space_sem;
+    uint32_t _data_waiters;
+    uint32_t _space_waiters;
+};
+
+}
+#endif
+
+/** @}*/
@@ -26,12 +26,69 @@
 #include <string.h>
 
 #include "cmsis_os.h"
+#include "platform/LockFreePool.h"
 
 namespace rtos {
 /** \addtogroup rtos */
 /** @{*/
 
+/** Fixed-size memory pool of objects of a given type, in storage defined
+  separately. The storage can then be placed in a particular RAM bank with
+  MBED_SECTION:
+  @code
+  MBED_SECTION("AHBSRAM1") SectionMemoryPool<frame_t, 8>::storage_t frame_storage;
+  SectionMemoryPool<frame_t, 8> frame_pool(frame_storage);
+  @endcode
+  @tparam  T         data type of a single object (element).
+  @tparam  pool_sz   maximum number of objects (elements) in the memory pool.
+*/
+template<typename T, uint32_t pool_sz>
+class SectionMemoryPool {
+public:
+    /** Storage for the objects of the pool */
+    typedef uint32_t storage_t[mbed::LockFreePoolStorage<T, pool_sz>::words];
+
+    /** Create and Initialize a memory pool.
+      @param   storage  storage for the objects, not used by anything else.
+    */
+    SectionMemoryPool(storage_t &storage) : _pool(storage, sizeof(T), pool_sz) {
+    }
+
+    /** Allocate a memory block of type T from a memory pool.
+      @return  address of the allocated memory block or NULL in case of no memory available.
+    */
+    T* alloc(void) {
+        return (T*)_pool.alloc();
+    }
+
+    /** Allocate a memory block of type T from a memory pool and set memory block to zero.
+      @return  address of the allocated memory block or NULL in case of no memory available.
+    */
+    T* calloc(void) {
+        T *block = alloc();
+        if (block != NULL) {
+            memset(block, 0, sizeof(T));
+        }
+        return block;
+    }
+
+    /** Return an allocated memory block back to a specific memory pool.
+      @param   address of the allocated memory block that is returned to the memory pool.
+      @return  status code that indicates the execution status of the function.
+    */
+    osStatus free(T *block) {
+        return _pool.free(block) ? osOK : osErrorValue;
+    }
+
+private:
+    mbed::LockFreePool _pool;
+};
+
 /** Define and manage fixed-size memory pools of objects of a given type.
+
+  Blocks are taken and returned with a lock-free free list (see
+  mbed::LockFreePool), so threads and interrupts can allocate and free
+  concurrently without the RTOS kernel being involved.
   @tparam  T         data type of a single object (element).
   @tparam  queue_sz  maximum number of objects (elements) in the memory pool.
 */
@@ -39,29 +96,21 @@ template<typename T, uint32_t pool_sz>
 class MemoryPool {
 public:
     /** Create and Initialize a memory pool. */
-    MemoryPool() {
-    #ifdef CMSIS_OS_RTX
-        memset(_pool_m, 0, sizeof(_pool_m));
-        _pool_def.pool = _pool_m;
-
-        _pool_def.pool_sz = pool_sz;
-        _pool_def.item_sz =  sizeof(T);
-    #endif
-        _pool_id = osPoolCreate(&_pool_def);
+    MemoryPool() : _pool(_pool_m) {
     }
 
     /** Allocate a memory block of type T from a memory pool.
       @return  address of the allocated memory block or NULL in case of no memory available.
     */
     T* alloc(void) {
-        return (T*)osPoolAlloc(_pool_id);
+        return _pool.alloc();
     }
 
     /** Allocate a memory block of type T from a memory pool and set memory block to zero.
       @return  address of the allocated memory block or NULL in case of no memory available.
     */
     T* calloc(void) {
-        return (T*)osPoolCAlloc(_pool_id);
+        return _pool.calloc();
     }
 
     /** Return an allocated memory block back to a specific memory pool.
@@ -69,15 +118,12 @@ public:
       @return  status code that indicates the execution status of the function.
     */
     osStatus free(T *block) {
-        return osPoolFree(_pool_id, (void*)block);
+        return _pool.free(block);
     }
 
 private:
-    osPoolId    _pool_id;
-    osPoolDef_t _pool_def;
-#ifdef CMSIS_OS_RTX
-    uint32_t    _pool_m[3+((sizeof(T)+3)/4)*(pool_sz)];
-#endif
+    typename SectionMemoryPool<T, pool_sz>::storage_t _pool_m;
+    SectionMemoryPool<T, pool_sz> _pool;
 };
 
 }
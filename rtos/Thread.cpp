@@ -30,6 +30,80 @@
 
 extern "C" P_TCB rt_tid2ptcb(osThreadId thread_id);
 
+#if defined(osFeature_ThreadStats) && osFeature_ThreadStats
+static bool get_thread_stats(osThreadId id, mbed_stats_thread_t *stats)
+{
+    osThreadStats os_stats;
+    if (_osThreadGetStats(id, &os_stats) != osOK) {
+        return false;
+    }
+    stats->id = (uint32_t)id;
+    stats->task_id = os_stats.task_id;
+    stats->run_time = os_stats.run_time;
+    stats->ready_time_total = os_stats.ready_time_total;
+    stats->ready_time_max = os_stats.ready_time_max;
+    stats->switches = os_stats.switches;
+    stats->preemptions = os_stats.preemptions;
+    return true;
+}
+#endif
+
+size_t mbed_stats_thread_get_each(mbed_stats_thread_t *stats, size_t count)
+{
+    size_t i = 0;
+#if defined(osFeature_ThreadStats) && osFeature_ThreadStats
+    osThreadEnumId enum_id = _osThreadsEnumStart();
+    while (i < count) {
+        osThreadId thread_id = _osThreadEnumNext(enum_id);
+        if (NULL == thread_id) {
+            // End of enumeration
+            break;
+        }
+        if (get_thread_stats(thread_id, &stats[i])) {
+            i++;
+        }
+    }
+    _osThreadEnumFree(enum_id);
+#endif
+    return i;
+}
+
+size_t mbed_stats_thread_trace_read(mbed_stats_thread_switch_t *records, size_t count, uint32_t *lost)
+{
+    size_t read = 0;
+#if defined(osFeature_ThreadTrace) && osFeature_ThreadTrace
+    osThreadSwitch chunk[8];
+    uint32_t chunk_lost = 0;
+    if (lost != NULL) {
+        *lost = 0;
+    }
+    // The kernel copies with the scheduler held off, so go a few at a time
+    while (read < count) {
+        uint32_t want = count - read < 8 ? count - read : 8;
+        uint32_t got = _osThreadTraceRead(chunk, want, &chunk_lost);
+        if (lost != NULL) {
+            *lost += chunk_lost;
+        }
+        for (uint32_t i = 0; i < got; i++) {
+            records[read + i].time = chunk[i].time;
+            records[read + i].from = chunk[i].from;
+            records[read + i].to = chunk[i].to;
+            records[read + i].preempted = chunk[i].preempted;
+            records[read + i].prio = chunk[i].prio;
+        }
+        read += got;
+        if (got < want) {
+            break;
+        }
+    }
+#else
+    if (lost != NULL) {
+        *lost = 0;
+    }
+#endif
+    return read;
+}
+
 
 static void (*terminate_hook)(osThreadId id) = 0;
 extern "C" void thread_terminate_hook(osThreadId id)
@@ -291,6 +365,21 @@ uint32_t Thread::used_stack() {
 #endif
 }
 
+mbed_stats_thread_t Thread::get_stats() {
+    mbed_stats_thread_t stats;
+    memset(&stats, 0, sizeof(stats));
+#if defined(osFeature_ThreadStats) && osFeature_ThreadStats
+    _mutex.lock();
+
+    if (_tid != NULL) {
+        get_thread_stats(_tid, &stats);
+    }
+
+    _mutex.unlock();
+#endif
+    return stats;
+}
+
 uint32_t Thread::max_stack() {
 #ifndef __MBED_CMSIS_RTOS_CA9
 #if defined(CMSIS_OS_RTX) && !defined(__MBED_CMSIS_RTOS_CM)
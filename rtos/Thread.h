@@ -26,6 +26,7 @@
 #include "cmsis_os.h"
 #include "platform/Callback.h"
 #include "platform/toolchain.h"
+#include "platform/mbed_stats.h"
 #include "rtos/Semaphore.h"
 #include "rtos/Mutex.h"
 
@@ -291,6 +292,14 @@ public:
     */
     uint32_t max_stack();
 
+    /** Get the scheduling statistics for this Thread
+      @return  run time, switch counts and ready-to-run latency of this Thread, all zero
+               unless MBED_THREAD_STATS_ENABLED is defined to 1
+      @note times are in RTOS kernel system timer ticks (see osKernelSysTickFrequency)
+      @note not callable from interrupt
+    */
+    mbed_stats_thread_t get_stats();
+
     /** Wait for one or more Signal Flags to become signaled for the current RUNNING thread.
       @param   signals   wait until all specified signal flags set or 0 for any single signal flag.
       @param   millisec  timeout value or 0 in case of no time-out. (default: osWaitForever).
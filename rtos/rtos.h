@@ -32,6 +32,7 @@
 #include "rtos/Mail.h"
 #include "rtos/MemoryPool.h"
 #include "rtos/Queue.h"
+#include "rtos/Channel.h"
 
 using namespace rtos;
 
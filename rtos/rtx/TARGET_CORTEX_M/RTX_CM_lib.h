@@ -167,6 +167,17 @@ uint8_t  const os_fifo_size = OS_FIFOSZ;
 /* An array of Active task pointers. */
 void *os_active_TCB[OS_TASK_CNT];
 
+#if (defined (osFeature_ThreadStats) && (osFeature_ThreadStats != 0))
+/* Scheduling statistics and ready time stamps, the idle task first. */
+osThreadStats  os_tsk_stats[OS_TASK_CNT+1];
+uint32_t       os_tsk_ready[OS_TASK_CNT+1];
+#if (defined (osFeature_ThreadTrace) && (osFeature_ThreadTrace != 0))
+/* Context switch trace ring. */
+osThreadSwitch os_trace[osFeature_ThreadTrace];
+uint32_t const os_trace_size = osFeature_ThreadTrace;
+#endif
+#endif
+
 /* User Timers Resources */
 #if (OS_TIMERS != 0)
 extern void osTimerThread (void const *argument);
@@ -107,6 +107,12 @@
 #define osFeature_Wait         0       ///< osWait not available
 #define osFeature_SysTick      1       ///< osKernelSysTick functions available
 #define osFeature_ThreadEnum   1       ///< Thread enumeration available
+#if defined(MBED_THREAD_STATS_ENABLED) && MBED_THREAD_STATS_ENABLED
+#define osFeature_ThreadStats  1       ///< Thread scheduling statistics available
+#ifdef MBED_THREAD_TRACE_SIZE
+#define osFeature_ThreadTrace  MBED_THREAD_TRACE_SIZE  ///< Number of context switches kept in the trace
+#endif
+#endif
 
 #if defined (__CC_ARM)
 #define os_InRegs __value_in_regs      // Compiler specific: force struct in registers
@@ -209,6 +215,25 @@ typedef struct os_mailQ_cb *osMailQId;
 /// Thread enumeration ID identifies the enumeration (pointer to a thread enumeration control block).
 typedef uint32_t *osThreadEnumId;
 
+/// Scheduling statistics of a thread, times in \ref osKernelSysTickFrequency ticks.
+typedef struct os_thread_stats  {
+  uint64_t                run_time;    ///< time spent running
+  uint64_t         ready_time_total;    ///< time spent ready but waiting for the processor
+  uint32_t           ready_time_max;    ///< longest wait from ready to running
+  uint32_t                 switches;    ///< number of times switched in
+  uint32_t              preemptions;    ///< number of times switched out while still ready
+  uint8_t                   task_id;    ///< task number as used in \ref osThreadSwitch records
+} osThreadStats;
+
+/// Context switch trace record.
+typedef struct os_thread_switch  {
+  uint32_t                     time;    ///< system timer counter at the switch
+  uint8_t                      from;    ///< task number switched out, 0 if it was terminated
+  uint8_t                        to;    ///< task number switched in, 0xFF for the idle thread
+  uint8_t                 preempted;    ///< 1 if the task switched out was still ready
+  uint8_t                      prio;    ///< priority of the task switched in
+} osThreadSwitch;
+
 /// Thread Definition structure contains startup information of a thread.
 typedef struct os_thread_def  {
   os_pthread               pthread;    ///< start address of thread function
@@ -727,6 +752,30 @@ osStatus _osThreadEnumFree(osThreadEnumId enum_id);
 #endif  // Thread Enumeration available
 
 
+//  ==== Thread Statistics Functions ====
+
+#if (defined (osFeature_ThreadStats)  &&  (osFeature_ThreadStats != 0))     // Thread statistics available
+
+/// Get the scheduling statistics of a thread.
+/// \param[in]     thread_id     thread ID obtained by \ref osThreadCreate, \ref osThreadGetId or \ref _osThreadEnumNext.
+/// \param[out]    stats         statistics of the thread, including the time it has been running so far.
+/// \return status code that indicates the execution status of the function.
+osStatus _osThreadGetStats(osThreadId thread_id, osThreadStats *stats);
+
+#if (defined (osFeature_ThreadTrace)  &&  (osFeature_ThreadTrace != 0))     // Context switch trace available
+
+/// Read and remove the oldest records from the context switch trace.
+/// \param[out]    records       array to receive the records.
+/// \param[in]     count         maximum number of records to read.
+/// \param[out]    lost          number of records overwritten since the previous read, may be NULL.
+/// \return number of records read.
+uint32_t _osThreadTraceRead(osThreadSwitch *records, uint32_t count, uint32_t *lost);
+
+#endif  // Context switch trace available
+
+#endif  // Thread statistics available
+
+
 //  ==== RTX Extensions ====
 
 /// Suspend the RTX task scheduler.
@@ -534,18 +534,7 @@ int32_t svcKernelRunning (void) {
 
 /// Get the RTOS kernel system timer counter
 uint32_t svcKernelSysTick (void) {
-  uint32_t tick, tick0;
-
-  tick = os_tick_val();
-  if (os_tick_ovf()) {
-    tick0 = os_tick_val();
-    if (tick0 < tick) { tick = tick0; }
-    tick += (os_trv + 1U) * (os_time + 1U);
-  } else {
-    tick += (os_trv + 1U) *  os_time;
-  }
-
-  return tick;
+  return rt_tick_cnt();
 }
 
 // Kernel Control Public API
@@ -1000,6 +989,60 @@ osStatus _osThreadEnumFree(osThreadEnumId enum_id) {
   return osOK;
 }
 
+#if (defined (osFeature_ThreadStats)  &&  (osFeature_ThreadStats != 0))
+
+// Thread Statistics Service Calls declarations
+SVC_2_1(svcThreadGetStats,   osStatus,         osThreadId,       osThreadStats *, RET_osStatus)
+#if (defined (osFeature_ThreadTrace)  &&  (osFeature_ThreadTrace != 0))
+SVC_3_1(svcThreadTraceRead,  uint32_t, osThreadSwitch *, uint32_t, uint32_t *, RET_uint32_t)
+#endif
+
+// Thread Statistics Service Calls
+
+/// Get the scheduling statistics of a thread
+osStatus svcThreadGetStats (osThreadId thread_id, osThreadStats *stats) {
+  P_TCB ptcb;
+
+  if (thread_id == (osThreadId)&os_idle_TCB) {
+    ptcb = &os_idle_TCB;
+  } else {
+    ptcb = rt_tid2ptcb(thread_id);              // Get TCB pointer
+    if (ptcb == NULL) { return osErrorParameter; }
+  }
+  rt_stats_get(ptcb, stats);
+  return osOK;
+}
+
+#if (defined (osFeature_ThreadTrace)  &&  (osFeature_ThreadTrace != 0))
+/// Read the oldest context switch trace records
+uint32_t svcThreadTraceRead (osThreadSwitch *records, uint32_t count, uint32_t *lost) {
+  return rt_trace_read(records, count, lost);
+}
+#endif
+
+// Thread Statistics Public API
+
+/// Get the scheduling statistics of a thread
+osStatus _osThreadGetStats (osThreadId thread_id, osThreadStats *stats) {
+  if (__get_PRIMASK() != 0U || __get_IPSR() != 0U) {
+    return osErrorISR;                          // Not allowed in ISR
+  }
+  if (stats == NULL) { return osErrorParameter; }
+  return __svcThreadGetStats(thread_id, stats);
+}
+
+#if (defined (osFeature_ThreadTrace)  &&  (osFeature_ThreadTrace != 0))
+/// Read and remove the oldest records from the context switch trace
+uint32_t _osThreadTraceRead (osThreadSwitch *records, uint32_t count, uint32_t *lost) {
+  if (__get_PRIMASK() != 0U || __get_IPSR() != 0U) {
+    return 0U;                                  // Not allowed in ISR
+  }
+  return __svcThreadTraceRead(records, count, lost);
+}
+#endif
+
+#endif
+
 // ==== Generic Wait Functions ====
 
 // Generic Wait Service Calls declarations
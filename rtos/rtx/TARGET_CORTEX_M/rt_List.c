@@ -68,6 +68,11 @@ void rt_put_prio (P_XCB p_CB, P_TCB p_task) {
   if ((p_CB->cb_type == SCB) || (p_CB->cb_type == MCB) || (p_CB->cb_type == MUCB)) {
     sem_mbx = __TRUE;
   }
+#if (defined (osFeature_ThreadStats) && (osFeature_ThreadStats != 0))
+  if (p_CB == &os_rdy) {
+    rt_stats_ready (p_task);
+  }
+#endif
   prio = p_task->prio;
   p_CB2 = p_CB->p_lnk;
   /* Search for an entry in the list */
@@ -118,6 +123,9 @@ P_TCB rt_get_first (P_XCB p_CB) {
 void rt_put_rdy_first (P_TCB p_task) {
   /* Put task identified with "p_task" at the head of the ready list. The   */
   /* task must have at least a priority equal to highest priority in list.  */
+#if (defined (osFeature_ThreadStats) && (osFeature_ThreadStats != 0))
+  rt_stats_ready (p_task);
+#endif
   p_task->p_lnk = os_rdy.p_lnk;
   p_task->p_rlnk = NULL;
   os_rdy.p_lnk = p_task;
@@ -273,6 +273,23 @@ __weak U32 os_tick_ovf (void) {
   return rt_systick_ovf();
 }
 
+/*--------------------------- rt_tick_cnt -----------------------------------*/
+
+U32 rt_tick_cnt (void) {
+  /* Get the system timer counter: ticks of the system timer since start. */
+  U32 tick, tick0;
+
+  tick = os_tick_val();
+  if (os_tick_ovf()) {
+    tick0 = os_tick_val();
+    if (tick0 < tick) { tick = tick0; }
+    tick += (os_trv + 1U) * (os_time + 1U);
+  } else {
+    tick += (os_trv + 1U) *  os_time;
+  }
+  return (tick);
+}
+
 /*--------------------------- os_tick_irqack --------------------------------*/
 
 __weak void os_tick_irqack (void) {
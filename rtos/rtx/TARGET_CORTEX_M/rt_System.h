@@ -48,6 +48,7 @@ extern void rt_psh_req    (void);
 extern void rt_pop_req    (void);
 extern void rt_systick    (void);
 extern void rt_stk_check  (void);
+extern U32  rt_tick_cnt   (void);
 
 /*----------------------------------------------------------------------------
  * end of file
@@ -52,6 +52,24 @@ struct OS_TSK os_tsk;
 /* Task Control Blocks of idle demon */
 struct OS_TCB os_idle_TCB;
 
+#if (defined (osFeature_ThreadStats) && (osFeature_ThreadStats != 0))
+extern osThreadStats  os_tsk_stats[];
+extern U32            os_tsk_ready[];
+
+/* System timer counter when the running task was switched in. */
+static U32 os_switch_time;
+
+#if (defined (osFeature_ThreadTrace) && (osFeature_ThreadTrace != 0))
+extern osThreadSwitch os_trace[];
+extern U32 const      os_trace_size;
+
+/* Next record to write, unread records and records overwritten unread. */
+static U32 os_trace_in;
+static U32 os_trace_cnt;
+static U32 os_trace_lost;
+#endif
+#endif
+
 
 /*----------------------------------------------------------------------------
  *      Local Functions
@@ -69,6 +87,139 @@ static OS_TID rt_get_TID (void) {
 }
 
 
+#if (defined (osFeature_ThreadStats) && (osFeature_ThreadStats != 0))
+
+/*--------------------------- rt_stats_idx ----------------------------------*/
+
+static __inline U32 rt_stats_idx (P_TCB p_TCB) {
+  /* Index of the task's statistics: the idle task takes the first entry. */
+  return ((p_TCB->task_id == 255U) ? 0U : p_TCB->task_id);
+}
+
+
+/*--------------------------- rt_stats_init ---------------------------------*/
+
+static void rt_stats_init (P_TCB p_TCB) {
+  /* Clear the statistics of a new task. */
+  osThreadStats *p_stats = &os_tsk_stats[rt_stats_idx (p_TCB)];
+
+  p_stats->run_time         = 0U;
+  p_stats->ready_time_total = 0U;
+  p_stats->ready_time_max   = 0U;
+  p_stats->switches         = 0U;
+  p_stats->preemptions      = 0U;
+  p_stats->task_id          = p_TCB->task_id;
+  os_tsk_ready[rt_stats_idx (p_TCB)] = 0U;
+}
+
+
+/*--------------------------- rt_stats_ready --------------------------------*/
+
+void rt_stats_ready (P_TCB p_TCB) {
+  /* Note when a task is put into the ready list, unless it already waits */
+  /* there (a priority change resorts it). Zero means "not waiting".        */
+  U32 *p_ready = &os_tsk_ready[rt_stats_idx (p_TCB)];
+
+  if (*p_ready == 0U) {
+    *p_ready = rt_tick_cnt () | 1U;
+  }
+}
+
+
+/*--------------------------- rt_stats_switch -------------------------------*/
+
+static void rt_stats_switch (P_TCB p_old, P_TCB p_new) {
+  /* Account the time run by "p_old" and the time "p_new" waited to run. */
+  /* Runs on every scheduling decision, also when the running task stays, */
+  /* so no interval outgrows the 32-bit timer counter.                    */
+  osThreadStats *p_stats;
+  U32 now, idx, wait;
+
+  now = rt_tick_cnt ();
+  if (p_old != NULL) {
+    os_tsk_stats[rt_stats_idx (p_old)].run_time += now - os_switch_time;
+  }
+  os_switch_time = now;
+
+  idx = rt_stats_idx (p_new);
+  if (p_new == p_old) {
+    /* Put back into the ready list but never left the processor */
+    os_tsk_ready[idx] = 0U;
+    return;
+  }
+  p_stats = &os_tsk_stats[idx];
+  p_stats->switches++;
+  if (os_tsk_ready[idx] != 0U) {
+    wait = now - os_tsk_ready[idx];
+    os_tsk_ready[idx] = 0U;
+    p_stats->ready_time_total += wait;
+    if (wait > p_stats->ready_time_max) {
+      p_stats->ready_time_max = wait;
+    }
+  }
+  if ((p_old != NULL) && (p_old->state == READY)) {
+    os_tsk_stats[rt_stats_idx (p_old)].preemptions++;
+  }
+
+#if (defined (osFeature_ThreadTrace) && (osFeature_ThreadTrace != 0))
+  os_trace[os_trace_in].time      = now;
+  os_trace[os_trace_in].from      = (p_old != NULL) ? p_old->task_id : 0U;
+  os_trace[os_trace_in].to        = p_new->task_id;
+  os_trace[os_trace_in].preempted = ((p_old != NULL) && (p_old->state == READY)) ? 1U : 0U;
+  os_trace[os_trace_in].prio      = p_new->prio;
+  if (++os_trace_in == os_trace_size) {
+    os_trace_in = 0U;
+  }
+  if (os_trace_cnt == os_trace_size) {
+    os_trace_lost++;
+  } else {
+    os_trace_cnt++;
+  }
+#endif
+}
+
+
+/*--------------------------- rt_stats_get ----------------------------------*/
+
+void rt_stats_get (P_TCB p_TCB, osThreadStats *stats) {
+  /* Copy the statistics of a task, counting the running task up to now. */
+  *stats = os_tsk_stats[rt_stats_idx (p_TCB)];
+  if (p_TCB == os_tsk.run) {
+    stats->run_time += rt_tick_cnt () - os_switch_time;
+  }
+}
+
+
+#if (defined (osFeature_ThreadTrace) && (osFeature_ThreadTrace != 0))
+
+/*--------------------------- rt_trace_read ---------------------------------*/
+
+U32 rt_trace_read (osThreadSwitch *records, U32 count, U32 *lost) {
+  /* Move up to "count" of the oldest trace records to "records". */
+  U32 i, out;
+
+  if (count > os_trace_cnt) {
+    count = os_trace_cnt;
+  }
+  out = (os_trace_in + os_trace_size - os_trace_cnt) % os_trace_size;
+  for (i = 0U; i < count; i++) {
+    records[i] = os_trace[out];
+    if (++out == os_trace_size) {
+      out = 0U;
+    }
+  }
+  os_trace_cnt -= count;
+  if (lost != NULL) {
+    *lost = os_trace_lost;
+  }
+  os_trace_lost = 0U;
+  return (count);
+}
+#endif
+
+#endif
+
+
 /*--------------------------- rt_init_context -------------------------------*/
 
 static void rt_init_context (P_TCB p_TCB, U8 priority, FUNCP task_body) {
@@ -87,6 +238,9 @@ static void rt_init_context (P_TCB p_TCB, U8 priority, FUNCP task_body) {
   p_TCB->events  = 0U;
   p_TCB->waits   = 0U;
   p_TCB->stack_frame = 0U;
+#if (defined (osFeature_ThreadStats) && (osFeature_ThreadStats != 0))
+  rt_stats_init (p_TCB);
+#endif
 
   if (p_TCB->priv_stack == 0U) {
     /* Allocate the memory space for the stack. */
@@ -100,6 +254,9 @@ static void rt_init_context (P_TCB p_TCB, U8 priority, FUNCP task_body) {
 
 void rt_switch_req (P_TCB p_new) {
   /* Switch to next task (identified by "p_new"). */
+#if (defined (osFeature_ThreadStats) && (osFeature_ThreadStats != 0))
+  rt_stats_switch (os_tsk.run, p_new);
+#endif
   os_tsk.new_tsk   = p_new;
   p_new->state = RUNNING;
   if (osEventObs && osEventObs->thread_switch) {
@@ -74,6 +74,13 @@ extern OS_TID    rt_tsk_self   (void);
 extern OS_RESULT rt_tsk_prio   (OS_TID task_id, U8 new_prio);
 extern OS_TID    rt_tsk_create (FUNCP task, U32 prio_stksz, void *stk, void *argv);
 extern OS_RESULT rt_tsk_delete (OS_TID task_id);
+#if (defined (osFeature_ThreadStats) && (osFeature_ThreadStats != 0))
+extern void      rt_stats_ready (P_TCB p_TCB);
+extern void      rt_stats_get   (P_TCB p_TCB, osThreadStats *stats);
+#if (defined (osFeature_ThreadTrace) && (osFeature_ThreadTrace != 0))
+extern U32       rt_trace_read  (osThreadSwitch *records, U32 count, U32 *lost);
+#endif
+#endif
 #ifdef __CMSIS_RTOS
 extern void      rt_sys_init   (void);
 extern void      rt_sys_start  (void);
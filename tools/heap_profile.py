@@ -0,0 +1,131 @@
+#!/usr/bin/env python
+
+"""Symbolizer for the mbed heap profiler
+
+Reads the lines printed by mbed_heap_profiler_dump() from a serial log,
+looks up the function of each call site in the ELF file of the application
+and prints the allocations per function, largest first. Counts are scaled
+up by the sample rate the profiler was built with.
+"""
+
+import re
+import struct
+import sys
+import argparse
+from bisect import bisect_right
+
+HEAP_PREFIX = "@heap"
+
+RE_SAMPLE = re.compile(HEAP_PREFIX + r' sample (\d+)')
+RE_SITE = re.compile(HEAP_PREFIX + r' (?:0x)?([0-9a-fA-F]+|\(nil\)) (\d+) (\d+) (\d+) (\d+)')
+
+STT_FUNC = 2
+
+
+class SymbolTable(object):
+    """Function symbols of an ELF file, sorted by address"""
+
+    def __init__(self, path):
+        with open(path, 'rb') as elf:
+            data = elf.read()
+        if data[:4] != b'\x7fELF':
+            raise ValueError("%s is not an ELF file" % path)
+        is_64 = bytearray(data[4:5])[0] == 2
+        if is_64:
+            shoff, = struct.unpack_from('<Q', data, 0x28)
+            shentsize, shnum = struct.unpack_from('<HH', data, 0x3A)
+            sh_fmt, sym_fmt = '<IIQQQQI', '<IBBHQQ'
+        else:
+            shoff, = struct.unpack_from('<I', data, 0x20)
+            shentsize, shnum = struct.unpack_from('<HH', data, 0x2E)
+            sh_fmt, sym_fmt = '<IIIIIII', '<IIIBBH'
+        sections = [struct.unpack_from(sh_fmt, data, shoff + index * shentsize)
+                    for index in range(shnum)]
+
+        symbols = []
+        for _, sh_type, _, _, offset, size, link in sections:
+            # SHT_SYMTAB, names in the linked string table
+            if sh_type != 2:
+                continue
+            strtab = sections[link][4]
+            entsize = struct.calcsize(sym_fmt)
+            for pos in range(offset, offset + size, entsize):
+                if is_64:
+                    name, info, _, _, value, sym_size = struct.unpack_from(sym_fmt, data, pos)
+                else:
+                    name, value, sym_size, info, _, _ = struct.unpack_from(sym_fmt, data, pos)
+                if info & 0xF != STT_FUNC:
+                    continue
+                end = data.find(b'\0', strtab + name)
+                # Clear the Thumb bit
+                symbols.append((value & ~1, sym_size,
+                                data[strtab + name:end].decode('utf-8', 'replace')))
+        symbols.sort()
+        self.addrs = [addr for addr, _, _ in symbols]
+        self.symbols = symbols
+
+    def lookup(self, addr):
+        """Name of the function containing addr, the address if none"""
+        index = bisect_right(self.addrs, addr & ~1) - 1
+        if index >= 0:
+            start, size, name = self.symbols[index]
+            if addr & ~1 < start + max(size, 1):
+                return name
+        return "0x%08x" % addr
+
+
+def parse(lines):
+    """Sample rate and (caller, counts) of the last dump in a log"""
+    sample = 1
+    sites = []
+    for line in lines:
+        match = RE_SAMPLE.search(line)
+        if match:
+            # A new dump replaces the previous one
+            sample = int(match.group(1))
+            sites = []
+            continue
+        match = RE_SITE.search(line)
+        if match:
+            caller = match.group(1)
+            caller = 0 if caller == '(nil)' else int(caller, 16)
+            sites.append((caller, [int(match.group(i)) for i in range(2, 6)]))
+    return sample, sites
+
+
+def main():
+    """Entry point"""
+    parser = argparse.ArgumentParser(
+        description="Symbolize mbed heap profiler dumps")
+    parser.add_argument('elf', help="ELF file of the application")
+    parser.add_argument('log', nargs='?', default='-',
+                        help="serial log with the dump, - for stdin (default)")
+    parser.add_argument('-s', '--sort', default='size',
+                        choices=['size', 'count', 'live'],
+                        help="order of the functions (default: size)")
+    args = parser.parse_args()
+
+    symbols = SymbolTable(args.elf)
+    if args.log == '-':
+        sample, sites = parse(sys.stdin)
+    else:
+        with open(args.log) as log:
+            sample, sites = parse(log)
+
+    functions = {}
+    for caller, counts in sites:
+        name = symbols.lookup(caller) if caller else "<other sites>"
+        totals = functions.setdefault(name, [0, 0, 0, 0])
+        for index in range(4):
+            totals[index] += counts[index] * sample
+    key = {'size': 1, 'count': 0, 'live': 3}[args.sort]
+
+    print("%10s %12s %10s %12s  %s" % ("allocs", "bytes", "live", "live bytes", "function"))
+    for name, totals in sorted(functions.items(), key=lambda item: -item[1][key]):
+        print("%10d %12d %10d %12d  %s" % (totals[0], totals[1], totals[2], totals[3], name))
+    if sample > 1:
+        print("(sampled one in %d allocations, counts are estimates)" % sample)
+
+
+if __name__ == "__main__":
+    main()
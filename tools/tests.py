@@ -431,6 +431,21 @@ TESTS = [
         "duration": 15,
         "peripherals": ["SD"]
     },
+    {
+        "id": "PERF_4", "description": "SD Block Device R/W Speed",
+        "source_dir": join(TEST_DIR, "mbed", "sd_perf_blocks"),
+        "dependencies": [MBED_LIBRARIES, TEST_MBED_LIB, FS_LIBRARY],
+        "automated": True,
+        "duration": 30,
+        "peripherals": ["SD"]
+    },
+    {
+        "id": "PERF_5", "description": "FAT Block Cache Device I/O",
+        "source_dir": join(TEST_DIR, "mbed", "fat_cache_io"),
+        "dependencies": [MBED_LIBRARIES, TEST_MBED_LIB, FS_LIBRARY],
+        "automated": True,
+        "duration": 20,
+    },
 
 
     # Not automated MBED tests
@@ -887,6 +902,15 @@ TESTS = [
                 "KL05Z", "K64F", "K66F", "KL46Z", "RZ_A1H",
                 "DISCO_F407VG", "DISCO_F429ZI", "NUCLEO_F429ZI", "NUCLEO_F411RE", "NUCLEO_F401RE", "NUCLEO_F410RB", "DISCO_F469NI", "NUCLEO_F207ZG"],
     },
+    {
+        "id": "RTOS_10", "description": "FAT concurrent file access",
+        "source_dir": join(TEST_DIR, "rtos", "mbed", "file_threads"),
+        "dependencies": [MBED_LIBRARIES, RTOS_LIBRARIES, TEST_MBED_LIB, FS_LIBRARY],
+        "automated": True,
+        "duration": 20,
+        "mcu": ["LPC1768", "K64F", "K66F", "DISCO_F429ZI", "NUCLEO_F429ZI", "DISCO_F469NI",
+                "NUCLEO_F446RE", "NUCLEO_F746ZG", "DISCO_F746NG", "NUCLEO_F767ZI"],
+    },
 
     # Networking Tests
     {
@@ -0,0 +1,191 @@
+#!/usr/bin/env python
+
+"""Decoder for mbed-trace binary mode records
+
+Reads the records returned by mbed_trace_binary_read() (for example
+captured from a serial port or dumped from RAM) and formats them on the
+host, looking up the group names and format strings in the ELF file of
+the application.
+"""
+
+import re
+import struct
+import sys
+import argparse
+
+TRACE_BINARY_MAGIC = 0xB5
+TRACE_BINARY_FLAG_TRUNCATED = 0x01
+TRACE_BINARY_HEADER_WORDS = 2
+
+LEVELS = {0x10: "DBG ", 0x08: "INFO", 0x04: "WARN", 0x02: "ERR ", 0x01: "CMD "}
+
+RE_SPEC = re.compile(r'%([-+ #0]*)(\*|\d*)(?:\.(\*|\d*))?(hh|h|ll|l|L|q|j|z|t)?([diouxXcfFeEgGaAspn%])')
+
+
+class ElfImage(object):
+    """Read-only view of the loadable sections of an ELF file"""
+
+    def __init__(self, path):
+        with open(path, 'rb') as elf:
+            self.data = elf.read()
+        if self.data[:4] != b'\x7fELF':
+            raise ValueError("%s is not an ELF file" % path)
+        elf_class = bytearray(self.data[4:5])[0]
+        self.ptr_size = 8 if elf_class == 2 else 4
+        if self.ptr_size == 4:
+            shoff, = struct.unpack_from('<I', self.data, 0x20)
+            shentsize, shnum = struct.unpack_from('<HH', self.data, 0x2E)
+            sh_fmt = '<IIIIII'
+        else:
+            shoff, = struct.unpack_from('<Q', self.data, 0x28)
+            shentsize, shnum = struct.unpack_from('<HH', self.data, 0x3A)
+            sh_fmt = '<IIQQQQ'
+        self.sections = []
+        for index in range(shnum):
+            _, sh_type, flags, addr, offset, size = \
+                struct.unpack_from(sh_fmt, self.data, shoff + index * shentsize)
+            # SHF_ALLOC sections with contents in the file (not SHT_NOBITS)
+            if flags & 0x2 and sh_type != 8 and size:
+                self.sections.append((addr, offset, size))
+
+    def string(self, addr):
+        """Read a NUL terminated string at a target address"""
+        for start, offset, size in self.sections:
+            if start <= addr < start + size:
+                begin = offset + addr - start
+                end = self.data.find(b'\0', begin, offset + size)
+                if end < 0:
+                    end = offset + size
+                return self.data[begin:end].decode('utf-8', 'replace')
+        return "<0x%x?>" % addr
+
+
+class RecordDecoder(object):
+    """Formats binary trace records"""
+
+    def __init__(self, elf):
+        self.elf = elf
+        self.ptr_words = elf.ptr_size // 4
+
+    def words(self, data, count):
+        return list(struct.unpack_from('<%dI' % count, data))
+
+    def value(self, words, pos, count):
+        value = 0
+        for index in range(count):
+            value |= words[pos + index] << (32 * index)
+        return value, pos + count
+
+    def format(self, words):
+        """Format one record, given as a list of words"""
+        size = words[0] & 0xFF
+        level = (words[0] >> 8) & 0xFF
+        flags = (words[0] >> 16) & 0xFF
+        pos = TRACE_BINARY_HEADER_WORDS
+        grp, pos = self.value(words, pos, self.ptr_words)
+        fmt, pos = self.value(words, pos, self.ptr_words)
+        fmt = self.elf.string(fmt)
+
+        def signed(value, bits):
+            if value & (1 << (bits - 1)):
+                value -= 1 << bits
+            return value
+
+        out = []
+        last = 0
+        for match in RE_SPEC.finditer(fmt):
+            out.append(fmt[last:match.start()])
+            last = match.end()
+            flag, width, prec, length, conv = match.groups()
+            if conv == '%':
+                out.append('%')
+                continue
+            try:
+                if width == '*':
+                    value, pos = self.value(words, pos, 1)
+                    width = str(signed(value, 32))
+                if prec == '*':
+                    value, pos = self.value(words, pos, 1)
+                    prec = str(signed(value, 32))
+                spec = '%' + flag + (width or '') + ('.' + prec if prec is not None else '')
+                if conv == 's':
+                    slen, pos = self.value(words, pos, 1)
+                    raw = struct.pack('<%dI' % ((slen + 4) // 4), *words[pos:pos + (slen + 4) // 4])
+                    pos += (slen + 4) // 4
+                    out.append((spec + 's') % raw[:slen].decode('utf-8', 'replace'))
+                elif conv in 'fFeEgGaA':
+                    value, pos = self.value(words, pos, 2)
+                    number, = struct.unpack('<d', struct.pack('<Q', value))
+                    out.append((spec + conv.replace('a', 'e').replace('A', 'E')) % number)
+                elif conv in 'pn':
+                    value, pos = self.value(words, pos, self.ptr_words)
+                    if conv == 'p':
+                        out.append((spec + 's') % hex(value).rstrip('L'))
+                else:
+                    if length in ('ll', 'q', 'j'):
+                        count = 2
+                    elif length in ('l', 'z', 't'):
+                        count = self.ptr_words
+                    else:
+                        count = 1
+                    value, pos = self.value(words, pos, count)
+                    if conv in 'di':
+                        out.append((spec + 'd') % signed(value, 32 * count))
+                    elif conv == 'c':
+                        out.append((spec + 'c') % chr(value & 0xFF))
+                    else:
+                        out.append((spec + conv.replace('u', 'd')) % value)
+            except IndexError:
+                # argument was not stored, the record is truncated
+                out.append(match.group(0))
+                break
+        else:
+            out.append(fmt[last:])
+
+        text = ''.join(out)
+        if flags & TRACE_BINARY_FLAG_TRUNCATED:
+            text += '...'
+        if pos > size:
+            text += ' <corrupt record>'
+        return "%08x [%s][%-4s]: %s" % (words[1], LEVELS.get(level, "    "),
+                                         self.elf.string(grp), text)
+
+    def decode(self, data):
+        """Generate formatted lines from a buffer of records"""
+        offset = 0
+        while offset + 4 <= len(data):
+            header, = struct.unpack_from('<I', data, offset)
+            size = header & 0xFF
+            if header >> 24 != TRACE_BINARY_MAGIC or size < TRACE_BINARY_HEADER_WORDS:
+                # resynchronise on the next word
+                offset += 4
+                continue
+            if offset + size * 4 > len(data):
+                break
+            yield self.format(self.words(data[offset:], size))
+            offset += size * 4
+
+
+def main():
+    """Entry point"""
+    parser = argparse.ArgumentParser(
+        description="Decode mbed-trace binary mode records")
+    parser.add_argument('elf', help="ELF file of the application")
+    parser.add_argument('records', nargs='?', default='-',
+                        help="file of raw records, - for stdin (default)")
+    args = parser.parse_args()
+
+    decoder = RecordDecoder(ElfImage(args.elf))
+    if args.records == '-':
+        stream = getattr(sys.stdin, 'buffer', sys.stdin)
+        data = stream.read()
+    else:
+        with open(args.records, 'rb') as records:
+            data = records.read()
+
+    for line in decoder.decode(data):
+        print(line)
+
+
+if __name__ == "__main__":
+    main()